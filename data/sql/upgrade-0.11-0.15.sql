@@ -0,0 +1,64 @@
+-- Planner Database Schema update
+--
+-- Brings a 0.11 database straight to 0.15: the global properties table
+-- from 0.13, the lookup indexes from 0.14 and the baseline tables.
+
+CREATE TABLE property_global (
+        prop_id           serial,
+        prop_name         text NOT NULL,
+        value             text,
+        PRIMARY KEY (prop_id)
+);
+
+CREATE INDEX phase_proj_id_idx ON phase (proj_id);
+CREATE INDEX daytype_proj_id_idx ON daytype (proj_id);
+CREATE INDEX calendar_proj_id_idx ON calendar (proj_id);
+CREATE INDEX calendar_parent_cid_idx ON calendar (parent_cid);
+CREATE INDEX day_cal_id_idx ON day (cal_id);
+CREATE INDEX day_dtype_id_idx ON day (dtype_id);
+CREATE INDEX day_interval_cal_id_idx ON day_interval (cal_id, dtype_id);
+CREATE INDEX task_proj_id_idx ON task (proj_id);
+CREATE INDEX task_parent_id_idx ON task (parent_id);
+CREATE INDEX predecessor_pred_task_id_idx ON predecessor (pred_task_id);
+CREATE INDEX property_type_proj_id_idx ON property_type (proj_id);
+CREATE INDEX property_proptype_id_idx ON property (proptype_id);
+CREATE INDEX project_to_property_prop_id_idx ON project_to_property (prop_id);
+CREATE INDEX task_to_property_prop_id_idx ON task_to_property (prop_id);
+CREATE INDEX resource_group_proj_id_idx ON resource_group (proj_id);
+CREATE INDEX resource_proj_id_idx ON resource (proj_id);
+CREATE INDEX resource_group_id_idx ON resource (group_id);
+CREATE INDEX resource_cal_id_idx ON resource (cal_id);
+CREATE INDEX resource_to_property_prop_id_idx ON resource_to_property (prop_id);
+CREATE INDEX allocation_task_id_idx ON allocation (task_id);
+CREATE INDEX property_global_prop_name_idx ON property_global (prop_name);
+
+--
+-- Baselines and scenarios
+--
+CREATE TABLE baseline (
+	baseline_id	  serial,
+	proj_id		  integer,
+	name		  text NOT NULL,
+	created		  timestamp with time zone,
+	is_scenario	  boolean NOT NULL DEFAULT FALSE,
+	FOREIGN KEY (proj_id) REFERENCES project (proj_id) 
+		ON DELETE CASCADE ON UPDATE CASCADE,
+	PRIMARY KEY (baseline_id)
+);
+
+CREATE TABLE baseline_task (
+	baseline_id	  integer,
+	task_id		  integer,
+	start		  timestamp with time zone,
+	finish		  timestamp with time zone,
+	work		  integer DEFAULT 0,
+	duration	  integer DEFAULT 0,
+	FOREIGN KEY (baseline_id) REFERENCES baseline (baseline_id) 
+		ON DELETE CASCADE ON UPDATE CASCADE,
+	FOREIGN KEY (task_id) REFERENCES task (task_id) 
+		ON DELETE CASCADE ON UPDATE CASCADE,
+	PRIMARY KEY (baseline_id, task_id)
+);
+
+CREATE INDEX baseline_proj_id_idx ON baseline (proj_id);
+CREATE INDEX baseline_task_task_id_idx ON baseline_task (task_id);
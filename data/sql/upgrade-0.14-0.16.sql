@@ -0,0 +1,61 @@
+-- Planner Database Schema update
+--
+-- Brings a 0.14 database straight to 0.16: the baseline tables from 0.15
+-- and the calendar rules.
+
+--
+-- Baselines and scenarios
+--
+CREATE TABLE baseline (
+	baseline_id	  serial,
+	proj_id		  integer,
+	name		  text NOT NULL,
+	created		  timestamp with time zone,
+	is_scenario	  boolean NOT NULL DEFAULT FALSE,
+	FOREIGN KEY (proj_id) REFERENCES project (proj_id) 
+		ON DELETE CASCADE ON UPDATE CASCADE,
+	PRIMARY KEY (baseline_id)
+);
+
+CREATE TABLE baseline_task (
+	baseline_id	  integer,
+	task_id		  integer,
+	start		  timestamp with time zone,
+	finish		  timestamp with time zone,
+	work		  integer DEFAULT 0,
+	duration	  integer DEFAULT 0,
+	FOREIGN KEY (baseline_id) REFERENCES baseline (baseline_id) 
+		ON DELETE CASCADE ON UPDATE CASCADE,
+	FOREIGN KEY (task_id) REFERENCES task (task_id) 
+		ON DELETE CASCADE ON UPDATE CASCADE,
+	PRIMARY KEY (baseline_id, task_id)
+);
+
+CREATE INDEX baseline_proj_id_idx ON baseline (proj_id);
+CREATE INDEX baseline_task_task_id_idx ON baseline_task (task_id);
+
+--
+-- Calendar rules (recurring dates)
+--
+CREATE TABLE calendar_rule (
+	rule_id		serial,
+       	cal_id		integer,
+	dtype_id	integer,
+	type		text NOT NULL,
+	start		date,
+	finish		date,
+	every		integer NOT NULL DEFAULT 1,
+	n_days		integer NOT NULL DEFAULT 0,
+	week_day	integer NOT NULL DEFAULT 0,
+	nth		integer NOT NULL DEFAULT 1,
+	month		integer NOT NULL DEFAULT 1,
+	month_day	integer NOT NULL DEFAULT 1,
+	CHECK (type = 'weekly' OR type = 'monthly' OR type = 'yearly' OR type = 'cycle'),
+	FOREIGN KEY (dtype_id) REFERENCES daytype (dtype_id) 
+		ON DELETE CASCADE ON UPDATE CASCADE,
+	FOREIGN KEY (cal_id) REFERENCES calendar (cal_id) 
+		ON DELETE CASCADE ON UPDATE CASCADE,
+	PRIMARY KEY (rule_id)
+);
+
+CREATE INDEX calendar_rule_cal_id_idx ON calendar_rule (cal_id);
@@ -0,0 +1,29 @@
+-- Planner Database Schema update
+--
+-- Adds the table holding the recurring dates of calendars.
+
+--
+-- Calendar rules (recurring dates)
+--
+CREATE TABLE calendar_rule (
+	rule_id		serial,
+       	cal_id		integer,
+	dtype_id	integer,
+	type		text NOT NULL,
+	start		date,
+	finish		date,
+	every		integer NOT NULL DEFAULT 1,
+	n_days		integer NOT NULL DEFAULT 0,
+	week_day	integer NOT NULL DEFAULT 0,
+	nth		integer NOT NULL DEFAULT 1,
+	month		integer NOT NULL DEFAULT 1,
+	month_day	integer NOT NULL DEFAULT 1,
+	CHECK (type = 'weekly' OR type = 'monthly' OR type = 'yearly' OR type = 'cycle'),
+	FOREIGN KEY (dtype_id) REFERENCES daytype (dtype_id) 
+		ON DELETE CASCADE ON UPDATE CASCADE,
+	FOREIGN KEY (cal_id) REFERENCES calendar (cal_id) 
+		ON DELETE CASCADE ON UPDATE CASCADE,
+	PRIMARY KEY (rule_id)
+);
+
+CREATE INDEX calendar_rule_cal_id_idx ON calendar_rule (cal_id);
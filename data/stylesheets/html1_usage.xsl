@@ -0,0 +1,65 @@
+<?xml version="1.0"?>
+<!DOCTYPE xsl:stylesheet [ <!ENTITY nbsp "&#160;"> ]>
+<xsl:stylesheet version="1.0"
+              xmlns:xsl="http://www.w3.org/1999/XSL/Transform"
+                  xmlns="http://www.w3.org/1999/xhtml"
+             xmlns:date="http://exslt.org/dates-and-times"
+             xmlns:I18N="http://www.gnu.org/software/gettext/" extension-element-prefixes="I18N">
+
+<!--**************************************************************************
+    *
+    * html1_usage.xsl: Display the work of each resource per week or month
+    *
+    *-->
+
+<xsl:template match="timephase">
+  <div class="resourcelist">
+  <h2><a name="usage"><xsl:value-of select="I18N:gettext('Resource Usage')"/></a></h2>
+
+  <div class="resourcelist-table">
+  <table cellspacing="0" cellpadding="0" border="1" width="100%">
+    <tr class="header" align="left">
+      <th><span><xsl:value-of select="I18N:gettext('Name')"/></span></th>
+      <xsl:for-each select="period">
+        <th>
+          <span>
+            <xsl:value-of select="I18N:getdate(date:seconds(concat(substring(@start, 1, 4),
+                                                                   '-', substring(@start, 5, 2),
+                                                                   '-', substring(@start, 7, 2))))"/>
+          </span>
+        </th>
+      </xsl:for-each>
+    </tr>
+
+    <xsl:for-each select="resource">
+      <xsl:variable name="rowclass">
+        <xsl:choose>
+          <xsl:when test="(position() mod 2) = 0">even</xsl:when>
+          <xsl:otherwise>odd</xsl:otherwise>
+        </xsl:choose>
+      </xsl:variable>
+
+      <tr class="{$rowclass}">
+        <td>
+          <span>
+            <xsl:value-of select="@name"/>
+          </span>
+        </td>
+        <xsl:for-each select="bucket">
+          <td align="right">
+            <span>
+              <xsl:if test="@work != 0">
+                <xsl:value-of select="format-number(@work div 3600, '0.#')"/>
+                <xsl:text>h</xsl:text>
+              </xsl:if>
+            </span>
+          </td>
+        </xsl:for-each>
+      </tr>
+    </xsl:for-each>
+  </table>
+  </div>
+  </div>
+</xsl:template>
+
+</xsl:stylesheet>
@@ -107,6 +107,7 @@
 <xsl:include href="html1_tasks.xsl"/>
 <xsl:include href="html1_resources.xsl"/>
 <xsl:include href="html1_gantt.xsl"/>
+<xsl:include href="html1_usage.xsl"/>
 
 
 <!-- ********************************************************************* -->
@@ -338,6 +339,11 @@
       <!-- Defined in html1_resources.xsl -->
       <xsl:apply-templates select="resources"/> 
 
+      <div class="separator"/>
+
+      <!-- Defined in html1_usage.xsl -->
+      <xsl:apply-templates select="timephase"/>
+
       <xsl:call-template name="htmlfooter"/>
     </body>
   </html>
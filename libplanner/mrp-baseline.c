@@ -0,0 +1,702 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Baselines and scenarios. A schedule table is a list of reference counted
+ * blocks of plain rows, sorted by the object id of the task. The project
+ * keeps a table of its current schedule and refreshes it by filling the
+ * blocks again, keeping every old block whose rows did not change. Taking a
+ * baseline only adds a reference to each block of that table, so baselines
+ * share all unchanged blocks with each other and with the project, and a
+ * variance query can skip every block that is shared with the current
+ * schedule without looking at its rows. A scenario copies a shared block
+ * the first time one of its rows is changed.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <stdlib.h>
+#include "mrp-private.h"
+#include "mrp-baseline.h"
+
+#define BLOCK_SIZE 256
+
+typedef struct {
+	mrptime      start;
+	mrptime      finish;
+	guint        task_id;
+	gint         duration;
+	gint         work;
+} BaselineRow;
+
+typedef struct {
+	gint         ref_count;
+	guint        n_rows;
+	guint        size;
+	BaselineRow  rows[1];
+} BaselineBlock;
+
+typedef struct {
+	guint        task_id;
+	MrpTask     *task;
+} BaselineEntry;
+
+struct _MrpBaseline {
+	gchar       *name;
+	mrptime      created;
+	gboolean     scenario;
+
+	GPtrArray   *blocks;   /* <BaselineBlock> */
+	guint        n_rows;
+
+	/* FALSE while a storage module appends rows in any order. */
+	gboolean     sorted;
+
+	/* Only in the table of the current schedule, the task of each row. */
+	GPtrArray   *tasks;
+};
+
+static BaselineBlock *
+baseline_block_new (guint size)
+{
+	BaselineBlock *block;
+
+	block = g_malloc (G_STRUCT_OFFSET (BaselineBlock, rows) +
+			  size * sizeof (BaselineRow));
+
+	block->ref_count = 1;
+	block->n_rows = 0;
+	block->size = size;
+
+	return block;
+}
+
+static BaselineBlock *
+baseline_block_ref (BaselineBlock *block)
+{
+	block->ref_count++;
+
+	return block;
+}
+
+static void
+baseline_block_unref (gpointer data)
+{
+	BaselineBlock *block = data;
+
+	if (--block->ref_count == 0) {
+		g_free (block);
+	}
+}
+
+static gboolean
+baseline_rows_equal (const BaselineRow *a, const BaselineRow *b, guint n_rows)
+{
+	guint i;
+
+	/* Compared by field, the padding is not initialized. */
+	for (i = 0; i < n_rows; i++) {
+		if (a[i].task_id != b[i].task_id ||
+		    a[i].start != b[i].start ||
+		    a[i].finish != b[i].finish ||
+		    a[i].duration != b[i].duration ||
+		    a[i].work != b[i].work) {
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+static gint
+baseline_row_compare (gconstpointer a, gconstpointer b)
+{
+	const BaselineRow *row_a = a;
+	const BaselineRow *row_b = b;
+
+	if (row_a->task_id < row_b->task_id) {
+		return -1;
+	}
+
+	return row_a->task_id > row_b->task_id;
+}
+
+static gint
+baseline_entry_compare (gconstpointer a, gconstpointer b)
+{
+	const BaselineEntry *entry_a = a;
+	const BaselineEntry *entry_b = b;
+
+	if (entry_a->task_id < entry_b->task_id) {
+		return -1;
+	}
+
+	return entry_a->task_id > entry_b->task_id;
+}
+
+static void
+baseline_row_set (BaselineRow *row, MrpTask *task)
+{
+	row->task_id = mrp_object_get_id (MRP_OBJECT (task));
+	row->start = mrp_task_get_start (task);
+	row->finish = mrp_task_get_finish (task);
+	row->duration = mrp_task_get_duration (task);
+	row->work = mrp_task_get_work (task);
+}
+
+static void
+baseline_ensure_sorted (MrpBaseline *baseline)
+{
+	BaselineBlock *block;
+	BaselineRow   *rows;
+	GPtrArray     *blocks;
+	guint          i, n;
+
+	if (baseline->sorted) {
+		return;
+	}
+
+	rows = g_new (BaselineRow, MAX (baseline->n_rows, 1));
+
+	for (i = 0, n = 0; i < baseline->blocks->len; i++) {
+		block = g_ptr_array_index (baseline->blocks, i);
+
+		memcpy (rows + n, block->rows, block->n_rows * sizeof (BaselineRow));
+		n += block->n_rows;
+	}
+
+	qsort (rows, n, sizeof (BaselineRow), baseline_row_compare);
+
+	blocks = g_ptr_array_new_with_free_func (baseline_block_unref);
+
+	for (i = 0; i < n; i += block->n_rows) {
+		block = baseline_block_new (MIN (BLOCK_SIZE, n - i));
+		block->n_rows = block->size;
+		memcpy (block->rows, rows + i, block->n_rows * sizeof (BaselineRow));
+
+		g_ptr_array_add (blocks, block);
+	}
+
+	g_ptr_array_unref (baseline->blocks);
+	baseline->blocks = blocks;
+	baseline->sorted = TRUE;
+
+	g_free (rows);
+}
+
+/* Finds the row of @task_id, or where it would be inserted. */
+static gboolean
+baseline_find (MrpBaseline *baseline,
+	       guint        task_id,
+	       guint       *block_index,
+	       guint       *row_index)
+{
+	BaselineBlock *block;
+	guint          low, high, mid;
+
+	baseline_ensure_sorted (baseline);
+
+	*block_index = 0;
+	*row_index = 0;
+
+	if (baseline->blocks->len == 0) {
+		return FALSE;
+	}
+
+	/* The first block whose last row is not before the id. */
+	low = 0;
+	high = baseline->blocks->len - 1;
+	while (low < high) {
+		mid = (low + high) / 2;
+		block = g_ptr_array_index (baseline->blocks, mid);
+
+		if (block->rows[block->n_rows - 1].task_id < task_id) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	*block_index = low;
+	block = g_ptr_array_index (baseline->blocks, low);
+
+	low = 0;
+	high = block->n_rows;
+	while (low < high) {
+		mid = (low + high) / 2;
+
+		if (block->rows[mid].task_id < task_id) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	*row_index = low;
+
+	return low < block->n_rows && block->rows[low].task_id == task_id;
+}
+
+/* Gives the scenario its own copy of a shared block, with room for one more
+ * row if @insert is set. Full blocks have to be split before inserting.
+ */
+static BaselineBlock *
+baseline_make_writable (MrpBaseline *baseline,
+			guint        index,
+			gboolean     insert)
+{
+	BaselineBlock *block, *copy;
+
+	block = g_ptr_array_index (baseline->blocks, index);
+
+	if (block->ref_count == 1 && (!insert || block->n_rows < block->size)) {
+		return block;
+	}
+
+	copy = baseline_block_new (BLOCK_SIZE);
+	copy->n_rows = block->n_rows;
+	memcpy (copy->rows, block->rows, block->n_rows * sizeof (BaselineRow));
+
+	g_ptr_array_index (baseline->blocks, index) = copy;
+	baseline_block_unref (block);
+
+	return copy;
+}
+
+static void
+baseline_split_block (MrpBaseline *baseline,
+		      guint       *block_index,
+		      guint       *row_index)
+{
+	BaselineBlock *block, *first, *second;
+	guint          half;
+
+	block = g_ptr_array_index (baseline->blocks, *block_index);
+	half = block->n_rows / 2;
+
+	first = baseline_block_new (BLOCK_SIZE);
+	first->n_rows = half;
+	memcpy (first->rows, block->rows, half * sizeof (BaselineRow));
+
+	second = baseline_block_new (BLOCK_SIZE);
+	second->n_rows = block->n_rows - half;
+	memcpy (second->rows, block->rows + half, second->n_rows * sizeof (BaselineRow));
+
+	g_ptr_array_index (baseline->blocks, *block_index) = first;
+	g_ptr_array_insert (baseline->blocks, *block_index + 1, second);
+	baseline_block_unref (block);
+
+	if (*row_index > half) {
+		*block_index += 1;
+		*row_index -= half;
+	}
+}
+
+MrpBaseline *
+imrp_baseline_new (const gchar *name,
+		   mrptime      created,
+		   gboolean     scenario)
+{
+	MrpBaseline *baseline;
+
+	baseline = g_new0 (MrpBaseline, 1);
+
+	baseline->name = g_strdup (name);
+	baseline->created = created;
+	baseline->scenario = scenario;
+	baseline->blocks = g_ptr_array_new_with_free_func (baseline_block_unref);
+	baseline->sorted = TRUE;
+
+	return baseline;
+}
+
+/* Makes a new table sharing all the blocks of @source. */
+MrpBaseline *
+imrp_baseline_copy (MrpBaseline *source,
+		    const gchar *name,
+		    mrptime      created,
+		    gboolean     scenario)
+{
+	MrpBaseline   *baseline;
+	BaselineBlock *block;
+	guint          i;
+
+	baseline_ensure_sorted (source);
+
+	baseline = imrp_baseline_new (name, created, scenario);
+
+	for (i = 0; i < source->blocks->len; i++) {
+		block = g_ptr_array_index (source->blocks, i);
+		g_ptr_array_add (baseline->blocks, baseline_block_ref (block));
+	}
+
+	baseline->n_rows = source->n_rows;
+
+	return baseline;
+}
+
+void
+imrp_baseline_free (MrpBaseline *baseline)
+{
+	g_free (baseline->name);
+	g_ptr_array_unref (baseline->blocks);
+
+	if (baseline->tasks) {
+		g_ptr_array_unref (baseline->tasks);
+	}
+
+	g_free (baseline);
+}
+
+/* Refreshes the table of the current schedule from @tasks, keeping the old
+ * blocks whose rows are unchanged. Tasks get increasing ids, so new tasks
+ * only add rows at the end and keep the earlier blocks aligned.
+ */
+void
+imrp_baseline_update (MrpBaseline *baseline, GList *tasks)
+{
+	BaselineEntry *entries;
+	BaselineBlock *old, *block;
+	BaselineRow    rows[BLOCK_SIZE];
+	GPtrArray     *blocks;
+	GList         *l;
+	guint          n, i, j, b, n_rows;
+
+	n = g_list_length (tasks);
+	entries = g_new (BaselineEntry, MAX (n, 1));
+
+	for (l = tasks, i = 0; l; l = l->next, i++) {
+		entries[i].task = l->data;
+		entries[i].task_id = mrp_object_get_id (l->data);
+	}
+
+	qsort (entries, n, sizeof (BaselineEntry), baseline_entry_compare);
+
+	if (!baseline->tasks) {
+		baseline->tasks = g_ptr_array_new ();
+	}
+	g_ptr_array_set_size (baseline->tasks, n);
+
+	blocks = g_ptr_array_new_with_free_func (baseline_block_unref);
+
+	for (i = 0, b = 0; i < n; i += n_rows, b++) {
+		n_rows = MIN (BLOCK_SIZE, n - i);
+
+		for (j = 0; j < n_rows; j++) {
+			baseline_row_set (&rows[j], entries[i + j].task);
+			g_ptr_array_index (baseline->tasks, i + j) = entries[i + j].task;
+		}
+
+		old = b < baseline->blocks->len ?
+			g_ptr_array_index (baseline->blocks, b) : NULL;
+
+		if (old && old->n_rows == n_rows &&
+		    baseline_rows_equal (old->rows, rows, n_rows)) {
+			block = baseline_block_ref (old);
+		} else {
+			block = baseline_block_new (n_rows);
+			block->n_rows = n_rows;
+			memcpy (block->rows, rows, n_rows * sizeof (BaselineRow));
+		}
+
+		g_ptr_array_add (blocks, block);
+	}
+
+	g_ptr_array_unref (baseline->blocks);
+	baseline->blocks = blocks;
+	baseline->n_rows = n;
+	baseline->sorted = TRUE;
+
+	g_free (entries);
+}
+
+/* Used by the storage modules, the rows can be added in any order. */
+void
+imrp_baseline_add_task (MrpBaseline *baseline,
+			MrpTask     *task,
+			mrptime      start,
+			mrptime      finish,
+			gint         duration,
+			gint         work)
+{
+	BaselineBlock *block = NULL;
+	BaselineRow   *row;
+	guint          task_id;
+
+	task_id = mrp_object_get_id (MRP_OBJECT (task));
+
+	if (baseline->blocks->len > 0) {
+		block = g_ptr_array_index (baseline->blocks, baseline->blocks->len - 1);
+
+		if (block->rows[block->n_rows - 1].task_id >= task_id) {
+			baseline->sorted = FALSE;
+		}
+
+		if (block->n_rows == block->size) {
+			block = NULL;
+		}
+	}
+
+	if (!block) {
+		block = baseline_block_new (BLOCK_SIZE);
+		g_ptr_array_add (baseline->blocks, block);
+	}
+
+	row = &block->rows[block->n_rows++];
+	row->task_id = task_id;
+	row->start = start;
+	row->finish = finish;
+	row->duration = duration;
+	row->work = work;
+
+	baseline->n_rows++;
+}
+
+/* Compares @baseline with the table of the current schedule. Both are sorted
+ * by task id, so this is a merge of the two, skipping shared blocks.
+ */
+GList *
+imrp_baseline_get_variances (MrpBaseline *baseline, MrpBaseline *current)
+{
+	BaselineBlock       *a_block, *b_block;
+	BaselineRow         *a, *b;
+	MrpBaselineVariance *variance;
+	GList               *variances = NULL;
+	guint                i = 0, j = 0, r = 0, s = 0, k = 0;
+
+	baseline_ensure_sorted (baseline);
+
+	while (i < baseline->blocks->len && j < current->blocks->len) {
+		a_block = g_ptr_array_index (baseline->blocks, i);
+		b_block = g_ptr_array_index (current->blocks, j);
+
+		if (r == 0 && s == 0 && a_block == b_block) {
+			k += b_block->n_rows;
+			i++;
+			j++;
+			continue;
+		}
+
+		a = &a_block->rows[r];
+		b = &b_block->rows[s];
+
+		if (a->task_id == b->task_id &&
+		    !baseline_rows_equal (a, b, 1)) {
+			variance = g_new (MrpBaselineVariance, 1);
+
+			variance->task = g_ptr_array_index (current->tasks, k);
+			variance->start_variance = b->start - a->start;
+			variance->finish_variance = b->finish - a->finish;
+			variance->duration_variance = b->duration - a->duration;
+			variance->work_variance = b->work - a->work;
+
+			variances = g_list_prepend (variances, variance);
+		}
+
+		if (a->task_id <= b->task_id && ++r == a_block->n_rows) {
+			r = 0;
+			i++;
+		}
+
+		if (b->task_id <= a->task_id) {
+			k++;
+			if (++s == b_block->n_rows) {
+				s = 0;
+				j++;
+			}
+		}
+	}
+
+	return g_list_reverse (variances);
+}
+
+/**
+ * mrp_baseline_get_name:
+ * @baseline: an #MrpBaseline
+ *
+ * Retrieves the name of @baseline.
+ *
+ * Return value: the name, owned by @baseline.
+ **/
+const gchar *
+mrp_baseline_get_name (MrpBaseline *baseline)
+{
+	g_return_val_if_fail (baseline != NULL, NULL);
+
+	return baseline->name;
+}
+
+/**
+ * mrp_baseline_get_created:
+ * @baseline: an #MrpBaseline
+ *
+ * Retrieves the time @baseline was taken.
+ *
+ * Return value: the creation time.
+ **/
+mrptime
+mrp_baseline_get_created (MrpBaseline *baseline)
+{
+	g_return_val_if_fail (baseline != NULL, 0);
+
+	return baseline->created;
+}
+
+/**
+ * mrp_baseline_is_scenario:
+ * @baseline: an #MrpBaseline
+ *
+ * Checks if @baseline is a scenario, which can be changed with
+ * mrp_baseline_set_task().
+ *
+ * Return value: %TRUE if @baseline is a scenario.
+ **/
+gboolean
+mrp_baseline_is_scenario (MrpBaseline *baseline)
+{
+	g_return_val_if_fail (baseline != NULL, FALSE);
+
+	return baseline->scenario;
+}
+
+/**
+ * mrp_baseline_get_n_tasks:
+ * @baseline: an #MrpBaseline
+ *
+ * Retrieves the number of tasks in @baseline.
+ *
+ * Return value: the number of tasks.
+ **/
+gint
+mrp_baseline_get_n_tasks (MrpBaseline *baseline)
+{
+	g_return_val_if_fail (baseline != NULL, 0);
+
+	return baseline->n_rows;
+}
+
+/**
+ * mrp_baseline_get_task:
+ * @baseline: an #MrpBaseline
+ * @task: an #MrpTask
+ * @start: location to store the start, or %NULL
+ * @finish: location to store the finish, or %NULL
+ * @duration: location to store the duration, or %NULL
+ * @work: location to store the work, or %NULL
+ *
+ * Retrieves the schedule of @task in @baseline.
+ *
+ * Return value: %TRUE if @task is in @baseline.
+ **/
+gboolean
+mrp_baseline_get_task (MrpBaseline *baseline,
+		       MrpTask     *task,
+		       mrptime     *start,
+		       mrptime     *finish,
+		       gint        *duration,
+		       gint        *work)
+{
+	BaselineBlock *block;
+	BaselineRow   *row;
+	guint          block_index, row_index;
+
+	g_return_val_if_fail (baseline != NULL, FALSE);
+	g_return_val_if_fail (MRP_IS_TASK (task), FALSE);
+
+	if (!baseline_find (baseline, mrp_object_get_id (MRP_OBJECT (task)),
+			    &block_index, &row_index)) {
+		return FALSE;
+	}
+
+	block = g_ptr_array_index (baseline->blocks, block_index);
+	row = &block->rows[row_index];
+
+	if (start) {
+		*start = row->start;
+	}
+	if (finish) {
+		*finish = row->finish;
+	}
+	if (duration) {
+		*duration = row->duration;
+	}
+	if (work) {
+		*work = row->work;
+	}
+
+	return TRUE;
+}
+
+/**
+ * mrp_baseline_set_task:
+ * @baseline: an #MrpBaseline that is a scenario
+ * @task: an #MrpTask
+ * @start: the start of @task in the scenario
+ * @finish: the finish of @task in the scenario
+ * @duration: the duration of @task in the scenario
+ * @work: the work of @task in the scenario
+ *
+ * Changes the schedule of @task in the scenario @baseline, or adds it. The
+ * project itself is not changed.
+ **/
+void
+mrp_baseline_set_task (MrpBaseline *baseline,
+		       MrpTask     *task,
+		       mrptime      start,
+		       mrptime      finish,
+		       gint         duration,
+		       gint         work)
+{
+	BaselineBlock *block;
+	BaselineRow   *row;
+	guint          block_index, row_index;
+	guint          task_id;
+	gboolean       found;
+
+	g_return_if_fail (baseline != NULL);
+	g_return_if_fail (baseline->scenario);
+	g_return_if_fail (MRP_IS_TASK (task));
+
+	task_id = mrp_object_get_id (MRP_OBJECT (task));
+
+	found = baseline_find (baseline, task_id, &block_index, &row_index);
+
+	if (baseline->blocks->len == 0) {
+		g_ptr_array_add (baseline->blocks, baseline_block_new (BLOCK_SIZE));
+	}
+
+	block = g_ptr_array_index (baseline->blocks, block_index);
+	if (!found && block->n_rows == BLOCK_SIZE) {
+		baseline_split_block (baseline, &block_index, &row_index);
+	}
+
+	block = baseline_make_writable (baseline, block_index, !found);
+
+	if (!found) {
+		memmove (block->rows + row_index + 1, block->rows + row_index,
+			 (block->n_rows - row_index) * sizeof (BaselineRow));
+		block->n_rows++;
+		baseline->n_rows++;
+	}
+
+	row = &block->rows[row_index];
+	row->task_id = task_id;
+	row->start = start;
+	row->finish = finish;
+	row->duration = duration;
+	row->work = work;
+}
@@ -0,0 +1,71 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <libplanner/mrp-time.h>
+#include <libplanner/mrp-task.h>
+
+G_BEGIN_DECLS
+
+/**
+ * MrpBaseline:
+ *
+ * A named copy of the schedule of a project, owned by the project, see
+ * mrp_project_add_baseline() and mrp_project_add_scenario().
+ */
+typedef struct _MrpBaseline MrpBaseline;
+
+/**
+ * MrpBaselineVariance:
+ * @task: a task whose schedule differs from the baseline
+ * @start_variance: the current start minus the baseline start, in seconds
+ * @finish_variance: the current finish minus the baseline finish, in seconds
+ * @duration_variance: the current duration minus the baseline duration
+ * @work_variance: the current work minus the baseline work
+ *
+ * The difference between a baseline and the current schedule of a task, see
+ * mrp_project_get_variances().
+ */
+typedef struct {
+	MrpTask *task;
+	mrptime  start_variance;
+	mrptime  finish_variance;
+	gint     duration_variance;
+	gint     work_variance;
+} MrpBaselineVariance;
+
+const gchar *mrp_baseline_get_name    (MrpBaseline *baseline);
+mrptime      mrp_baseline_get_created (MrpBaseline *baseline);
+gboolean     mrp_baseline_is_scenario (MrpBaseline *baseline);
+gint         mrp_baseline_get_n_tasks (MrpBaseline *baseline);
+gboolean     mrp_baseline_get_task    (MrpBaseline *baseline,
+				       MrpTask     *task,
+				       mrptime     *start,
+				       mrptime     *finish,
+				       gint        *duration,
+				       gint        *work);
+void         mrp_baseline_set_task    (MrpBaseline *baseline,
+				       MrpTask     *task,
+				       mrptime      start,
+				       mrptime      finish,
+				       gint         duration,
+				       gint         work);
+
+G_END_DECLS
@@ -35,6 +35,10 @@
  * Day types can be overriden so that a working day
  * has another set of working time intervals per calendar. Certain dates
  * can be overridden to use another day type as well.
+ *
+ * Recurring dates, like yearly holidays or shift rotations, are set with
+ * rules (#MrpCalendarRule) instead. Rules are evaluated when a date is
+ * looked up, so they cost the same whatever range of dates they cover.
  */
 
 #include <config.h>
@@ -80,6 +84,9 @@ typedef struct {
 
 	/* This can override single days and is hashed on the date */
 	GHashTable  *days;
+
+	/* MrpCalendarRules, checked after the single days */
+	GList       *rules;
 } MrpCalendarPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (MrpCalendar, mrp_calendar, MRP_TYPE_OBJECT)
@@ -106,6 +113,9 @@ static void         calendar_add_child       (MrpCalendar      *parent,
 static void         calendar_reparent        (MrpCalendar      *new_parent,
 					      MrpCalendar      *child);
 static void         calendar_emit_changed    (MrpCalendar      *calendar);
+static MrpDay *     calendar_get_rule_day    (MrpCalendar      *calendar,
+					      mrptime           date);
+static void         calendar_rule_free       (MrpCalendarRule  *rule);
 static GList *      calendar_clean_intervals (GList            *list);
 
 
@@ -120,6 +130,8 @@ mrp_calendar_finalize (GObject *object)
 	g_hash_table_destroy (priv->days);
 	g_hash_table_destroy (priv->day_intervals);
 
+	g_list_free_full (priv->rules, (GDestroyNotify) calendar_rule_free);
+
 	g_list_foreach (priv->children, (GFunc) g_object_unref, NULL);
 	g_list_free (priv->children);
 
@@ -266,6 +278,10 @@ calendar_get_day (MrpCalendar *calendar, mrptime date, gboolean derive)
 
 	day = (MrpDay *) g_hash_table_lookup (priv->days,
 					      GINT_TO_POINTER ((int)date));
+	if (!day && priv->rules) {
+		day = calendar_get_rule_day (calendar, date);
+	}
+
 	if (!day) {
 		if (derive && priv->parent) {
 			return calendar_get_day (priv->parent, date, derive);
@@ -413,6 +429,7 @@ mrp_calendar_copy (const gchar *name, MrpCalendar *calendar)
 {
 	MrpCalendarPrivate *priv = mrp_calendar_get_instance_private (calendar);
 	MrpCalendar *parent, *ret_val;
+	GList       *l;
 
 	parent = mrp_project_get_root_calendar (priv->project);
 
@@ -431,6 +448,10 @@ mrp_calendar_copy (const gchar *name, MrpCalendar *calendar)
 			      (GHFunc) foreach_copy_days,
 			      ret_val);
 
+	for (l = priv->rules; l; l = l->next) {
+		mrp_calendar_add_rule (ret_val, l->data);
+	}
+
 	imrp_project_signal_calendar_tree_changed (priv->project);
 	imrp_project_set_needs_saving (priv->project, TRUE);
 
@@ -904,9 +925,11 @@ mrp_calendar_get_children (MrpCalendar *calendar)
  * @date: an #mrptime
  * @check_ancestors: specifies if the whole calendar hierarchy should be checked
  *
- * Retrieves the day type for the given date and calendar. If @check_ancestors
- * is %TRUE, the parent and grandparent, and so on, is searched if @calendar
- * does not have an overridden day type for the specified date.
+ * Retrieves the day type for the given date and calendar. A date overridden
+ * with mrp_calendar_set_days() takes precedence over the rules of @calendar,
+ * which take precedence over the default week. If @check_ancestors is %TRUE,
+ * the dates and rules of the parent and grandparent, and so on, are searched
+ * if @calendar does not override the specified date.
  *
  * Return value: An #MrpDay.
  **/
@@ -1139,6 +1162,205 @@ mrp_calendar_get_all_overridden_dates (MrpCalendar *calendar)
 	return ret_val;
 }
 
+/**
+ * mrp_calendar_add_rule:
+ * @calendar: an #MrpCalendar
+ * @rule: an #MrpCalendarRule
+ *
+ * Adds a copy of @rule to @calendar, setting the day type of the dates it
+ * matches. Dates overridden with mrp_calendar_set_days() are not affected,
+ * and where rules match the same date the one added first is used.
+ *
+ **/
+void
+mrp_calendar_add_rule (MrpCalendar           *calendar,
+		       const MrpCalendarRule *rule)
+{
+	MrpCalendarPrivate *priv = mrp_calendar_get_instance_private (calendar);
+	MrpCalendarRule    *copy;
+
+	g_return_if_fail (MRP_IS_CALENDAR (calendar));
+	g_return_if_fail (rule != NULL);
+	g_return_if_fail (rule->day != NULL);
+	g_return_if_fail (rule->day != mrp_day_get_use_base ());
+
+	if ((rule->type == MRP_CALENDAR_RULE_WEEKLY ||
+	     rule->type == MRP_CALENDAR_RULE_CYCLE) && rule->interval < 1) {
+		g_warning ("Trying to add a calendar rule without an interval");
+		return;
+	}
+
+	copy = g_new (MrpCalendarRule, 1);
+	*copy = *rule;
+
+	copy->day = mrp_day_ref (rule->day);
+	copy->start = mrp_time_align_day (rule->start);
+	if (rule->end != MRP_TIME_INVALID) {
+		copy->end = mrp_time_align_day (rule->end);
+	}
+
+	priv->rules = g_list_append (priv->rules, copy);
+
+	calendar_emit_changed (calendar);
+	imrp_project_set_needs_saving (priv->project, TRUE);
+}
+
+/**
+ * mrp_calendar_remove_rule:
+ * @calendar: an #MrpCalendar
+ * @rule: a rule from mrp_calendar_get_rules()
+ *
+ * Removes @rule from @calendar.
+ *
+ **/
+void
+mrp_calendar_remove_rule (MrpCalendar           *calendar,
+			  const MrpCalendarRule *rule)
+{
+	MrpCalendarPrivate *priv = mrp_calendar_get_instance_private (calendar);
+	GList              *link;
+
+	g_return_if_fail (MRP_IS_CALENDAR (calendar));
+
+	link = g_list_find (priv->rules, rule);
+	if (!link) {
+		return;
+	}
+
+	priv->rules = g_list_delete_link (priv->rules, link);
+	calendar_rule_free ((MrpCalendarRule *) rule);
+
+	calendar_emit_changed (calendar);
+	imrp_project_set_needs_saving (priv->project, TRUE);
+}
+
+/**
+ * mrp_calendar_get_rules:
+ * @calendar: an #MrpCalendar
+ *
+ * Retrieves the rules of @calendar in the order they are checked. The rules
+ * of the parent calendars are not included.
+ *
+ * Return value: A list of #MrpCalendarRule, owned by @calendar.
+ **/
+GList *
+mrp_calendar_get_rules (MrpCalendar *calendar)
+{
+	MrpCalendarPrivate *priv = mrp_calendar_get_instance_private (calendar);
+
+	g_return_val_if_fail (MRP_IS_CALENDAR (calendar), NULL);
+
+	return priv->rules;
+}
+
+static void
+calendar_rule_free (MrpCalendarRule *rule)
+{
+	mrp_day_unref (rule->day);
+	g_free (rule);
+}
+
+/* Days from 1970-01-01, which was a Thursday, to the julian day of GDate. */
+#define EPOCH_JULIAN_DAY 719163
+#define EPOCH_WEEK_DAY   MRP_CALENDAR_DAY_THU
+#define SECONDS_PER_DAY  (24 * 60 * 60)
+
+static gint
+calendar_week_day (gint64 days)
+{
+	return ((days + EPOCH_WEEK_DAY) % 7 + 7) % 7;
+}
+
+/* Checks @rule against @date, a day aligned time. The week day and the
+ * calendar date are worked out from the day number without going through
+ * GDateTime, since this is called for every day the scheduler looks at.
+ */
+static gboolean
+calendar_rule_matches (MrpCalendarRule *rule,
+		       mrptime          date,
+		       gint64           days,
+		       gint             week_day,
+		       GDate           *gdate)
+{
+	gint64 first;
+
+	if (date < rule->start) {
+		return FALSE;
+	}
+
+	if (rule->end != MRP_TIME_INVALID && date > rule->end) {
+		return FALSE;
+	}
+
+	switch (rule->type) {
+	case MRP_CALENDAR_RULE_WEEKLY:
+		if (week_day != rule->week_day) {
+			return FALSE;
+		}
+
+		/* The first matching day on or after the start. */
+		first = rule->start / SECONDS_PER_DAY;
+		first += (rule->week_day - calendar_week_day (first) + 7) % 7;
+
+		return ((days - first) / 7) % rule->interval == 0;
+
+	case MRP_CALENDAR_RULE_MONTHLY:
+		if (week_day != rule->week_day) {
+			return FALSE;
+		}
+
+		if (!g_date_valid (gdate)) {
+			g_date_set_julian (gdate, days + EPOCH_JULIAN_DAY);
+		}
+
+		if (rule->nth == -1) {
+			return g_date_get_day (gdate) + 7 >
+				g_date_get_days_in_month (g_date_get_month (gdate),
+							  g_date_get_year (gdate));
+		}
+
+		return (g_date_get_day (gdate) - 1) / 7 + 1 == rule->nth;
+
+	case MRP_CALENDAR_RULE_YEARLY:
+		if (!g_date_valid (gdate)) {
+			g_date_set_julian (gdate, days + EPOCH_JULIAN_DAY);
+		}
+
+		return g_date_get_month (gdate) == rule->month &&
+			g_date_get_day (gdate) == rule->month_day;
+
+	case MRP_CALENDAR_RULE_CYCLE:
+		return (days - rule->start / SECONDS_PER_DAY) % rule->interval < rule->count;
+	}
+
+	return FALSE;
+}
+
+static MrpDay *
+calendar_get_rule_day (MrpCalendar *calendar, mrptime date)
+{
+	MrpCalendarPrivate *priv = mrp_calendar_get_instance_private (calendar);
+	GList              *l;
+	GDate               gdate;
+	gint64              days;
+	gint                week_day;
+
+	days = date / SECONDS_PER_DAY;
+	week_day = calendar_week_day (days);
+
+	g_date_clear (&gdate, 1);
+
+	for (l = priv->rules; l; l = l->next) {
+		MrpCalendarRule *rule = l->data;
+
+		if (calendar_rule_matches (rule, date, days, week_day, &gdate)) {
+			return rule->day;
+		}
+	}
+
+	return NULL;
+}
+
 typedef struct {
 	MrpDay *day;
 	GList *list;
@@ -1193,6 +1415,16 @@ imrp_calendar_replace_day (MrpCalendar *calendar,
 	}
 
 	g_list_free (data.list);
+
+	/* Rules. */
+	for (l = priv->rules; l; l = l->next) {
+		MrpCalendarRule *rule = l->data;
+
+		if (rule->day == orig_day) {
+			mrp_day_unref (rule->day);
+			rule->day = mrp_day_ref (new_day);
+		}
+	}
 }
 
 static void
@@ -83,6 +83,56 @@ typedef struct {
 	MrpDay *day;
 } MrpDateWithDay;
 
+/**
+ * MrpCalendarRuleType:
+ * @MRP_CALENDAR_RULE_WEEKLY: @week_day every @interval weeks, counting from
+ * the first such day on or after @start.
+ * @MRP_CALENDAR_RULE_MONTHLY: the @nth @week_day of every month, or the last
+ * one if @nth is -1.
+ * @MRP_CALENDAR_RULE_YEARLY: @month_day of @month every year.
+ * @MRP_CALENDAR_RULE_CYCLE: the first @count days of every cycle of
+ * @interval days, counting from @start.
+ *
+ * The kinds of recurring dates of an #MrpCalendarRule.
+ */
+typedef enum {
+	MRP_CALENDAR_RULE_WEEKLY,
+	MRP_CALENDAR_RULE_MONTHLY,
+	MRP_CALENDAR_RULE_YEARLY,
+	MRP_CALENDAR_RULE_CYCLE
+} MrpCalendarRuleType;
+
+/**
+ * MrpCalendarRule:
+ * @type: how the dates recur.
+ * @day: the day type to use for those dates.
+ * @start: the first date the rule applies to.
+ * @end: the last date the rule applies to, or %MRP_TIME_INVALID.
+ * @interval: the number of weeks between dates of a weekly rule, or the
+ * length in days of a cycle.
+ * @count: the number of days at the start of a cycle.
+ * @week_day: the week day of a weekly or monthly rule, 0 is Sunday.
+ * @nth: the week of the month of a monthly rule, 1 - 5 or -1 for the last.
+ * @month: the month of a yearly rule, 1 - 12.
+ * @month_day: the day of the month of a yearly rule, 1 - 31.
+ *
+ * Sets the day type of recurring dates, e.g. holidays or shift rotations,
+ * without overriding each date. Only the fields used by @type are looked
+ * at.
+ */
+typedef struct {
+	MrpCalendarRuleType  type;
+	MrpDay              *day;
+	mrptime              start;
+	mrptime              end;
+	gint                 interval;
+	gint                 count;
+	gint                 week_day;
+	gint                 nth;
+	gint                 month;
+	gint                 month_day;
+} MrpCalendarRule;
+
 enum {
 	MRP_CALENDAR_DAY_SUN,
 	MRP_CALENDAR_DAY_MON,
@@ -130,6 +180,11 @@ MrpCalendar *mrp_calendar_get_parent               (MrpCalendar *calendar);
 GList *      mrp_calendar_get_children             (MrpCalendar *calendar);
 GList *      mrp_calendar_get_overridden_days      (MrpCalendar *calendar);
 GList *      mrp_calendar_get_all_overridden_dates (MrpCalendar *calendar);
+void         mrp_calendar_add_rule                 (MrpCalendar           *calendar,
+						    const MrpCalendarRule *rule);
+void         mrp_calendar_remove_rule              (MrpCalendar           *calendar,
+						    const MrpCalendarRule *rule);
+GList *      mrp_calendar_get_rules                (MrpCalendar *calendar);
 
 /* Interval */
 GType        mrp_interval_get_type                 (void) G_GNUC_CONST;
@@ -0,0 +1,400 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Compressed project files. A compressed file is told apart from plain XML
+ * by its first bytes, so nothing depends on the file name. The data goes
+ * through a GConverter in chunks as it is read or written, the compressed
+ * file is never held in memory as a whole.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <glib/gi18n.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#include "mrp-error.h"
+#include "mrp-private.h"
+
+#define CHUNK_SIZE (64 * 1024)
+
+static const guchar gzip_magic[] = { 0x1f, 0x8b };
+static const guchar zstd_magic[] = { 0x28, 0xb5, 0x2f, 0xfd };
+
+#ifdef HAVE_ZSTD
+
+/* GIO only comes with zlib, zstd gets a converter of its own. It either
+ * compresses or decompresses, depending on which context it has.
+ */
+typedef struct {
+	GObject    parent;
+
+	ZSTD_CCtx *cctx;
+	ZSTD_DCtx *dctx;
+
+	/* Whether the last frame read is complete. */
+	gboolean   frame_done;
+} ZstdConverter;
+
+typedef struct {
+	GObjectClass parent_class;
+} ZstdConverterClass;
+
+static void zstd_converter_iface_init (GConverterIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (ZstdConverter, zstd_converter, G_TYPE_OBJECT,
+			 G_IMPLEMENT_INTERFACE (G_TYPE_CONVERTER,
+						zstd_converter_iface_init))
+
+static void
+zstd_converter_finalize (GObject *object)
+{
+	ZstdConverter *zstd = (ZstdConverter *) object;
+
+	ZSTD_freeCCtx (zstd->cctx);
+	ZSTD_freeDCtx (zstd->dctx);
+
+	G_OBJECT_CLASS (zstd_converter_parent_class)->finalize (object);
+}
+
+static void
+zstd_converter_class_init (ZstdConverterClass *klass)
+{
+	G_OBJECT_CLASS (klass)->finalize = zstd_converter_finalize;
+}
+
+static void
+zstd_converter_init (ZstdConverter *zstd)
+{
+}
+
+static GConverterResult
+zstd_converter_convert (GConverter      *converter,
+			const void      *inbuf,
+			gsize            inbuf_size,
+			void            *outbuf,
+			gsize            outbuf_size,
+			GConverterFlags  flags,
+			gsize           *bytes_read,
+			gsize           *bytes_written,
+			GError         **error)
+{
+	ZstdConverter      *zstd = (ZstdConverter *) converter;
+	ZSTD_inBuffer       in = { inbuf, inbuf_size, 0 };
+	ZSTD_outBuffer      out = { outbuf, outbuf_size, 0 };
+	ZSTD_EndDirective   directive = ZSTD_e_continue;
+	gsize               ret;
+
+	if (zstd->cctx) {
+		if (flags & G_CONVERTER_INPUT_AT_END) {
+			directive = ZSTD_e_end;
+		}
+		else if (flags & G_CONVERTER_FLUSH) {
+			directive = ZSTD_e_flush;
+		}
+
+		ret = ZSTD_compressStream2 (zstd->cctx, &out, &in, directive);
+	} else {
+		if (inbuf_size == 0 && zstd->frame_done &&
+		    (flags & G_CONVERTER_INPUT_AT_END)) {
+			*bytes_read = 0;
+			*bytes_written = 0;
+			return G_CONVERTER_FINISHED;
+		}
+
+		ret = ZSTD_decompressStream (zstd->dctx, &out, &in);
+		if (!ZSTD_isError (ret)) {
+			zstd->frame_done = (ret == 0);
+		}
+	}
+
+	if (ZSTD_isError (ret)) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_INVALID_DATA,
+			     "%s", ZSTD_getErrorName (ret));
+		return G_CONVERTER_ERROR;
+	}
+
+	*bytes_read = in.pos;
+	*bytes_written = out.pos;
+
+	/* Zero is returned when a frame is complete, or everything asked
+	 * for is flushed.
+	 */
+	if (ret == 0) {
+		if (zstd->cctx && directive == ZSTD_e_end) {
+			return G_CONVERTER_FINISHED;
+		}
+		if (zstd->dctx && in.pos == inbuf_size &&
+		    (flags & G_CONVERTER_INPUT_AT_END)) {
+			return G_CONVERTER_FINISHED;
+		}
+		if (directive == ZSTD_e_flush) {
+			return G_CONVERTER_FLUSHED;
+		}
+	}
+
+	if (in.pos == 0 && out.pos == 0) {
+		if (outbuf_size == 0 || directive != ZSTD_e_continue) {
+			g_set_error_literal (error,
+					     G_IO_ERROR,
+					     G_IO_ERROR_NO_SPACE,
+					     _("Not enough room for the output"));
+		}
+		else if (flags & G_CONVERTER_INPUT_AT_END) {
+			g_set_error_literal (error,
+					     G_IO_ERROR,
+					     G_IO_ERROR_INVALID_DATA,
+					     _("The compressed data ends too early"));
+		} else {
+			g_set_error_literal (error,
+					     G_IO_ERROR,
+					     G_IO_ERROR_PARTIAL_INPUT,
+					     _("Need more input"));
+		}
+		return G_CONVERTER_ERROR;
+	}
+
+	return G_CONVERTER_CONVERTED;
+}
+
+static void
+zstd_converter_reset (GConverter *converter)
+{
+	ZstdConverter *zstd = (ZstdConverter *) converter;
+
+	if (zstd->cctx) {
+		ZSTD_CCtx_reset (zstd->cctx, ZSTD_reset_session_only);
+	} else {
+		ZSTD_DCtx_reset (zstd->dctx, ZSTD_reset_session_only);
+		zstd->frame_done = FALSE;
+	}
+}
+
+static void
+zstd_converter_iface_init (GConverterIface *iface)
+{
+	iface->convert = zstd_converter_convert;
+	iface->reset = zstd_converter_reset;
+}
+
+static GConverter *
+zstd_converter_new (gboolean compress)
+{
+	ZstdConverter *zstd;
+
+	zstd = g_object_new (zstd_converter_get_type (), NULL);
+
+	if (compress) {
+		zstd->cctx = ZSTD_createCCtx ();
+		ZSTD_CCtx_setParameter (zstd->cctx, ZSTD_c_compressionLevel,
+					ZSTD_CLEVEL_DEFAULT);
+	} else {
+		zstd->dctx = ZSTD_createDCtx ();
+	}
+
+	return G_CONVERTER (zstd);
+}
+
+#endif /* HAVE_ZSTD */
+
+static GConverter *
+compression_converter_new (MrpFileCompression compression, gboolean compress)
+{
+	switch (compression) {
+	case MRP_FILE_COMPRESSION_GZIP:
+		if (compress) {
+			return G_CONVERTER (g_zlib_compressor_new (
+						    G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1));
+		}
+		return G_CONVERTER (g_zlib_decompressor_new (
+					    G_ZLIB_COMPRESSOR_FORMAT_GZIP));
+#ifdef HAVE_ZSTD
+	case MRP_FILE_COMPRESSION_ZSTD:
+		return zstd_converter_new (compress);
+#endif
+	default:
+		return NULL;
+	}
+}
+
+MrpFileCompression
+imrp_compression_detect (const gchar *data, gsize length)
+{
+	if (length >= sizeof (gzip_magic) &&
+	    memcmp (data, gzip_magic, sizeof (gzip_magic)) == 0) {
+		return MRP_FILE_COMPRESSION_GZIP;
+	}
+
+	if (length >= sizeof (zstd_magic) &&
+	    memcmp (data, zstd_magic, sizeof (zstd_magic)) == 0) {
+		return MRP_FILE_COMPRESSION_ZSTD;
+	}
+
+	return MRP_FILE_COMPRESSION_NONE;
+}
+
+/* Reads all of @filename into @contents, like g_file_get_contents(), and
+ * decompresses it on the way if it's compressed.
+ */
+gboolean
+imrp_compression_read_file (const gchar         *filename,
+			    gchar              **contents,
+			    gsize               *length,
+			    MrpFileCompression  *compression,
+			    GError             **error)
+{
+	GFile              *file;
+	GInputStream       *stream;
+	GInputStream       *buffered;
+	GConverter         *converter;
+	GString            *str;
+	const gchar        *head;
+	gsize               head_length;
+	gsize               len;
+	gssize              n;
+	MrpFileCompression  detected;
+
+	file = g_file_new_for_path (filename);
+	stream = G_INPUT_STREAM (g_file_read (file, NULL, error));
+	g_object_unref (file);
+
+	if (!stream) {
+		return FALSE;
+	}
+
+	buffered = g_buffered_input_stream_new_sized (stream, CHUNK_SIZE);
+	g_object_unref (stream);
+
+	if (g_buffered_input_stream_fill (G_BUFFERED_INPUT_STREAM (buffered),
+					  -1, NULL, error) < 0) {
+		g_object_unref (buffered);
+		return FALSE;
+	}
+
+	head = g_buffered_input_stream_peek_buffer (G_BUFFERED_INPUT_STREAM (buffered),
+						    &head_length);
+	detected = imrp_compression_detect (head, head_length);
+
+	if (!mrp_file_compression_is_supported (detected)) {
+		g_set_error (error,
+			     MRP_ERROR,
+			     MRP_ERROR_LOAD_FILE_INVALID,
+			     _("'%s' is compressed in a format that is not supported"),
+			     filename);
+		g_object_unref (buffered);
+		return FALSE;
+	}
+
+	converter = compression_converter_new (detected, FALSE);
+	if (converter) {
+		stream = g_converter_input_stream_new (buffered, converter);
+		g_object_unref (converter);
+		g_object_unref (buffered);
+	} else {
+		stream = buffered;
+	}
+
+	str = g_string_sized_new (CHUNK_SIZE);
+
+	do {
+		len = str->len;
+		g_string_set_size (str, len + CHUNK_SIZE);
+
+		n = g_input_stream_read (stream, str->str + len, CHUNK_SIZE, NULL, error);
+		g_string_set_size (str, len + MAX (n, 0));
+	} while (n > 0);
+
+	g_object_unref (stream);
+
+	if (n < 0) {
+		g_string_free (str, TRUE);
+		return FALSE;
+	}
+
+	if (length) {
+		*length = str->len;
+	}
+	if (compression) {
+		*compression = detected;
+	}
+
+	*contents = g_string_free (str, FALSE);
+
+	return TRUE;
+}
+
+/* Opens @filename for writing, what is written to the stream is compressed
+ * with @compression. The file only replaces an existing one when the stream
+ * is closed, closing it with a cancelled cancellable leaves the old file.
+ */
+GOutputStream *
+imrp_compression_create_file (const gchar         *filename,
+			      MrpFileCompression   compression,
+			      GError             **error)
+{
+	GFile         *file;
+	GOutputStream *stream;
+	GOutputStream *converted;
+	GConverter    *converter;
+
+	if (!mrp_file_compression_is_supported (compression)) {
+		g_set_error (error,
+			     MRP_ERROR,
+			     MRP_ERROR_SAVE_WRITE_FAILED,
+			     _("The compression format is not supported"));
+		return NULL;
+	}
+
+	file = g_file_new_for_path (filename);
+	stream = G_OUTPUT_STREAM (g_file_replace (file, NULL, FALSE,
+						  G_FILE_CREATE_NONE, NULL, error));
+	g_object_unref (file);
+
+	if (!stream) {
+		return NULL;
+	}
+
+	converter = compression_converter_new (compression, TRUE);
+	if (converter) {
+		converted = g_converter_output_stream_new (stream, converter);
+		g_object_unref (converter);
+		g_object_unref (stream);
+		stream = converted;
+	}
+
+	converted = g_buffered_output_stream_new_sized (stream, CHUNK_SIZE);
+	g_object_unref (stream);
+
+	return converted;
+}
+
+/* Returns the name @uri is saved under. Names without a project extension
+ * get ".planner" added, compressed names are taken as they are.
+ */
+gchar *
+imrp_compression_get_save_name (const gchar *uri)
+{
+	if (strstr (uri, ".mrproject") || strstr (uri, ".planner") ||
+	    g_str_has_suffix (uri, ".gz") || g_str_has_suffix (uri, ".zst")) {
+		return g_strdup (uri);
+	}
+
+	return g_strconcat (uri, ".planner", NULL);
+}
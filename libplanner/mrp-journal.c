@@ -0,0 +1,1520 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Edit journal. Every change made to a project is appended to a file as a
+ * line of text when it happens, so that the changes made since the project
+ * was last saved can be replayed on top of the saved project after a crash.
+ * Saving compacts the journal down to its header again. The header has the
+ * size of the project when the journal was started, and the size and
+ * modification time of the file it was saved in, so that a journal isn't
+ * replayed on top of another version of the file.
+ *
+ * Tasks, resources and groups are referred to by a number. The objects of
+ * the saved project are numbered when the journal starts or is compacted,
+ * tasks depth first from the root, then resources, then groups, which is the
+ * order they are in again after the project is loaded. Objects added later
+ * take the next numbers. Assignments are referred to as A<task>,<resource>,
+ * relations as L<successor>,<predecessor> and the project itself as P.
+ *
+ * After the header, each line is a record of tab separated fields, the first
+ * one says what changed:
+ *
+ *   S ref name value                         a property was set
+ *   C ref name value                         a custom property was set
+ *   T id parent position                     a task was inserted
+ *   t ref                                    a task was removed
+ *   M ref parent position                    a task was moved
+ *   R id, r ref                              a resource was added, removed
+ *   G id, g ref                              a group was added, removed
+ *   A task resource units                    a resource was assigned
+ *   a ref                                    an assignment was removed
+ *   L task predecessor type lag              a relation was added
+ *   l ref                                    a relation was removed
+ *   D owner name type label description user-defined
+ *                                            a custom property was added
+ *   E owner name label description           a custom property was changed
+ *   d owner name                             a custom property was removed
+ *
+ * New objects are followed by S and C records for their values. Calendars,
+ * day types and baselines are not recorded.
+ *
+ * A project that was never saved is replayed on a new project, which starts
+ * on the day it is created. The first change made to it is therefore
+ * preceded by S records for the values of the project itself, its start
+ * among them. A journal with no records has nothing to recover.
+ *
+ * Each record is written with a single write, so it survives the program
+ * crashing, and the file is synced to disk at most every few seconds. A
+ * record that was cut short is dropped on replay. The journal is replayed on
+ * a scratch copy of the project first, so that one that doesn't replay
+ * completely leaves the project alone. The copy is a round trip through the
+ * XML format, so recovering a large project costs about a save and a load
+ * on top of the replay itself. Only a journal with records pays for it.
+ */
+
+#include <config.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+#ifdef G_OS_WIN32
+#include <io.h>
+#define fsync _commit
+#else
+#include <unistd.h>
+#endif
+#include "mrp-error.h"
+#include "mrp-private.h"
+#include "mrp-group.h"
+#include "mrp-resource.h"
+#include "mrp-relation.h"
+#include "mrp-assignment.h"
+#include "mrp-property.h"
+#include "mrp-project.h"
+
+#define JOURNAL_MAGIC         "planner-journal"
+#define JOURNAL_VERSION       2
+
+/* Seconds between syncs of the journal to disk. */
+#define JOURNAL_SYNC_INTERVAL 2
+
+struct _MrpJournal {
+	MrpProject     *project;
+	MrpTaskManager *manager;
+	gchar          *filename;
+	FILE           *file;
+
+	/* Tasks, resources and groups -> their number, and back. */
+	GHashTable     *ids;
+	GPtrArray      *objects;
+
+	/* The size of the project when it was numbered. */
+	guint           n_tasks;
+	guint           n_resources;
+	guint           n_groups;
+
+	/* The file the project was saved in, 0 if there is none. */
+	gint64          file_size;
+	gint64          file_mtime;
+
+	/* The objects whose changes are recorded. */
+	GHashTable     *watched;
+
+	GString        *record;
+	guint           sync_id;
+	gboolean        dirty;
+
+	/* The project was never saved, its values go before the first record. */
+	gboolean        write_project;
+};
+
+static void
+journal_add_object (MrpJournal *journal, gpointer object, guint id)
+{
+	g_hash_table_insert (journal->ids, g_object_ref (object), GUINT_TO_POINTER (id));
+
+	if (id >= journal->objects->len) {
+		g_ptr_array_set_size (journal->objects, id + 1);
+	}
+
+	g_ptr_array_index (journal->objects, id) = object;
+}
+
+static gboolean
+journal_get_id (MrpJournal *journal, gpointer object, guint *id)
+{
+	gpointer value;
+
+	if (!g_hash_table_lookup_extended (journal->ids, object, NULL, &value)) {
+		return FALSE;
+	}
+
+	*id = GPOINTER_TO_UINT (value);
+
+	return TRUE;
+}
+
+/* Objects that are put back, e.g. by undo, keep their number. */
+static guint
+journal_ensure_id (MrpJournal *journal, gpointer object)
+{
+	guint id;
+
+	if (!journal_get_id (journal, object, &id)) {
+		id = journal->objects->len;
+		journal_add_object (journal, object, id);
+	}
+
+	return id;
+}
+
+static gboolean
+journal_index_task (MrpTask *task, MrpJournal *journal)
+{
+	journal_add_object (journal, task, journal->objects->len);
+	journal->n_tasks++;
+
+	return FALSE;
+}
+
+static void
+journal_index_project (MrpJournal *journal)
+{
+	MrpProject *project = journal->project;
+	GList      *l;
+
+	g_hash_table_remove_all (journal->ids);
+	g_ptr_array_set_size (journal->objects, 0);
+
+	journal->n_tasks = 0;
+	mrp_project_task_traverse (project,
+				   mrp_project_get_root_task (project),
+				   (MrpTaskTraverseFunc) journal_index_task,
+				   journal);
+
+	l = mrp_project_get_resources (project);
+	journal->n_resources = g_list_length (l);
+	for (; l; l = l->next) {
+		journal_add_object (journal, l->data, journal->objects->len);
+	}
+
+	l = mrp_project_get_groups (project);
+	journal->n_groups = g_list_length (l);
+	for (; l; l = l->next) {
+		journal_add_object (journal, l->data, journal->objects->len);
+	}
+}
+
+static gpointer
+journal_lookup_id (MrpJournal *journal, guint64 id)
+{
+	if (id >= journal->objects->len) {
+		return NULL;
+	}
+
+	return g_ptr_array_index (journal->objects, id);
+}
+
+static gboolean
+journal_parse_id (const gchar *str, guint64 *id)
+{
+	gchar *end;
+
+	*id = g_ascii_strtoull (str, &end, 10);
+
+	return end != str && *end == '\0';
+}
+
+static gpointer
+journal_lookup_ref (MrpJournal *journal, const gchar *ref)
+{
+	gpointer  first, second;
+	guint64   id;
+	gchar    *end;
+
+	switch (ref[0]) {
+	case 'P':
+		return journal->project;
+
+	case 'A':
+	case 'L':
+		first = journal_lookup_id (journal, g_ascii_strtoull (ref + 1, &end, 10));
+		if (*end != ',') {
+			return NULL;
+		}
+		second = journal_lookup_id (journal, g_ascii_strtoull (end + 1, NULL, 10));
+
+		if (!MRP_IS_TASK (first)) {
+			return NULL;
+		}
+
+		if (ref[0] == 'A') {
+			if (!MRP_IS_RESOURCE (second)) {
+				return NULL;
+			}
+			return mrp_task_get_assignment (first, second);
+		}
+
+		if (!MRP_IS_TASK (second)) {
+			return NULL;
+		}
+		return mrp_task_get_predecessor_relation (first, second);
+
+	default:
+		if (!journal_parse_id (ref, &id)) {
+			return NULL;
+		}
+		return journal_lookup_id (journal, id);
+	}
+}
+
+static gboolean
+journal_append_ref (MrpJournal *journal, gpointer object)
+{
+	guint first, second;
+
+	if (object == (gpointer) journal->project) {
+		g_string_append_c (journal->record, 'P');
+		return TRUE;
+	}
+
+	if (MRP_IS_ASSIGNMENT (object)) {
+		if (!journal_get_id (journal, mrp_assignment_get_task (object), &first) ||
+		    !journal_get_id (journal, mrp_assignment_get_resource (object), &second)) {
+			return FALSE;
+		}
+
+		g_string_append_printf (journal->record, "A%u,%u", first, second);
+		return TRUE;
+	}
+
+	if (MRP_IS_RELATION (object)) {
+		if (!journal_get_id (journal, mrp_relation_get_successor (object), &first) ||
+		    !journal_get_id (journal, mrp_relation_get_predecessor (object), &second)) {
+			return FALSE;
+		}
+
+		g_string_append_printf (journal->record, "L%u,%u", first, second);
+		return TRUE;
+	}
+
+	if (!journal_get_id (journal, object, &first)) {
+		return FALSE;
+	}
+
+	g_string_append_printf (journal->record, "%u", first);
+
+	return TRUE;
+}
+
+static void
+journal_append_string (MrpJournal *journal, const gchar *str)
+{
+	gchar *escaped;
+
+	escaped = g_strescape (str ? str : "", NULL);
+	g_string_append (journal->record, escaped);
+	g_free (escaped);
+}
+
+/* Returns FALSE for values that can't be recorded, like pointers and
+ * calendars.
+ */
+static gboolean
+journal_append_value (MrpJournal *journal, const GValue *value)
+{
+	GString       *record = journal->record;
+	MrpConstraint *constraint;
+	gchar          buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+	if (G_VALUE_HOLDS (value, MRP_TYPE_CONSTRAINT)) {
+		constraint = g_value_get_boxed (value);
+		if (!constraint) {
+			return FALSE;
+		}
+
+		g_string_append_printf (record, "%d,%" G_GINT64_FORMAT,
+					constraint->type, constraint->time);
+		return TRUE;
+	}
+
+	switch (G_TYPE_FUNDAMENTAL (G_VALUE_TYPE (value))) {
+	case G_TYPE_STRING:
+		journal_append_string (journal, g_value_get_string (value));
+		break;
+	case G_TYPE_BOOLEAN:
+		g_string_append_printf (record, "%d", g_value_get_boolean (value));
+		break;
+	case G_TYPE_INT:
+		g_string_append_printf (record, "%d", g_value_get_int (value));
+		break;
+	case G_TYPE_UINT:
+		g_string_append_printf (record, "%u", g_value_get_uint (value));
+		break;
+	case G_TYPE_LONG:
+		g_string_append_printf (record, "%ld", g_value_get_long (value));
+		break;
+	case G_TYPE_INT64:
+		g_string_append_printf (record, "%" G_GINT64_FORMAT, g_value_get_int64 (value));
+		break;
+	case G_TYPE_ENUM:
+		g_string_append_printf (record, "%d", g_value_get_enum (value));
+		break;
+	case G_TYPE_FLOAT:
+		g_string_append (record, g_ascii_dtostr (buf, sizeof (buf),
+							 g_value_get_float (value)));
+		break;
+	case G_TYPE_DOUBLE:
+		g_string_append (record, g_ascii_dtostr (buf, sizeof (buf),
+							 g_value_get_double (value)));
+		break;
+	case G_TYPE_OBJECT:
+		if (!g_value_get_object (value)) {
+			g_string_append_c (record, '-');
+			break;
+		}
+		return journal_append_ref (journal, g_value_get_object (value));
+	default:
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+journal_parse_value (MrpJournal *journal, const gchar *str, GValue *value)
+{
+	MrpConstraint  constraint;
+	gpointer       object;
+	gchar         *end;
+
+	if (G_VALUE_HOLDS (value, MRP_TYPE_CONSTRAINT)) {
+		constraint.type = g_ascii_strtoll (str, &end, 10);
+		if (*end != ',') {
+			return FALSE;
+		}
+		constraint.time = g_ascii_strtoll (end + 1, NULL, 10);
+
+		g_value_set_boxed (value, &constraint);
+		return TRUE;
+	}
+
+	switch (G_TYPE_FUNDAMENTAL (G_VALUE_TYPE (value))) {
+	case G_TYPE_STRING:
+		g_value_take_string (value, g_strcompress (str));
+		break;
+	case G_TYPE_BOOLEAN:
+		g_value_set_boolean (value, g_ascii_strtoll (str, NULL, 10) != 0);
+		break;
+	case G_TYPE_INT:
+		g_value_set_int (value, g_ascii_strtoll (str, NULL, 10));
+		break;
+	case G_TYPE_UINT:
+		g_value_set_uint (value, g_ascii_strtoull (str, NULL, 10));
+		break;
+	case G_TYPE_LONG:
+		g_value_set_long (value, g_ascii_strtoll (str, NULL, 10));
+		break;
+	case G_TYPE_INT64:
+		g_value_set_int64 (value, g_ascii_strtoll (str, NULL, 10));
+		break;
+	case G_TYPE_ENUM:
+		g_value_set_enum (value, g_ascii_strtoll (str, NULL, 10));
+		break;
+	case G_TYPE_FLOAT:
+		g_value_set_float (value, g_ascii_strtod (str, NULL));
+		break;
+	case G_TYPE_DOUBLE:
+		g_value_set_double (value, g_ascii_strtod (str, NULL));
+		break;
+	case G_TYPE_OBJECT:
+		if (strcmp (str, "-") == 0) {
+			g_value_set_object (value, NULL);
+			break;
+		}
+
+		object = journal_lookup_ref (journal, str);
+		if (!object || !g_type_is_a (G_OBJECT_TYPE (object), G_VALUE_TYPE (value))) {
+			return FALSE;
+		}
+		g_value_set_object (value, object);
+		break;
+	default:
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Writing records. */
+
+static gboolean
+journal_sync_cb (MrpJournal *journal)
+{
+	journal->sync_id = 0;
+
+	imrp_journal_sync (journal);
+
+	return FALSE;
+}
+
+static void journal_write_state (MrpJournal *journal, gpointer object);
+
+static void
+journal_begin (MrpJournal *journal, gchar type)
+{
+	if (journal->write_project) {
+		journal->write_project = FALSE;
+		journal_write_state (journal, journal->project);
+	}
+
+	g_string_truncate (journal->record, 0);
+	g_string_append_c (journal->record, type);
+}
+
+static void
+journal_commit (MrpJournal *journal)
+{
+	GString *record = journal->record;
+
+	if (!journal->file) {
+		return;
+	}
+
+	g_string_append_c (record, '\n');
+
+	/* The flush hands the record to the system, syncing it to disk is
+	 * left to the timeout.
+	 */
+	if (fwrite (record->str, 1, record->len, journal->file) != record->len ||
+	    fflush (journal->file) != 0) {
+		g_warning ("Couldn't write to the journal '%s': %s",
+			   journal->filename, g_strerror (errno));
+		return;
+	}
+
+	journal->dirty = TRUE;
+
+	if (!journal->sync_id) {
+		journal->sync_id = g_timeout_add_seconds (JOURNAL_SYNC_INTERVAL,
+							  (GSourceFunc) journal_sync_cb,
+							  journal);
+	}
+}
+
+/* Notes the size and modification time of the file the project was saved
+ * in, for telling whether the journal belongs to it.
+ */
+static void
+journal_stat_file (MrpJournal *journal)
+{
+	const gchar *uri;
+	gchar       *filename;
+	GStatBuf     buf;
+
+	journal->file_size = 0;
+	journal->file_mtime = 0;
+
+	uri = mrp_project_get_uri (journal->project);
+	if (uri == NULL || strncmp (uri, "sql://", 6) == 0) {
+		return;
+	}
+
+	if (g_str_has_prefix (uri, "file:")) {
+		filename = g_filename_from_uri (uri, NULL, NULL);
+	} else {
+		filename = g_strdup (uri);
+	}
+
+	if (filename && g_stat (filename, &buf) == 0) {
+		journal->file_size = buf.st_size;
+		journal->file_mtime = buf.st_mtime;
+	}
+
+	g_free (filename);
+}
+
+static void
+journal_format_header (MrpJournal *journal, GString *str)
+{
+	g_string_printf (str, "%s\t%d\t%u\t%u\t%u\t%" G_GINT64_FORMAT "\t%" G_GINT64_FORMAT,
+			 JOURNAL_MAGIC, JOURNAL_VERSION,
+			 journal->n_tasks, journal->n_resources, journal->n_groups,
+			 journal->file_size, journal->file_mtime);
+}
+
+static void
+journal_write_header (MrpJournal *journal)
+{
+	journal_format_header (journal, journal->record);
+	journal_commit (journal);
+}
+
+static void
+journal_write_ref (MrpJournal *journal, gchar type, gpointer object)
+{
+	journal_begin (journal, type);
+	g_string_append_c (journal->record, '\t');
+
+	if (journal_append_ref (journal, object)) {
+		journal_commit (journal);
+	}
+}
+
+static void
+journal_write_property (MrpJournal   *journal,
+			gchar         type,
+			gpointer      object,
+			const gchar  *name,
+			const GValue *value)
+{
+	journal_begin (journal, type);
+	g_string_append_c (journal->record, '\t');
+
+	if (!journal_append_ref (journal, object)) {
+		return;
+	}
+
+	g_string_append_c (journal->record, '\t');
+	g_string_append (journal->record, name);
+	g_string_append_c (journal->record, '\t');
+
+	if (journal_append_value (journal, value)) {
+		journal_commit (journal);
+	}
+}
+
+static gboolean
+journal_param_is_recorded (GParamSpec *pspec)
+{
+	return (pspec->flags & G_PARAM_WRITABLE) &&
+		!(pspec->flags & G_PARAM_CONSTRUCT_ONLY) &&
+		pspec->owner_type != MRP_TYPE_OBJECT;
+}
+
+static void
+journal_write_params (MrpJournal  *journal,
+		      gpointer     object,
+		      GParamSpec **pspecs,
+		      guint        n_pspecs,
+		      gboolean     enums)
+{
+	GValue value = G_VALUE_INIT;
+	guint  i;
+
+	for (i = 0; i < n_pspecs; i++) {
+		if (!journal_param_is_recorded (pspecs[i]) ||
+		    G_TYPE_IS_ENUM (pspecs[i]->value_type) != enums) {
+			continue;
+		}
+
+		g_value_init (&value, pspecs[i]->value_type);
+		g_object_get_property (object, pspecs[i]->name, &value);
+
+		if (!g_param_value_defaults (pspecs[i], &value)) {
+			journal_write_property (journal, 'S', object,
+						pspecs[i]->name, &value);
+		}
+
+		g_value_unset (&value);
+	}
+}
+
+/* Records the values of a new object that differ from the defaults. The
+ * task type and scheduling go first, they decide how work and duration are
+ * taken.
+ */
+static void
+journal_write_state (MrpJournal *journal, gpointer object)
+{
+	GParamSpec **pspecs;
+	GList       *properties, *l;
+	GValue       value = G_VALUE_INIT;
+	guint        n_pspecs;
+
+	pspecs = g_object_class_list_properties (G_OBJECT_GET_CLASS (object), &n_pspecs);
+	journal_write_params (journal, object, pspecs, n_pspecs, TRUE);
+	journal_write_params (journal, object, pspecs, n_pspecs, FALSE);
+	g_free (pspecs);
+
+	properties = mrp_project_get_properties_from_type (journal->project,
+							   G_OBJECT_TYPE (object));
+
+	for (l = properties; l; l = l->next) {
+		g_value_init (&value, G_PARAM_SPEC_VALUE_TYPE (l->data));
+		mrp_object_get_property (object, l->data, &value);
+
+		if (!g_param_value_defaults (l->data, &value)) {
+			journal_write_property (journal, 'C', object,
+						mrp_property_get_name (l->data),
+						&value);
+		}
+
+		g_value_unset (&value);
+	}
+
+	g_list_free (properties);
+}
+
+/* Watching the project. */
+
+static void journal_watch_object (MrpJournal *journal, gpointer object);
+
+static void
+journal_notify_cb (GObject    *object,
+		   GParamSpec *pspec,
+		   MrpJournal *journal)
+{
+	GValue value = G_VALUE_INIT;
+
+	/* What the scheduler changes follows from the other changes. */
+	if (!journal_param_is_recorded (pspec) ||
+	    imrp_task_manager_get_in_recalc (journal->manager)) {
+		return;
+	}
+
+	g_value_init (&value, pspec->value_type);
+	g_object_get_property (object, pspec->name, &value);
+
+	journal_write_property (journal, 'S', object, pspec->name, &value);
+
+	g_value_unset (&value);
+}
+
+static void
+journal_prop_changed_cb (MrpObject   *object,
+			 MrpProperty *property,
+			 GValue      *value,
+			 MrpJournal  *journal)
+{
+	journal_write_property (journal, 'C', object,
+				mrp_property_get_name (property), value);
+}
+
+static void
+journal_assignment_added_cb (MrpTask       *task,
+			     MrpAssignment *assignment,
+			     MrpJournal    *journal)
+{
+	journal_begin (journal, 'A');
+	g_string_append_c (journal->record, '\t');
+	if (!journal_append_ref (journal, task)) {
+		return;
+	}
+
+	g_string_append_c (journal->record, '\t');
+	if (!journal_append_ref (journal, mrp_assignment_get_resource (assignment))) {
+		return;
+	}
+
+	g_string_append_printf (journal->record, "\t%d",
+				mrp_assignment_get_units (assignment));
+	journal_commit (journal);
+
+	journal_watch_object (journal, assignment);
+}
+
+static void
+journal_assignment_removed_cb (MrpTask       *task,
+			       MrpAssignment *assignment,
+			       MrpJournal    *journal)
+{
+	journal_write_ref (journal, 'a', assignment);
+}
+
+static void
+journal_relation_added_cb (MrpTask     *task,
+			   MrpRelation *relation,
+			   MrpJournal  *journal)
+{
+	/* Emitted on both tasks, record it once. */
+	if (mrp_relation_get_successor (relation) != task) {
+		return;
+	}
+
+	journal_begin (journal, 'L');
+	g_string_append_c (journal->record, '\t');
+	if (!journal_append_ref (journal, task)) {
+		return;
+	}
+
+	g_string_append_c (journal->record, '\t');
+	if (!journal_append_ref (journal, mrp_relation_get_predecessor (relation))) {
+		return;
+	}
+
+	g_string_append_printf (journal->record, "\t%d\t%d",
+				mrp_relation_get_relation_type (relation),
+				mrp_relation_get_lag (relation));
+	journal_commit (journal);
+
+	journal_watch_object (journal, relation);
+}
+
+static void
+journal_relation_removed_cb (MrpTask     *task,
+			     MrpRelation *relation,
+			     MrpJournal  *journal)
+{
+	if (mrp_relation_get_successor (relation) == task) {
+		journal_write_ref (journal, 'l', relation);
+	}
+}
+
+static void
+journal_watch_object (MrpJournal *journal, gpointer object)
+{
+	if (!g_hash_table_add (journal->watched, g_object_ref (object))) {
+		return;
+	}
+
+	g_signal_connect (object, "notify",
+			  G_CALLBACK (journal_notify_cb),
+			  journal);
+	g_signal_connect (object, "prop_changed",
+			  G_CALLBACK (journal_prop_changed_cb),
+			  journal);
+
+	if (!MRP_IS_TASK (object)) {
+		return;
+	}
+
+	g_signal_connect (object, "assignment_added",
+			  G_CALLBACK (journal_assignment_added_cb),
+			  journal);
+	g_signal_connect (object, "assignment_removed",
+			  G_CALLBACK (journal_assignment_removed_cb),
+			  journal);
+	g_signal_connect (object, "relation_added",
+			  G_CALLBACK (journal_relation_added_cb),
+			  journal);
+	g_signal_connect (object, "relation_removed",
+			  G_CALLBACK (journal_relation_removed_cb),
+			  journal);
+}
+
+static gboolean
+journal_watch_task (MrpTask *task, MrpJournal *journal)
+{
+	GList *l;
+
+	journal_watch_object (journal, task);
+
+	for (l = mrp_task_get_assignments (task); l; l = l->next) {
+		journal_watch_object (journal, l->data);
+	}
+
+	for (l = imrp_task_peek_predecessors (task); l; l = l->next) {
+		journal_watch_object (journal, l->data);
+	}
+
+	return FALSE;
+}
+
+static void
+journal_write_new_object (MrpJournal *journal, gchar type, gpointer object)
+{
+	journal_begin (journal, type);
+	g_string_append_printf (journal->record, "\t%u",
+				journal_ensure_id (journal, object));
+	journal_commit (journal);
+
+	journal_write_state (journal, object);
+	journal_watch_object (journal, object);
+}
+
+static void
+journal_task_inserted_cb (MrpProject *project,
+			  MrpTask    *task,
+			  MrpJournal *journal)
+{
+	journal_begin (journal, 'T');
+	g_string_append_printf (journal->record, "\t%u\t",
+				journal_ensure_id (journal, task));
+
+	if (!journal_append_ref (journal, mrp_task_get_parent (task))) {
+		return;
+	}
+
+	g_string_append_printf (journal->record, "\t%d", mrp_task_get_position (task));
+	journal_commit (journal);
+
+	journal_write_state (journal, task);
+	journal_watch_task (task, journal);
+}
+
+static void
+journal_task_removed_cb (MrpProject *project,
+			 MrpTask    *task,
+			 MrpJournal *journal)
+{
+	journal_write_ref (journal, 't', task);
+}
+
+static void
+journal_task_moved_cb (MrpProject *project,
+		       MrpTask    *task,
+		       MrpJournal *journal)
+{
+	journal_begin (journal, 'M');
+	g_string_append_c (journal->record, '\t');
+	if (!journal_append_ref (journal, task)) {
+		return;
+	}
+
+	g_string_append_c (journal->record, '\t');
+	if (!journal_append_ref (journal, mrp_task_get_parent (task))) {
+		return;
+	}
+
+	g_string_append_printf (journal->record, "\t%d", mrp_task_get_position (task));
+	journal_commit (journal);
+}
+
+static void
+journal_resource_added_cb (MrpProject  *project,
+			   MrpResource *resource,
+			   MrpJournal  *journal)
+{
+	journal_write_new_object (journal, 'R', resource);
+}
+
+static void
+journal_resource_removed_cb (MrpProject  *project,
+			     MrpResource *resource,
+			     MrpJournal  *journal)
+{
+	journal_write_ref (journal, 'r', resource);
+}
+
+static void
+journal_group_added_cb (MrpProject *project,
+			MrpGroup   *group,
+			MrpJournal *journal)
+{
+	journal_write_new_object (journal, 'G', group);
+}
+
+static void
+journal_group_removed_cb (MrpProject *project,
+			  MrpGroup   *group,
+			  MrpJournal *journal)
+{
+	journal_write_ref (journal, 'g', group);
+}
+
+static void
+journal_property_added_cb (MrpProject  *project,
+			   GType        object_type,
+			   MrpProperty *property,
+			   MrpJournal  *journal)
+{
+	journal_begin (journal, 'D');
+	g_string_append_printf (journal->record, "\t%s\t%s\t%d\t",
+				g_type_name (object_type),
+				mrp_property_get_name (property),
+				mrp_property_get_property_type (property));
+	journal_append_string (journal, mrp_property_get_label (property));
+	g_string_append_c (journal->record, '\t');
+	journal_append_string (journal, mrp_property_get_description (property));
+	g_string_append_printf (journal->record, "\t%d",
+				mrp_property_get_user_defined (property));
+	journal_commit (journal);
+}
+
+static void
+journal_property_changed_cb (MrpProject  *project,
+			     MrpProperty *property,
+			     MrpJournal  *journal)
+{
+	journal_begin (journal, 'E');
+	g_string_append_printf (journal->record, "\t%s\t%s\t",
+				g_type_name (G_PARAM_SPEC (property)->owner_type),
+				mrp_property_get_name (property));
+	journal_append_string (journal, mrp_property_get_label (property));
+	g_string_append_c (journal->record, '\t');
+	journal_append_string (journal, mrp_property_get_description (property));
+	journal_commit (journal);
+}
+
+static void
+journal_property_removed_cb (MrpProject  *project,
+			     MrpProperty *property,
+			     MrpJournal  *journal)
+{
+	journal_begin (journal, 'd');
+	g_string_append_printf (journal->record, "\t%s\t%s",
+				g_type_name (G_PARAM_SPEC (property)->owner_type),
+				mrp_property_get_name (property));
+	journal_commit (journal);
+}
+
+static void
+journal_watch_project (MrpJournal *journal)
+{
+	MrpProject *project = journal->project;
+	GList      *l;
+
+	g_signal_connect (project, "notify",
+			  G_CALLBACK (journal_notify_cb),
+			  journal);
+	g_signal_connect (project, "prop_changed",
+			  G_CALLBACK (journal_prop_changed_cb),
+			  journal);
+	g_signal_connect (project, "task_inserted",
+			  G_CALLBACK (journal_task_inserted_cb),
+			  journal);
+	g_signal_connect (project, "task_removed",
+			  G_CALLBACK (journal_task_removed_cb),
+			  journal);
+	g_signal_connect (project, "task_moved",
+			  G_CALLBACK (journal_task_moved_cb),
+			  journal);
+	g_signal_connect (project, "resource_added",
+			  G_CALLBACK (journal_resource_added_cb),
+			  journal);
+	g_signal_connect (project, "resource_removed",
+			  G_CALLBACK (journal_resource_removed_cb),
+			  journal);
+	g_signal_connect (project, "group_added",
+			  G_CALLBACK (journal_group_added_cb),
+			  journal);
+	g_signal_connect (project, "group_removed",
+			  G_CALLBACK (journal_group_removed_cb),
+			  journal);
+	g_signal_connect (project, "property_added",
+			  G_CALLBACK (journal_property_added_cb),
+			  journal);
+	g_signal_connect (project, "property_changed",
+			  G_CALLBACK (journal_property_changed_cb),
+			  journal);
+	g_signal_connect (project, "property_removed",
+			  G_CALLBACK (journal_property_removed_cb),
+			  journal);
+
+	mrp_project_task_traverse (project,
+				   mrp_project_get_root_task (project),
+				   (MrpTaskTraverseFunc) journal_watch_task,
+				   journal);
+
+	for (l = mrp_project_get_resources (project); l; l = l->next) {
+		journal_watch_object (journal, l->data);
+	}
+
+	for (l = mrp_project_get_groups (project); l; l = l->next) {
+		journal_watch_object (journal, l->data);
+	}
+}
+
+static void
+journal_unwatch (MrpJournal *journal)
+{
+	GHashTableIter iter;
+	gpointer       object;
+
+	g_signal_handlers_disconnect_by_data (journal->project, journal);
+
+	g_hash_table_iter_init (&iter, journal->watched);
+	while (g_hash_table_iter_next (&iter, &object, NULL)) {
+		g_signal_handlers_disconnect_by_data (object, journal);
+	}
+
+	g_hash_table_remove_all (journal->watched);
+}
+
+/* Replaying records. */
+
+static gboolean
+journal_replay_property (MrpJournal  *journal,
+			 gboolean     custom,
+			 gpointer     object,
+			 const gchar *name,
+			 const gchar *str)
+{
+	GParamSpec *pspec;
+	GValue      value = G_VALUE_INIT;
+
+	if (custom) {
+		pspec = mrp_project_get_property (journal->project, name,
+						  G_OBJECT_TYPE (object));
+	} else {
+		pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (object), name);
+	}
+
+	if (!pspec) {
+		return FALSE;
+	}
+
+	g_value_init (&value, pspec->value_type);
+
+	if (!journal_parse_value (journal, str, &value)) {
+		g_value_unset (&value);
+		return FALSE;
+	}
+
+	if (custom) {
+		mrp_object_set_property (object, pspec, &value);
+	} else {
+		g_object_set_property (object, name, &value);
+	}
+
+	g_value_unset (&value);
+
+	return TRUE;
+}
+
+/* Moves the task to the position it was recorded at under the parent. */
+static gboolean
+journal_replay_move (MrpJournal *journal,
+		     MrpTask    *task,
+		     MrpTask    *parent,
+		     gint        position)
+{
+	MrpTask *sibling = NULL;
+	MrpTask *child;
+	gint     i = 0;
+
+	for (child = mrp_task_get_first_child (parent);
+	     child && i < position;
+	     child = mrp_task_get_next_sibling (child)) {
+		if (child != task) {
+			sibling = child;
+			i++;
+		}
+	}
+
+	return mrp_project_move_task (journal->project, task, sibling, parent,
+				      sibling == NULL, NULL);
+}
+
+static gboolean
+journal_replay_record (MrpJournal *journal, gchar **fields, guint n_fields)
+{
+	MrpProject  *project = journal->project;
+	MrpProperty *property;
+	gpointer     object, other;
+	GType        owner;
+	guint64      id;
+	gchar       *label, *description;
+
+	if (n_fields < 2 || strlen (fields[0]) != 1) {
+		return FALSE;
+	}
+
+	switch (fields[0][0]) {
+	case 'S':
+	case 'C':
+		object = journal_lookup_ref (journal, fields[1]);
+		if (n_fields != 4 || !object) {
+			return FALSE;
+		}
+		return journal_replay_property (journal, fields[0][0] == 'C',
+						object, fields[2], fields[3]);
+
+	case 'T':
+		other = journal_lookup_ref (journal, fields[2]);
+		if (n_fields != 4 || !MRP_IS_TASK (other) || !journal_parse_id (fields[1], &id)) {
+			return FALSE;
+		}
+
+		/* The task tree takes over the reference, as it does from the
+		 * file readers, and drops it when the task is removed. The
+		 * number holds one of its own, so it can't be unreffed here.
+		 */
+		object = g_object_new (MRP_TYPE_TASK, NULL);
+		journal_add_object (journal, object, id);
+		mrp_project_insert_task (project, other,
+					 g_ascii_strtoll (fields[3], NULL, 10),
+					 object);
+		return TRUE;
+
+	case 't':
+		object = journal_lookup_ref (journal, fields[1]);
+		if (!MRP_IS_TASK (object)) {
+			return FALSE;
+		}
+		mrp_project_remove_task (project, object);
+		return TRUE;
+
+	case 'M':
+		object = journal_lookup_ref (journal, fields[1]);
+		other = journal_lookup_ref (journal, fields[2]);
+		if (n_fields != 4 || !MRP_IS_TASK (object) || !MRP_IS_TASK (other)) {
+			return FALSE;
+		}
+		return journal_replay_move (journal, object, other,
+					    g_ascii_strtoll (fields[3], NULL, 10));
+
+	case 'R':
+	case 'G':
+		if (!journal_parse_id (fields[1], &id)) {
+			return FALSE;
+		}
+
+		/* The project keeps the reference, like for tasks. */
+		if (fields[0][0] == 'R') {
+			object = g_object_new (MRP_TYPE_RESOURCE, NULL);
+			journal_add_object (journal, object, id);
+			mrp_project_add_resource (project, object);
+		} else {
+			object = g_object_new (MRP_TYPE_GROUP, NULL);
+			journal_add_object (journal, object, id);
+			mrp_project_add_group (project, object);
+		}
+		return TRUE;
+
+	case 'r':
+		object = journal_lookup_ref (journal, fields[1]);
+		if (!MRP_IS_RESOURCE (object)) {
+			return FALSE;
+		}
+		mrp_project_remove_resource (project, object);
+		return TRUE;
+
+	case 'g':
+		object = journal_lookup_ref (journal, fields[1]);
+		if (!MRP_IS_GROUP (object)) {
+			return FALSE;
+		}
+		mrp_project_remove_group (project, object);
+		return TRUE;
+
+	case 'A':
+		object = journal_lookup_ref (journal, fields[1]);
+		other = journal_lookup_ref (journal, fields[2]);
+		if (n_fields != 4 || !MRP_IS_TASK (object) || !MRP_IS_RESOURCE (other)) {
+			return FALSE;
+		}
+		mrp_resource_assign (other, object, g_ascii_strtoll (fields[3], NULL, 10));
+		return TRUE;
+
+	case 'a':
+		object = journal_lookup_ref (journal, fields[1]);
+		if (!MRP_IS_ASSIGNMENT (object)) {
+			return FALSE;
+		}
+		mrp_object_removed (object);
+		return TRUE;
+
+	case 'L':
+		object = journal_lookup_ref (journal, fields[1]);
+		other = journal_lookup_ref (journal, fields[2]);
+		if (n_fields != 5 || !MRP_IS_TASK (object) || !MRP_IS_TASK (other)) {
+			return FALSE;
+		}
+		return mrp_task_add_predecessor (object, other,
+						 g_ascii_strtoll (fields[3], NULL, 10),
+						 g_ascii_strtoll (fields[4], NULL, 10),
+						 NULL) != NULL;
+
+	case 'l':
+		object = journal_lookup_ref (journal, fields[1]);
+		if (!MRP_IS_RELATION (object)) {
+			return FALSE;
+		}
+		mrp_task_remove_predecessor (mrp_relation_get_successor (object),
+					     mrp_relation_get_predecessor (object));
+		return TRUE;
+
+	case 'D':
+	case 'E':
+	case 'd':
+		owner = g_type_from_name (fields[1]);
+		if (owner == 0 || n_fields < 3) {
+			return FALSE;
+		}
+
+		if (fields[0][0] == 'd') {
+			mrp_project_remove_property (project, owner, fields[2]);
+			return TRUE;
+		}
+
+		if (n_fields != (fields[0][0] == 'D' ? 7 : 5)) {
+			return FALSE;
+		}
+
+		if (fields[0][0] == 'D') {
+			label = g_strcompress (fields[4]);
+			description = g_strcompress (fields[5]);
+			property = mrp_property_new (fields[2],
+						     g_ascii_strtoll (fields[3], NULL, 10),
+						     label, description,
+						     g_ascii_strtoll (fields[6], NULL, 10));
+			if (property) {
+				mrp_project_add_property (project, owner, property,
+							  mrp_property_get_user_defined (property));
+			}
+		} else {
+			property = mrp_project_get_property (project, fields[2], owner);
+			if (!property) {
+				return FALSE;
+			}
+
+			label = g_strcompress (fields[3]);
+			description = g_strcompress (fields[4]);
+			mrp_property_set_label (property, label);
+			mrp_property_set_description (property, description);
+		}
+
+		g_free (label);
+		g_free (description);
+		return property != NULL;
+
+	default:
+		return FALSE;
+	}
+}
+
+/* Replays the complete lines of @contents and sets @length to where they
+ * end.
+ */
+static gboolean
+journal_replay (MrpJournal  *journal,
+		gchar       *contents,
+		gsize       *length,
+		GError     **error)
+{
+	GString *header;
+	gchar   *line, *end;
+	gchar  **fields;
+	gboolean ok;
+	gint     n_line = 1;
+
+	line = contents;
+	end = memchr (line, '\n', *length);
+	*end = '\0';
+
+	header = g_string_new (NULL);
+	journal_format_header (journal, header);
+	ok = strcmp (line, header->str) == 0;
+	g_string_free (header, TRUE);
+
+	*end = '\n';
+
+	if (!ok) {
+		g_set_error (error,
+			     MRP_ERROR,
+			     MRP_ERROR_LOAD_FILE_INVALID,
+			     _("The journal '%s' does not belong to this version of the project."),
+			     journal->filename);
+		return FALSE;
+	}
+
+	line = end + 1;
+
+	while ((end = memchr (line, '\n', contents + *length - line))) {
+		*end = '\0';
+		n_line++;
+
+		fields = g_strsplit (line, "\t", -1);
+		ok = journal_replay_record (journal, fields, g_strv_length (fields));
+		g_strfreev (fields);
+
+		if (!ok) {
+			g_set_error (error,
+				     MRP_ERROR,
+				     MRP_ERROR_LOAD_FILE_INVALID,
+				     _("Invalid record on line %d of the journal '%s'."),
+				     n_line, journal->filename);
+			return FALSE;
+		}
+
+		*end = '\n';
+		line = end + 1;
+	}
+
+	*length = line - contents;
+
+	return TRUE;
+}
+
+static MrpJournal *
+journal_new (MrpProject *project, const gchar *filename)
+{
+	MrpJournal *journal;
+
+	journal = g_new0 (MrpJournal, 1);
+
+	journal->project = project;
+	journal->manager = imrp_project_get_task_manager (project);
+	journal->filename = g_strdup (filename);
+	journal->ids = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
+	journal->objects = g_ptr_array_new ();
+	journal->watched = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
+	journal->record = g_string_sized_new (128);
+
+	journal_index_project (journal);
+
+	return journal;
+}
+
+/* Replays @contents on a copy of the project, records can only be undone by
+ * throwing the copy away. The copy is made by saving the project to XML and
+ * loading it again.
+ */
+static gboolean
+journal_replay_scratch (MrpJournal  *journal,
+			gchar       *contents,
+			gsize        length,
+			GError     **error)
+{
+	MrpProject *scratch;
+	MrpJournal *scratch_journal;
+	gchar      *xml;
+	gboolean    ok;
+
+	if (!mrp_project_save_to_xml (journal->project, &xml, error)) {
+		return FALSE;
+	}
+
+	scratch = mrp_project_new (imrp_project_get_application (journal->project));
+	ok = mrp_project_load_from_xml (scratch, xml, error);
+	g_free (xml);
+
+	if (ok) {
+		scratch_journal = journal_new (scratch, journal->filename);
+		scratch_journal->file_size = journal->file_size;
+		scratch_journal->file_mtime = journal->file_mtime;
+
+		ok = journal_replay (scratch_journal, contents, &length, error);
+
+		imrp_journal_free (scratch_journal, FALSE);
+	}
+
+	g_object_unref (scratch);
+
+	return ok;
+}
+
+MrpJournal *
+imrp_journal_new (MrpProject   *project,
+		  const gchar  *filename,
+		  GError      **error)
+{
+	MrpJournal *journal;
+	gchar      *contents = NULL;
+	gchar      *end;
+	gsize       length, replayed;
+
+	journal = journal_new (project, filename);
+	journal_stat_file (journal);
+
+	if (g_file_get_contents (filename, &contents, &length, NULL) &&
+	    memchr (contents, '\n', length)) {
+		replayed = length;
+		end = (gchar *) memchr (contents, '\n', length) + 1;
+
+		/* A journal with records is tried on a copy first, so that a
+		 * record that fails leaves the project as it was.
+		 */
+		if (memchr (end, '\n', contents + length - end) &&
+		    !journal_replay_scratch (journal, contents, length, error)) {
+			g_free (contents);
+			imrp_journal_free (journal, FALSE);
+			return NULL;
+		}
+
+		if (!journal_replay (journal, contents, &replayed, error)) {
+			g_free (contents);
+			imrp_journal_free (journal, FALSE);
+			return NULL;
+		}
+
+		/* Drop a record that was cut short, new ones go after it. */
+		if (replayed < length &&
+		    !g_file_set_contents (filename, contents, replayed, error)) {
+			g_free (contents);
+			imrp_journal_free (journal, FALSE);
+			return NULL;
+		}
+
+		journal->file = g_fopen (filename, "ab");
+	} else {
+		journal->file = g_fopen (filename, "wb");
+		if (journal->file) {
+			journal_write_header (journal);
+		}
+
+		journal->write_project = mrp_project_get_uri (project) == NULL;
+	}
+
+	g_free (contents);
+
+	if (!journal->file) {
+		g_set_error (error,
+			     MRP_ERROR,
+			     MRP_ERROR_SAVE_WRITE_FAILED,
+			     _("Couldn't open the journal '%s': %s"),
+			     filename, g_strerror (errno));
+		imrp_journal_free (journal, FALSE);
+		return NULL;
+	}
+
+	journal_watch_project (journal);
+
+	return journal;
+}
+
+void
+imrp_journal_free (MrpJournal *journal, gboolean discard)
+{
+	if (journal->sync_id) {
+		g_source_remove (journal->sync_id);
+	}
+
+	journal_unwatch (journal);
+
+	if (journal->file) {
+		imrp_journal_sync (journal);
+		fclose (journal->file);
+	}
+
+	if (discard) {
+		g_remove (journal->filename);
+	}
+
+	g_hash_table_destroy (journal->ids);
+	g_hash_table_destroy (journal->watched);
+	g_ptr_array_free (journal->objects, TRUE);
+	g_string_free (journal->record, TRUE);
+	g_free (journal->filename);
+	g_free (journal);
+}
+
+void
+imrp_journal_sync (MrpJournal *journal)
+{
+	if (!journal->dirty || !journal->file) {
+		return;
+	}
+
+	if (fsync (fileno (journal->file)) != 0) {
+		g_warning ("Couldn't sync the journal '%s': %s",
+			   journal->filename, g_strerror (errno));
+	}
+
+	journal->dirty = FALSE;
+}
+
+/* Called when the project has been saved, the journal then starts over from
+ * the saved project.
+ */
+void
+imrp_journal_compact (MrpJournal *journal)
+{
+	journal_unwatch (journal);
+	journal_index_project (journal);
+	journal_stat_file (journal);
+
+	if (journal->file) {
+		fclose (journal->file);
+	}
+
+	journal->file = g_fopen (journal->filename, "wb");
+	if (!journal->file) {
+		g_warning ("Couldn't open the journal '%s': %s",
+			   journal->filename, g_strerror (errno));
+	} else {
+		journal_write_header (journal);
+		imrp_journal_sync (journal);
+	}
+
+	journal_watch_project (journal);
+}
@@ -60,7 +60,12 @@
 typedef struct {
 	MrpProject *project;
 	guint       id;
-	GHashTable *property_hash;
+
+	/* Slot of this object in the custom property columns, handed out by
+	 * the project on the first custom value. A stamp of 0 means none.
+	 */
+	guint       index;
+	guint       stamp;
 } MrpObjectPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (MrpObject, mrp_object, G_TYPE_OBJECT)
@@ -89,36 +94,43 @@ mrp_object_init (MrpObject *object)
 
 	priv->id = mrp_application_get_unique_id ();
 	mrp_application_id_set_data (object, priv->id);
-
-        priv->property_hash = g_hash_table_new (NULL, NULL);
 }
 
+/* Drops the custom values of @object and gives its slot back to @project. */
 static void
-mrp_object_finalize (GObject *g_object)
+object_release_slot (MrpObject *object, MrpProject *project)
 {
-	G_OBJECT_CLASS (mrp_object_parent_class)->finalize (g_object);
+	MrpObjectPrivate *priv = mrp_object_get_instance_private (object);
+	GList            *properties, *l;
+
+	if (priv->stamp == 0) {
+		return;
+	}
+
+	properties = mrp_project_get_properties_from_type (project,
+							   G_OBJECT_TYPE (object));
+	for (l = properties; l; l = l->next) {
+		imrp_property_unset_value (l->data, priv->index, priv->stamp);
+	}
+	g_list_free (properties);
+
+	imrp_project_release_object_slot (project, G_OBJECT_TYPE (object),
+					  priv->index);
+	priv->stamp = 0;
 }
 
 static void
-object_property_removed_cb (MrpProject  *project,
-			    MrpProperty *property,
-			    MrpObject   *object)
+mrp_object_finalize (GObject *g_object)
 {
+	MrpObject        *object = MRP_OBJECT (g_object);
 	MrpObjectPrivate *priv = mrp_object_get_instance_private (object);
-	GValue        *value;
 
-	g_return_if_fail (MRP_IS_PROJECT (project));
-	g_return_if_fail (property != NULL);
-	g_return_if_fail (MRP_IS_OBJECT (object));
-
-	value = g_hash_table_lookup (priv->property_hash, property);
-
-	if (value) {
-		g_hash_table_steal (priv->property_hash, property);
-		g_value_unset (value);
-		g_free (value);
-		mrp_property_unref (property);
+	if (priv->project && priv->project != (MrpProject *) object) {
+		object_release_slot (object, priv->project);
+		imrp_project_object_finalized (priv->project, object);
 	}
+
+	G_OBJECT_CLASS (mrp_object_parent_class)->finalize (g_object);
 }
 
 
@@ -136,20 +148,15 @@ mrp_object_set_g_property (GObject        *g_object,
 	switch (prop_id) {
 	case PROP_PROJECT:
 		if (priv->project) {
-			g_signal_handlers_disconnect_by_func (priv->project,
-							      G_CALLBACK (object_property_removed_cb),
-							      object);
+			if (priv->project != g_value_get_object (value)) {
+				object_release_slot (object, priv->project);
+			}
 			g_object_unref (priv->project);
 		}
 
 		priv->project = g_value_get_object (value);
 		if (priv->project) {
 			g_object_ref (priv->project);
-			g_signal_connect_object (priv->project,
-						 "property_removed",
-						 G_CALLBACK (object_property_removed_cb),
-						 object,
-						 G_CONNECT_AFTER);
 		}
 		break;
 	default:
@@ -255,33 +262,19 @@ void
 mrp_object_set_property (MrpObject *object, MrpProperty *property, GValue *value)
 {
 	MrpObjectPrivate *priv = mrp_object_get_instance_private (object);
-	GValue        *value_cpy;
-	GParamSpec    *pspec;
-	GValue        *tmp_value;
-
-	pspec = G_PARAM_SPEC (property);
-
-	value_cpy = g_new0 (GValue, 1);
 
-	g_value_init (value_cpy, G_PARAM_SPEC_VALUE_TYPE (pspec));
+	g_return_if_fail (priv->project != NULL);
 
-	g_value_copy (value, value_cpy);
-
-	tmp_value = g_hash_table_lookup (priv->property_hash,
-					 property);
-
-	if (tmp_value) {
-		g_hash_table_steal (priv->property_hash, property);
-		g_value_unset (tmp_value);
-	} else {
-		mrp_property_ref (property);
+	if (priv->stamp == 0) {
+		priv->index = imrp_project_get_object_slot (priv->project,
+							    G_OBJECT_TYPE (object),
+							    &priv->stamp);
 	}
 
-	g_hash_table_insert (priv->property_hash,
-			     property, value_cpy);
+	imrp_property_set_value (property, priv->index, priv->stamp, value);
 
 	g_signal_emit (object, signals[PROP_CHANGED],
-		       g_quark_from_string (G_PARAM_SPEC (property)->name),
+		       imrp_property_get_quark (property),
 		       property, value);
 
 	mrp_object_changed (object);
@@ -300,18 +293,12 @@ void
 mrp_object_get_property (MrpObject *object, MrpProperty *property, GValue *value)
 {
 	MrpObjectPrivate *priv = mrp_object_get_instance_private (object);
-	GValue        *tmp_value;
 
-	tmp_value = g_hash_table_lookup (priv->property_hash,
-					 property);
-
-	if (!tmp_value) {
+	if (priv->stamp == 0 ||
+	    !imrp_property_get_value (property, priv->index, priv->stamp, value)) {
 		g_param_value_set_default (G_PARAM_SPEC (property),
 					   value);
-		return;
 	}
-
-	g_value_copy (tmp_value, value);
 }
 
 /**
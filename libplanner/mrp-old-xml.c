@@ -47,6 +47,7 @@ typedef struct {
 	GList          *resources;
 	GList          *groups;
 	GList          *assignments;
+	GList          *baselines;
 
 	mrptime         project_start;
 
@@ -536,6 +537,59 @@ old_xml_read_assignment (MrpParser *parser, xmlNodePtr tree)
 	; /* Avoid gcc warning. */
 }
 
+static void
+old_xml_read_baseline (MrpParser *parser, xmlNodePtr tree)
+{
+	MrpBaseline *baseline;
+	MrpTask     *task;
+	xmlNodePtr   child;
+	gchar       *name, *type;
+	gint         task_id;
+
+	if (strcmp_ (tree->name, "baseline")){
+		return;
+	}
+
+	name = old_xml_get_string (tree, "name");
+	type = old_xml_get_string (tree, "type");
+
+	if (!name) {
+		g_warning ("Corrupt file? Baseline without a name.");
+		g_free (type);
+		return;
+	}
+
+	baseline = imrp_baseline_new (name,
+				      old_xml_get_date (tree, "created"),
+				      g_strcmp0 (type, "scenario") == 0);
+
+	for (child = tree->children; child; child = child->next) {
+		if (strcmp_ (child->name, "baseline-task")) {
+			continue;
+		}
+
+		task_id = old_xml_get_int (child, "id");
+		task = g_hash_table_lookup (parser->task_hash,
+					    GINT_TO_POINTER (task_id));
+
+		if (!task) {
+			g_warning ("Corrupt file? Task %d not found in hash.", task_id);
+			continue;
+		}
+
+		imrp_baseline_add_task (baseline, task,
+					old_xml_get_date (child, "start"),
+					old_xml_get_date (child, "end"),
+					old_xml_get_int (child, "duration"),
+					old_xml_get_int (child, "work"));
+	}
+
+	parser->baselines = g_list_prepend (parser->baselines, baseline);
+
+	g_free (name);
+	g_free (type);
+}
+
 static void
 old_xml_read_day_type (MrpParser *parser, xmlNodePtr tree)
 {
@@ -681,6 +735,62 @@ old_xml_read_overridden_day (MrpParser   *parser,
 	xmlFree (xml_str);
 }
 
+static void
+old_xml_read_rule (MrpParser   *parser,
+		   MrpCalendar *calendar,
+		   xmlNodePtr   tree)
+{
+	MrpCalendarRule  rule = { 0 };
+	gchar           *type;
+	gchar           *end;
+
+	if (strcmp_ (tree->name, "rule") != 0){
+		return;
+	}
+
+	rule.day = g_hash_table_lookup (parser->day_hash,
+					GINT_TO_POINTER (old_xml_get_int (tree, "id")));
+	if (!rule.day) {
+		g_warning ("Corrupt file? Calendar rule without a day type.");
+		return;
+	}
+
+	type = old_xml_get_string (tree, "type");
+
+	if (g_strcmp0 (type, "weekly") == 0) {
+		rule.type = MRP_CALENDAR_RULE_WEEKLY;
+	}
+	else if (g_strcmp0 (type, "monthly") == 0) {
+		rule.type = MRP_CALENDAR_RULE_MONTHLY;
+	}
+	else if (g_strcmp0 (type, "yearly") == 0) {
+		rule.type = MRP_CALENDAR_RULE_YEARLY;
+	}
+	else if (g_strcmp0 (type, "cycle") == 0) {
+		rule.type = MRP_CALENDAR_RULE_CYCLE;
+	} else {
+		g_warning ("Unknown calendar rule type '%s'.", type);
+		g_free (type);
+		return;
+	}
+	g_free (type);
+
+	rule.start = old_xml_get_date (tree, "start");
+
+	end = old_xml_get_string (tree, "end");
+	rule.end = end ? mrp_time_from_string (end) : MRP_TIME_INVALID;
+	g_free (end);
+
+	rule.interval = old_xml_get_int_with_default (tree, "interval", 1);
+	rule.count = old_xml_get_int_with_default (tree, "count", 0);
+	rule.week_day = old_xml_get_int_with_default (tree, "week-day", 0);
+	rule.nth = old_xml_get_int_with_default (tree, "nth", 1);
+	rule.month = old_xml_get_int_with_default (tree, "month", 1);
+	rule.month_day = old_xml_get_int_with_default (tree, "month-day", 1);
+
+	mrp_calendar_add_rule (calendar, &rule);
+}
+
 static void
 old_xml_read_calendar (MrpParser *parser, MrpCalendar *parent, xmlNodePtr tree)
 {
@@ -749,6 +859,13 @@ old_xml_read_calendar (MrpParser *parser, MrpCalendar *parent, xmlNodePtr tree)
 							     day);
 			}
 		}
+		else if (strcmp_ (child->name, "rules") == 0) {
+			xmlNodePtr rule;
+
+			for (rule = child->children; rule; rule = rule->next) {
+				old_xml_read_rule (parser, calendar, rule);
+			}
+		}
 	}
 }
 
@@ -1103,6 +1220,17 @@ old_xml_read_project (MrpParser *parser)
 		}
 	}
 
+	/* Load baselines. */
+	child = old_xml_search_child (parser->doc->children, "baselines");
+	if (child != NULL) {
+		xmlNodePtr baseline;
+
+		for (baseline = child->children; baseline; baseline = baseline->next) {
+			old_xml_read_baseline (parser, baseline);
+		}
+	}
+	parser->baselines = g_list_reverse (parser->baselines);
+
 	return TRUE;
 }
 
@@ -1550,6 +1678,11 @@ mrp_old_xml_parse (MrpProject *project, xmlDoc *doc, GError **error)
         g_list_free (parser.assignments);
         g_list_free (parser.resources);
 
+	for (node = parser.baselines; node; node = node->next) {
+		imrp_project_add_baseline (project, node->data);
+	}
+	g_list_free (parser.baselines);
+
 	return TRUE;
 }
 
@@ -33,6 +33,7 @@
 #include <libxml/tree.h>
 #include <libxml/parser.h>
 #include <libxml/xmlmemory.h>
+#include <libxml/xmlIO.h>
 #include "mrp-private.h"
 #include "mrp-error.h"
 #include <glib/gi18n.h>
@@ -862,6 +863,50 @@ mpp_write_overridden_date (MrpParser      *parser,
  	g_free (dd);
 }
 
+static void
+mpp_write_rule (MrpParser       *parser,
+		xmlNodePtr       parent,
+		MrpCalendarRule *rule)
+{
+	NodeEntry  *entry;
+	xmlNodePtr  child;
+
+	entry = g_hash_table_lookup (parser->day_hash, rule->day);
+	if (!entry) {
+		return;
+	}
+
+	child = xmlNewChild_ (parent, NULL, "rule", NULL);
+	mpp_xml_set_int (child, "id", entry->id);
+	mpp_xml_set_date (child, "start", rule->start);
+	if (rule->end != MRP_TIME_INVALID) {
+		mpp_xml_set_date (child, "end", rule->end);
+	}
+
+	switch (rule->type) {
+	case MRP_CALENDAR_RULE_WEEKLY:
+		xmlSetProp_ (child, "type", "weekly");
+		mpp_xml_set_int (child, "week-day", rule->week_day);
+		mpp_xml_set_int (child, "interval", rule->interval);
+		break;
+	case MRP_CALENDAR_RULE_MONTHLY:
+		xmlSetProp_ (child, "type", "monthly");
+		mpp_xml_set_int (child, "week-day", rule->week_day);
+		mpp_xml_set_int (child, "nth", rule->nth);
+		break;
+	case MRP_CALENDAR_RULE_YEARLY:
+		xmlSetProp_ (child, "type", "yearly");
+		mpp_xml_set_int (child, "month", rule->month);
+		mpp_xml_set_int (child, "month-day", rule->month_day);
+		break;
+	case MRP_CALENDAR_RULE_CYCLE:
+		xmlSetProp_ (child, "type", "cycle");
+		mpp_xml_set_int (child, "interval", rule->interval);
+		mpp_xml_set_int (child, "count", rule->count);
+		break;
+	}
+}
+
 static void
 mpp_write_calendar (MrpParser   *parser,
 		    xmlNodePtr   parent,
@@ -923,6 +968,14 @@ mpp_write_calendar (MrpParser   *parser,
 	}
 	g_list_free (dates);
 
+	/* Write the recurring dates */
+	if (mrp_calendar_get_rules (calendar)) {
+		child = xmlNewChild_ (node, NULL, "rules", NULL);
+		for (l = mrp_calendar_get_rules (calendar); l; l = l->next) {
+			mpp_write_rule (parser, child, l->data);
+		}
+	}
+
 	/* Add special dates */
 	for (l = mrp_calendar_get_children (calendar); l; l = l->next) {
 		MrpCalendar *child_calendar = l->data;
@@ -931,6 +984,45 @@ mpp_write_calendar (MrpParser   *parser,
 	}
 }
 
+static void
+mpp_write_baseline (MrpParser   *parser,
+		    xmlNodePtr   parent,
+		    MrpBaseline *baseline,
+		    GList       *tasks)
+{
+	xmlNodePtr  node, child;
+	GList      *l;
+	NodeEntry  *entry;
+	mrptime     start, finish;
+	gint        duration, work;
+
+	node = xmlNewChild_ (parent, NULL, "baseline", NULL);
+
+	xmlSetProp_ (node, "name", mrp_baseline_get_name (baseline));
+	mpp_xml_set_date (node, "created", mrp_baseline_get_created (baseline));
+	xmlSetProp_ (node, "type",
+		     mrp_baseline_is_scenario (baseline) ? "scenario" : "baseline");
+
+	/* Tasks removed since the baseline was taken have no id to refer to
+	 * and are left out.
+	 */
+	for (l = tasks; l; l = l->next) {
+		if (!mrp_baseline_get_task (baseline, l->data,
+					    &start, &finish, &duration, &work)) {
+			continue;
+		}
+
+		entry = g_hash_table_lookup (parser->task_hash, l->data);
+
+		child = xmlNewChild_ (node, NULL, "baseline-task", NULL);
+		mpp_xml_set_int (child, "id", entry->id);
+		mpp_xml_set_date (child, "start", start);
+		mpp_xml_set_date (child, "end", finish);
+		mpp_xml_set_int (child, "duration", duration);
+		mpp_xml_set_int (child, "work", work);
+	}
+}
+
 static gboolean
 mpp_write_project (MrpParser *parser)
 {
@@ -1040,6 +1132,21 @@ mpp_write_project (MrpParser *parser)
 	}
 	g_list_free (assignments);
 
+	/* Write baselines. */
+	list = mrp_project_get_baselines (parser->project);
+	if (list) {
+		GList *tasks;
+
+		child = xmlNewChild_ (node, NULL, "baselines", NULL);
+		tasks = mrp_project_get_all_tasks (parser->project);
+
+		for (l = list; l; l = l->next) {
+			mpp_write_baseline (parser, child, l->data, tasks);
+		}
+
+		g_list_free (tasks);
+	}
+
 	return TRUE;
 }
 
@@ -1049,7 +1156,7 @@ parser_build_xml_doc (MrpStorageMrproject  *module,
 {
 	MrpParser parser;
 
-	g_return_val_if_fail (MRP_IS_STORAGE_MRPROJECT (module), FALSE);
+	g_return_val_if_fail (MRP_IS_STORAGE_MRPROJECT (module), NULL);
 
 	/* We want indentation. */
 	xmlKeepBlanksDefault (0);
@@ -1087,6 +1194,83 @@ parser_build_xml_doc (MrpStorageMrproject  *module,
 	return parser.doc;
 }
 
+typedef struct {
+	GOutputStream *stream;
+	GError        *error;
+} ParserOutput;
+
+static int
+parser_output_write_cb (void *context, const char *buffer, int len)
+{
+	ParserOutput *output = context;
+
+	if (output->error ||
+	    !g_output_stream_write_all (output->stream, buffer, len,
+					NULL, NULL, &output->error)) {
+		return -1;
+	}
+
+	return len;
+}
+
+static int
+parser_output_close_cb (void *context)
+{
+	return 0;
+}
+
+/* Writes the document out through the compressor, as libxml serializes it. */
+static gboolean
+parser_write_doc (xmlDocPtr            doc,
+		  const gchar         *filename,
+		  MrpFileCompression   compression,
+		  GError             **error)
+{
+	ParserOutput      output;
+	xmlOutputBuffer  *buf;
+	GCancellable     *cancellable;
+	gint              ret;
+
+	output.stream = imrp_compression_create_file (filename, compression, error);
+	output.error = NULL;
+
+	if (!output.stream) {
+		return FALSE;
+	}
+
+	buf = xmlOutputBufferCreateIO (parser_output_write_cb,
+				       parser_output_close_cb,
+				       &output, NULL);
+
+	ret = xmlSaveFormatFileTo (buf, doc, NULL, 1);
+
+	if (ret == -1 || output.error) {
+		/* Leave the old file alone. */
+		cancellable = g_cancellable_new ();
+		g_cancellable_cancel (cancellable);
+		g_output_stream_close (output.stream, cancellable, NULL);
+		g_object_unref (cancellable);
+	}
+	else if (!g_output_stream_close (output.stream, NULL, &output.error)) {
+		ret = -1;
+	}
+
+	g_object_unref (output.stream);
+
+	if (ret == -1 || output.error) {
+		g_set_error (error,
+			     MRP_ERROR,
+			     MRP_ERROR_SAVE_WRITE_FAILED,
+			     _("Could not write XML file: %s"),
+			     output.error ? output.error->message : filename);
+		g_clear_error (&output.error);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
 gboolean
 mrp_parser_save (MrpStorageMrproject  *module,
 		 const gchar          *uri,
@@ -1094,18 +1278,14 @@ mrp_parser_save (MrpStorageMrproject  *module,
 		 GError              **error)
 {
 	gchar     *real_filename;
-	gint       ret;
+	gboolean   ret;
 	gboolean   file_exist;
 	xmlDocPtr  doc;
 
 	g_return_val_if_fail (MRP_IS_STORAGE_MRPROJECT (module), FALSE);
 	g_return_val_if_fail (uri != NULL && uri[0] != 0, FALSE);
 
-	if (!strstr (uri, ".mrproject") && !strstr (uri, ".planner")) {
-		real_filename = g_strconcat (uri, ".planner", NULL);
-	} else {
-		real_filename = g_strdup (uri);
-	}
+	real_filename = imrp_compression_get_save_name (uri);
 
 	file_exist = g_file_test (
 		real_filename, G_FILE_TEST_EXISTS | G_FILE_TEST_IS_DIR);
@@ -1126,20 +1306,13 @@ mrp_parser_save (MrpStorageMrproject  *module,
 		return FALSE;
 	}
 
-	ret = xmlSaveFormatFile (real_filename, doc, 1);
+	ret = parser_write_doc (doc, real_filename,
+				mrp_project_get_file_compression (module->project),
+				error);
 	g_free (real_filename);
 	xmlFreeDoc (doc);
 
-	if (ret == -1) {
-		g_set_error (error,
-			     MRP_ERROR,
-			     MRP_ERROR_SAVE_WRITE_FAILED,
-			     _("Could not write XML file"));
-
-		return FALSE;
-	}
-
-	return TRUE;
+	return ret;
 }
 
 gboolean
@@ -1176,6 +1349,15 @@ mrp_parser_to_xml (MrpStorageMrproject  *module,
 	return TRUE;
 }
 
+xmlDocPtr
+mrp_parser_to_xml_doc (MrpStorageMrproject  *module,
+		       GError              **error)
+{
+	g_return_val_if_fail (MRP_IS_STORAGE_MRPROJECT (module), NULL);
+
+	return parser_build_xml_doc (module, error);
+}
+
 gboolean
 mrp_parser_from_xml (MrpStorageMrproject  *module,
 		     const gchar          *str,
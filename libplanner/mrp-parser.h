@@ -23,6 +23,7 @@
 #pragma once
 
 #include <glib.h>
+#include <libxml/tree.h>
 #include <libplanner/mrp-error.h>
 #include "mrp-storage-mrproject.h"
 
@@ -47,3 +48,5 @@ gboolean mrp_parser_to_xml   (MrpStorageMrproject  *module,
 gboolean mrp_parser_from_xml (MrpStorageMrproject  *module,
 			      const gchar          *str,
 			      GError              **error);
+xmlDocPtr mrp_parser_to_xml_doc (MrpStorageMrproject  *module,
+				 GError              **error);
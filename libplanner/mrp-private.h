@@ -23,6 +23,7 @@
 
 #pragma once
 
+#include <gio/gio.h>
 #include <libplanner/mrp-calendar.h>
 #include <libplanner/mrp-task-manager.h>
 #include <libplanner/mrp-project.h>
@@ -42,10 +43,16 @@ void            imrp_project_set_resources         (MrpProject        *project,
 void            imrp_project_set_groups            (MrpProject        *project,
 						    GList             *groups);
 MrpTaskManager *imrp_project_get_task_manager      (MrpProject        *project);
+MrpApplication *imrp_project_get_application       (MrpProject        *project);
 void            imrp_task_add_assignment           (MrpTask           *task,
 						    MrpAssignment     *assignment);
 void            imrp_resource_add_assignment       (MrpResource       *resource,
 						    MrpAssignment     *assignment);
+void            imrp_resource_invalidate_load      (MrpResource       *resource);
+void            imrp_resource_check_overallocations (MrpResource      *resource);
+void            imrp_project_queue_overallocation_check (MrpProject   *project,
+							 MrpResource  *resource);
+void            imrp_project_check_overallocations (MrpProject        *project);
 
 guint           imrp_task_get_unique_id            (MrpProject        *project);
 
@@ -58,6 +65,8 @@ gboolean          mrp_task_manager_check_move        (MrpTaskManager  *manager,
 						      MrpTask         *task,
 						      MrpTask         *parent,
 						      GError         **error);
+GList *           imrp_task_manager_peek_dependency_list (MrpTaskManager *manager);
+gboolean          imrp_task_manager_get_in_recalc    (MrpTaskManager  *manager);
 void              imrp_task_insert_child             (MrpTask         *parent,
 						      gint             position,
 						      MrpTask         *child);
@@ -97,6 +106,7 @@ GList *           imrp_task_peek_predecessors        (MrpTask         *task);
 GList *           imrp_task_peek_successors          (MrpTask         *task);
 MrpTaskType       imrp_task_get_type                 (MrpTask         *task);
 MrpTaskSched      imrp_task_get_sched                (MrpTask         *task);
+void              imrp_task_recalc_rollup            (MrpTask         *task);
 
 
 /* MrpStorageModule functions. */
@@ -107,6 +117,84 @@ gboolean imrp_project_add_calendar_day    (MrpProject       *project,
 GList *  imrp_project_get_calendar_days   (MrpProject       *project);
 void     imrp_project_remove_calendar_day (MrpProject       *project,
 					   MrpDay           *day);
+gpointer imrp_project_save_to_xml_doc     (MrpProject       *project,
+					   GError          **error);
+
+
+/* Baseline functions. */
+MrpBaseline *imrp_baseline_new           (const gchar *name,
+					  mrptime      created,
+					  gboolean     scenario);
+MrpBaseline *imrp_baseline_copy          (MrpBaseline *source,
+					  const gchar *name,
+					  mrptime      created,
+					  gboolean     scenario);
+void         imrp_baseline_free          (MrpBaseline *baseline);
+void         imrp_baseline_update        (MrpBaseline *baseline,
+					  GList       *tasks);
+void         imrp_baseline_add_task      (MrpBaseline *baseline,
+					  MrpTask     *task,
+					  mrptime      start,
+					  mrptime      finish,
+					  gint         duration,
+					  gint         work);
+GList *      imrp_baseline_get_variances (MrpBaseline *baseline,
+					  MrpBaseline *current);
+void         imrp_project_add_baseline   (MrpProject  *project,
+					  MrpBaseline *baseline);
+
+
+/* Timephase functions. */
+MrpTimephase *imrp_timephase_new                (MrpProject   *project);
+void          imrp_timephase_free               (MrpTimephase *timephase);
+void          imrp_timephase_invalidate_task    (MrpTimephase *timephase,
+						 MrpTask      *task);
+void          imrp_timephase_invalidate_all     (MrpTimephase *timephase);
+GArray *      imrp_timephase_get_resource       (MrpTimephase *timephase,
+						 MrpResource  *resource,
+						 MrpTimeUnit   unit,
+						 mrptime       start,
+						 mrptime       finish);
+GArray *      imrp_timephase_get_task           (MrpTimephase *timephase,
+						 MrpTask      *task,
+						 MrpTimeUnit   unit,
+						 mrptime       start,
+						 mrptime       finish);
+void          imrp_project_invalidate_timephase (MrpProject   *project,
+						 MrpTask      *task);
+
+
+/* Journal functions. */
+typedef struct _MrpJournal MrpJournal;
+
+MrpJournal *imrp_journal_new     (MrpProject   *project,
+				  const gchar  *filename,
+				  GError      **error);
+void        imrp_journal_free    (MrpJournal   *journal,
+				  gboolean      discard);
+void        imrp_journal_sync    (MrpJournal   *journal);
+void        imrp_journal_compact (MrpJournal   *journal);
+
+
+/* Shared strings. */
+const gchar *imrp_string_ref     (const gchar  *str);
+void         imrp_string_unref   (const gchar  *str);
+gboolean     imrp_string_replace (const gchar **field,
+				  const gchar  *str);
+
+
+/* Compression functions. */
+MrpFileCompression imrp_compression_detect      (const gchar         *data,
+						 gsize                length);
+gboolean           imrp_compression_read_file   (const gchar         *filename,
+						 gchar              **contents,
+						 gsize               *length,
+						 MrpFileCompression  *compression,
+						 GError             **error);
+GOutputStream *    imrp_compression_create_file (const gchar         *filename,
+						 MrpFileCompression   compression,
+						 GError             **error);
+gchar *            imrp_compression_get_save_name (const gchar       *uri);
 
 
 /* Calendar functions. */
@@ -125,6 +213,9 @@ void imrp_project_task_inserted    (MrpProject *project,
 				    MrpTask    *task);
 void imrp_project_task_moved       (MrpProject *project,
 				    MrpTask    *task);
+void imrp_project_tasks_replaced   (MrpProject *project);
+void imrp_project_object_finalized (MrpProject *project,
+				    MrpObject  *object);
 
 
 /* Property related stuff */
@@ -132,6 +223,25 @@ void imrp_project_property_changed (MrpProject  *project,
 				    MrpProperty *property);
 void imrp_property_set_project     (MrpProperty *property,
 				    MrpProject  *project);
+GQuark   imrp_property_get_quark    (MrpProperty  *property);
+void     imrp_property_set_value    (MrpProperty  *property,
+				     guint         index,
+				     guint         stamp,
+				     const GValue *value);
+gboolean imrp_property_get_value    (MrpProperty  *property,
+				     guint         index,
+				     guint         stamp,
+				     GValue       *value);
+void     imrp_property_unset_value  (MrpProperty  *property,
+				     guint         index,
+				     guint         stamp);
+void     imrp_property_clear_values (MrpProperty  *property);
+guint    imrp_project_get_object_slot     (MrpProject *project,
+					   GType       type,
+					   guint      *stamp);
+void     imrp_project_release_object_slot (MrpProject *project,
+					   GType       type,
+					   guint       slot);
 
 
 /* MrpApplication functions. */
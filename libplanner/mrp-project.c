@@ -62,6 +62,18 @@
 #include "mrp-resource.h"
 #include "mrp-project.h"
 
+typedef struct {
+	GHashTable       *objects;   /* key -> GPtrArray of objects */
+	GHashTable       *keys;      /* object -> key */
+} ProjectIndex;
+
+/* Slots in the custom property columns for the objects of one type. */
+typedef struct {
+	GArray           *free_slots;
+	guint             n_slots;
+	guint             last_stamp;
+} ObjectSlots;
+
 struct _MrpProjectPriv {
 	MrpApplication   *app;
 	gchar            *uri;
@@ -69,12 +81,33 @@ struct _MrpProjectPriv {
 	MrpTaskManager   *task_manager;
 
 	GList            *resources;
+	GList            *resources_tail;
 	GList            *groups;
 
+	/* Object -> its link in resources/groups. */
+	GHashTable       *resource_links;
+	GHashTable       *group_links;
+
+	/* Lookup indices, built on first use. */
+	gboolean          indices_built;
+	ProjectIndex     *task_index;
+	ProjectIndex     *resource_index;
+	ProjectIndex     *group_index;
+	GHashTable       *property_indices;
+
+	/* GType -> ObjectSlots, for the custom property columns. */
+	GHashTable       *object_slots;
+
 	MrpStorageModule *primary_storage;
 
 	mrptime           project_start;
 
+	/* The date that actual cost and planned value are measured at. */
+	mrptime           status_date;
+
+	/* How the project file is compressed when saved. */
+	MrpFileCompression file_compression;
+
 	gchar            *organization;
 	gchar            *manager;
 	gchar            *name;
@@ -96,6 +129,21 @@ struct _MrpProjectPriv {
 	/* Project phases */
 	GList            *phases;
 	gchar            *phase;
+
+	/* Baselines and scenarios, and the table of the current schedule
+	 * that they share their unchanged rows with.
+	 */
+	GList            *baselines;
+	MrpBaseline      *schedule;
+
+	/* Time-phased work and cost, created on the first query. */
+	MrpTimephase     *timephase;
+
+	/* Resources whose overallocations need a check after scheduling. */
+	GHashTable       *overallocation_queue;
+
+	/* Changes made since the project was saved, if journaled. */
+	MrpJournal       *journal;
 };
 
 /* Properties */
@@ -109,6 +157,7 @@ enum {
 	PROP_CALENDAR,
 	PROP_PHASES,
 	PROP_PHASE,
+	PROP_STATUS_DATE,
 };
 
 /* Signals */
@@ -157,6 +206,7 @@ static gboolean project_load_from_sql             (MrpProject       *project,
 						   GError          **error);
 static gboolean project_set_storage               (MrpProject       *project,
 						   const gchar      *storage_name);
+static void     project_object_slots_free         (ObjectSlots      *slots);
 #if 0
 static void     project_dump_task_tree            (MrpProject       *project);
 #endif
@@ -550,6 +600,13 @@ project_class_init (MrpProjectClass *klass)
 							      "The phase the project is in",
 							      "",
 							      G_PARAM_READWRITE));
+
+	g_object_class_install_property (object_class,
+					 PROP_STATUS_DATE,
+					 mrp_param_spec_time ("status-date",
+							      "Status date",
+							      "The date progress is measured at",
+							      G_PARAM_READWRITE));
 }
 
 static void
@@ -565,8 +622,15 @@ project_init (MrpProject *project)
 	priv->needs_saving  = FALSE;
 	priv->empty         = TRUE;
 	priv->project_start = mrp_time_align_day (mrp_time_current_time ());
+	priv->status_date   = priv->project_start;
 	priv->resources     = NULL;
 	priv->groups        = NULL;
+	priv->resource_links = g_hash_table_new (NULL, NULL);
+	priv->group_links   = g_hash_table_new (NULL, NULL);
+	priv->object_slots  = g_hash_table_new_full (NULL, NULL, NULL,
+						     (GDestroyNotify) project_object_slots_free);
+	priv->overallocation_queue = g_hash_table_new_full (NULL, NULL,
+							    g_object_unref, NULL);
 	priv->organization  = g_strdup ("");
 	priv->manager       = g_strdup ("");
 	priv->name          = g_strdup ("");
@@ -622,9 +686,33 @@ project_finalize (GObject *object)
 {
 	MrpProject *project = MRP_PROJECT (object);
 
+	if (project->priv->journal) {
+		imrp_journal_free (project->priv->journal, FALSE);
+		project->priv->journal = NULL;
+	}
+
+	if (project->priv->timephase) {
+		imrp_timephase_free (project->priv->timephase);
+		project->priv->timephase = NULL;
+	}
+
+	g_hash_table_destroy (project->priv->overallocation_queue);
+	project->priv->overallocation_queue = NULL;
+
+	project_reset_indices (project);
+	g_hash_table_destroy (project->priv->resource_links);
+	g_hash_table_destroy (project->priv->group_links);
+	g_hash_table_destroy (project->priv->object_slots);
+
 	g_object_unref (project->priv->primary_storage);
 	g_object_unref (project->priv->task_manager);
 
+	g_list_free_full (project->priv->baselines,
+			  (GDestroyNotify) imrp_baseline_free);
+	if (project->priv->schedule) {
+		imrp_baseline_free (project->priv->schedule);
+	}
+
 	g_free (project->priv->uri);
 	g_free (project->priv);
 
@@ -715,6 +803,10 @@ project_set_property (GObject      *object,
 		imrp_project_set_needs_saving (project, TRUE);
 		break;
 
+	case PROP_STATUS_DATE:
+		mrp_project_set_status_date (project, g_value_get_int64 (value));
+		break;
+
 	default:
 		break;
 	}
@@ -737,6 +829,10 @@ project_get_property (GObject    *object,
 		g_value_set_int64 (value, priv->project_start);
 		break;
 
+	case PROP_STATUS_DATE:
+		g_value_set_int64 (value, priv->status_date);
+		break;
+
 	case PROP_ORGANIZATION:
 		g_value_set_string (value, priv->organization);
 		break;
@@ -777,6 +873,348 @@ project_connect_object (MrpObject *object, MrpProject *project)
 	g_object_set (object, "project", project, NULL);
 }
 
+/* Lookup indices.
+ *
+ * Tasks, resources and groups are indexed by name, and on demand by the
+ * value of a string custom property. The indices are only built the first
+ * time a lookup is made, after that they are kept current as objects are
+ * added, removed and renamed.
+ */
+
+static ProjectIndex *
+project_index_new (void)
+{
+	ProjectIndex *index;
+
+	index = g_new0 (ProjectIndex, 1);
+	index->objects = g_hash_table_new_full (g_str_hash, g_str_equal,
+						g_free,
+						(GDestroyNotify) g_ptr_array_unref);
+	index->keys = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+
+	return index;
+}
+
+static void
+project_index_free (ProjectIndex *index)
+{
+	g_hash_table_destroy (index->objects);
+	g_hash_table_destroy (index->keys);
+	g_free (index);
+}
+
+static void
+project_index_remove (ProjectIndex *index, gpointer object)
+{
+	const gchar *key;
+	GPtrArray   *array;
+
+	key = g_hash_table_lookup (index->keys, object);
+	if (!key) {
+		return;
+	}
+
+	array = g_hash_table_lookup (index->objects, key);
+	if (array) {
+		g_ptr_array_remove (array, object);
+		if (array->len == 0) {
+			g_hash_table_remove (index->objects, key);
+		}
+	}
+
+	g_hash_table_remove (index->keys, object);
+}
+
+static void
+project_index_set (ProjectIndex *index, gpointer object, const gchar *key)
+{
+	GPtrArray *array;
+
+	project_index_remove (index, object);
+
+	if (!key) {
+		key = "";
+	}
+
+	array = g_hash_table_lookup (index->objects, key);
+	if (!array) {
+		array = g_ptr_array_new ();
+		g_hash_table_insert (index->objects, g_strdup (key), array);
+	}
+
+	g_ptr_array_add (array, object);
+	g_hash_table_insert (index->keys, object, g_strdup (key));
+}
+
+static GList *
+project_index_lookup (ProjectIndex *index, const gchar *key)
+{
+	GPtrArray *array;
+	GList     *list = NULL;
+	gint       i;
+
+	array = g_hash_table_lookup (index->objects, key);
+	if (!array) {
+		return NULL;
+	}
+
+	for (i = array->len - 1; i >= 0; i--) {
+		list = g_list_prepend (list, g_ptr_array_index (array, i));
+	}
+
+	return list;
+}
+
+static gpointer
+project_index_lookup_first (ProjectIndex *index, const gchar *key)
+{
+	GPtrArray *array;
+
+	array = g_hash_table_lookup (index->objects, key);
+	if (!array) {
+		return NULL;
+	}
+
+	return g_ptr_array_index (array, 0);
+}
+
+static ProjectIndex *
+project_get_name_index (MrpProject *project, GType object_type)
+{
+	MrpProjectPriv *priv = project->priv;
+
+	if (g_type_is_a (object_type, MRP_TYPE_TASK)) {
+		return priv->task_index;
+	}
+	else if (g_type_is_a (object_type, MRP_TYPE_RESOURCE)) {
+		return priv->resource_index;
+	}
+	else if (g_type_is_a (object_type, MRP_TYPE_GROUP)) {
+		return priv->group_index;
+	}
+
+	return NULL;
+}
+
+static void
+project_index_property_value (ProjectIndex *index,
+			      MrpObject    *object,
+			      MrpProperty  *property)
+{
+	GValue value = { 0 };
+
+	g_value_init (&value, G_TYPE_STRING);
+	mrp_object_get_property (object, property, &value);
+	project_index_set (index, object, g_value_get_string (&value));
+	g_value_unset (&value);
+}
+
+static void
+project_object_name_notify_cb (MrpObject  *object,
+			       GParamSpec *pspec,
+			       MrpProject *project)
+{
+	ProjectIndex *index;
+	gchar        *name;
+
+	index = project_get_name_index (project, G_OBJECT_TYPE (object));
+	if (!index) {
+		return;
+	}
+
+	g_object_get (object, "name", &name, NULL);
+	project_index_set (index, object, name);
+	g_free (name);
+}
+
+static void
+project_object_prop_changed_cb (MrpObject   *object,
+				MrpProperty *property,
+				GValue      *value,
+				MrpProject  *project)
+{
+	ProjectIndex *index;
+
+	index = g_hash_table_lookup (project->priv->property_indices, property);
+	if (index) {
+		project_index_set (index, object, g_value_get_string (value));
+	}
+}
+
+static void
+project_track_object (MrpObject *object, MrpProject *project)
+{
+	MrpProjectPriv *priv = project->priv;
+	ProjectIndex   *index;
+	GHashTableIter  iter;
+	gpointer        property, property_index;
+	gchar          *name;
+
+	if (!priv->indices_built) {
+		return;
+	}
+
+	index = project_get_name_index (project, G_OBJECT_TYPE (object));
+	if (!index || g_hash_table_contains (index->keys, object)) {
+		return;
+	}
+
+	g_object_get (object, "name", &name, NULL);
+	project_index_set (index, object, name);
+	g_free (name);
+
+	g_signal_connect (object, "notify::name",
+			  G_CALLBACK (project_object_name_notify_cb),
+			  project);
+	g_signal_connect (object, "prop_changed",
+			  G_CALLBACK (project_object_prop_changed_cb),
+			  project);
+
+	g_hash_table_iter_init (&iter, priv->property_indices);
+	while (g_hash_table_iter_next (&iter, &property, &property_index)) {
+		if (G_TYPE_CHECK_INSTANCE_TYPE (object,
+						G_PARAM_SPEC (property)->owner_type)) {
+			project_index_property_value (property_index,
+						      object,
+						      property);
+		}
+	}
+}
+
+static void
+project_untrack_object (MrpObject *object, MrpProject *project)
+{
+	MrpProjectPriv *priv = project->priv;
+	ProjectIndex   *index;
+	GHashTableIter  iter;
+	gpointer        property_index;
+
+	if (!priv->indices_built) {
+		return;
+	}
+
+	index = project_get_name_index (project, G_OBJECT_TYPE (object));
+	if (!index || !g_hash_table_contains (index->keys, object)) {
+		return;
+	}
+
+	project_index_remove (index, object);
+
+	g_signal_handlers_disconnect_by_func (object,
+					      project_object_name_notify_cb,
+					      project);
+	g_signal_handlers_disconnect_by_func (object,
+					      project_object_prop_changed_cb,
+					      project);
+
+	g_hash_table_iter_init (&iter, priv->property_indices);
+	while (g_hash_table_iter_next (&iter, NULL, &property_index)) {
+		project_index_remove (property_index, object);
+	}
+}
+
+static gboolean
+project_track_task_traverse_func (MrpTask *task, MrpProject *project)
+{
+	if (task != mrp_project_get_root_task (project)) {
+		project_track_object (MRP_OBJECT (task), project);
+	}
+
+	return FALSE;
+}
+
+static gboolean
+project_untrack_task_traverse_func (MrpTask *task, MrpProject *project)
+{
+	project_untrack_object (MRP_OBJECT (task), project);
+
+	return FALSE;
+}
+
+static void
+project_ensure_indices (MrpProject *project)
+{
+	MrpProjectPriv *priv = project->priv;
+	MrpTask        *root;
+
+	if (priv->indices_built) {
+		return;
+	}
+
+	priv->indices_built = TRUE;
+
+	priv->task_index = project_index_new ();
+	priv->resource_index = project_index_new ();
+	priv->group_index = project_index_new ();
+	priv->property_indices = g_hash_table_new_full (
+		NULL, NULL, NULL,
+		(GDestroyNotify) project_index_free);
+
+	root = mrp_project_get_root_task (project);
+	if (root) {
+		mrp_project_task_traverse (project,
+					   root,
+					   (MrpTaskTraverseFunc) project_track_task_traverse_func,
+					   project);
+	}
+
+	g_list_foreach (priv->resources, (GFunc) project_track_object, project);
+	g_list_foreach (priv->groups, (GFunc) project_track_object, project);
+}
+
+static void
+project_drop_index (ProjectIndex *index, MrpProject *project)
+{
+	GHashTableIter iter;
+	gpointer       object;
+
+	g_hash_table_iter_init (&iter, index->keys);
+	while (g_hash_table_iter_next (&iter, &object, NULL)) {
+		g_signal_handlers_disconnect_by_func (object,
+						      project_object_name_notify_cb,
+						      project);
+		g_signal_handlers_disconnect_by_func (object,
+						      project_object_prop_changed_cb,
+						      project);
+	}
+
+	project_index_free (index);
+}
+
+static void
+project_reset_indices (MrpProject *project)
+{
+	MrpProjectPriv *priv = project->priv;
+
+	if (!priv->indices_built) {
+		return;
+	}
+
+	priv->indices_built = FALSE;
+
+	g_hash_table_destroy (priv->property_indices);
+	priv->property_indices = NULL;
+
+	project_drop_index (priv->task_index, project);
+	project_drop_index (priv->resource_index, project);
+	project_drop_index (priv->group_index, project);
+
+	priv->task_index = NULL;
+	priv->resource_index = NULL;
+	priv->group_index = NULL;
+}
+
+static void
+project_link_objects (GList *list, GHashTable *links)
+{
+	GList *l;
+
+	g_hash_table_remove_all (links);
+	for (l = list; l; l = l->next) {
+		g_hash_table_insert (links, l->data, l);
+	}
+}
+
 /**
  * mrp_project_new:
  * @app: #MrpApplication that creates the new project.
@@ -816,7 +1254,9 @@ mrp_project_new (MrpApplication *app)
  * @uri: the URI where project should be read from
  * @error: location to store error, or %NULL
  *
- * Loads a project stored at @uri into @project.
+ * Loads a project stored at @uri into @project. A journal kept for @project
+ * is stopped and removed first, since its changes don't apply to the loaded
+ * project.
  *
  * Return value: Returns %TRUE on success, otherwise %FALSE.
  **/
@@ -830,12 +1270,15 @@ mrp_project_load (MrpProject *project, const gchar *uri, GError **error)
 	gchar          *scheme;
 	gboolean	is_file_scheme;
 	gchar          *filename;
+	MrpFileCompression compression;
 
 	g_return_val_if_fail (MRP_IS_PROJECT (project), FALSE);
 	g_return_val_if_fail (uri != NULL, FALSE);
 
 	priv = project->priv;
 
+	mrp_project_stop_journal (project, TRUE);
+
 	/* Hack. Check if we are dealing with an SQL uri. */
 	if (strncmp (uri, "sql://", 6) == 0) {
 		return project_load_from_sql (project, uri, error);
@@ -862,9 +1305,11 @@ mrp_project_load (MrpProject *project, const gchar *uri, GError **error)
 
 			return FALSE;
 		}
+	} else {
+		filename = g_strdup (uri);
 	}
 
-	if (!g_file_get_contents (filename, &file_str, NULL, error)) {
+	if (!imrp_compression_read_file (filename, &file_str, NULL, &compression, error)) {
 		g_free (filename);
 		return FALSE;
 	}
@@ -881,6 +1326,7 @@ mrp_project_load (MrpProject *project, const gchar *uri, GError **error)
 
 			g_free (priv->uri);
 			priv->uri = filename;
+			priv->file_compression = compression;
 
 			/* Remove old calendar. */
 			mrp_calendar_remove (old_default_calendar);
@@ -975,6 +1421,10 @@ mrp_project_save (MrpProject *project, gboolean force, GError **error)
 		return FALSE;
 	}
 
+	if (priv->journal) {
+		imrp_journal_compact (priv->journal);
+	}
+
 	imrp_project_set_needs_saving (project, FALSE);
 
 	return TRUE;
@@ -1014,11 +1464,7 @@ mrp_project_save_as (MrpProject   *project,
 		is_sql = FALSE;
 
 		/* Hack for now. */
-		if (!strstr (uri, ".mrproject") && !strstr (uri, ".planner")) {
-			real_uri = g_strconcat (uri, ".planner", NULL);
-		} else {
-			real_uri = g_strdup (uri);
-		}
+		real_uri = imrp_compression_get_save_name (uri);
 	}
 
 	if (!project_do_save (project, real_uri, force, error)) {
@@ -1042,6 +1488,10 @@ mrp_project_save_as (MrpProject   *project,
 
 	g_free (real_uri);
 
+	if (priv->journal) {
+		imrp_journal_compact (priv->journal);
+	}
+
 	imrp_project_set_needs_saving (project, FALSE);
 
 	return TRUE;
@@ -1193,6 +1643,24 @@ mrp_project_save_to_xml (MrpProject   *project,
 	return mrp_storage_module_to_xml (priv->primary_storage, str, error);
 }
 
+/* Builds the project's XML tree without serializing it, so that file
+ * writers that operate on a tree (e.g. XSLT) can skip a round trip through
+ * a string. Returns an xmlDocPtr, or NULL if the primary storage module
+ * can't produce one.
+ */
+gpointer
+imrp_project_save_to_xml_doc (MrpProject  *project,
+			      GError     **error)
+{
+	MrpProjectPriv *priv;
+
+	g_return_val_if_fail (MRP_IS_PROJECT (project), NULL);
+
+	priv = project->priv;
+
+	return mrp_storage_module_to_xml_doc (priv->primary_storage, error);
+}
+
 static gboolean
 project_load_from_sql (MrpProject   *project,
 		       const gchar  *uri,
@@ -1290,6 +1758,14 @@ imrp_project_get_task_manager (MrpProject *project)
 	return project->priv->task_manager;
 }
 
+MrpApplication *
+imrp_project_get_application (MrpProject *project)
+{
+	g_return_val_if_fail (MRP_IS_PROJECT (project), NULL);
+
+	return project->priv->app;
+}
+
 /**
  * mrp_project_get_resource_by_name:
  * @project: an #MrpProject
@@ -1302,24 +1778,12 @@ imrp_project_get_task_manager (MrpProject *project)
 MrpResource *
 mrp_project_get_resource_by_name (MrpProject *project, const gchar *name)
 {
-	GList *resources, *l;
-
 	g_return_val_if_fail (MRP_IS_PROJECT (project), NULL);
 	g_return_val_if_fail (name != NULL, NULL);
 
-	/* Should we use a hash table to store these in as well? */
-	resources = mrp_project_get_resources (project);
-
-	for (l = resources; l; l = l->next) {
-		const gchar *rname;
-
-		rname = mrp_resource_get_name (MRP_RESOURCE (l->data));
-		if (strcmp (name, rname) == 0) {
-			return MRP_RESOURCE (l->data);
-		}
-	}
+	project_ensure_indices (project);
 
-	return NULL;
+	return project_index_lookup_first (project->priv->resource_index, name);
 }
 
 /**
@@ -1345,7 +1809,11 @@ imrp_project_set_resources (MrpProject *project,
 {
 	g_return_if_fail (MRP_IS_PROJECT (project));
 
+	project_reset_indices (project);
+
 	project->priv->resources = resources;
+	project->priv->resources_tail = g_list_last (resources);
+	project_link_objects (resources, project->priv->resource_links);
 
 	g_list_foreach (project->priv->resources,
 			(GFunc) project_connect_object,
@@ -1371,7 +1839,14 @@ mrp_project_add_resource (MrpProject *project, MrpResource *resource)
 
 	priv = project->priv;
 
-	priv->resources = g_list_append (priv->resources, resource);
+	/* Append through the tail so adding many resources stays linear. */
+	priv->resources_tail = g_list_append (priv->resources_tail, resource);
+	if (!priv->resources) {
+		priv->resources = priv->resources_tail;
+	} else {
+		priv->resources_tail = priv->resources_tail->next;
+	}
+	g_hash_table_insert (priv->resource_links, resource, priv->resources_tail);
 
 	g_object_get (resource, "group", &group, NULL);
 
@@ -1387,7 +1862,7 @@ mrp_project_add_resource (MrpProject *project, MrpResource *resource)
 
 
 	project_connect_object (MRP_OBJECT (resource), project);
-
+	project_track_object (MRP_OBJECT (resource), project);
 
 	g_signal_emit (project, signals[RESOURCE_ADDED], 0, resource);
 
@@ -1405,6 +1880,7 @@ void
 mrp_project_remove_resource (MrpProject *project, MrpResource *resource)
 {
 	MrpProjectPriv *priv;
+	GList          *link;
 
 	g_return_if_fail (MRP_IS_PROJECT (project));
 	g_return_if_fail (MRP_IS_RESOURCE (resource));
@@ -1413,7 +1889,16 @@ mrp_project_remove_resource (MrpProject *project, MrpResource *resource)
 
 	mrp_object_removed (MRP_OBJECT (resource));
 
-	priv->resources = g_list_remove (priv->resources, resource);
+	link = g_hash_table_lookup (priv->resource_links, resource);
+	if (link) {
+		if (link == priv->resources_tail) {
+			priv->resources_tail = link->prev;
+		}
+		priv->resources = g_list_delete_link (priv->resources, link);
+		g_hash_table_remove (priv->resource_links, resource);
+	}
+
+	project_untrack_object (MRP_OBJECT (resource), project);
 
 	g_signal_emit (project, signals[RESOURCE_REMOVED], 0, resource);
 
@@ -1432,22 +1917,12 @@ mrp_project_remove_resource (MrpProject *project, MrpResource *resource)
 MrpGroup *
 mrp_project_get_group_by_name (MrpProject *project, const gchar *name)
 {
-	GList *groups, *l;
-
 	g_return_val_if_fail (MRP_IS_PROJECT (project), NULL);
 	g_return_val_if_fail (name != NULL, NULL);
 
-	groups = mrp_project_get_groups (project);
-	for (l = groups; l; l = l->next) {
-		const gchar *gname;
-
-		gname = mrp_group_get_name (MRP_GROUP (l->data));
-		if (strcmp (gname, name) == 0) {
-			return MRP_GROUP (l->data);
-		}
-	}
+	project_ensure_indices (project);
 
-	return NULL;
+	return project_index_lookup_first (project->priv->group_index, name);
 }
 
 /**
@@ -1473,7 +1948,10 @@ imrp_project_set_groups (MrpProject *project,
 {
 	g_return_if_fail (MRP_IS_PROJECT (project));
 
+	project_reset_indices (project);
+
 	project->priv->groups = groups;
+	project_link_objects (groups, project->priv->group_links);
 
 	g_list_foreach (project->priv->groups,
 			(GFunc) project_connect_object,
@@ -1499,10 +1977,12 @@ mrp_project_add_group (MrpProject *project, MrpGroup *group)
 	priv = project->priv;
 
 	priv->groups = g_list_prepend (priv->groups, group);
+	g_hash_table_insert (priv->group_links, group, priv->groups);
 
 	g_object_set (group, "project", project, NULL);
 
 	project_connect_object (MRP_OBJECT (group), project);
+	project_track_object (MRP_OBJECT (group), project);
 
 	g_signal_emit (project, signals[GROUP_ADDED], 0, group);
 
@@ -1520,6 +2000,7 @@ void
 mrp_project_remove_group (MrpProject *project, MrpGroup *group)
 {
 	MrpProjectPriv *priv;
+	GList          *link;
 
 	g_return_if_fail (MRP_IS_PROJECT (project));
 	g_return_if_fail (MRP_IS_GROUP (group));
@@ -1530,7 +2011,13 @@ mrp_project_remove_group (MrpProject *project, MrpGroup *group)
 		priv->default_group = NULL;
 	}
 
-	priv->groups = g_list_remove (priv->groups, group);
+	link = g_hash_table_lookup (priv->group_links, group);
+	if (link) {
+		priv->groups = g_list_delete_link (priv->groups, link);
+		g_hash_table_remove (priv->group_links, group);
+	}
+
+	project_untrack_object (MRP_OBJECT (group), project);
 
 	g_signal_emit (project, signals[GROUP_REMOVED], 0, group);
 
@@ -1631,30 +2118,114 @@ mrp_project_set_project_start (MrpProject *project,
 
 	project->priv->project_start = start;
 }
+
 /**
- * imrp_project_add_calendar_day:
+ * mrp_project_get_status_date:
  * @project: an #MrpProject
- * @day: #MrpDay to add
  *
- * This adds a calendar day type to the list of available day types.
+ * Fetches the status date of @project, the date that the actual cost and
+ * planned value of tasks are measured at. It defaults to today.
  *
- * Return value: %TRUE on success, %FALSE if a day type of the same id
- * was already in the list.
+ * Return value: the status date
  **/
-gboolean
-imrp_project_add_calendar_day (MrpProject *project, MrpDay *day)
+mrptime
+mrp_project_get_status_date (MrpProject *project)
+{
+	g_return_val_if_fail (MRP_IS_PROJECT (project), MRP_TIME_INVALID);
+
+	return project->priv->status_date;
+}
+
+/**
+ * mrp_project_set_status_date:
+ * @project: an #MrpProject
+ * @date: the new status date
+ *
+ * Sets the status date of @project and updates the cost figures of all tasks.
+ **/
+void
+mrp_project_set_status_date (MrpProject *project,
+			     mrptime     date)
 {
 	MrpProjectPriv *priv;
-	MrpDay         *tmp_day;
+	MrpTask        *root;
 
-	g_return_val_if_fail (MRP_IS_PROJECT (project), -1);
-	g_return_val_if_fail (day != NULL, -1);
+	g_return_if_fail (MRP_IS_PROJECT (project));
 
 	priv = project->priv;
 
-	tmp_day = (MrpDay *) g_hash_table_lookup (priv->day_types,
-						  GINT_TO_POINTER (mrp_day_get_id (day)));
-
+	if (priv->status_date == date) {
+		return;
+	}
+
+	priv->status_date = date;
+
+	root = mrp_task_manager_get_root (priv->task_manager);
+	if (root) {
+		imrp_task_recalc_rollup (root);
+	}
+
+	g_object_notify (G_OBJECT (project), "status-date");
+}
+
+/**
+ * mrp_project_get_file_compression:
+ * @project: an #MrpProject
+ *
+ * Fetches how the project file of @project is compressed. Loading a project
+ * sets it to the compression of the file that was loaded.
+ *
+ * Return value: the compression of the project file
+ **/
+MrpFileCompression
+mrp_project_get_file_compression (MrpProject *project)
+{
+	g_return_val_if_fail (MRP_IS_PROJECT (project), MRP_FILE_COMPRESSION_NONE);
+
+	return project->priv->file_compression;
+}
+
+/**
+ * mrp_project_set_file_compression:
+ * @project: an #MrpProject
+ * @compression: the compression to use
+ *
+ * Sets how the project file is compressed the next time @project is saved.
+ **/
+void
+mrp_project_set_file_compression (MrpProject         *project,
+				  MrpFileCompression  compression)
+{
+	g_return_if_fail (MRP_IS_PROJECT (project));
+	g_return_if_fail (mrp_file_compression_is_supported (compression));
+
+	project->priv->file_compression = compression;
+}
+
+/**
+ * imrp_project_add_calendar_day:
+ * @project: an #MrpProject
+ * @day: #MrpDay to add
+ *
+ * This adds a calendar day type to the list of available day types.
+ *
+ * Return value: %TRUE on success, %FALSE if a day type of the same id
+ * was already in the list.
+ **/
+gboolean
+imrp_project_add_calendar_day (MrpProject *project, MrpDay *day)
+{
+	MrpProjectPriv *priv;
+	MrpDay         *tmp_day;
+
+	g_return_val_if_fail (MRP_IS_PROJECT (project), -1);
+	g_return_val_if_fail (day != NULL, -1);
+
+	priv = project->priv;
+
+	tmp_day = (MrpDay *) g_hash_table_lookup (priv->day_types,
+						  GINT_TO_POINTER (mrp_day_get_id (day)));
+
 	if (tmp_day) {
 		g_warning ("Trying to add already present day type: '%s'",
 			   mrp_day_get_name (tmp_day));
@@ -1842,53 +2413,115 @@ imrp_project_set_needs_saving (MrpProject *project, gboolean needs_saving)
 /* Task related functions.
  */
 
-typedef struct {
-	const gchar *name;
-	MrpTask     *task;
-} FindTaskByNameData;
-
-static gboolean
-find_task_by_name_traverse_func (MrpTask *task, FindTaskByNameData *data)
+/**
+ * mrp_project_get_task_by_name:
+ * @project: an #MrpProject
+ * @name: the name to look for
+ *
+ * Retrieves the first task added to @project with name matching @name.
+ *
+ * Return value: an #MrpTask or %NULL if not found.
+ **/
+MrpTask *
+mrp_project_get_task_by_name (MrpProject *project, const gchar *name)
 {
-	const gchar *name;
+	g_return_val_if_fail (MRP_IS_PROJECT (project), NULL);
+	g_return_val_if_fail (name != NULL, NULL);
 
-	name = mrp_task_get_name (task);
-	if (strcmp (name, data->name) == 0) {
-		data->task = task;
-		return TRUE;
-	}
+	project_ensure_indices (project);
 
-	return FALSE;
+	return project_index_lookup_first (project->priv->task_index, name);
 }
 
 /**
- * mrp_project_get_task_by_name:
+ * mrp_project_get_objects_by_name:
  * @project: an #MrpProject
+ * @object_type: %MRP_TYPE_TASK, %MRP_TYPE_RESOURCE or %MRP_TYPE_GROUP
  * @name: the name to look for
  *
- * Retrieves the first task with name matching @name. Uses task_traverse to traverse all tasks.
+ * Retrieves all objects of @object_type in @project named @name, in the order
+ * they were added. The lookup uses an index that is built on first use.
  *
- * Return value: an #MrpTask or %NULL if not found.
+ * Return value: a newly allocated list that must be freed with g_list_free().
  **/
-MrpTask *
-mrp_project_get_task_by_name (MrpProject *project, const gchar *name)
+GList *
+mrp_project_get_objects_by_name (MrpProject  *project,
+				 GType        object_type,
+				 const gchar *name)
 {
-	FindTaskByNameData *data;
-	MrpTask            *ret_val;
+	ProjectIndex *index;
 
-	data = g_new0 (FindTaskByNameData, 1);
-	data->name = name;
-	data->task = NULL;
+	g_return_val_if_fail (MRP_IS_PROJECT (project), NULL);
+	g_return_val_if_fail (name != NULL, NULL);
 
-	mrp_project_task_traverse (project,
-				   mrp_project_get_root_task (project),
-				   (MrpTaskTraverseFunc) find_task_by_name_traverse_func,
-				   data);
+	project_ensure_indices (project);
 
-	ret_val = data->task;
-	g_free (data);
+	index = project_get_name_index (project, object_type);
+	g_return_val_if_fail (index != NULL, NULL);
 
-	return ret_val;
+	return project_index_lookup (index, name);
+}
+
+/**
+ * mrp_project_get_objects_by_property:
+ * @project: an #MrpProject
+ * @object_type: %MRP_TYPE_TASK, %MRP_TYPE_RESOURCE or %MRP_TYPE_GROUP
+ * @name: the name of a string custom property of @object_type
+ * @value: the value to look for
+ *
+ * Retrieves all objects of @object_type in @project whose custom property
+ * @name is set to @value. This is meant for keys such as external ids; the
+ * index for a property is built the first time it is looked up and kept
+ * current afterwards.
+ *
+ * Return value: a newly allocated list that must be freed with g_list_free().
+ **/
+GList *
+mrp_project_get_objects_by_property (MrpProject  *project,
+				     GType        object_type,
+				     const gchar *name,
+				     const gchar *value)
+{
+	MrpProjectPriv *priv;
+	MrpProperty    *property;
+	ProjectIndex   *index;
+	GHashTableIter  iter;
+	gpointer        object;
+
+	g_return_val_if_fail (MRP_IS_PROJECT (project), NULL);
+	g_return_val_if_fail (g_type_is_a (object_type, MRP_TYPE_TASK) ||
+			      g_type_is_a (object_type, MRP_TYPE_RESOURCE) ||
+			      g_type_is_a (object_type, MRP_TYPE_GROUP), NULL);
+	g_return_val_if_fail (name != NULL, NULL);
+	g_return_val_if_fail (value != NULL, NULL);
+
+	priv = project->priv;
+
+	property = mrp_project_get_property (project, name, object_type);
+	if (!property) {
+		return NULL;
+	}
+
+	g_return_val_if_fail (
+		mrp_property_get_property_type (property) == MRP_PROPERTY_TYPE_STRING,
+		NULL);
+
+	project_ensure_indices (project);
+
+	index = g_hash_table_lookup (priv->property_indices, property);
+	if (!index) {
+		index = project_index_new ();
+		g_hash_table_insert (priv->property_indices, property, index);
+
+		g_hash_table_iter_init (
+			&iter,
+			project_get_name_index (project, object_type)->keys);
+		while (g_hash_table_iter_next (&iter, &object, NULL)) {
+			project_index_property_value (index, object, property);
+		}
+	}
+
+	return project_index_lookup (index, value);
 }
 
 /**
@@ -1934,6 +2567,29 @@ mrp_project_insert_task (MrpProject *project,
 	g_object_set (MRP_OBJECT (task), "project", project, NULL);
 }
 
+static gboolean
+project_invalidate_timephase_traverse_func (MrpTask      *task,
+					    MrpTimephase *timephase)
+{
+	imrp_timephase_invalidate_task (timephase, task);
+
+	return FALSE;
+}
+
+static void
+project_invalidate_timephase_subtree (MrpProject *project,
+				      MrpTask    *task)
+{
+	if (!project->priv->timephase) {
+		return;
+	}
+
+	mrp_project_task_traverse (project,
+				   task,
+				   (MrpTaskTraverseFunc) project_invalidate_timephase_traverse_func,
+				   project->priv->timephase);
+}
+
 /**
  * mrp_project_remove_task:
  * @project: an #MrpProject
@@ -1949,6 +2605,13 @@ mrp_project_remove_task (MrpProject *project,
 
 	mrp_object_removed (MRP_OBJECT (task));
 
+	mrp_project_task_traverse (project,
+				   task,
+				   (MrpTaskTraverseFunc) project_untrack_task_traverse_func,
+				   project);
+
+	project_invalidate_timephase_subtree (project, task);
+
 	mrp_task_manager_remove_task (project->priv->task_manager,
 				      task);
 
@@ -2005,6 +2668,8 @@ void
 imrp_project_task_moved (MrpProject *project,
 			 MrpTask    *task)
 {
+	project_invalidate_timephase_subtree (project, task);
+
 	g_signal_emit (project, signals[TASK_MOVED], 0, task);
 
 	imrp_project_set_needs_saving (project, TRUE);
@@ -2061,6 +2726,8 @@ mrp_project_reschedule (MrpProject *project)
 {
 	g_return_if_fail (MRP_IS_PROJECT (project));
 
+	imrp_project_invalidate_timephase (project, NULL);
+
 	mrp_task_manager_recalc (project->priv->task_manager, TRUE);
 }
 
@@ -2133,11 +2800,130 @@ imrp_project_task_inserted (MrpProject *project, MrpTask *task)
 {
 	g_return_if_fail (MRP_IS_PROJECT (project));
 
+	mrp_project_task_traverse (project,
+				   task,
+				   (MrpTaskTraverseFunc) project_track_task_traverse_func,
+				   project);
+
+	/* The parent may have been a leaf until now. */
+	project_invalidate_timephase_subtree (project, task);
+	if (mrp_task_get_parent (task)) {
+		imrp_project_invalidate_timephase (project, mrp_task_get_parent (task));
+	}
+
 	g_signal_emit (project, signals[TASK_INSERTED], 0, task);
 
 	imrp_project_set_needs_saving (project, TRUE);
 }
 
+/**
+ * imrp_project_tasks_replaced:
+ * @project: an #MrpProject
+ *
+ * Called when the whole task tree is swapped out, drops the lookup indices
+ * so that they are rebuilt from the new tree on the next lookup.
+ **/
+void
+imrp_project_tasks_replaced (MrpProject *project)
+{
+	g_return_if_fail (MRP_IS_PROJECT (project));
+
+	project_reset_indices (project);
+	imrp_project_invalidate_timephase (project, NULL);
+}
+
+/**
+ * imrp_project_object_finalized:
+ * @project: an #MrpProject
+ * @object: an #MrpObject being finalized
+ *
+ * Makes sure @object is no longer referenced by the lookup indices.
+ **/
+void
+imrp_project_object_finalized (MrpProject *project, MrpObject *object)
+{
+	g_return_if_fail (MRP_IS_PROJECT (project));
+
+	project_untrack_object (object, project);
+}
+
+static void
+project_object_slots_free (ObjectSlots *slots)
+{
+	g_array_free (slots->free_slots, TRUE);
+	g_free (slots);
+}
+
+/**
+ * imrp_project_get_object_slot:
+ * @project: an #MrpProject
+ * @type: the type of the object
+ * @stamp: return location for the stamp of the slot
+ *
+ * Hands out a slot in the custom property columns of @type, reusing the slots
+ * of finalized objects first. The stamp tells a new owner of a reused slot
+ * apart from the old one. Like the rest of the project this is not locked and
+ * must only be used from the main thread.
+ *
+ * Return value: the slot.
+ **/
+guint
+imrp_project_get_object_slot (MrpProject *project, GType type, guint *stamp)
+{
+	ObjectSlots *slots;
+	guint        slot;
+
+	g_return_val_if_fail (MRP_IS_PROJECT (project), 0);
+	g_return_val_if_fail (stamp != NULL, 0);
+
+	slots = g_hash_table_lookup (project->priv->object_slots,
+				     GSIZE_TO_POINTER (type));
+	if (!slots) {
+		slots = g_new0 (ObjectSlots, 1);
+		slots->free_slots = g_array_new (FALSE, FALSE, sizeof (guint));
+		g_hash_table_insert (project->priv->object_slots,
+				     GSIZE_TO_POINTER (type), slots);
+	}
+
+	if (slots->free_slots->len > 0) {
+		slot = g_array_index (slots->free_slots, guint,
+				      slots->free_slots->len - 1);
+		g_array_set_size (slots->free_slots, slots->free_slots->len - 1);
+	} else {
+		slot = slots->n_slots++;
+	}
+
+	if (++slots->last_stamp == 0) {
+		slots->last_stamp = 1;
+	}
+	*stamp = slots->last_stamp;
+
+	return slot;
+}
+
+/**
+ * imrp_project_release_object_slot:
+ * @project: an #MrpProject
+ * @type: the type of the object
+ * @slot: a slot from imrp_project_get_object_slot()
+ *
+ * Gives @slot back to the pool of @type. The values in it must already be
+ * unset.
+ **/
+void
+imrp_project_release_object_slot (MrpProject *project, GType type, guint slot)
+{
+	ObjectSlots *slots;
+
+	g_return_if_fail (MRP_IS_PROJECT (project));
+
+	slots = g_hash_table_lookup (project->priv->object_slots,
+				     GSIZE_TO_POINTER (type));
+	g_return_if_fail (slots != NULL && slot < slots->n_slots);
+
+	g_array_append_val (slots->free_slots, slot);
+}
+
 /* Debug function. */
 #if 0
 static void
@@ -2316,6 +3102,13 @@ mrp_project_remove_property (MrpProject  *project,
 
 	g_signal_emit (project, signals[PROPERTY_REMOVED], 0, property);
 
+	/* Drop the values every object held for it. */
+	imrp_property_clear_values (property);
+
+	if (priv->indices_built) {
+		g_hash_table_remove (priv->property_indices, property);
+	}
+
 	g_param_spec_pool_remove (priv->property_pool,
 				  G_PARAM_SPEC (property));
 
@@ -2423,6 +3216,17 @@ project_setup_default_calendar (MrpProject *project)
 	g_list_free (ivals);
 }
 
+/* For the resources that work on the project calendar. */
+static void
+project_invalidate_resource_loads (MrpProject *project)
+{
+	GList *l;
+
+	for (l = project->priv->resources; l; l = l->next) {
+		imrp_resource_invalidate_load (l->data);
+	}
+}
+
 static void
 project_calendar_changed (MrpCalendar *calendar,
 			  MrpProject  *project)
@@ -2431,6 +3235,9 @@ project_calendar_changed (MrpCalendar *calendar,
 
 	priv = project->priv;
 
+	imrp_project_invalidate_timephase (project, NULL);
+	project_invalidate_resource_loads (project);
+
 	mrp_task_manager_recalc (priv->task_manager, TRUE);
 }
 
@@ -2459,6 +3266,9 @@ project_set_calendar (MrpProject  *project,
 					 0);
 	}
 
+	imrp_project_invalidate_timephase (project, NULL);
+	project_invalidate_resource_loads (project);
+
 	mrp_task_manager_recalc (priv->task_manager, TRUE);
 }
 
@@ -2500,3 +3310,479 @@ mrp_project_get_block_scheduling (MrpProject *project)
 	return mrp_task_manager_get_block_scheduling (priv->task_manager);
 }
 
+
+/**
+ * mrp_project_get_leveling_delays:
+ * @project: an #MrpProject
+ *
+ * Calculates which tasks need to start later so that no work resource is
+ * assigned more than full time, placing tasks with a higher priority first.
+ * The project is not changed, see mrp_project_level_resources().
+ *
+ * Return value: a newly allocated list of newly allocated #MrpLevelingDelay,
+ * in the order the tasks were placed. Free with g_list_free_full() and
+ * g_free().
+ **/
+GList *
+mrp_project_get_leveling_delays (MrpProject *project)
+{
+	g_return_val_if_fail (MRP_IS_PROJECT (project), NULL);
+
+	return mrp_task_manager_level_resources (project->priv->task_manager);
+}
+
+/**
+ * mrp_project_level_resources:
+ * @project: an #MrpProject
+ *
+ * Levels the resources of @project, giving each task delayed by
+ * mrp_project_get_leveling_delays() a start-no-earlier-than constraint, and
+ * reschedules the project once.
+ *
+ * Return value: the number of delayed tasks.
+ **/
+gint
+mrp_project_level_resources (MrpProject *project)
+{
+	GList            *delays, *l;
+	MrpLevelingDelay *delay;
+	MrpConstraint     constraint;
+	gboolean          block;
+	gint              n;
+
+	g_return_val_if_fail (MRP_IS_PROJECT (project), 0);
+
+	delays = mrp_task_manager_level_resources (project->priv->task_manager);
+	n = g_list_length (delays);
+
+	block = mrp_project_get_block_scheduling (project);
+	mrp_project_set_block_scheduling (project, TRUE);
+
+	for (l = delays; l; l = l->next) {
+		delay = l->data;
+
+		constraint.type = MRP_CONSTRAINT_SNET;
+		constraint.time = delay->start;
+
+		g_object_set (delay->task, "constraint", &constraint, NULL);
+	}
+
+	mrp_project_set_block_scheduling (project, block);
+
+	g_list_free_full (delays, g_free);
+
+	return n;
+}
+
+static MrpBaseline *
+project_update_schedule (MrpProject *project)
+{
+	MrpProjectPriv *priv;
+	GList          *tasks;
+
+	priv = project->priv;
+
+	if (!priv->schedule) {
+		priv->schedule = imrp_baseline_new (NULL, 0, FALSE);
+	}
+
+	tasks = mrp_project_get_all_tasks (project);
+	imrp_baseline_update (priv->schedule, tasks);
+	g_list_free (tasks);
+
+	return priv->schedule;
+}
+
+static void
+project_remove_baseline (MrpProject *project, MrpBaseline *baseline)
+{
+	MrpProjectPriv *priv;
+
+	priv = project->priv;
+
+	priv->baselines = g_list_remove (priv->baselines, baseline);
+	imrp_baseline_free (baseline);
+}
+
+void
+imrp_project_add_baseline (MrpProject *project, MrpBaseline *baseline)
+{
+	MrpBaseline *old;
+
+	g_return_if_fail (MRP_IS_PROJECT (project));
+	g_return_if_fail (baseline != NULL);
+
+	old = mrp_project_get_baseline (project, mrp_baseline_get_name (baseline));
+	if (old) {
+		project_remove_baseline (project, old);
+	}
+
+	project->priv->baselines = g_list_append (project->priv->baselines, baseline);
+}
+
+/**
+ * mrp_project_add_baseline:
+ * @project: an #MrpProject
+ * @name: the name of the baseline
+ *
+ * Saves the current schedule of the tasks in @project as a baseline called
+ * @name, replacing any baseline or scenario with the same name. The baseline
+ * shares the rows of all tasks that did not change since the last baseline
+ * was taken.
+ *
+ * Return value: the new baseline, owned by @project.
+ **/
+MrpBaseline *
+mrp_project_add_baseline (MrpProject *project, const gchar *name)
+{
+	MrpBaseline *baseline;
+
+	g_return_val_if_fail (MRP_IS_PROJECT (project), NULL);
+	g_return_val_if_fail (name != NULL, NULL);
+
+	baseline = imrp_baseline_copy (project_update_schedule (project),
+				       name, mrp_time_current_time (), FALSE);
+
+	imrp_project_add_baseline (project, baseline);
+	imrp_project_set_needs_saving (project, TRUE);
+
+	return baseline;
+}
+
+/**
+ * mrp_project_add_scenario:
+ * @project: an #MrpProject
+ * @name: the name of the scenario
+ * @source: the baseline or scenario to start from, or %NULL
+ *
+ * Adds a scenario called @name, a baseline that can be changed with
+ * mrp_baseline_set_task() without changing the project. It starts as a copy
+ * of @source, or of the current schedule if @source is %NULL. Any baseline
+ * or scenario with the same name is replaced.
+ *
+ * Return value: the new scenario, owned by @project.
+ **/
+MrpBaseline *
+mrp_project_add_scenario (MrpProject  *project,
+			  const gchar *name,
+			  MrpBaseline *source)
+{
+	MrpBaseline *scenario;
+
+	g_return_val_if_fail (MRP_IS_PROJECT (project), NULL);
+	g_return_val_if_fail (name != NULL, NULL);
+
+	if (!source) {
+		source = project_update_schedule (project);
+	}
+
+	scenario = imrp_baseline_copy (source, name, mrp_time_current_time (), TRUE);
+
+	imrp_project_add_baseline (project, scenario);
+	imrp_project_set_needs_saving (project, TRUE);
+
+	return scenario;
+}
+
+/**
+ * mrp_project_remove_baseline:
+ * @project: an #MrpProject
+ * @baseline: a baseline or scenario of @project
+ *
+ * Removes and frees @baseline.
+ **/
+void
+mrp_project_remove_baseline (MrpProject *project, MrpBaseline *baseline)
+{
+	g_return_if_fail (MRP_IS_PROJECT (project));
+	g_return_if_fail (g_list_find (project->priv->baselines, baseline));
+
+	project_remove_baseline (project, baseline);
+	imrp_project_set_needs_saving (project, TRUE);
+}
+
+/**
+ * mrp_project_get_baseline:
+ * @project: an #MrpProject
+ * @name: the name of a baseline
+ *
+ * Looks up the baseline or scenario called @name.
+ *
+ * Return value: the baseline, or %NULL if there is none called @name.
+ **/
+MrpBaseline *
+mrp_project_get_baseline (MrpProject *project, const gchar *name)
+{
+	GList *l;
+
+	g_return_val_if_fail (MRP_IS_PROJECT (project), NULL);
+	g_return_val_if_fail (name != NULL, NULL);
+
+	for (l = project->priv->baselines; l; l = l->next) {
+		if (strcmp (mrp_baseline_get_name (l->data), name) == 0) {
+			return l->data;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * mrp_project_get_baselines:
+ * @project: an #MrpProject
+ *
+ * Fetches the baselines and scenarios of @project, in the order they were
+ * added. This list should not be freed.
+ *
+ * Return value: the baseline list of @project.
+ **/
+GList *
+mrp_project_get_baselines (MrpProject *project)
+{
+	g_return_val_if_fail (MRP_IS_PROJECT (project), NULL);
+
+	return project->priv->baselines;
+}
+
+/**
+ * mrp_project_get_variances:
+ * @project: an #MrpProject
+ * @baseline: a baseline or scenario of @project
+ *
+ * Compares the current schedule with @baseline. Tasks that are not in
+ * @baseline, or whose schedule did not change, are left out.
+ *
+ * Return value: a newly allocated list of newly allocated
+ * #MrpBaselineVariance, ordered by when the tasks were created. Free with
+ * g_list_free_full() and g_free().
+ **/
+GList *
+mrp_project_get_variances (MrpProject *project, MrpBaseline *baseline)
+{
+	g_return_val_if_fail (MRP_IS_PROJECT (project), NULL);
+	g_return_val_if_fail (baseline != NULL, NULL);
+
+	return imrp_baseline_get_variances (baseline, project_update_schedule (project));
+}
+
+/* Marks the time-phased work of @task, or of all tasks if @task is %NULL, as
+ * out of date. Nothing is tracked until the first query.
+ */
+void
+imrp_project_invalidate_timephase (MrpProject *project, MrpTask *task)
+{
+	MrpTimephase *timephase;
+
+	g_return_if_fail (MRP_IS_PROJECT (project));
+
+	timephase = project->priv->timephase;
+	if (!timephase) {
+		return;
+	}
+
+	if (task) {
+		imrp_timephase_invalidate_task (timephase, task);
+	} else {
+		imrp_timephase_invalidate_all (timephase);
+	}
+}
+
+static MrpTimephase *
+project_get_timephase (MrpProject *project)
+{
+	MrpProjectPriv *priv;
+
+	priv = project->priv;
+
+	if (!priv->timephase) {
+		priv->timephase = imrp_timephase_new (project);
+	}
+
+	return priv->timephase;
+}
+
+/**
+ * mrp_project_get_resource_timephase:
+ * @project: an #MrpProject
+ * @resource: a resource of @project
+ * @unit: %MRP_TIME_UNIT_DAY, %MRP_TIME_UNIT_WEEK or %MRP_TIME_UNIT_MONTH
+ * @start: the start of the range
+ * @finish: the end of the range
+ *
+ * Retrieves the work and cost of @resource per day, week or month, for each
+ * period that overlaps the range from @start to @finish. Weeks start on
+ * Monday. The buckets are kept up to date as the project changes, so this
+ * only takes time in proportion to the number of periods, apart from
+ * updating the tasks that changed since the last query.
+ *
+ * Return value: a newly allocated array of #MrpTimephaseBucket, free with
+ * g_array_free().
+ **/
+GArray *
+mrp_project_get_resource_timephase (MrpProject  *project,
+				    MrpResource *resource,
+				    MrpTimeUnit  unit,
+				    mrptime      start,
+				    mrptime      finish)
+{
+	g_return_val_if_fail (MRP_IS_PROJECT (project), NULL);
+	g_return_val_if_fail (MRP_IS_RESOURCE (resource), NULL);
+
+	return imrp_timephase_get_resource (project_get_timephase (project),
+					    resource, unit, start, finish);
+}
+
+/**
+ * mrp_project_get_task_timephase:
+ * @project: an #MrpProject
+ * @task: a task of @project
+ * @unit: %MRP_TIME_UNIT_DAY, %MRP_TIME_UNIT_WEEK or %MRP_TIME_UNIT_MONTH
+ * @start: the start of the range
+ * @finish: the end of the range
+ *
+ * Like mrp_project_get_resource_timephase(), for @task. The work of a
+ * summary task is the work of all tasks below it, and the root task holds
+ * the work of the whole project.
+ *
+ * Return value: a newly allocated array of #MrpTimephaseBucket, free with
+ * g_array_free().
+ **/
+GArray *
+mrp_project_get_task_timephase (MrpProject  *project,
+				MrpTask     *task,
+				MrpTimeUnit  unit,
+				mrptime      start,
+				mrptime      finish)
+{
+	g_return_val_if_fail (MRP_IS_PROJECT (project), NULL);
+	g_return_val_if_fail (MRP_IS_TASK (task), NULL);
+
+	return imrp_timephase_get_task (project_get_timephase (project),
+					task, unit, start, finish);
+}
+
+/* Remembers to check the overallocations of @resource after the next
+ * scheduling pass.
+ */
+void
+imrp_project_queue_overallocation_check (MrpProject  *project,
+					 MrpResource *resource)
+{
+	GHashTable *queue;
+
+	g_return_if_fail (MRP_IS_PROJECT (project));
+
+	queue = project->priv->overallocation_queue;
+	if (queue && !g_hash_table_contains (queue, resource)) {
+		g_hash_table_add (queue, g_object_ref (resource));
+	}
+}
+
+/* Rebuilds the overallocations of the queued resources, which emit
+ * MrpResource::overallocations-changed where they differ. Called after each
+ * scheduling pass, so the work is in proportion to the resources of the
+ * tasks that moved.
+ */
+void
+imrp_project_check_overallocations (MrpProject *project)
+{
+	GList *resources, *l;
+
+	g_return_if_fail (MRP_IS_PROJECT (project));
+
+	if (g_hash_table_size (project->priv->overallocation_queue) == 0) {
+		return;
+	}
+
+	/* Handlers may change the project and queue resources again. */
+	resources = g_hash_table_get_keys (project->priv->overallocation_queue);
+	g_hash_table_steal_all (project->priv->overallocation_queue);
+
+	for (l = resources; l; l = l->next) {
+		if (mrp_object_get_project (l->data) == project) {
+			imrp_resource_check_overallocations (l->data);
+		}
+
+		g_object_unref (l->data);
+	}
+
+	g_list_free (resources);
+}
+
+/**
+ * mrp_project_start_journal:
+ * @project: an #MrpProject
+ * @filename: the file to keep the journal in
+ * @error: location to store error, or %NULL
+ *
+ * Starts recording the changes made to @project in a journal, so that they
+ * can be recovered if the program crashes before the project is saved. The
+ * journal is compacted every time the project is saved.
+ *
+ * If @filename holds a journal left behind earlier, its changes are first
+ * replayed on top of @project, which must then be loaded from the same
+ * project file that the journal was started on, or be a new project if the
+ * journal was started on one that was never saved. A journal that doesn't
+ * replay completely leaves @project as it was.
+ *
+ * Return value: %TRUE on success, otherwise %FALSE
+ **/
+gboolean
+mrp_project_start_journal (MrpProject   *project,
+			   const gchar  *filename,
+			   GError      **error)
+{
+	MrpProjectPriv *priv;
+
+	g_return_val_if_fail (MRP_IS_PROJECT (project), FALSE);
+	g_return_val_if_fail (filename != NULL, FALSE);
+
+	priv = project->priv;
+
+	g_return_val_if_fail (priv->journal == NULL, FALSE);
+
+	priv->journal = imrp_journal_new (project, filename, error);
+
+	return priv->journal != NULL;
+}
+
+/**
+ * mrp_project_stop_journal:
+ * @project: an #MrpProject
+ * @discard: whether to remove the journal file
+ *
+ * Stops recording changes made to @project. Pass %TRUE for @discard when
+ * the changes should not be recovered, e.g. when the project is closed
+ * without saving it.
+ **/
+void
+mrp_project_stop_journal (MrpProject *project, gboolean discard)
+{
+	MrpProjectPriv *priv;
+
+	g_return_if_fail (MRP_IS_PROJECT (project));
+
+	priv = project->priv;
+
+	if (priv->journal) {
+		imrp_journal_free (priv->journal, discard);
+		priv->journal = NULL;
+	}
+}
+
+/**
+ * mrp_project_sync_journal:
+ * @project: an #MrpProject
+ *
+ * Writes the recorded changes through to disk right away, instead of
+ * waiting for the next periodic sync.
+ **/
+void
+mrp_project_sync_journal (MrpProject *project)
+{
+	g_return_if_fail (MRP_IS_PROJECT (project));
+
+	if (project->priv->journal) {
+		imrp_journal_sync (project->priv->journal);
+	}
+}
@@ -46,6 +46,8 @@ typedef struct _MrpProjectPriv MrpProjectPriv;
 
 #include <libplanner/mrp-resource.h>
 #include <libplanner/mrp-calendar.h>
+#include <libplanner/mrp-baseline.h>
+#include <libplanner/mrp-timephase.h>
 
 /**
  * MrpTaskTraverseFunc:
@@ -70,6 +72,18 @@ typedef struct {
 	MrpObjectClass  parent_class;
 } MrpProjectClass;
 
+/**
+ * MrpLevelingDelay:
+ * @task: the task to delay
+ * @start: the start that keeps the resources of @task within their capacity
+ *
+ * A task that resource leveling moves, see mrp_project_get_leveling_delays().
+ */
+typedef struct {
+	MrpTask *task;
+	mrptime  start;
+} MrpLevelingDelay;
+
 GType            mrp_project_get_type                 (void) G_GNUC_CONST;
 MrpProject      *mrp_project_new                      (MrpApplication       *app);
 gboolean         mrp_project_is_empty                 (MrpProject           *project);
@@ -77,6 +91,12 @@ gboolean         mrp_project_needs_saving             (MrpProject           *pro
 mrptime          mrp_project_get_project_start        (MrpProject           *project);
 void             mrp_project_set_project_start        (MrpProject           *project,
 						       mrptime               start);
+mrptime          mrp_project_get_status_date          (MrpProject           *project);
+void             mrp_project_set_status_date          (MrpProject           *project,
+						       mrptime               date);
+MrpFileCompression mrp_project_get_file_compression   (MrpProject           *project);
+void             mrp_project_set_file_compression     (MrpProject           *project,
+						       MrpFileCompression    compression);
 gboolean         mrp_project_load                     (MrpProject           *project,
 						       const gchar          *uri,
 						       GError              **error);
@@ -99,6 +119,12 @@ gboolean         mrp_project_load_from_xml            (MrpProject           *pro
 						       const gchar          *str,
 						       GError              **error);
 void             mrp_project_close                    (MrpProject           *project);
+gboolean         mrp_project_start_journal            (MrpProject           *project,
+						       const gchar          *filename,
+						       GError              **error);
+void             mrp_project_stop_journal             (MrpProject           *project,
+						       gboolean              discard);
+void             mrp_project_sync_journal             (MrpProject           *project);
 const gchar     *mrp_project_get_uri                  (MrpProject           *project);
 void             mrp_project_set_uri                  (MrpProject           *project,
 						       const gchar          *uri);
@@ -118,6 +144,13 @@ void             mrp_project_remove_group             (MrpProject           *pro
 						       MrpGroup             *group);
 MrpTask         *mrp_project_get_task_by_name         (MrpProject           *project,
 						       const gchar          *name);
+GList           *mrp_project_get_objects_by_name      (MrpProject           *project,
+						       GType                 object_type,
+						       const gchar          *name);
+GList           *mrp_project_get_objects_by_property  (MrpProject           *project,
+						       GType                 object_type,
+						       const gchar          *name,
+						       const gchar          *value);
 GList           *mrp_project_get_all_tasks            (MrpProject           *project);
 void             mrp_project_insert_task              (MrpProject           *project,
 						       MrpTask              *parent,
@@ -167,3 +200,27 @@ MrpDay *         mrp_project_get_calendar_day_by_id   (MrpProject           *pro
 void             mrp_project_set_block_scheduling     (MrpProject           *project,
 						       gboolean              block);
 gboolean         mrp_project_get_block_scheduling     (MrpProject           *project);
+GList           *mrp_project_get_leveling_delays      (MrpProject           *project);
+gint             mrp_project_level_resources          (MrpProject           *project);
+MrpBaseline     *mrp_project_add_baseline             (MrpProject           *project,
+						       const gchar          *name);
+MrpBaseline     *mrp_project_add_scenario             (MrpProject           *project,
+						       const gchar          *name,
+						       MrpBaseline          *source);
+void             mrp_project_remove_baseline          (MrpProject           *project,
+						       MrpBaseline          *baseline);
+MrpBaseline     *mrp_project_get_baseline             (MrpProject           *project,
+						       const gchar          *name);
+GList           *mrp_project_get_baselines            (MrpProject           *project);
+GList           *mrp_project_get_variances            (MrpProject           *project,
+						       MrpBaseline          *baseline);
+GArray          *mrp_project_get_resource_timephase   (MrpProject           *project,
+						       MrpResource          *resource,
+						       MrpTimeUnit           unit,
+						       mrptime               start,
+						       mrptime               finish);
+GArray          *mrp_project_get_task_timephase       (MrpProject           *project,
+						       MrpTask              *task,
+						       MrpTimeUnit           unit,
+						       mrptime               start,
+						       mrptime               finish);
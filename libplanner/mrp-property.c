@@ -33,11 +33,13 @@
  */
 
 #include <config.h>
+#include <string.h>
 
 #include "mrp-private.h"
 #include <glib/gi18n.h>
 #include "mrp-project.h"
 #include "mrp-property.h"
+#include "mrp-time.h"
 
 /* Quarks */
 #define LABEL        "label"
@@ -45,6 +47,7 @@
 #define DESCRIPTION  "description"
 #define TYPE         "type"
 #define USER_DEFINED "user_defined"
+#define STORE        "store"
 
 static void         property_set_type               (MrpProperty     *property,
 						     MrpPropertyType  type);
@@ -70,6 +73,251 @@ imrp_property_set_project (MrpProperty *property, MrpProject *project)
 				project);
 }
 
+/* Custom property values are kept on the property itself, one column per
+ * property, instead of in a hash table on every object. Objects address
+ * their slot with a dense index that the project hands out per object type,
+ * so a column only grows with the objects that can own it. Each slot
+ * remembers the stamp of the object that wrote it so that a recycled index
+ * never sees a stale value.
+ */
+typedef enum {
+	STORE_INT,
+	STORE_FLOAT,
+	STORE_TIME,
+	STORE_STRING,
+	STORE_VALUE
+} StoreKind;
+
+typedef struct {
+	GQuark     name_quark;
+	StoreKind  kind;
+	gsize      elem_size;
+	guint      n_slots;
+	guint     *stamps;
+	guint8    *data;
+} PropertyStore;
+
+#define STORE_SLOT(store,index) ((gpointer) ((store)->data + (gsize) (index) * (store)->elem_size))
+
+static void
+property_store_unset_slot (PropertyStore *store, guint index)
+{
+	if (store->stamps[index] == 0) {
+		return;
+	}
+
+	switch (store->kind) {
+	case STORE_STRING:
+		g_free (*(gchar **) STORE_SLOT (store, index));
+		break;
+	case STORE_VALUE:
+		g_value_unset (STORE_SLOT (store, index));
+		break;
+	default:
+		break;
+	}
+
+	memset (STORE_SLOT (store, index), 0, store->elem_size);
+	store->stamps[index] = 0;
+}
+
+static void
+property_store_free (PropertyStore *store)
+{
+	guint i;
+
+	for (i = 0; i < store->n_slots; i++) {
+		property_store_unset_slot (store, i);
+	}
+
+	g_free (store->stamps);
+	g_free (store->data);
+	g_free (store);
+}
+
+static PropertyStore *
+property_get_store (MrpProperty *property)
+{
+	static GQuark  store_quark = 0;
+	PropertyStore *store;
+	GType          type;
+
+	if (!store_quark) {
+		store_quark = g_quark_from_static_string (STORE);
+	}
+
+	store = g_param_spec_get_qdata (G_PARAM_SPEC (property), store_quark);
+	if (store) {
+		return store;
+	}
+
+	store = g_new0 (PropertyStore, 1);
+	store->name_quark = g_quark_from_string (G_PARAM_SPEC (property)->name);
+
+	type = G_PARAM_SPEC_VALUE_TYPE (G_PARAM_SPEC (property));
+	switch (G_TYPE_FUNDAMENTAL (type)) {
+	case G_TYPE_INT:
+		store->kind = STORE_INT;
+		store->elem_size = sizeof (gint);
+		break;
+	case G_TYPE_FLOAT:
+		store->kind = STORE_FLOAT;
+		store->elem_size = sizeof (gfloat);
+		break;
+	case G_TYPE_INT64:
+		store->kind = STORE_TIME;
+		store->elem_size = sizeof (mrptime);
+		break;
+	case G_TYPE_STRING:
+		store->kind = STORE_STRING;
+		store->elem_size = sizeof (gchar *);
+		break;
+	default:
+		store->kind = STORE_VALUE;
+		store->elem_size = sizeof (GValue);
+		break;
+	}
+
+	g_param_spec_set_qdata_full (G_PARAM_SPEC (property),
+				     store_quark,
+				     store,
+				     (GDestroyNotify) property_store_free);
+
+	return store;
+}
+
+static void
+property_store_reserve (PropertyStore *store, guint index)
+{
+	guint n_slots;
+
+	if (index < store->n_slots) {
+		return;
+	}
+
+	n_slots = MAX (store->n_slots * 2, 64);
+	while (n_slots <= index) {
+		n_slots *= 2;
+	}
+
+	store->stamps = g_renew (guint, store->stamps, n_slots);
+	memset (store->stamps + store->n_slots, 0,
+		(n_slots - store->n_slots) * sizeof (guint));
+
+	store->data = g_realloc (store->data, n_slots * store->elem_size);
+	memset (store->data + (gsize) store->n_slots * store->elem_size, 0,
+		(gsize) (n_slots - store->n_slots) * store->elem_size);
+
+	store->n_slots = n_slots;
+}
+
+GQuark
+imrp_property_get_quark (MrpProperty *property)
+{
+	return property_get_store (property)->name_quark;
+}
+
+void
+imrp_property_set_value (MrpProperty  *property,
+			 guint         index,
+			 guint         stamp,
+			 const GValue *value)
+{
+	PropertyStore *store;
+	gpointer       slot;
+
+	g_return_if_fail (stamp != 0);
+
+	store = property_get_store (property);
+	property_store_reserve (store, index);
+	property_store_unset_slot (store, index);
+
+	slot = STORE_SLOT (store, index);
+
+	switch (store->kind) {
+	case STORE_INT:
+		*(gint *) slot = g_value_get_int (value);
+		break;
+	case STORE_FLOAT:
+		*(gfloat *) slot = g_value_get_float (value);
+		break;
+	case STORE_TIME:
+		*(mrptime *) slot = g_value_get_int64 (value);
+		break;
+	case STORE_STRING:
+		*(gchar **) slot = g_value_dup_string (value);
+		break;
+	case STORE_VALUE:
+		g_value_init (slot, G_PARAM_SPEC_VALUE_TYPE (G_PARAM_SPEC (property)));
+		g_value_copy (value, slot);
+		break;
+	}
+
+	store->stamps[index] = stamp;
+}
+
+gboolean
+imrp_property_get_value (MrpProperty *property,
+			 guint        index,
+			 guint        stamp,
+			 GValue      *value)
+{
+	PropertyStore *store;
+	gpointer       slot;
+
+	store = property_get_store (property);
+	if (index >= store->n_slots || store->stamps[index] != stamp) {
+		return FALSE;
+	}
+
+	slot = STORE_SLOT (store, index);
+
+	switch (store->kind) {
+	case STORE_INT:
+		g_value_set_int (value, *(gint *) slot);
+		break;
+	case STORE_FLOAT:
+		g_value_set_float (value, *(gfloat *) slot);
+		break;
+	case STORE_TIME:
+		g_value_set_int64 (value, *(mrptime *) slot);
+		break;
+	case STORE_STRING:
+		g_value_set_string (value, *(gchar **) slot);
+		break;
+	case STORE_VALUE:
+		g_value_copy (slot, value);
+		break;
+	}
+
+	return TRUE;
+}
+
+void
+imrp_property_unset_value (MrpProperty *property,
+			   guint        index,
+			   guint        stamp)
+{
+	PropertyStore *store;
+
+	store = property_get_store (property);
+	if (index < store->n_slots && store->stamps[index] == stamp) {
+		property_store_unset_slot (store, index);
+	}
+}
+
+void
+imrp_property_clear_values (MrpProperty *property)
+{
+	PropertyStore *store;
+	guint          i;
+
+	store = property_get_store (property);
+	for (i = 0; i < store->n_slots; i++) {
+		property_store_unset_slot (store, i);
+	}
+}
+
 /**
  * mrp_property_new:
  * @name: the name of the property
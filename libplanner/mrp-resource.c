@@ -65,17 +65,32 @@ struct _MrpResource {
 };
 
 typedef struct {
-	gchar           *name;
-	gchar		*short_name;
+	/* Shared strings, see imrp_string_ref(). */
+	const gchar     *name;
+	const gchar     *short_name;
         MrpGroup        *group;
         MrpResourceType  type;
         gint             units;
-        gchar           *email;
-        gchar           *note;
+        const gchar     *email;
+        const gchar     *note;
 	GList           *assignments;
 
 	MrpCalendar     *calendar;
 	gfloat           cost;
+
+	/* Sorted MrpLoadSegments, rebuilt on demand when load_valid is
+	 * cleared by a change to the assignments or their tasks' dates.
+	 */
+	GArray          *load;
+	gboolean         load_valid;
+
+	/* Sorted MrpLoadSegments of the working time where the load exceeds
+	 * full time. Only kept up to date once they have been asked for, the
+	 * project rebuilds them after scheduling and tells when they changed.
+	 */
+	GArray          *overallocations;
+	gboolean         overallocations_valid;
+	gboolean         overallocations_changed;
 } MrpResourcePrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (MrpResource, mrp_resource, MRP_TYPE_OBJECT)
@@ -98,6 +113,7 @@ enum {
 enum {
 	ASSIGNMENT_ADDED,
 	ASSIGNMENT_REMOVED,
+	OVERALLOCATIONS_CHANGED,
 	LAST_SIGNAL
 };
 
@@ -109,6 +125,9 @@ static void resource_assignment_removed_cb (MrpAssignment    *assignment,
 					    MrpResource      *resource);
 static void resource_group_removed_cb      (MrpGroup         *group,
 					    MrpResource      *resource);
+static void resource_assignment_units_notify_cb (MrpAssignment *assignment,
+						 GParamSpec    *pspec,
+						 MrpResource   *resource);
 
 static guint signals[LAST_SIGNAL];
 
@@ -118,10 +137,10 @@ mrp_resource_finalize (GObject *object)
         MrpResource     *resource = MRP_RESOURCE (object);
 	MrpResourcePrivate *priv = mrp_resource_get_instance_private (resource);
 
-        g_free (priv->name);
-	g_free (priv->short_name);
-        g_free (priv->email);
-        g_free (priv->note);
+	imrp_string_unref (priv->name);
+	imrp_string_unref (priv->short_name);
+	imrp_string_unref (priv->email);
+	imrp_string_unref (priv->note);
 	if (priv->group) {
 		g_object_unref (priv->group);
 	}
@@ -129,6 +148,11 @@ mrp_resource_finalize (GObject *object)
 		g_object_unref (priv->calendar);
 	}
 
+	g_array_free (priv->load, TRUE);
+	if (priv->overallocations) {
+		g_array_free (priv->overallocations, TRUE);
+	}
+
 	G_OBJECT_CLASS (mrp_resource_parent_class)->finalize (object);
 }
 
@@ -141,7 +165,6 @@ mrp_resource_set_property (GObject      *object,
 	MrpResource     *resource;
 	MrpResourcePrivate *priv;
 	gboolean         changed = FALSE;
-	const gchar     *str;
 	gint             i_val;
 	gfloat           f_val;
 	MrpGroup        *group;
@@ -153,21 +176,13 @@ mrp_resource_set_property (GObject      *object,
 
 	switch (prop_id) {
 	case PROP_NAME:
-		str = g_value_get_string (value);
-		if (!priv->name || strcmp (priv->name, str)) {
-			g_free (priv->name);
-			priv->name = g_strdup (str);
-			changed = TRUE;
-		}
+		changed = imrp_string_replace (&priv->name,
+					       g_value_get_string (value));
 		break;
 
 	case PROP_SHORT_NAME:
-		str = g_value_get_string (value);
-		if (!priv->short_name || strcmp (priv->short_name, str)) {
-			g_free (priv->short_name);
-			priv->short_name = g_strdup (str);
-			changed = TRUE;
-		}
+		changed = imrp_string_replace (&priv->short_name,
+					       g_value_get_string (value));
 		break;
 
 	case PROP_GROUP:
@@ -210,23 +225,12 @@ mrp_resource_set_property (GObject      *object,
 		}
 		break;
 	case PROP_EMAIL:
-		str = g_value_get_string (value);
-
-		if (!priv->email || strcmp (priv->email, str)) {
-			g_free (priv->email);
-			priv->email = g_strdup (str);
-			changed = TRUE;
-		}
+		changed = imrp_string_replace (&priv->email,
+					       g_value_get_string (value));
 		break;
 	case PROP_NOTE:
-		str = g_value_get_string (value);
-
-		if (!priv->note || strcmp (priv->note, str)) {
-			g_free (priv->note);
-			priv->note = g_strdup (str);
-			changed = TRUE;
-		}
-
+		changed = imrp_string_replace (&priv->note,
+					       g_value_get_string (value));
 		break;
 	case PROP_CALENDAR:
 		calendar = g_value_get_pointer (value);
@@ -254,6 +258,7 @@ mrp_resource_set_property (GObject      *object,
 		}
 
 		priv->calendar = calendar;
+		imrp_resource_invalidate_load (resource);
 
 		/* Make sure the project is rescheduled if necessary. */
 		if (priv->assignments) {
@@ -337,6 +342,9 @@ resource_remove_assignment_foreach (MrpAssignment *assignment,
 	g_signal_handlers_disconnect_by_func (MRP_OBJECT (assignment),
 					      resource_assignment_removed_cb,
 					      resource);
+	g_signal_handlers_disconnect_by_func (MRP_OBJECT (assignment),
+					      resource_assignment_units_notify_cb,
+					      resource);
 
 	g_object_unref (assignment);
 
@@ -360,6 +368,7 @@ mrp_resource_removed (MrpObject *object)
 
 	g_list_free (priv->assignments);
 	priv->assignments = NULL;
+	imrp_resource_invalidate_load (resource);
 
 	if (MRP_OBJECT_CLASS (mrp_resource_parent_class)->removed)
 		MRP_OBJECT_CLASS (mrp_resource_parent_class)->removed (object);
@@ -484,6 +493,23 @@ mrp_resource_class_init (MrpResourceClass *klass)
 			      mrp_marshal_VOID__OBJECT,
 			      G_TYPE_NONE,
 			      1, MRP_TYPE_ASSIGNMENT);
+
+    /**
+     * MrpResource::overallocations-changed:
+     * @resource: the object which received the signal.
+     *
+     * emitted after scheduling when the periods where @resource is
+     * overallocated have changed, see
+     * mrp_resource_get_overallocated_periods().
+     */
+	signals[OVERALLOCATIONS_CHANGED] =
+		g_signal_new ("overallocations_changed",
+			      G_TYPE_FROM_CLASS (klass),
+			      G_SIGNAL_RUN_LAST,
+			      0,
+			      NULL, NULL,
+			      mrp_marshal_VOID__VOID,
+			      G_TYPE_NONE, 0);
 }
 
 static void
@@ -493,11 +519,12 @@ mrp_resource_init (MrpResource *resource)
 
 	priv->assignments = NULL;
 	priv->type        = MRP_RESOURCE_TYPE_NONE;
-        priv->name        = g_strdup ("");
-	priv->short_name    = g_strdup ("");
+	priv->name        = "";
+	priv->short_name  = "";
 	priv->group       = NULL;
-	priv->email       = g_strdup ("");
-	priv->note        = g_strdup ("");
+	priv->email       = "";
+	priv->note        = "";
+	priv->load        = g_array_new (FALSE, FALSE, sizeof (MrpLoadSegment));
 }
 
 static void
@@ -506,6 +533,9 @@ resource_calendar_changed (MrpCalendar *calendar,
 {
 	MrpProject *project;
 
+	/* The working time changes even if no task moves. */
+	imrp_resource_invalidate_load (resource);
+
 	project = mrp_object_get_project (MRP_OBJECT (resource));
 
 	if (!project) {
@@ -552,6 +582,11 @@ resource_assignment_removed_cb (MrpAssignment *assignment,
 	}
 
 	priv->assignments = g_list_remove (priv->assignments, assignment);
+	imrp_resource_invalidate_load (resource);
+
+	g_signal_handlers_disconnect_by_func (assignment,
+					      resource_assignment_units_notify_cb,
+					      resource);
 
 	g_signal_emit (resource, signals[ASSIGNMENT_REMOVED],
 		       0,
@@ -562,6 +597,14 @@ resource_assignment_removed_cb (MrpAssignment *assignment,
 	mrp_object_changed (MRP_OBJECT (resource));
 }
 
+static void
+resource_assignment_units_notify_cb (MrpAssignment *assignment,
+				     GParamSpec    *pspec,
+				     MrpResource   *resource)
+{
+	imrp_resource_invalidate_load (resource);
+}
+
 static void
 resource_invalidate_task_costs (MrpResource *resource)
 {
@@ -595,6 +638,12 @@ imrp_resource_add_assignment (MrpResource *resource, MrpAssignment *assignment)
 			  "removed",
 			  G_CALLBACK (resource_assignment_removed_cb),
 			  resource);
+	g_signal_connect (G_OBJECT (assignment),
+			  "notify::units",
+			  G_CALLBACK (resource_assignment_units_notify_cb),
+			  resource);
+
+	imrp_resource_invalidate_load (resource);
 
 	g_signal_emit (resource, signals[ASSIGNMENT_ADDED], 0, assignment);
 
@@ -821,3 +870,461 @@ mrp_resource_set_calendar (MrpResource *resource, MrpCalendar *calendar)
 
 	g_object_set (resource, "calendar", calendar, NULL);
 }
+
+/**
+ * mrp_resource_get_cost:
+ * @resource: an #MrpResource
+ *
+ * Retrieves the standard rate of @resource, the cost of an hour of work.
+ *
+ * Return value: the cost per hour of @resource.
+ **/
+gfloat
+mrp_resource_get_cost (MrpResource *resource)
+{
+	MrpResourcePrivate *priv = mrp_resource_get_instance_private (resource);
+
+	g_return_val_if_fail (MRP_IS_RESOURCE (resource), 0);
+
+	return priv->cost;
+}
+
+/* Marks the load profile of @resource as out of date. Called when one of its
+ * assignments changes units, a task it's assigned to changes dates or its
+ * working time changes.
+ */
+void
+imrp_resource_invalidate_load (MrpResource *resource)
+{
+	MrpResourcePrivate *priv = mrp_resource_get_instance_private (resource);
+	MrpProject         *project;
+
+	g_return_if_fail (MRP_IS_RESOURCE (resource));
+
+	priv->load_valid = FALSE;
+
+	if (priv->overallocations_valid) {
+		priv->overallocations_valid = FALSE;
+
+		project = mrp_object_get_project (MRP_OBJECT (resource));
+		if (project) {
+			imrp_project_queue_overallocation_check (project, resource);
+		}
+	}
+}
+
+typedef struct {
+	mrptime time;
+	gint    units;
+} LoadEvent;
+
+static gint
+resource_load_event_compare (gconstpointer a, gconstpointer b)
+{
+	const LoadEvent *event_a = a;
+	const LoadEvent *event_b = b;
+
+	if (event_a->time < event_b->time) {
+		return -1;
+	}
+	else if (event_a->time > event_b->time) {
+		return 1;
+	}
+
+	return 0;
+}
+
+static void
+resource_build_load (MrpResource *resource)
+{
+	MrpResourcePrivate *priv = mrp_resource_get_instance_private (resource);
+	GArray             *events;
+	GList              *l;
+	MrpAssignment      *assignment;
+	MrpTask            *task;
+	LoadEvent           event;
+	LoadEvent          *e;
+	MrpLoadSegment      segment;
+	MrpLoadSegment     *last;
+	mrptime             start, finish;
+	gint                units;
+	guint               i;
+
+	g_array_set_size (priv->load, 0);
+	priv->load_valid = TRUE;
+
+	events = g_array_new (FALSE, FALSE, sizeof (LoadEvent));
+
+	for (l = priv->assignments; l; l = l->next) {
+		assignment = l->data;
+		task = mrp_assignment_get_task (assignment);
+
+		start = mrp_task_get_work_start (task);
+		finish = mrp_task_get_finish (task);
+		units = mrp_assignment_get_units (assignment);
+
+		if (start >= finish || units == 0) {
+			continue;
+		}
+
+		event.time = start;
+		event.units = units;
+		g_array_append_val (events, event);
+
+		event.time = finish;
+		event.units = -units;
+		g_array_append_val (events, event);
+	}
+
+	g_array_sort (events, resource_load_event_compare);
+
+	/* Sweep the events, adding one segment per run of equal load. */
+	units = 0;
+	for (i = 0; i < events->len; i++) {
+		e = &g_array_index (events, LoadEvent, i);
+
+		if (i > 0 && e->time > e[-1].time) {
+			last = priv->load->len > 0 ?
+				&g_array_index (priv->load, MrpLoadSegment,
+						priv->load->len - 1) : NULL;
+
+			if (last && last->units == units && last->end == e[-1].time) {
+				last->end = e->time;
+			} else {
+				segment.start = e[-1].time;
+				segment.end = e->time;
+				segment.units = units;
+				g_array_append_val (priv->load, segment);
+			}
+		}
+
+		units += e->units;
+	}
+
+	g_array_free (events, TRUE);
+}
+
+/**
+ * mrp_resource_get_load_profile:
+ * @resource: an #MrpResource
+ *
+ * Retrieves the load of @resource over time, as a step function of the units
+ * assigned to it. The array holds #MrpLoadSegment structs sorted by time,
+ * covering the time from the start of the first assignment to the end of the
+ * last one without gaps, where adjacent segments have different units.
+ *
+ * The profile is computed on the first call after the assignments of
+ * @resource or the dates of their tasks change, and cached until then.
+ *
+ * Return value: the load profile, owned by @resource. It must not be
+ * modified or freed and is only valid until the resource changes.
+ **/
+GArray *
+mrp_resource_get_load_profile (MrpResource *resource)
+{
+	MrpResourcePrivate *priv;
+
+	g_return_val_if_fail (MRP_IS_RESOURCE (resource), NULL);
+
+	priv = mrp_resource_get_instance_private (resource);
+
+	if (!priv->load_valid) {
+		resource_build_load (resource);
+	}
+
+	return priv->load;
+}
+
+/* Finds the first working time in @calendar between @start and @end, or
+ * @start without a calendar. Only the days up to the first working interval
+ * are looked at, the rest of the range is stepped over.
+ */
+static gboolean
+resource_find_first_work (MrpCalendar *calendar,
+			  mrptime      start,
+			  mrptime      end,
+			  mrptime     *first)
+{
+	MrpDay  *day;
+	GList   *l;
+	mrptime  date;
+	mrptime  i_start, i_end;
+
+	if (!calendar) {
+		*first = start;
+		return start < end;
+	}
+
+	for (date = mrp_time_align_day (start); date < end; date += 24 * 60 * 60) {
+		day = mrp_calendar_get_day (calendar, date, TRUE);
+
+		for (l = mrp_calendar_day_get_intervals (calendar, day, TRUE); l; l = l->next) {
+			mrp_interval_get_absolute (l->data, date, &i_start, &i_end);
+
+			i_start = MAX (i_start, start);
+			i_end = MIN (i_end, end);
+
+			if (i_end > i_start) {
+				*first = i_start;
+				return TRUE;
+			}
+		}
+	}
+
+	return FALSE;
+}
+
+/* Like resource_find_first_work(), the end of the last working interval,
+ * looking back from @end.
+ */
+static gboolean
+resource_find_last_work (MrpCalendar *calendar,
+			 mrptime      start,
+			 mrptime      end,
+			 mrptime     *last)
+{
+	MrpDay   *day;
+	GList    *l;
+	mrptime   date;
+	mrptime   i_start, i_end;
+	gboolean  found;
+
+	if (!calendar) {
+		*last = end;
+		return start < end;
+	}
+
+	for (date = mrp_time_align_day (end - 1); date + 24 * 60 * 60 > start; date -= 24 * 60 * 60) {
+		day = mrp_calendar_get_day (calendar, date, TRUE);
+
+		found = FALSE;
+		for (l = mrp_calendar_day_get_intervals (calendar, day, TRUE); l; l = l->next) {
+			mrp_interval_get_absolute (l->data, date, &i_start, &i_end);
+
+			i_start = MAX (i_start, start);
+			i_end = MIN (i_end, end);
+
+			if (i_end > i_start) {
+				*last = i_end;
+				found = TRUE;
+			}
+		}
+
+		if (found) {
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static gboolean
+resource_periods_equal (GArray *a, GArray *b)
+{
+	MrpLoadSegment *sa, *sb;
+	guint           i;
+
+	if (a->len != b->len) {
+		return FALSE;
+	}
+
+	/* Field by field, the padding of the struct isn't initialized. */
+	for (i = 0; i < a->len; i++) {
+		sa = &g_array_index (a, MrpLoadSegment, i);
+		sb = &g_array_index (b, MrpLoadSegment, i);
+
+		if (sa->start != sb->start ||
+		    sa->end != sb->end ||
+		    sa->units != sb->units) {
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/* Collects the segments of the load profile above full time, trimmed to the
+ * working time of the resource. Overallocations that are only apart by time
+ * off are joined.
+ *
+ * Only the non-working days at the edges of each period are looked at, one
+ * search forward from the end of the previous period finds both whether
+ * there is work in between and where the next period starts. The working
+ * days inside a period are never visited, so a long overallocation costs
+ * no more than a short one.
+ */
+static void
+resource_build_overallocations (MrpResource *resource)
+{
+	MrpResourcePrivate *priv = mrp_resource_get_instance_private (resource);
+	MrpProject         *project;
+	MrpCalendar        *calendar;
+	GArray             *load;
+	GArray             *periods;
+	MrpLoadSegment     *segment;
+	MrpLoadSegment     *last;
+	MrpLoadSegment      period;
+	mrptime             first;
+	guint               i;
+
+	calendar = priv->calendar;
+	if (!calendar) {
+		project = mrp_object_get_project (MRP_OBJECT (resource));
+		if (project) {
+			calendar = mrp_project_get_calendar (project);
+		}
+	}
+
+	load = mrp_resource_get_load_profile (resource);
+	periods = g_array_new (FALSE, FALSE, sizeof (MrpLoadSegment));
+
+	for (i = 0; i < load->len; i++) {
+		segment = &g_array_index (load, MrpLoadSegment, i);
+
+		if (segment->units <= 100) {
+			continue;
+		}
+
+		last = periods->len > 0 ?
+			&g_array_index (periods, MrpLoadSegment, periods->len - 1) : NULL;
+
+		/* Searching from the end of the previous period, work found
+		 * before this segment means the two are apart.
+		 */
+		if (!resource_find_first_work (calendar,
+					       last ? last->end : segment->start,
+					       segment->end,
+					       &first)) {
+			continue;
+		}
+
+		if (last && first >= segment->start) {
+			resource_find_last_work (calendar, first, segment->end, &last->end);
+			last->units = MAX (last->units, segment->units);
+			continue;
+		}
+
+		if (first < segment->start) {
+			if (!resource_find_first_work (calendar, segment->start,
+						       segment->end, &first)) {
+				continue;
+			}
+		}
+
+		period.start = first;
+		resource_find_last_work (calendar, first, segment->end, &period.end);
+		period.units = segment->units;
+
+		g_array_append_val (periods, period);
+	}
+
+	if (priv->overallocations) {
+		if (!resource_periods_equal (priv->overallocations, periods)) {
+			priv->overallocations_changed = TRUE;
+		}
+
+		g_array_free (priv->overallocations, TRUE);
+	}
+
+	priv->overallocations = periods;
+	priv->overallocations_valid = TRUE;
+}
+
+/* Called by the project after scheduling for the resources whose load was
+ * invalidated since their overallocations were last asked for.
+ */
+void
+imrp_resource_check_overallocations (MrpResource *resource)
+{
+	MrpResourcePrivate *priv = mrp_resource_get_instance_private (resource);
+
+	g_return_if_fail (MRP_IS_RESOURCE (resource));
+
+	if (!priv->overallocations_valid) {
+		resource_build_overallocations (resource);
+	}
+
+	if (priv->overallocations_changed) {
+		priv->overallocations_changed = FALSE;
+		g_signal_emit (resource, signals[OVERALLOCATIONS_CHANGED], 0);
+	}
+}
+
+/**
+ * mrp_resource_get_overallocated_periods:
+ * @resource: an #MrpResource
+ *
+ * Retrieves the periods where @resource is assigned more than full time
+ * during its working time, following the calendar of the resource or else
+ * the one of the project. The array holds #MrpLoadSegment structs sorted by
+ * time, with the highest load of each period in @units. Periods that are
+ * only apart by non-working time are joined.
+ *
+ * Once this has been called, the periods are rebuilt after each scheduling
+ * pass that moved tasks of @resource, and
+ * #MrpResource::overallocations-changed is emitted when they differ.
+ *
+ * Return value: the periods, owned by @resource. It must not be modified or
+ * freed and is only valid until the resource changes.
+ **/
+GArray *
+mrp_resource_get_overallocated_periods (MrpResource *resource)
+{
+	MrpResourcePrivate *priv;
+
+	g_return_val_if_fail (MRP_IS_RESOURCE (resource), NULL);
+
+	priv = mrp_resource_get_instance_private (resource);
+
+	if (!priv->overallocations_valid) {
+		resource_build_overallocations (resource);
+	}
+
+	return priv->overallocations;
+}
+
+/**
+ * mrp_resource_is_overallocated:
+ * @resource: an #MrpResource
+ * @start: the start of the range
+ * @finish: the end of the range
+ *
+ * Checks whether @resource is overallocated anywhere between @start and
+ * @finish, see mrp_resource_get_overallocated_periods().
+ *
+ * Return value: %TRUE if an overallocated period overlaps the range.
+ **/
+gboolean
+mrp_resource_is_overallocated (MrpResource *resource,
+			       mrptime      start,
+			       mrptime      finish)
+{
+	GArray         *periods;
+	MrpLoadSegment *period;
+	guint           low, high, mid;
+
+	g_return_val_if_fail (MRP_IS_RESOURCE (resource), FALSE);
+
+	periods = mrp_resource_get_overallocated_periods (resource);
+
+	/* Find the first period that ends after the start. */
+	low = 0;
+	high = periods->len;
+	while (low < high) {
+		mid = (low + high) / 2;
+
+		if (g_array_index (periods, MrpLoadSegment, mid).end <= start) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	if (low == periods->len) {
+		return FALSE;
+	}
+
+	period = &g_array_index (periods, MrpLoadSegment, low);
+
+	return period->start < finish;
+}
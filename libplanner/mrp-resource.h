@@ -47,6 +47,21 @@ typedef enum {
 	MRP_RESOURCE_TYPE_MATERIAL
 } MrpResourceType;
 
+/**
+ * MrpLoadSegment:
+ * @start: the start of the segment
+ * @end: the end of the segment
+ * @units: the sum of the units of all assignments running during the segment
+ *
+ * A piece of the load profile of a resource, see
+ * mrp_resource_get_load_profile().
+ */
+typedef struct {
+	mrptime start;
+	mrptime end;
+	gint    units;
+} MrpLoadSegment;
+
 MrpResource *mrp_resource_new                (void);
 const gchar *mrp_resource_get_name           (MrpResource   *resource);
 void         mrp_resource_set_name           (MrpResource   *resource,
@@ -64,5 +79,11 @@ gint         mrp_resource_compare            (gconstpointer  a,
 MrpCalendar *mrp_resource_get_calendar       (MrpResource   *resource);
 void         mrp_resource_set_calendar       (MrpResource   *resource,
                                               MrpCalendar   *calendar);
+gfloat       mrp_resource_get_cost           (MrpResource   *resource);
+GArray      *mrp_resource_get_load_profile   (MrpResource   *resource);
+GArray      *mrp_resource_get_overallocated_periods (MrpResource *resource);
+gboolean     mrp_resource_is_overallocated   (MrpResource   *resource,
+                                              mrptime        start,
+                                              mrptime        finish);
 
 G_END_DECLS
@@ -0,0 +1,630 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Schedule risk analysis. The task tree is copied once into flat arrays in
+ * scheduling order, with all times converted to working time since the
+ * project start, so that an iteration is a plain forward pass over integers
+ * without objects, notifications or calendars. Each iteration draws the task
+ * durations from triangular distributions, schedules the tasks and follows
+ * the driving predecessors back from the project finish to find the critical
+ * tasks. Iterations run in chunks on a thread pool, each chunk with its own
+ * random generator seeded from the chunk number.
+ */
+
+#include <config.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mrp-private.h"
+#include "mrp-relation.h"
+#include "mrp-risk.h"
+
+/* Chunks are fixed in size so that the seeds don't depend on the number of
+ * threads.
+ */
+#define ITERATIONS_PER_CHUNK 256
+
+typedef struct {
+	gint             pred;
+	MrpRelationType  type;
+	gint             lag;
+} RiskEdge;
+
+typedef struct {
+	gint               parent;
+
+	/* Children of summaries, in the children array. */
+	guint              first_child;
+	guint              n_children;
+
+	/* Relations of leaves and their ancestors, in the edges array. */
+	guint              first_edge;
+	guint              n_edges;
+
+	gint               optimistic;
+	gint               likely;
+	gint               pessimistic;
+
+	MrpConstraintType  constraint;
+	gint               constraint_time;
+} RiskNode;
+
+typedef struct {
+	guint     first;
+	guint     n;
+	guint32   seed;
+	guint    *critical;
+} RiskChunk;
+
+struct _MrpRiskAnalysis {
+	MrpProject  *project;
+	mrptime      project_start;
+
+	GHashTable  *indices;
+	RiskNode    *nodes;
+	guint        n_nodes;
+	RiskEdge    *edges;
+	guint       *children;
+
+	gint         iterations;
+
+	/* Project finish of each iteration, sorted after a run. */
+	gint        *finishes;
+
+	/* Number of iterations each task was critical in. */
+	guint       *critical;
+	GMutex       lock;
+};
+
+static gint
+risk_analysis_work_between (MrpRiskAnalysis *analysis,
+			    MrpTask         *task,
+			    mrptime          t1,
+			    mrptime          t2)
+{
+	if (t1 <= t2) {
+		return mrp_project_calculate_summary_duration (analysis->project,
+							       task, t1, t2);
+	} else {
+		return -mrp_project_calculate_summary_duration (analysis->project,
+								task, t2, t1);
+	}
+}
+
+static gint
+risk_analysis_get_estimate (MrpProject  *project,
+			    MrpTask     *task,
+			    const gchar *name)
+{
+	gint value = 0;
+
+	if (mrp_project_has_property (project, MRP_TYPE_TASK, name)) {
+		mrp_object_get (task, name, &value, NULL);
+	}
+
+	return value;
+}
+
+/**
+ * mrp_risk_analysis_new:
+ * @project: an #MrpProject
+ *
+ * Takes a snapshot of the tasks of @project for a risk analysis, with the
+ * three point estimates from the %MRP_RISK_PROPERTY_OPTIMISTIC,
+ * %MRP_RISK_PROPERTY_LIKELY and %MRP_RISK_PROPERTY_PESSIMISTIC task
+ * properties. Later changes to the project don't affect the analysis.
+ * Durations and lags are taken in the project calendar.
+ *
+ * Return value: a new #MrpRiskAnalysis, free with mrp_risk_analysis_free().
+ **/
+MrpRiskAnalysis *
+mrp_risk_analysis_new (MrpProject *project)
+{
+	MrpRiskAnalysis *analysis;
+	MrpTaskManager  *manager;
+	MrpTask         *root;
+	MrpTask         *task, *tmp_task;
+	MrpTask         *predecessor;
+	MrpRelation     *relation;
+	MrpConstraint    constraint;
+	RiskNode        *node;
+	RiskEdge        *edge;
+	GArray          *edges;
+	GList           *tasks, *l, *r;
+	mrptime          base;
+	gint             likely;
+	guint            n_children;
+	guint            i;
+
+	g_return_val_if_fail (MRP_IS_PROJECT (project), NULL);
+
+	analysis = g_new0 (MrpRiskAnalysis, 1);
+	analysis->project = g_object_ref (project);
+	analysis->project_start = mrp_project_get_project_start (project);
+	analysis->indices = g_hash_table_new (NULL, NULL);
+	g_mutex_init (&analysis->lock);
+
+	root = mrp_project_get_root_task (project);
+	manager = imrp_project_get_task_manager (project);
+
+	tasks = NULL;
+	for (l = imrp_task_manager_peek_dependency_list (manager); l; l = l->next) {
+		if (l->data != root) {
+			tasks = g_list_prepend (tasks, l->data);
+		}
+	}
+	tasks = g_list_reverse (tasks);
+
+	analysis->n_nodes = g_list_length (tasks);
+	analysis->nodes = g_new0 (RiskNode, analysis->n_nodes);
+	analysis->children = g_new (guint, analysis->n_nodes);
+	analysis->critical = g_new0 (guint, analysis->n_nodes);
+
+	for (l = tasks, i = 0; l; l = l->next, i++) {
+		g_hash_table_insert (analysis->indices, l->data, GUINT_TO_POINTER (i));
+	}
+
+	edges = g_array_new (FALSE, FALSE, sizeof (RiskEdge));
+	n_children = 0;
+
+	for (l = tasks, i = 0; l; l = l->next, i++) {
+		task = l->data;
+		node = &analysis->nodes[i];
+
+		tmp_task = mrp_task_get_parent (task);
+		if (tmp_task && tmp_task != root) {
+			node->parent = GPOINTER_TO_UINT (g_hash_table_lookup (analysis->indices, tmp_task));
+		} else {
+			node->parent = -1;
+		}
+
+		if (mrp_task_get_n_children (task) > 0) {
+			/* Summary dates follow from the children, which come
+			 * before it.
+			 */
+			node->first_child = n_children;
+			for (tmp_task = mrp_task_get_first_child (task);
+			     tmp_task;
+			     tmp_task = mrp_task_get_next_sibling (tmp_task)) {
+				analysis->children[n_children++] =
+					GPOINTER_TO_UINT (g_hash_table_lookup (analysis->indices, tmp_task));
+				node->n_children++;
+			}
+			continue;
+		}
+
+		if (mrp_task_get_task_type (task) != MRP_TASK_TYPE_MILESTONE) {
+			likely = risk_analysis_get_estimate (project, task, MRP_RISK_PROPERTY_LIKELY);
+			if (likely <= 0) {
+				likely = mrp_task_get_duration (task);
+			}
+
+			node->likely = likely;
+			node->optimistic = risk_analysis_get_estimate (project, task, MRP_RISK_PROPERTY_OPTIMISTIC);
+			node->pessimistic = risk_analysis_get_estimate (project, task, MRP_RISK_PROPERTY_PESSIMISTIC);
+
+			node->optimistic = node->optimistic > 0 ? MIN (node->optimistic, likely) : likely;
+			node->pessimistic = MAX (node->pessimistic, likely);
+		}
+
+		constraint = imrp_task_get_constraint (task);
+		node->constraint = constraint.type;
+		node->constraint_time = risk_analysis_work_between (analysis, task,
+								    analysis->project_start,
+								    MAX (constraint.time, analysis->project_start));
+
+		/* The relations of the ancestors apply to the leaves too. */
+		node->first_edge = edges->len;
+		for (tmp_task = task; tmp_task != root; tmp_task = mrp_task_get_parent (tmp_task)) {
+			for (r = imrp_task_peek_predecessors (tmp_task); r; r = r->next) {
+				relation = r->data;
+				predecessor = mrp_relation_get_predecessor (relation);
+
+				g_array_set_size (edges, edges->len + 1);
+				edge = &g_array_index (edges, RiskEdge, edges->len - 1);
+
+				edge->pred = GPOINTER_TO_UINT (g_hash_table_lookup (analysis->indices, predecessor));
+				edge->type = mrp_relation_get_relation_type (relation);
+
+				switch (edge->type) {
+				case MRP_RELATION_SS:
+				case MRP_RELATION_SF:
+					base = mrp_task_get_start (predecessor);
+					break;
+				default:
+					base = mrp_task_get_finish (predecessor);
+					break;
+				}
+
+				edge->lag = risk_analysis_work_between (analysis, task, base,
+									base + mrp_relation_get_lag (relation));
+			}
+		}
+		node->n_edges = edges->len - node->first_edge;
+	}
+
+	analysis->edges = (RiskEdge *) g_array_free (edges, FALSE);
+
+	g_list_free (tasks);
+
+	return analysis;
+}
+
+/**
+ * mrp_risk_analysis_free:
+ * @analysis: an #MrpRiskAnalysis
+ *
+ * Frees @analysis and its results.
+ **/
+void
+mrp_risk_analysis_free (MrpRiskAnalysis *analysis)
+{
+	g_return_if_fail (analysis != NULL);
+
+	g_object_unref (analysis->project);
+	g_hash_table_destroy (analysis->indices);
+	g_mutex_clear (&analysis->lock);
+	g_free (analysis->nodes);
+	g_free (analysis->edges);
+	g_free (analysis->children);
+	g_free (analysis->finishes);
+	g_free (analysis->critical);
+	g_free (analysis);
+}
+
+static gint
+risk_analysis_sample (const RiskNode *node,
+		      GRand          *rand)
+{
+	gdouble a, m, b;
+	gdouble u;
+
+	if (node->optimistic == node->pessimistic) {
+		return node->likely;
+	}
+
+	a = node->optimistic;
+	m = node->likely;
+	b = node->pessimistic;
+	u = g_rand_double (rand);
+
+	/* Inverse of the triangular distribution function. */
+	if (u < (m - a) / (b - a)) {
+		return a + sqrt (u * (b - a) * (m - a));
+	} else {
+		return b - sqrt ((1 - u) * (b - a) * (b - m));
+	}
+}
+
+static void
+risk_analysis_run_chunk (gpointer data,
+			 gpointer user_data)
+{
+	MrpRiskAnalysis *analysis = user_data;
+	RiskChunk       *chunk = data;
+	const RiskNode  *node;
+	const RiskEdge  *edge;
+	GRand           *rand;
+	guint            n = analysis->n_nodes;
+	gint            *es, *ef, *driver, *start_child, *finish_child, *marked;
+	gint             start, dep_start, d;
+	gint             finish, last;
+	gint             i, j, k, c;
+	gboolean         at_finish;
+
+	rand = g_rand_new_with_seed (chunk->seed);
+
+	/* All the memory an iteration needs. */
+	es = g_new (gint, n);
+	ef = g_new (gint, n);
+	driver = g_new (gint, n);
+	start_child = g_new (gint, n);
+	finish_child = g_new (gint, n);
+	marked = g_new (gint, n);
+	for (i = 0; i < (gint) n; i++) {
+		marked[i] = -1;
+	}
+
+	for (k = 0; k < (gint) chunk->n; k++) {
+		finish = 0;
+		last = -1;
+
+		for (i = 0; i < (gint) n; i++) {
+			node = &analysis->nodes[i];
+
+			if (node->n_children > 0) {
+				for (j = 0; j < (gint) node->n_children; j++) {
+					c = analysis->children[node->first_child + j];
+
+					if (j == 0 || es[c] < es[i]) {
+						es[i] = es[c];
+						start_child[i] = c;
+					}
+					if (j == 0 || ef[c] > ef[i]) {
+						ef[i] = ef[c];
+						finish_child[i] = c;
+					}
+				}
+			} else {
+				d = risk_analysis_sample (node, rand);
+
+				start = 0;
+				driver[i] = -1;
+
+				if (node->constraint == MRP_CONSTRAINT_MSO) {
+					start = node->constraint_time;
+				} else {
+					for (j = 0; j < (gint) node->n_edges; j++) {
+						edge = &analysis->edges[node->first_edge + j];
+
+						switch (edge->type) {
+						case MRP_RELATION_FF:
+							dep_start = ef[edge->pred] + edge->lag - d;
+							break;
+						case MRP_RELATION_SF:
+							dep_start = es[edge->pred] + edge->lag - d;
+							break;
+						case MRP_RELATION_SS:
+							dep_start = es[edge->pred] + edge->lag;
+							break;
+						default:
+							dep_start = ef[edge->pred] + edge->lag;
+							break;
+						}
+
+						if (dep_start > start) {
+							start = dep_start;
+							driver[i] = node->first_edge + j;
+						}
+					}
+
+					if (node->constraint == MRP_CONSTRAINT_SNET &&
+					    node->constraint_time > start) {
+						start = node->constraint_time;
+						driver[i] = -1;
+					}
+				}
+
+				es[i] = start;
+				ef[i] = start + d;
+			}
+
+			if (node->parent == -1 && (last == -1 || ef[i] > finish)) {
+				finish = ef[i];
+				last = i;
+			}
+		}
+
+		analysis->finishes[chunk->first + k] = finish;
+
+		/* Follow the driving relations back from the finish. */
+		at_finish = TRUE;
+		i = last;
+		while (i != -1) {
+			node = &analysis->nodes[i];
+
+			if (node->n_children > 0) {
+				i = at_finish ? finish_child[i] : start_child[i];
+				continue;
+			}
+
+			for (j = i; j != -1 && marked[j] != k; j = analysis->nodes[j].parent) {
+				marked[j] = k;
+				chunk->critical[j]++;
+			}
+
+			if (driver[i] == -1) {
+				break;
+			}
+
+			edge = &analysis->edges[driver[i]];
+			at_finish = edge->type == MRP_RELATION_FS ||
+				    edge->type == MRP_RELATION_FF ||
+				    edge->type == MRP_RELATION_NONE;
+			i = edge->pred;
+		}
+	}
+
+	g_mutex_lock (&analysis->lock);
+	for (i = 0; i < (gint) n; i++) {
+		analysis->critical[i] += chunk->critical[i];
+	}
+	g_mutex_unlock (&analysis->lock);
+
+	g_free (es);
+	g_free (ef);
+	g_free (driver);
+	g_free (start_child);
+	g_free (finish_child);
+	g_free (marked);
+	g_free (chunk->critical);
+	g_free (chunk);
+	g_rand_free (rand);
+}
+
+static gint
+risk_analysis_compare_finish (gconstpointer a,
+			      gconstpointer b)
+{
+	gint finish_a = *(const gint *) a;
+	gint finish_b = *(const gint *) b;
+
+	return finish_a < finish_b ? -1 : (finish_a > finish_b);
+}
+
+/**
+ * mrp_risk_analysis_run:
+ * @analysis: an #MrpRiskAnalysis
+ * @iterations: the number of schedules to simulate
+ * @seed: the seed for the random durations
+ *
+ * Simulates @iterations schedules, spread over one thread per processor,
+ * replacing the results of any earlier run. The results only depend on the
+ * snapshot, @iterations and @seed.
+ **/
+void
+mrp_risk_analysis_run (MrpRiskAnalysis *analysis,
+		       gint             iterations,
+		       guint32          seed)
+{
+	GThreadPool *pool;
+	RiskChunk   *chunk;
+	guint        first;
+
+	g_return_if_fail (analysis != NULL);
+	g_return_if_fail (iterations > 0);
+
+	analysis->iterations = iterations;
+
+	g_free (analysis->finishes);
+	analysis->finishes = g_new0 (gint, iterations);
+	memset (analysis->critical, 0, analysis->n_nodes * sizeof (guint));
+
+	pool = g_thread_pool_new (risk_analysis_run_chunk, analysis,
+				  g_get_num_processors (), FALSE, NULL);
+
+	for (first = 0; first < (guint) iterations; first += ITERATIONS_PER_CHUNK) {
+		chunk = g_new (RiskChunk, 1);
+		chunk->first = first;
+		chunk->n = MIN (ITERATIONS_PER_CHUNK, iterations - first);
+		chunk->seed = seed + first / ITERATIONS_PER_CHUNK;
+		chunk->critical = g_new0 (guint, analysis->n_nodes);
+
+		g_thread_pool_push (pool, chunk, NULL);
+	}
+
+	g_thread_pool_free (pool, FALSE, TRUE);
+
+	qsort (analysis->finishes, iterations, sizeof (gint),
+	       risk_analysis_compare_finish);
+}
+
+/**
+ * mrp_risk_analysis_get_iterations:
+ * @analysis: an #MrpRiskAnalysis
+ *
+ * Retrieves the number of iterations of the last run.
+ *
+ * Return value: the number of iterations, 0 before the first run.
+ **/
+gint
+mrp_risk_analysis_get_iterations (MrpRiskAnalysis *analysis)
+{
+	g_return_val_if_fail (analysis != NULL, 0);
+
+	return analysis->iterations;
+}
+
+/* Converts working time since the project start to a date. */
+static mrptime
+risk_analysis_get_date (MrpRiskAnalysis *analysis,
+			gint             work)
+{
+	MrpCalendar *calendar;
+	MrpDay      *day;
+	GList       *ivals, *l;
+	mrptime      t, t1, t2;
+	gint         idle_days;
+
+	if (work <= 0) {
+		return analysis->project_start;
+	}
+
+	calendar = mrp_project_get_calendar (analysis->project);
+
+	/* Give up after a year without working time. */
+	idle_days = 0;
+	for (t = mrp_time_align_day (analysis->project_start); idle_days < 366; t += 24*60*60) {
+		day = mrp_calendar_get_day (calendar, t, TRUE);
+		ivals = mrp_calendar_day_get_intervals (calendar, day, TRUE);
+
+		idle_days++;
+		for (l = ivals; l; l = l->next) {
+			mrp_interval_get_absolute (l->data, t, &t1, &t2);
+
+			t1 = MAX (t1, analysis->project_start);
+			if (t2 <= t1) {
+				continue;
+			}
+
+			idle_days = 0;
+			if (work <= t2 - t1) {
+				return t1 + work;
+			}
+			work -= t2 - t1;
+		}
+	}
+
+	return t;
+}
+
+/**
+ * mrp_risk_analysis_get_finish_percentile:
+ * @analysis: an #MrpRiskAnalysis
+ * @percentile: a percentile between 0 and 100
+ *
+ * Retrieves the project finish that the given percentage of the simulated
+ * schedules finished by, in the last run.
+ *
+ * Return value: the finish date, or the project start before the first run.
+ **/
+mrptime
+mrp_risk_analysis_get_finish_percentile (MrpRiskAnalysis *analysis,
+					 gdouble          percentile)
+{
+	gint index;
+
+	g_return_val_if_fail (analysis != NULL, 0);
+	g_return_val_if_fail (percentile >= 0 && percentile <= 100, 0);
+
+	if (analysis->iterations == 0) {
+		return analysis->project_start;
+	}
+
+	index = floor (0.5 + percentile / 100 * (analysis->iterations - 1));
+
+	return risk_analysis_get_date (analysis, analysis->finishes[index]);
+}
+
+/**
+ * mrp_risk_analysis_get_criticality:
+ * @analysis: an #MrpRiskAnalysis
+ * @task: an #MrpTask of the project
+ *
+ * Retrieves the criticality index of @task, the part of the simulated
+ * schedules in the last run where it was on the critical path. A summary
+ * task is critical when any of its subtasks is.
+ *
+ * Return value: the criticality index between 0 and 1.
+ **/
+gdouble
+mrp_risk_analysis_get_criticality (MrpRiskAnalysis *analysis,
+				   MrpTask         *task)
+{
+	gpointer index;
+
+	g_return_val_if_fail (analysis != NULL, 0);
+	g_return_val_if_fail (MRP_IS_TASK (task), 0);
+
+	if (analysis->iterations == 0 ||
+	    !g_hash_table_lookup_extended (analysis->indices, task, NULL, &index)) {
+		return 0;
+	}
+
+	return (gdouble) analysis->critical[GPOINTER_TO_UINT (index)] / analysis->iterations;
+}
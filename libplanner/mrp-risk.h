@@ -0,0 +1,54 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <libplanner/mrp-project.h>
+#include <libplanner/mrp-task.h>
+
+G_BEGIN_DECLS
+
+/* Names of the duration properties on tasks that hold the three point
+ * estimates. A missing or zero likely duration means the scheduled duration,
+ * a missing or zero optimistic or pessimistic one means the likely duration.
+ */
+#define MRP_RISK_PROPERTY_OPTIMISTIC  "risk-optimistic"
+#define MRP_RISK_PROPERTY_LIKELY      "risk-likely"
+#define MRP_RISK_PROPERTY_PESSIMISTIC "risk-pessimistic"
+
+/**
+ * MrpRiskAnalysis:
+ *
+ * A Monte Carlo analysis of the schedule of a project, see
+ * mrp_risk_analysis_new().
+ */
+typedef struct _MrpRiskAnalysis MrpRiskAnalysis;
+
+MrpRiskAnalysis *mrp_risk_analysis_new                   (MrpProject      *project);
+void             mrp_risk_analysis_free                  (MrpRiskAnalysis *analysis);
+void             mrp_risk_analysis_run                   (MrpRiskAnalysis *analysis,
+							  gint             iterations,
+							  guint32          seed);
+gint             mrp_risk_analysis_get_iterations        (MrpRiskAnalysis *analysis);
+mrptime          mrp_risk_analysis_get_finish_percentile (MrpRiskAnalysis *analysis,
+							  gdouble          percentile);
+gdouble          mrp_risk_analysis_get_criticality       (MrpRiskAnalysis *analysis,
+							  MrpTask         *task);
+
+G_END_DECLS
@@ -148,10 +148,8 @@ static void     sql_calendar_insert_node      (GHashTable           *hash,
 static gboolean sql_read_calendars            (SQLData              *data);
 static gboolean sql_read_groups               (SQLData              *data);
 static gboolean sql_read_resources            (SQLData              *data);
-static gboolean sql_read_assignments          (SQLData              *data,
-					       gint                  task_id);
-static gboolean sql_read_relations            (SQLData              *data,
-					       gint                  task_id);
+static gboolean sql_read_assignments          (SQLData              *data);
+static gboolean sql_read_relations            (SQLData              *data);
 static void     sql_task_insert_node          (GHashTable           *hash,
 					       GNode                *root,
 					       GNode                *node);
@@ -890,8 +888,6 @@ sql_read_property_values (SQLData   *data,
 	const gchar  *table;
 	const gchar  *object_id_name;
 	gint          object_id;
-	gint          prop_id;
-	GList        *prop_ids = NULL, *l;
 	gint          prop_type_id;
 	MrpProperty  *property;
 	gchar        *value;
@@ -918,10 +914,15 @@ sql_read_property_values (SQLData   *data,
 		object_id = -1;
 	}
 
-	/* Get properties. */
-	query = g_strdup_printf ("DECLARE propcursor CURSOR FOR SELECT * "
-				 "FROM %s WHERE %s=%d",
-				 table, object_id_name, object_id);
+	/* Get the property values, joined with the link table so that each
+	 * object needs a single round trip.
+	 */
+	query = g_strdup_printf ("DECLARE propcursor CURSOR FOR SELECT "
+				 "property.proptype_id, property.value "
+				 "FROM %s, property "
+				 "WHERE %s.prop_id=property.prop_id "
+				 "AND %s.%s=%d",
+				 table, table, table, object_id_name, object_id);
 
 	success = sql_execute_command (data->con, query);
 	g_free (query);
@@ -939,79 +940,30 @@ sql_read_property_values (SQLData   *data,
 		goto out;
 	}
 
-
 	n = gda_data_model_get_n_columns (model);
 	for (i = 0; i < gda_data_model_get_n_rows (model); i++) {
-		prop_id = -1;
+		prop_type_id = -1;
+		value = NULL;
 
 		for (j = 0; j < n; j++) {
-			if (is_field (model, j, "prop_id")) {
-				prop_id = get_id (model, i, j);
+			if (is_field (model, j, "proptype_id")) {
+				prop_type_id = get_id (model, i, j);
+			}
+			if (is_field (model, j, "value")) {
+				value = get_string (model, i, j);
 			}
 		}
 
-		prop_ids = g_list_prepend (prop_ids, GINT_TO_POINTER (prop_id));
+		property = g_hash_table_lookup (data->property_type_id_hash, GINT_TO_POINTER (prop_type_id));
+
+		sql_set_property_value (data, object, property, value);
+		g_free (value);
 	}
 	g_object_unref (model);
 	model = NULL;
 
 	sql_execute_command (data->con, "CLOSE propcursor");
 
-
-	/* Get the actual values. */
-	for (l = prop_ids; l; l = l->next) {
-		prop_id = GPOINTER_TO_INT (l->data);
-
-		query = g_strdup_printf ("DECLARE propcursor CURSOR FOR SELECT * "
-					 "FROM property WHERE prop_id=%d",
-					 prop_id);
-
-		success = sql_execute_command (data->con, query);
-		g_free (query);
-
-
-		if (!success) {
-			g_warning ("DECLARE CURSOR command failed (property) %s.",
-					sql_get_last_error (data->con));
-			goto out;
-		}
-
-		model = sql_execute_query (data->con,"FETCH ALL in propcursor");
-		if (model == NULL) {
-			g_warning ("FETCH ALL failed for property %s.",
-					sql_get_last_error (data->con));
-			goto out;
-		}
-
-
-		n = gda_data_model_get_n_columns (model);
-		for (i = 0; i < gda_data_model_get_n_rows (model); i++) {
-			prop_type_id = -1;
-			value = NULL;
-
-			for (j = 0; j < n; j++) {
-				if (is_field (model, j, "proptype_id")) {
-					prop_type_id = get_id (model, i, j);
-				}
-				if (is_field (model, j, "value")) {
-					value = get_string (model, i, j);
-				}
-			}
-
-			property = g_hash_table_lookup (data->property_type_id_hash, GINT_TO_POINTER (prop_type_id));
-
-			sql_set_property_value (data, object, property, value);
-			g_free (value);
-		}
-		g_object_unref (model);
-		model = NULL;
-
-		sql_execute_command (data->con, "CLOSE propcursor");
-
-	}
-
-	g_list_free (prop_ids);
-
 	return TRUE;
 
  out:
@@ -1147,6 +1099,10 @@ sql_read_overriden_days (SQLData *data, gint calendar_id)
 
 	gint          day_type_id;
 	mrptime       date;
+	MrpDay       *day;
+	MrpCalendar  *calendar;
+
+	calendar = g_hash_table_lookup (data->calendar_id_hash, GINT_TO_POINTER (calendar_id));
 
 	/* Get overridden days for the given calendar. */
 	query = g_strdup_printf ("DECLARE daycursor CURSOR FOR SELECT "
@@ -1190,7 +1146,11 @@ sql_read_overriden_days (SQLData *data, gint calendar_id)
 
 		g_debug ("Overridden for cal %d, on %s\n", calendar_id, mrp_time_format ("%a %e %b", date));
 
-		/*data->days = g_list_prepend (data->days, day);*/
+		/* The dates take precedence over the calendar rules. */
+		day = g_hash_table_lookup (data->day_id_hash, GINT_TO_POINTER (day_type_id));
+		if (calendar && day && date != -1) {
+			mrp_calendar_set_days (calendar, date, day, (mrptime) -1);
+		}
 	}
 	g_object_unref (model);
 	model = NULL;
@@ -1208,6 +1168,122 @@ sql_read_overriden_days (SQLData *data, gint calendar_id)
 	return FALSE;
 }
 
+/* Reads the recurring dates of a calendar, in the order they were added.
+ */
+static gboolean
+sql_read_calendar_rules (SQLData *data, gint calendar_id)
+{
+	gint             n, i, j;
+	GdaDataModel    *model = NULL;
+	gboolean         success;
+	gchar           *query;
+
+	gint             day_type_id;
+	gchar           *type;
+	MrpCalendarRule  rule;
+	MrpCalendar     *calendar;
+
+	calendar = g_hash_table_lookup (data->calendar_id_hash, GINT_TO_POINTER (calendar_id));
+
+	query = g_strdup_printf ("DECLARE rulecursor CURSOR FOR SELECT "
+				 "extract (epoch from start) as start_seconds, "
+				 "coalesce (extract (epoch from finish), 0) as finish_seconds, "
+				 "* FROM calendar_rule WHERE cal_id=%d ORDER BY rule_id",
+				 calendar_id);
+
+	success = sql_execute_command (data->con, query);
+	g_free (query);
+
+	if (!success) {
+		g_warning ("DECLARE CURSOR command failed (calendar_rule) %s.",
+				sql_get_last_error (data->con));
+		goto out;
+	}
+
+	model = sql_execute_query (data->con, "FETCH ALL in rulecursor");
+	if (model == NULL) {
+		g_warning ("FETCH ALL failed for calendar_rule %s.",
+				sql_get_last_error (data->con));
+		goto out;
+	}
+
+	n = gda_data_model_get_n_columns (model);
+	for (i = 0; i < gda_data_model_get_n_rows (model); i++) {
+		memset (&rule, 0, sizeof (rule));
+		day_type_id = -1;
+		type = NULL;
+
+		for (j = 0; j < n; j++) {
+			if (is_field (model, j, "dtype_id")) {
+				day_type_id = get_int (model, i, j);
+			}
+			else if (is_field (model, j, "type")) {
+				g_free (type);
+				type = get_string (model, i, j);
+			}
+			else if (is_field (model, j, "start_seconds")) {
+				rule.start = get_int (model, i, j);
+			}
+			else if (is_field (model, j, "finish_seconds")) {
+				rule.end = get_int (model, i, j);
+			}
+			else if (is_field (model, j, "every")) {
+				rule.interval = get_int (model, i, j);
+			}
+			else if (is_field (model, j, "n_days")) {
+				rule.count = get_int (model, i, j);
+			}
+			else if (is_field (model, j, "week_day")) {
+				rule.week_day = get_int (model, i, j);
+			}
+			else if (is_field (model, j, "nth")) {
+				rule.nth = get_int (model, i, j);
+			}
+			else if (is_field (model, j, "month")) {
+				rule.month = get_int (model, i, j);
+			}
+			else if (is_field (model, j, "month_day")) {
+				rule.month_day = get_int (model, i, j);
+			}
+		}
+
+		rule.day = g_hash_table_lookup (data->day_id_hash, GINT_TO_POINTER (day_type_id));
+
+		if (g_strcmp0 (type, "weekly") == 0) {
+			rule.type = MRP_CALENDAR_RULE_WEEKLY;
+		}
+		else if (g_strcmp0 (type, "monthly") == 0) {
+			rule.type = MRP_CALENDAR_RULE_MONTHLY;
+		}
+		else if (g_strcmp0 (type, "yearly") == 0) {
+			rule.type = MRP_CALENDAR_RULE_YEARLY;
+		} else {
+			rule.type = MRP_CALENDAR_RULE_CYCLE;
+		}
+		g_free (type);
+
+		if (!calendar || !rule.day) {
+			g_warning ("Calendar rule refers to unknown calendar or day type.");
+			continue;
+		}
+
+		mrp_calendar_add_rule (calendar, &rule);
+	}
+	g_object_unref (model);
+	model = NULL;
+
+	sql_execute_command (data->con,"CLOSE rulecursor");
+
+	return TRUE;
+
+ out:
+	if (model) {
+		g_object_unref (model);
+	}
+
+	return FALSE;
+}
+
 static gboolean
 sql_read_day_types (SQLData *data)
 {
@@ -1339,6 +1415,7 @@ sql_calendar_create (GNode   *node,
 
 	sql_read_overriden_days (data, cal_data->id);
 	sql_read_overriden_day_types (data, cal_data->id);
+	sql_read_calendar_rules (data, cal_data->id);
 
 	return FALSE;
 }
@@ -1754,9 +1831,11 @@ sql_read_resources (SQLData *data)
 	return FALSE;
 }
 
+/* Reads the assignments of all tasks in the project with one query, using
+ * the index on allocation.task_id instead of one cursor per task.
+ */
 static gboolean
-sql_read_assignments (SQLData *data,
-			    gint     task_id)
+sql_read_assignments (SQLData *data)
 {
 	gint          n, i, j;
 	GdaDataModel *model = NULL;
@@ -1764,14 +1843,17 @@ sql_read_assignments (SQLData *data,
 	gchar        *query;
 
 	gint          units;
+	gint          task_id;
 	gint          resource_id;
 	MrpTask      *task;
 	MrpResource  *resource;
 
 	/* Get assignments. */
 	query = g_strdup_printf ("DECLARE alloccursor CURSOR FOR SELECT "
-				 "* FROM allocation WHERE task_id=%d",
-				 task_id);
+				 "allocation.* FROM allocation, task "
+				 "WHERE allocation.task_id=task.task_id "
+				 "AND task.proj_id=%d",
+				 data->project_id);
 	success = sql_execute_command (data->con, query);
 	g_free (query);
 
@@ -1790,6 +1872,7 @@ sql_read_assignments (SQLData *data,
 
 	n = gda_data_model_get_n_columns (model);
 	for (i = 0; i < gda_data_model_get_n_rows (model); i++) {
+		task_id = -1;
 		resource_id = -1;
 		units = -1;
 
@@ -1800,11 +1883,19 @@ sql_read_assignments (SQLData *data,
 			else if (is_field (model, j, "res_id")) {
 				resource_id = get_id (model, i, j);
 			}
+			else if (is_field (model, j, "task_id")) {
+				task_id = get_id (model, i, j);
+			}
 		}
 
 		task = g_hash_table_lookup (data->task_id_hash, GINT_TO_POINTER (task_id));
 		resource = g_hash_table_lookup (data->resource_id_hash, GINT_TO_POINTER (resource_id));
 
+		if (!task || !resource) {
+			g_warning ("Allocation refers to unknown task or resource.");
+			continue;
+		}
+
 		mrp_resource_assign (resource, task, units);
 	}
 	g_object_unref (model);
@@ -1822,14 +1913,18 @@ sql_read_assignments (SQLData *data,
 	return FALSE;
 }
 
+/* Reads the predecessor relations of all tasks in the project with one
+ * query.
+ */
 static gboolean
-sql_read_relations (SQLData *data, gint task_id)
+sql_read_relations (SQLData *data)
 {
 	gint          n, i, j;
 	GdaDataModel *model = NULL;
 	gboolean      success;
 	gchar        *query;
 
+	gint          task_id;
 	gint          predecessor_id;
 	gint          lag;
 	MrpTask      *task;
@@ -1837,8 +1932,10 @@ sql_read_relations (SQLData *data, gint task_id)
 
 	/* Get relations. */
 	query = g_strdup_printf ("DECLARE predcursor CURSOR FOR SELECT "
-				 "* FROM predecessor WHERE task_id=%d",
-				 task_id);
+				 "predecessor.* FROM predecessor, task "
+				 "WHERE predecessor.task_id=task.task_id "
+				 "AND task.proj_id=%d",
+				 data->project_id);
 	success = sql_execute_command (data->con, query);
 	g_free (query);
 
@@ -1857,6 +1954,7 @@ sql_read_relations (SQLData *data, gint task_id)
 
 	n = gda_data_model_get_n_columns (model);
 	for (i = 0; i < gda_data_model_get_n_rows (model); i++) {
+		task_id = -1;
 		predecessor_id = -1;
 		lag = 0;
 
@@ -1864,6 +1962,9 @@ sql_read_relations (SQLData *data, gint task_id)
 			if (is_field (model, j, "pred_task_id")) {
 				predecessor_id = get_id (model, i, j);
 			}
+			else if (is_field (model, j, "task_id")) {
+				task_id = get_id (model, i, j);
+			}
 			else if (is_field (model, j, "lag")) {
 				lag = get_int (model, i, j);
 			}
@@ -1872,6 +1973,11 @@ sql_read_relations (SQLData *data, gint task_id)
 		task = g_hash_table_lookup (data->task_id_hash, GINT_TO_POINTER (task_id));
 		predecessor = g_hash_table_lookup (data->task_id_hash, GINT_TO_POINTER (predecessor_id));
 
+		if (!task || !predecessor) {
+			g_warning ("Relation refers to unknown task.");
+			continue;
+		}
+
 		mrp_task_add_predecessor (task,
 					  predecessor,
 					  MRP_RELATION_FS,
@@ -1893,6 +1999,145 @@ sql_read_relations (SQLData *data, gint task_id)
 	return FALSE;
 }
 
+/* Reads the baselines of the project and their task rows with one query.
+ * Rows of tasks that are gone are dropped by the foreign key.
+ */
+static gboolean
+sql_read_baselines (SQLData *data)
+{
+	gint          n, i, j;
+	GdaDataModel *model = NULL;
+	gboolean      success;
+	gchar        *query;
+
+	gint          baseline_id;
+	gchar        *name;
+	mrptime       created;
+	gboolean      is_scenario;
+	gint          task_id;
+	mrptime       start, finish;
+	gint          work, duration;
+	MrpTask      *task;
+	MrpBaseline  *baseline;
+	GHashTable   *hash;
+	GList        *baselines = NULL, *l;
+
+	query = g_strdup_printf ("DECLARE baselinecursor CURSOR FOR SELECT "
+				 "baseline.baseline_id, baseline.name, baseline.is_scenario, "
+				 "extract (epoch from baseline.created) as created_seconds, "
+				 "baseline_task.task_id, baseline_task.work, baseline_task.duration, "
+				 "extract (epoch from baseline_task.start) as start_seconds, "
+				 "extract (epoch from baseline_task.finish) as finish_seconds "
+				 "FROM baseline LEFT JOIN baseline_task "
+				 "ON baseline.baseline_id=baseline_task.baseline_id "
+				 "WHERE baseline.proj_id=%d "
+				 "ORDER BY baseline.baseline_id",
+				 data->project_id);
+	success = sql_execute_command (data->con, query);
+	g_free (query);
+
+	if (!success) {
+		g_warning ("DECLARE CURSOR command failed (baseline) %s.",
+				sql_get_last_error (data->con));
+		goto out;
+	}
+
+	model = sql_execute_query (data->con, "FETCH ALL in baselinecursor");
+	if (model == NULL) {
+		g_warning ("FETCH ALL failed for baseline %s.",
+				sql_get_last_error (data->con));
+		goto out;
+	}
+
+	hash = g_hash_table_new (NULL, NULL);
+
+	n = gda_data_model_get_n_columns (model);
+	for (i = 0; i < gda_data_model_get_n_rows (model); i++) {
+		baseline_id = -1;
+		name = NULL;
+		created = 0;
+		is_scenario = FALSE;
+		task_id = -1;
+		start = 0;
+		finish = 0;
+		work = 0;
+		duration = 0;
+
+		for (j = 0; j < n; j++) {
+			if (is_field (model, j, "baseline_id")) {
+				baseline_id = get_id (model, i, j);
+			}
+			else if (is_field (model, j, "name")) {
+				g_free (name);
+				name = get_string (model, i, j);
+			}
+			else if (is_field (model, j, "is_scenario")) {
+				is_scenario = get_boolean (model, i, j);
+			}
+			else if (is_field (model, j, "created_seconds")) {
+				created = get_int (model, i, j);
+			}
+			else if (is_field (model, j, "task_id")) {
+				task_id = get_id (model, i, j);
+			}
+			else if (is_field (model, j, "work")) {
+				work = get_int (model, i, j);
+			}
+			else if (is_field (model, j, "duration")) {
+				duration = get_int (model, i, j);
+			}
+			else if (is_field (model, j, "start_seconds")) {
+				start = get_int (model, i, j);
+			}
+			else if (is_field (model, j, "finish_seconds")) {
+				finish = get_int (model, i, j);
+			}
+		}
+
+		baseline = g_hash_table_lookup (hash, GINT_TO_POINTER (baseline_id));
+		if (!baseline) {
+			baseline = imrp_baseline_new (name, created, is_scenario);
+			g_hash_table_insert (hash, GINT_TO_POINTER (baseline_id), baseline);
+			baselines = g_list_prepend (baselines, baseline);
+		}
+		g_free (name);
+
+		/* A baseline without tasks comes back as one row without a task. */
+		if (task_id == -1) {
+			continue;
+		}
+
+		task = g_hash_table_lookup (data->task_id_hash, GINT_TO_POINTER (task_id));
+		if (!task) {
+			g_warning ("Baseline refers to unknown task.");
+			continue;
+		}
+
+		imrp_baseline_add_task (baseline, task, start, finish, duration, work);
+	}
+	g_object_unref (model);
+	model = NULL;
+
+	g_hash_table_destroy (hash);
+
+	sql_execute_command (data->con, "CLOSE baselinecursor");
+
+	baselines = g_list_reverse (baselines);
+	for (l = baselines; l; l = l->next) {
+		imrp_project_add_baseline (data->project, l->data);
+	}
+	g_list_free (baselines);
+
+	return TRUE;
+
+ out:
+	if (model) {
+		g_object_unref (model);
+	}
+
+	return FALSE;
+}
+
 /*
  * Insert a task from the GNode tree into the project.
  */
@@ -2175,23 +2420,13 @@ sql_read_tasks (SQLData *data)
 			 data);
 
 	/* Get predecessor relations. */
-	for (l = tasks; l; l = l->next) {
-		GNode *node = l->data;
-
-		task_data = node->data;
-		if (!sql_read_relations (data, task_data->id)) {
-			g_warning ("Couldn't read predecessor relations.");
-		}
+	if (!sql_read_relations (data)) {
+		g_warning ("Couldn't read predecessor relations.");
 	}
 
 	/* Get resource assignments. */
-	for (l = tasks; l; l = l->next) {
-		GNode *node = l->data;
-
-		task_data = node->data;
-		if (!sql_read_assignments (data, task_data->id)) {
-			g_warning ("Couldn't read resource assignments.");
-		}
+	if (!sql_read_assignments (data)) {
+		g_warning ("Couldn't read resource assignments.");
 	}
 
 	/* Get property values. */
@@ -2358,6 +2593,11 @@ mrp_sql_load_project (MrpStorageSQL *storage,
 	} else {
 		task_manager = imrp_project_get_task_manager (storage->project);
 		mrp_task_manager_set_root (task_manager, data->root_task);
+
+		/* Get baselines. */
+		if (!sql_read_baselines (data)) {
+			g_warning ("Couldn't read baselines.");
+		}
 	}
 
 	sql_execute_command (data->con, "COMMIT");
@@ -3059,6 +3299,71 @@ sql_write_overridden_dates (SQLData        *data,
 	return FALSE;
 }
 
+static gboolean
+sql_write_calendar_rule (SQLData         *data,
+			 MrpCalendar     *calendar,
+			 MrpCalendarRule *rule)
+{
+	gboolean      success;
+	gchar        *query;
+
+	gint          calendar_id;
+	gint          day_type_id;
+	const gchar  *type = NULL;
+	gchar        *start_string, *end_string;
+
+	calendar_id = get_hash_data_as_id (data->calendar_hash, calendar);
+	day_type_id = get_hash_data_as_id (data->day_hash, rule->day);
+
+	switch (rule->type) {
+	case MRP_CALENDAR_RULE_WEEKLY:
+		type = "weekly";
+		break;
+	case MRP_CALENDAR_RULE_MONTHLY:
+		type = "monthly";
+		break;
+	case MRP_CALENDAR_RULE_YEARLY:
+		type = "yearly";
+		break;
+	case MRP_CALENDAR_RULE_CYCLE:
+		type = "cycle";
+		break;
+	}
+
+	start_string = mrp_time_format ("%Y-%m-%d", rule->start);
+	sql_quote_and_escape_string (data, &start_string, TRUE);
+
+	if (rule->end != MRP_TIME_INVALID) {
+		end_string = mrp_time_format ("%Y-%m-%d", rule->end);
+		sql_quote_and_escape_string (data, &end_string, TRUE);
+	} else {
+		end_string = g_strdup ("NULL");
+	}
+
+	query = g_strdup_printf ("INSERT INTO calendar_rule(cal_id, dtype_id, type, start, finish, "
+				 "every, n_days, week_day, nth, month, month_day) "
+				 "VALUES(%d, %d, '%s', %s, %s, %d, %d, %d, %d, %d, %d)",
+				 calendar_id, day_type_id, type,
+				 start_string, end_string,
+				 rule->interval, rule->count, rule->week_day,
+				 rule->nth, rule->month, rule->month_day);
+	success = sql_execute_command (data->con, query);
+	g_free (query);
+	g_free (start_string);
+	g_free (end_string);
+
+	if (!success) {
+		g_warning ("INSERT command failed (calendar_rule) %s.",
+				sql_get_last_error (data->con));
+		goto out;
+	}
+
+	return TRUE;
+
+ out:
+	return FALSE;
+}
+
 static gboolean
 sql_write_calendars_recurse (SQLData     *data,
 				    MrpCalendar *parent,
@@ -3139,6 +3444,13 @@ sql_write_calendars_recurse (SQLData     *data,
 		}
 	}
 
+	/* Write recurring dates. */
+	for (l = mrp_calendar_get_rules (calendar); l; l = l->next) {
+		if (!sql_write_calendar_rule (data, calendar, l->data)) {
+			goto out;
+		}
+	}
+
 	/* Write the calendar's children. */
 	list = mrp_calendar_get_children (calendar);
 	for (l = list; l; l = l->next) {
@@ -3662,6 +3974,128 @@ sql_write_tasks (SQLData *data)
 	return FALSE;
 }
 
+/* The task rows of a baseline are inserted this many at a time. */
+#define BASELINE_ROWS_PER_INSERT 500
+
+static gboolean
+sql_write_baseline_rows (SQLData *data, GString *values)
+{
+	gchar    *query;
+	gboolean  success;
+
+	if (values->len == 0) {
+		return TRUE;
+	}
+
+	query = g_strdup_printf ("INSERT INTO baseline_task(baseline_id, task_id, "
+				 "start, finish, work, duration) VALUES%s",
+				 values->str);
+	success = sql_execute_command (data->con, query);
+	g_free (query);
+
+	g_string_truncate (values, 0);
+
+	if (!success) {
+		g_warning ("INSERT command failed (baseline_task) %s.",
+				sql_get_last_error (data->con));
+	}
+
+	return success;
+}
+
+static gboolean
+sql_write_baselines (SQLData *data)
+{
+	gboolean     success;
+	gchar       *query;
+	GList       *tasks, *l, *b;
+	MrpBaseline *baseline;
+	gchar       *name;
+	gchar       *created_string;
+	gchar       *start_string;
+	gchar       *finish_string;
+	mrptime      start, finish;
+	gint         work, duration;
+	gint         id, task_id;
+	gint         n_rows;
+	GString     *values;
+
+	tasks = mrp_project_get_all_tasks (data->project);
+	values = g_string_new (NULL);
+
+	for (b = mrp_project_get_baselines (data->project); b; b = b->next) {
+		baseline = b->data;
+
+		name = g_strdup (mrp_baseline_get_name (baseline));
+		created_string = mrp_time_format ("%Y-%m-%d %H:%M:%S+0",
+						  mrp_baseline_get_created (baseline));
+
+		sql_quote_and_escape_string (data, &name, TRUE);
+		sql_quote_and_escape_string (data, &created_string, TRUE);
+
+		query = g_strdup_printf ("INSERT INTO baseline(proj_id, name, created, is_scenario) "
+					 "VALUES(%d, %s, %s, %s)",
+					 data->project_id, name, created_string,
+					 mrp_baseline_is_scenario (baseline) ? "true" : "false");
+
+		success = sql_execute_command (data->con, query);
+		g_free (query);
+		g_free (name);
+		g_free (created_string);
+
+		if (!success) {
+			g_warning ("INSERT command failed (baseline) %s.",
+					sql_get_last_error (data->con));
+			goto out;
+		}
+
+		id = get_inserted_id (data, "baseline_baseline_id_seq");
+
+		n_rows = 0;
+		for (l = tasks; l; l = l->next) {
+			if (!mrp_baseline_get_task (baseline, l->data,
+						    &start, &finish, &duration, &work)) {
+				continue;
+			}
+
+			task_id = get_hash_data_as_id (data->task_hash, l->data);
+
+			start_string = mrp_time_format ("%Y-%m-%d %H:%M:%S+0", start);
+			finish_string = mrp_time_format ("%Y-%m-%d %H:%M:%S+0", finish);
+
+			g_string_append_printf (values, "%s(%d, %d, '%s', '%s', %d, %d)",
+						values->len ? ", " : "",
+						id, task_id, start_string, finish_string,
+						work, duration);
+
+			g_free (start_string);
+			g_free (finish_string);
+
+			if (++n_rows == BASELINE_ROWS_PER_INSERT) {
+				if (!sql_write_baseline_rows (data, values)) {
+					goto out;
+				}
+				n_rows = 0;
+			}
+		}
+
+		if (!sql_write_baseline_rows (data, values)) {
+			goto out;
+		}
+	}
+
+	g_string_free (values, TRUE);
+	g_list_free (tasks);
+
+	return TRUE;
+
+ out:
+	g_string_free (values, TRUE);
+	g_list_free (tasks);
+
+	return FALSE;
+}
+
 /*
  * mrp_sql_save_project:
  * @storage: an #MrpStorageSQL
@@ -3800,6 +4234,11 @@ mrp_sql_save_project (MrpStorageSQL  *storage,
 		g_warning ("Couldn't write tasks.");
 	}
 
+	/* Write baselines. */
+	if (!sql_write_baselines (data)) {
+		g_warning ("Couldn't write baselines.");
+	}
+
 	sql_execute_command (data->con, "COMMIT");
 
 	g_debug ("Write project, set rev to %d\n", data->revision);
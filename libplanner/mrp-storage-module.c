@@ -122,3 +122,16 @@ imrp_storage_module_set_project (MrpStorageModule *module,
 	}
 }
 
+gpointer
+mrp_storage_module_to_xml_doc (MrpStorageModule  *module,
+			       GError           **error)
+{
+	g_return_val_if_fail (MRP_IS_STORAGE_MODULE (module), NULL);
+
+	if (MRP_STORAGE_MODULE_GET_CLASS (module)->to_xml_doc) {
+		return MRP_STORAGE_MODULE_GET_CLASS (module)->to_xml_doc (module,
+									  error);
+	}
+
+	return NULL;
+}
@@ -56,6 +56,9 @@ struct _MrpStorageModuleClass
  	gboolean (* from_xml)   (MrpStorageModule  *module,
 				 const gchar       *str,
 				 GError           **error);
+	/* Returns a newly built xmlDocPtr, avoids a serialize/parse cycle. */
+ 	gpointer (* to_xml_doc) (MrpStorageModule  *module,
+				 GError           **error);
 	void (* set_project)    (MrpStorageModule  *module,
 				 MrpProject        *project);
 };
@@ -90,5 +93,7 @@ gboolean mrp_storage_module_to_xml   (MrpStorageModule  *module,
 gboolean mrp_storage_module_from_xml (MrpStorageModule  *module,
 				      const gchar       *str,
 				      GError           **error);
+gpointer mrp_storage_module_to_xml_doc (MrpStorageModule  *module,
+					GError           **error);
 
 G_END_DECLS
@@ -43,6 +43,8 @@ static gboolean   mpsm_to_xml      (MrpStorageModule          *module,
 static gboolean   mpsm_from_xml    (MrpStorageModule          *module,
 				    const gchar               *str,
 				    GError                   **error);
+static gpointer   mpsm_to_xml_doc  (MrpStorageModule          *module,
+				    GError                   **error);
 static void       mpsm_set_project (MrpStorageModule          *module,
 				    MrpProject                *project);
 void              module_init      (GTypeModule               *module);
@@ -63,6 +65,7 @@ mrp_storage_mrproject_class_init (MrpStorageMrprojectClass *klass)
 	mrp_storage_module_class->save = mpsm_save;
 	mrp_storage_module_class->to_xml = mpsm_to_xml;
 	mrp_storage_module_class->from_xml = mpsm_from_xml;
+	mrp_storage_module_class->to_xml_doc = mpsm_to_xml_doc;
 	mrp_storage_module_class->set_project = mpsm_set_project;
 }
 
@@ -209,6 +212,16 @@ mpsm_from_xml (MrpStorageModule  *module,
 				    error);
 }
 
+static gpointer
+mpsm_to_xml_doc (MrpStorageModule  *module,
+		 GError           **error)
+{
+	g_return_val_if_fail (MRP_IS_STORAGE_MRPROJECT (module), NULL);
+
+	return mrp_parser_to_xml_doc (MRP_STORAGE_MRPROJECT (module),
+				      error);
+}
+
 static void
 mpsm_set_project (MrpStorageModule *module,
 		  MrpProject       *project)
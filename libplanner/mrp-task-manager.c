@@ -435,6 +435,8 @@ mrp_task_manager_set_root (MrpTaskManager *manager,
 
 	priv->root = task;
 
+	imrp_project_tasks_replaced (priv->project);
+
 	project = priv->project;
 
 	tasks = mrp_task_manager_get_all_tasks (manager);
@@ -450,6 +452,9 @@ mrp_task_manager_set_root (MrpTaskManager *manager,
 		      "project", project,
 		      NULL);
 
+	/* The tasks were built before they knew about the project. */
+	imrp_task_recalc_rollup (task);
+
 	g_list_free (tasks);
 }
 
@@ -2326,6 +2331,493 @@ mrp_task_manager_recalc (MrpTaskManager *manager,
 
 	priv->needs_recalc = FALSE;
 	priv->in_recalc = FALSE;
+
+	imrp_project_check_overallocations (project);
+}
+
+/* Returns the tasks in the order they are scheduled in, where every task
+ * comes after its predecessors, the predecessors of its ancestors and its
+ * children. The dates are up to date unless scheduling is blocked.
+ */
+GList *
+imrp_task_manager_peek_dependency_list (MrpTaskManager *manager)
+{
+	MrpTaskManagerPrivate *priv = mrp_task_manager_get_instance_private (manager);
+
+	mrp_task_manager_recalc (manager, FALSE);
+
+	if (priv->needs_rebuild) {
+		task_manager_build_dependency_graph (manager);
+	}
+
+	return priv->dependency_list;
+}
+
+/* Whether the scheduler is placing the tasks, the changes it makes to them
+ * then follow from other changes.
+ */
+gboolean
+imrp_task_manager_get_in_recalc (MrpTaskManager *manager)
+{
+	MrpTaskManagerPrivate *priv = mrp_task_manager_get_instance_private (manager);
+
+	return priv->in_recalc;
+}
+
+/* Resource leveling. The tasks are placed one at a time in priority order,
+ * each as early as its dependencies allow and then later until it fits in
+ * the remaining capacity of its resources. A task becomes ready to be placed
+ * when everything it depends on, directly or through its ancestors, has been
+ * placed. The dates are set on the tasks while leveling so that the regular
+ * start and finish calculations see the leveled predecessors, and restored
+ * afterwards.
+ */
+typedef struct {
+	MrpTask  *task;
+	guint     order;
+	gint      priority;
+
+	/* Dates before leveling. */
+	mrptime   start;
+	mrptime   work_start;
+	mrptime   finish;
+
+	/* Predecessors that are not placed yet. */
+	gint      blockers;
+
+	/* Leaves in the subtree that are not placed yet. */
+	gint      remaining;
+
+	gboolean  queued;
+} LevelNode;
+
+typedef struct {
+	MrpTaskManager *manager;
+	GHashTable     *nodes;
+	GHashTable     *timelines;
+	GSequence      *queue;
+	GList          *delays;
+} LevelData;
+
+static gint
+task_manager_level_compare (gconstpointer a,
+			    gconstpointer b,
+			    gpointer      user_data)
+{
+	const LevelNode *node_a = a;
+	const LevelNode *node_b = b;
+
+	if (node_a->priority != node_b->priority) {
+		return node_a->priority > node_b->priority ? -1 : 1;
+	}
+
+	if (node_a->start != node_b->start) {
+		return node_a->start < node_b->start ? -1 : 1;
+	}
+
+	return node_a->order < node_b->order ? -1 : (node_a->order > node_b->order);
+}
+
+/* Returns the end of the first segment in [start, end) where @units don't
+ * fit, or -1 if they fit everywhere. A resource can always take one
+ * assignment, even one above 100 units.
+ */
+static mrptime
+task_manager_level_find_conflict (GArray  *load,
+				  mrptime  start,
+				  mrptime  end,
+				  gint     units)
+{
+	MrpLoadSegment *segment;
+	gint            capacity;
+	guint           low, high, mid;
+
+	capacity = MAX (100, units);
+
+	/* Find the first segment ending after start. */
+	low = 0;
+	high = load->len;
+	while (low < high) {
+		mid = (low + high) / 2;
+		if (g_array_index (load, MrpLoadSegment, mid).end <= start) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	for (; low < load->len; low++) {
+		segment = &g_array_index (load, MrpLoadSegment, low);
+
+		if (segment->start >= end) {
+			break;
+		}
+
+		if (segment->units + units > capacity) {
+			return segment->end;
+		}
+	}
+
+	return -1;
+}
+
+static void
+task_manager_level_add_load (GArray  *load,
+			     mrptime  start,
+			     mrptime  end,
+			     gint     units)
+{
+	GArray         *result;
+	MrpLoadSegment *segment;
+	MrpLoadSegment  piece;
+	mrptime         t;
+	guint           i;
+
+	result = g_array_sized_new (FALSE, FALSE, sizeof (MrpLoadSegment), load->len + 3);
+
+	/* The part of [start, end) that is not added yet starts at t. */
+	t = start;
+	for (i = 0; i < load->len; i++) {
+		segment = &g_array_index (load, MrpLoadSegment, i);
+
+		if (t < end && t < segment->start) {
+			piece.start = t;
+			piece.end = MIN (end, segment->start);
+			piece.units = units;
+			g_array_append_val (result, piece);
+			t = piece.end;
+		}
+
+		if (t < end && segment->end > t && segment->start < end) {
+			if (segment->start < t) {
+				piece.start = segment->start;
+				piece.end = t;
+				piece.units = segment->units;
+				g_array_append_val (result, piece);
+			}
+
+			piece.start = t;
+			piece.end = MIN (end, segment->end);
+			piece.units = segment->units + units;
+			g_array_append_val (result, piece);
+			t = piece.end;
+
+			if (segment->end > t) {
+				piece.start = t;
+				piece.end = segment->end;
+				piece.units = segment->units;
+				g_array_append_val (result, piece);
+			}
+		} else {
+			g_array_append_val (result, *segment);
+		}
+	}
+
+	if (t < end) {
+		piece.start = t;
+		piece.end = end;
+		piece.units = units;
+		g_array_append_val (result, piece);
+	}
+
+	g_array_set_size (load, 0);
+	g_array_append_vals (load, result->data, result->len);
+	g_array_free (result, TRUE);
+}
+
+static gboolean
+task_manager_level_is_ready (LevelData *data,
+			     MrpTask   *task)
+{
+	MrpTaskManagerPrivate *priv = mrp_task_manager_get_instance_private (data->manager);
+	LevelNode          *node;
+
+	for (; task && task != priv->root; task = mrp_task_get_parent (task)) {
+		node = g_hash_table_lookup (data->nodes, task);
+		if (node->blockers > 0) {
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/* Queues the leaves under task that are ready, the ancestors of task must not
+ * be blocked.
+ */
+static void
+task_manager_level_queue_subtree (LevelData *data,
+				  MrpTask   *task)
+{
+	LevelNode *node;
+	MrpTask   *child;
+
+	node = g_hash_table_lookup (data->nodes, task);
+	if (node->blockers > 0) {
+		return;
+	}
+
+	child = mrp_task_get_first_child (task);
+	if (!child) {
+		if (!node->queued) {
+			node->queued = TRUE;
+			g_sequence_insert_sorted (data->queue, node,
+						  task_manager_level_compare,
+						  NULL);
+		}
+		return;
+	}
+
+	for (; child; child = mrp_task_get_next_sibling (child)) {
+		task_manager_level_queue_subtree (data, child);
+	}
+}
+
+/* Unblocks the successors of a task that is completely placed. */
+static void
+task_manager_level_complete (LevelData *data,
+			     MrpTask   *task)
+{
+	GList     *l;
+	MrpTask   *successor;
+	LevelNode *node;
+
+	for (l = imrp_task_peek_successors (task); l; l = l->next) {
+		successor = mrp_relation_get_successor (l->data);
+		node = g_hash_table_lookup (data->nodes, successor);
+
+		node->blockers--;
+		if (node->blockers == 0 &&
+		    task_manager_level_is_ready (data, mrp_task_get_parent (successor))) {
+			task_manager_level_queue_subtree (data, successor);
+		}
+	}
+}
+
+static void
+task_manager_level_place (LevelData *data,
+			  LevelNode *node)
+{
+	MrpTaskManager     *manager = data->manager;
+	MrpTaskManagerPrivate *priv = mrp_task_manager_get_instance_private (manager);
+	MrpTask            *task = node->task;
+	MrpTask            *parent;
+	MrpTask            *child;
+	LevelNode          *parent_node;
+	MrpLevelingDelay   *delay;
+	MrpConstraint       constraint;
+	MrpAssignment      *assignment;
+	GArray             *load;
+	GList              *assignments, *l;
+	mrptime             dep_start, start, work_start, finish;
+	mrptime             next, conflict;
+	gint                duration;
+	gint                units;
+
+	duration = 0;
+	dep_start = task_manager_calculate_task_start (manager, task, &duration);
+	assignments = mrp_task_get_assignments (task);
+	constraint = imrp_task_get_constraint (task);
+
+	/* Move the task past the first conflict on each resource until it
+	 * fits, like an event queue over the load segments.
+	 */
+	start = dep_start;
+	while (TRUE) {
+		finish = task_manager_calculate_task_finish (manager, task, start, &duration);
+		work_start = mrp_task_get_work_start (task);
+
+		if (constraint.type == MRP_CONSTRAINT_MSO || work_start >= finish) {
+			break;
+		}
+
+		next = -1;
+		for (l = assignments; l; l = l->next) {
+			assignment = l->data;
+			units = mrp_assignment_get_units (assignment);
+			load = g_hash_table_lookup (data->timelines,
+						    mrp_assignment_get_resource (assignment));
+
+			if (!load || units <= 0) {
+				continue;
+			}
+
+			conflict = task_manager_level_find_conflict (load, work_start, finish, units);
+			next = MAX (next, conflict);
+		}
+
+		if (next == -1) {
+			break;
+		}
+
+		start = next;
+	}
+
+	imrp_task_set_start (task, start);
+	imrp_task_set_finish (task, finish);
+
+	if (work_start < finish) {
+		for (l = assignments; l; l = l->next) {
+			assignment = l->data;
+			units = mrp_assignment_get_units (assignment);
+			load = g_hash_table_lookup (data->timelines,
+						    mrp_assignment_get_resource (assignment));
+
+			if (load && units > 0) {
+				task_manager_level_add_load (load, work_start, finish, units);
+			}
+		}
+	}
+
+	if (start > dep_start) {
+		delay = g_new (MrpLevelingDelay, 1);
+		delay->task = task;
+		delay->start = start;
+		data->delays = g_list_prepend (data->delays, delay);
+	}
+
+	task_manager_level_complete (data, task);
+
+	/* Summary tasks are complete when their last leaf is placed, their
+	 * dates then follow from the children like in the forward pass.
+	 */
+	for (parent = mrp_task_get_parent (task);
+	     parent && parent != priv->root;
+	     parent = mrp_task_get_parent (parent)) {
+		parent_node = g_hash_table_lookup (data->nodes, parent);
+
+		parent_node->remaining--;
+		if (parent_node->remaining > 0) {
+			continue;
+		}
+
+		child = mrp_task_get_first_child (parent);
+		start = mrp_task_get_start (child);
+		work_start = mrp_task_get_work_start (child);
+		finish = mrp_task_get_finish (child);
+
+		for (child = mrp_task_get_next_sibling (child);
+		     child;
+		     child = mrp_task_get_next_sibling (child)) {
+			start = MIN (start, mrp_task_get_start (child));
+			work_start = MIN (work_start, mrp_task_get_work_start (child));
+			finish = MAX (finish, mrp_task_get_finish (child));
+		}
+
+		imrp_task_set_start (parent, start);
+		imrp_task_set_work_start (parent, work_start);
+		imrp_task_set_finish (parent, finish);
+
+		task_manager_level_complete (data, parent);
+	}
+}
+
+/* Calculates how the tasks need to be delayed so that no work resource is
+ * assigned over its capacity, without changing the project. Tasks with a
+ * higher priority are placed first, ties are broken by the current start.
+ * Tasks that must start on a fixed date are not moved but still take up
+ * capacity, material resources are not considered.
+ *
+ * Returns a list of newly allocated MrpLevelingDelay, one for each task that
+ * needs to start later than its dependencies and constraints allow.
+ */
+GList *
+mrp_task_manager_level_resources (MrpTaskManager *manager)
+{
+	MrpTaskManagerPrivate *priv = mrp_task_manager_get_instance_private (manager);
+	LevelData           data;
+	LevelNode          *nodes, *node, *parent_node;
+	MrpTask            *task, *parent;
+	MrpResource        *resource;
+	MrpResourceType     type;
+	GSequenceIter      *iter;
+	GList              *l;
+	guint               n, i;
+
+	g_return_val_if_fail (MRP_IS_TASK_MANAGER (manager), NULL);
+	g_return_val_if_fail (priv->root != NULL, NULL);
+
+	imrp_task_manager_peek_dependency_list (manager);
+
+	data.manager = manager;
+	data.nodes = g_hash_table_new (NULL, NULL);
+	data.timelines = g_hash_table_new_full (NULL, NULL, NULL,
+						(GDestroyNotify) g_array_unref);
+	data.queue = g_sequence_new (NULL);
+	data.delays = NULL;
+
+	for (l = mrp_project_get_resources (priv->project); l; l = l->next) {
+		resource = l->data;
+
+		g_object_get (resource, "type", &type, NULL);
+		if (type != MRP_RESOURCE_TYPE_MATERIAL) {
+			g_hash_table_insert (data.timelines, resource,
+					     g_array_new (FALSE, FALSE, sizeof (MrpLoadSegment)));
+		}
+	}
+
+	n = g_list_length (priv->dependency_list);
+	nodes = g_new0 (LevelNode, n);
+
+	for (l = priv->dependency_list, i = 0; l; l = l->next, i++) {
+		task = l->data;
+		node = &nodes[i];
+
+		node->task = task;
+		node->order = i;
+		node->priority = mrp_task_get_priority (task);
+		node->start = mrp_task_get_start (task);
+		node->work_start = mrp_task_get_work_start (task);
+		node->finish = mrp_task_get_finish (task);
+		node->blockers = g_list_length (imrp_task_peek_predecessors (task));
+
+		node->remaining = mrp_task_get_n_children (task) == 0 ? 1 : 0;
+
+		g_hash_table_insert (data.nodes, task, node);
+	}
+
+	/* Children come before their parents in the dependency list, so the
+	 * leaf count of a summary is complete when it is added to its parent.
+	 */
+	for (i = 0; i < n; i++) {
+		node = &nodes[i];
+
+		parent = mrp_task_get_parent (node->task);
+		if (parent && parent != priv->root) {
+			parent_node = g_hash_table_lookup (data.nodes, parent);
+			parent_node->remaining += node->remaining;
+		}
+	}
+
+	for (task = mrp_task_get_first_child (priv->root);
+	     task;
+	     task = mrp_task_get_next_sibling (task)) {
+		task_manager_level_queue_subtree (&data, task);
+	}
+
+	while (!g_sequence_is_empty (data.queue)) {
+		iter = g_sequence_get_begin_iter (data.queue);
+		node = g_sequence_get (iter);
+		g_sequence_remove (iter);
+
+		task_manager_level_place (&data, node);
+	}
+
+	/* Put the dates back, leveling only reports the delays. */
+	for (i = 0; i < n; i++) {
+		node = &nodes[i];
+
+		imrp_task_set_start (node->task, node->start);
+		imrp_task_set_work_start (node->task, node->work_start);
+		imrp_task_set_finish (node->task, node->finish);
+	}
+
+	g_free (nodes);
+	g_sequence_free (data.queue);
+	g_hash_table_destroy (data.timelines);
+	g_hash_table_destroy (data.nodes);
+
+	return g_list_reverse (data.delays);
 }
 
 static void
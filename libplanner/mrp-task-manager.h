@@ -68,6 +68,7 @@ gint            mrp_task_manager_calculate_summary_duration (MrpTaskManager
                                                              MrpTask              *task,
                                                              mrptime               start,
                                                              mrptime               finish);
+GList          *mrp_task_manager_level_resources            (MrpTaskManager       *manager);
 void            mrp_task_manager_dump_task_tree             (MrpTaskManager       *manager);
 void            mrp_task_manager_dump_task_list             (MrpTaskManager       *manager);
 
@@ -84,7 +84,11 @@ enum {
 	PROP_CONSTRAINT,
 	PROP_NOTE,
 	PROP_PERCENT_COMPLETE,
-	PROP_PRIORITY
+	PROP_PRIORITY,
+	PROP_COST,
+	PROP_ACTUAL_COST,
+	PROP_PLANNED_VALUE,
+	PROP_EARNED_VALUE
 };
 
 /* Signals */
@@ -103,6 +107,14 @@ struct _MrpTask {
 	MrpObject parent_instance;
 };
 
+/* The cost and earned value figures of a task, see task_rollup_compute(). */
+typedef struct {
+	gdouble cost;
+	gdouble actual_cost;
+	gdouble planned_value;
+	gdouble earned_value;
+} TaskRollup;
+
 typedef struct {
 	guint             critical : 1;
 
@@ -128,8 +140,9 @@ typedef struct {
 	/* Arbitrary range of 0,1..9999. A hint for any (3rd party) resource leveller */
 	gint              priority;
 
-	gchar            *name;
-	gchar            *note;
+	/* Shared strings, see imrp_string_ref(). */
+	const gchar      *name;
+	const gchar      *note;
 
 	/* The amount of work effort (duration*units) necessary to complete this
 	 * task.
@@ -171,8 +184,15 @@ typedef struct {
 	/* Intervals to build graphical view of the task */
 	GList            *unit_ivals;
 
-	gfloat            cost;
-	gboolean          cost_cached;
+	/* Bumped whenever unit_ivals is replaced. */
+	guint             unit_ivals_serial;
+
+	/* The figures of the task itself, zero for summary tasks, and their
+	 * sum over the subtree. The sums are kept up to date by adding the
+	 * difference to the ancestors whenever a task or the tree changes.
+	 */
+	TaskRollup        own;
+	TaskRollup        total;
 } MrpTaskPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (MrpTask, mrp_task, MRP_TYPE_OBJECT)
@@ -181,6 +201,11 @@ static void task_assignment_removed_cb (MrpAssignment      *assignment,
 					MrpTask            *task);
 static void task_remove_assignments    (MrpTask            *task);
 static void task_remove_relations      (MrpTask            *task);
+static void task_invalidate_resource_loads (MrpTask        *task);
+static void task_update_rollup         (MrpTask            *task);
+static void task_rollup_propagate      (GNode              *node,
+					const TaskRollup   *delta,
+					gdouble             sign);
 
 
 static guint signals[LAST_SIGNAL];
@@ -190,15 +215,13 @@ mrp_task_init (MrpTask *task)
 {
 	MrpTaskPrivate *priv = mrp_task_get_instance_private (task);
 
-	priv->name = g_strdup ("");
+	priv->name = "";
 	priv->node = g_node_new (task);
 	priv->assignments = NULL;
 	priv->constraint.type = MRP_CONSTRAINT_ASAP;
 	priv->graph_node = g_new0 (MrpTaskGraphNode, 1);
-	priv->note = g_strdup ("");
+	priv->note = "";
 
-	priv->cost = 0.0;
-	priv->cost_cached = FALSE;
 	priv->unit_ivals = NULL;
 }
 
@@ -208,8 +231,8 @@ mrp_task_finalize (GObject *object)
 	MrpTask *task = MRP_TASK (object);
 	MrpTaskPrivate *priv = mrp_task_get_instance_private (task);
 
-	g_free (priv->name);
-	g_free (priv->note);
+	imrp_string_unref (priv->name);
+	imrp_string_unref (priv->note);
 
 	/* Make sure we aren't left hanging in the tree. */
 	g_assert (priv->node->parent == NULL);
@@ -231,32 +254,19 @@ mrp_task_set_property (GObject      *object,
 {
 	MrpTask     *task = MRP_TASK (object);
 	MrpTaskPrivate *priv = mrp_task_get_instance_private (task);
-	const gchar *str;
 	gint         i_val;
 	MrpTaskType  type;
 	gboolean     changed = FALSE;
 
 	switch (prop_id) {
 	case PROP_NAME:
-		str = g_value_get_string (value);
-
-		if (!priv->name || strcmp (priv->name, str)) {
-			g_free (priv->name);
-			priv->name = g_strdup (str);
-			changed = TRUE;
-		}
-
+		changed = imrp_string_replace (&priv->name,
+					       g_value_get_string (value));
 		break;
 
 	case PROP_NOTE:
-		str = g_value_get_string (value);
-
-		if (!priv->note || strcmp (priv->note, str)) {
-			g_free (priv->note);
-			priv->note = g_strdup (str);
-			changed = TRUE;
-		}
-
+		changed = imrp_string_replace (&priv->note,
+					       g_value_get_string (value));
 		break;
 
 	case PROP_START:
@@ -265,6 +275,7 @@ mrp_task_set_property (GObject      *object,
 
 	case PROP_FINISH:
 		priv->finish = g_value_get_int64 (value);
+		task_invalidate_resource_loads (task);
 		break;
 
 	case PROP_DURATION:
@@ -331,6 +342,8 @@ mrp_task_set_property (GObject      *object,
 			g_object_notify (G_OBJECT (task), "work");
 
 			changed = TRUE;
+
+			mrp_task_invalidate_cost (task);
 		}
 		break;
 
@@ -351,6 +364,8 @@ mrp_task_set_property (GObject      *object,
 		if (priv->percent_complete != i_val) {
 			priv->percent_complete = i_val;
 			changed = TRUE;
+
+			task_update_rollup (task);
 		}
 
 		break;
@@ -426,6 +441,18 @@ mrp_task_get_property (GObject    *object,
 	case PROP_PRIORITY:
 		g_value_set_int (value, priv->priority);
 		break;
+	case PROP_COST:
+		g_value_set_float (value, priv->total.cost);
+		break;
+	case PROP_ACTUAL_COST:
+		g_value_set_float (value, priv->total.actual_cost);
+		break;
+	case PROP_PLANNED_VALUE:
+		g_value_set_float (value, priv->total.planned_value);
+		break;
+	case PROP_EARNED_VALUE:
+		g_value_set_float (value, priv->total.earned_value);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -695,6 +722,42 @@ mrp_task_class_init (MrpTaskClass *klass)
 				  "Priority of the task",
 				  0, 9999, 0,
 				  G_PARAM_READWRITE));
+
+	g_object_class_install_property (
+		object_class,
+		PROP_COST,
+		g_param_spec_float ("cost",
+				    "Cost",
+				    "Cost of the task and its subtasks",
+				    0, G_MAXFLOAT, 0,
+				    G_PARAM_READABLE));
+
+	g_object_class_install_property (
+		object_class,
+		PROP_ACTUAL_COST,
+		g_param_spec_float ("actual_cost",
+				    "Actual cost",
+				    "Cost spent on the task at the status date",
+				    0, G_MAXFLOAT, 0,
+				    G_PARAM_READABLE));
+
+	g_object_class_install_property (
+		object_class,
+		PROP_PLANNED_VALUE,
+		g_param_spec_float ("planned_value",
+				    "Planned value",
+				    "Cost scheduled to be spent at the status date",
+				    0, G_MAXFLOAT, 0,
+				    G_PARAM_READABLE));
+
+	g_object_class_install_property (
+		object_class,
+		PROP_EARNED_VALUE,
+		g_param_spec_float ("earned_value",
+				    "Earned value",
+				    "Cost of the work completed",
+				    0, G_MAXFLOAT, 0,
+				    G_PARAM_READABLE));
 }
 
 static void
@@ -713,6 +776,174 @@ task_assignment_removed_cb (MrpAssignment *assignment, MrpTask *task)
 	mrp_object_changed (MRP_OBJECT (task));
 }
 
+static void
+task_invalidate_timephase (MrpTask *task)
+{
+	MrpProject *project;
+
+	project = mrp_object_get_project (MRP_OBJECT (task));
+	if (project) {
+		imrp_project_invalidate_timephase (project, task);
+	}
+}
+
+/* The load profile of each assigned resource depends on when the task runs. */
+static void
+task_invalidate_resource_loads (MrpTask *task)
+{
+	MrpTaskPrivate *priv = mrp_task_get_instance_private (task);
+	GList          *l;
+
+	for (l = priv->assignments; l; l = l->next) {
+		imrp_resource_invalidate_load (mrp_assignment_get_resource (l->data));
+	}
+
+	task_invalidate_timephase (task);
+}
+
+static void
+task_rollup_add (TaskRollup       *rollup,
+		 const TaskRollup *other,
+		 gdouble           sign)
+{
+	rollup->cost += sign * other->cost;
+	rollup->actual_cost += sign * other->actual_cost;
+	rollup->planned_value += sign * other->planned_value;
+	rollup->earned_value += sign * other->earned_value;
+}
+
+/* Adds @delta to the totals of @node and all its ancestors. */
+static void
+task_rollup_propagate (GNode            *node,
+		       const TaskRollup *delta,
+		       gdouble           sign)
+{
+	MrpTaskPrivate *priv;
+
+	for (; node; node = node->parent) {
+		priv = mrp_task_get_instance_private (node->data);
+		task_rollup_add (&priv->total, delta, sign);
+	}
+}
+
+/* Computes the figures of a leaf task. There are no recorded actuals, so the
+ * actual cost of a started task is the cost of the time elapsed at the
+ * status date, as for time and materials work.
+ */
+static void
+task_rollup_compute (MrpTask *task, TaskRollup *rollup)
+{
+	MrpTaskPrivate *priv = mrp_task_get_instance_private (task);
+	MrpProject     *project;
+	GList          *l;
+	mrptime         status_date;
+	gdouble         elapsed;
+
+	memset (rollup, 0, sizeof (TaskRollup));
+
+	if (priv->node->children) {
+		return;
+	}
+
+	for (l = priv->assignments; l; l = l->next) {
+		rollup->cost += mrp_assignment_get_units (l->data) * (gdouble) priv->duration *
+			mrp_resource_get_cost (mrp_assignment_get_resource (l->data)) / (3600.0 * 100);
+	}
+
+	rollup->earned_value = rollup->cost * priv->percent_complete / 100.0;
+
+	project = mrp_object_get_project (MRP_OBJECT (task));
+	if (!project) {
+		return;
+	}
+
+	status_date = mrp_project_get_status_date (project);
+
+	if (status_date >= priv->finish) {
+		elapsed = 1.0;
+	} else if (status_date <= priv->start) {
+		elapsed = 0.0;
+	} else {
+		elapsed = (gdouble) (status_date - priv->start) / (priv->finish - priv->start);
+	}
+
+	rollup->planned_value = rollup->cost * elapsed;
+
+	if (priv->percent_complete >= 100) {
+		rollup->actual_cost = rollup->cost;
+	} else if (priv->percent_complete > 0) {
+		rollup->actual_cost = rollup->planned_value;
+	}
+}
+
+/* Recomputes the figures of @task and passes the difference on to the
+ * totals up the tree, which is O(depth).
+ */
+static void
+task_update_rollup (MrpTask *task)
+{
+	MrpTaskPrivate *priv = mrp_task_get_instance_private (task);
+	TaskRollup      rollup, delta;
+
+	task_rollup_compute (task, &rollup);
+
+	delta = rollup;
+	task_rollup_add (&delta, &priv->own, -1.0);
+
+	if (delta.cost == 0 && delta.actual_cost == 0 &&
+	    delta.planned_value == 0 && delta.earned_value == 0) {
+		return;
+	}
+
+	priv->own = rollup;
+	task_rollup_propagate (priv->node, &delta, 1.0);
+}
+
+static gboolean
+task_recalc_rollup_cb (GNode *node, gpointer data)
+{
+	MrpTaskPrivate *priv = mrp_task_get_instance_private (node->data);
+	MrpTaskPrivate *child_priv;
+	GNode          *child;
+
+	task_rollup_compute (node->data, &priv->own);
+
+	priv->total = priv->own;
+	for (child = node->children; child; child = child->next) {
+		child_priv = mrp_task_get_instance_private (child->data);
+		task_rollup_add (&priv->total, &child_priv->total, 1.0);
+	}
+
+	return FALSE;
+}
+
+/* Recomputes the figures of @task and all tasks below it from scratch, used
+ * when all of them change at once, like after loading or moving the status
+ * date.
+ */
+void
+imrp_task_recalc_rollup (MrpTask *task)
+{
+	MrpTaskPrivate *priv = mrp_task_get_instance_private (task);
+	TaskRollup      old;
+
+	g_return_if_fail (MRP_IS_TASK (task));
+
+	old = priv->total;
+
+	g_node_traverse (priv->node,
+			 G_POST_ORDER,
+			 G_TRAVERSE_ALL,
+			 -1,
+			 task_recalc_rollup_cb,
+			 NULL);
+
+	if (priv->node->parent) {
+		task_rollup_propagate (priv->node->parent, &old, -1.0);
+		task_rollup_propagate (priv->node->parent, &priv->total, 1.0);
+	}
+}
+
 static void
 task_remove_relations (MrpTask *task)
 {
@@ -812,6 +1043,10 @@ imrp_task_remove_subtree (MrpTask *task)
 
 	g_object_ref (task);
 
+	if (parent) {
+		task_rollup_propagate (priv->node->parent, &priv->total, -1.0);
+	}
+
 	/* Remove the tasks one by one using post order so we don't mess with
 	 * the tree while traversing it.
 	 */
@@ -839,6 +1074,10 @@ imrp_task_detach (MrpTask *task)
 
 	/* FIXME: Do some extra checking. */
 
+	if (priv->node->parent) {
+		task_rollup_propagate (priv->node->parent, &priv->total, -1.0);
+	}
+
 	g_node_unlink (priv->node);
 }
 
@@ -900,6 +1139,8 @@ imrp_task_reattach (MrpTask  *task,
 				       task_priv->node);
 		}
 	}
+
+	task_rollup_propagate (parent_priv->node, &task_priv->total, 1.0);
 }
 
 void
@@ -919,6 +1160,8 @@ imrp_task_reattach_pos (MrpTask  *task,
 	g_node_insert (parent_priv->node,
 		       pos,
 		       priv->node);
+
+	task_rollup_propagate (parent_priv->node, &priv->total, 1.0);
 }
 
 /**
@@ -990,6 +1233,9 @@ imrp_task_insert_child (MrpTask *parent,
 		       position,
 		       child_priv->node);
 
+	task_rollup_propagate (parent_priv->node, &child_priv->total, 1.0);
+	task_update_rollup (child);
+
 	mrp_task_invalidate_cost (parent);
 
 	if (parent_priv->type == MRP_TASK_TYPE_MILESTONE) {
@@ -1727,10 +1973,33 @@ mrp_task_set_unit_ivals (MrpTask *task, GList *ivals)
 		priv->unit_ivals = NULL;
 	}
 	priv->unit_ivals = ivals;
+	priv->unit_ivals_serial++;
+
+	task_invalidate_timephase (task);
 
 	return priv->unit_ivals;
 }
 
+/**
+ * mrp_task_get_unit_ivals_serial:
+ * @task: an #MrpTask
+ *
+ * Retrieves a number that changes whenever the intervals of @task are
+ * replaced, so that anything built from them can tell when it is out of
+ * date.
+ *
+ * Return value: The serial of the intervals of @task.
+ **/
+guint
+mrp_task_get_unit_ivals_serial (MrpTask *task)
+{
+	MrpTaskPrivate *priv = mrp_task_get_instance_private (task);
+
+	g_return_val_if_fail (MRP_IS_TASK (task), 0);
+
+	return priv->unit_ivals_serial;
+}
+
 /**
  * mrp_task_get_assignments:
  * @task: an #MrpTask
@@ -1872,7 +2141,7 @@ mrp_task_reset_constraint (MrpTask *task)
  * mrp_task_get_cost:
  * @task: an #MrpTask
  *
- * Calculates the cost to complete @task.
+ * Retrieves the cost to complete @task, including its subtasks.
  *
  * Return value: The cost to complete @task.
  **/
@@ -1880,59 +2149,88 @@ gfloat
 mrp_task_get_cost (MrpTask *task)
 {
 	MrpTaskPrivate *priv = mrp_task_get_instance_private (task);
-	GList       *assignments, *l;
-	MrpResource *resource;
-	gfloat       total = 0;
-	gfloat       cost;
-	MrpTask     *child;
 
 	g_return_val_if_fail (MRP_IS_TASK (task), 0);
 
-	if (priv->cost_cached) {
-		return priv->cost;
-	}
+	return priv->total.cost;
+}
 
-	/* summary task cost calc */
-	child = mrp_task_get_first_child (task);
-	if (child) {
-		while (child) {
-			total += mrp_task_get_cost (child);
-			child = mrp_task_get_next_sibling (child);
-		}
-	} else {
-	/* non summary task cost calc */
-		assignments = mrp_task_get_assignments (task);
-		for (l = assignments; l; l = l->next) {
-			resource = mrp_assignment_get_resource (l->data);
+/**
+ * mrp_task_get_actual_cost:
+ * @task: an #MrpTask
+ *
+ * Retrieves the cost spent on @task and its subtasks at the status date of
+ * the project. Started tasks are assumed to have spent the cost of the time
+ * elapsed since their start, finished tasks all of their cost.
+ *
+ * Return value: The actual cost of @task.
+ **/
+gfloat
+mrp_task_get_actual_cost (MrpTask *task)
+{
+	MrpTaskPrivate *priv = mrp_task_get_instance_private (task);
 
-			mrp_object_get (resource, "cost", &cost, NULL);
-			total += mrp_assignment_get_units (l->data) * priv->duration * cost / (3600.0 * 100);
-		}
-	}
+	g_return_val_if_fail (MRP_IS_TASK (task), 0);
+
+	return priv->total.actual_cost;
+}
+
+/**
+ * mrp_task_get_planned_value:
+ * @task: an #MrpTask
+ *
+ * Retrieves the cost of @task and its subtasks that is scheduled to be spent
+ * at the status date of the project.
+ *
+ * Return value: The planned value of @task.
+ **/
+gfloat
+mrp_task_get_planned_value (MrpTask *task)
+{
+	MrpTaskPrivate *priv = mrp_task_get_instance_private (task);
 
-	priv->cost = total;
-	priv->cost_cached = TRUE;
+	g_return_val_if_fail (MRP_IS_TASK (task), 0);
 
-	return total;
+	return priv->total.planned_value;
+}
+
+/**
+ * mrp_task_get_earned_value:
+ * @task: an #MrpTask
+ *
+ * Retrieves the cost of the completed part of @task and its subtasks,
+ * according to their percent complete.
+ *
+ * Return value: The earned value of @task.
+ **/
+gfloat
+mrp_task_get_earned_value (MrpTask *task)
+{
+	MrpTaskPrivate *priv = mrp_task_get_instance_private (task);
+
+	g_return_val_if_fail (MRP_IS_TASK (task), 0);
+
+	return priv->total.earned_value;
 }
 
 /**
  * mrp_task_invalidate_cost:
  * @task: a task.
  *
- * invalidates @task cost.
+ * Recomputes the cost of @task and updates the totals of the tasks above it.
  */
 void
 mrp_task_invalidate_cost (MrpTask *task)
 {
 	MrpTaskPrivate *priv = mrp_task_get_instance_private (task);
+	GNode          *node;
 
 	g_return_if_fail (MRP_IS_TASK (task));
 
-	priv->cost_cached = FALSE;
+	task_update_rollup (task);
 
-	if (priv->node->parent) {
-		mrp_task_invalidate_cost (priv->node->parent->data);
+	for (node = priv->node; node; node = node->parent) {
+		task_invalidate_timephase (node->data);
 	}
 }
 
@@ -1992,7 +2290,10 @@ imrp_task_set_start (MrpTask *task, mrptime start)
 
 	g_return_if_fail (MRP_IS_TASK (task));
 
-	priv->start = start;
+	if (priv->start != start) {
+		priv->start = start;
+		task_update_rollup (task);
+	}
 }
 
 void
@@ -2002,7 +2303,10 @@ imrp_task_set_work_start (MrpTask *task, mrptime work_start)
 
 	g_return_if_fail (MRP_IS_TASK (task));
 
-	priv->work_start = work_start;
+	if (priv->work_start != work_start) {
+		priv->work_start = work_start;
+		task_invalidate_resource_loads (task);
+	}
 }
 
 void
@@ -2012,7 +2316,11 @@ imrp_task_set_finish (MrpTask *task, mrptime finish)
 
 	g_return_if_fail (MRP_IS_TASK (task));
 
-	priv->finish = finish;
+	if (priv->finish != finish) {
+		priv->finish = finish;
+		task_invalidate_resource_loads (task);
+		task_update_rollup (task);
+	}
 }
 
 void
@@ -2022,7 +2330,10 @@ imrp_task_set_duration (MrpTask *task, gint duration)
 
 	g_return_if_fail (MRP_IS_TASK (task));
 
-	priv->duration = duration;
+	if (priv->duration != duration) {
+		priv->duration = duration;
+		task_update_rollup (task);
+	}
 }
 
 void
@@ -128,6 +128,7 @@ gboolean         mrp_task_is_dominant               (MrpTask          *task);
 GList *          mrp_task_get_unit_ivals            (MrpTask          *task);
 GList *          mrp_task_set_unit_ivals            (MrpTask          *task,
 						     GList *ivals);
+guint            mrp_task_get_unit_ivals_serial     (MrpTask          *task);
 GList           *mrp_task_get_assignments           (MrpTask          *task);
 gint             mrp_task_get_nres                  (MrpTask          *task);
 
@@ -144,6 +145,9 @@ MrpAssignment   *mrp_task_get_assignment            (MrpTask          *task,
 void             mrp_task_reset_constraint          (MrpTask          *task);
 gfloat           mrp_task_get_cost                  (MrpTask          *task);
 void             mrp_task_invalidate_cost           (MrpTask          *task);
+gfloat           mrp_task_get_actual_cost           (MrpTask          *task);
+gfloat           mrp_task_get_planned_value         (MrpTask          *task);
+gfloat           mrp_task_get_earned_value          (MrpTask          *task);
 GList           *mrp_task_get_assigned_resources    (MrpTask          *task);
 gint             mrp_task_compare                   (gconstpointer     a,
 						     gconstpointer     b);
@@ -0,0 +1,629 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Time-phased work and cost. Each leaf task has a contribution, the work
+ * and cost of each of its resources per day, found by walking the calendar
+ * of the resource over the time the task is worked on. The contributions
+ * are added to a series per resource and per summary task, which holds
+ * dense arrays of day, week and month buckets, so a query only copies the
+ * buckets it covers. Tasks that change are marked dirty, and on the next
+ * query their old contribution is subtracted and the new one added, leaving
+ * the rest of the project alone.
+ */
+
+#include <config.h>
+#include <string.h>
+#include "mrp-private.h"
+#include "mrp-timephase.h"
+
+#define DAY_SECONDS  (60*60*24)
+
+/* The GDate julian day of the first day of mrptime, 1970-01-01. */
+#define EPOCH_JULIAN 719163
+
+/* Extra buckets added when a series grows backwards in time. */
+#define LEVEL_SLACK  32
+
+enum {
+	LEVEL_DAY,
+	LEVEL_WEEK,
+	LEVEL_MONTH,
+	N_LEVELS
+};
+
+typedef struct {
+	gint64       work;
+	gdouble      cost;
+} Bucket;
+
+typedef struct {
+	gint         origin;  /* The index of the first bucket. */
+	GArray      *buckets; /* <Bucket> */
+} Level;
+
+typedef struct {
+	Level        levels[N_LEVELS];
+} Series;
+
+typedef struct {
+	MrpResource *resource; /* NULL for tasks without assignments. */
+	gint         day;
+	gint         work;
+	gfloat       cost;
+} Entry;
+
+typedef struct {
+	GArray      *entries;   /* <Entry> */
+	GPtrArray   *summaries; /* <MrpTask> The ancestors, up to the root. */
+} Contribution;
+
+struct _MrpTimephase {
+	MrpProject  *project;
+
+	GHashTable  *resources;     /* MrpResource -> Series */
+	GHashTable  *tasks;         /* MrpTask -> Series, for summary tasks */
+	GHashTable  *contributions; /* MrpTask -> Contribution, for leaves */
+
+	GHashTable  *dirty;         /* Set of MrpTask */
+	gboolean     all_dirty;
+};
+
+static gint
+timephase_floor_div (gint64 a, gint64 b)
+{
+	if (a >= 0) {
+		return a / b;
+	}
+
+	return (a - b + 1) / b;
+}
+
+static gint
+timephase_day_month (gint day)
+{
+	GDate date;
+
+	g_date_clear (&date, 1);
+	g_date_set_julian (&date, day + EPOCH_JULIAN);
+
+	return g_date_get_year (&date) * 12 + g_date_get_month (&date) - 1;
+}
+
+/* Weeks start on Monday, like mrp_time_align_prev() aligns them, and the
+ * first day of mrptime is a Thursday.
+ */
+static gint
+timephase_day_index (gint level, gint day)
+{
+	switch (level) {
+	case LEVEL_DAY:
+		return day;
+	case LEVEL_WEEK:
+		return timephase_floor_div (day + 3, 7);
+	case LEVEL_MONTH:
+		return timephase_day_month (day);
+	}
+
+	g_assert_not_reached ();
+	return 0;
+}
+
+static mrptime
+timephase_index_start (gint level, gint index)
+{
+	switch (level) {
+	case LEVEL_DAY:
+		return (mrptime) index * DAY_SECONDS;
+	case LEVEL_WEEK:
+		return ((mrptime) index * 7 - 3) * DAY_SECONDS;
+	case LEVEL_MONTH:
+		return mrp_time_compose (index / 12, index % 12 + 1, 1, 0, 0, 0);
+	}
+
+	g_assert_not_reached ();
+	return 0;
+}
+
+static gint
+timephase_unit_level (MrpTimeUnit unit)
+{
+	switch (unit) {
+	case MRP_TIME_UNIT_DAY:
+		return LEVEL_DAY;
+	case MRP_TIME_UNIT_WEEK:
+		return LEVEL_WEEK;
+	case MRP_TIME_UNIT_MONTH:
+		return LEVEL_MONTH;
+	default:
+		return -1;
+	}
+}
+
+static Series *
+series_new (void)
+{
+	Series *series;
+	gint    i;
+
+	series = g_new0 (Series, 1);
+
+	for (i = 0; i < N_LEVELS; i++) {
+		series->levels[i].buckets = g_array_new (FALSE, TRUE, sizeof (Bucket));
+	}
+
+	return series;
+}
+
+static void
+series_free (Series *series)
+{
+	gint i;
+
+	for (i = 0; i < N_LEVELS; i++) {
+		g_array_free (series->levels[i].buckets, TRUE);
+	}
+
+	g_free (series);
+}
+
+static void
+level_add (Level *level, gint index, gint64 work, gdouble cost)
+{
+	GArray *buckets = level->buckets;
+	Bucket *bucket;
+	guint   len;
+	gint    n;
+
+	len = buckets->len;
+
+	if (len == 0) {
+		level->origin = index;
+	}
+	else if (index < level->origin) {
+		n = level->origin - index + LEVEL_SLACK;
+
+		g_array_set_size (buckets, len + n);
+		memmove (&g_array_index (buckets, Bucket, n),
+			 &g_array_index (buckets, Bucket, 0),
+			 len * sizeof (Bucket));
+		memset (&g_array_index (buckets, Bucket, 0), 0, n * sizeof (Bucket));
+
+		level->origin -= n;
+	}
+
+	if (index - level->origin >= (gint) buckets->len) {
+		g_array_set_size (buckets, index - level->origin + 1);
+	}
+
+	bucket = &g_array_index (buckets, Bucket, index - level->origin);
+	bucket->work += work;
+	bucket->cost += cost;
+}
+
+static void
+series_add (Series *series, gint day, gint64 work, gdouble cost)
+{
+	gint i;
+
+	for (i = 0; i < N_LEVELS; i++) {
+		level_add (&series->levels[i],
+			   timephase_day_index (i, day),
+			   work, cost);
+	}
+}
+
+static GArray *
+series_get_buckets (Series  *series,
+		    gint     level,
+		    mrptime  start,
+		    mrptime  finish)
+{
+	GArray             *array;
+	Level              *l = NULL;
+	Bucket             *bucket;
+	MrpTimephaseBucket  period;
+	gint                first, last, index;
+
+	array = g_array_new (FALSE, FALSE, sizeof (MrpTimephaseBucket));
+
+	if (start >= finish) {
+		return array;
+	}
+
+	if (series) {
+		l = &series->levels[level];
+	}
+
+	first = timephase_day_index (level, timephase_floor_div (start, DAY_SECONDS));
+	last = timephase_day_index (level, timephase_floor_div (finish - 1, DAY_SECONDS));
+
+	period.end = timephase_index_start (level, first);
+
+	for (index = first; index <= last; index++) {
+		period.start = period.end;
+		period.end = timephase_index_start (level, index + 1);
+		period.work = 0;
+		period.cost = 0;
+
+		if (l && index >= l->origin &&
+		    index - l->origin < (gint) l->buckets->len) {
+			bucket = &g_array_index (l->buckets, Bucket, index - l->origin);
+			period.work = bucket->work;
+			period.cost = bucket->cost;
+		}
+
+		g_array_append_val (array, period);
+	}
+
+	return array;
+}
+
+static Series *
+timephase_get_series (GHashTable *table, gpointer object)
+{
+	Series *series;
+
+	series = g_hash_table_lookup (table, object);
+	if (!series) {
+		series = series_new ();
+		g_hash_table_insert (table, g_object_ref (object), series);
+	}
+
+	return series;
+}
+
+static void
+contribution_free (Contribution *contribution)
+{
+	g_array_free (contribution->entries, TRUE);
+	g_ptr_array_free (contribution->summaries, TRUE);
+	g_free (contribution);
+}
+
+/* Adds the work of @units of @resource between @start and @finish, one
+ * entry per day with working time in @calendar.
+ */
+static void
+timephase_add_work (GArray      *entries,
+		    MrpCalendar *calendar,
+		    MrpResource *resource,
+		    gint         units,
+		    gfloat       rate,
+		    mrptime      start,
+		    mrptime      finish)
+{
+	MrpDay  *day;
+	GList   *l;
+	Entry    entry;
+	mrptime  date;
+	mrptime  i_start, i_end;
+	gint64   work;
+
+	for (date = mrp_time_align_day (start); date < finish; date += DAY_SECONDS) {
+		day = mrp_calendar_get_day (calendar, date, TRUE);
+
+		work = 0;
+		for (l = mrp_calendar_day_get_intervals (calendar, day, TRUE); l; l = l->next) {
+			mrp_interval_get_absolute (l->data, date, &i_start, &i_end);
+
+			i_start = MAX (i_start, start);
+			i_end = MIN (i_end, finish);
+
+			if (i_end > i_start) {
+				work += i_end - i_start;
+			}
+		}
+
+		if (work == 0) {
+			continue;
+		}
+
+		entry.resource = resource;
+		entry.day = timephase_floor_div (date, DAY_SECONDS);
+		entry.work = work * units / 100;
+		entry.cost = entry.work * rate / 3600.0;
+
+		g_array_append_val (entries, entry);
+	}
+}
+
+/* Returns NULL for summary tasks, milestones and tasks that are no longer
+ * in the task tree of the project.
+ */
+static Contribution *
+timephase_compute (MrpTimephase *timephase, MrpTask *task)
+{
+	Contribution  *contribution;
+	MrpCalendar   *project_calendar, *calendar;
+	MrpAssignment *assignment;
+	MrpResource   *resource;
+	MrpTask       *parent, *top;
+	GList         *l;
+	mrptime        start, finish;
+
+	if (mrp_task_get_n_children (task) > 0) {
+		return NULL;
+	}
+
+	top = task;
+	while ((parent = mrp_task_get_parent (top))) {
+		top = parent;
+	}
+
+	if (top == task || top != mrp_project_get_root_task (timephase->project)) {
+		return NULL;
+	}
+
+	start = mrp_task_get_work_start (task);
+	finish = mrp_task_get_finish (task);
+
+	if (start >= finish) {
+		return NULL;
+	}
+
+	contribution = g_new0 (Contribution, 1);
+	contribution->entries = g_array_new (FALSE, FALSE, sizeof (Entry));
+	contribution->summaries = g_ptr_array_new_with_free_func (g_object_unref);
+
+	for (parent = mrp_task_get_parent (task); parent; parent = mrp_task_get_parent (parent)) {
+		g_ptr_array_add (contribution->summaries, g_object_ref (parent));
+	}
+
+	project_calendar = mrp_project_get_calendar (timephase->project);
+
+	/* Without assignments the task is worked on full time following the
+	 * project calendar, like the scheduler does.
+	 */
+	if (!mrp_task_get_assignments (task)) {
+		timephase_add_work (contribution->entries, project_calendar,
+				    NULL, 100, 0, start, finish);
+	}
+
+	for (l = mrp_task_get_assignments (task); l; l = l->next) {
+		assignment = l->data;
+		resource = mrp_assignment_get_resource (assignment);
+
+		calendar = mrp_resource_get_calendar (resource);
+		if (!calendar) {
+			calendar = project_calendar;
+		}
+
+		timephase_add_work (contribution->entries, calendar, resource,
+				    mrp_assignment_get_units (assignment),
+				    mrp_resource_get_cost (resource),
+				    start, finish);
+	}
+
+	return contribution;
+}
+
+static void
+timephase_apply (MrpTimephase *timephase,
+		 Contribution *contribution,
+		 gint          sign)
+{
+	Entry  *entry;
+	Series *series;
+	guint   i, j;
+
+	for (i = 0; i < contribution->entries->len; i++) {
+		entry = &g_array_index (contribution->entries, Entry, i);
+
+		if (entry->resource) {
+			series = timephase_get_series (timephase->resources, entry->resource);
+			series_add (series, entry->day,
+				    sign * entry->work, sign * entry->cost);
+		}
+	}
+
+	for (j = 0; j < contribution->summaries->len; j++) {
+		series = timephase_get_series (timephase->tasks,
+					       g_ptr_array_index (contribution->summaries, j));
+
+		for (i = 0; i < contribution->entries->len; i++) {
+			entry = &g_array_index (contribution->entries, Entry, i);
+			series_add (series, entry->day,
+				    sign * entry->work, sign * entry->cost);
+		}
+	}
+}
+
+static void
+timephase_update_task (MrpTimephase *timephase, MrpTask *task)
+{
+	Contribution *contribution;
+
+	contribution = g_hash_table_lookup (timephase->contributions, task);
+	if (contribution) {
+		timephase_apply (timephase, contribution, -1);
+		g_hash_table_remove (timephase->contributions, task);
+	}
+
+	contribution = timephase_compute (timephase, task);
+	if (contribution) {
+		timephase_apply (timephase, contribution, 1);
+		g_hash_table_insert (timephase->contributions,
+				     g_object_ref (task),
+				     contribution);
+	}
+}
+
+static gboolean
+timephase_update_traverse_func (MrpTask *task, MrpTimephase *timephase)
+{
+	timephase_update_task (timephase, task);
+
+	return FALSE;
+}
+
+static void
+timephase_flush (MrpTimephase *timephase)
+{
+	GHashTableIter  iter;
+	MrpTask        *task, *root;
+
+	root = mrp_project_get_root_task (timephase->project);
+
+	if (timephase->all_dirty) {
+		timephase->all_dirty = FALSE;
+
+		g_hash_table_remove_all (timephase->dirty);
+		g_hash_table_remove_all (timephase->contributions);
+		g_hash_table_remove_all (timephase->resources);
+		g_hash_table_remove_all (timephase->tasks);
+
+		if (root) {
+			mrp_project_task_traverse (timephase->project,
+						   root,
+						   (MrpTaskTraverseFunc) timephase_update_traverse_func,
+						   timephase);
+		}
+
+		return;
+	}
+
+	g_hash_table_iter_init (&iter, timephase->dirty);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &task, NULL)) {
+		timephase_update_task (timephase, task);
+	}
+
+	/* Drop the series of removed summary tasks, once all their children
+	 * have been subtracted from them.
+	 */
+	g_hash_table_iter_init (&iter, timephase->dirty);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &task, NULL)) {
+		if (task != root && !mrp_task_get_parent (task)) {
+			g_hash_table_remove (timephase->tasks, task);
+		}
+	}
+
+	g_hash_table_remove_all (timephase->dirty);
+}
+
+MrpTimephase *
+imrp_timephase_new (MrpProject *project)
+{
+	MrpTimephase *timephase;
+
+	timephase = g_new0 (MrpTimephase, 1);
+
+	timephase->project = project;
+	timephase->resources = g_hash_table_new_full (NULL, NULL,
+						      g_object_unref,
+						      (GDestroyNotify) series_free);
+	timephase->tasks = g_hash_table_new_full (NULL, NULL,
+						  g_object_unref,
+						  (GDestroyNotify) series_free);
+	timephase->contributions = g_hash_table_new_full (NULL, NULL,
+							  g_object_unref,
+							  (GDestroyNotify) contribution_free);
+	timephase->dirty = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
+	timephase->all_dirty = TRUE;
+
+	return timephase;
+}
+
+void
+imrp_timephase_free (MrpTimephase *timephase)
+{
+	g_hash_table_destroy (timephase->dirty);
+	g_hash_table_destroy (timephase->contributions);
+	g_hash_table_destroy (timephase->resources);
+	g_hash_table_destroy (timephase->tasks);
+
+	g_free (timephase);
+}
+
+/* Marks @task to be recomputed on the next query. */
+void
+imrp_timephase_invalidate_task (MrpTimephase *timephase, MrpTask *task)
+{
+	if (timephase->all_dirty || g_hash_table_contains (timephase->dirty, task)) {
+		return;
+	}
+
+	g_hash_table_add (timephase->dirty, g_object_ref (task));
+}
+
+void
+imrp_timephase_invalidate_all (MrpTimephase *timephase)
+{
+	timephase->all_dirty = TRUE;
+	g_hash_table_remove_all (timephase->dirty);
+}
+
+GArray *
+imrp_timephase_get_resource (MrpTimephase *timephase,
+			     MrpResource  *resource,
+			     MrpTimeUnit   unit,
+			     mrptime       start,
+			     mrptime       finish)
+{
+	gint level;
+
+	level = timephase_unit_level (unit);
+	g_return_val_if_fail (level >= 0, NULL);
+
+	timephase_flush (timephase);
+
+	return series_get_buckets (g_hash_table_lookup (timephase->resources, resource),
+				   level, start, finish);
+}
+
+GArray *
+imrp_timephase_get_task (MrpTimephase *timephase,
+			 MrpTask      *task,
+			 MrpTimeUnit   unit,
+			 mrptime       start,
+			 mrptime       finish)
+{
+	Contribution *contribution;
+	Series       *series;
+	Entry        *entry;
+	GArray       *array;
+	guint         i;
+	gint          level;
+
+	level = timephase_unit_level (unit);
+	g_return_val_if_fail (level >= 0, NULL);
+
+	timephase_flush (timephase);
+
+	if (mrp_task_get_n_children (task) > 0) {
+		return series_get_buckets (g_hash_table_lookup (timephase->tasks, task),
+					   level, start, finish);
+	}
+
+	/* A leaf task is small, its buckets are added up on the fly. */
+	contribution = g_hash_table_lookup (timephase->contributions, task);
+	if (!contribution) {
+		return series_get_buckets (NULL, level, start, finish);
+	}
+
+	series = series_new ();
+
+	for (i = 0; i < contribution->entries->len; i++) {
+		entry = &g_array_index (contribution->entries, Entry, i);
+		series_add (series, entry->day, entry->work, entry->cost);
+	}
+
+	array = series_get_buckets (series, level, start, finish);
+	series_free (series);
+
+	return array;
+}
@@ -0,0 +1,51 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <libplanner/mrp-time.h>
+
+G_BEGIN_DECLS
+
+/**
+ * MrpTimephaseBucket:
+ * @start: the start of the period
+ * @end: the start of the next period
+ * @work: the work scheduled in the period, in seconds
+ * @cost: the cost of that work
+ *
+ * The work and cost of a resource or a task in one day, week or month, see
+ * mrp_project_get_resource_timephase() and mrp_project_get_task_timephase().
+ */
+typedef struct {
+	mrptime start;
+	mrptime end;
+	gint    work;
+	gfloat  cost;
+} MrpTimephaseBucket;
+
+/**
+ * MrpTimephase:
+ *
+ * The time-phased work and cost of the resources and summary tasks of a
+ * project, maintained by the project.
+ */
+typedef struct _MrpTimephase MrpTimephase;
+
+G_END_DECLS
@@ -30,9 +30,25 @@
  */
 
 #include <config.h>
+#include <string.h>
 #include <glib.h>
 #include "mrp-types.h"
 #include "mrp-property.h"
+#include "mrp-private.h"
+
+/* Shared strings, for the text fields of tasks and resources. Names repeat a
+ * lot in large projects, so equal strings are stored once with a count of
+ * their users. The empty string is never stored, empty notes cost nothing.
+ */
+typedef struct {
+	guint ref_count;
+	gchar str[1];
+} SharedString;
+
+#define SHARED_STRING(s) ((SharedString *) ((gchar *) (s) - G_STRUCT_OFFSET (SharedString, str)))
+
+G_LOCK_DEFINE_STATIC (shared_strings);
+static GHashTable *shared_strings;
 
 GType
 mrp_relation_type_get_type (void)
@@ -103,6 +119,125 @@ mrp_property_type_get_type (void)
 	return etype;
 }
 
+GType
+mrp_file_compression_get_type (void)
+{
+	static GType etype = 0;
+	if (etype == 0) {
+		static const GEnumValue values[] = {
+			{ MRP_FILE_COMPRESSION_NONE, "MRP_FILE_COMPRESSION_NONE", "none" },
+			{ MRP_FILE_COMPRESSION_GZIP, "MRP_FILE_COMPRESSION_GZIP", "gzip" },
+			{ MRP_FILE_COMPRESSION_ZSTD, "MRP_FILE_COMPRESSION_ZSTD", "zstd" },
+			{ 0, NULL, NULL }
+		};
+		etype = g_enum_register_static ("MrpFileCompression", values);
+	}
+	return etype;
+}
+
+/**
+ * mrp_file_compression_is_supported:
+ * @compression: a compression.
+ *
+ * Checks if project files compressed with @compression can be read and
+ * written. Zstandard depends on how libplanner was built.
+ *
+ * Return value: %TRUE if @compression is supported.
+ */
+gboolean
+mrp_file_compression_is_supported (MrpFileCompression compression)
+{
+	switch (compression) {
+	case MRP_FILE_COMPRESSION_NONE:
+	case MRP_FILE_COMPRESSION_GZIP:
+		return TRUE;
+	case MRP_FILE_COMPRESSION_ZSTD:
+#ifdef HAVE_ZSTD
+		return TRUE;
+#else
+		return FALSE;
+#endif
+	}
+
+	return FALSE;
+}
+
+/* Returns a shared copy of @str, to be released with imrp_string_unref(). */
+const gchar *
+imrp_string_ref (const gchar *str)
+{
+	SharedString *shared;
+	gchar        *key;
+	gsize         len;
+
+	if (!str || !str[0]) {
+		return "";
+	}
+
+	G_LOCK (shared_strings);
+
+	if (!shared_strings) {
+		shared_strings = g_hash_table_new (g_str_hash, g_str_equal);
+	}
+
+	key = g_hash_table_lookup (shared_strings, str);
+	if (key) {
+		shared = SHARED_STRING (key);
+		shared->ref_count++;
+	} else {
+		len = strlen (str);
+		shared = g_malloc (G_STRUCT_OFFSET (SharedString, str) + len + 1);
+		shared->ref_count = 1;
+		memcpy (shared->str, str, len + 1);
+
+		key = shared->str;
+		g_hash_table_add (shared_strings, key);
+	}
+
+	G_UNLOCK (shared_strings);
+
+	return key;
+}
+
+void
+imrp_string_unref (const gchar *str)
+{
+	SharedString *shared;
+
+	if (!str[0]) {
+		return;
+	}
+
+	shared = SHARED_STRING (str);
+
+	G_LOCK (shared_strings);
+
+	if (--shared->ref_count == 0) {
+		g_hash_table_remove (shared_strings, shared->str);
+		g_free (shared);
+	}
+
+	G_UNLOCK (shared_strings);
+}
+
+/* Replaces the shared string in @field with @str, returns %TRUE if it
+ * changed.
+ */
+gboolean
+imrp_string_replace (const gchar **field, const gchar *str)
+{
+	const gchar *old = *field;
+
+	if (strcmp (old, str ? str : "") == 0) {
+		return FALSE;
+	}
+
+	*field = imrp_string_ref (str);
+	imrp_string_unref (old);
+
+	return TRUE;
+}
+
 /**
  * mrp_string_list_copy:
  * @list: a list.
@@ -29,6 +29,7 @@
 #define MRP_TYPE_TASK_SCHED    (mrp_task_sched_get_type ())
 #define MRP_TYPE_PROPERTY_TYPE (mrp_property_type_get_type ())
 #define MRP_TYPE_STRING_LIST   (mrp_string_list_get_type ())
+#define MRP_TYPE_FILE_COMPRESSION (mrp_file_compression_get_type ())
 
 /**
  * MrpRelationType:
@@ -95,6 +96,20 @@ typedef enum {
 	MRP_TASK_SCHED_FIXED_DURATION
 } MrpTaskSched;
 
+/**
+ * MrpFileCompression:
+ * @MRP_FILE_COMPRESSION_NONE: plain XML
+ * @MRP_FILE_COMPRESSION_GZIP: gzip
+ * @MRP_FILE_COMPRESSION_ZSTD: Zstandard, when libplanner is built with it
+ *
+ * How a project file is compressed.
+ */
+typedef enum {
+	MRP_FILE_COMPRESSION_NONE,
+	MRP_FILE_COMPRESSION_GZIP,
+	MRP_FILE_COMPRESSION_ZSTD
+} MrpFileCompression;
+
 
 /**
  * MrpTask:
@@ -137,6 +152,10 @@ GType   mrp_task_sched_get_type    (void) G_GNUC_CONST;
 
 GType   mrp_property_type_get_type (void) G_GNUC_CONST;
 
+GType   mrp_file_compression_get_type (void) G_GNUC_CONST;
+
+gboolean mrp_file_compression_is_supported (MrpFileCompression compression);
+
 GList * mrp_string_list_copy       (const GList *list);
 
 void    mrp_string_list_free       (GList       *list);
@@ -37,6 +37,17 @@
 #include <libplanner/mrp-private.h>
 #include "libplanner/mrp-paths.h"
 #include <libplanner/mrp-time.h>
+#include <libplanner/mrp-task.h>
+#include <libplanner/mrp-resource.h>
+#include <libplanner/mrp-assignment.h>
+
+/* Longer projects get monthly instead of weekly resource usage. */
+#define HTML_TIMEPHASE_MAX_WEEKS 26
+
+struct _MrpFileWriterPriv {
+	/* Compiled planner2html.xsl, parsed on first export and reused. */
+	xsltStylesheet *stylesheet;
+};
 
 void            init                     (MrpFileModule   *module,
 					  MrpApplication  *application);
@@ -45,6 +56,11 @@ static gboolean html_write               (MrpFileWriter   *writer,
 					  const gchar     *uri,
 					  gboolean         force,
 					  GError         **error);
+static gboolean html_native_write        (MrpFileWriter   *writer,
+					  MrpProject      *project,
+					  const gchar     *uri,
+					  gboolean         force,
+					  GError         **error);
 
 
 static void xslt_module_gettext		(xmlXPathParserContextPtr ctxt,
@@ -110,6 +126,147 @@ xslt_module_init (xsltTransformContextPtr ctxt, const xmlChar *uri)
 }
 
 
+static xsltStylesheet *
+html_get_stylesheet (MrpFileWriter *writer)
+{
+	MrpFileWriterPriv *priv;
+	gchar             *filename;
+
+	priv = writer->priv;
+
+	if (!priv->stylesheet) {
+		filename = mrp_paths_get_stylesheet_dir ("planner2html.xsl");
+		priv->stylesheet = xsltParseStylesheetFile ((const xmlChar *) filename);
+		g_free (filename);
+	}
+
+	return priv->stylesheet;
+}
+
+/* Picks weeks or months for the resource usage of @project, returns
+ * MRP_TIME_UNIT_NONE if there is nothing to show.
+ */
+static MrpTimeUnit
+html_get_timephase_unit (MrpProject *project,
+			 mrptime    *start,
+			 mrptime    *finish)
+{
+	*start = mrp_project_get_project_start (project);
+	*finish = mrp_task_get_finish (mrp_project_get_root_task (project));
+
+	if (!mrp_project_get_resources (project) || *finish <= *start) {
+		return MRP_TIME_UNIT_NONE;
+	}
+
+	if (*finish - *start > HTML_TIMEPHASE_MAX_WEEKS * 7 * 24 * 60 * 60) {
+		return MRP_TIME_UNIT_MONTH;
+	}
+
+	return MRP_TIME_UNIT_WEEK;
+}
+
+static void
+html_set_prop (xmlNode *node, const gchar *name, const gchar *value)
+{
+	xmlSetProp (node, (const xmlChar *) name, (const xmlChar *) value);
+}
+
+/* Adds the work and cost of each resource per period, read from the
+ * time-phased buckets of the project, for the resource usage table.
+ */
+static void
+html_add_timephase (MrpProject *project, xmlDoc *doc)
+{
+	xmlNode            *node, *resource_node, *child;
+	GList              *resources, *l;
+	GArray             *buckets;
+	MrpTimephaseBucket *bucket;
+	MrpTimeUnit         unit;
+	mrptime             start, finish;
+	gchar              *str;
+	gchar               buf[G_ASCII_DTOSTR_BUF_SIZE];
+	guint               i;
+
+	unit = html_get_timephase_unit (project, &start, &finish);
+	if (unit == MRP_TIME_UNIT_NONE) {
+		return;
+	}
+
+	resources = mrp_project_get_resources (project);
+
+	node = xmlNewChild (xmlDocGetRootElement (doc), NULL,
+			    (const xmlChar *) "timephase", NULL);
+	html_set_prop (node, "unit", unit == MRP_TIME_UNIT_MONTH ? "month" : "week");
+
+	for (l = resources; l; l = l->next) {
+		buckets = mrp_project_get_resource_timephase (project, l->data,
+							      unit, start, finish);
+
+		/* The periods are the same for all resources. */
+		if (l == resources) {
+			for (i = 0; i < buckets->len; i++) {
+				bucket = &g_array_index (buckets, MrpTimephaseBucket, i);
+
+				child = xmlNewChild (node, NULL, (const xmlChar *) "period", NULL);
+				str = mrp_time_to_string (bucket->start);
+				html_set_prop (child, "start", str);
+				g_free (str);
+			}
+		}
+
+		resource_node = xmlNewChild (node, NULL, (const xmlChar *) "resource", NULL);
+		html_set_prop (resource_node, "name", mrp_resource_get_name (l->data));
+
+		for (i = 0; i < buckets->len; i++) {
+			bucket = &g_array_index (buckets, MrpTimephaseBucket, i);
+
+			child = xmlNewChild (resource_node, NULL, (const xmlChar *) "bucket", NULL);
+
+			str = g_strdup_printf ("%d", bucket->work);
+			html_set_prop (child, "work", str);
+			g_free (str);
+
+			html_set_prop (child, "cost",
+				       g_ascii_formatd (buf, sizeof (buf), "%.2f", bucket->cost));
+		}
+
+		g_array_free (buckets, TRUE);
+	}
+}
+
+static xmlDoc *
+html_get_project_doc (MrpProject *project, GError **error)
+{
+	xmlDoc *doc;
+	gchar  *xml_project;
+	GError *tmp_error = NULL;
+
+	/* Use the tree from the storage module directly when possible, and
+	 * only fall back to a serialize/parse round trip when the module
+	 * can't build one.
+	 */
+	doc = imrp_project_save_to_xml_doc (project, &tmp_error);
+	if (tmp_error) {
+		g_propagate_error (error, tmp_error);
+		return NULL;
+	}
+
+	if (!doc) {
+		if (!mrp_project_save_to_xml (project, &xml_project, error)) {
+			return NULL;
+		}
+
+		doc = xmlParseMemory (xml_project, strlen (xml_project));
+		g_free (xml_project);
+	}
+
+	if (doc) {
+		html_add_timephase (project, doc);
+	}
+
+	return doc;
+}
+
 static gboolean
 html_write (MrpFileWriter  *writer,
 	    MrpProject     *project,
@@ -117,32 +274,27 @@ html_write (MrpFileWriter  *writer,
 	    gboolean        force,
 	    GError        **error)
 {
-        gchar          *xml_project;
         xsltStylesheet *stylesheet;
         xmlDoc         *doc;
         xmlDoc         *final_doc;
 	gboolean        ret;
-	gchar          *filename;
 
-	if (!mrp_project_save_to_xml (project, &xml_project, error)) {
+	stylesheet = html_get_stylesheet (writer);
+	if (!stylesheet) {
+		g_set_error (error,
+			     MRP_ERROR,
+			     MRP_ERROR_EXPORT_FAILED,
+			     _("Export to HTML failed"));
 		return FALSE;
 	}
 
-        /* libxml housekeeping */
-        xmlSubstituteEntitiesDefault (1);
-        xmlLoadExtDtdDefaultValue = 1;
-        exsltRegisterAll ();
-
-	xsltRegisterExtModule((const xmlChar *)"http://www.gnu.org/software/gettext/",
-                                 xslt_module_init, xslt_module_shutdown);
-
-	filename = mrp_paths_get_stylesheet_dir ("planner2html.xsl");
-        stylesheet = xsltParseStylesheetFile ((const xmlChar *) filename);
-	g_free (filename);
+	doc = html_get_project_doc (project, error);
+	if (!doc) {
+		return FALSE;
+	}
 
-        doc = xmlParseMemory (xml_project, strlen (xml_project));
         final_doc = xsltApplyStylesheet (stylesheet, doc, NULL);
-        xmlFree (doc);
+        xmlFreeDoc (doc);
 
 	ret = TRUE;
 
@@ -155,8 +307,284 @@ html_write (MrpFileWriter  *writer,
 		ret = FALSE;
 	}
 
-	xsltFreeStylesheet (stylesheet);
-        xmlFree (final_doc);
+	if (final_doc) {
+		xmlFreeDoc (final_doc);
+	}
+
+	return ret;
+}
+
+/*
+ * Native writer, produces the task and resource tables of the standard
+ * report straight from the project, without going through XML and XSLT.
+ */
+
+static void
+html_native_append_text (GString *str, const gchar *text)
+{
+	gchar *escaped;
+
+	if (!text) {
+		return;
+	}
+
+	escaped = g_markup_escape_text (text, -1);
+	g_string_append (str, escaped);
+	g_free (escaped);
+}
+
+static void
+html_native_append_date (GString *str, mrptime t)
+{
+	gchar *tmp;
+
+	tmp = mrp_time_format ("%Y-%m-%d %H:%M", t);
+	g_string_append (str, tmp);
+	g_free (tmp);
+}
+
+static void
+html_native_append_work (GString *str, gint work)
+{
+	gint days, hours;
+
+	/* Same convention as the XSLT report, 8 hour days. */
+	days = work / (8 * 60 * 60);
+	hours = (work % (8 * 60 * 60)) / (60 * 60);
+
+	if (days) {
+		g_string_append_printf (str, "%dd ", days);
+	}
+	if (hours) {
+		g_string_append_printf (str, "%dh", hours);
+	}
+}
+
+static void
+html_native_append_assignments (GString *str, MrpTask *task)
+{
+	GList         *l;
+	MrpAssignment *assignment;
+	MrpResource   *resource;
+	const gchar   *name;
+	gint           units;
+
+	for (l = mrp_task_get_assignments (task); l; l = l->next) {
+		assignment = l->data;
+		resource = mrp_assignment_get_resource (assignment);
+
+		name = mrp_resource_get_short_name (resource);
+		if (!name || name[0] == 0) {
+			name = mrp_resource_get_name (resource);
+		}
+
+		html_native_append_text (str, name);
+
+		units = mrp_assignment_get_units (assignment);
+		if (units != 100) {
+			g_string_append_printf (str, "[%d]", units);
+		}
+
+		if (l->next) {
+			g_string_append (str, ", ");
+		}
+	}
+}
+
+static void
+html_native_write_task (GString *str, MrpTask *task, gint depth)
+{
+	MrpTask *child;
+
+	g_string_append (str, "<tr>");
+
+	g_string_append_printf (str,
+				"<td style=\"padding-left: %dpx\">",
+				depth * 18);
+	html_native_append_text (str, mrp_task_get_name (task));
+	g_string_append (str, "</td><td>");
+	html_native_append_date (str, mrp_task_get_start (task));
+	g_string_append (str, "</td><td>");
+	html_native_append_date (str, mrp_task_get_finish (task));
+	g_string_append (str, "</td><td>");
+	html_native_append_work (str, mrp_task_get_work (task));
+	g_string_append_printf (str, "</td><td>%d%%</td><td>",
+				mrp_task_get_percent_complete (task));
+	html_native_append_assignments (str, task);
+	g_string_append (str, "</td></tr>\n");
+
+	child = mrp_task_get_first_child (task);
+	while (child) {
+		html_native_write_task (str, child, depth + 1);
+		child = mrp_task_get_next_sibling (child);
+	}
+}
+
+static void
+html_native_write_timephase (GString *str, MrpProject *project)
+{
+	GList              *resources, *l;
+	GArray             *buckets;
+	MrpTimephaseBucket *bucket;
+	MrpTimeUnit         unit;
+	mrptime             start, finish;
+	gchar              *tmp;
+	guint               i;
+
+	unit = html_get_timephase_unit (project, &start, &finish);
+	if (unit == MRP_TIME_UNIT_NONE) {
+		return;
+	}
+
+	resources = mrp_project_get_resources (project);
+
+	g_string_append_printf (str, "<h2>%s</h2>\n<table>\n",
+				_("Resource usage"));
+
+	for (l = resources; l; l = l->next) {
+		buckets = mrp_project_get_resource_timephase (project, l->data,
+							      unit, start, finish);
+
+		if (l == resources) {
+			g_string_append_printf (str, "<tr><th>%s</th>", _("Name"));
+
+			for (i = 0; i < buckets->len; i++) {
+				bucket = &g_array_index (buckets, MrpTimephaseBucket, i);
+
+				tmp = mrp_time_format (unit == MRP_TIME_UNIT_MONTH ?
+						       "%Y-%m" : "%Y-%m-%d",
+						       bucket->start);
+				g_string_append_printf (str, "<th>%s</th>", tmp);
+				g_free (tmp);
+			}
+
+			g_string_append (str, "</tr>\n");
+		}
+
+		g_string_append (str, "<tr><td>");
+		html_native_append_text (str, mrp_resource_get_name (l->data));
+		g_string_append (str, "</td>");
+
+		for (i = 0; i < buckets->len; i++) {
+			bucket = &g_array_index (buckets, MrpTimephaseBucket, i);
+
+			g_string_append (str, "<td>");
+			html_native_append_work (str, bucket->work);
+			g_string_append (str, "</td>");
+		}
+
+		g_string_append (str, "</tr>\n");
+
+		g_array_free (buckets, TRUE);
+	}
+
+	g_string_append (str, "</table>\n");
+}
+
+static gboolean
+html_native_write (MrpFileWriter  *writer,
+		   MrpProject     *project,
+		   const gchar    *uri,
+		   gboolean        force,
+		   GError        **error)
+{
+	GString     *str;
+	GList       *l;
+	MrpTask     *task;
+	MrpResource *resource;
+	gchar       *name;
+	gchar       *manager;
+	gchar       *email;
+	gboolean     ret;
+
+	if (!force && g_file_test (uri, G_FILE_TEST_EXISTS)) {
+		g_set_error (error,
+			     MRP_ERROR,
+			     MRP_ERROR_SAVE_FILE_EXIST,
+			     "%s", uri);
+		return FALSE;
+	}
+
+	g_object_get (project,
+		      "name", &name,
+		      "manager", &manager,
+		      NULL);
+
+	str = g_string_sized_new (64 * 1024);
+
+	g_string_append (str,
+			 "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+			 "<!DOCTYPE html PUBLIC \"-//W3C//DTD XHTML 1.0 Strict//EN\" "
+			 "\"http://www.w3.org/TR/xhtml1/DTD/xhtml1-strict.dtd\">\n"
+			 "<html xmlns=\"http://www.w3.org/1999/xhtml\">\n<head>\n"
+			 "<meta name=\"GENERATOR\" content=\"Planner HTML output\"/>\n"
+			 "<title>");
+	html_native_append_text (str, name);
+	g_string_append (str, " - Planner</title>\n</head>\n<body>\n<h1>");
+	html_native_append_text (str, name);
+	g_string_append (str, "</h1>\n");
+
+	if (manager && manager[0] != 0) {
+		g_string_append_printf (str, "<div class=\"property\">%s: ",
+					_("Manager"));
+		html_native_append_text (str, manager);
+		g_string_append (str, "</div>\n");
+	}
+
+	g_string_append_printf (str, "<div class=\"property\">%s: ",
+				_("Start"));
+	html_native_append_date (str, mrp_project_get_project_start (project));
+	g_string_append (str, "</div>\n");
+
+	/* Tasks. */
+	g_string_append_printf (str,
+				"<h2>%s</h2>\n<table>\n<tr><th>%s</th><th>%s</th>"
+				"<th>%s</th><th>%s</th><th>%s</th><th>%s</th></tr>\n",
+				_("Tasks"), _("Name"), _("Start"), _("Finish"),
+				_("Work"), _("Complete"), _("Assigned to"));
+
+	task = mrp_task_get_first_child (mrp_project_get_root_task (project));
+	while (task) {
+		html_native_write_task (str, task, 0);
+		task = mrp_task_get_next_sibling (task);
+	}
+
+	g_string_append (str, "</table>\n");
+
+	/* Resources. */
+	g_string_append_printf (str,
+				"<h2>%s</h2>\n<table>\n<tr><th>%s</th><th>%s</th>"
+				"<th>%s</th></tr>\n",
+				_("Resources"), _("Name"), _("Short name"),
+				_("Email"));
+
+	for (l = mrp_project_get_resources (project); l; l = l->next) {
+		resource = l->data;
+
+		g_object_get (resource, "email", &email, NULL);
+
+		g_string_append (str, "<tr><td>");
+		html_native_append_text (str, mrp_resource_get_name (resource));
+		g_string_append (str, "</td><td>");
+		html_native_append_text (str, mrp_resource_get_short_name (resource));
+		g_string_append (str, "</td><td>");
+		html_native_append_text (str, email);
+		g_string_append (str, "</td></tr>\n");
+
+		g_free (email);
+	}
+
+	g_string_append (str, "</table>\n");
+
+	html_native_write_timephase (str, project);
+
+	g_string_append (str, "</body>\n</html>\n");
+
+	ret = g_file_set_contents (uri, str->str, str->len, error);
+
+	g_string_free (str, TRUE);
+	g_free (name);
+	g_free (manager);
 
 	return ret;
 }
@@ -166,17 +594,39 @@ init (MrpFileModule *module, MrpApplication *application)
 {
         MrpFileWriter *writer;
 
+        /* libxml housekeeping, only needs to be done once. */
+        xmlSubstituteEntitiesDefault (1);
+        xmlLoadExtDtdDefaultValue = 1;
+        exsltRegisterAll ();
+
+	xsltRegisterExtModule ((const xmlChar *)"http://www.gnu.org/software/gettext/",
+			       xslt_module_init, xslt_module_shutdown);
+
+	/* The native HTML writer registration. It is registered first so
+	 * that the XSLT writer is preferred when looking up by mime type.
+	 */
+
         writer = g_new0 (MrpFileWriter, 1);
 
+        writer->module     = module;
+	writer->identifier = "Planner HTML Native";
+	writer->mime_type  = "text/html";
+        writer->priv       = NULL;
+
+        writer->write      = html_native_write;
+
+        mrp_application_register_writer (application, writer);
+
 	/* The HTML writer registration */
 
+        writer = g_new0 (MrpFileWriter, 1);
+
         writer->module     = module;
 	writer->identifier = "Planner HTML";
 	writer->mime_type  = "text/html";
-        writer->priv       = NULL;
+        writer->priv       = g_new0 (MrpFileWriterPriv, 1);
 
         writer->write      = html_write;
 
         mrp_application_register_writer (application, writer);
 }
-
@@ -33,4 +33,7 @@
 #include <libplanner/mrp-object.h>
 #include <libplanner/mrp-project.h>
 #include <libplanner/mrp-resource.h>
+#include <libplanner/mrp-risk.h>
+#include <libplanner/mrp-baseline.h>
+#include <libplanner/mrp-timephase.h>
 #include <libplanner/mrp-task.h>
@@ -0,0 +1,327 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Collects objects that changed and hands them over in one batch per frame.
+ *
+ * A recalc or an undo transaction can emit several notifications for each
+ * of thousands of tasks. Views queue the object here instead of updating
+ * right away, and get each changed object once, just before the next frame
+ * is drawn. When a widget is set, delivery happens from its frame clock,
+ * otherwise from an idle that runs ahead of the redraw.
+ *
+ * While the queues are frozen, for the duration of an undo transaction,
+ * nothing is delivered, and every queue that got changes is scheduled once
+ * when they are thawed. Like the views, this is only used from the main
+ * thread.
+ */
+
+#include <config.h>
+#include "planner-change-queue.h"
+
+struct _PlannerChangeQueue {
+	PlannerChangeQueueFunc  func;
+	gpointer                user_data;
+
+	GtkWidget              *widget;
+
+	/* Object -> position in objects + 1. */
+	GHashTable             *pending;
+	GPtrArray              *objects;
+
+	guint                   tick_id;
+	guint                   idle_id;
+
+	/* In frozen_queues, waiting for the thaw. */
+	gboolean                frozen;
+};
+
+static gint    freeze_count;
+static GSList *frozen_queues;
+
+static void change_queue_schedule (PlannerChangeQueue *queue);
+
+static void
+change_queue_object_finalized (PlannerChangeQueue *queue,
+			       GObject            *where_the_object_was)
+{
+	guint pos;
+
+	pos = GPOINTER_TO_UINT (g_hash_table_lookup (queue->pending,
+						     where_the_object_was));
+	if (pos > 0) {
+		g_ptr_array_index (queue->objects, pos - 1) = NULL;
+		g_hash_table_remove (queue->pending, where_the_object_was);
+	}
+}
+
+static void
+change_queue_clear (PlannerChangeQueue *queue)
+{
+	guint i;
+
+	for (i = 0; i < queue->objects->len; i++) {
+		GObject *object = g_ptr_array_index (queue->objects, i);
+
+		if (object) {
+			g_object_weak_unref (object,
+					     (GWeakNotify) change_queue_object_finalized,
+					     queue);
+		}
+	}
+
+	g_hash_table_remove_all (queue->pending);
+	g_ptr_array_set_size (queue->objects, 0);
+}
+
+static void
+change_queue_cancel (PlannerChangeQueue *queue)
+{
+	if (queue->tick_id) {
+		gtk_widget_remove_tick_callback (queue->widget, queue->tick_id);
+		queue->tick_id = 0;
+	}
+
+	if (queue->idle_id) {
+		g_source_remove (queue->idle_id);
+		queue->idle_id = 0;
+	}
+}
+
+static gboolean
+change_queue_tick_cb (GtkWidget          *widget,
+		      GdkFrameClock      *frame_clock,
+		      PlannerChangeQueue *queue)
+{
+	queue->tick_id = 0;
+
+	/* Scheduled before the freeze, wait for the thaw. */
+	if (freeze_count > 0) {
+		change_queue_schedule (queue);
+		return G_SOURCE_REMOVE;
+	}
+
+	planner_change_queue_flush (queue);
+
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+change_queue_idle_cb (PlannerChangeQueue *queue)
+{
+	queue->idle_id = 0;
+
+	if (freeze_count > 0) {
+		change_queue_schedule (queue);
+		return FALSE;
+	}
+
+	planner_change_queue_flush (queue);
+
+	return FALSE;
+}
+
+static void
+change_queue_schedule (PlannerChangeQueue *queue)
+{
+	if (queue->tick_id || queue->idle_id || queue->frozen) {
+		return;
+	}
+
+	if (freeze_count > 0) {
+		queue->frozen = TRUE;
+		frozen_queues = g_slist_prepend (frozen_queues, queue);
+		return;
+	}
+
+	if (queue->widget && gtk_widget_get_realized (queue->widget)) {
+		queue->tick_id = gtk_widget_add_tick_callback (
+			queue->widget,
+			(GtkTickCallback) change_queue_tick_cb,
+			queue,
+			NULL);
+	} else {
+		queue->idle_id = g_idle_add_full (GDK_PRIORITY_REDRAW - 1,
+						  (GSourceFunc) change_queue_idle_cb,
+						  queue,
+						  NULL);
+	}
+}
+
+PlannerChangeQueue *
+planner_change_queue_new (PlannerChangeQueueFunc func,
+			  gpointer               user_data)
+{
+	PlannerChangeQueue *queue;
+
+	g_return_val_if_fail (func != NULL, NULL);
+
+	queue = g_new0 (PlannerChangeQueue, 1);
+
+	queue->func = func;
+	queue->user_data = user_data;
+	queue->pending = g_hash_table_new (NULL, NULL);
+	queue->objects = g_ptr_array_new ();
+
+	return queue;
+}
+
+void
+planner_change_queue_free (PlannerChangeQueue *queue)
+{
+	g_return_if_fail (queue != NULL);
+
+	change_queue_cancel (queue);
+	change_queue_clear (queue);
+
+	if (queue->frozen) {
+		frozen_queues = g_slist_remove (frozen_queues, queue);
+	}
+
+	if (queue->widget) {
+		g_object_remove_weak_pointer (G_OBJECT (queue->widget),
+					      (gpointer *) &queue->widget);
+	}
+
+	g_hash_table_destroy (queue->pending);
+	g_ptr_array_free (queue->objects, TRUE);
+	g_free (queue);
+}
+
+/* Deliver batches from the frame clock of @widget while it is realized. */
+void
+planner_change_queue_set_widget (PlannerChangeQueue *queue,
+				 GtkWidget          *widget)
+{
+	g_return_if_fail (queue != NULL);
+	g_return_if_fail (widget == NULL || GTK_IS_WIDGET (widget));
+
+	if (queue->widget == widget) {
+		return;
+	}
+
+	change_queue_cancel (queue);
+
+	if (queue->widget) {
+		g_object_remove_weak_pointer (G_OBJECT (queue->widget),
+					      (gpointer *) &queue->widget);
+	}
+
+	queue->widget = widget;
+
+	if (widget) {
+		g_object_add_weak_pointer (G_OBJECT (widget),
+					   (gpointer *) &queue->widget);
+	}
+
+	if (queue->objects->len > 0) {
+		change_queue_schedule (queue);
+	}
+}
+
+void
+planner_change_queue_add (PlannerChangeQueue *queue,
+			  gpointer            object)
+{
+	g_return_if_fail (queue != NULL);
+	g_return_if_fail (G_IS_OBJECT (object));
+
+	if (g_hash_table_lookup (queue->pending, object)) {
+		return;
+	}
+
+	g_ptr_array_add (queue->objects, object);
+	g_hash_table_insert (queue->pending,
+			     object,
+			     GUINT_TO_POINTER (queue->objects->len));
+
+	g_object_weak_ref (object,
+			   (GWeakNotify) change_queue_object_finalized,
+			   queue);
+
+	change_queue_schedule (queue);
+}
+
+/* Delivers the pending objects right away, for callers that need the views
+ * to be current before returning to the main loop.
+ */
+void
+planner_change_queue_flush (PlannerChangeQueue *queue)
+{
+	GPtrArray *objects;
+	guint      i;
+
+	g_return_if_fail (queue != NULL);
+
+	change_queue_cancel (queue);
+
+	if (queue->objects->len == 0) {
+		return;
+	}
+
+	/* Take the batch first, the callback may queue more changes. */
+	objects = g_ptr_array_new_with_free_func (g_object_unref);
+	for (i = 0; i < queue->objects->len; i++) {
+		GObject *object = g_ptr_array_index (queue->objects, i);
+
+		if (object) {
+			g_ptr_array_add (objects, g_object_ref (object));
+		}
+	}
+
+	change_queue_clear (queue);
+
+	if (objects->len > 0) {
+		queue->func (objects, queue->user_data);
+	}
+
+	g_ptr_array_unref (objects);
+}
+
+/* Holds back delivery from all queues until the matching thaw. Calls nest. */
+void
+planner_change_queue_freeze (void)
+{
+	freeze_count++;
+}
+
+void
+planner_change_queue_thaw (void)
+{
+	GSList             *queues, *l;
+	PlannerChangeQueue *queue;
+
+	g_return_if_fail (freeze_count > 0);
+
+	if (--freeze_count > 0) {
+		return;
+	}
+
+	queues = g_slist_reverse (frozen_queues);
+	frozen_queues = NULL;
+
+	for (l = queues; l; l = l->next) {
+		queue = l->data;
+
+		queue->frozen = FALSE;
+		if (queue->objects->len > 0) {
+			change_queue_schedule (queue);
+		}
+	}
+
+	g_slist_free (queues);
+}
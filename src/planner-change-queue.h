@@ -0,0 +1,41 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+typedef struct _PlannerChangeQueue PlannerChangeQueue;
+
+/* Called once per batch with the objects that changed since the last one,
+ * in the order they were first queued. Objects finalized in between are
+ * left out.
+ */
+typedef void (*PlannerChangeQueueFunc) (GPtrArray *objects,
+					gpointer   user_data);
+
+PlannerChangeQueue *planner_change_queue_new        (PlannerChangeQueueFunc  func,
+						     gpointer                user_data);
+void                planner_change_queue_free       (PlannerChangeQueue     *queue);
+void                planner_change_queue_set_widget (PlannerChangeQueue     *queue,
+						     GtkWidget              *widget);
+void                planner_change_queue_add        (PlannerChangeQueue     *queue,
+						     gpointer                object);
+void                planner_change_queue_flush      (PlannerChangeQueue     *queue);
+void                planner_change_queue_freeze     (void);
+void                planner_change_queue_thaw       (void);
@@ -21,16 +21,41 @@
 #include <config.h>
 #include <glib.h>
 #include <glib/gi18n.h>
+#include <string.h>
 #include "planner-cmd-manager.h"
+#include "planner-change-queue.h"
 #include "planner-marshal.h"
 
+/* A command with the same merge function as the current one, inserted
+ * within this interval of it, is folded into it as one undo step.
+ */
+#define MERGE_TIMEOUT (G_USEC_PER_SEC / 2)
+
 struct _PlannerCmdManagerPriv {
-	gint   limit;
+	gint      limit;
+	gsize     byte_limit;
+
+	/* Newest command at the head, so the oldest operation can be trimmed
+	 * from the tail without walking the history.
+	 */
+	GQueue    list;
+	GList    *current;
 
-	GList *list;
-	GList *current;
+	/* Whole transactions count as one operation. */
+	gint      n_operations;
+	gsize     n_bytes;
 
 	gboolean  inside_transaction;
+
+	/* Scheduling is blocked on the project, and the views are frozen,
+	 * while a transaction is built, undone or redone, so that it's
+	 * recalculated and repainted once at the end instead of once per
+	 * command. Undoing a transaction while building one nests, the state
+	 * from before the outermost block is restored.
+	 */
+	MrpProject *project;
+	gint        block_depth;
+	gboolean    was_blocked;
 };
 
 
@@ -48,6 +73,7 @@ static void cmd_manager_init       (PlannerCmdManager      *manager);
 static void cmd_manager_finalize   (GObject                *object);
 static void cmd_manager_free_func  (PlannerCmd             *cmd,
 				    gpointer                data);
+static void cmd_manager_unblock_scheduling (PlannerCmdManager *manager);
 
 
 GType
@@ -120,6 +146,9 @@ cmd_manager_init (PlannerCmdManager *manager)
 	 * 1.
 	 */
 	priv->limit = 100;
+	priv->byte_limit = 32 * 1024 * 1024;
+
+	g_queue_init (&priv->list);
 }
 
 static void
@@ -128,7 +157,21 @@ cmd_manager_finalize (GObject *object)
 	PlannerCmdManager     *manager = PLANNER_CMD_MANAGER (object);
 	PlannerCmdManagerPriv *priv = manager->priv;;
 
-	g_list_foreach (priv->list, (GFunc) cmd_manager_free_func, NULL);
+	/* Don't leave the project blocked or the views frozen when dropped in
+	 * the middle of a transaction.
+	 */
+	if (priv->block_depth > 0) {
+		priv->block_depth = 1;
+		cmd_manager_unblock_scheduling (manager);
+	}
+
+	g_queue_foreach (&priv->list, (GFunc) cmd_manager_free_func, NULL);
+	g_queue_clear (&priv->list);
+
+	if (priv->project) {
+		g_object_remove_weak_pointer (G_OBJECT (priv->project),
+					      (gpointer *) &priv->project);
+	}
 
 	g_free (manager->priv);
 
@@ -137,6 +180,45 @@ cmd_manager_finalize (GObject *object)
 	}
 }
 
+static void
+cmd_manager_block_scheduling (PlannerCmdManager *manager)
+{
+	PlannerCmdManagerPriv *priv = manager->priv;
+
+	if (priv->block_depth++ > 0) {
+		return;
+	}
+
+	planner_change_queue_freeze ();
+
+	if (priv->project) {
+		priv->was_blocked = mrp_project_get_block_scheduling (priv->project);
+		mrp_project_set_block_scheduling (priv->project, TRUE);
+	}
+}
+
+/* Restores the blocking state when the outermost block ends, which triggers
+ * the one recalc for everything done since cmd_manager_block_scheduling(),
+ * and lets the views catch up in one repaint.
+ */
+static void
+cmd_manager_unblock_scheduling (PlannerCmdManager *manager)
+{
+	PlannerCmdManagerPriv *priv = manager->priv;
+
+	g_return_if_fail (priv->block_depth > 0);
+
+	if (--priv->block_depth > 0) {
+		return;
+	}
+
+	if (priv->project) {
+		mrp_project_set_block_scheduling (priv->project, priv->was_blocked);
+	}
+
+	planner_change_queue_thaw ();
+}
+
 static void
 cmd_manager_dump (PlannerCmdManager *manager)
 {
@@ -152,7 +234,10 @@ cmd_manager_dump (PlannerCmdManager *manager)
 
 	g_print ("--------\n");
 
-	for (l = priv->list; l; l = l->next) {
+	g_print ("%d operations, %" G_GSIZE_FORMAT " bytes\n",
+		 priv->n_operations, priv->n_bytes);
+
+	for (l = priv->list.head; l; l = l->next) {
 		if (l == priv->current) {
 			g_print ("*");
 		} else {
@@ -193,8 +278,8 @@ get_redo_cmd (PlannerCmdManager *manager, gboolean next)
 	GList                 *l;
 	PlannerCmd            *cmd;
 
-	if (!priv->current && priv->list) {
-		l = g_list_last (priv->list);
+	if (!priv->current && priv->list.tail) {
+		l = priv->list.tail;
 	}
 	else if (!priv->current || !priv->current->prev) {
 		l = NULL;
@@ -259,13 +344,60 @@ cmd_manager_free_func (PlannerCmd *cmd,
 }
 
 static void
-cmd_manager_ensure_limit (PlannerCmdManager *manager)
+cmd_manager_remove_cmd (PlannerCmdManager *manager,
+			PlannerCmd        *cmd)
+{
+	PlannerCmdManagerPriv *priv = manager->priv;
+
+	priv->n_bytes -= MIN (priv->n_bytes, cmd->size);
+
+	cmd_manager_free_func (cmd, NULL);
+}
+
+/* Drops the oldest operation, i.e. a single command or a whole transaction,
+ * from the tail of the history.
+ */
+static void
+cmd_manager_trim_oldest (PlannerCmdManager *manager)
 {
 	PlannerCmdManagerPriv *priv;
-	GList                 *l;
 	PlannerCmd            *cmd;
-	gboolean               inside_transaction;
-	gint                   num;
+
+	priv = manager->priv;
+
+	cmd = g_queue_pop_tail (&priv->list);
+	if (!cmd) {
+		return;
+	}
+
+	if (cmd->type == PLANNER_CMD_TYPE_BEGIN_TRANSACTION) {
+		cmd_manager_remove_cmd (manager, cmd);
+
+		while ((cmd = g_queue_pop_tail (&priv->list)) != NULL) {
+			gboolean end;
+
+			end = cmd->type == PLANNER_CMD_TYPE_END_TRANSACTION;
+			cmd_manager_remove_cmd (manager, cmd);
+
+			if (end) {
+				break;
+			}
+		}
+	} else {
+		cmd_manager_remove_cmd (manager, cmd);
+	}
+
+	priv->n_operations--;
+
+	if (!priv->list.head) {
+		priv->current = NULL;
+	}
+}
+
+static void
+cmd_manager_ensure_limit (PlannerCmdManager *manager)
+{
+	PlannerCmdManagerPriv *priv;
 
 	priv = manager->priv;
 
@@ -278,39 +410,80 @@ cmd_manager_ensure_limit (PlannerCmdManager *manager)
 		return;
 	}
 
+	while (priv->n_operations > priv->limit) {
+		cmd_manager_trim_oldest (manager);
+	}
+
+	/* Always keep the most recent operation, however large. */
+	while (priv->n_bytes > priv->byte_limit && priv->n_operations > 1) {
+		cmd_manager_trim_oldest (manager);
+	}
+}
+
+/* Frees the commands that were undone, i.e. everything newer than the
+ * current command, since they can't be redone after a new insert.
+ */
+static void
+cmd_manager_wipe_redo (PlannerCmdManager *manager)
+{
+	PlannerCmdManagerPriv *priv;
+	PlannerCmd            *cmd;
+	gboolean               inside_transaction;
+
+	priv = manager->priv;
+
 	inside_transaction = FALSE;
-	num = 0;
 
-	/* Get the number of operations, counting whole transactions as one
-	 * operation.
-	 */
-	for (l = priv->list; l; l = l->next) {
-		cmd = l->data;
+	while (priv->list.head && priv->list.head != priv->current) {
+		cmd = g_queue_pop_head (&priv->list);
 
 		if (cmd->type == PLANNER_CMD_TYPE_END_TRANSACTION) {
 			inside_transaction = TRUE;
 		}
 		else if (cmd->type == PLANNER_CMD_TYPE_BEGIN_TRANSACTION) {
 			inside_transaction = FALSE;
-			num++;
+			priv->n_operations--;
 		}
 		else if (!inside_transaction) {
-			num++;
+			priv->n_operations--;
 		}
 
-		if (cmd->type != PLANNER_CMD_TYPE_BEGIN_TRANSACTION && num > priv->limit) {
-			break;
-		}
+		cmd_manager_remove_cmd (manager, cmd);
 	}
+}
 
-	if (l != NULL) {
-		/* Trim the undo history. */
-		l->prev->next = NULL;
-		l->prev = NULL;
+static PlannerCmd *
+cmd_manager_get_merge_target (PlannerCmdManager *manager,
+			      PlannerCmd        *cmd,
+			      gint64             now)
+{
+	PlannerCmdManagerPriv *priv;
+	PlannerCmd            *prev;
+
+	priv = manager->priv;
+
+	if (!cmd->merge_func || cmd->type != PLANNER_CMD_TYPE_NORMAL) {
+		return NULL;
+	}
+
+	if (priv->inside_transaction || !priv->current) {
+		return NULL;
+	}
+
+	/* Measured from the current command itself, after an undo it can be
+	 * older than the command inserted last.
+	 */
+	prev = priv->current->data;
+	if (now - prev->time > MERGE_TIMEOUT) {
+		return NULL;
+	}
 
-		g_list_foreach (l, (GFunc) cmd_manager_free_func, NULL);
-		g_list_free (l);
+	if (prev->type != PLANNER_CMD_TYPE_NORMAL ||
+	    prev->merge_func != cmd->merge_func) {
+		return NULL;
 	}
+
+	return prev;
 }
 
 static gboolean
@@ -319,42 +492,62 @@ cmd_manager_insert (PlannerCmdManager *manager,
 		    gboolean           run_do)
 {
 	PlannerCmdManagerPriv *priv;
-	GList                 *current;
+	PlannerCmd            *prev;
+	gint64                 now;
 	gboolean               retval;
 
 	priv = manager->priv;
 
-	if (priv->current != priv->list) {
-		/* Need to wipe the cmd history added after the current
-		 * element.
-		 */
+	retval = TRUE;
+
+	cmd_manager_wipe_redo (manager);
 
-		current = priv->current;
+	cmd->manager = manager;
+
+	now = g_get_monotonic_time ();
 
-		if (current && current->prev) {
-			current->prev->next = NULL;
-			current->prev = NULL;
+	/* Try to fold the command into the previous one, e.g. repeated edits
+	 * of the same property.
+	 */
+	prev = cmd_manager_get_merge_target (manager, cmd, now);
+	if (prev) {
+		if (run_do && cmd->do_func) {
+			retval = cmd->do_func (cmd);
 		}
 
-		g_list_foreach (priv->list, (GFunc) cmd_manager_free_func, NULL);
-		g_list_free (priv->list);
+		run_do = FALSE;
 
-		priv->list = current;
+		if (retval && prev->merge_func (prev, cmd)) {
+			cmd_manager_free_func (cmd, NULL);
+
+			prev->time = now;
+
+			cmd_manager_dump (manager);
+
+			state_changed (manager);
+
+			return retval;
+		}
 	}
 
-	cmd_manager_ensure_limit (manager);
+	g_queue_push_head (&priv->list, cmd);
+	priv->current = priv->list.head;
 
-	priv->list = g_list_prepend (priv->list, cmd);
-	priv->current = priv->list;
+	priv->n_bytes += cmd->size;
 
-	cmd->manager = manager;
+	if (cmd->type == PLANNER_CMD_TYPE_BEGIN_TRANSACTION ||
+	    (cmd->type == PLANNER_CMD_TYPE_NORMAL && !priv->inside_transaction)) {
+		priv->n_operations++;
+	}
+
+	cmd->time = now;
 
 	if (run_do && cmd->do_func) {
 		retval = cmd->do_func (cmd);
-	} else {
-		retval = TRUE;
 	}
 
+	cmd_manager_ensure_limit (manager);
+
 	cmd_manager_dump (manager);
 
 	state_changed (manager);
@@ -423,6 +616,64 @@ planner_cmd_manager_redo (PlannerCmdManager *manager)
 	return TRUE;
 }
 
+/**
+ * planner_cmd_manager_set_limits:
+ * @manager: a #PlannerCmdManager
+ * @limit: the maximum number of operations to keep, must be > 1
+ * @byte_limit: the approximate number of bytes the history may use
+ *
+ * Sets how much undo history to keep. A transaction counts as one
+ * operation. The most recent operation is always kept. The new limits are
+ * applied when the next command is inserted.
+ **/
+void
+planner_cmd_manager_set_limits (PlannerCmdManager *manager,
+				gint               limit,
+				gsize              byte_limit)
+{
+	PlannerCmdManagerPriv *priv;
+
+	g_return_if_fail (PLANNER_IS_CMD_MANAGER (manager));
+	g_return_if_fail (limit > 1);
+
+	priv = manager->priv;
+
+	priv->limit = limit;
+	priv->byte_limit = byte_limit;
+}
+
+/**
+ * planner_cmd_manager_get_stats:
+ * @manager: a #PlannerCmdManager
+ * @n_operations: location to store the number of operations, or %NULL
+ * @n_commands: location to store the number of commands, or %NULL
+ * @n_bytes: location to store the approximate memory used, or %NULL
+ *
+ * Retrieves statistics about the undo history.
+ **/
+void
+planner_cmd_manager_get_stats (PlannerCmdManager *manager,
+			       gint              *n_operations,
+			       gint              *n_commands,
+			       gsize             *n_bytes)
+{
+	PlannerCmdManagerPriv *priv;
+
+	g_return_if_fail (PLANNER_IS_CMD_MANAGER (manager));
+
+	priv = manager->priv;
+
+	if (n_operations) {
+		*n_operations = priv->n_operations;
+	}
+	if (n_commands) {
+		*n_commands = g_queue_get_length (&priv->list);
+	}
+	if (n_bytes) {
+		*n_bytes = priv->n_bytes;
+	}
+}
+
 PlannerCmdManager *
 planner_cmd_manager_new (void)
 {
@@ -433,6 +684,34 @@ planner_cmd_manager_new (void)
 	return manager;
 }
 
+void
+planner_cmd_manager_set_project (PlannerCmdManager *manager,
+				 MrpProject        *project)
+{
+	PlannerCmdManagerPriv *priv;
+
+	g_return_if_fail (PLANNER_IS_CMD_MANAGER (manager));
+	g_return_if_fail (project == NULL || MRP_IS_PROJECT (project));
+
+	priv = manager->priv;
+
+	if (priv->project == project) {
+		return;
+	}
+
+	if (priv->project) {
+		g_object_remove_weak_pointer (G_OBJECT (priv->project),
+					      (gpointer *) &priv->project);
+	}
+
+	priv->project = project;
+
+	if (project) {
+		g_object_add_weak_pointer (G_OBJECT (project),
+					   (gpointer *) &priv->project);
+	}
+}
+
 
 /*
  * Transaction commands
@@ -447,6 +726,8 @@ transaction_cmd_do (PlannerCmd *cmd)
 {
 	PlannerCmd *cmd_sub;
 
+	cmd_manager_block_scheduling (cmd->manager);
+
 	while (1) {
 		cmd_sub = get_redo_cmd (cmd->manager, TRUE);
 
@@ -465,6 +746,8 @@ transaction_cmd_do (PlannerCmd *cmd)
 		g_assert (cmd_sub->type == PLANNER_CMD_TYPE_NORMAL);
 	}
 
+	cmd_manager_unblock_scheduling (cmd->manager);
+
 	/* FIXME: need to make sure we handle transactions that doesn't work. */
 
 	return TRUE;
@@ -475,6 +758,8 @@ transaction_cmd_undo (PlannerCmd *cmd)
 {
 	PlannerCmd *cmd_sub;
 
+	cmd_manager_block_scheduling (cmd->manager);
+
 	while (1) {
 		cmd_sub = get_undo_cmd (cmd->manager, TRUE);
 
@@ -492,6 +777,8 @@ transaction_cmd_undo (PlannerCmd *cmd)
 
 		g_assert (cmd_sub->type == PLANNER_CMD_TYPE_NORMAL);
 	}
+
+	cmd_manager_unblock_scheduling (cmd->manager);
 }
 
 gboolean
@@ -512,6 +799,8 @@ planner_cmd_manager_begin_transaction (PlannerCmdManager *manager,
 
 	priv->inside_transaction = TRUE;
 
+	cmd_manager_block_scheduling (manager);
+
 	cmd = planner_cmd_new (PlannerCmd,
 			       name,
 			       transaction_cmd_do,
@@ -553,6 +842,10 @@ planner_cmd_manager_end_transaction (PlannerCmdManager *manager)
 
 	if (!begin_cmd) {
 		g_warning ("Can't find beginning of transaction.");
+
+		priv->inside_transaction = FALSE;
+		cmd_manager_unblock_scheduling (manager);
+
 		return FALSE;
 	}
 
@@ -568,6 +861,8 @@ planner_cmd_manager_end_transaction (PlannerCmdManager *manager)
 
 	priv->inside_transaction = FALSE;
 
+	cmd_manager_unblock_scheduling (manager);
+
 	return TRUE;
 }
 
@@ -583,6 +878,7 @@ planner_cmd_new_size (gsize               size,
 	cmd = g_malloc0 (size);
 
 	cmd->name = g_strdup (name);
+	cmd->size = size + (name ? strlen (name) + 1 : 0);
 	cmd->do_func = do_func;
 	cmd->undo_func = undo_func;
 	cmd->free_func = free_func;
@@ -21,6 +21,7 @@
 #pragma once
 
 #include <glib-object.h>
+#include <libplanner/mrp-project.h>
 
 #define PLANNER_TYPE_CMD_MANAGER            (planner_cmd_manager_get_type ())
 #define PLANNER_CMD_MANAGER(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), PLANNER_TYPE_CMD_MANAGER, PlannerCmdManager))
@@ -48,6 +49,12 @@ typedef gboolean (*PlannerCmdDoFunc)   (PlannerCmd *cmd);
 typedef void     (*PlannerCmdUndoFunc) (PlannerCmd *cmd);
 typedef void     (*PlannerCmdFreeFunc) (PlannerCmd *cmd);
 
+/* Folds @next into @cmd so that they are undone as one step. Returns TRUE if
+ * merged, in which case @next is freed by the manager.
+ */
+typedef gboolean (*PlannerCmdMergeFunc) (PlannerCmd *cmd,
+					 PlannerCmd *next);
+
 typedef enum {
 	PLANNER_CMD_TYPE_NORMAL = 0,
 	PLANNER_CMD_TYPE_BEGIN_TRANSACTION,
@@ -63,13 +70,29 @@ struct _PlannerCmd {
 	PlannerCmdDoFunc    do_func;
 	PlannerCmdUndoFunc  undo_func;
 	PlannerCmdFreeFunc  free_func;
+	PlannerCmdMergeFunc merge_func;
 
 	PlannerCmdType      type;
+
+	/* Approximate memory held by the command, for the history budget. */
+	gsize               size;
+
+	/* When the command, or the last one merged into it, was inserted. */
+	gint64              time;
 };
 
 
 GType              planner_cmd_manager_get_type          (void) G_GNUC_CONST;
 PlannerCmdManager *planner_cmd_manager_new               (void);
+void               planner_cmd_manager_set_project       (PlannerCmdManager  *manager,
+							  MrpProject         *project);
+void               planner_cmd_manager_set_limits        (PlannerCmdManager  *manager,
+							  gint                limit,
+							  gsize               byte_limit);
+void               planner_cmd_manager_get_stats         (PlannerCmdManager  *manager,
+							  gint               *n_operations,
+							  gint               *n_commands,
+							  gsize              *n_bytes);
 gboolean           planner_cmd_manager_insert_and_do     (PlannerCmdManager  *manager,
 							  PlannerCmd         *cmd);
 gboolean           planner_cmd_manager_undo              (PlannerCmdManager  *manager);
@@ -30,6 +30,13 @@
 #include "planner-gantt-background.h"
 #include "planner-scale-utils.h"
 
+/* The non-working time shading is rendered into tiles of this many pixels,
+ * one pixel high, and repeated down the exposed area.
+ */
+#define TILE_WIDTH 512
+
+/* Drop the whole tile cache when it grows past this. */
+#define MAX_TILES 64
 
 /* Object argument IDs */
 enum {
@@ -56,6 +63,13 @@ struct _PlannerGanttBackgroundPriv {
 	gdouble      zoom;
 	gint	     row_height;
 	gboolean     show_guidelines;
+
+	/* Cached non-working time tiles, tile index -> cairo_surface_t. They
+	 * are valid for tiles_scale and tiles_level only.
+	 */
+	GHashTable  *tiles;
+	gdouble      tiles_scale;
+	gint         tiles_level;
 };
 
 
@@ -91,6 +105,7 @@ gantt_background_project_calendar_notify_cb       (MrpProject             *proje
 						   PlannerGanttBackground      *background);
 static void        gantt_background_set_calendar  (PlannerGanttBackground      *background,
 						   MrpCalendar            *calendar);
+static void        gantt_background_clear_tiles   (PlannerGanttBackground      *background);
 
 
 static GnomeCanvasItemClass *parent_class;
@@ -212,6 +227,10 @@ gantt_background_init (PlannerGanttBackground *background)
 	priv->timeline = mrp_time_current_time ();
 	priv->row_height = 0;
 	priv->show_guidelines = FALSE;
+
+	priv->tiles = g_hash_table_new_full (NULL, NULL, NULL,
+					     (GDestroyNotify) cairo_surface_destroy);
+	priv->tiles_level = -1;
 }
 
 static void
@@ -230,6 +249,15 @@ gantt_background_finalize (GObject *object)
 		priv->timeout_id = 0;
 	}
 
+	if (priv->calendar) {
+		g_signal_handlers_disconnect_by_func (
+			priv->calendar,
+			gantt_background_calendar_changed,
+			background);
+	}
+
+	g_hash_table_destroy (priv->tiles);
+
 	g_free (priv);
 	background->priv = NULL;
 
@@ -380,6 +408,9 @@ gantt_background_unrealize (GnomeCanvasItem *item)
 	g_object_unref (background->priv->layout);
 	background->priv->layout = NULL;
 
+	/* The tiles are created similar to the canvas window's surface. */
+	gantt_background_clear_tiles (background);
+
 	GNOME_CANVAS_ITEM_CLASS (parent_class)->unrealize (item);
 }
 
@@ -399,6 +430,141 @@ gantt_background_update_timeline (gpointer data)
 	return TRUE;
 }
 
+static gint
+gantt_background_get_tile_index (gint px)
+{
+	/* Round towards minus infinity. */
+	if (px < 0) {
+		return -((-px - 1) / TILE_WIDTH) - 1;
+	}
+
+	return px / TILE_WIDTH;
+}
+
+static void
+gantt_background_clear_tiles (PlannerGanttBackground *background)
+{
+	g_hash_table_remove_all (background->priv->tiles);
+}
+
+static void
+gantt_background_draw_nonworking (cairo_t *cr,
+				  gdouble  hscale,
+				  gint     offset,
+				  mrptime  start,
+				  mrptime  end)
+{
+	gint cx1, cx2;
+
+	cx1 = floor (start * hscale + 0.5) - offset;
+	cx2 = floor (end * hscale + 0.5) - offset;
+
+	cairo_set_source_rgb (cr, 245/255., 245/255., 245/255.); /* grey96 */
+	cairo_rectangle (cr, cx1, 0, cx2 - cx1, 1);
+	cairo_fill (cr);
+
+	cairo_set_source_rgb (cr, 204/255., 204/255., 204/255.); /* grey80 */
+	cairo_rectangle (cr, cx1, 0, 1, 1);
+	cairo_fill (cr);
+}
+
+/* Renders the non-working time of the project calendar between pixels
+ * [index * TILE_WIDTH, (index + 1) * TILE_WIDTH) of the world into a one
+ * pixel high tile, or returns the cached one.
+ */
+static cairo_surface_t *
+gantt_background_get_tile (PlannerGanttBackground *background,
+			   cairo_t                *target,
+			   gint                    index)
+{
+	PlannerGanttBackgroundPriv *priv;
+	cairo_surface_t            *tile;
+	cairo_t                    *cr;
+	gdouble                     hscale;
+	gint                        level;
+	gint                        offset;
+	mrptime                     t1, t2;
+	mrptime                     ival_start, ival_end, ival_prev;
+	MrpDay                     *day;
+	GList                      *ivals, *l;
+	MrpInterval                *ival;
+
+	priv = background->priv;
+
+	if (!priv->calendar) {
+		return NULL;
+	}
+
+	tile = g_hash_table_lookup (priv->tiles, GINT_TO_POINTER (index));
+	if (tile) {
+		return tile;
+	}
+
+	if (g_hash_table_size (priv->tiles) >= MAX_TILES) {
+		gantt_background_clear_tiles (background);
+	}
+
+	hscale = priv->tiles_scale;
+	level = priv->tiles_level;
+	offset = index * TILE_WIDTH;
+
+	tile = cairo_surface_create_similar (cairo_get_target (target),
+					     CAIRO_CONTENT_COLOR_ALPHA,
+					     TILE_WIDTH, 1);
+	cr = cairo_create (tile);
+
+	t1 = floor (offset / hscale + 0.5);
+	t2 = floor ((offset + TILE_WIDTH) / hscale + 0.5);
+
+	t1 = mrp_time_align_day (t1 - 24*60*60);
+	t2 = mrp_time_align_day (t2 + 24*60*60);
+
+	/* Loop through the days between t1 and t2. */
+	while (t1 <= t2) {
+		day = mrp_calendar_get_day (priv->calendar, t1, TRUE);
+
+		ivals = mrp_calendar_day_get_intervals (priv->calendar, day, TRUE);
+
+		ival_prev = t1;
+
+		/* Loop through the intervals for this day. */
+		for (l = ivals; l; l = l->next) {
+			ival = l->data;
+
+			mrp_interval_get_absolute (ival,
+						   t1,
+						   &ival_start,
+						   &ival_end);
+
+			/* Draw the section between the end of the last working
+			 * time interval and the start of the current one,
+			 * i.e. [ival_prev, ival_start], unless it's shorter
+			 * than what we want at this zoom level.
+			 */
+			if (planner_scale_conf[level].nonworking_limit <= ival_start - ival_prev) {
+				gantt_background_draw_nonworking (cr, hscale, offset,
+								  ival_prev, ival_start);
+			}
+
+			ival_prev = ival_end;
+		}
+
+		t1 += 60*60*24;
+
+		/* Draw the remaining interval if there is one. */
+		if (ival_prev < t1 && planner_scale_conf[level].nonworking_limit <= t1 - ival_prev) {
+			gantt_background_draw_nonworking (cr, hscale, offset,
+							  ival_prev, t1);
+		}
+	}
+
+	cairo_destroy (cr);
+
+	g_hash_table_insert (priv->tiles, GINT_TO_POINTER (index), tile);
+
+	return tile;
+}
+
 static void
 gantt_background_draw (GnomeCanvasItem *item,
 		       cairo_t         *cr,
@@ -409,20 +575,18 @@ gantt_background_draw (GnomeCanvasItem *item,
 {
 	PlannerGanttBackground     *background;
 	PlannerGanttBackgroundPriv *priv;
-	gint                   cx1, cx2;  /* Canvas pixel coordinates */
+	gint                   cx1;       /* Canvas pixel coordinates */
 	gint                   cy1, cy2;
 	gdouble                wx1, wx2;  /* World coordinates */
 	gdouble                hscale;
 	mrptime                t0;
 	mrptime                t1, t2;    /* First and last exposed times */
-	mrptime                ival_start, ival_end, ival_prev;
-	MrpCalendar           *calendar;
-	MrpDay                *day;
-	GList                 *ivals, *l;
-	MrpInterval           *ival;
 	gint                   level;
 	gdouble                i2w_dx,i2w_dy;
 	gint                   xx,yy;
+	gint                   origin, tile_x;
+	gint                   tile_index, first_tile, last_tile;
+	cairo_surface_t       *tile;
 
 	background = PLANNER_GANTT_BACKGROUND (item);
 	priv = background->priv;
@@ -435,8 +599,6 @@ gantt_background_draw (GnomeCanvasItem *item,
 	cairo_set_line_width (cr, 1.0);
 	cairo_set_line_cap (cr, CAIRO_LINE_CAP_SQUARE);
 
-	calendar = mrp_project_get_calendar (priv->project);
-
 	hscale = priv->hscale;
 	level = planner_scale_clamp_zoom (priv->zoom);
 
@@ -449,77 +611,33 @@ gantt_background_draw (GnomeCanvasItem *item,
 	t1 = floor (wx1 / hscale + 0.5);
 	t2 = floor (wx2 / hscale + 0.5);
 
-	t0 = t1 = mrp_time_align_day (t1 - 24*60*60);
+	t0 = mrp_time_align_day (t1 - 24*60*60);
 	t2 = mrp_time_align_day (t2 + 24*60*60);
 
-	/* Loop through the days between t0 and t2. */
-	while (t1 <= t2) {
-		day = mrp_calendar_get_day (calendar, t1, TRUE);
-
-		ivals = mrp_calendar_day_get_intervals (calendar, day, TRUE);
-
-		ival_prev = t1;
-
-		/* Loop through the intervals for this day. */
-		for (l = ivals; l; l = l->next) {
-			ival = l->data;
-
-			mrp_interval_get_absolute (ival,
-						   t1,
-						   &ival_start,
-						   &ival_end);
-
-			/* Draw the section between the end of the last working
-			 * time interval and the start of the current one,
-			 * i.e. [ival_prev, ival_start].
-			 */
-
-			wx1 = ival_prev * hscale;
-			wx2 = ival_start * hscale;
-
-			gnome_canvas_w2c (item->canvas, wx1, 0, &cx1, NULL);
-			gnome_canvas_w2c (item->canvas, wx2, 0, &cx2, NULL);
+	if (priv->tiles_scale != hscale || priv->tiles_level != level) {
+		gantt_background_clear_tiles (background);
+		priv->tiles_scale = hscale;
+		priv->tiles_level = level;
+	}
 
-			/* Don't draw if the interval is shorter than what we
-			 * want at this zoom level.
-			 */
-			if (planner_scale_conf[level].nonworking_limit <= ival_start - ival_prev) {
-				cairo_set_source_rgb (cr, 245/255., 245/255., 245/255.); /* grey96 */
-				cairo_rectangle (cr,
-						 cx1 - x, cy1 - y,
-						 cx2 - cx1, cy2 - cy1);
-				cairo_fill (cr);
+	/* Canvas x of the world origin, the tiles are laid out from there. */
+	gnome_canvas_w2c (item->canvas, 0, 0, &origin, NULL);
 
-				cairo_set_source_rgb (cr, 204/255., 204/255., 204/255.); /* grey80 */
-				cairo_move_to (cr, cx1 - x + 0.5, cy1 - y + 0.5);
-				cairo_line_to (cr, cx1 - x + 0.5, cy2 - y + 0.5);
-				cairo_stroke (cr);
-			}
+	first_tile = gantt_background_get_tile_index (x - origin);
+	last_tile = gantt_background_get_tile_index (x + width - origin);
 
-			ival_prev = ival_end;
+	for (tile_index = first_tile; tile_index <= last_tile; tile_index++) {
+		tile = gantt_background_get_tile (background, cr, tile_index);
+		if (!tile) {
+			continue;
 		}
 
-		t1 += 60*60*24;
+		tile_x = origin + tile_index * TILE_WIDTH - x;
 
-		/* Draw the remaining interval if there is one. */
-		if (ival_prev < t1 && planner_scale_conf[level].nonworking_limit <= t1 - ival_prev) {
-			wx1 = ival_prev * hscale;
-			wx2 = t1 * hscale;
-
-			gnome_canvas_w2c (item->canvas, wx1, 0, &cx1, NULL);
-			gnome_canvas_w2c (item->canvas, wx2, 0, &cx2, NULL);
-
-			cairo_set_source_rgb (cr, 245/255., 245/255., 245/255.); /* grey96 */
-			cairo_rectangle (cr,
-					 cx1 - x, cy1 - y,
-					 cx2 - cx1, cy2 - cy1);
-			cairo_fill (cr);
-
-			cairo_set_source_rgb (cr, 204/255., 204/255., 204/255.); /* grey80 */
-			cairo_move_to (cr, cx1 - x + 0.5, cy1 - y + 0.5);
-			cairo_line_to (cr, cx1 - x + 0.5, cy2 - y + 0.5);
-			cairo_stroke (cr);
-		}
+		cairo_set_source_surface (cr, tile, tile_x, 0);
+		cairo_pattern_set_extend (cairo_get_source (cr), CAIRO_EXTEND_REPEAT);
+		cairo_rectangle (cr, tile_x, 0, TILE_WIDTH, height);
+		cairo_fill (cr);
 	}
 
 	/* Guidelines */
@@ -615,6 +733,8 @@ static void
 gantt_background_calendar_changed (MrpCalendar       *calendar,
 				   PlannerGanttBackground *background)
 {
+	gantt_background_clear_tiles (background);
+
 	gnome_canvas_item_request_update (GNOME_CANVAS_ITEM (background));
 }
 
@@ -658,5 +778,7 @@ gantt_background_set_calendar (PlannerGanttBackground *background,
 
 	priv->calendar = calendar;
 
+	gantt_background_clear_tiles (background);
+
 	gnome_canvas_item_request_update (GNOME_CANVAS_ITEM (background));
 }
@@ -54,6 +54,11 @@
 /* Font width factor. */
 static gdouble font_width_factor = 1.0;
 
+/* Arrows this far outside the visible area are still routed, so short
+ * scrolls don't show them lagging behind.
+ */
+#define ARROW_ROUTE_MARGIN 50.0
+
 #define CRITICAL_PATH_KEY  "highlight-critical-path"
 #define NOSTDDAYS_PATH_KEY "display-nonstandard-days"
 #define GUIDELINES_PATH_KEY "show-guidelines"
@@ -91,6 +96,11 @@ struct _PlannerGanttChartPriv {
 
 	GHashTable      *relation_hash;
 
+	/* Arrows waiting to be routed, see gantt_chart_route_arrows(). */
+	GHashTable      *dirty_arrows;
+	guint            route_idle_id;
+	guint            n_arrow_routes;
+
 	GnomeCanvasItem *background;
 
 	gdouble          zoom;
@@ -191,6 +201,10 @@ static void        gantt_chart_task_removed             (MrpTask            *tas
 static void        gantt_chart_build_tree               (PlannerGanttChart  *chart);
 static void        gantt_chart_reflow                   (PlannerGanttChart  *chart,
 							 gboolean            height_changed);
+static void        gantt_chart_queue_arrow              (PlannerGanttChart  *chart,
+							 PlannerRelationArrow *arrow);
+static void        gantt_chart_route_arrows             (PlannerGanttChart  *chart);
+static void        gantt_chart_queue_route              (PlannerGanttChart  *chart);
 static TreeNode *  gantt_chart_insert_task              (PlannerGanttChart  *chart,
 							 GtkTreePath        *path,
 							 MrpTask            *task);
@@ -397,6 +411,8 @@ gantt_chart_init (PlannerGanttChart *chart)
 						  NULL);
 
 	priv->relation_hash = g_hash_table_new (NULL, NULL);
+	priv->dirty_arrows = g_hash_table_new_full (NULL, NULL,
+						    g_object_unref, NULL);
 
 	priv->highlight_critical = planner_conf_get_bool (CRITICAL_PATH_KEY,
 							  "gantt");
@@ -505,6 +521,7 @@ gantt_chart_finalize (GObject *object)
 	PlannerGanttChart *chart = PLANNER_GANTT_CHART (object);
 
 	g_hash_table_destroy (chart->priv->relation_hash);
+	g_hash_table_destroy (chart->priv->dirty_arrows);
 
 	g_free (chart->priv);
 
@@ -520,6 +537,23 @@ gantt_chart_destroy (GtkWidget *widget)
 
 	planner_gantt_chart_set_model (chart, NULL);
 
+	if (chart->priv->route_idle_id != 0) {
+		g_source_remove (chart->priv->route_idle_id);
+		chart->priv->route_idle_id = 0;
+	}
+
+	g_hash_table_remove_all (chart->priv->dirty_arrows);
+
+	if (chart->priv->hadjustment != NULL) {
+		g_signal_handlers_disconnect_by_data (chart->priv->hadjustment,
+						      chart);
+	}
+
+	if (chart->priv->vadjustment != NULL) {
+		g_signal_handlers_disconnect_by_data (chart->priv->vadjustment,
+						      chart);
+	}
+
 	/* FIXME: free more stuff. */
 	if (chart->priv->tree != NULL) {
 		gantt_chart_remove_children (chart, chart->priv->tree);
@@ -643,6 +677,9 @@ gantt_chart_size_allocate (GtkWidget     *widget,
 	if (gtk_widget_get_mapped (GTK_WIDGET (chart))) {
 		planner_gantt_chart_reflow_now (chart);
 	}
+
+	/* A larger view can show arrows that are still waiting. */
+	gantt_chart_queue_route (chart);
 }
 
 static void
@@ -665,8 +702,13 @@ gantt_chart_set_hadjustment (PlannerGanttChart *chart,
 		g_object_unref (chart->priv->hadjustment);
 	}
 
-	/* TODO: value-changed handler? If not adding, disconnecting above is probably unnecessary too */
 	chart->priv->hadjustment = g_object_ref_sink (hadj);
+
+	/* Arrows scrolled into view may still need routing. */
+	g_signal_connect_swapped (hadj,
+				  "value-changed",
+				  G_CALLBACK (gantt_chart_queue_route),
+				  chart);
 	/* TODO: Do we need to set the initial hadj values? */
 	/* TODO: Share the hadjustment with header and canvas? */
 
@@ -693,8 +735,15 @@ gantt_chart_set_vadjustment (PlannerGanttChart *chart,
 		g_object_unref (chart->priv->vadjustment);
 	}
 
-	/* TODO: value-changed handler? If not adding, disconnecting above is probably unnecessary too */
 	chart->priv->vadjustment = g_object_ref_sink (vadj);
+
+	/* Arrows scrolled into view may still need routing. The canvas
+	 * scrolls from its own handler, so route once it has.
+	 */
+	g_signal_connect_swapped (vadj,
+				  "value-changed",
+				  G_CALLBACK (gantt_chart_queue_route),
+				  chart);
 	/* TODO: Do we need to set the initial vadj values? */
 	/* TODO: Share the vadjustment with canvas? */
 
@@ -1071,6 +1120,9 @@ gantt_chart_reflow_idle (PlannerGanttChart *chart)
 	priv->height_changed = FALSE;
 	priv->reflow_idle_id = 0;
 
+	/* The rows are in place now, route the arrows they moved in one go. */
+	gantt_chart_route_arrows (chart);
+
 	return FALSE;
 }
 
@@ -1084,6 +1136,17 @@ planner_gantt_chart_reflow_now (PlannerGanttChart *chart)
 	gantt_chart_reflow_idle (chart);
 }
 
+/* Number of times a relation arrow has been routed, for checking how much
+ * work a change causes.
+ */
+guint
+planner_gantt_chart_get_n_arrow_routes (PlannerGanttChart *chart)
+{
+	g_return_val_if_fail (PLANNER_IS_GANTT_CHART (chart), 0);
+
+	return chart->priv->n_arrow_routes;
+}
+
 static void
 gantt_chart_reflow (PlannerGanttChart *chart, gboolean height_changed)
 {
@@ -1100,6 +1163,201 @@ gantt_chart_reflow (PlannerGanttChart *chart, gboolean height_changed)
 	chart->priv->reflow_idle_id = g_idle_add ((GSourceFunc) gantt_chart_reflow_idle, chart);
 }
 
+static void
+gantt_chart_get_visible_region (PlannerGanttChart *chart,
+				gdouble           *x1,
+				gdouble           *y1,
+				gdouble           *x2,
+				gdouble           *y2)
+{
+	PlannerGanttChartPriv *priv;
+	GtkAllocation          allocation;
+	gint                   cx, cy;
+
+	priv = chart->priv;
+
+	gtk_widget_get_allocation (GTK_WIDGET (priv->canvas), &allocation);
+	gnome_canvas_get_scroll_offsets (priv->canvas, &cx, &cy);
+
+	gnome_canvas_c2w (priv->canvas, cx, cy, x1, y1);
+	gnome_canvas_c2w (priv->canvas,
+			  cx + allocation.width,
+			  cy + allocation.height,
+			  x2, y2);
+}
+
+static gboolean
+gantt_chart_arrow_is_visible (PlannerRelationArrow *arrow,
+			      gdouble               vx1,
+			      gdouble               vy1,
+			      gdouble               vx2,
+			      gdouble               vy2)
+{
+	gdouble px1, py1, px2, py2;
+	gdouble sx1, sy1, sx2, sy2;
+
+	if (!(GNOME_CANVAS_ITEM (arrow)->flags & GNOME_CANVAS_ITEM_VISIBLE)) {
+		return FALSE;
+	}
+
+	planner_gantt_row_get_geometry (planner_relation_arrow_get_predecessor (arrow),
+					&px1, &py1, &px2, &py2);
+	planner_gantt_row_get_geometry (planner_relation_arrow_get_successor (arrow),
+					&sx1, &sy1, &sx2, &sy2);
+
+	/* The arrow stays within the box spanned by its two rows, so it can
+	 * cross the view even if both rows are outside of it.
+	 */
+	if (MAX (px2, sx2) + ARROW_ROUTE_MARGIN < vx1 ||
+	    MIN (px1, sx1) - ARROW_ROUTE_MARGIN > vx2) {
+		return FALSE;
+	}
+
+	if (MAX (py2, sy2) + ARROW_ROUTE_MARGIN < vy1 ||
+	    MIN (py1, sy1) - ARROW_ROUTE_MARGIN > vy2) {
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Routes the queued arrows that are visible. Arrows outside the view keep
+ * their old segments and stay queued until they are scrolled into view.
+ */
+static void
+gantt_chart_route_arrows (PlannerGanttChart *chart)
+{
+	PlannerGanttChartPriv *priv;
+	PlannerRelationArrow  *arrow;
+	GHashTableIter         iter;
+	gpointer               key;
+	gdouble                vx1, vy1, vx2, vy2;
+
+	priv = chart->priv;
+
+	if (priv->route_idle_id != 0) {
+		g_source_remove (priv->route_idle_id);
+		priv->route_idle_id = 0;
+	}
+
+	if (g_hash_table_size (priv->dirty_arrows) == 0) {
+		return;
+	}
+
+	gantt_chart_get_visible_region (chart, &vx1, &vy1, &vx2, &vy2);
+
+	g_hash_table_iter_init (&iter, priv->dirty_arrows);
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		arrow = key;
+
+		if (planner_relation_arrow_get_predecessor (arrow) == NULL ||
+		    planner_relation_arrow_get_successor (arrow) == NULL) {
+			g_hash_table_iter_remove (&iter);
+			continue;
+		}
+
+		if (!gantt_chart_arrow_is_visible (arrow, vx1, vy1, vx2, vy2)) {
+			continue;
+		}
+
+		planner_relation_arrow_update (arrow);
+		priv->n_arrow_routes++;
+
+		g_hash_table_iter_remove (&iter);
+	}
+}
+
+static gboolean
+gantt_chart_route_idle (PlannerGanttChart *chart)
+{
+	chart->priv->route_idle_id = 0;
+
+	gantt_chart_route_arrows (chart);
+
+	return FALSE;
+}
+
+static void
+gantt_chart_queue_route (PlannerGanttChart *chart)
+{
+	PlannerGanttChartPriv *priv;
+
+	priv = chart->priv;
+
+	if (g_hash_table_size (priv->dirty_arrows) == 0) {
+		return;
+	}
+
+	/* A pending reflow routes the arrows when it's done. */
+	if (priv->reflow_idle_id != 0 || priv->route_idle_id != 0) {
+		return;
+	}
+
+	/* Same priority as the row change queue, so that the arrows catch up
+	 * with the rows before the frame is drawn.
+	 */
+	priv->route_idle_id = g_idle_add_full (GDK_PRIORITY_REDRAW - 1,
+					       (GSourceFunc) gantt_chart_route_idle,
+					       chart, NULL);
+}
+
+static void
+gantt_chart_queue_arrow (PlannerGanttChart    *chart,
+			 PlannerRelationArrow *arrow)
+{
+	PlannerGanttChartPriv *priv;
+
+	priv = chart->priv;
+
+	if (!g_hash_table_contains (priv->dirty_arrows, arrow)) {
+		g_hash_table_add (priv->dirty_arrows, g_object_ref (arrow));
+	}
+
+	gantt_chart_queue_route (chart);
+}
+
+static void
+gantt_chart_queue_task_arrows (PlannerGanttChart *chart,
+			       MrpTask           *task)
+{
+	PlannerRelationArrow *arrow;
+	GList                *l;
+
+	for (l = mrp_task_get_predecessor_relations (task); l; l = l->next) {
+		arrow = g_hash_table_lookup (chart->priv->relation_hash, l->data);
+		if (arrow) {
+			gantt_chart_queue_arrow (chart, arrow);
+		}
+	}
+
+	for (l = mrp_task_get_successor_relations (task); l; l = l->next) {
+		arrow = g_hash_table_lookup (chart->priv->relation_hash, l->data);
+		if (arrow) {
+			gantt_chart_queue_arrow (chart, arrow);
+		}
+	}
+}
+
+static void
+gantt_chart_row_geometry_changed (PlannerGanttRow   *row,
+				  gdouble            x1,
+				  gdouble            y1,
+				  gdouble            x2,
+				  gdouble            y2,
+				  PlannerGanttChart *chart)
+{
+	MrpTask *task;
+
+	g_object_get (row, "task", &task, NULL);
+	if (task == NULL) {
+		return;
+	}
+
+	gantt_chart_queue_task_arrows (chart, task);
+
+	g_object_unref (task);
+}
+
 static TreeNode *
 gantt_chart_insert_task (PlannerGanttChart *chart,
 			 GtkTreePath  *path,
@@ -1124,6 +1382,15 @@ gantt_chart_insert_task (PlannerGanttChart *chart,
 
 	gantt_chart_tree_node_insert_path (priv->tree, path, tree_node);
 
+	/* The chart routes the arrows instead of each arrow following its
+	 * rows, so that a row moving many times in a frame costs one pass.
+	 */
+	g_signal_connect_object (item,
+				 "geometry-changed",
+				 G_CALLBACK (gantt_chart_row_geometry_changed),
+				 chart,
+				 0);
+
 	g_signal_connect (task,
 			  "relation-added",
 			  G_CALLBACK (gantt_chart_relation_added),
@@ -1148,9 +1415,14 @@ gantt_chart_add_relation (PlannerGanttChart *chart,
 			  TreeNode          *predecessor,
 			  MrpRelationType    type)
 {
-	return planner_relation_arrow_new (PLANNER_GANTT_ROW (task->item),
-					   PLANNER_GANTT_ROW (predecessor->item),
-					   type);
+	PlannerRelationArrow *arrow;
+
+	arrow = planner_relation_arrow_new (PLANNER_GANTT_ROW (task->item),
+					    PLANNER_GANTT_ROW (predecessor->item),
+					    type);
+	gantt_chart_queue_arrow (chart, arrow);
+
+	return arrow;
 }
 
 static void
@@ -1327,6 +1599,7 @@ gantt_chart_relation_removed (MrpTask           *task,
 	arrow = g_hash_table_lookup (chart->priv->relation_hash, relation);
 	if (arrow != NULL) {
 		g_hash_table_remove (chart->priv->relation_hash, relation);
+		g_hash_table_remove (chart->priv->dirty_arrows, arrow);
 
 		g_object_run_dispose (G_OBJECT (arrow));
 		gantt_chart_reflow (chart, FALSE);
@@ -1380,6 +1653,7 @@ gantt_chart_task_moved_task_traverse_func (MrpTask *task, PlannerGanttChart *cha
 		arrow = g_hash_table_lookup (priv->relation_hash, relation);
 		if (arrow) {
 			planner_relation_arrow_set_successor (arrow, row);
+			gantt_chart_queue_arrow (chart, arrow);
 		}
 	}
 
@@ -1390,6 +1664,7 @@ gantt_chart_task_moved_task_traverse_func (MrpTask *task, PlannerGanttChart *cha
 		arrow = g_hash_table_lookup (priv->relation_hash, relation);
 		if (arrow) {
 			planner_relation_arrow_set_predecessor (arrow, row);
+			gantt_chart_queue_arrow (chart, arrow);
 		}
 	}
 
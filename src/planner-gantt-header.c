@@ -32,6 +32,28 @@
 #include "planner-gantt-model.h"
 #include "planner-scale-utils.h"
 
+/* The most ticks kept per scale, enough for several screens of scrolling at
+ * any zoom level.
+ */
+#define MAX_CACHED_TICKS 1024
+
+typedef struct {
+	mrptime      t;
+
+	/* Created the first time the tick is drawn. */
+	PangoLayout *layout;
+} GanttHeaderTick;
+
+/* Ticks of one scale, for a contiguous time range. The last tick only marks
+ * the end of the one before it. They only depend on the unit and format, so
+ * they stay valid when scrolling or changing the scale factor.
+ */
+typedef struct {
+	MrpTimeUnit         unit;
+	PlannerScaleFormat  format;
+
+	GArray             *ticks;
+} GanttHeaderScale;
 
 struct _PlannerGanttHeaderPriv {
 	GdkWindow          *bin_window;
@@ -40,13 +62,8 @@ struct _PlannerGanttHeaderPriv {
 	guint               hscroll_policy : 1;
 	guint               vscroll_policy : 1;
 
-	PangoLayout        *layout;
-
-	MrpTimeUnit    major_unit;
-	PlannerScaleFormat  major_format;
-
-	MrpTimeUnit    minor_unit;
-	PlannerScaleFormat  minor_format;
+	GanttHeaderScale    major;
+	GanttHeaderScale    minor;
 
 	gdouble             hscale;
 
@@ -93,6 +110,7 @@ static void     gantt_header_get_property        (GObject                 *objec
 static void     gantt_header_map                 (GtkWidget               *widget);
 static void     gantt_header_realize             (GtkWidget               *widget);
 static void     gantt_header_unrealize           (GtkWidget               *widget);
+static void     gantt_header_style_updated       (GtkWidget               *widget);
 static void     gantt_header_size_allocate       (GtkWidget               *widget,
 						  GtkAllocation           *allocation);
 static gboolean gantt_header_draw                (GtkWidget               *widget,
@@ -170,6 +188,7 @@ gantt_header_class_init (PlannerGanttHeaderClass *class)
 	widget_class->map = gantt_header_map;;
 	widget_class->realize = gantt_header_realize;
 	widget_class->unrealize = gantt_header_unrealize;
+	widget_class->style_updated = gantt_header_style_updated;
 	widget_class->size_allocate = gantt_header_size_allocate;
 	widget_class->draw = gantt_header_draw;
 	widget_class->leave_notify_event = gantt_header_leave_notify_event;
@@ -255,11 +274,167 @@ gantt_header_init (PlannerGanttHeader *header)
 	priv->height = -1;
 	priv->width = -1;
 
-	priv->major_unit = MRP_TIME_UNIT_MONTH;
-	priv->minor_unit = MRP_TIME_UNIT_WEEK;
+	priv->major.unit = MRP_TIME_UNIT_MONTH;
+	priv->major.ticks = g_array_new (FALSE, FALSE, sizeof (GanttHeaderTick));
+
+	priv->minor.unit = MRP_TIME_UNIT_WEEK;
+	priv->minor.ticks = g_array_new (FALSE, FALSE, sizeof (GanttHeaderTick));
+}
+
+static void
+gantt_header_scale_clear (GanttHeaderScale *scale)
+{
+	GanttHeaderTick *tick;
+	guint            i;
+
+	for (i = 0; i < scale->ticks->len; i++) {
+		tick = &g_array_index (scale->ticks, GanttHeaderTick, i);
+
+		if (tick->layout) {
+			g_object_unref (tick->layout);
+		}
+	}
+
+	g_array_set_size (scale->ticks, 0);
+}
+
+static void
+gantt_header_scale_set (GanttHeaderScale   *scale,
+			MrpTimeUnit         unit,
+			PlannerScaleFormat  format)
+{
+	if (scale->unit == unit && scale->format == format) {
+		return;
+	}
+
+	gantt_header_scale_clear (scale);
 
-	priv->layout = gtk_widget_create_pango_layout (GTK_WIDGET (header),
-						       NULL);
+	scale->unit = unit;
+	scale->format = format;
+}
+
+/* Drops @n ticks starting at @index. */
+static void
+gantt_header_scale_remove (GanttHeaderScale *scale,
+			   guint             index,
+			   guint             n)
+{
+	GanttHeaderTick *tick;
+	guint            i;
+
+	for (i = index; i < index + n; i++) {
+		tick = &g_array_index (scale->ticks, GanttHeaderTick, i);
+
+		if (tick->layout) {
+			g_object_unref (tick->layout);
+		}
+	}
+
+	g_array_remove_range (scale->ticks, index, n);
+}
+
+/* Returns the index of the last tick at or before @t. */
+static guint
+gantt_header_scale_find (GanttHeaderScale *scale,
+			 mrptime           t)
+{
+	guint lo, hi, mid;
+
+	lo = 0;
+	hi = scale->ticks->len - 1;
+
+	while (lo < hi) {
+		mid = (lo + hi + 1) / 2;
+
+		if (g_array_index (scale->ticks, GanttHeaderTick, mid).t <= t) {
+			lo = mid;
+		} else {
+			hi = mid - 1;
+		}
+	}
+
+	return lo;
+}
+
+/* Makes sure the ticks from the one at or before @t0 up to the first one
+ * after @t1 are computed, and returns the index of the first one.
+ */
+static guint
+gantt_header_scale_ensure (GanttHeaderScale *scale,
+			   mrptime           t0,
+			   mrptime           t1)
+{
+	GanttHeaderTick  tick = { 0 };
+	GanttHeaderTick *first, *last;
+	guint            index, end;
+
+	if (scale->ticks->len > 0) {
+		first = &g_array_index (scale->ticks, GanttHeaderTick, 0);
+		last = &g_array_index (scale->ticks, GanttHeaderTick, scale->ticks->len - 1);
+
+		/* Start over if we jumped away from the cached range. */
+		if (t1 < first->t || t0 > last->t) {
+			gantt_header_scale_clear (scale);
+		}
+	}
+
+	if (scale->ticks->len == 0) {
+		tick.t = mrp_time_align_prev (t0, scale->unit);
+		g_array_append_val (scale->ticks, tick);
+	}
+
+	while (g_array_index (scale->ticks, GanttHeaderTick, 0).t > t0) {
+		tick.t = mrp_time_align_prev (
+			g_array_index (scale->ticks, GanttHeaderTick, 0).t - 1,
+			scale->unit);
+		g_array_prepend_val (scale->ticks, tick);
+	}
+
+	while (g_array_index (scale->ticks, GanttHeaderTick, scale->ticks->len - 1).t <= t1) {
+		tick.t = mrp_time_align_next (
+			g_array_index (scale->ticks, GanttHeaderTick, scale->ticks->len - 1).t,
+			scale->unit);
+		g_array_append_val (scale->ticks, tick);
+	}
+
+	index = gantt_header_scale_find (scale, t0);
+
+	/* Keep the cache bounded, dropping the ticks furthest away first. */
+	if (scale->ticks->len > MAX_CACHED_TICKS && index > 0) {
+		gantt_header_scale_remove (scale, 0, MIN (index, scale->ticks->len - MAX_CACHED_TICKS));
+		index = gantt_header_scale_find (scale, t0);
+	}
+
+	if (scale->ticks->len > MAX_CACHED_TICKS) {
+		end = gantt_header_scale_find (scale, t1) + 2;
+
+		if (end < scale->ticks->len) {
+			gantt_header_scale_remove (scale, end,
+						   MIN (scale->ticks->len - end,
+							scale->ticks->len - MAX_CACHED_TICKS));
+		}
+	}
+
+	return index;
+}
+
+static PangoLayout *
+gantt_header_get_tick_layout (PlannerGanttHeader *header,
+			      GanttHeaderScale   *scale,
+			      GanttHeaderTick    *tick)
+{
+	gchar *str;
+
+	if (!tick->layout) {
+		str = planner_scale_format_time (tick->t,
+						 scale->unit,
+						 scale->format);
+		tick->layout = gtk_widget_create_pango_layout (GTK_WIDGET (header),
+							       str);
+		g_free (str);
+	}
+
+	return tick->layout;
 }
 
 static void
@@ -272,11 +447,13 @@ gantt_header_set_zoom (PlannerGanttHeader *header, gdouble zoom)
 
 	level = planner_scale_clamp_zoom (zoom);
 
-	priv->major_unit = planner_scale_conf[level].major_unit;
-	priv->major_format = planner_scale_conf[level].major_format;
+	gantt_header_scale_set (&priv->major,
+				planner_scale_conf[level].major_unit,
+				planner_scale_conf[level].major_format);
 
-	priv->minor_unit = planner_scale_conf[level].minor_unit;
-	priv->minor_format = planner_scale_conf[level].minor_format;
+	gantt_header_scale_set (&priv->minor,
+				planner_scale_conf[level].minor_unit,
+				planner_scale_conf[level].minor_format);
 }
 
 static void
@@ -405,7 +582,11 @@ gantt_header_finalize (GObject *object)
 {
 	PlannerGanttHeader *header = PLANNER_GANTT_HEADER (object);
 
-	g_object_unref (header->priv->layout);
+	gantt_header_scale_clear (&header->priv->major);
+	g_array_free (header->priv->major.ticks, TRUE);
+
+	gantt_header_scale_clear (&header->priv->minor);
+	g_array_free (header->priv->minor.ticks, TRUE);
 
 	g_free (header->priv->date_hint);
 
@@ -497,6 +678,22 @@ gantt_header_unrealize (GtkWidget *widget)
 	}
 }
 
+static void
+gantt_header_style_updated (GtkWidget *widget)
+{
+	PlannerGanttHeader *header;
+
+	header = PLANNER_GANTT_HEADER (widget);
+
+	/* The labels are shaped with the widget font. */
+	gantt_header_scale_clear (&header->priv->major);
+	gantt_header_scale_clear (&header->priv->minor);
+
+	if (GTK_WIDGET_CLASS (parent_class)->style_updated) {
+		GTK_WIDGET_CLASS (parent_class)->style_updated (widget);
+	}
+}
+
 static void
 gantt_header_size_allocate (GtkWidget     *widget,
 			    GtkAllocation *allocation)
@@ -532,8 +729,9 @@ gantt_header_draw (GtkWidget *widget,
 	gint                    x, tr_x, tr_y;
 	mrptime                 t0;
 	mrptime                 t1;
-	mrptime                 t;
-	gchar                  *str;
+	GanttHeaderTick        *tick;
+	guint                   i;
+	gint                    width;
 	gint                    minor_width;
 	gint                    major_width;
 	GdkRGBA text_color = { 0.0, 0.0, 0.0, 1.0 }; /* Fallback to black */
@@ -586,22 +784,33 @@ gantt_header_draw (GtkWidget *widget,
 	/* Get the widths of major/minor ticks so that we know how wide to make
 	 * the clip region.
 	 */
-	major_width = hscale * (mrp_time_align_next (t0, priv->major_unit) -
-				mrp_time_align_prev (t0, priv->major_unit));
+	if (priv->major.unit != MRP_TIME_UNIT_NONE) {
+		i = gantt_header_scale_ensure (&priv->major, t0, t0);
+		tick = &g_array_index (priv->major.ticks, GanttHeaderTick, i);
+		major_width = hscale * ((tick + 1)->t - tick->t);
+	} else {
+		major_width = 0;
+	}
 
-	minor_width = hscale * (mrp_time_align_next (t0, priv->minor_unit) -
-				mrp_time_align_prev (t0, priv->minor_unit));
+	if (priv->minor.unit != MRP_TIME_UNIT_NONE) {
+		i = gantt_header_scale_ensure (&priv->minor, t0, t0);
+		tick = &g_array_index (priv->minor.ticks, GanttHeaderTick, i);
+		minor_width = hscale * ((tick + 1)->t - tick->t);
+	} else {
+		minor_width = 0;
+	}
 
 	/* Draw the major scale. */
-	if (major_width < 2 || priv->major_unit == MRP_TIME_UNIT_NONE) {
+	if (major_width < 2 || priv->major.unit == MRP_TIME_UNIT_NONE) {
 		/* Unless it's too thin to make sense. */
 		goto minor_ticks;
 	}
 
-	t = mrp_time_align_prev (t0, priv->major_unit);
+	i = gantt_header_scale_ensure (&priv->major, t0, t1);
 
-	while (t <= t1) {
-		x = floor (t * hscale - priv->x1 + 0.5);
+	for (tick = &g_array_index (priv->major.ticks, GanttHeaderTick, i); tick->t <= t1; tick++) {
+		x = floor (tick->t * hscale - priv->x1 + 0.5);
+		width = floor ((tick + 1)->t * hscale - priv->x1 + 0.5) - x;
 
 		// Vertical lines between different weeks
 		gdk_cairo_set_source_rgba (cr, &insensitive_fg_color);
@@ -609,38 +818,30 @@ gantt_header_draw (GtkWidget *widget,
 		cairo_line_to (cr, x + 0.5, height / 2 + 1);
 		cairo_stroke (cr);
 
-		str = planner_scale_format_time (t,
-					    priv->major_unit,
-					    priv->major_format);
-		pango_layout_set_text (priv->layout,
-				       str,
-				       -1);
-		g_free (str);
-
 		cairo_save (cr);
-		cairo_rectangle (cr, x, 0, major_width, height);
+		cairo_rectangle (cr, x, 0, width, height);
 		cairo_clip (cr);
 
 		gdk_cairo_set_source_rgba (cr, &text_color);
 		cairo_move_to (cr, x + 3, 2);
-		pango_cairo_show_layout (cr, priv->layout);
+		pango_cairo_show_layout (cr,
+					 gantt_header_get_tick_layout (header, &priv->major, tick));
 		cairo_restore (cr);
-
-		t = mrp_time_align_next (t, priv->major_unit);
 	}
 
  minor_ticks:
 
 	/* Draw the minor scale. */
-	if (minor_width < 2 || priv->major_unit == MRP_TIME_UNIT_NONE) {
+	if (minor_width < 2 || priv->major.unit == MRP_TIME_UNIT_NONE) {
 		/* Unless it's too thin to make sense. */
 		goto done;
 	}
 
-	t = mrp_time_align_prev (t0, priv->minor_unit);
+	i = gantt_header_scale_ensure (&priv->minor, t0, t1);
 
-	while (t <= t1) {
-		x = floor (t * hscale - priv->x1 + 0.5);
+	for (tick = &g_array_index (priv->minor.ticks, GanttHeaderTick, i); tick->t <= t1; tick++) {
+		x = floor (tick->t * hscale - priv->x1 + 0.5);
+		width = floor ((tick + 1)->t * hscale - priv->x1 + 0.5) - x;
 
 		// NOTE: Vertical lines between dates
 		gdk_cairo_set_source_rgba (cr, &insensitive_fg_color);
@@ -648,23 +849,14 @@ gantt_header_draw (GtkWidget *widget,
 		cairo_line_to (cr, x + 0.5, height + 0.5);
 		cairo_stroke (cr);
 
-		str = planner_scale_format_time (t,
-					    priv->minor_unit,
-					    priv->minor_format);
-		pango_layout_set_text (priv->layout,
-				       str,
-				       -1);
-		g_free (str);
-
 		cairo_save (cr);
-		cairo_rectangle (cr, x, 0, minor_width, height);
+		cairo_rectangle (cr, x, 0, width, height);
 		cairo_clip (cr);
 		gdk_cairo_set_source_rgba (cr, &text_color);
 		cairo_move_to (cr, x + 3, height / 2 + 2);
-		pango_cairo_show_layout (cr, priv->layout);
+		pango_cairo_show_layout (cr,
+					 gantt_header_get_tick_layout (header, &priv->minor, tick));
 		cairo_restore (cr);
-
-		t = mrp_time_align_next (t, priv->minor_unit);
 	}
 
  done:
@@ -29,6 +29,7 @@
 #include <glib/gi18n.h>
 #include <libplanner/mrp-task.h>
 #include "planner-marshal.h"
+#include "planner-change-queue.h"
 #include "planner-gantt-model.h"
 
 enum {
@@ -37,24 +38,36 @@ enum {
 	LAST_SIGNAL
 };
 
+typedef struct _GanttNode GanttNode;
+
+struct _GanttNode {
+	MrpTask   *task;
+	GanttNode *parent;
+
+	/* The children in order, NULL until the first one is added. */
+	GPtrArray *children;
+
+	/* Position among the siblings. */
+	guint      index;
+
+	/* The WBS string is valid if it was made after this node last moved
+	 * and after the parent's string was made.
+	 */
+	gchar     *wbs;
+	guint      wbs_stamp;
+	guint      moved_stamp;
+};
+
 struct _PlannerGanttModelPriv {
 	MrpProject *project;
 	GHashTable *task2node;
-	GNode      *tree;
-
-	GHashTable *task2cache;
-	gint        wbs_stamp;
-};
+	GanttNode  *tree;
 
-typedef struct {
-	gchar *wbs;
-	gint   wbs_stamp;
+	guint       wbs_stamp;
 
-	gchar *start;
-	gchar *finish;
-	gchar *duration;
-	gchar *work;
-} ValueCache;
+	/* Tasks whose rows need a row-changed, sent once per frame. */
+	PlannerChangeQueue *changes;
+};
 
 
 static void         gantt_model_init                 (PlannerGanttModel      *model);
@@ -70,17 +83,13 @@ static void         gantt_model_task_prop_changed_cb (MrpTask                *ta
 						      MrpProperty            *property,
 						      GValue                 *value,
 						      PlannerGanttModel      *model);
+static void         gantt_model_flush_changes        (GPtrArray              *tasks,
+						      PlannerGanttModel      *model);
 static GtkTreePath *gantt_model_get_path_from_node   (PlannerGanttModel      *model,
-						      GNode                  *node);
+						      GanttNode              *node);
 gchar *             get_wbs_from_task                (MrpTask                *task);
-static const gchar *value_cache_get_wbs              (PlannerGanttModel      *model,
-						      MrpTask                *task);
-static ValueCache * value_cache_get                  (PlannerGanttModel      *model,
-						      MrpTask                *task);
-static void         value_cache_clear                (PlannerGanttModel      *model,
-						      MrpTask                *task);
-static void         value_cache_clear_cache_wbs      (PlannerGanttModel      *model);
-static void         value_cache_free                 (ValueCache             *cache);
+static const gchar *gantt_model_get_node_wbs         (PlannerGanttModel      *model,
+						      GanttNode              *node);
 
 
 static GObjectClass *parent_class;
@@ -122,6 +131,109 @@ planner_gantt_model_get_type (void)
 	return type;
 }
 
+static GanttNode *
+gantt_node_new (MrpTask *task)
+{
+	GanttNode *node;
+
+	node = g_slice_new0 (GanttNode);
+	node->task = task;
+
+	return node;
+}
+
+static void
+gantt_node_free (GanttNode *node)
+{
+	guint i;
+
+	if (node->children) {
+		for (i = 0; i < node->children->len; i++) {
+			gantt_node_free (g_ptr_array_index (node->children, i));
+		}
+
+		g_ptr_array_free (node->children, TRUE);
+	}
+
+	g_free (node->wbs);
+	g_slice_free (GanttNode, node);
+}
+
+static guint
+gantt_node_n_children (GanttNode *node)
+{
+	return node->children ? node->children->len : 0;
+}
+
+static GanttNode *
+gantt_node_nth_child (GanttNode *node, guint n)
+{
+	if (n >= gantt_node_n_children (node)) {
+		return NULL;
+	}
+
+	return g_ptr_array_index (node->children, n);
+}
+
+/* Updates the positions of the children from @from on, which also makes
+ * their WBS strings and those of their subtrees stale.
+ */
+static void
+gantt_model_renumber_children (PlannerGanttModel *model,
+			       GanttNode         *parent,
+			       guint              from)
+{
+	GanttNode *child;
+	guint      stamp;
+	guint      i;
+
+	stamp = ++model->priv->wbs_stamp;
+
+	for (i = from; i < gantt_node_n_children (parent); i++) {
+		child = g_ptr_array_index (parent->children, i);
+
+		child->index = i;
+		child->moved_stamp = stamp;
+	}
+}
+
+static void
+gantt_model_node_insert (PlannerGanttModel *model,
+			 GanttNode         *parent,
+			 gint               pos,
+			 GanttNode         *node)
+{
+	if (!parent->children) {
+		parent->children = g_ptr_array_new ();
+	}
+
+	if (pos < 0 || pos > (gint) parent->children->len) {
+		pos = parent->children->len;
+	}
+
+	g_ptr_array_insert (parent->children, pos, node);
+	node->parent = parent;
+
+	gantt_model_renumber_children (model, parent, pos);
+}
+
+static void
+gantt_model_node_unlink (PlannerGanttModel *model,
+			 GanttNode         *node)
+{
+	GanttNode *parent;
+
+	parent = node->parent;
+	if (!parent) {
+		return;
+	}
+
+	g_ptr_array_remove_index (parent->children, node->index);
+	node->parent = NULL;
+
+	gantt_model_renumber_children (model, parent, node->index);
+}
+
 static void
 gantt_model_connect_to_task_signals (PlannerGanttModel *model, MrpTask *task)
 {
@@ -146,15 +258,13 @@ gantt_model_task_inserted_cb (MrpProject        *project,
 	GtkTreePath *path;
 	GtkTreePath *parent_path;
 	GtkTreeIter  iter;
-	GNode       *node;
-	GNode       *parent_node;
+	GanttNode   *node;
+	GanttNode   *parent_node;
 	MrpTask     *parent;
 	gint         pos;
 	gboolean     has_child_toggled;
 
-	value_cache_clear_cache_wbs (model);
-
-	node = g_node_new (task);
+	node = gantt_node_new (task);
 
 	g_hash_table_insert (model->priv->task2node, task, node);
 
@@ -163,9 +273,9 @@ gantt_model_task_inserted_cb (MrpProject        *project,
 
 	parent_node = g_hash_table_lookup (model->priv->task2node, parent);
 
-	has_child_toggled = (g_node_n_children (parent_node) == 0);
+	has_child_toggled = (gantt_node_n_children (parent_node) == 0);
 
-	g_node_insert (parent_node, pos, node);
+	gantt_model_node_insert (model, parent_node, pos, node);
 
 	if (has_child_toggled && parent_node->parent != NULL) {
 		parent_path = gantt_model_get_path_from_node (model, parent_node);
@@ -184,47 +294,38 @@ gantt_model_task_inserted_cb (MrpProject        *project,
 
 	gantt_model_connect_to_task_signals (model, task);
 
-	/* Sanity check. */
-#if 0
-	if (g_node_n_nodes (model->priv->tree, G_TRAVERSE_ALL) !=
-	    g_hash_table_size (model->priv->task2node)) {
-		g_warning ("Gantt model corrupt.");
-	}
-#endif
-
 	g_signal_emit (model, signals[TASK_ADDED], 0, task);
 }
 
-static gboolean
-traverse_remove_subtree (GNode             *node,
+static void
+traverse_remove_subtree (GanttNode         *node,
 			 PlannerGanttModel *model)
 {
-	g_signal_handlers_disconnect_by_func (node->data,
+	guint i;
+
+	for (i = 0; i < gantt_node_n_children (node); i++) {
+		traverse_remove_subtree (g_ptr_array_index (node->children, i), model);
+	}
+
+	g_signal_handlers_disconnect_by_func (node->task,
 					      gantt_model_task_notify_cb,
 					      model);
-	g_signal_handlers_disconnect_by_func (node->data,
+	g_signal_handlers_disconnect_by_func (node->task,
 					      gantt_model_task_prop_changed_cb,
 					      model);
 
-	g_hash_table_remove (model->priv->task2node, node->data);
-
-	return FALSE;
+	g_hash_table_remove (model->priv->task2node, node->task);
 }
 
 static void
 gantt_model_remove_subtree (PlannerGanttModel *model,
-			    GNode             *node)
+			    GanttNode         *node)
 {
-	g_node_unlink (node);
+	gantt_model_node_unlink (model, node);
 
-	g_node_traverse (node,
-			 G_POST_ORDER,
-			 G_TRAVERSE_ALL,
-			 -1,
-			 (GNodeTraverseFunc) traverse_remove_subtree,
-			 model);
+	traverse_remove_subtree (node, model);
 
-	g_node_destroy (node);
+	gantt_node_free (node);
 }
 
 static void
@@ -232,8 +333,8 @@ gantt_model_task_removed_cb (MrpProject        *project,
 			     MrpTask           *task,
 			     PlannerGanttModel *model)
 {
-	GNode       *node;
-	GNode       *parent_node;
+	GanttNode   *node;
+	GanttNode   *parent_node;
 	GtkTreePath *path;
 	GtkTreePath *parent_path;
 	GtkTreeIter  iter;
@@ -249,8 +350,6 @@ gantt_model_task_removed_cb (MrpProject        *project,
 		return;
 	}
 
-	value_cache_clear_cache_wbs (model);
-
 	g_signal_handlers_disconnect_by_func (task,
 					      gantt_model_task_notify_cb,
 					      model);
@@ -263,7 +362,7 @@ gantt_model_task_removed_cb (MrpProject        *project,
 	path = gantt_model_get_path_from_node (model, node);
 	gtk_tree_model_get_iter (GTK_TREE_MODEL (model), &iter, path);
 
-	has_child_toggled = (g_node_n_children (parent_node) == 1);
+	has_child_toggled = (gantt_node_n_children (parent_node) == 1);
 
 	gantt_model_remove_subtree (model, node);
 
@@ -280,13 +379,6 @@ gantt_model_task_removed_cb (MrpProject        *project,
 
 	gtk_tree_path_free (path);
 
-	/* Sanity check. */
-#if 0
-	if (g_node_n_nodes (model->priv->tree, G_TRAVERSE_ALL) !=
-	    g_hash_table_size (model->priv->task2node)) {
-		g_warning ("Gantt model corrupt.");
-	}
-#endif
 }
 
 static void
@@ -296,8 +388,8 @@ gantt_model_reattach_subtasks (GtkTreeModel *tree_model,
 	PlannerGanttModel     *model;
 	PlannerGanttModelPriv *priv;
 	MrpTask               *child;
-	GNode                 *node;
-	GNode                 *parent_node;
+	GanttNode             *node;
+	GanttNode             *parent_node;
 	GtkTreePath           *path;
 	GtkTreeIter            iter;
 	gint                   pos;
@@ -313,9 +405,9 @@ gantt_model_reattach_subtasks (GtkTreeModel *tree_model,
 	while (child) {
 		node = g_hash_table_lookup (priv->task2node, child);
 		pos = mrp_task_get_position (child);
-		g_node_insert (parent_node, pos, node);
+		gantt_model_node_insert (model, parent_node, pos, node);
 
-		has_child_toggled = (g_node_n_children (parent_node) == 1);
+		has_child_toggled = (gantt_node_n_children (parent_node) == 1);
 
 		/* Emit has_child_toggled if necessary. */
 		if (has_child_toggled) {
@@ -341,26 +433,23 @@ gantt_model_reattach_subtasks (GtkTreeModel *tree_model,
 	}
 }
 
-static gboolean
-gantt_model_unlink_subtree_cb (GNode *node, gpointer data)
-{
-	g_node_unlink (node);
-
-	return FALSE;
-}
-
 static void
-gantt_model_unlink_subtree_recursively (GNode *node)
+gantt_model_unlink_subtree_recursively (PlannerGanttModel *model,
+					GanttNode         *node)
 {
-	/* Remove the tasks one by one using post order so we don't mess with
-	 * the tree while traversing it.
+	GanttNode *child;
+
+	/* Remove the tasks one by one, from the end, so that the views are
+	 * told about the subtasks one at a time when they are reattached.
 	 */
-	g_node_traverse (node,
-			 G_POST_ORDER,
-			 G_TRAVERSE_ALL,
-			 -1,
-			 (GNodeTraverseFunc) gantt_model_unlink_subtree_cb,
-			 NULL);
+	while (gantt_node_n_children (node) > 0) {
+		child = g_ptr_array_index (node->children,
+					   node->children->len - 1);
+
+		gantt_model_unlink_subtree_recursively (model, child);
+	}
+
+	gantt_model_node_unlink (model, node);
 }
 
 static void
@@ -372,13 +461,11 @@ gantt_model_task_moved_cb (MrpProject        *project,
 	GtkTreePath *path;
 	GtkTreePath *parent_path;
 	GtkTreeIter  iter;
-	GNode       *node;
-	GNode       *parent_node;
+	GanttNode   *node;
+	GanttNode   *parent_node;
 	gint         pos;
 	gboolean     has_child_toggled;
 
-	value_cache_clear_cache_wbs (model);
-
 	path = planner_gantt_model_get_path_from_task (model, task);
 	gtk_tree_model_get_iter (GTK_TREE_MODEL (model), &iter, path);
 
@@ -389,10 +476,10 @@ gantt_model_task_moved_cb (MrpProject        *project,
 	node = g_hash_table_lookup (model->priv->task2node, task);
 
 	parent_node = node->parent;
-	has_child_toggled = (g_node_n_children (parent_node) == 1);
+	has_child_toggled = (gantt_node_n_children (parent_node) == 1);
 
 	/* Unlink the subtree from the original position in the tree. */
-	gantt_model_unlink_subtree_recursively (node);
+	gantt_model_unlink_subtree_recursively (model, node);
 
 	/* Emit has_child_toggled if necessary. */
 	if (has_child_toggled) {
@@ -410,9 +497,9 @@ gantt_model_task_moved_cb (MrpProject        *project,
 
 	/* Re-insert the task at the new position. */
 	pos = mrp_task_get_position (task);
-	g_node_insert (parent_node, pos, node);
+	gantt_model_node_insert (model, parent_node, pos, node);
 
-	has_child_toggled = (g_node_n_children (parent_node) == 1);
+	has_child_toggled = (gantt_node_n_children (parent_node) == 1);
 
 	/* Emit has_child_toggled if necessary. */
 	if (has_child_toggled) {
@@ -437,28 +524,40 @@ gantt_model_task_moved_cb (MrpProject        *project,
 }
 
 static void
-gantt_model_task_notify_cb (MrpTask           *task,
-			    GParamSpec        *pspec,
-			    PlannerGanttModel *model)
+gantt_model_flush_changes (GPtrArray         *tasks,
+			   PlannerGanttModel *model)
 {
 	GtkTreeModel *tree_model;
 	GtkTreePath  *path;
 	GtkTreeIter   iter;
+	guint         i;
 
 	tree_model = GTK_TREE_MODEL (model);
 
-	if (strcmp (pspec->name, "start") == 0 ||
-	    strcmp (pspec->name, "finish") == 0 ||
-	    strcmp (pspec->name, "duration") == 0 ||
-	    strcmp (pspec->name, "work") == 0) {
-		value_cache_clear (model, task);
-	}
+	for (i = 0; i < tasks->len; i++) {
+		/* The task may have been removed since it was queued. */
+		path = planner_gantt_model_get_path_from_task (model,
+							       g_ptr_array_index (tasks, i));
+		if (!path) {
+			continue;
+		}
 
-	path = planner_gantt_model_get_path_from_task (model, task);
-	gtk_tree_model_get_iter (tree_model, &iter, path);
-	gtk_tree_model_row_changed (tree_model, path, &iter);
+		gtk_tree_model_get_iter (tree_model, &iter, path);
+		gtk_tree_model_row_changed (tree_model, path, &iter);
 
-	gtk_tree_path_free (path);
+		gtk_tree_path_free (path);
+	}
+}
+
+static void
+gantt_model_task_notify_cb (MrpTask           *task,
+			    GParamSpec        *pspec,
+			    PlannerGanttModel *model)
+{
+	/* A recalc notifies several properties on many tasks, only tell the
+	 * views once per frame.
+	 */
+	planner_change_queue_add (model->priv->changes, task);
 }
 
 static void
@@ -467,58 +566,40 @@ gantt_model_task_prop_changed_cb (MrpTask           *task,
 				  GValue            *value,
 				  PlannerGanttModel *model)
 {
-	GtkTreeModel *tree_model;
-	GtkTreePath  *path;
-	GtkTreeIter   iter;
-
-	tree_model = GTK_TREE_MODEL (model);
-
-	path = planner_gantt_model_get_path_from_task (model, task);
-	gtk_tree_model_get_iter (tree_model, &iter, path);
-	gtk_tree_model_row_changed (tree_model, path, &iter);
-
-	gtk_tree_path_free (path);
-}
-
-static gboolean
-traverse_insert_task_into_hash (GNode             *node,
-				PlannerGanttModel *model)
-{
-	g_hash_table_insert (model->priv->task2node,
-			     node->data,
-			     node);
-
-	return FALSE;
+	planner_change_queue_add (model->priv->changes, task);
 }
 
 static void
-traverse_setup_tree (MrpTask  *task,
-		     GNode    *node)
+traverse_setup_tree (PlannerGanttModel *model,
+		     MrpTask           *task,
+		     GanttNode         *node)
 {
-	MrpTask *child_task;
-	GNode   *child_node;
+	MrpTask   *child_task;
+	GanttNode *child_node;
+
+	g_hash_table_insert (model->priv->task2node, task, node);
 
 	child_task = mrp_task_get_first_child (task);
 	while (child_task) {
-		child_node = g_node_new (child_task);
-		g_node_append (node, child_node);
+		child_node = gantt_node_new (child_task);
+		gantt_model_node_insert (model, node, -1, child_node);
 
-		traverse_setup_tree (child_task, child_node);
+		traverse_setup_tree (model, child_task, child_node);
 
 		child_task = mrp_task_get_next_sibling (child_task);
 	}
 }
 
-static GNode *
+static GanttNode *
 gantt_model_setup_task_tree (PlannerGanttModel *model)
 {
-	MrpTask *root_task;
-	GNode   *root_node;
+	MrpTask   *root_task;
+	GanttNode *root_node;
 
 	root_task = mrp_project_get_root_task (model->priv->project);
-	root_node = g_node_new (root_task);
+	root_node = gantt_node_new (root_task);
 
-	traverse_setup_tree (root_task, root_node);
+	traverse_setup_tree (model, root_task, root_node);
 
 	return root_node;
 }
@@ -535,13 +616,9 @@ planner_gantt_model_new (MrpProject *project)
 
 	priv->project = project;
 	priv->tree = gantt_model_setup_task_tree (model);
-
-	g_node_traverse (priv->tree,
-			 G_PRE_ORDER,
-			 G_TRAVERSE_ALL,
-			 -1,
-			 (GNodeTraverseFunc) traverse_insert_task_into_hash,
-			 model);
+	priv->changes = planner_change_queue_new (
+		(PlannerChangeQueueFunc) gantt_model_flush_changes,
+		model);
 
 	g_signal_connect_object (project,
 				 "task-inserted",
@@ -576,9 +653,9 @@ gantt_model_finalize (GObject *object)
 {
 	PlannerGanttModel *model = PLANNER_GANTT_MODEL (object);
 
-	g_node_destroy (model->priv->tree);
+	planner_change_queue_free (model->priv->changes);
+	gantt_node_free (model->priv->tree);
 	g_hash_table_destroy (model->priv->task2node);
-	g_hash_table_destroy (model->priv->task2cache);
 
 	g_free (model->priv);
 	model->priv = NULL;
@@ -651,7 +728,10 @@ gantt_model_get_column_type (GtkTreeModel *tree_model,
 	case COL_TASK:
 		return MRP_TYPE_TASK;
 	case COL_COST:
-		return G_TYPE_LONG;
+	case COL_ACTUAL_COST:
+	case COL_PLANNED_VALUE:
+	case COL_EARNED_VALUE:
+		return G_TYPE_FLOAT;
 	case COL_COMPLETE:
 		return G_TYPE_INT;
 	default:
@@ -695,57 +775,29 @@ gantt_model_get_iter (GtkTreeModel *tree_model,
 
 GtkTreePath *
 gantt_model_get_path_from_node (PlannerGanttModel *model,
-				GNode             *node)
+				GanttNode         *node)
 {
 	GtkTreePath *path;
-	GNode       *parent;
-	GNode       *child;
-	gint         i = 0;
 
 	g_return_val_if_fail (PLANNER_IS_GANTT_MODEL (model), NULL);
 	g_return_val_if_fail (node != NULL, NULL);
 
-	parent = node->parent;
-
-	if (parent == NULL && node == model->priv->tree) {
+	if (node == model->priv->tree) {
 		return gtk_tree_path_new_first ();
 	}
 
-	g_assert (parent != NULL);
-
-	if (parent == model->priv->tree) {
-		path = gtk_tree_path_new ();
-		child = g_node_first_child (model->priv->tree);
-	} else {
-		path = gantt_model_get_path_from_node (model, parent);
-		child = g_node_first_child (parent);
-	}
-
-	if (path == NULL) {
-		return NULL;
-	}
+	path = gtk_tree_path_new ();
 
-	if (child == NULL) {
-		gtk_tree_path_free (path);
-		return NULL;
+	for (; node->parent; node = node->parent) {
+		gtk_tree_path_prepend_index (path, node->index);
 	}
 
-	for (; child; child = g_node_next_sibling (child)) {
-		if (child == node) {
-			break;
-		}
-		i++;
-	}
-
-	if (child == NULL) {
-		/* We couldn't find node, meaning it's prolly not ours */
-		/* Perhaps I should do a g_return_if_fail here. */
+	if (node != model->priv->tree) {
+		/* The node is not in the tree, meaning it's prolly not ours. */
 		gtk_tree_path_free (path);
 		return NULL;
 	}
 
-	gtk_tree_path_append_index (path, i);
-
 	return path;
 }
 
@@ -753,7 +805,7 @@ GtkTreePath *
 planner_gantt_model_get_path_from_task (PlannerGanttModel *model,
 					MrpTask           *task)
 {
-	GNode *node;
+	GanttNode *node;
 
 	g_return_val_if_fail (PLANNER_IS_GANTT_MODEL (model), NULL);
 	g_return_val_if_fail (MRP_IS_TASK (task), NULL);
@@ -771,7 +823,7 @@ static GtkTreePath *
 gantt_model_get_path (GtkTreeModel *tree_model,
 		      GtkTreeIter  *iter)
 {
-	GNode *node;
+	GanttNode *node;
 
 	g_return_val_if_fail (iter != NULL, NULL);
 	g_return_val_if_fail (iter->user_data != NULL, NULL);
@@ -788,7 +840,7 @@ gantt_model_get_value (GtkTreeModel *tree_model,
 		       gint          column,
 		       GValue       *value)
 {
-	GNode       *node;
+	GanttNode   *node;
 	MrpTask     *task;
 	MrpProject  *project;
 	mrptime      t1, t2;
@@ -799,12 +851,12 @@ gantt_model_get_value (GtkTreeModel *tree_model,
 	g_return_if_fail (iter != NULL);
 
 	node = iter->user_data;
-	task = node->data;
+	task = node->task;
 
 	switch (column) {
 	case COL_WBS:
-		cached_str = value_cache_get_wbs (PLANNER_GANTT_MODEL (tree_model),
-						  task);
+		cached_str = gantt_model_get_node_wbs (PLANNER_GANTT_MODEL (tree_model),
+						       node);
 
 		g_value_init (value, G_TYPE_STRING);
 		g_value_set_string (value, cached_str);
@@ -861,7 +913,7 @@ gantt_model_get_value (GtkTreeModel *tree_model,
 
 	case COL_WEIGHT:
 		g_value_init (value, G_TYPE_INT);
-		if (g_node_n_children (node) > 0) {
+		if (gantt_node_n_children (node) > 0) {
 			g_value_set_int (value, PANGO_WEIGHT_BOLD);
 		} else {
 			g_value_set_int (value, PANGO_WEIGHT_NORMAL);
@@ -870,7 +922,7 @@ gantt_model_get_value (GtkTreeModel *tree_model,
 
 	case COL_EDITABLE:
 		g_value_init (value, G_TYPE_BOOLEAN);
-		if (g_node_n_children (node) > 0) {
+		if (gantt_node_n_children (node) > 0) {
 			g_value_set_boolean (value, FALSE);
 		} else {
 			g_value_set_boolean (value, TRUE);
@@ -895,6 +947,24 @@ gantt_model_get_value (GtkTreeModel *tree_model,
 
 		break;
 
+	case COL_ACTUAL_COST:
+		g_value_init (value, G_TYPE_FLOAT);
+		g_value_set_float (value, mrp_task_get_actual_cost (task));
+
+		break;
+
+	case COL_PLANNED_VALUE:
+		g_value_init (value, G_TYPE_FLOAT);
+		g_value_set_float (value, mrp_task_get_planned_value (task));
+
+		break;
+
+	case COL_EARNED_VALUE:
+		g_value_init (value, G_TYPE_FLOAT);
+		g_value_set_float (value, mrp_task_get_earned_value (task));
+
+		break;
+
 	default:
 		g_warning ("Bad column %d requested", column);
 	}
@@ -904,11 +974,15 @@ static gboolean
 gantt_model_iter_next (GtkTreeModel *tree_model,
 		       GtkTreeIter  *iter)
 {
-	GNode *node, *next;
+	GanttNode *node, *next;
 
 	node = iter->user_data;
 
-	next = g_node_next_sibling (node);
+	if (node->parent) {
+		next = gantt_node_nth_child (node->parent, node->index + 1);
+	} else {
+		next = NULL;
+	}
 
 	if (next == NULL) {
 		iter->user_data = NULL;
@@ -924,7 +998,7 @@ gantt_model_iter_children (GtkTreeModel *tree_model,
 			   GtkTreeIter  *iter,
 			   GtkTreeIter  *parent)
 {
-	GNode *node, *child;
+	GanttNode *node, *child;
 
 	/* Handle iter == NULL (or gail will crash), even though the docs
 	 * doesn't say we need to.
@@ -935,7 +1009,7 @@ gantt_model_iter_children (GtkTreeModel *tree_model,
 		node = PLANNER_GANTT_MODEL (tree_model)->priv->tree;
 	}
 
-	child = g_node_first_child (node);
+	child = gantt_node_nth_child (node, 0);
 
 	if (child == NULL) {
 		iter->user_data = NULL;
@@ -951,18 +1025,18 @@ static gboolean
 gantt_model_iter_has_child (GtkTreeModel *tree_model,
 			    GtkTreeIter  *iter)
 {
-	GNode *node;
+	GanttNode *node;
 
 	node = iter->user_data;
 
-	return (g_node_n_children (node) > 0);
+	return (gantt_node_n_children (node) > 0);
 }
 
 static gint
 gantt_model_iter_n_children (GtkTreeModel *tree_model,
 			     GtkTreeIter  *iter)
 {
-	GNode *node;
+	GanttNode *node;
 
 	if (iter) {
 		node = iter->user_data;
@@ -970,7 +1044,7 @@ gantt_model_iter_n_children (GtkTreeModel *tree_model,
 		node = PLANNER_GANTT_MODEL (tree_model)->priv->tree;
 	}
 
-	return g_node_n_children (node);
+	return gantt_node_n_children (node);
 }
 
 static gboolean
@@ -980,8 +1054,8 @@ gantt_model_iter_nth_child (GtkTreeModel *tree_model,
 			    gint          n)
 {
 	PlannerGanttModel *model;
-	GNode        *parent;
-	GNode        *child;
+	GanttNode         *parent;
+	GanttNode         *child;
 
 	g_return_val_if_fail (parent_iter == NULL || parent_iter->user_data != NULL, FALSE);
 
@@ -993,7 +1067,12 @@ gantt_model_iter_nth_child (GtkTreeModel *tree_model,
 		parent = parent_iter->user_data;
 	}
 
-	child = g_node_nth_child (parent, n);
+	if (n < 0) {
+		iter->user_data = NULL;
+		return FALSE;
+	}
+
+	child = gantt_node_nth_child (parent, n);
 
 	if (child) {
 		iter->user_data = child;
@@ -1010,8 +1089,8 @@ gantt_model_iter_parent (GtkTreeModel *tree_model,
 			 GtkTreeIter  *iter,
 			 GtkTreeIter  *child)
 {
-	GNode *node_task;
-	GNode *node_parent;
+	GanttNode *node_task;
+	GanttNode *node_parent;
 
 	node_task = child->user_data;
 
@@ -1053,9 +1132,6 @@ gantt_model_init (PlannerGanttModel *model)
 	model->priv = priv;
 
 	priv->task2node = g_hash_table_new (NULL, NULL);
-	priv->task2cache = g_hash_table_new_full (NULL, NULL,
-						  NULL,
-						  (GDestroyNotify) value_cache_free);
 
 	do {
 		model->stamp = g_random_int ();
@@ -1070,13 +1146,25 @@ planner_gantt_model_get_project (PlannerGanttModel *model)
 	return model->priv->project;
 }
 
+/* Row changes are batched per frame of @widget, the view that shows the
+ * model. Without a realized view they go out from an idle instead.
+ */
+void
+planner_gantt_model_set_widget (PlannerGanttModel *model,
+				GtkWidget         *widget)
+{
+	g_return_if_fail (PLANNER_IS_GANTT_MODEL (model));
+
+	planner_change_queue_set_widget (model->priv->changes, widget);
+}
+
 MrpTask *
 planner_gantt_model_get_task (PlannerGanttModel *model,
 			      GtkTreeIter  *iter)
 {
 	MrpTask *task;
 
-	task = ((GNode *) iter->user_data)->data;
+	task = ((GanttNode *) iter->user_data)->task;
 
 	if (task == NULL) {
 		/* Shouldn't really happen. */
@@ -1108,22 +1196,19 @@ MrpTask *
 planner_gantt_model_get_indent_task_target (PlannerGanttModel *model,
 					    MrpTask           *task)
 {
-	GNode *node;
-	GNode *sibling;
+	GanttNode *node;
 
 	g_return_val_if_fail (PLANNER_IS_GANTT_MODEL (model), NULL);
 	g_return_val_if_fail (MRP_IS_TASK (task), NULL);
 
 	node = g_hash_table_lookup (model->priv->task2node, task);
 
-	sibling = g_node_prev_sibling (node);
-
 	/* If we're the first child we can't indent. */
-	if (sibling == NULL || sibling == node) {
+	if (node == NULL || node->parent == NULL || node->index == 0) {
 		return NULL;
 	}
 
-	return sibling->data;
+	return gantt_node_nth_child (node->parent, node->index - 1)->task;
 }
 
 gchar *
@@ -1157,72 +1242,36 @@ get_wbs_from_task(MrpTask *task)
         return g_string_free (string, FALSE);
 }
 
+/* Builds the WBS string from the parent's, so only the strings in a subtree
+ * that moved are made again.
+ */
 static const gchar *
-value_cache_get_wbs (PlannerGanttModel *model,
-		     MrpTask           *task)
+gantt_model_get_node_wbs (PlannerGanttModel *model,
+			  GanttNode         *node)
 {
-	ValueCache *cache;
+	const gchar *parent_wbs = NULL;
+	guint        parent_stamp = 0;
 
-	cache = value_cache_get (model, task);
-	if (!cache->wbs) {
-		goto update_cache;
+	if (node->parent && node->parent != model->priv->tree) {
+		parent_wbs = gantt_model_get_node_wbs (model, node->parent);
+		parent_stamp = node->parent->wbs_stamp;
 	}
 
-	if (cache->wbs_stamp != model->priv->wbs_stamp) {
-		goto update_cache;
+	if (node->wbs &&
+	    node->wbs_stamp > node->moved_stamp &&
+	    node->wbs_stamp > parent_stamp) {
+		return node->wbs;
 	}
 
-	return cache->wbs;
-
- update_cache:
-	g_free (cache->wbs);
-	cache->wbs = get_wbs_from_task(task);
-	cache->wbs_stamp = model->priv->wbs_stamp;
+	g_free (node->wbs);
 
-	return cache->wbs;
-}
-
-static void
-value_cache_free (ValueCache *cache)
-{
-	g_free (cache->wbs);
-	g_free (cache->start);
-	g_free (cache->finish);
-	g_free (cache->duration);
-	g_free (cache->work);
-
-	g_free (cache);
-}
-
-static ValueCache *
-value_cache_get (PlannerGanttModel *model,
-		 MrpTask           *task)
-{
-	ValueCache *cache;
-
-	cache = g_hash_table_lookup (model->priv->task2cache, task);
-	if (!cache) {
-		cache = g_new0 (ValueCache, 1);
-		g_hash_table_insert (model->priv->task2cache,
-				     task,
-				     cache);
+	if (parent_wbs) {
+		node->wbs = g_strdup_printf ("%s.%u", parent_wbs, node->index + 1);
+	} else {
+		node->wbs = g_strdup_printf ("%u", node->index + 1);
 	}
 
-	return cache;
-}
+	node->wbs_stamp = ++model->priv->wbs_stamp;
 
-static void
-value_cache_clear (PlannerGanttModel *model,
-		   MrpTask           *task)
-{
-	g_hash_table_remove (model->priv->task2cache, task);
+	return node->wbs;
 }
-
-static void
-value_cache_clear_cache_wbs (PlannerGanttModel *model)
-{
-	model->priv->wbs_stamp++;
-}
-
-
-
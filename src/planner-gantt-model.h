@@ -60,6 +60,9 @@ enum {
 	COL_COST,
 	COL_ASSIGNED_TO,
 	COL_COMPLETE,
+	COL_ACTUAL_COST,
+	COL_PLANNED_VALUE,
+	COL_EARNED_VALUE,
 	NUM_COLS
 };
 
@@ -70,6 +73,8 @@ GtkTreePath  *     planner_gantt_model_get_path_from_task     (PlannerGanttModel
 MrpTask      *     planner_gantt_model_get_indent_task_target (PlannerGanttModel *model,
 							       MrpTask           *task);
 MrpProject   *     planner_gantt_model_get_project            (PlannerGanttModel *model);
+void               planner_gantt_model_set_widget             (PlannerGanttModel *model,
+							       GtkWidget         *widget);
 MrpTask      *     planner_gantt_model_get_task               (PlannerGanttModel *model,
 							       GtkTreeIter       *iter);
 MrpTask           *planner_gantt_model_get_task_from_path     (PlannerGanttModel *model,
@@ -24,6 +24,9 @@
 #include <config.h>
 #include <math.h>
 #include <string.h>
+#include <cairo-pdf.h>
+#include <cairo-svg.h>
+#include <pango/pangocairo.h>
 #include <libplanner/mrp-project.h>
 #include <libplanner/mrp-task.h>
 #include <libplanner/mrp-resource.h>
@@ -36,19 +39,60 @@
 #include "planner-scale-utils.h"
 
 #define d(x)
-#define GET_PAGE(d,r,c) (&d->pages[r*d->cols_of_pages+c])
 #define INDENT_FACTOR 4
 
+/* Pages rendered ahead of the one being output, per rendering thread. */
+#define RENDER_AHEAD_PER_THREAD 2
+
+/* A4 in points, used when exporting without a print context. */
+#define EXPORT_PAGE_WIDTH  595.0
+#define EXPORT_PAGE_HEIGHT 842.0
+#define EXPORT_PAGE_MARGIN 36.0
+
+typedef struct {
+	/* Page */
+	gint     row, col;
+
+	/* Position on that page. */
+	gdouble  x, y;
+
+	gboolean valid;
+} TaskCoord;
+
+/* A snapshot of a visible task, taken when the print data is created so
+ * that the pages can be laid out and rendered without touching the
+ * project.
+ */
 typedef struct {
-	mrptime  first_time;
-	mrptime  last_time;
+	MrpTask   *task;
+	gint       depth;
+
+	gchar     *name;
+	gchar     *work;
+	gchar     *resources;
+
+	mrptime    start;
+	mrptime    finish;
+	mrptime    complete;
+
+	gboolean   is_summary;
+	gboolean   is_milestone;
+	gboolean   is_critical;
+
+	/* Where the bar starts and ends, for the relation arrows. */
+	TaskCoord  start_coord;
+	TaskCoord  finish_coord;
+} PrintTask;
 
-	gdouble  gantt_x0;
-	gdouble  gantt_y0;
+typedef struct {
+	gint predecessor;
+	gint successor;
+} PrintRelation;
 
-	GList   *elements;
-	GList   *background_elements;
-} Page;
+typedef struct {
+	gdouble x1;
+	gdouble x2;
+} PrintShade;
 
 struct _PlannerGanttPrintData {
 	MrpProject        *project;
@@ -89,13 +133,31 @@ struct _PlannerGanttPrintData {
 
 	gdouble            row_height;
 
-	GHashTable        *task_start_coords;
-	GHashTable        *task_finish_coords;
+	/* Printable area and text, taken from the print job or set up for an
+	 * export.
+	 */
+	gdouble            width;
+	gdouble            height;
+	gdouble            x_pad;
+	gdouble            font_height;
 
 	PangoFontDescription         *font;
 	PangoFontDescription         *font_bold;
 
-	GList             *tasks;
+	/* Used to measure text while setting up. */
+	PangoContext      *pango_context;
+
+	PrintTask         *tasks;
+	gint               n_tasks;
+
+	/* Relations between visible tasks, as indices into tasks. */
+	GArray            *relations;
+
+	/* Non-working time shading and the current time line for each column
+	 * of pages, they are the same on every row.
+	 */
+	GArray           **shades;
+	gdouble           *timelines;
 
 	gdouble            f;
 
@@ -117,22 +179,17 @@ struct _PlannerGanttPrintData {
 
 	mrptime            second_column_start;
 
-	Page              *pages;
+	/* Pages are laid out and rendered onto recording surfaces by a pool
+	 * of threads, a few pages ahead of the one being output.
+	 */
+	GThreadPool       *pool;
+	GMutex             mutex;
+	GCond              cond;
+	GHashTable        *rendered;
+	gboolean          *queued;
+	gint               render_ahead;
 };
 
-typedef struct {
-	/* Page */
-	gint    row, col;
-
-	/* Position on that page. */
-	gdouble x, y;
-} TaskCoord;
-
-typedef struct {
-	MrpTask *task;
-	gint     depth;
-} PrintTask;
-
 typedef enum {
 	TASK_WHOLE,
 	TASK_LEFT,
@@ -166,56 +223,121 @@ typedef struct {
 	gdouble      x_complete;
 
 	gboolean     is_critical;
-	gchar       *resources;
+	const gchar *resources;
 } Element;
 
+/* State for rendering one page, owned by the thread doing it. */
+typedef struct {
+	PlannerGanttPrintData *data;
+	cairo_t               *cr;
+	PangoLayout           *layout;
+	PangoFontDescription  *font;
+} PrintPage;
+
+static gdouble
+gantt_print_get_extents (PlannerGanttPrintData *data, const gchar *text)
+{
+	PangoLayout    *layout;
+	PangoRectangle  ink;
+
+	layout = pango_layout_new (data->pango_context);
+
+	pango_layout_set_font_description (layout, data->font);
+	pango_layout_set_text (layout, text, -1);
+
+	pango_layout_get_extents (layout, &ink, NULL);
+
+	g_object_unref (layout);
+
+	return ((gdouble)ink.width / PANGO_SCALE);
+}
+
+static void
+gantt_print_show_clipped (PrintPage   *page,
+			  gdouble      x,
+			  gdouble      y,
+			  const gchar *str,
+			  gdouble      x1,
+			  gdouble      y1,
+			  gdouble      x2,
+			  gdouble      y2)
+{
+	cairo_t *cr = page->cr;
+
+	x1 = MAX (x1, 0);
+	x2 = MIN (x2, page->data->width);
+	y1 = MAX (y1, 0);
+	y2 = MIN (y2, page->data->height);
+
+	/* Don't try to print anything if the text starts outside the clip rect. */
+	if (x < x1 || x > x2) {
+		return;
+	}
+
+	cairo_save (cr);
+
+	cairo_new_path (cr);
+	cairo_rectangle (cr, x1, y1, x2 - x1, y2 - y1);
+	cairo_clip (cr);
+
+	pango_layout_set_font_description (page->layout, page->font);
+	pango_layout_set_text (page->layout, str, -1);
+	pango_layout_set_ellipsize (page->layout, PANGO_ELLIPSIZE_END);
+	pango_layout_set_width (page->layout, (x2 - x1) * PANGO_SCALE);
+
+	cairo_move_to (cr, x, y - page->data->font_height);
+
+	pango_cairo_show_layout (cr, page->layout);
+
+	cairo_restore (cr);
+}
 
 static void
-print_table_header (PlannerGanttPrintData *data)
+print_table_header (PrintPage *page)
 {
-	gdouble x, y;
+	PlannerGanttPrintData *data = page->data;
+	cairo_t               *cr = page->cr;
+	gdouble                x, y;
 
-	cairo_set_line_width (data->job->cr, THIN_LINE_WIDTH);
-	planner_print_job_set_font_bold (data->job);
+	cairo_set_line_width (cr, THIN_LINE_WIDTH);
+	page->font = data->font_bold;
 
 	y = data->header_height;
 
-	planner_print_job_moveto (data->job, data->tree_x1, y);
-	planner_print_job_lineto (data->job, data->tree_x2, y);
-	cairo_stroke (data->job->cr);
+	cairo_move_to (cr, data->tree_x1, y);
+	cairo_line_to (cr, data->tree_x2, y);
+	cairo_stroke (cr);
 
-	x = data->name_x1 + data->job->x_pad;
+	x = data->name_x1 + data->x_pad;
 	y = data->row_height;
 
-	planner_print_job_show_clipped (data->job,
-					x, y,
-					_("Name"),
-					data->name_x1 + data->job->x_pad, y - data->row_height,
-					data->name_x2 - data->job->x_pad, y + data->row_height);
+	gantt_print_show_clipped (page,
+				  x, y,
+				  _("Name"),
+				  data->name_x1 + data->x_pad, y - data->row_height,
+				  data->name_x2 - data->x_pad, y + data->row_height);
 
-	x = data->work_x1 + data->job->x_pad;
+	x = data->work_x1 + data->x_pad;
 
-	planner_print_job_show_clipped (data->job,
-					x, y,
-					_("Work"),
-					data->work_x1 + data->job->x_pad, 0,
-					data->work_x2 - data->job->x_pad, y + data->row_height);
+	gantt_print_show_clipped (page,
+				  x, y,
+				  _("Work"),
+				  data->work_x1 + data->x_pad, 0,
+				  data->work_x2 - data->x_pad, y + data->row_height);
 
-	planner_print_job_set_font_regular (data->job);
+	page->font = data->font;
 }
 
 static void
-print_table_tasks (PlannerGanttPrintData *data,
-		   gboolean               header,
-		   GList                 *tasks,
-		   gint                   first)
+print_table_tasks (PrintPage *page,
+		   gboolean   header,
+		   gint       first)
 {
-	gchar     *str;
-	gint       work;
-	gdouble    x, y;
-	GList     *l, *to;
-	PrintTask *ptask;
-	gint       last, i;
+	PlannerGanttPrintData *data = page->data;
+	cairo_t               *cr = page->cr;
+	gdouble                x, y;
+	PrintTask             *ptask;
+	gint                   last, i, j;
 
 	if (header) {
 		last = first + data->tasks_per_page_with_header;
@@ -223,94 +345,87 @@ print_table_tasks (PlannerGanttPrintData *data,
 		last = first + data->tasks_per_page_without_header;
 	}
 
-	l = g_list_nth (tasks, first);
-	to = g_list_nth (tasks, last);
+	last = MIN (last, data->n_tasks);
 	i = 1;
 
-	cairo_set_line_width (data->job->cr, THIN_LINE_WIDTH);
+	cairo_set_line_width (cr, THIN_LINE_WIDTH);
 
-	while (l && l != to) {
-		ptask = l->data;
+	for (j = first; j < last; j++) {
+		ptask = &data->tasks[j];
 
-		g_object_get (ptask->task,
-			      "name", &str,
-			      "work", &work,
-			      NULL);
-
-		if (mrp_task_get_n_children (ptask->task) > 0) {
-			planner_print_job_set_font_bold (data->job);
+		if (ptask->is_summary) {
+			page->font = data->font_bold;
 		} else {
-			planner_print_job_set_font_regular (data->job);
+			page->font = data->font;
 		}
 
-		x = data->name_x1 + data->job->x_pad + ptask->depth * INDENT_FACTOR * data->job->x_pad;
+		x = data->name_x1 + data->x_pad + ptask->depth * INDENT_FACTOR * data->x_pad;
 		y = i * data->row_height;
 
 		if (header) {
 			y += data->header_height;
 		}
 
-		planner_print_job_show_clipped (data->job,
-						x, y - data->row_height / 4,
-						str,
-						data->name_x1 + data->job->x_pad, y - data->row_height,
-						data->name_x2 - data->job->x_pad, y);
+		gantt_print_show_clipped (page,
+					  x, y - data->row_height / 4,
+					  ptask->name,
+					  data->name_x1 + data->x_pad, y - data->row_height,
+					  data->name_x2 - data->x_pad, y);
 
-		g_free (str);
+		x = data->work_x1 + data->x_pad;
 
-		x = data->work_x1 + data->job->x_pad;
+		gantt_print_show_clipped (page,
+					  x, y - data->row_height / 4,
+					  ptask->work,
+					  data->work_x1 + data->x_pad, y - data->row_height,
+					  data->work_x2 - data->x_pad, y);
 
-		str = planner_format_duration (data->project, work);
-		planner_print_job_show_clipped (data->job,
-						x, y - data->row_height / 4,
-						str,
-						data->work_x1 + data->job->x_pad, y - data->row_height,
-						data->work_x2 - data->job->x_pad, y);
-		g_free (str);
-
-		planner_print_job_moveto (data->job, 0, y);
-		planner_print_job_lineto (data->job, data->tree_x2, y);
-		cairo_stroke (data->job->cr);
+		cairo_move_to (cr, 0, y);
+		cairo_line_to (cr, data->tree_x2, y);
+		cairo_stroke (cr);
 
 		i++;
-		l = l->next;
 	}
 
-	cairo_set_line_width (data->job->cr, 1);
+	page->font = data->font;
+
+	cairo_set_line_width (cr, 1);
 }
 
 static void
-print_time_header (PlannerGanttPrintData *data,
-		   gdouble                x1,
-		   gdouble                x2,
-		   mrptime                start,
-		   mrptime                finish)
+print_time_header (PrintPage *page,
+		   gdouble    x1,
+		   gdouble    x2,
+		   mrptime    start,
+		   mrptime    finish)
 {
-	gdouble  x, y;
-	gdouble  y1, y2, y3;
-	gdouble  width;
-	mrptime  t;
-	gchar   *str;
+	PlannerGanttPrintData *data = page->data;
+	cairo_t               *cr = page->cr;
+	gdouble                x, y;
+	gdouble                y1, y2, y3;
+	gdouble                width;
+	mrptime                t;
+	gchar                 *str;
 
 	y1 = 0;
 	y2 = data->header_height / 2;
 	y3 = data->header_height;
 
-	cairo_set_line_width (data->job->cr, THIN_LINE_WIDTH);
+	cairo_set_line_width (cr, THIN_LINE_WIDTH);
 
-	planner_print_job_moveto (data->job, x1, y2);
-	planner_print_job_lineto (data->job, x2, y2);
-	cairo_stroke (data->job->cr);
+	cairo_move_to (cr, x1, y2);
+	cairo_line_to (cr, x2, y2);
+	cairo_stroke (cr);
 
-	planner_print_job_moveto (data->job, x1, y3);
-	planner_print_job_lineto (data->job, x2, y3);
-	cairo_stroke (data->job->cr);
+	cairo_move_to (cr, x1, y3);
+	cairo_line_to (cr, x2, y3);
+	cairo_stroke (cr);
 
 	/* Major scale. */
 	x = x1;
 	y = y2 - data->row_height / 4;
 
-	planner_print_job_set_font_regular (data->job);
+	page->font = data->font;
 
 	t = mrp_time_align_prev (start, data->major_unit);
 	width = (mrp_time_align_next (t, data->major_unit) - t) / data->f;
@@ -320,18 +435,18 @@ print_time_header (PlannerGanttPrintData *data,
 
 		if (x + width > x1) {
 			if (x > x1) {
-				planner_print_job_moveto (data->job, x, y1);
-				planner_print_job_lineto (data->job, x, y2);
-				cairo_stroke (data->job->cr);
+				cairo_move_to (cr, x, y1);
+				cairo_line_to (cr, x, y2);
+				cairo_stroke (cr);
 			}
 
 			str = planner_scale_format_time (t, data->major_unit, data->major_format);
 
-			planner_print_job_show_clipped (data->job,
-							x + data->job->x_pad, y,
-							str,
-							MAX (x, x1), y1,
-							x + width, y2);
+			gantt_print_show_clipped (page,
+						  x + data->x_pad, y,
+						  str,
+						  MAX (x, x1), y1,
+						  x + width, y2);
 
 			g_free (str);
 		}
@@ -351,18 +466,18 @@ print_time_header (PlannerGanttPrintData *data,
 
 		if (x + width > x1) {
 			if (x > x1) {
-				planner_print_job_moveto (data->job, x, y2);
-				planner_print_job_lineto (data->job, x, y3);
-				cairo_stroke (data->job->cr);
+				cairo_move_to (cr, x, y2);
+				cairo_line_to (cr, x, y3);
+				cairo_stroke (cr);
 			}
 
 			str = planner_scale_format_time (t, data->minor_unit, data->minor_format);
 
-			planner_print_job_show_clipped (data->job,
-							x + data->job->x_pad, y,
-							str,
-							MAX (x, x1), y2,
-							x + width, y3);
+			gantt_print_show_clipped (page,
+						  x + data->x_pad, y,
+						  str,
+						  MAX (x, x1), y2,
+						  x + width, y3);
 
 			g_free (str);
 		}
@@ -373,7 +488,7 @@ print_time_header (PlannerGanttPrintData *data,
 
 typedef struct {
 	GtkTreeView *tree_view;
-	GList       *list;
+	GArray      *tasks;
 } ForeachVisibleData;
 
 static gboolean
@@ -386,7 +501,7 @@ foreach_visible_task (GtkTreeModel *model,
 	MrpTask            *task;
 	GtkTreeIter         parent_iter;
 	GtkTreePath        *parent_path;
-	PrintTask          *ptask;
+	PrintTask           ptask = { 0 };
 
 	gtk_tree_model_iter_parent (model, &parent_iter, iter);
 	parent_path = gtk_tree_model_get_path (model, &parent_iter);
@@ -397,18 +512,20 @@ foreach_visible_task (GtkTreeModel *model,
 				    COL_TASK, &task,
 				    -1);
 
-		ptask = g_new0 (PrintTask, 1);
-		ptask->task = task;
-		ptask->depth = gtk_tree_path_get_depth (path);
+		ptask.task = task;
+		ptask.depth = gtk_tree_path_get_depth (path);
+
+		g_array_append_val (fvd->tasks, ptask);
 
-		fvd->list = g_list_prepend (fvd->list, ptask);
+		/* The project keeps the task alive. */
+		g_object_unref (task);
 	}
 	gtk_tree_path_free (parent_path);
 
 	return FALSE;
 }
 
-static GList *
+static GArray *
 gantt_print_get_visible_tasks (PlannerGanttPrintData *data)
 {
 	ForeachVisibleData  fvd;
@@ -416,24 +533,53 @@ gantt_print_get_visible_tasks (PlannerGanttPrintData *data)
 
 	model = gtk_tree_view_get_model (data->tree_view);
 
-	fvd.list = NULL;
+	fvd.tasks = g_array_new (FALSE, FALSE, sizeof (PrintTask));
 	fvd.tree_view = data->tree_view;
 
 	gtk_tree_model_foreach (model,
 				foreach_visible_task,
 				&fvd);
 
-	return g_list_reverse (fvd.list);
+	return fvd.tasks;
 }
 
-static void
-gantt_print_free_print_tasks (GList *tasks)
+static gboolean
+gantt_print_add_task (MrpTask *task, GArray *tasks)
 {
-	GList *l;
+	PrintTask  ptask = { 0 };
+	MrpTask   *parent;
 
-	for (l = tasks; l; l = l->next) {
-		g_free (l->data);
+	parent = mrp_task_get_parent (task);
+
+	/* Skip the root task. */
+	if (!parent) {
+		return FALSE;
+	}
+
+	ptask.task = task;
+	for (; parent; parent = mrp_task_get_parent (parent)) {
+		ptask.depth++;
 	}
+
+	g_array_append_val (tasks, ptask);
+
+	return FALSE;
+}
+
+/* All tasks, fully expanded, for exporting without a task tree. */
+static GArray *
+gantt_print_get_all_tasks (PlannerGanttPrintData *data)
+{
+	GArray *tasks;
+
+	tasks = g_array_new (FALSE, FALSE, sizeof (PrintTask));
+
+	mrp_project_task_traverse (data->project,
+				   mrp_project_get_root_task (data->project),
+				   (MrpTaskTraverseFunc) gantt_print_add_task,
+				   tasks);
+
+	return tasks;
 }
 
 static GList *
@@ -457,59 +603,9 @@ gantt_print_get_relations (PlannerGanttPrintData *data)
 	return relations;
 }
 
-static void
-gantt_print_task (PlannerGanttPrintData *data, Element *element)
-{
-	cairo_new_path (data->job->cr);
-	planner_print_job_moveto (data->job, element->x1, element->y1);
-	planner_print_job_lineto (data->job, element->x2, element->y1);
-	planner_print_job_lineto (data->job, element->x2, element->y2);
-	planner_print_job_lineto (data->job, element->x1, element->y2);
-	cairo_close_path (data->job->cr);
-
-	cairo_save (data->job->cr);
-
-	if (data->show_critical && element->is_critical) {
-		cairo_set_source_rgb (data->job->cr, 205/255.0, 92/255.0, 92/255.0);
-	} else {
-		cairo_set_source_rgb (data->job->cr, 235/255.0, 235/255.0, 235/255.0);
-	}
-
-	cairo_fill_preserve (data->job->cr);
-	cairo_set_line_width (data->job->cr, THIN_LINE_WIDTH);
-	cairo_set_source_rgb (data->job->cr, 0, 0, 0);
-	cairo_stroke (data->job->cr);
-
-	cairo_restore (data->job->cr);
-
-
-	/* Percent complete. */
-	if (element->x_complete > 0) {
-		gdouble pad;
-
-		pad = (element->y2 - element->y1) * 0.25;
-
-		cairo_save (data->job->cr);
-
-		cairo_new_path (data->job->cr);
-		planner_print_job_moveto (data->job, element->x1, element->y1 + pad);
-		planner_print_job_lineto (data->job, element->x_complete, element->y1 + pad);
-		planner_print_job_lineto (data->job, element->x_complete, element->y2 - pad);
-		planner_print_job_lineto (data->job, element->x1, element->y2 - pad);
-		cairo_close_path (data->job->cr);
-
-		cairo_set_source_rgb (data->job->cr, 135/255.0, 135/255.0, 135/255.0);
-		cairo_fill (data->job->cr);
-
-		cairo_restore (data->job->cr);
-	}
-}
-
-static gboolean
-gantt_print_get_allocated_resources_string (PlannerGanttPrintData  *data,
-					    MrpTask                *task,
-					    gchar                 **str,
-					    gdouble                *width)
+static gchar *
+gantt_print_get_allocated_resources_string (PlannerGanttPrintData *data,
+					    MrpTask               *task)
 {
 	GList         *l;
 	GList         *assignments;
@@ -517,7 +613,6 @@ gantt_print_get_allocated_resources_string (PlannerGanttPrintData  *data,
 	MrpResource   *resource;
 	gchar         *name, *tmp_str, *name_unit;
 	gchar         *text = NULL;
-	gdouble        w = 0;
 	gint           units;
 
 	assignments = mrp_task_get_assignments (task);
@@ -568,440 +663,237 @@ gantt_print_get_allocated_resources_string (PlannerGanttPrintData  *data,
 		text = tmp_str;
 	}
 
-	if (text && width) {
-		w = planner_print_job_get_extents(data->job, text);
-	}
-
-	if (width) {
-		*width = w;
-	}
+	return text;
+}
 
-	if (str) {
-		*str = text;
+/* Gets the left edge and the time span of a column of pages. */
+static void
+gantt_print_get_column (PlannerGanttPrintData *data,
+			gint                   col,
+			gdouble               *x0,
+			mrptime               *t1,
+			mrptime               *t2)
+{
+	if (col == 0) {
+		/* Left-most column has the task tree. */
+		*x0 = data->tree_x2;
+		*t1 = data->start;
+		*t2 = data->second_column_start;
 	} else {
-		g_free (text);
+		*x0 = 0;
+		*t1 = data->second_column_start + (col - 1) * data->width * data->f;
+		*t2 = *t1 + data->width * data->f;
 	}
-
-	return text != NULL;
 }
 
-void
-planner_gantt_print_do (PlannerGanttPrintData *data, gint page_nr)
+/* Gets the row of pages a task is printed on, the top of the task area on
+ * that row and the task's index within it.
+ */
+static void
+gantt_print_get_task_row (PlannerGanttPrintData *data,
+			  gint                   index,
+			  gint                  *row,
+			  gdouble               *y0,
+			  gint                  *i)
 {
-	GList       *l;
-	gdouble      x1, x2;
-	mrptime      t1, t2;
-	Element     *element;
-	gint         row, col, first_task;
-	Page        *page;
-
-	/* Fourth pass, generate pages. */
-	col = page_nr % data->cols_of_pages;
-	row = page_nr / data->cols_of_pages;
-
-	x2 = data->job->width;
+	if (index < data->tasks_per_page_with_header) {
+		/* Top-most row has the header. */
+		*row = 0;
+		*y0 = data->header_height;
+		*i = index;
+	} else {
+		index -= data->tasks_per_page_with_header;
 
-	planner_print_job_begin_next_page (data->job);
+		*row = 1 + index / data->tasks_per_page_without_header;
+		*y0 = 0;
+		*i = index % data->tasks_per_page_without_header;
+	}
+}
 
+static gint
+gantt_print_get_first_task (PlannerGanttPrintData *data, gint row)
+{
 	if (row == 0) {
-		first_task = 0;
-	} else {
-		first_task = data->tasks_per_page_with_header +
-			     data->tasks_per_page_without_header * (row - 1);
+		return 0;
 	}
 
-	if (col == 0) {
-		x1 = data->tree_x2;
-		t1 = data->start;
-		t2 = data->second_column_start;
+	return data->tasks_per_page_with_header +
+		data->tasks_per_page_without_header * (row - 1);
+}
 
-		cairo_set_line_width (data->job->cr, THIN_LINE_WIDTH);
-
-		planner_print_job_moveto (data->job,
-					  data->tree_x2,
-					  0);
-		planner_print_job_lineto (data->job,
-					  data->tree_x2,
-					  data->job->height);
-		cairo_stroke (data->job->cr);
-
-		planner_print_job_moveto (data->job,
-					  data->name_x2,
-					  0);
-		planner_print_job_lineto (data->job,
-					  data->name_x2,
-					  data->job->height);
-		cairo_stroke (data->job->cr);
-
-		print_table_tasks (data,
-				   row == 0,
-				   data->tasks,
-				   first_task);
-	} else {
-		x1 = 0;
-		t1 = data->second_column_start + (col - 1) * data->job->width * data->f;
-		t2 = t1 + data->job->width * data->f;
+static ElementType
+gantt_print_get_task_type (PrintTask   *ptask,
+			   ElementType  task_type,
+			   ElementType  summary_type)
+{
+	if (ptask->is_summary) {
+		return summary_type;
+	}
+	else if (ptask->is_milestone) {
+		return MILESTONE;
 	}
 
-	page = GET_PAGE (data, row, col);
-	for (l = page->background_elements; l; l = l->next) {
-		gdouble dashes[] = { 4, 4 };
+	return task_type;
+}
 
-		element = l->data;
+/* Fills in the part of a task bar that falls on a column of pages, returns
+ * FALSE if there is none.
+ */
+static gboolean
+gantt_print_get_task_element (PlannerGanttPrintData *data,
+			      PrintTask             *ptask,
+			      gint                   col,
+			      gdouble                y1,
+			      gdouble                y2,
+			      Element               *element)
+{
+	mrptime start, finish, complete;
+	mrptime t1, t2;
+	gdouble x0;
 
-		switch (element->type) {
-		case TIMELINE:
-			cairo_new_path (data->job->cr);
-			cairo_set_source_rgb (data->job->cr, 150/255.0, 150/255.0, 249/255.0);
+	gantt_print_get_column (data, col, &x0, &t1, &t2);
 
-			cairo_set_dash (data->job->cr, dashes, 2, 0);
+	start = ptask->start;
+	finish = ptask->finish;
+	complete = ptask->complete;
 
-			cairo_set_line_width (data->job->cr, 1);
-			planner_print_job_moveto (data->job, element->x1, element->y1);
-			planner_print_job_lineto (data->job, element->x1, element->y2);
-			cairo_stroke (data->job->cr);
+	memset (element, 0, sizeof (Element));
 
-			cairo_set_dash (data->job->cr, NULL, 0, 0);
+	element->y1 = y1;
+	element->y2 = y2;
+	element->is_critical = ptask->is_critical;
 
-			break;
-		case SHADE:
-			cairo_new_path (data->job->cr);
-			planner_print_job_moveto (data->job, element->x1, element->y1);
-			planner_print_job_lineto (data->job, element->x2, element->y1);
-			planner_print_job_lineto (data->job, element->x2, element->y2);
-			planner_print_job_lineto (data->job, element->x1, element->y2);
-			cairo_close_path (data->job->cr);
-
-			cairo_set_source_rgb (data->job->cr, 249/255.0, 249/255.0, 249/255.0);
-			cairo_fill (data->job->cr);
-
-			cairo_set_line_width (data->job->cr, THIN_LINE_WIDTH);
-			cairo_set_source_rgb (data->job->cr, 150/255.0, 150/255.0, 150/255.0);
-			planner_print_job_moveto (data->job, element->x1, element->y1);
-			planner_print_job_lineto (data->job, element->x1, element->y2);
-			cairo_stroke (data->job->cr);
-			break;
-		default:
-			break;
-		}
+	/* Identify the cases: only left-most part on page, only right-most
+	 * part, the whole task, or only the mid-section.
+	 */
+	if (start >= t1 && start <= t2 && finish > t2) {
+		/* Left */
+		element->type = gantt_print_get_task_type (ptask, TASK_LEFT, SUMMARY_LEFT);
+
+		element->x1 = x0 + (start - t1) / data->f;
+		element->x2 = data->width;
+		element->x_complete = x0 + (complete - t1) / data->f;
+		element->x_complete = MIN (element->x_complete, element->x2);
 	}
-
-	cairo_set_source_rgb (data->job->cr, 0, 0, 0);
-
-	if (row == 0) {
-		print_time_header (data, x1, x2, t1, t2);
-		if (col == 0) {
-			print_table_header (data);
-		}
+	else if (start < t1 && finish >= t1 && finish <= t2) {
+		/* Right */
+		element->type = gantt_print_get_task_type (ptask, TASK_RIGHT, SUMMARY_RIGHT);
+
+		element->x1 = x0;
+		element->x2 = x0 + (finish - t1) / data->f;
+		element->x_complete = x0 + (complete - t1) / data->f;
+		element->x_complete = MIN (element->x_complete, element->x2);
 	}
+	else if (start >= t1 && finish <= t2) {
+		/* Whole */
+		element->type = gantt_print_get_task_type (ptask, TASK_WHOLE, SUMMARY_WHOLE);
+
+		element->x1 = x0 + (start - t1) / data->f;
+		element->x2 = x0 + (finish - t1) / data->f;
+		element->x_complete = x0 + (complete - t1) / data->f;
+		element->x_complete = MIN (element->x_complete, element->x2);
+	}
+	else if (start < t1 && finish > t2) {
+		/* Middle */
+		element->type = gantt_print_get_task_type (ptask, TASK_MIDDLE, SUMMARY_MIDDLE);
 
-	for (l = page->elements; l; l = l->next) {
-		element = l->data;
-
-		cairo_set_source_rgb (data->job->cr, 0, 0, 0);
+		element->x1 = x0;
+		element->x2 = data->width;
 
-		switch (element->type) {
-		case TASK_LEFT:
-		case TASK_RIGHT:
-		case TASK_WHOLE:
-		case TASK_MIDDLE:
-			gantt_print_task (data, element);
-			break;
-		case SUMMARY_LEFT:
-			planner_print_job_moveto (data->job,
-						  element->x1,
-						  element->y1 + data->summary_thick);
-			planner_print_job_lineto (data->job,
-						  element->x1,
-						  element->y1 + data->summary_thick + data->summary_height);
-			planner_print_job_lineto (data->job,
-						  element->x1 + data->summary_slope,
-						  element->y1 + data->summary_thick);
-			cairo_close_path (data->job->cr);
-			cairo_fill (data->job->cr);
-
-			planner_print_job_moveto (data->job,
-						  element->x2,
-						  element->y1 + 2 * data->summary_thick);
-			planner_print_job_lineto (data->job,
-						  element->x1,
-						  element->y1 + 2 * data->summary_thick);
-			planner_print_job_lineto (data->job,
-						  element->x1,
-						  element->y1 + data->summary_thick);
-			planner_print_job_lineto (data->job,
-						  element->x2,
-						  element->y1 + data->summary_thick);
-			cairo_close_path (data->job->cr);
-			cairo_fill (data->job->cr);
-			break;
-		case SUMMARY_RIGHT:
-			planner_print_job_moveto (data->job,
-						  element->x2,
-						  element->y1 + data->summary_thick);
-			planner_print_job_lineto (data->job,
-						  element->x2,
-						  element->y1 + data->summary_thick + data->summary_height);
-			planner_print_job_lineto (data->job,
-						  element->x2 - data->summary_slope,
-						  element->y1 + data->summary_thick);
-			cairo_close_path (data->job->cr);
-			cairo_fill (data->job->cr);
-
-			planner_print_job_moveto (data->job,
-						  element->x2,
-						  element->y1 + 2 * data->summary_thick);
-			planner_print_job_lineto (data->job,
-						  element->x1,
-						  element->y1 + 2 * data->summary_thick);
-			planner_print_job_lineto (data->job,
-						  element->x1,
-						  element->y1 + data->summary_thick);
-			planner_print_job_lineto (data->job,
-						  element->x2,
-						  element->y1 + data->summary_thick);
-			cairo_close_path (data->job->cr);
-			cairo_fill (data->job->cr);
-			break;
-		case SUMMARY_WHOLE:
-			planner_print_job_moveto (data->job,
-						  element->x1,
-						  element->y1 + data->summary_thick);
-			planner_print_job_lineto (data->job,
-						  element->x1,
-						  element->y1 + data->summary_thick + data->summary_height);
-			planner_print_job_lineto (data->job,
-						  element->x1 + data->summary_slope,
-						  element->y1 + data->summary_thick);
-			cairo_close_path (data->job->cr);
-			cairo_fill (data->job->cr);
-
-			planner_print_job_moveto (data->job,
-						  element->x2,
-						  element->y1 + data->summary_thick);
-			planner_print_job_lineto (data->job,
-						  element->x2,
-						  element->y1 + data->summary_thick + data->summary_height);
-			planner_print_job_lineto (data->job,
-						  element->x2 - data->summary_slope,
-						  element->y1 + data->summary_thick);
-			cairo_close_path (data->job->cr);
-			cairo_fill (data->job->cr);
-
-			planner_print_job_moveto (data->job,
-						  element->x2,
-						  element->y1 + 2 * data->summary_thick);
-			planner_print_job_lineto (data->job,
-						  element->x1,
-						  element->y1 + 2 * data->summary_thick);
-			planner_print_job_lineto (data->job,
-						  element->x1,
-						  element->y1 + data->summary_thick);
-			planner_print_job_lineto (data->job,
-						  element->x2,
-						  element->y1 + data->summary_thick);
-			cairo_close_path (data->job->cr);
-			cairo_fill (data->job->cr);
-			break;
-		case SUMMARY_MIDDLE:
-			planner_print_job_moveto (data->job,
-						  element->x2,
-						  element->y1 + 2 * data->summary_thick);
-			planner_print_job_lineto (data->job,
-						  element->x1,
-						  element->y1 + 2 * data->summary_thick);
-			planner_print_job_lineto (data->job,
-						  element->x1,
-						  element->y1 + data->summary_thick);
-			planner_print_job_lineto (data->job,
-						  element->x2,
-						  element->y1 + data->summary_thick);
-			cairo_close_path (data->job->cr);
-			cairo_fill (data->job->cr);
-			break;
-		case RELATION_ARROW_DOWN:
-			planner_print_job_moveto (data->job,
-						  element->x1,
-						  element->y1);
-			planner_print_job_lineto (data->job,
-						  element->x1 - data->arrow_width,
-						  element->y1 - data->arrow_height);
-			planner_print_job_lineto (data->job,
-						  element->x1 + data->arrow_width,
-						  element->y1 - data->arrow_height);
-			cairo_close_path (data->job->cr);
-			cairo_fill (data->job->cr);
-			break;
-		case RELATION_ARROW_UP:
-			planner_print_job_moveto (data->job,
-						  element->x1,
-						  element->y1);
-			planner_print_job_lineto (data->job,
-						  element->x1 - data->arrow_width,
-						  element->y1 + data->arrow_height);
-			planner_print_job_lineto (data->job,
-						  element->x1 + data->arrow_width,
-						  element->y1 + data->arrow_height);
-			cairo_close_path (data->job->cr);
-			cairo_fill (data->job->cr);
-			break;
-		case RELATION_HORIZ:
-			planner_print_job_moveto (data->job, element->x1, element->y1);
-			planner_print_job_lineto (data->job, element->x2, element->y1);
-			cairo_stroke (data->job->cr);
-			break;
-		case RELATION_VERT:
-			planner_print_job_moveto (data->job, element->x1, element->y1);
-			planner_print_job_lineto (data->job, element->x1, element->y2);
-			cairo_stroke (data->job->cr);
-			break;
-		case MILESTONE:
-			planner_print_job_moveto (data->job,
-						  element->x1,
-						  element->y1);
-			planner_print_job_lineto (data->job,
-						  element->x1 + data->milestone_size,
-						  element->y1 + data->milestone_size);
-			planner_print_job_lineto (data->job,
-						  element->x1,
-						  element->y1 + 2 * data->milestone_size);
-			planner_print_job_lineto (data->job,
-						  element->x1 - data->milestone_size,
-						  element->y1 + data->milestone_size);
-			cairo_close_path (data->job->cr);
-			cairo_fill (data->job->cr);
-			break;
-		case RESOURCES:
-			planner_print_job_show_clipped (data->job,
-							element->x1,
-							element->y1,
-							element->resources,
-							0, 0,
-							data->job->width,
-							data->job->height);
-			break;
-		default:
-			break;
+		if (complete > t1 && complete <= t2) {
+			element->x_complete = x0 + (complete - t1) / data->f;
+			element->x_complete = MIN (element->x_complete, element->x2);
 		}
+	} else {
+		return FALSE;
 	}
 
-	planner_print_job_finish_page (data->job, TRUE);
+	return TRUE;
 }
 
-PlannerGanttPrintData *
-planner_gantt_print_data_new (PlannerView     *view,
-			      PlannerPrintJob *job,
-			      GtkTreeView     *tree_view,
-			      gint             level,
-			      gboolean         show_critical)
+/* Takes a snapshot of the tasks and works out the page matrix and where
+ * each task bar starts and ends. The page contents are laid out later, one
+ * page at a time.
+ */
+static void
+gantt_print_data_setup (PlannerGanttPrintData *data, GArray *tasks)
 {
-	PlannerGanttPrintData *data;
-	GList                 *tasks = NULL, *l;
-	gint                   num_tasks;
-	gdouble                max_name_width = 0.0;
-	gdouble                ext;
-	GList       *relations;
-	gdouble      y1, y2;
-	mrptime      t1, t2, t0;
+	PrintTask   *ptask;
+	GHashTable  *task_index;
+	GList       *relations, *l;
+	Element      element;
+	gdouble      max_name_width = 0.0;
+	gdouble      ext, name_width;
+	gdouble      x0, y0, y1, y2;
+	mrptime      t0, t1, t2;
 	mrptime      current_time;
-	mrptime      start, finish;
-	mrptime      complete;
-	gboolean     is_summary;
-	gboolean     is_critical;
 	MrpTaskType  type;
-	PrintTask   *ptask;
-	TaskCoord   *task_coord;
-	Element     *element;
-	gdouble      x0, y0;
-	gint         i, row, col;
-	gint         tasks_on_this_page;
-	gchar       *name;
-	Page        *page;
-	gchar       *str;
 	MrpCalendar *calendar;
 	MrpDay      *day;
 	GList       *ivals;
+	gint         index, i, row, col;
+	gint         work;
 
-	data = g_new0 (PlannerGanttPrintData, 1);
-
-	data->view = view;
-	data->job = job;
-	data->project = planner_window_get_project (view->main_window);
-
-	data->tree_view = tree_view;
+	data->n_tasks = tasks->len;
+	data->tasks = (PrintTask *) g_array_free (tasks, FALSE);
 
-	data->show_critical = show_critical;
-	data->level = level;
+	data->finish = data->start;
 
-	/* Note: This looks hackish, but it's more or less the same equation
-	 * used for the zoom level in the gantt chart, which actually is
-	 * calculated to have a "good feel" :).
-	 */
-	data->f = 1.8 / pow (2, level - 19);
+	for (index = 0; index < data->n_tasks; index++) {
+		ptask = &data->tasks[index];
 
-	data->major_unit = planner_scale_conf[level].major_unit;
-	data->major_format = planner_scale_conf[level].major_format;
+		g_object_get (ptask->task,
+			      "name", &ptask->name,
+			      "work", &work,
+			      "type", &type,
+			      "critical", &ptask->is_critical,
+			      NULL);
 
-	data->minor_unit = planner_scale_conf[level].minor_unit;
-	data->minor_format = planner_scale_conf[level].minor_format;
+		if (!ptask->name) {
+			ptask->name = g_strdup ("");
+		}
 
-	data->task_start_coords = g_hash_table_new_full (NULL, NULL, NULL, g_free);
-	data->task_finish_coords = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+		ptask->work = planner_format_duration (data->project, work);
+		ptask->resources = gantt_print_get_allocated_resources_string (data, ptask->task);
 
-	/* Start and finish of the project. */
-	data->start = mrp_project_get_project_start (data->project);
+		ptask->start = mrp_task_get_work_start (ptask->task);
+		ptask->finish = mrp_task_get_finish (ptask->task);
+		ptask->complete = ptask->start + (ptask->finish - ptask->start) *
+			mrp_task_get_percent_complete (ptask->task) / 100.0;
 
-	tasks = gantt_print_get_visible_tasks (data);
-	data->tasks = tasks;
-	num_tasks = g_list_length (tasks);
+		ptask->is_summary = mrp_task_get_n_children (ptask->task) > 0;
+		ptask->is_milestone = !ptask->is_summary && type == MRP_TASK_TYPE_MILESTONE;
 
-	data->finish = data->start;
+		/* The end time is the finish of the right-most task. */
+		data->finish = MAX (data->finish, ptask->finish);
 
-	/* Go through the tasks and get the end time by checking the right-most
-	 * resource label we will print.
-	 */
-	for (l = tasks; l; l = l->next) {
-		PrintTask *ptask = l->data;
-		MrpTask   *task  = ptask->task;
-		gchar     *name;
-		mrptime    finish;
-		gdouble    width;
-		gdouble    name_width;
-
-		g_object_get (task,
-			      "name", &name,
-			      "finish", &finish,
-			      NULL);
+		if (ptask->is_milestone) {
+			ptask->finish = ptask->start;
+		}
 
-		ext = planner_print_job_get_extents(data->job, name);
-		name_width = ext + ptask->depth * INDENT_FACTOR * data->job->x_pad;
+		ext = gantt_print_get_extents (data, ptask->name);
+		name_width = ext + ptask->depth * INDENT_FACTOR * data->x_pad;
 
 		if (max_name_width < name_width) {
 			max_name_width = name_width;
 		}
-
-		gantt_print_get_allocated_resources_string (data, task, NULL, &width);
-
-		data->finish = MAX (data->finish, finish);/* + width * data->f);*/
-
-		g_free (name);
 	}
 
 	/* TODO: figure out why the width of WW and WORKWO is significant */
 	data->name_x1 = 0;
-	ext = planner_print_job_get_extents (data->job, "WW");
+	ext = gantt_print_get_extents (data, "WW");
 	data->name_x2 = data->name_x1 + max_name_width + ext;
 
 	data->work_x1 = data->name_x2;
-	ext = planner_print_job_get_extents (data->job, "WORKWO");
+	ext = gantt_print_get_extents (data, "WORKWO");
 	data->work_x2 = data->work_x1 + ext;
 
 	data->tree_x1 = 0;
 	data->tree_x2 = data->work_x2;
 
-	data->second_column_start = data->start + (data->job->width - (data->tree_x2 - data->tree_x1)) * data->f;
+	data->second_column_start = data->start + (data->width - (data->tree_x2 - data->tree_x1)) * data->f;
 
-	data->row_height = 2 * planner_print_job_get_font_height (job);
+	data->row_height = 2 * data->font_height;
 
 	data->header_height = 2 * data->row_height + data->row_height / 4;
 
@@ -1013,523 +905,1051 @@ planner_gantt_print_data_new (PlannerView     *view,
 	data->arrow_height   = 0.24 * data->row_height;
 	data->arrow_width    = 0.11 * data->row_height;
 
-	if (num_tasks > 0) {
-		data->tasks_per_page_without_header = data->job->height / data->row_height;
-		data->tasks_per_page_with_header = (data->job->height - data->header_height) /
-			data->row_height;
-
-		data->cols_of_pages = ceil (((data->finish - data->start) /
-					     data->f + data->tree_x2 - data->tree_x1) /
-					    data->job->width);
-
-		data->rows_of_pages = ceil ((num_tasks * data->row_height + data->header_height) /
-					    (data->job->height - data->row_height));
+	data->relations = g_array_new (FALSE, FALSE, sizeof (PrintRelation));
 
-		if (data->tasks_per_page_without_header * (data->rows_of_pages - 2) +
-		    data->tasks_per_page_with_header >= num_tasks) {
-			data->rows_of_pages--;
-		}
+	if (data->n_tasks == 0) {
+		return;
+	}
 
-		data->cols_of_pages = MAX (1, data->cols_of_pages);
-		data->rows_of_pages = MAX (1, data->rows_of_pages);
+	data->tasks_per_page_without_header = data->height / data->row_height;
+	data->tasks_per_page_with_header = (data->height - data->header_height) /
+		data->row_height;
 
- 		data->pages = g_new0 (Page, data->cols_of_pages * data->rows_of_pages);
+	data->cols_of_pages = ceil (((data->finish - data->start) /
+				     data->f + data->tree_x2 - data->tree_x1) /
+				    data->width);
 
+	data->rows_of_pages = ceil ((data->n_tasks * data->row_height + data->header_height) /
+				    (data->height - data->row_height));
 
+	if (data->tasks_per_page_without_header * (data->rows_of_pages - 2) +
+	    data->tasks_per_page_with_header >= data->n_tasks) {
+		data->rows_of_pages--;
 	}
 
-	calendar = mrp_project_get_calendar (data->project);
-
-	num_tasks = g_list_length (data->tasks);
+	data->cols_of_pages = MAX (1, data->cols_of_pages);
+	data->rows_of_pages = MAX (1, data->rows_of_pages);
 
-	current_time = mrp_time_current_time();
-
-	/* Go through all tasks in a first pass and layout them so that we know
-	 * where to draw relation arrows.
+	/* Find where each task bar starts and ends, so that we know where to
+	 * draw relation arrows.
 	 */
+	for (index = 0; index < data->n_tasks; index++) {
+		ptask = &data->tasks[index];
 
-	l = data->tasks;
-	row = 0;
-	col = 0;
-	while (l) {
-		if (row == 0) {
-			/* Top-most row has the header. */
-			y0 = data->header_height;
-			tasks_on_this_page = data->tasks_per_page_with_header;
-		} else {
-			y0 = 0;
-			tasks_on_this_page = data->tasks_per_page_without_header;
-		}
+		gantt_print_get_task_row (data, index, &row, &y0, &i);
 
-		/* Loop through the tasks on this row of pages. */
-		for (i = 0; i < tasks_on_this_page; i++) {
-			ptask = l->data;
+		y1 = y0 + data->row_height * (i + 0.25);
+		y2 = y1 + 0.5 * data->row_height;
 
-			start = mrp_task_get_work_start (ptask->task);
-			finish = mrp_task_get_finish (ptask->task);
-			complete = start + (finish - start) *
-				mrp_task_get_percent_complete (ptask->task) / 100.0;
+		/* Loop through the columns that this task covers. */
+		for (col = 0; ; col++) {
+			gantt_print_get_column (data, col, &x0, &t1, &t2);
+			if (t1 > ptask->finish) {
+				break;
+			}
 
-			is_summary = mrp_task_get_n_children (ptask->task) > 0;
+			if (!gantt_print_get_task_element (data, ptask, col, y1, y2, &element)) {
+				continue;
+			}
 
-			g_object_get (ptask->task,
-				      "name", &name,
-				      "type", &type,
-				      "critical", &is_critical,
-				      NULL);
+			switch (element.type) {
+			case TASK_WHOLE:
+			case TASK_LEFT:
+			case SUMMARY_WHOLE:
+			case SUMMARY_LEFT:
+			case MILESTONE:
+				ptask->start_coord.row = row;
+				ptask->start_coord.col = col;
+				ptask->start_coord.x = element.x1;
+				ptask->start_coord.y = y1 - (y2 - y1) / 2;
+				ptask->start_coord.valid = TRUE;
+				break;
+			default:
+				break;
+			}
 
-			if (!is_summary && type == MRP_TASK_TYPE_MILESTONE) {
-				finish = start;
+			switch (element.type) {
+			case TASK_WHOLE:
+			case TASK_RIGHT:
+			case SUMMARY_WHOLE:
+			case SUMMARY_RIGHT:
+			case MILESTONE:
+				ptask->finish_coord.row = row;
+				ptask->finish_coord.col = col;
+				ptask->finish_coord.x = element.x2;
+				ptask->finish_coord.y = y1 + (y2 - y1) / 2;
+				ptask->finish_coord.valid = TRUE;
+				break;
+			default:
+				break;
 			}
+		}
+	}
 
-			d(g_print ("%s: ", name));
-			g_free (name);
+	/* Keep the relations between tasks that are both printed. */
+	task_index = g_hash_table_new (NULL, NULL);
+	for (index = 0; index < data->n_tasks; index++) {
+		g_hash_table_insert (task_index,
+				     data->tasks[index].task,
+				     GINT_TO_POINTER (index + 1));
+	}
 
-			col = 0;
-			t1 = data->start;
+	relations = gantt_print_get_relations (data);
+	for (l = relations; l; l = l->next) {
+		PrintRelation relation;
 
-			y1 = y0 + data->row_height * (i + 0.25);
-			y2 = y1 + 0.5 * data->row_height;
+		relation.predecessor = GPOINTER_TO_INT (
+			g_hash_table_lookup (task_index,
+					     mrp_relation_get_predecessor (l->data))) - 1;
+		relation.successor = GPOINTER_TO_INT (
+			g_hash_table_lookup (task_index,
+					     mrp_relation_get_successor (l->data))) - 1;
 
+		/* One of the tasks might not be visible. */
+		if (relation.predecessor < 0 || relation.successor < 0 ||
+		    !data->tasks[relation.predecessor].finish_coord.valid ||
+		    !data->tasks[relation.successor].start_coord.valid) {
+			continue;
+		}
 
-			/* Loop through the columns that this task covers. */
-			while (t1 <= finish) {
-				if (col == 0) {
-					/* Left-most column has the task tree. */
-					x0 = data->tree_x2;
-					t2 = data->second_column_start;
-				} else {
-					x0 = 0;
-					t2 = t1 + data->job->width * data->f;
-				}
+		g_array_append_val (data->relations, relation);
+	}
 
-				element = g_new0 (Element, 1);
-
-				element->y1 = y1;
-				element->y2 = y2;
-				element->is_critical = is_critical;
-
-				/* Identify the cases: only left-most part on
-				 * page, only right-most part, the whole task,
-				 * or only the mid-section.
-				 */
-				if (start >= t1 && start <= t2 && finish > t2) {
-					/* Left */
-					d(g_print ("left "));
-
-					if (is_summary) {
-						element->type = SUMMARY_LEFT;
-					}
-					else if (type == MRP_TASK_TYPE_MILESTONE) {
-						element->type = MILESTONE;
-					} else {
-						element->type = TASK_LEFT;
-					}
-
-					element->x1 = x0 + (start - t1) / data->f;
-					element->x2 = data->job->width;
-					element->x_complete = x0 + (complete - t1) / data->f;
-					element->x_complete = MIN (element->x_complete, element->x2);
-				}
-				else if (start < t1 && finish >= t1 && finish <= t2) {
-					/* Right */
-					d(g_print ("right "));
-
-					if (is_summary) {
-						element->type = SUMMARY_RIGHT;
-					}
-					else if (type == MRP_TASK_TYPE_MILESTONE) {
-						element->type = MILESTONE;
-					} else {
-						element->type = TASK_RIGHT;
-					}
-
-					element->x1 = x0;
-					element->x2 = x0 + (finish - t1) / data->f;
-					element->x_complete = x0 + (complete - t1) / data->f;
-					element->x_complete = MIN (element->x_complete, element->x2);
-				}
-				else if (start >= t1 && finish <= t2) {
-					/* Whole */
-					d(g_print ("whole "));
-
-					if (is_summary) {
-						element->type = SUMMARY_WHOLE;
-					}
-					else if (type == MRP_TASK_TYPE_MILESTONE) {
-						element->type = MILESTONE;
-					} else {
-						element->type = TASK_WHOLE;
-					}
-
-					element->x1 = x0 + (start - t1) / data->f;
-					element->x2 = x0 + (finish - t1) / data->f;
-					element->x_complete = x0 + (complete - t1) / data->f;
-					element->x_complete = MIN (element->x_complete, element->x2);
-				}
-				else if (start < t1 && finish > t2) {
-					/* Middle */
-					d(g_print ("middle "));
-
-					if (is_summary) {
-						element->type = SUMMARY_MIDDLE;
-					}
-					else if (type == MRP_TASK_TYPE_MILESTONE) {
-						element->type = MILESTONE;
-					} else {
-						element->type = TASK_MIDDLE;
-					}
-
-					element->x1 = x0;
-					element->x2 = data->job->width;
-
-					if (complete > t1 && complete <= t2) {
-						element->x_complete = x0 + (complete - t1) / data->f;
-						element->x_complete = MIN (element->x_complete, element->x2);
-					}
-				} else {
-					d(g_print ("nothing"));
-					g_free (element);
-					element = NULL;
-				}
+	g_list_free (relations);
+	g_hash_table_destroy (task_index);
 
-				if (element) {
-					switch (element->type) {
-					case TASK_WHOLE:
-					case TASK_LEFT:
-					case SUMMARY_WHOLE:
-					case SUMMARY_LEFT:
-					case MILESTONE:
-						task_coord = g_new0 (TaskCoord, 1);
-						task_coord->row = row;
-						task_coord->col = col;
-
-						task_coord->x = element->x1;
-						task_coord->y = y1 - (y2 - y1) / 2;
-
-						g_hash_table_insert (data->task_start_coords,
-								     ptask->task,
-								     task_coord);
-						break;
-					default:
-						break;
-					}
-
-					switch (element->type) {
-					case TASK_WHOLE:
-					case TASK_RIGHT:
-					case SUMMARY_WHOLE:
-					case SUMMARY_RIGHT:
-					case MILESTONE:
-						task_coord = g_new0 (TaskCoord, 1);
-						task_coord->row = row;
-						task_coord->col = col;
-
-						task_coord->x = element->x2;
-						task_coord->y = y1 + (y2 - y1) / 2;
-
-						g_hash_table_insert (data->task_finish_coords,
-								     ptask->task,
-								     task_coord);
-						break;
-					default:
-						break;
-					}
-
-					page = GET_PAGE (data, row, col);
-					page->elements = g_list_prepend (page->elements, element);
-				}
+	/* Background shading for non-work intervals, and the current time. */
+	calendar = mrp_project_get_calendar (data->project);
+	current_time = mrp_time_current_time ();
 
-				t1 = t2;
-				col++;
-			}
+	data->shades = g_new0 (GArray *, data->cols_of_pages);
+	data->timelines = g_new0 (gdouble, data->cols_of_pages);
 
-			d(g_print ("\n"));
+	t0 = mrp_time_align_day (data->start);
 
-			/* Handle the allocated resources. */
-			if (gantt_print_get_allocated_resources_string (data, ptask->task, &str, NULL)) {
-				task_coord = g_hash_table_lookup (data->task_finish_coords,
-								  ptask->task);
+	for (col = 0; col < data->cols_of_pages; col++) {
+		mrptime ival_start, ival_end, ival_prev;
 
-				/* FIXME: Remove this check when the scheduler
-				 * is fixed. We get a crash here if tasks get
-				 * really odd start/finish values. This
-				 * sometimes happens for complex projects now.
-				 */
-				if (!task_coord) {
-					goto fail;
-				}
+		data->shades[col] = g_array_new (FALSE, FALSE, sizeof (PrintShade));
 
-				element = g_new0 (Element, 1);
-				element->type = RESOURCES;
+		if (col == 0) {
+			/* Left-most col has the tree. */
+			x0 = data->tree_x2;
+		} else {
+			x0 = 0;
+		}
 
-				element->x1 = task_coord->x + data->job->x_pad;
-				element->y1 = y0 + data->row_height * (i + 0.75);
+		t2 = t0 + (data->width - x0) * data->f;
 
-				element->resources = str;
+		/* Loop through the days between t0 and t2. */
+		t1 = mrp_time_align_day(t0);
 
-				page = GET_PAGE (data, row, col - 1);
-				page->elements = g_list_prepend (page->elements, element);
-			}
+		while (t1 <= t2) {
+			gboolean done = FALSE;
 
-		fail:
+			day = mrp_calendar_get_day (calendar, t1, TRUE);
 
-			l = l->next;
-			if (!l) {
-				break;
+			ivals = mrp_calendar_day_get_intervals (calendar, day, TRUE);
+
+			ival_prev = t1;
+
+			/* Loop through the non-work intervals for this day */
+			while (!done)
+			{
+				/* The number of non-work intervals is one for each work interval and one
+				 * more for the remaining period after the last work interval */
+				if (ivals != NULL) {
+					mrp_interval_get_absolute (ivals->data,
+								   t1,
+								   &ival_start,
+								   &ival_end);
+
+					ivals = ivals->next;
+				} else {
+					ival_start = t1 + 60*60*24;
+					done = TRUE;
+				}
+
+				/* Only consider non-work intervals that are large enough and
+				 * lie (partially) within [t0...t2] */
+				if (ival_prev < t2 && ival_start > t0 &&
+				    planner_scale_conf[data->level].nonworking_limit <= ival_start - ival_prev) {
+					PrintShade shade;
+
+					/* Only draw the part within [t0...t2] */
+					shade.x1 = x0 + (MAX(t0, ival_prev) - t0) / data->f;
+					shade.x2 = x0 + (MIN(t2, ival_start) - t0) / data->f;
+
+					g_array_append_val (data->shades[col], shade);
+				}
+
+				ival_prev = ival_end;
 			}
+			/* Set t1 to the start of the next day */
+			t1 = ival_start;
 		}
 
-		row++;
-		col = 0;
-	}
+		/* The current time, if it's in this column. */
+		if (current_time >= t0 && current_time <= t2) {
+			data->timelines[col] = x0 + (current_time - t0) / data->f;
+		} else {
+			data->timelines[col] = -1;
+		}
 
-	/* Second pass, go through all relations and add elements for them. */
-	relations = gantt_print_get_relations (data);
-	for (l = relations; l; l = l->next) {
-		MrpTask     *predecessor, *successor;
-		TaskCoord   *pre_coord, *suc_coord;
-		Page        *page;
-		MrpRelation *relation = l->data;
-		gint         from_row, to_row;
-		gdouble      top;
+		t0 = t2;
+	}
+}
 
-		predecessor = mrp_relation_get_predecessor (relation);
-		successor = mrp_relation_get_successor (relation);
+static void
+gantt_print_add_element (GArray *elements, Element *element)
+{
+	g_array_append_vals (elements, element, 1);
+}
 
-		pre_coord = g_hash_table_lookup (data->task_finish_coords, predecessor);
-		suc_coord = g_hash_table_lookup (data->task_start_coords, successor);
+/* Lays out the relation arrows passing through a page. */
+static void
+gantt_print_layout_relations (PlannerGanttPrintData *data,
+			      gint                   row,
+			      gint                   col,
+			      GArray                *elements)
+{
+	PrintRelation *relation;
+	TaskCoord     *pre_coord, *suc_coord;
+	Element        element;
+	gint           from_row, to_row;
+	gdouble        top;
+	guint          i;
 
-		/* One of the tasks might not be visible. */
-		if (!pre_coord || !suc_coord) {
-			continue;
-		}
+	for (i = 0; i < data->relations->len; i++) {
+		relation = &g_array_index (data->relations, PrintRelation, i);
 
-		element = g_new0 (Element, 1);
-		element->x1 = suc_coord->x;
+		pre_coord = &data->tasks[relation->predecessor].finish_coord;
+		suc_coord = &data->tasks[relation->successor].start_coord;
 
 		from_row = MIN (pre_coord->row, suc_coord->row);
 		to_row = MAX (pre_coord->row, suc_coord->row);
 
+		if (row < from_row || row > to_row) {
+			continue;
+		}
+
 		/* Get the right direction and position of the arrow depending on
 		 * the order of the predecessor and successor.
 		 */
-		if ((pre_coord->row == suc_coord->row && pre_coord->y < suc_coord->y) ||
-		    (pre_coord->row < suc_coord->row)) {
-			element->y1 = suc_coord->y + data->row_height * 0.25;
-			element->type = RELATION_ARROW_DOWN;
-		} else {
-			element->y1 = suc_coord->y + data->row_height * 0.75;
-			element->type = RELATION_ARROW_UP;
-		}
-
-		page = GET_PAGE (data, suc_coord->row, suc_coord->col);
-		page->elements = g_list_prepend (page->elements, element);
-
-		for (row = from_row; row <= to_row; row++) {
-			if (row == pre_coord->row) {
-				for (col = pre_coord->col; col <= suc_coord->col; col++) {
-					element = g_new0 (Element, 1);
-					element->type = RELATION_HORIZ;
-
-					if (col == pre_coord->col) {
-						element->x1 = pre_coord->x;
-					} else {
-						if (col == 0) {
-							element->x1 = data->tree_x2;
-						} else {
-							element->x1 = 0;
-						}
-					}
-
-					if (col == suc_coord->col) {
-						element->x2 = suc_coord->x;
-					} else {
-						element->x2 = data->job->width;
-					}
-
-					element->y1 = pre_coord->y;
-
-					page = GET_PAGE (data, row, col);
-					page->elements = g_list_prepend (page->elements, element);
-				}
+		if (row == suc_coord->row && col == suc_coord->col) {
+			memset (&element, 0, sizeof (Element));
+			element.x1 = suc_coord->x;
+
+			if ((pre_coord->row == suc_coord->row && pre_coord->y < suc_coord->y) ||
+			    (pre_coord->row < suc_coord->row)) {
+				element.y1 = suc_coord->y + data->row_height * 0.25;
+				element.type = RELATION_ARROW_DOWN;
+			} else {
+				element.y1 = suc_coord->y + data->row_height * 0.75;
+				element.type = RELATION_ARROW_UP;
 			}
 
-			element = g_new0 (Element, 1);
-			element->type = RELATION_VERT;
-			element->x1 = suc_coord->x;
+			gantt_print_add_element (elements, &element);
+		}
 
-			if (row == 0) {
-				top = data->header_height;
-			} else {
-				top = 0;
-			}
+		if (row == pre_coord->row && col >= pre_coord->col && col <= suc_coord->col) {
+			memset (&element, 0, sizeof (Element));
+			element.type = RELATION_HORIZ;
 
-			if (row == pre_coord->row) {
-				element->y1 = pre_coord->y;
+			if (col == pre_coord->col) {
+				element.x1 = pre_coord->x;
 			} else {
-				if (pre_coord->row <= suc_coord->row) {
-					element->y1 = top;
+				if (col == 0) {
+					element.x1 = data->tree_x2;
 				} else {
-					element->y1 = data->job->height;
+					element.x1 = 0;
 				}
 			}
 
-			if (row == suc_coord->row) {
-				element->y2 = suc_coord->y + data->row_height / 2;
+			if (col == suc_coord->col) {
+				element.x2 = suc_coord->x;
 			} else {
-				if (pre_coord->row <= suc_coord->row) {
-					element->y2 = data->job->height;
-				} else {
-					element->y2 = top;
-				}
+				element.x2 = data->width;
 			}
 
-			page = GET_PAGE (data, row, suc_coord->col);
-			page->elements = g_list_prepend (page->elements, element);
+			element.y1 = pre_coord->y;
+
+			gantt_print_add_element (elements, &element);
 		}
-	}
 
-	g_list_free (relations);
+		if (col != suc_coord->col) {
+			continue;
+		}
 
-	/* Third pass, add background shading for non-work intervals. */
-	for (row = 0; row < data->rows_of_pages; row++) {
-		t0 = mrp_time_align_day (data->start);
+		memset (&element, 0, sizeof (Element));
+		element.type = RELATION_VERT;
+		element.x1 = suc_coord->x;
 
 		if (row == 0) {
-			/* Top-most row has the header. */
-			y0 = data->header_height;
+			top = data->header_height;
 		} else {
-			y0 = 0;
+			top = 0;
 		}
 
-		for (col = 0; col < data->cols_of_pages; col++) {
-			mrptime ival_start, ival_end, ival_prev;
+		if (row == pre_coord->row) {
+			element.y1 = pre_coord->y;
+		} else {
+			if (pre_coord->row <= suc_coord->row) {
+				element.y1 = top;
+			} else {
+				element.y1 = data->height;
+			}
+		}
 
-			if (col == 0) {
-				/* Left-most col has the tree. */
-				x0 = data->tree_x2;
+		if (row == suc_coord->row) {
+			element.y2 = suc_coord->y + data->row_height / 2;
+		} else {
+			if (pre_coord->row <= suc_coord->row) {
+				element.y2 = data->height;
 			} else {
-				x0 = 0;
+				element.y2 = top;
 			}
+		}
 
-			t2 = t0 + (data->job->width - x0) * data->f;
+		gantt_print_add_element (elements, &element);
+	}
+}
 
-			/* Loop through the days between t0 and t2. */
-			t1 = mrp_time_align_day(t0);
+/* Lays out the contents of one page, the background in one array and the
+ * task bars, labels and relations in the other.
+ */
+static void
+gantt_print_layout_page (PlannerGanttPrintData *data,
+			 gint                   row,
+			 gint                   col,
+			 GArray                *background,
+			 GArray                *elements)
+{
+	PrintTask  *ptask;
+	PrintShade *shade;
+	Element     element;
+	gdouble     y0, y1, y2;
+	gint        first, last, index, i, r;
+
+	if (row == 0) {
+		/* Top-most row has the header. */
+		y0 = data->header_height;
+	} else {
+		y0 = 0;
+	}
 
-			while (t1 <= t2) {
-				gboolean done = FALSE;
+	if (data->timelines[col] >= 0) {
+		memset (&element, 0, sizeof (Element));
+		element.type = TIMELINE;
+		element.y1 = data->header_height;
+		element.y2 = data->height;
+		element.x1 = data->timelines[col];
+		element.x2 = element.x1;
 
-				day = mrp_calendar_get_day (calendar, t1, TRUE);
+		gantt_print_add_element (background, &element);
+	}
 
-				ivals = mrp_calendar_day_get_intervals (calendar, day, TRUE);
+	for (i = (gint) data->shades[col]->len - 1; i >= 0; i--) {
+		shade = &g_array_index (data->shades[col], PrintShade, i);
 
-				ival_prev = t1;
+		memset (&element, 0, sizeof (Element));
+		element.type = SHADE;
+		element.y1 = y0;
+		element.y2 = data->height;
+		element.x1 = shade->x1;
+		element.x2 = shade->x2;
 
-				/* Loop through the non-work intervals for this day */
-				while (!done)
-				{
-					/* The number of non-work intervals is one for each work interval and one
-					 * more for the remaining period after the last work interval */
-					if (ivals != NULL) {
-						mrp_interval_get_absolute (ivals->data,
-									   t1,
-									   &ival_start,
-									   &ival_end);
+		gantt_print_add_element (background, &element);
+	}
 
-						ivals = ivals->next;
-					} else {
-						ival_start = t1 + 60*60*24;
-						done = TRUE;
-					}
+	gantt_print_layout_relations (data, row, col, elements);
 
-					/* Only consider non-work intervals that are large enough and
-					 * lie (partially) within [t0...t2] */
-					if (ival_prev < t2 && ival_start > t0 &&
-					    planner_scale_conf[data->level].nonworking_limit <= ival_start - ival_prev) {
+	first = gantt_print_get_first_task (data, row);
+	last = MIN (data->n_tasks,
+		    first + (row == 0 ?
+			     data->tasks_per_page_with_header :
+			     data->tasks_per_page_without_header));
 
-						/* Only draw the part within [t0...t2] */
+	for (index = first; index < last; index++) {
+		ptask = &data->tasks[index];
 
-						element = g_new0 (Element, 1);
-						element->type = SHADE;
-						element->y1 = y0;
-						element->y2 = data->job->height;
+		gantt_print_get_task_row (data, index, &r, &y0, &i);
 
-						element->x1 = x0 + (MAX(t0, ival_prev) - t0) / data->f;
-						element->x2 = x0 + (MIN(t2, ival_start) - t0) / data->f;
+		y1 = y0 + data->row_height * (i + 0.25);
+		y2 = y1 + 0.5 * data->row_height;
 
-						page = GET_PAGE (data, row, col);
-						page->background_elements = g_list_prepend (page->background_elements, element);
+		if (gantt_print_get_task_element (data, ptask, col, y1, y2, &element)) {
+			gantt_print_add_element (elements, &element);
+		}
 
-					}
+		/* The allocated resources go after the end of the bar. */
+		if (ptask->resources &&
+		    ptask->finish_coord.valid &&
+		    ptask->finish_coord.col == col) {
+			memset (&element, 0, sizeof (Element));
+			element.type = RESOURCES;
 
-					ival_prev = ival_end;
-				}
-				/* Set t1 to the start of the next day */
-				t1 = ival_start;
-			}
+			element.x1 = ptask->finish_coord.x + data->x_pad;
+			element.y1 = y0 + data->row_height * (i + 0.75);
 
-			/* Print the current time. */
-			if (current_time >= t0 && current_time <= t2) {
-				element = g_new0 (Element, 1);
-				element->type = TIMELINE;
-				element->y1 = data->header_height;
-				element->y2 = data->job->height;
-				element->x1 = x0 + (current_time - t0) / data->f;
-				element->x2 = element->x1;
-				page = GET_PAGE (data, row, col);
-				page->background_elements = g_list_prepend (page->background_elements, element);
-			}
+			element.resources = ptask->resources;
 
-			t0 = t2;
+			gantt_print_add_element (elements, &element);
 		}
 	}
+}
 
-	return data;
+static void
+gantt_print_task (PrintPage *page, Element *element)
+{
+	PlannerGanttPrintData *data = page->data;
+	cairo_t               *cr = page->cr;
+
+	cairo_new_path (cr);
+	cairo_move_to (cr, element->x1, element->y1);
+	cairo_line_to (cr, element->x2, element->y1);
+	cairo_line_to (cr, element->x2, element->y2);
+	cairo_line_to (cr, element->x1, element->y2);
+	cairo_close_path (cr);
+
+	cairo_save (cr);
+
+	if (data->show_critical && element->is_critical) {
+		cairo_set_source_rgb (cr, 205/255.0, 92/255.0, 92/255.0);
+	} else {
+		cairo_set_source_rgb (cr, 235/255.0, 235/255.0, 235/255.0);
+	}
+
+	cairo_fill_preserve (cr);
+	cairo_set_line_width (cr, THIN_LINE_WIDTH);
+	cairo_set_source_rgb (cr, 0, 0, 0);
+	cairo_stroke (cr);
+
+	cairo_restore (cr);
+
+
+	/* Percent complete. */
+	if (element->x_complete > 0) {
+		gdouble pad;
+
+		pad = (element->y2 - element->y1) * 0.25;
+
+		cairo_save (cr);
+
+		cairo_new_path (cr);
+		cairo_move_to (cr, element->x1, element->y1 + pad);
+		cairo_line_to (cr, element->x_complete, element->y1 + pad);
+		cairo_line_to (cr, element->x_complete, element->y2 - pad);
+		cairo_line_to (cr, element->x1, element->y2 - pad);
+		cairo_close_path (cr);
+
+		cairo_set_source_rgb (cr, 135/255.0, 135/255.0, 135/255.0);
+		cairo_fill (cr);
+
+		cairo_restore (cr);
+	}
 }
 
 static void
-free_page (Page *page)
+gantt_print_summary_bar (PrintPage *page, Element *element)
 {
-	GList   *l;
-	Element *element;
+	PlannerGanttPrintData *data = page->data;
+	cairo_t               *cr = page->cr;
+
+	cairo_move_to (cr,
+		       element->x2,
+		       element->y1 + 2 * data->summary_thick);
+	cairo_line_to (cr,
+		       element->x1,
+		       element->y1 + 2 * data->summary_thick);
+	cairo_line_to (cr,
+		       element->x1,
+		       element->y1 + data->summary_thick);
+	cairo_line_to (cr,
+		       element->x2,
+		       element->y1 + data->summary_thick);
+	cairo_close_path (cr);
+	cairo_fill (cr);
+}
 
-	for (l = page->elements; l; l = l->next) {
-		element = l->data;
-		g_free (element->resources);
+static void
+gantt_print_summary_left (PrintPage *page, Element *element)
+{
+	PlannerGanttPrintData *data = page->data;
+	cairo_t               *cr = page->cr;
+
+	cairo_move_to (cr,
+		       element->x1,
+		       element->y1 + data->summary_thick);
+	cairo_line_to (cr,
+		       element->x1,
+		       element->y1 + data->summary_thick + data->summary_height);
+	cairo_line_to (cr,
+		       element->x1 + data->summary_slope,
+		       element->y1 + data->summary_thick);
+	cairo_close_path (cr);
+	cairo_fill (cr);
+}
+
+static void
+gantt_print_summary_right (PrintPage *page, Element *element)
+{
+	PlannerGanttPrintData *data = page->data;
+	cairo_t               *cr = page->cr;
+
+	cairo_move_to (cr,
+		       element->x2,
+		       element->y1 + data->summary_thick);
+	cairo_line_to (cr,
+		       element->x2,
+		       element->y1 + data->summary_thick + data->summary_height);
+	cairo_line_to (cr,
+		       element->x2 - data->summary_slope,
+		       element->y1 + data->summary_thick);
+	cairo_close_path (cr);
+	cairo_fill (cr);
+}
+
+/* Lays out and draws a page. This runs in the rendering threads and only
+ * uses the snapshot in @data.
+ */
+static void
+gantt_print_render_page (PlannerGanttPrintData *data,
+			 gint                   page_nr,
+			 cairo_t               *cr)
+{
+	PrintPage  page;
+	GArray    *background, *elements;
+	gdouble    x1, x2;
+	mrptime    t1, t2;
+	Element   *element;
+	gint       row, col;
+	guint      i;
+
+	col = page_nr % data->cols_of_pages;
+	row = page_nr / data->cols_of_pages;
+
+	page.data = data;
+	page.cr = cr;
+	page.font = data->font;
+
+	/* Use the thread's own font map, and points like the print context. */
+	page.layout = pango_cairo_create_layout (cr);
+	pango_cairo_context_set_resolution (pango_layout_get_context (page.layout), 72);
+	pango_layout_context_changed (page.layout);
+
+	x2 = data->width;
+
+	if (col == 0) {
+		x1 = data->tree_x2;
+		t1 = data->start;
+		t2 = data->second_column_start;
+
+		cairo_set_line_width (cr, THIN_LINE_WIDTH);
+
+		cairo_move_to (cr, data->tree_x2, 0);
+		cairo_line_to (cr, data->tree_x2, data->height);
+		cairo_stroke (cr);
+
+		cairo_move_to (cr, data->name_x2, 0);
+		cairo_line_to (cr, data->name_x2, data->height);
+		cairo_stroke (cr);
+
+		print_table_tasks (&page,
+				   row == 0,
+				   gantt_print_get_first_task (data, row));
+	} else {
+		x1 = 0;
+		t1 = data->second_column_start + (col - 1) * data->width * data->f;
+		t2 = t1 + data->width * data->f;
 	}
 
-	for (l = page->background_elements; l; l = l->next) {
-		element = l->data;
-		g_free (element->resources);
+	background = g_array_new (FALSE, FALSE, sizeof (Element));
+	elements = g_array_new (FALSE, FALSE, sizeof (Element));
+
+	gantt_print_layout_page (data, row, col, background, elements);
+
+	for (i = 0; i < background->len; i++) {
+		gdouble dashes[] = { 4, 4 };
+
+		element = &g_array_index (background, Element, i);
+
+		switch (element->type) {
+		case TIMELINE:
+			cairo_new_path (cr);
+			cairo_set_source_rgb (cr, 150/255.0, 150/255.0, 249/255.0);
+
+			cairo_set_dash (cr, dashes, 2, 0);
+
+			cairo_set_line_width (cr, 1);
+			cairo_move_to (cr, element->x1, element->y1);
+			cairo_line_to (cr, element->x1, element->y2);
+			cairo_stroke (cr);
+
+			cairo_set_dash (cr, NULL, 0, 0);
+
+			break;
+		case SHADE:
+			cairo_new_path (cr);
+			cairo_move_to (cr, element->x1, element->y1);
+			cairo_line_to (cr, element->x2, element->y1);
+			cairo_line_to (cr, element->x2, element->y2);
+			cairo_line_to (cr, element->x1, element->y2);
+			cairo_close_path (cr);
+
+			cairo_set_source_rgb (cr, 249/255.0, 249/255.0, 249/255.0);
+			cairo_fill (cr);
+
+			cairo_set_line_width (cr, THIN_LINE_WIDTH);
+			cairo_set_source_rgb (cr, 150/255.0, 150/255.0, 150/255.0);
+			cairo_move_to (cr, element->x1, element->y1);
+			cairo_line_to (cr, element->x1, element->y2);
+			cairo_stroke (cr);
+			break;
+		default:
+			break;
+		}
+	}
+
+	cairo_set_source_rgb (cr, 0, 0, 0);
+
+	if (row == 0) {
+		print_time_header (&page, x1, x2, t1, t2);
+		if (col == 0) {
+			print_table_header (&page);
+		}
+	}
+
+	for (i = 0; i < elements->len; i++) {
+		element = &g_array_index (elements, Element, i);
+
+		cairo_set_source_rgb (cr, 0, 0, 0);
+
+		switch (element->type) {
+		case TASK_LEFT:
+		case TASK_RIGHT:
+		case TASK_WHOLE:
+		case TASK_MIDDLE:
+			gantt_print_task (&page, element);
+			break;
+		case SUMMARY_LEFT:
+			gantt_print_summary_left (&page, element);
+			gantt_print_summary_bar (&page, element);
+			break;
+		case SUMMARY_RIGHT:
+			gantt_print_summary_right (&page, element);
+			gantt_print_summary_bar (&page, element);
+			break;
+		case SUMMARY_WHOLE:
+			gantt_print_summary_left (&page, element);
+			gantt_print_summary_right (&page, element);
+			gantt_print_summary_bar (&page, element);
+			break;
+		case SUMMARY_MIDDLE:
+			gantt_print_summary_bar (&page, element);
+			break;
+		case RELATION_ARROW_DOWN:
+			cairo_move_to (cr,
+				       element->x1,
+				       element->y1);
+			cairo_line_to (cr,
+				       element->x1 - data->arrow_width,
+				       element->y1 - data->arrow_height);
+			cairo_line_to (cr,
+				       element->x1 + data->arrow_width,
+				       element->y1 - data->arrow_height);
+			cairo_close_path (cr);
+			cairo_fill (cr);
+			break;
+		case RELATION_ARROW_UP:
+			cairo_move_to (cr,
+				       element->x1,
+				       element->y1);
+			cairo_line_to (cr,
+				       element->x1 - data->arrow_width,
+				       element->y1 + data->arrow_height);
+			cairo_line_to (cr,
+				       element->x1 + data->arrow_width,
+				       element->y1 + data->arrow_height);
+			cairo_close_path (cr);
+			cairo_fill (cr);
+			break;
+		case RELATION_HORIZ:
+			cairo_move_to (cr, element->x1, element->y1);
+			cairo_line_to (cr, element->x2, element->y1);
+			cairo_stroke (cr);
+			break;
+		case RELATION_VERT:
+			cairo_move_to (cr, element->x1, element->y1);
+			cairo_line_to (cr, element->x1, element->y2);
+			cairo_stroke (cr);
+			break;
+		case MILESTONE:
+			cairo_move_to (cr,
+				       element->x1,
+				       element->y1);
+			cairo_line_to (cr,
+				       element->x1 + data->milestone_size,
+				       element->y1 + data->milestone_size);
+			cairo_line_to (cr,
+				       element->x1,
+				       element->y1 + 2 * data->milestone_size);
+			cairo_line_to (cr,
+				       element->x1 - data->milestone_size,
+				       element->y1 + data->milestone_size);
+			cairo_close_path (cr);
+			cairo_fill (cr);
+			break;
+		case RESOURCES:
+			gantt_print_show_clipped (&page,
+						  element->x1,
+						  element->y1,
+						  element->resources,
+						  0, 0,
+						  data->width,
+						  data->height);
+			break;
+		default:
+			break;
+		}
+	}
+
+	g_array_free (background, TRUE);
+	g_array_free (elements, TRUE);
+
+	g_object_unref (page.layout);
+}
+
+static void
+gantt_print_render_func (gpointer page_data, gpointer user_data)
+{
+	PlannerGanttPrintData *data = user_data;
+	cairo_surface_t       *surface;
+	cairo_t               *cr;
+	gint                   page_nr;
+
+	page_nr = GPOINTER_TO_INT (page_data) - 1;
+
+	surface = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA, NULL);
+	cr = cairo_create (surface);
+
+	gantt_print_render_page (data, page_nr, cr);
+
+	cairo_destroy (cr);
+
+	g_mutex_lock (&data->mutex);
+	g_hash_table_insert (data->rendered, GINT_TO_POINTER (page_nr), surface);
+	g_cond_broadcast (&data->cond);
+	g_mutex_unlock (&data->mutex);
+}
+
+/* Returns the recorded page, after queueing it and the pages following it
+ * for rendering. Only a window of pages from @page_nr on is kept, so memory
+ * use doesn't grow with the size of the chart.
+ */
+static cairo_surface_t *
+gantt_print_get_page (PlannerGanttPrintData *data, gint page_nr)
+{
+	cairo_surface_t *surface;
+	GHashTableIter   iter;
+	gpointer         key;
+	gint             n_pages, n_threads;
+	gint             i, last;
+
+	n_pages = planner_gantt_print_get_n_pages (data);
+
+	if (!data->pool) {
+		n_threads = g_get_num_processors ();
+
+		data->render_ahead = n_threads * RENDER_AHEAD_PER_THREAD;
+		data->queued = g_new0 (gboolean, n_pages);
+		data->pool = g_thread_pool_new (gantt_print_render_func,
+						data,
+						n_threads,
+						FALSE,
+						NULL);
+	}
+
+	last = MIN (page_nr + data->render_ahead, n_pages);
+
+	g_mutex_lock (&data->mutex);
+
+	/* Drop pages we rendered but are not going to use soon, which can
+	 * happen when the preview jumps between pages.
+	 */
+	g_hash_table_iter_init (&iter, data->rendered);
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		i = GPOINTER_TO_INT (key);
+
+		if (i < page_nr || i >= last) {
+			data->queued[i] = FALSE;
+			g_hash_table_iter_remove (&iter);
+		}
+	}
+
+	for (i = page_nr; i < last; i++) {
+		if (!data->queued[i]) {
+			data->queued[i] = TRUE;
+			g_thread_pool_push (data->pool, GINT_TO_POINTER (i + 1), NULL);
+		}
+	}
+
+	while (!(surface = g_hash_table_lookup (data->rendered, GINT_TO_POINTER (page_nr)))) {
+		g_cond_wait (&data->cond, &data->mutex);
+	}
+
+	g_hash_table_steal (data->rendered, GINT_TO_POINTER (page_nr));
+	data->queued[page_nr] = FALSE;
+
+	g_mutex_unlock (&data->mutex);
+
+	return surface;
+}
+
+void
+planner_gantt_print_do (PlannerGanttPrintData *data, gint page_nr)
+{
+	cairo_surface_t *surface;
+	cairo_t         *cr;
+
+	surface = gantt_print_get_page (data, page_nr);
+
+	planner_print_job_begin_next_page (data->job);
+
+	cr = data->job->cr;
+
+	cairo_save (cr);
+	cairo_set_source_surface (cr, surface, 0, 0);
+	cairo_paint (cr);
+	cairo_restore (cr);
+
+	cairo_surface_destroy (surface);
+
+	planner_print_job_finish_page (data->job, TRUE);
+}
+
+static PlannerGanttPrintData *
+gantt_print_data_alloc (MrpProject *project,
+			gint        level,
+			gboolean    show_critical)
+{
+	PlannerGanttPrintData *data;
+
+	data = g_new0 (PlannerGanttPrintData, 1);
+
+	data->project = project;
+
+	data->show_critical = show_critical;
+	data->level = level;
+
+	/* Note: This looks hackish, but it's more or less the same equation
+	 * used for the zoom level in the gantt chart, which actually is
+	 * calculated to have a "good feel" :).
+	 */
+	data->f = 1.8 / pow (2, level - 19);
+
+	data->major_unit = planner_scale_conf[level].major_unit;
+	data->major_format = planner_scale_conf[level].major_format;
+
+	data->minor_unit = planner_scale_conf[level].minor_unit;
+	data->minor_format = planner_scale_conf[level].minor_format;
+
+	/* Start of the project. */
+	data->start = mrp_project_get_project_start (data->project);
+
+	data->pango_context = pango_font_map_create_context (pango_cairo_font_map_get_default ());
+	pango_cairo_context_set_resolution (data->pango_context, 72);
+
+	g_mutex_init (&data->mutex);
+	g_cond_init (&data->cond);
+	data->rendered = g_hash_table_new_full (NULL, NULL, NULL,
+						(GDestroyNotify) cairo_surface_destroy);
+
+	return data;
+}
+
+PlannerGanttPrintData *
+planner_gantt_print_data_new (PlannerView     *view,
+			      PlannerPrintJob *job,
+			      GtkTreeView     *tree_view,
+			      gint             level,
+			      gboolean         show_critical)
+{
+	PlannerGanttPrintData *data;
+
+	data = gantt_print_data_alloc (planner_window_get_project (view->main_window),
+				       level,
+				       show_critical);
+
+	data->view = view;
+	data->job = job;
+	data->tree_view = tree_view;
+
+	data->width = job->width;
+	data->height = job->height;
+	data->x_pad = job->x_pad;
+
+	data->font = pango_font_description_copy (planner_print_job_get_font (job));
+	data->font_bold = pango_font_description_copy (data->font);
+	pango_font_description_set_weight (data->font_bold, PANGO_WEIGHT_BOLD);
+	data->font_height = planner_print_job_get_font_height (job);
+
+	gantt_print_data_setup (data, gantt_print_get_visible_tasks (data));
+
+	return data;
+}
+
+/**
+ * planner_gantt_print_export:
+ * @project: an #MrpProject
+ * @filename: the file to write, a PDF file unless it ends in ".svg"
+ * @level: the zoom level of the chart
+ * @show_critical: whether to highlight the critical path
+ * @error: location to store an error, or %NULL
+ *
+ * Writes the gantt chart of all tasks to @filename without going through a
+ * print dialog. Pages are rendered in parallel and written in order.
+ *
+ * Return value: %TRUE on success.
+ **/
+gboolean
+planner_gantt_print_export (MrpProject   *project,
+			    const gchar  *filename,
+			    gint          level,
+			    gboolean      show_critical,
+			    GError      **error)
+{
+	PlannerGanttPrintData *data;
+	cairo_surface_t       *surface, *page;
+	cairo_status_t         status;
+	cairo_t               *cr;
+	gint                   n_pages, i;
+
+	g_return_val_if_fail (MRP_IS_PROJECT (project), FALSE);
+	g_return_val_if_fail (filename != NULL, FALSE);
+
+	if (g_str_has_suffix (filename, ".svg")) {
+		surface = cairo_svg_surface_create (filename,
+						    EXPORT_PAGE_WIDTH,
+						    EXPORT_PAGE_HEIGHT);
+		cairo_svg_surface_restrict_to_version (surface, CAIRO_SVG_VERSION_1_2);
+	} else {
+		surface = cairo_pdf_surface_create (filename,
+						    EXPORT_PAGE_WIDTH,
+						    EXPORT_PAGE_HEIGHT);
+	}
+
+	status = cairo_surface_status (surface);
+	if (status != CAIRO_STATUS_SUCCESS) {
+		g_set_error (error,
+			     G_FILE_ERROR,
+			     G_FILE_ERROR_FAILED,
+			     _("Could not write '%s': %s"),
+			     filename,
+			     cairo_status_to_string (status));
+		cairo_surface_destroy (surface);
+		return FALSE;
+	}
+
+	data = gantt_print_data_alloc (project, level, show_critical);
+
+	data->width = EXPORT_PAGE_WIDTH - 2 * EXPORT_PAGE_MARGIN;
+	data->height = EXPORT_PAGE_HEIGHT - 2 * EXPORT_PAGE_MARGIN;
+
+	data->font = pango_font_description_from_string ("Sans Regular 6");
+	data->font_bold = pango_font_description_from_string ("Sans Bold 6");
+	data->font_height = pango_font_description_get_size (data->font) / PANGO_SCALE;
+	data->x_pad = gantt_print_get_extents (data, "#") / 2;
+
+	gantt_print_data_setup (data, gantt_print_get_all_tasks (data));
+
+	cr = cairo_create (surface);
+
+	n_pages = planner_gantt_print_get_n_pages (data);
+	for (i = 0; i < n_pages; i++) {
+		page = gantt_print_get_page (data, i);
+
+		cairo_save (cr);
+		cairo_translate (cr, EXPORT_PAGE_MARGIN, EXPORT_PAGE_MARGIN);
+
+		cairo_set_source_surface (cr, page, 0, 0);
+		cairo_paint (cr);
+
+		cairo_set_source_rgb (cr, 0, 0, 0);
+		cairo_set_line_width (cr, THIN_LINE_WIDTH);
+		cairo_rectangle (cr, 0, 0, data->width, data->height);
+		cairo_stroke (cr);
+
+		cairo_restore (cr);
+
+		cairo_show_page (cr);
+
+		cairo_surface_destroy (page);
 	}
 
-	g_list_free (page->elements);
-	g_list_free (page->background_elements);
+	cairo_destroy (cr);
+
+	planner_gantt_print_data_free (data);
+
+	cairo_surface_finish (surface);
+	status = cairo_surface_status (surface);
+	cairo_surface_destroy (surface);
+
+	if (status != CAIRO_STATUS_SUCCESS) {
+		g_set_error (error,
+			     G_FILE_ERROR,
+			     G_FILE_ERROR_FAILED,
+			     _("Could not write '%s': %s"),
+			     filename,
+			     cairo_status_to_string (status));
+		return FALSE;
+	}
+
+	return TRUE;
 }
 
 void
 planner_gantt_print_data_free (PlannerGanttPrintData *data)
 {
-	gint i, num_pages;
+	gint i;
 
 	g_return_if_fail (data != NULL);
 
-	g_hash_table_destroy (data->task_start_coords);
-	g_hash_table_destroy (data->task_finish_coords);
+	/* Drop the pages nobody asked for yet and wait for the ones being
+	 * rendered.
+	 */
+	if (data->pool) {
+		g_thread_pool_free (data->pool, TRUE, TRUE);
+	}
+
+	g_hash_table_destroy (data->rendered);
+	g_mutex_clear (&data->mutex);
+	g_cond_clear (&data->cond);
+	g_free (data->queued);
+
+	for (i = 0; i < data->n_tasks; i++) {
+		g_free (data->tasks[i].name);
+		g_free (data->tasks[i].work);
+		g_free (data->tasks[i].resources);
+	}
 
-	gantt_print_free_print_tasks (data->tasks);
+	g_free (data->tasks);
 	data->tasks = NULL;
 
-	num_pages = data->cols_of_pages * data->rows_of_pages;
+	g_array_free (data->relations, TRUE);
 
-	for (i = 0; i < num_pages; i++) {
-		free_page (&data->pages[i]);
+	if (data->shades) {
+		for (i = 0; i < data->cols_of_pages; i++) {
+			g_array_free (data->shades[i], TRUE);
+		}
 	}
 
-	g_free (data->pages);
-	data->pages = NULL;
+	g_free (data->shades);
+	g_free (data->timelines);
+
+	pango_font_description_free (data->font);
+	pango_font_description_free (data->font_bold);
+	g_object_unref (data->pango_context);
 
 	g_free (data);
 }
@@ -23,6 +23,7 @@
 #pragma once
 
 #include <gtk/gtk.h>
+#include <libplanner/mrp-project.h>
 #include "planner-print-job.h"
 #include "planner-view.h"
 
@@ -41,3 +42,9 @@ PlannerGanttPrintData *  planner_gantt_print_data_new       (PlannerView
 						   gboolean          show_critical);
 
 void                planner_gantt_print_data_free      (PlannerGanttPrintData *data);
+
+gboolean            planner_gantt_print_export         (MrpProject       *project,
+							const gchar      *filename,
+							gint              level,
+							gboolean          show_critical,
+							GError          **error);
@@ -36,6 +36,7 @@
 #include "planner-gantt-row.h"
 #include "planner-gantt-chart.h"
 #include "planner-canvas-line.h"
+#include "planner-change-queue.h"
 #include "eel-canvas-rect.h"
 #include "dummy-canvas-item.h"
 #include "planner-scale-utils.h"
@@ -89,6 +90,24 @@ typedef enum {
 	STATE_DRAG_ANY = STATE_DRAG_LINK | STATE_DRAG_DURATION | STATE_DRAG_COMPLETE
 } State;
 
+/* The pieces a bar with assignments is drawn from, see
+ * gantt_row_build_slices().
+ */
+typedef enum {
+	SLICE_SHADOW_UP,
+	SLICE_SHADOW_DOWN,
+	SLICE_WORK_UP,
+	SLICE_WORK_DOWN,
+	SLICE_UNITS
+} SliceType;
+
+typedef struct {
+	SliceType type;
+	mrptime   start;
+	mrptime   end;
+	gdouble   delta; /* Fraction of the bar filled, for SLICE_UNITS. */
+} GanttSlice;
+
 typedef enum
 {
 	DRAG_NONE_SPOT,
@@ -117,6 +136,15 @@ struct _PlannerGanttRowPriv {
 	guint        visible    : 1;
 	guint        highlight  : 1;
 
+	/* A change that needs a redraw even if the bounds are the same is
+	 * waiting for the next frame.
+	 */
+	guint        redraw_pending : 1;
+
+	/* The cached slices and resource label are up to date. */
+	guint        slices_valid : 1;
+	guint        resources_valid : 1;
+
 	gdouble      scale;
 	gdouble      zoom;
 
@@ -143,6 +171,16 @@ struct _PlannerGanttRowPriv {
 
 	/* Cached positions of each assigned resource. */
 	GArray      *resource_widths;
+
+	/* Cached slices of the bar, in task time. They only depend on the
+	 * schedule, the calendar and the zoom level, not on the scroll
+	 * position, so they are rebuilt when one of those changes.
+	 */
+	GArray      *slices;
+	gint         slices_level;
+	gboolean     slices_nonstandard;
+	MrpCalendar *slices_calendar;
+	guint        slices_ivals_serial;
 };
 
 static void     gantt_row_class_init                  (PlannerGanttRowClass  *class);
@@ -198,6 +236,8 @@ static void     gantt_row_assignment_units_changed    (MrpAssignment         *as
 						       PlannerGanttRow       *row);
 static void     gantt_row_ensure_layout               (PlannerGanttRow       *row);
 static void     gantt_row_update_resources            (PlannerGanttRow       *row);
+static void     gantt_row_set_slices_calendar         (PlannerGanttRow       *row,
+						       MrpCalendar           *calendar);
 static void     gantt_row_geometry_changed            (PlannerGanttRow       *row);
 static void     gantt_row_connect_all_resources       (MrpTask               *task,
 						       PlannerGanttRow       *row);
@@ -213,12 +253,6 @@ static gboolean gantt_row_get_resource_by_index       (PlannerGanttRow       *ro
 						       gint                  *x1,
 						       gint                  *x2);
 
-static PlannerCmd *task_cmd_edit_property             (PlannerWindow   *window,
-					               PlannerTaskTree *tree,
-						       MrpTask         *task,
-						       const gchar     *property,
-						       const GValue    *value);
-
 static GList *  gantt_row_get_selected_tasks          (GtkTreeSelection      *selection);
 
 static MrpUnitsInterval * mop_get_next_ival           (GList                **cur,
@@ -400,6 +434,8 @@ gantt_row_init (PlannerGanttRow *row)
 	priv->highlight = FALSE;
 	priv->mouse_over_index = -1;
 	priv->resource_widths = g_array_new (TRUE, FALSE, sizeof (gint));
+	priv->slices = g_array_new (FALSE, FALSE, sizeof (GanttSlice));
+	priv->slices_level = -1;
 
 	gdk_rgba_parse (&priv->color_normal, "LightSkyBlue3");
 	gdk_rgba_parse (&priv->color_normal_light, "#9ac7e0");
@@ -428,6 +464,9 @@ gantt_row_dispose (GObject *object)
 
 		g_array_free (priv->resource_widths, FALSE);
 
+		gantt_row_set_slices_calendar (row, NULL);
+		g_array_free (priv->slices, TRUE);
+
 		g_free (priv);
 		row->priv = NULL;
 	}
@@ -686,8 +725,12 @@ gantt_row_ensure_layout (PlannerGanttRow *row)
 	if (row->priv->layout == NULL) {
 		row->priv->layout = gtk_widget_create_pango_layout (
 			GTK_WIDGET (GNOME_CANVAS_ITEM (row)->canvas), NULL);
+		row->priv->resources_valid = FALSE;
+	}
+
+	if (!row->priv->resources_valid) {
+		gantt_row_update_resources (row);
 	}
-	gantt_row_update_resources (row);
 }
 
 static void
@@ -700,9 +743,8 @@ gantt_row_update_resources (PlannerGanttRow *row)
 	MrpAssignment  *assignment;
 	MrpResource    *resource;
 	const gchar    *name;
-	gchar          *name_unit;
-	gchar          *tmp_str;
-	gchar          *text = NULL;
+	GString        *text;
+	gsize           name_start;
 	PangoRectangle  rect;
 	gint            spacing, x;
 	gint            units;
@@ -719,6 +761,7 @@ gantt_row_update_resources (PlannerGanttRow *row)
 	spacing = rect.width / PANGO_SCALE;
 
 	x = 0;
+	text = g_string_new (NULL);
 	resources = mrp_task_get_assigned_resources (priv->task);
 
 	for (l = resources; l; l = l->next) {
@@ -740,42 +783,33 @@ gantt_row_update_resources (PlannerGanttRow *row)
 
 		g_array_append_val (priv->resource_widths, x);
 
+		if (text->len > 0) {
+			g_string_append (text, ", ");
+		}
+
+		name_start = text->len;
+		g_string_append (text, name);
 		if (units != 100) {
-			name_unit = g_strdup_printf ("%s [%i]", name, units);
-		} else {
-			name_unit = g_strdup_printf ("%s", name);
+			g_string_append_printf (text, " [%i]", units);
 		}
 
-		pango_layout_set_text (priv->layout, name_unit, -1);
+		pango_layout_set_text (priv->layout,
+				       text->str + name_start,
+				       text->len - name_start);
 		pango_layout_get_extents (priv->layout, NULL, &rect);
 		x += rect.width / PANGO_SCALE;
 		g_array_append_val (priv->resource_widths, x);
 
 		x += spacing;
-
-		if (text == NULL) { /* First resource */
-			text = g_strdup_printf ("%s", name_unit);
-			g_free (name_unit);
-			continue;
-		}
-
-		tmp_str = g_strdup_printf ("%s, %s", text, name_unit);
-
-		g_free (text);
-		g_free (name_unit);
-
-		text = tmp_str;
 	}
 
 	g_list_free (resources);
 
-	if (text == NULL) {
-		pango_layout_set_text (priv->layout, "", 0);
-	} else {
-		pango_layout_set_text (priv->layout, text, -1);
-	}
+	pango_layout_set_text (priv->layout, text->str, text->len);
+
+	g_string_free (text, TRUE);
 
-	g_free (text);
+	priv->resources_valid = TRUE;
 }
 
 static void
@@ -1022,66 +1056,110 @@ static gboolean gantt_draw_tasktime(cairo_t *cr,
 }
 
 static void
-gantt_row_draw (GnomeCanvasItem *item,
-		cairo_t         *cr,
-		gint             x,
-		gint             y,
-		gint             width,
-		gint             height)
+gantt_row_add_slice (GArray    *slices,
+		     SliceType  type,
+		     mrptime    start,
+		     mrptime    end,
+		     gdouble    delta)
 {
-	PlannerGanttRow     *row;
-	PlannerGanttRowPriv *priv;
-	PlannerGanttChart   *chart;
-	gdouble              i2w_dx;
-	gdouble              i2w_dy;
-	gdouble              dx1, dy1, dx2, dy2, dshay1, dshay2;
-	gint                 level;
-	MrpTaskType          type;
-	gboolean             summary;
-	gint                 summary_y;
-	gint                 percent_complete;
-	gint                 complete_x2, complete_width;
-	gboolean             highlight_critical;
-	gboolean             display_nonstandard_days;
-	gboolean             critical;
-#ifdef WITH_SIMPLE_PRIORITY_SCHEDULING
-	gboolean             is_dominant;
-#endif
-	gint                 rx1;
-	gint                 rx2;
-	gint                 cx1, cy1, cx2, cy2;
+	GanttSlice slice;
+
+	slice.type = type;
+	slice.start = start;
+	slice.end = end;
+	slice.delta = delta;
 
+	g_array_append_val (slices, slice);
+}
+
+static void
+gantt_row_calendar_changed_cb (MrpCalendar     *calendar,
+			       PlannerGanttRow *row)
+{
+	row->priv->slices_valid = FALSE;
+	gnome_canvas_item_request_update (GNOME_CANVAS_ITEM (row));
+}
+
+static void
+gantt_row_set_slices_calendar (PlannerGanttRow *row,
+			       MrpCalendar     *calendar)
+{
+	PlannerGanttRowPriv *priv = row->priv;
+
+	if (priv->slices_calendar == calendar) {
+		return;
+	}
+
+	if (priv->slices_calendar) {
+		g_signal_handlers_disconnect_by_func (priv->slices_calendar,
+						      gantt_row_calendar_changed_cb,
+						      row);
+		g_object_remove_weak_pointer (G_OBJECT (priv->slices_calendar),
+					      (gpointer *) &priv->slices_calendar);
+	}
+
+	priv->slices_calendar = calendar;
+
+	if (calendar) {
+		g_object_add_weak_pointer (G_OBJECT (calendar),
+					   (gpointer *) &priv->slices_calendar);
+		g_signal_connect_object (calendar,
+					 "calendar-changed",
+					 G_CALLBACK (gantt_row_calendar_changed_cb),
+					 row,
+					 0);
+	}
+}
+
+/* Walks the unit intervals of the task together with the calendar intervals
+ * of each day and records the work and shadow slices of the bar, in task
+ * time so that they stay valid across scale changes.
+ */
+static void
+gantt_row_build_slices (PlannerGanttRow *row,
+			MrpCalendar     *calendar,
+			gint             level,
+			gboolean         display_nonstandard_days)
+{
+	PlannerGanttRowPriv *priv;
+	GArray              *slices;
 	GList               *unit_ivals, *cal_ivals, *cur_unit;
 	GList		    *cur_cal = NULL;
-	GdkRGBA              color;
-	gint                 x_start, x_end, y_dumb, is_a_gap, is_a_subgap;
+	gint                 is_a_gap, is_a_subgap;
 	MrpUnitsInterval    *unit_ival, ival_buf;
         MrpInterval         *ival_subbuf = NULL, *cal_ival = NULL;
 	gint                 i, day_cur, cur_start, cur_end;
-
-	MrpProject          *project;
 	MrpDay              *day;
-	MrpCalendar         *calendar;
 	mrptime              cal_start, cal_end;
 	gboolean             is_before_work;
 	gboolean             shadup_is_cached, shadup_draw_it;
 	gboolean             shaddo_is_cached, shaddo_draw_it;
 	gint                 shadup_start, shadup_end;
 	gint                 shaddo_start, shaddo_end;
-
 	gboolean             workup_is_cached, workup_draw_it;
 	gboolean             workdo_is_cached, workdo_draw_it;
 	gint                 workup_start, workup_end;
 	gint                 workdo_start, workdo_end;
-
 	gboolean             wunits_is_first, wunits_is_cached, wunits_draw_it;
-	gint                 wunits_x_start;
-
+	mrptime              wunits_start;
 	gint                 last_end;
-
-	gint                 topy,  nres, finish;
+	gint                 nres, finish;
 	gdouble              delta;
-	GList               *assignments;
+
+	priv = row->priv;
+	slices = priv->slices;
+
+	g_array_set_size (slices, 0);
+
+	priv->slices_valid = TRUE;
+	priv->slices_level = level;
+	priv->slices_nonstandard = display_nonstandard_days;
+	priv->slices_ivals_serial = mrp_task_get_unit_ivals_serial (priv->task);
+	gantt_row_set_slices_calendar (row, calendar);
+
+	if (!mrp_task_get_assignments (priv->task)) {
+		return;
+	}
 
 	shadup_start = -1;
 	shadup_end = -1;
@@ -1093,15 +1171,449 @@ gantt_row_draw (GnomeCanvasItem *item,
 	workdo_end = -1;
 	wunits_is_first = FALSE;
 	wunits_is_cached = FALSE;
-	wunits_x_start = -1;
+	wunits_start = -1;
 	last_end = 0;
 	delta = -1.0;
 	cur_start = 0;
 	cur_end = 0;
+	cal_start = 0;
+	cal_end = 0;
 	day_cur = 0;
 
 	cur_unit = (GList *)NULL;
-	cur_cal = (GList *)NULL;
+
+	finish = mrp_task_get_finish (priv->task);
+	nres = mrp_task_get_nres (priv->task);
+
+	unit_ivals = mrp_task_get_unit_ivals (priv->task);
+	ival_subbuf = mrp_interval_new (0,0);
+
+	is_before_work = TRUE;
+	shadup_is_cached = FALSE;
+	shaddo_is_cached = FALSE;
+	workup_is_cached = FALSE;
+	workdo_is_cached = FALSE;
+	for (i = 0, unit_ival = mop_get_next_ival (&cur_unit, &is_a_gap,
+						  unit_ivals, &ival_buf)
+		     ; unit_ival && (i == 0 || cur_start < finish) ; i++) {
+		if (i == 0) {
+			/* first iteration: read the day when start the task */
+			day_cur = mrp_time_align_day (unit_ival->start);
+
+			/* extract the intervals of the day */
+			day = mrp_calendar_get_day (calendar, day_cur, TRUE);
+			cal_ivals = mrp_calendar_day_get_intervals (calendar, day, TRUE);
+
+			if (cal_ivals == NULL) {
+				mrp_interval_set_absolute (ival_subbuf, 0, 0, (24*60*60));
+				is_a_subgap = 1;
+				cal_ival = ival_subbuf;
+			}
+			else {
+				for (cal_ival = mop_get_next_mrp_ival (&cur_cal, &is_a_subgap,
+								       cal_ivals, ival_subbuf) ;
+				     cal_ival ;
+				     cal_ival = mop_get_next_mrp_ival (&cur_cal, &is_a_subgap,
+								       NULL, ival_subbuf)) {
+					mrp_interval_get_absolute (cal_ival, day_cur, &cal_start, &cal_end);
+
+					if (cal_end > unit_ival->start) {
+						break;
+					}
+				}
+			}
+			cur_start = MAX (unit_ival->start, cal_start);
+			cur_end   = MIN (unit_ival->end  , cal_end  );
+			wunits_is_first = TRUE;
+		}
+		g_assert (cal_ival != NULL);
+
+		if (is_before_work) {
+			if (unit_ival->units_full == 0) {
+				goto cont_shadowloop;
+			}
+			else {
+				is_before_work = FALSE;
+			}
+
+		}
+		if (display_nonstandard_days) {
+			shadup_draw_it = FALSE;
+			shaddo_draw_it = FALSE;
+			workup_draw_it = FALSE;
+			workdo_draw_it = FALSE;
+
+			if (unit_ival->res_n == 0 && (!is_a_subgap ||
+						      (is_a_subgap && planner_scale_conf[level].nonworking_limit
+						       > cal_end - cal_start))) {
+				if (shadup_is_cached == FALSE) {
+					shadup_start = cur_start;
+					shadup_is_cached = TRUE;
+				}
+			}
+			else {
+				if (shadup_is_cached == TRUE) {
+					if (planner_scale_conf[level].nonworking_limit <=
+					    cur_start - shadup_start) {
+						shadup_end = cur_start;
+						shadup_draw_it = TRUE;
+					}
+					shadup_is_cached = FALSE;
+				}
+			}
+
+			if (unit_ival->res_n < nres && (!is_a_subgap ||
+							(is_a_subgap && planner_scale_conf[level].nonworking_limit
+							 > cal_end - cal_start))) {
+
+				if (shaddo_is_cached == FALSE) {
+					shaddo_start = cur_start;
+					shaddo_is_cached = TRUE;
+				}
+			}
+			else {
+				if (shaddo_is_cached == TRUE) {
+					if (planner_scale_conf[level].nonworking_limit <=
+					    cur_start - shaddo_start) {
+						shaddo_end = cur_start;
+						shaddo_draw_it = TRUE;
+					}
+					shaddo_is_cached = FALSE;
+				}
+			}
+
+			if ((unit_ival->res_n == nres && is_a_subgap) ||
+			    (unit_ival->res_n == 0 &&
+			     (cal_start % (24*60*60) == 0) && (cal_end % (24*60*60) == 0) &&
+			     planner_scale_conf[level].nonworking_limit > cur_end - cur_start)) {
+				if (workup_is_cached == FALSE) {
+					workup_start = cur_start;
+					workup_is_cached = TRUE;
+				}
+			}
+			else {
+				if (workup_is_cached == TRUE) {
+					if (planner_scale_conf[level].nonworking_limit <=
+					    cur_start - workup_start) {
+						workup_end = cur_start;
+						workup_draw_it = TRUE;
+					}
+					workup_is_cached = FALSE;
+				}
+			}
+
+			if ((unit_ival->res_n > 0 && is_a_subgap) ||
+			    (unit_ival->res_n == 0 &&
+			     (cal_start % (24*60*60) == 0) && (cal_end % (24*60*60) == 0) &&
+			     planner_scale_conf[level].nonworking_limit > cur_end - cur_start)) {
+
+				if (workdo_is_cached == FALSE) {
+					workdo_start = cur_start;
+					workdo_is_cached = TRUE;
+				}
+			}
+			else {
+				if (workdo_is_cached == TRUE) {
+					if (planner_scale_conf[level].nonworking_limit <=
+					    cur_start - workdo_start) {
+						workdo_end = cur_start;
+						workdo_draw_it = TRUE;
+					}
+					workdo_is_cached = FALSE;
+				}
+			}
+
+			/* Shadow up. */
+			if (shadup_draw_it ||
+			    (shadup_is_cached &&
+			     ((cur_end % (24*60*60)) == 0))) {
+				if (!shadup_draw_it && ((cur_end % (24*60*60)) == 0)) {
+					shadup_end = cur_end;
+				}
+				if (planner_scale_conf[level].nonworking_limit <=
+				    shadup_end - shadup_start) {
+					gantt_row_add_slice (slices, SLICE_SHADOW_UP,
+							     shadup_start, shadup_end, 0.0);
+				}
+				shadup_draw_it = FALSE;
+				shadup_is_cached = FALSE;
+			}
+
+			/* Shadow down. */
+			if (shaddo_draw_it ||
+			    (shaddo_is_cached &&
+			     ((cur_end % (24*60*60)) == 0))) {
+				if (!shaddo_draw_it && ((cur_end % (24*60*60)) == 0)) {
+					shaddo_end = cur_end;
+				}
+				if (planner_scale_conf[level].nonworking_limit <=
+				    shaddo_end - shaddo_start) {
+					gantt_row_add_slice (slices, SLICE_SHADOW_DOWN,
+							     shaddo_start, shaddo_end, 0.0);
+				}
+				shaddo_draw_it = FALSE;
+				shaddo_is_cached = FALSE;
+			}
+
+			/* Work up. */
+			if (workup_draw_it ||
+			    (workup_is_cached &&
+			     ((cur_end % (24*60*60)) == 0))) {
+				if (!workup_draw_it && ((cur_end % (24*60*60)) == 0)) {
+					workup_end = cur_end;
+				}
+				if (planner_scale_conf[level].nonworking_limit <=
+				    workup_end - workup_start) {
+					gantt_row_add_slice (slices, SLICE_WORK_UP,
+							     workup_start, workup_end, 0.0);
+				}
+				workup_draw_it = FALSE;
+				workup_is_cached = FALSE;
+			}
+
+			/* Work down. */
+			if (workdo_draw_it ||
+			    (workdo_is_cached &&
+			     ((cur_end % (24*60*60)) == 0))) {
+				if (!workdo_draw_it && ((cur_end % (24*60*60)) == 0)) {
+					workdo_end = cur_end;
+				}
+				if (planner_scale_conf[level].nonworking_limit <=
+				    workdo_end - workdo_start) {
+					gantt_row_add_slice (slices, SLICE_WORK_DOWN,
+							     workdo_start, workdo_end, 0.0);
+
+					workdo_draw_it = FALSE;
+					workdo_is_cached = FALSE;
+				}
+			}
+		}
+		/* Work units area. */
+		wunits_draw_it = TRUE;
+		if (unit_ival->res_n > 0 && unit_ival->units_full > 0) {
+			delta = (double)unit_ival->units / (double)unit_ival->units_full;
+		}
+		else {
+			if (unit_ival->res_n == 0) {  /* It is a nonworking interval. */
+				if (planner_scale_conf[level].nonworking_limit <=
+				    cur_end - cur_start) {
+					delta = 1.0;
+				}   /* else it use the last selected value */
+			}
+			/* It isn't a nonworking interval. */
+			else if (planner_scale_conf[level].nonworking_limit <=
+				 cur_end - cur_start) { /* Visible non working interval. */
+				delta = 1.0;
+			}
+			else {  /* use the last selected value */
+				if (wunits_is_first == TRUE) {
+					wunits_is_cached = TRUE;
+					wunits_start = cur_start;
+					wunits_draw_it = FALSE;
+				}
+			}
+		}
+
+		if (wunits_draw_it) {
+			if (wunits_is_cached) {
+				wunits_is_cached = FALSE;
+			}
+			else {
+				wunits_start = cur_start;
+			}
+
+			gantt_row_add_slice (slices, SLICE_UNITS,
+					     wunits_start, cur_end, delta);
+		}
+
+	cont_shadowloop:
+		if (display_nonstandard_days) {
+			last_end = cur_end;
+		}
+		wunits_is_first = FALSE;
+
+		if (cur_end == unit_ival->end) {
+			if ((unit_ival = mop_get_next_ival (&cur_unit, &is_a_gap,
+							    NULL, &ival_buf)) == NULL) {
+				break;
+			}
+		}
+		if (cur_end == cal_end) {
+			if ((cal_ival = mop_get_next_mrp_ival (&cur_cal, &is_a_subgap,
+							       NULL, ival_subbuf)) == NULL) {
+				/* End of the day intervals, read next. */
+				day_cur += (24*60*60);
+				day = mrp_calendar_get_day (calendar, day_cur, TRUE);
+				cal_ivals = mrp_calendar_day_get_intervals (calendar, day, TRUE);
+				if (cal_ivals) {
+					/* Not empty day. */
+					cal_ival = mop_get_next_mrp_ival (&cur_cal, &is_a_subgap,
+									  cal_ivals, ival_subbuf);
+				}
+				else {
+					/* Empty day. */
+					mrp_interval_set_absolute (ival_subbuf, 0, 0, (24*60*60));
+					is_a_subgap = 1;
+					cal_ival = ival_subbuf;
+				}
+				wunits_is_first = TRUE;
+			}
+			mrp_interval_get_absolute (cal_ival, day_cur, &cal_start, &cal_end);
+		}
+
+		cur_start = MAX (unit_ival->start, cal_start);
+		cur_end   = MIN (unit_ival->end  , cal_end  );
+	}
+
+	if (display_nonstandard_days) {
+		/*
+		  H O L Y D A Y S
+		*/
+		if (shadup_is_cached) {
+			gantt_row_add_slice (slices, SLICE_SHADOW_UP,
+					     shadup_start, last_end, 0.0);
+		}
+		if (shaddo_is_cached) {
+			gantt_row_add_slice (slices, SLICE_SHADOW_DOWN,
+					     shaddo_start, last_end, 0.0);
+		}
+
+		/*
+		  W O R K
+		*/
+		if (workup_is_cached) {
+			gantt_row_add_slice (slices, SLICE_WORK_UP,
+					     workup_start, last_end, 0.0);
+		}
+		if (workdo_is_cached) {
+			gantt_row_add_slice (slices, SLICE_WORK_DOWN,
+					     workdo_start, last_end, 0.0);
+		}
+	}
+
+	mrp_interval_unref (ival_subbuf);
+}
+
+/* Replays the cached slices, skipping the ones outside the exposed area. */
+static void
+gantt_row_draw_slices (PlannerGanttRow *row,
+		       cairo_t         *cr,
+		       gdouble          i2w_dx,
+		       gdouble          i2w_dy,
+		       gint             x,
+		       gint             y,
+		       gint             width,
+		       gint             cy1,
+		       gint             cy2,
+		       const GdkRGBA   *units_color)
+{
+	PlannerGanttRowPriv *priv = row->priv;
+	GnomeCanvas         *canvas = GNOME_CANVAS_ITEM (row)->canvas;
+	GanttSlice          *slice;
+	GdkRGBA              white;
+	gdouble              dshay1, dshay2;
+	gint                 x_start, x_end, y_dumb, topy;
+	guint                i;
+
+	gdk_rgba_parse (&white, "white");
+
+	dshay1 = priv->y + 0.08 * priv->height;
+	dshay2 = priv->y + 0.92 * priv->height;
+
+	for (i = 0; i < priv->slices->len; i++) {
+		slice = &g_array_index (priv->slices, GanttSlice, i);
+
+		gnome_canvas_w2c (canvas, (slice->start * priv->scale) + i2w_dx,
+				  i2w_dy, &x_start, &y_dumb);
+		gnome_canvas_w2c (canvas, (slice->end * priv->scale) + i2w_dx,
+				  i2w_dy, &x_end, &y_dumb);
+		x_start -= x;
+		x_end   -= x;
+
+		if (x_end < 0 || x_start > width) {
+			continue;
+		}
+
+		switch (slice->type) {
+		case SLICE_SHADOW_UP:
+		case SLICE_SHADOW_DOWN:
+		case SLICE_WORK_UP:
+		case SLICE_WORK_DOWN:
+			gantt_draw_tasktime (cr, canvas,
+					     (slice->start * priv->scale) + i2w_dx,
+					     dshay1 + i2w_dy,
+					     (slice->end * priv->scale) + i2w_dx,
+					     dshay2 + i2w_dy,
+					     cy1, cy2, x, y,
+					     slice->type == SLICE_SHADOW_UP ||
+					     slice->type == SLICE_WORK_UP,
+					     (slice->type == SLICE_SHADOW_UP ||
+					      slice->type == SLICE_SHADOW_DOWN) ?
+					     "grey96" : "white");
+			break;
+
+		case SLICE_UNITS:
+			topy = floor ((cy1 + ((1.0 - slice->delta) * (double)(cy2 - cy1 - 3))) + 0.5);
+
+			if ((cy2 - topy - 3) > 0) {
+				gdk_cairo_set_source_rgba (cr, units_color);
+				cairo_rectangle (cr,
+						 x_start,
+						 topy + 2,
+						 x_end - x_start,
+						 cy2 - topy - 3);
+				cairo_fill (cr);
+			}
+			if (topy - cy1 > 0) {
+				gdk_cairo_set_source_rgba (cr, &white);
+				cairo_rectangle (cr, x_start,
+						 cy1+2,
+						 x_end - x_start,
+						 topy - cy1);
+				cairo_fill (cr);
+			}
+			break;
+		}
+	}
+}
+
+static void
+gantt_row_draw (GnomeCanvasItem *item,
+		cairo_t         *cr,
+		gint             x,
+		gint             y,
+		gint             width,
+		gint             height)
+{
+	PlannerGanttRow     *row;
+	PlannerGanttRowPriv *priv;
+	PlannerGanttChart   *chart;
+	gdouble              i2w_dx;
+	gdouble              i2w_dy;
+	gdouble              dx1, dy1, dx2, dy2;
+	gint                 level;
+	MrpTaskType          type;
+	gboolean             summary;
+	gint                 summary_y;
+	gint                 percent_complete;
+	gint                 complete_x2, complete_width;
+	gboolean             highlight_critical;
+	gboolean             display_nonstandard_days;
+	gboolean             critical;
+#ifdef WITH_SIMPLE_PRIORITY_SCHEDULING
+	gboolean             is_dominant;
+#endif
+	gint                 rx1;
+	gint                 rx2;
+	gint                 cx1, cy1, cx2, cy2;
+
+	GdkRGBA              color;
+	MrpProject          *project;
+	MrpCalendar         *calendar;
+	GList               *assignments;
+#ifdef WITH_SIMPLE_PRIORITY_SCHEDULING
+	gint                 i;
+#endif
 
 	row = PLANNER_GANTT_ROW (item);
 	priv = row->priv;
@@ -1139,8 +1651,6 @@ gantt_row_draw (GnomeCanvasItem *item,
 
 	dx2 = MAX (dx2, dx1 + MIN_WIDTH);
 
-	dshay1 = priv->y + 0.08 * priv->height;
-	dshay2 = priv->y + 0.92 * priv->height;
 	gnome_canvas_w2c (item->canvas,
 			  dx1 + i2w_dx,
 			  dy1 + i2w_dy,
@@ -1180,8 +1690,6 @@ gantt_row_draw (GnomeCanvasItem *item,
 	percent_complete = mrp_task_get_percent_complete (priv->task);
 	critical = mrp_task_get_critical (priv->task);
 	type = mrp_task_get_task_type (priv->task);
-	finish = mrp_task_get_finish (priv->task);
-	nres = mrp_task_get_nres (priv->task);
 	assignments = mrp_task_get_assignments (priv->task);
 #ifdef WITH_SIMPLE_PRIORITY_SCHEDULING
 	is_dominant = mrp_task_is_dominant (priv->task);
@@ -1201,393 +1709,19 @@ gantt_row_draw (GnomeCanvasItem *item,
 			cairo_fill (cr);
 #endif
 
-			/* Start slices drawer */
-			unit_ivals = mrp_task_get_unit_ivals (priv->task);
-			ival_subbuf = mrp_interval_new (0,0);
-
-			is_before_work = TRUE;
-			shadup_is_cached = FALSE;
-			shaddo_is_cached = FALSE;
-			workup_is_cached = FALSE;
-			workdo_is_cached = FALSE;
-			for (i = 0, unit_ival = mop_get_next_ival (&cur_unit, &is_a_gap,
-								  unit_ivals, &ival_buf)
-					 ; unit_ival && (i == 0 || cur_start < finish) ; i++) {
-				if (i == 0) {
-					/* first iteration: read the day when start the task */
-					day_cur = mrp_time_align_day (unit_ival->start);
-
-					/* extract the intervals of the day */
-					day = mrp_calendar_get_day (calendar, day_cur, TRUE);
-					cal_ivals = mrp_calendar_day_get_intervals (calendar, day, TRUE);
-
-					if (cal_ivals == NULL) {
-						mrp_interval_set_absolute (ival_subbuf, 0, 0, (24*60*60));
-						is_a_subgap = 1;
-						cal_ival = ival_subbuf;
-					}
-					else {
-						for (cal_ival = mop_get_next_mrp_ival (&cur_cal, &is_a_subgap,
-										       cal_ivals, ival_subbuf) ;
-						   cal_ival ;
-						   cal_ival = mop_get_next_mrp_ival (&cur_cal, &is_a_subgap,
-											NULL, ival_subbuf)) {
-							mrp_interval_get_absolute (cal_ival, day_cur, &cal_start, &cal_end);
-
-							if (cal_end > unit_ival->start) {
-								break;
-							}
-						}
-					}
-					cur_start = MAX (unit_ival->start, cal_start);
-					cur_end   = MIN (unit_ival->end  , cal_end  );
-					wunits_is_first = TRUE;
-				}
-				g_assert (cal_ival != NULL);
-
-				gnome_canvas_w2c (item->canvas, (cur_start * priv->scale)
-								  + i2w_dx, i2w_dy, &x_start, &y_dumb);
-				gnome_canvas_w2c (item->canvas, (cur_end * priv->scale)
-								  + i2w_dx, i2w_dy, &x_end, &y_dumb);
-				x_start -= x;
-				x_end   -= x;
-
-				if (is_before_work) {
-					if (unit_ival->units_full == 0) {
-						goto cont_shadowloop;
-					}
-					else {
-						is_before_work = FALSE;
-					}
-
-				}
-				if (display_nonstandard_days) {
-					shadup_draw_it = FALSE;
-					shaddo_draw_it = FALSE;
-					workup_draw_it = FALSE;
-					workdo_draw_it = FALSE;
-
-					if (unit_ival->res_n == 0 && (!is_a_subgap ||
-								  (is_a_subgap && planner_scale_conf[level].nonworking_limit
-								   > cal_end - cal_start))) {
-						if (shadup_is_cached == FALSE) {
-							shadup_start = cur_start;
-							shadup_is_cached = TRUE;
-						}
-					}
-					else {
-						if (shadup_is_cached == TRUE) {
-							if (planner_scale_conf[level].nonworking_limit <=
-								cur_start - shadup_start) {
-								shadup_end = cur_start;
-								shadup_draw_it = TRUE;
-							}
-							shadup_is_cached = FALSE;
-						}
-					}
-
-					if (unit_ival->res_n < nres && (!is_a_subgap ||
-									(is_a_subgap && planner_scale_conf[level].nonworking_limit
-									 > cal_end - cal_start))) {
-
-						if (shaddo_is_cached == FALSE) {
-							shaddo_start = cur_start;
-							shaddo_is_cached = TRUE;
-						}
-					}
-					else {
-						if (shaddo_is_cached == TRUE) {
-							if (planner_scale_conf[level].nonworking_limit <=
-								cur_start - shaddo_start) {
-								shaddo_end = cur_start;
-								shaddo_draw_it = TRUE;
-							}
-							shaddo_is_cached = FALSE;
-						}
-					}
-
-					if ((unit_ival->res_n == nres && is_a_subgap) ||
-						(unit_ival->res_n == 0 &&
-						 (cal_start % (24*60*60) == 0) && (cal_end % (24*60*60) == 0) &&
-						 planner_scale_conf[level].nonworking_limit > cur_end - cur_start)) {
-						if (workup_is_cached == FALSE) {
-							workup_start = cur_start;
-							workup_is_cached = TRUE;
-						}
-					}
-					else {
-						if (workup_is_cached == TRUE) {
-							if (planner_scale_conf[level].nonworking_limit <=
-								cur_start - workup_start) {
-								workup_end = cur_start;
-								workup_draw_it = TRUE;
-							}
-							workup_is_cached = FALSE;
-						}
-					}
-
-					if ((unit_ival->res_n > 0 && is_a_subgap) ||
-						(unit_ival->res_n == 0 &&
-						 (cal_start % (24*60*60) == 0) && (cal_end % (24*60*60) == 0) &&
-						 planner_scale_conf[level].nonworking_limit > cur_end - cur_start)) {
-
-						if (workdo_is_cached == FALSE) {
-							workdo_start = cur_start;
-							workdo_is_cached = TRUE;
-						}
-					}
-					else {
-						if (workdo_is_cached == TRUE) {
-							if (planner_scale_conf[level].nonworking_limit <=
-								cur_start - workdo_start) {
-								workdo_end = cur_start;
-								workdo_draw_it = TRUE;
-							}
-							workdo_is_cached = FALSE;
-						}
-					}
-
-					/* Show shadow up. */
-					if (shadup_draw_it ||
-						(shadup_is_cached &&
-						 ((cur_end % (24*60*60)) == 0))) {
-						if (!shadup_draw_it && ((cur_end % (24*60*60)) == 0)) {
-							shadup_end = cur_end;
-						}
-						if (planner_scale_conf[level].nonworking_limit <=
-							shadup_end - shadup_start) {
-
-							gantt_draw_tasktime (cr, item->canvas,
-									     (shadup_start * priv->scale) + i2w_dx,
-									     dshay1 + i2w_dy,
-									     (shadup_end * priv->scale) + i2w_dx,
-									     dshay2 + i2w_dy,
-									     cy1, cy2, x, y,  TRUE, "grey96");
-						}
-						shadup_draw_it = FALSE;
-						shadup_is_cached = FALSE;
-					}
-
-					/* Show shadow down. */
-					if (shaddo_draw_it ||
-						(shaddo_is_cached &&
-						 ((cur_end % (24*60*60)) == 0))) {
-						if (!shaddo_draw_it && ((cur_end % (24*60*60)) == 0)) {
-							shaddo_end = cur_end;
-						}
-						if (planner_scale_conf[level].nonworking_limit <=
-							shaddo_end - shaddo_start) {
-
-							gantt_draw_tasktime (cr, item->canvas,
-									     (shaddo_start * priv->scale) + i2w_dx,
-									     dshay1 + i2w_dy,
-									     (shaddo_end * priv->scale) + i2w_dx,
-									     dshay2 + i2w_dy,
-									     cy1, cy2, x, y,  FALSE, "grey96");
-						}
-						shaddo_draw_it = FALSE;
-						shaddo_is_cached = FALSE;
-					}
-
-					/* Show work up. */
-					if (workup_draw_it ||
-						(workup_is_cached &&
-						 ((cur_end % (24*60*60)) == 0))) {
-						if (!workup_draw_it && ((cur_end % (24*60*60)) == 0)) {
-							workup_end = cur_end;
-						}
-						if (planner_scale_conf[level].nonworking_limit <=
-							workup_end - workup_start) {
-
-							gantt_draw_tasktime (cr, item->canvas,
-									     (workup_start * priv->scale) + i2w_dx,
-									     dshay1 + i2w_dy,
-									     (workup_end * priv->scale) + i2w_dx,
-									     dshay2 + i2w_dy,
-									     cy1, cy2, x, y,  TRUE, "white");
-						}
-						workup_draw_it = FALSE;
-						workup_is_cached = FALSE;
-					}
-
-					/* Show work down. */
-					if (workdo_draw_it ||
-						(workdo_is_cached &&
-						 ((cur_end % (24*60*60)) == 0))) {
-						if (!workdo_draw_it && ((cur_end % (24*60*60)) == 0)) {
-							workdo_end = cur_end;
-						}
-						if (planner_scale_conf[level].nonworking_limit <=
-							workdo_end - workdo_start) {
-
-							gantt_draw_tasktime (cr, item->canvas,
-									     (workdo_start * priv->scale) + i2w_dx,
-									     dshay1 + i2w_dy,
-									     (workdo_end * priv->scale) + i2w_dx,
-									     dshay2 + i2w_dy,
-									     cy1, cy2, x, y,  FALSE, "white");
-
-							workdo_draw_it = FALSE;
-							workdo_is_cached = FALSE;
-						}
-					}
-				}
-				/* Draw area. */
-				wunits_draw_it = TRUE;
-				if (unit_ival->res_n > 0 && unit_ival->units_full > 0) {
-					delta = (double)unit_ival->units / (double)unit_ival->units_full;
-				}
-				else {
-					if (unit_ival->res_n == 0) {  /* It is a nonworking interval. */
-						if (planner_scale_conf[level].nonworking_limit <=
-						    cur_end - cur_start) {
-							delta = 1.0;
-						}   /* else it use the last selected value */
-					}
-					/* It isn't a nonworking interval. */
-					else if (planner_scale_conf[level].nonworking_limit <=
-						cur_end - cur_start) { /* Visible non working interval. */
-						delta = 1.0;
-					}
-					else {  /* use the last selected value */
-						if (wunits_is_first == TRUE) {
-							wunits_is_cached = TRUE;
-							wunits_x_start = x_start;
-							wunits_draw_it = FALSE;
-						}
-					}
-				}
-
-				topy = floor ((cy1 + ((1.0 - (double)delta) * (double)(cy2 - cy1 - 3))) + 0.5);
-				if (!highlight_critical || !critical) {
-					gdk_cairo_set_source_rgba (cr, &priv->color_normal);
-				} else {
-					gdk_cairo_set_source_rgba (cr, &priv->color_critical);
-				}
-
-				if (wunits_draw_it) {
-					if (wunits_is_cached) {
-						wunits_is_cached = FALSE;
-					}
-					else {
-						wunits_x_start = x_start;
-					}
-
-					if ((cy2 - topy - 3) > 0) {
-						cairo_rectangle (cr,
-								 wunits_x_start,
-								 topy + 2,
-								 x_end - wunits_x_start,
-								 cy2 - topy - 3);
-						cairo_fill (cr);
-					}
-					if (topy  - cy1 > 0) {
-						gdk_rgba_parse (&color, "white");
-						gdk_cairo_set_source_rgba (cr, &color);
-						cairo_rectangle (cr, wunits_x_start,
-								 cy1+2,
-								 x_end - wunits_x_start,
-								 topy - cy1);
-						cairo_fill (cr);
-					}
-				}
-
-			cont_shadowloop:
-				if (display_nonstandard_days) {
-					last_end = cur_end;
-				}
-				wunits_is_first = FALSE;
-
-				if (cur_end == unit_ival->end) {
-					if ((unit_ival = mop_get_next_ival (&cur_unit, &is_a_gap,
-									    NULL, &ival_buf)) == NULL) {
-						break;
-					}
-				}
-				if (cur_end == cal_end) {
-					if ((cal_ival = mop_get_next_mrp_ival (&cur_cal, &is_a_subgap,
-									       NULL, ival_subbuf)) == NULL) {
-						/* End of the day intervals, read next. */
-						day_cur += (24*60*60);
-						day = mrp_calendar_get_day (calendar, day_cur, TRUE);
-						cal_ivals = mrp_calendar_day_get_intervals (calendar, day, TRUE);
-						if (cal_ivals) {
-							/* Not empty day. */
-							cal_ival = mop_get_next_mrp_ival (&cur_cal, &is_a_subgap,
-											  cal_ivals, ival_subbuf);
-						}
-						else {
-							/* Empty day. */
-							mrp_interval_set_absolute (ival_subbuf, 0, 0, (24*60*60));
-							is_a_subgap = 1;
-							cal_ival = ival_subbuf;
-						}
-						wunits_is_first = TRUE;
-					}
-					mrp_interval_get_absolute (cal_ival, day_cur, &cal_start, &cal_end);
-				}
-
-				cur_start = MAX (unit_ival->start, cal_start);
-				cur_end   = MIN (unit_ival->end  , cal_end  );
+			if (!priv->slices_valid ||
+			    priv->slices_level != level ||
+			    priv->slices_nonstandard != display_nonstandard_days ||
+			    priv->slices_calendar != calendar ||
+			    priv->slices_ivals_serial != mrp_task_get_unit_ivals_serial (priv->task)) {
+				gantt_row_build_slices (row, calendar, level,
+							display_nonstandard_days);
 			}
 
-			if (display_nonstandard_days) {
-				/*
-				  H O L Y D A Y S
-				*/
-
-				/* Show shad up. */
-				if (shadup_is_cached) {
-					shadup_end = last_end;
-
-					gantt_draw_tasktime (cr, item->canvas,
-							     (shadup_start * priv->scale) + i2w_dx,
-							     dshay1 + i2w_dy,
-							     (shadup_end * priv->scale) + i2w_dx,
-							     dshay2 + i2w_dy,
-							     cy1, cy2, x, y,  TRUE, "grey96");
-				}
-
-				/* Show shad down. */
-				if (shaddo_is_cached) {
-					shaddo_end = last_end;
-
-					gantt_draw_tasktime (cr, item->canvas,
-							     (shaddo_start * priv->scale) + i2w_dx,
-							     dshay1 + i2w_dy,
-							     (shaddo_end * priv->scale) + i2w_dx,
-							     dshay2 + i2w_dy,
-							     cy1, cy2, x, y,  FALSE, "grey96");
-				}
-
-				/*
-				  W O R K
-				*/
-
-				/* Show work up. */
-				if (workup_is_cached) {
-					workup_end = last_end;
-
-					gantt_draw_tasktime (cr, item->canvas,
-							     (workup_start * priv->scale) + i2w_dx,
-							     dshay1 + i2w_dy,
-							     (workup_end * priv->scale) + i2w_dx,
-							     dshay2 + i2w_dy,
-							     cy1, cy2, x, y,	 TRUE, "white");
-				}
-
-				/* Show work down. */
-				if (workdo_is_cached) {
-					workdo_end = last_end;
-
-					gantt_draw_tasktime (cr, item->canvas,
-							     (workdo_start * priv->scale) + i2w_dx,
-							     dshay1 + i2w_dy,
-							     (workdo_end * priv->scale) + i2w_dx,
-							     dshay2 + i2w_dy,
-							     cy1, cy2, x, y,  FALSE, "white");
-				}
-			}
+			gantt_row_draw_slices (row, cr, i2w_dx, i2w_dy,
+					       x, y, width, cy1, cy2,
+					       (!highlight_critical || !critical) ?
+					       &priv->color_normal : &priv->color_critical);
 		}
 		else { /* if (assignments) ... */
 			if (!highlight_critical || !critical) {
@@ -1604,10 +1738,6 @@ gantt_row_draw (GnomeCanvasItem *item,
 		}
 
 
-		if (ival_subbuf) {
-			mrp_interval_unref (ival_subbuf);
-		}
-
 		if (rx1 <= complete_x2) {
 			/* TODO: This and many other things code duplicated in planner-usage-row.c */
 			/* TODO: Improve design of completed percentage bar; perhaps add borders? */
@@ -1820,28 +1950,103 @@ gantt_row_bounds (GnomeCanvasItem *item,
 }
 
 static void
-gantt_row_notify_cb (MrpTask *task, GParamSpec *pspec, PlannerGanttRow *row)
+gantt_row_flush_changes (GPtrArray *rows, gpointer data)
 {
-	if (recalc_bounds (row)) {
-		gantt_row_geometry_changed (row);
+	PlannerGanttRow *row;
+	guint            i;
+
+	for (i = 0; i < rows->len; i++) {
+		row = g_ptr_array_index (rows, i);
+
+		/* Disposed since it was queued. */
+		if (!row->priv) {
+			continue;
+		}
+
+		if (recalc_bounds (row)) {
+			gantt_row_geometry_changed (row);
+		}
+		else if (!row->priv->redraw_pending) {
+			continue;
+		}
+
+		row->priv->redraw_pending = FALSE;
+		gnome_canvas_item_request_update (GNOME_CANVAS_ITEM (row));
+	}
+}
+
+/* All rows on a canvas share one queue, so a recalc that moves thousands of
+ * tasks results in one pass over the changed rows per frame.
+ */
+static PlannerChangeQueue *
+gantt_row_get_change_queue (PlannerGanttRow *row)
+{
+	GnomeCanvas        *canvas;
+	PlannerChangeQueue *queue;
+
+	canvas = GNOME_CANVAS_ITEM (row)->canvas;
+	if (!canvas) {
+		return NULL;
+	}
+
+	queue = g_object_get_data (G_OBJECT (canvas), "planner-gantt-row-changes");
+	if (!queue) {
+		queue = planner_change_queue_new (gantt_row_flush_changes, NULL);
+		planner_change_queue_set_widget (queue, GTK_WIDGET (canvas));
+
+		g_object_set_data_full (G_OBJECT (canvas),
+					"planner-gantt-row-changes",
+					queue,
+					(GDestroyNotify) planner_change_queue_free);
 	}
+
+	return queue;
+}
+
+static void
+gantt_row_notify_cb (MrpTask *task, GParamSpec *pspec, PlannerGanttRow *row)
+{
+	PlannerChangeQueue *queue;
+	GPtrArray          *rows;
+
 	/* Note: This is not really nice, it's bug-prone, but we can live with
 	 * it since it's a good optimization.
 	 */
-	else if (strcmp (pspec->name, "critical") != 0 &&
-		 strcmp (pspec->name, "sched") != 0 &&
-		 strcmp (pspec->name, "priority") != 0 &&
-		 strcmp (pspec->name, "percent-complete")) {
+	if (strcmp (pspec->name, "critical") == 0 ||
+	    strcmp (pspec->name, "sched") == 0 ||
+	    strcmp (pspec->name, "priority") == 0 ||
+	    strcmp (pspec->name, "percent-complete") == 0) {
+		row->priv->redraw_pending = TRUE;
+	}
+
+	/* The slices follow the unit intervals, which are only updated when
+	 * the task is rescheduled.
+	 */
+	if (strcmp (pspec->name, "sched") == 0 ||
+	    strcmp (pspec->name, "start") == 0 ||
+	    strcmp (pspec->name, "finish") == 0 ||
+	    strcmp (pspec->name, "duration") == 0 ||
+	    strcmp (pspec->name, "work") == 0) {
+		row->priv->slices_valid = FALSE;
+	}
+
+	queue = gantt_row_get_change_queue (row);
+	if (queue) {
+		planner_change_queue_add (queue, row);
 		return;
 	}
 
-	gnome_canvas_item_request_update (GNOME_CANVAS_ITEM (row));
+	rows = g_ptr_array_new ();
+	g_ptr_array_add (rows, row);
+	gantt_row_flush_changes (rows, NULL);
+	g_ptr_array_free (rows, TRUE);
 }
 
 static void
 gantt_row_update_assignment_string (PlannerGanttRow *row)
 {
-	gantt_row_update_resources (row);
+	row->priv->resources_valid = FALSE;
+	row->priv->slices_valid = FALSE;
 
 	recalc_bounds (row);
 	gnome_canvas_item_request_update (GNOME_CANVAS_ITEM (row));
@@ -1993,13 +2198,15 @@ gantt_row_geometry_changed (PlannerGanttRow *row)
 static void
 gantt_row_connect_all_resources (MrpTask *task, PlannerGanttRow *row)
 {
-	GList       *resources, *node;
-	MrpResource *resource;
+	GList         *resources, *node;
+	MrpResource   *resource;
+	MrpAssignment *assignment;
 
 	resources = mrp_task_get_assigned_resources (task);
 
 	for (node = resources; node; node = node->next) {
 		resource = MRP_RESOURCE (node->data);
+		assignment = mrp_task_get_assignment (task, resource);
 
 		g_signal_connect_object (resource, "notify::name",
 					 G_CALLBACK (gantt_row_resource_name_changed),
@@ -2009,6 +2216,10 @@ gantt_row_connect_all_resources (MrpTask *task, PlannerGanttRow *row)
 					 G_CALLBACK (gantt_row_resource_short_name_changed),
 					 row, 0);
 
+		/* The label shows the units, it's only rebuilt on changes. */
+		g_signal_connect_object (assignment, "notify::units",
+					 G_CALLBACK (gantt_row_assignment_units_changed),
+					 row, 0);
 	}
 
 	g_list_free (resources);
@@ -2017,13 +2228,15 @@ gantt_row_connect_all_resources (MrpTask *task, PlannerGanttRow *row)
 static void
 gantt_row_disconnect_all_resources (MrpTask *task, PlannerGanttRow *row)
 {
-	GList       *resources, *node;
-	MrpResource *resource;
+	GList         *resources, *node;
+	MrpResource   *resource;
+	MrpAssignment *assignment;
 
 	resources = mrp_task_get_assigned_resources (task);
 
 	for (node = resources; node; node = node->next) {
 		resource = MRP_RESOURCE (node->data);
+		assignment = mrp_task_get_assignment (task, resource);
 
 		g_signal_handlers_disconnect_by_func (resource,
 						      gantt_row_resource_name_changed,
@@ -2032,6 +2245,10 @@ gantt_row_disconnect_all_resources (MrpTask *task, PlannerGanttRow *row)
 		g_signal_handlers_disconnect_by_func (resource,
 						      gantt_row_resource_short_name_changed,
 						      row);
+
+		g_signal_handlers_disconnect_by_func (assignment,
+						      gantt_row_assignment_units_changed,
+						      row);
 	}
 
 	g_list_free (resources);
@@ -2656,11 +2873,11 @@ gantt_row_event (GnomeCanvasItem *item, GdkEvent *event)
 			g_value_init (&value, G_TYPE_INT);
 			g_value_set_int (&value, work);
 
-			task_cmd_edit_property (planner_task_tree_get_window (tree),
-						tree,
-						priv->task,
-						"work",
-						&value);
+			planner_task_cmd_edit_property (planner_task_tree_get_window (tree),
+							tree,
+							priv->task,
+							"work",
+							&value);
 
 			if (priv->scroll_timeout_id) {
 				g_source_remove (priv->scroll_timeout_id);
@@ -2688,11 +2905,11 @@ gantt_row_event (GnomeCanvasItem *item, GdkEvent *event)
 			g_value_init (&value, G_TYPE_INT);
 			g_value_set_int (&value, percent_complete);
 
-			task_cmd_edit_property (planner_task_tree_get_window (tree),
-						tree,
-						priv->task,
-						"percent_complete",
-						&value);
+			planner_task_cmd_edit_property (planner_task_tree_get_window (tree),
+							tree,
+							priv->task,
+							"percent_complete",
+							&value);
 
 			if (priv->scroll_timeout_id) {
 				g_source_remove (priv->scroll_timeout_id);
@@ -3117,121 +3334,6 @@ gantt_row_get_resource_by_index (PlannerGanttRow *row,
 #endif
 
 
-/* This should be ina shared file ideally, but there are some linking
- * problems.
- */
-
-typedef struct {
-	PlannerCmd         base;
-
-	PlannerTaskTree   *tree;
-	MrpProject        *project;
-
-	GtkTreePath       *path;
-
-	gchar             *property;
-	GValue            *value;
-	GValue            *old_value;
-} TaskCmdEditProperty;
-
-static gboolean
-task_cmd_edit_property_do (PlannerCmd *cmd_base)
-{
-	TaskCmdEditProperty *cmd;
-	PlannerGanttModel   *model;
-	MrpTask             *task;
-
-	cmd = (TaskCmdEditProperty*) cmd_base;
-
-	model = PLANNER_GANTT_MODEL (gtk_tree_view_get_model (GTK_TREE_VIEW (cmd->tree)));
-	task = planner_gantt_model_get_task_from_path (model, cmd->path);
-
-	g_object_set_property (G_OBJECT (task),
-			       cmd->property,
-			       cmd->value);
-
-	return TRUE;
-}
-
-static void
-task_cmd_edit_property_undo (PlannerCmd *cmd_base)
-{
-	TaskCmdEditProperty *cmd;
-	PlannerGanttModel   *model;
-	MrpTask             *task;
-
-	cmd = (TaskCmdEditProperty*) cmd_base;
-
-	model = PLANNER_GANTT_MODEL (gtk_tree_view_get_model (GTK_TREE_VIEW (cmd->tree)));
-	task = planner_gantt_model_get_task_from_path (model, cmd->path);
-
-	g_object_set_property (G_OBJECT (task),
-			       cmd->property,
-			       cmd->old_value);
-}
-
-static void
-task_cmd_edit_property_free (PlannerCmd *cmd_base)
-{
-	TaskCmdEditProperty *cmd;
-
-	cmd = (TaskCmdEditProperty*) cmd_base;
-
-	g_object_unref (cmd->project);
-
-	g_free (cmd->property);
-	g_value_unset (cmd->value);
-	g_value_unset (cmd->old_value);
-
-	g_free (cmd->value);
-	g_free (cmd->old_value);
-}
-
-static PlannerCmd *
-task_cmd_edit_property (PlannerWindow   *window,
-			PlannerTaskTree *tree,
-			MrpTask         *task,
-			const gchar     *property,
-			const GValue    *value)
-{
-	PlannerCmd          *cmd_base;
-	TaskCmdEditProperty *cmd;
-	PlannerGanttModel   *model;
-
-	cmd_base = planner_cmd_new (TaskCmdEditProperty,
-				    _("Edit task property"),
-				    task_cmd_edit_property_do,
-				    task_cmd_edit_property_undo,
-				    task_cmd_edit_property_free);
-
-	cmd = (TaskCmdEditProperty *) cmd_base;
-
-	cmd->tree = tree;
-	cmd->project = g_object_ref (planner_window_get_project (window));
-
-	model = PLANNER_GANTT_MODEL (gtk_tree_view_get_model (GTK_TREE_VIEW (tree)));
-
-	cmd->path = planner_gantt_model_get_path_from_task (model, task);
-
-	cmd->property = g_strdup (property);
-
-	cmd->value = g_new0 (GValue, 1);
-	g_value_init (cmd->value, G_VALUE_TYPE (value));
-	g_value_copy (value, cmd->value);
-
-	cmd->old_value = g_new0 (GValue, 1);
-	g_value_init (cmd->old_value, G_VALUE_TYPE (value));
-
-	g_object_get_property (G_OBJECT (task),
-			       cmd->property,
-			       cmd->old_value);
-
-	planner_cmd_manager_insert_and_do (planner_window_get_cmd_manager (window),
-					   cmd_base);
-
-	return cmd_base;
-}
-
 static  void
 gantt_row_get_selected_func (GtkTreeModel *model,
 			     GtkTreePath  *path,
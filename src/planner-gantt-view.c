@@ -34,6 +34,7 @@
 #include "planner-resource-dialog.h"
 #include "planner-gantt-model.h"
 #include "planner-task-tree.h"
+#include "planner-task-cmd.h"
 #include "planner-gantt-chart.h"
 #include "planner-gantt-print.h"
 #include "planner-column-dialog.h"
@@ -77,6 +78,8 @@ static void          gantt_view_move_task_down_cb         (GtkAction         *ac
 							   gpointer           data);
 static void          gantt_view_reset_constraint_cb       (GtkAction         *action,
 							   gpointer           data);
+static void          gantt_view_level_resources_cb        (GtkAction         *action,
+							   gpointer           data);
 static void          gantt_view_zoom_to_fit_cb            (GtkAction         *action,
 							   gpointer           data);
 static void          gantt_view_zoom_in_cb                (GtkAction         *action,
@@ -170,6 +173,9 @@ static const GtkActionEntry entries[] = {
 	{ "ResetConstraint", NULL,                           N_("Reset _Constraint"),
 	  NULL,                NULL,
 	  G_CALLBACK (gantt_view_reset_constraint_cb) },
+	{ "LevelResources",  NULL,                           N_("_Level Resources"),
+	  NULL,                N_("Delay tasks so that no resource is overallocated"),
+	  G_CALLBACK (gantt_view_level_resources_cb) },
 	{ "ZoomToFit",       GTK_STOCK_ZOOM_FIT,             N_("Zoom To _Fit"),
 	  NULL,                N_("Zoom to fit the entire project"),
 	  G_CALLBACK (gantt_view_zoom_to_fit_cb) },
@@ -608,6 +614,9 @@ gantt_view_create_widget (PlannerGanttView *view)
 				       * xgettext:no-c-format
 				       */
 				      COL_COMPLETE, _("% Complete"),
+				      COL_ACTUAL_COST, _("Actual Cost"),
+				      COL_PLANNED_VALUE, _("Planned Value"),
+				      COL_EARNED_VALUE, _("Earned Value"),
 				      -1);
 
 	priv->tree = tree;
@@ -843,6 +852,20 @@ gantt_view_reset_constraint_cb (GtkAction *action,
 	planner_task_tree_reset_constraint (PLANNER_TASK_TREE (view->priv->tree));
 }
 
+static void
+gantt_view_level_resources_cb (GtkAction *action,
+			       gpointer   data)
+{
+	PlannerGanttView *view;
+
+	view = PLANNER_GANTT_VIEW (data);
+
+	if (!planner_task_cmd_level_resources (PLANNER_VIEW (view)->main_window)) {
+		planner_window_set_status (PLANNER_VIEW (view)->main_window,
+					   _("No resource is overallocated."));
+	}
+}
+
 static void
 gantt_view_zoom_to_fit_cb (GtkAction *action,
 			   gpointer   data)
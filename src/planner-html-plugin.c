@@ -63,20 +63,37 @@ html_plugin_show_url (PlannerPlugin *plugin, const char *path)
 static void
 html_plugin_export_do (PlannerPlugin *plugin,
 		       const gchar   *path,
+		       gboolean       tables_only,
 		       gboolean       show_in_browser)
 {
 	MrpProject        *project;
 	GtkWidget         *dialog;
+	const gchar       *identifier;
+	GError            *error = NULL;
 
 	project = planner_window_get_project (plugin->main_window);
 
-	if (!mrp_project_export (project, path, "Planner HTML", TRUE, NULL)) {
+	/* The native writer only does the tables of the report, but is a
+	 * lot faster on large projects.
+	 */
+	if (tables_only) {
+		identifier = "Planner HTML Native";
+	} else {
+		identifier = "Planner HTML";
+	}
+
+	if (!mrp_project_export (project, path, identifier, TRUE, &error)) {
 		dialog = gtk_message_dialog_new (GTK_WINDOW (plugin->main_window),
 						 GTK_DIALOG_MODAL |
 						 GTK_DIALOG_DESTROY_WITH_PARENT,
 						 GTK_MESSAGE_ERROR,
 						 GTK_BUTTONS_OK,
 						 _("Could not export to HTML"));
+		if (error) {
+			gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (dialog),
+								  "%s", error->message);
+			g_error_free (error);
+		}
 		gtk_dialog_run (GTK_DIALOG (dialog));
 		gtk_widget_destroy (dialog);
 	}
@@ -97,8 +114,11 @@ html_plugin_export (GtkAction *action,
 	gint               res;
 	GtkWidget         *filechooser;
 	GtkWidget         *dialog;
+	GtkWidget         *vbox;
 	GtkWidget         *show_button;
+	GtkWidget         *tables_button;
 	gboolean           show;
+	gboolean           tables_only;
 
 	plugin = PLANNER_PLUGIN (user_data);
 
@@ -146,8 +166,16 @@ html_plugin_export (GtkAction *action,
 
 	gtk_file_chooser_set_current_name (GTK_FILE_CHOOSER (filechooser), basename);
 
+	vbox = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+
 	show_button = gtk_check_button_new_with_label (_("Show result in browser"));
-	gtk_file_chooser_set_extra_widget (GTK_FILE_CHOOSER (filechooser), show_button);
+	gtk_box_pack_start (GTK_BOX (vbox), show_button, FALSE, FALSE, 0);
+
+	tables_button = gtk_check_button_new_with_label (_("Only the task and resource tables"));
+	gtk_box_pack_start (GTK_BOX (vbox), tables_button, FALSE, FALSE, 0);
+
+	gtk_widget_show_all (vbox);
+	gtk_file_chooser_set_extra_widget (GTK_FILE_CHOOSER (filechooser), vbox);
 
 	g_free (basename);
 	g_free (filename);
@@ -186,9 +214,10 @@ html_plugin_export (GtkAction *action,
 		}
 
 		show = gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (show_button));
+		tables_only = gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (tables_button));
 		gtk_widget_destroy (filechooser);
 
-		html_plugin_export_do (plugin, filename, show);
+		html_plugin_export_do (plugin, filename, tables_only, show);
 		g_free (filename);
 
 		break;
@@ -29,19 +29,32 @@
 #include <glib/gstdio.h>
 #include <errno.h>
 #include "libplanner/mrp-paths.h"
+#include "libplanner/mrp-application.h"
+#include "libplanner/mrp-project.h"
 #include "planner-application.h"
 #include "planner-window.h"
+#include "planner-gantt-print.h"
+
+/* Zoom level used when exporting from the command line. */
+#define EXPORT_ZOOM_LEVEL 7
 
 static gboolean migrate_config_to_xdg_dir (void);
+static gchar   *main_get_uri              (const gchar *arg);
+static gint     main_export_gantt         (void);
+static gint     main_usage_report         (void);
 
 static PlannerApplication *application;
 
 /* Command line options */
 static gchar *geometry = NULL;
 static gchar **args_remaining = NULL;
+static gchar *export_gantt = NULL;
+static gchar *usage_report = NULL;
 
 static GOptionEntry options[] = {
 		{ "geometry", 'g', 0, G_OPTION_ARG_STRING, &geometry, N_("Create the initial window with the given geometry."), N_("GEOMETRY")},
+		{ "export-gantt", 0, 0, G_OPTION_ARG_FILENAME, &export_gantt, N_("Write the gantt chart of the project to a PDF or SVG file and exit."), N_("FILE")},
+		{ "usage-report", 0, 0, G_OPTION_ARG_STRING, &usage_report, N_("Print the work and cost of each resource per day, week or month and exit."), N_("day|week|month")},
 		{ G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &args_remaining, NULL, N_("FILES|URIs") },
 		{ NULL }
 	};
@@ -76,12 +89,30 @@ main (int argc, char **argv)
 	                         options,
 	                         GETTEXT_PACKAGE,
 	                         &error)) {
-		g_printerr (_("%s\nRun '%s --help' to see a full list of available command line options.\n"),
-		            error->message, argv[0]);
-		g_error_free (error);
+		/* Exporting doesn't need a display. */
+		if (!error && export_gantt) {
+			return main_export_gantt ();
+		}
+		if (!error && usage_report) {
+			return main_usage_report ();
+		}
+
+		if (error) {
+			g_printerr (_("%s\nRun '%s --help' to see a full list of available command line options.\n"),
+			            error->message, argv[0]);
+			g_error_free (error);
+		}
 		return 1;
 	}
 
+	if (export_gantt) {
+		return main_export_gantt ();
+	}
+
+	if (usage_report) {
+		return main_usage_report ();
+	}
+
 	/* Migrate configuration if necessary */
 	migrate_config_to_xdg_dir ();
 	migrate_gconf_settings ();
@@ -110,36 +141,18 @@ main (int argc, char **argv)
 
 	if (args_remaining != NULL) {
 		for (i = 0; args_remaining[i]; i++) {
-			gchar *scheme = g_uri_parse_scheme(args_remaining[i]);
-			if (scheme != NULL) {
+			gchar *uri = main_get_uri (args_remaining[i]);
+
+			if (uri) {
 				planner_window_open_in_existing_or_new (
-					PLANNER_WINDOW (main_window), args_remaining[i], FALSE);
-				g_free(scheme);
-			} else {
-				gchar *uri;
-
-				if (!g_path_is_absolute (args_remaining[i])) {
-					/* Relative path. */
-					gchar *cwd, *tmp;
-
-					cwd = g_get_current_dir ();
-					tmp = g_build_filename (cwd, args_remaining[i], NULL);
-					uri = g_filename_to_uri (tmp, NULL, NULL);
-					g_free (tmp);
-					g_free (cwd);
-				} else {
-					uri = g_filename_to_uri (args_remaining[i], NULL, NULL);
-				}
-
-				if (uri) {
-					planner_window_open_in_existing_or_new (
-						PLANNER_WINDOW (main_window), uri, FALSE);
-					g_free (uri);
-				}
+					PLANNER_WINDOW (main_window), uri, FALSE);
+				g_free (uri);
 			}
 		}
 	}
 
+	planner_window_recover_journals (PLANNER_WINDOW (main_window));
+
         gtk_main ();
 
 	g_object_unref (application);
@@ -147,6 +160,173 @@ main (int argc, char **argv)
         return 0;
 }
 
+static gchar *
+main_get_uri (const gchar *arg)
+{
+	gchar *scheme;
+	gchar *uri;
+
+	scheme = g_uri_parse_scheme (arg);
+	if (scheme != NULL) {
+		g_free (scheme);
+		return g_strdup (arg);
+	}
+
+	if (!g_path_is_absolute (arg)) {
+		/* Relative path. */
+		gchar *cwd, *tmp;
+
+		cwd = g_get_current_dir ();
+		tmp = g_build_filename (cwd, arg, NULL);
+		uri = g_filename_to_uri (tmp, NULL, NULL);
+		g_free (tmp);
+		g_free (cwd);
+	} else {
+		uri = g_filename_to_uri (arg, NULL, NULL);
+	}
+
+	return uri;
+}
+
+/* Loads the project given on the command line, for the options that work
+ * on a project without opening a window.
+ */
+static MrpProject *
+main_load_project (MrpApplication *app)
+{
+	MrpProject *project;
+	GError     *error = NULL;
+	gchar      *uri;
+
+	if (args_remaining == NULL || args_remaining[0] == NULL) {
+		g_printerr (_("No project given to export.\n"));
+		return NULL;
+	}
+
+	uri = main_get_uri (args_remaining[0]);
+	if (!uri) {
+		g_printerr (_("Invalid project location \"%s\".\n"), args_remaining[0]);
+		return NULL;
+	}
+
+	project = mrp_project_new (app);
+
+	if (!mrp_project_load (project, uri, &error)) {
+		if (error) {
+			g_printerr ("%s\n", error->message);
+			g_error_free (error);
+		} else {
+			g_printerr (_("Could not open \"%s\".\n"), args_remaining[0]);
+		}
+		g_object_unref (project);
+		project = NULL;
+	}
+
+	g_free (uri);
+
+	return project;
+}
+
+static gint
+main_export_gantt (void)
+{
+	MrpApplication *app;
+	MrpProject     *project;
+	GError         *error = NULL;
+	gint            ret = 1;
+
+	app = mrp_application_new ();
+
+	project = main_load_project (app);
+	if (!project) {
+		g_object_unref (app);
+		return 1;
+	}
+
+	if (!planner_gantt_print_export (project, export_gantt,
+					 EXPORT_ZOOM_LEVEL, FALSE, &error)) {
+		if (error) {
+			g_printerr ("%s\n", error->message);
+			g_error_free (error);
+		} else {
+			g_printerr (_("Could not export to \"%s\".\n"), export_gantt);
+		}
+	} else {
+		ret = 0;
+	}
+
+	g_object_unref (project);
+	g_object_unref (app);
+
+	return ret;
+}
+
+static gint
+main_usage_report (void)
+{
+	MrpApplication     *app;
+	MrpProject         *project;
+	MrpTimeUnit         unit;
+	GArray             *buckets;
+	MrpTimephaseBucket *bucket;
+	GList              *l;
+	mrptime             start, finish;
+	gchar              *date;
+	guint               i;
+
+	if (strcmp (usage_report, "day") == 0) {
+		unit = MRP_TIME_UNIT_DAY;
+	}
+	else if (strcmp (usage_report, "week") == 0) {
+		unit = MRP_TIME_UNIT_WEEK;
+	}
+	else if (strcmp (usage_report, "month") == 0) {
+		unit = MRP_TIME_UNIT_MONTH;
+	} else {
+		g_printerr (_("Invalid report period \"%s\", use day, week or month.\n"),
+			    usage_report);
+		return 1;
+	}
+
+	app = mrp_application_new ();
+
+	project = main_load_project (app);
+	if (!project) {
+		g_object_unref (app);
+		return 1;
+	}
+
+	start = mrp_project_get_project_start (project);
+	finish = mrp_task_get_finish (mrp_project_get_root_task (project));
+
+	for (l = mrp_project_get_resources (project); l; l = l->next) {
+		g_print ("%s\n", mrp_resource_get_name (l->data));
+
+		buckets = mrp_project_get_resource_timephase (project, l->data,
+							      unit, start, finish);
+
+		for (i = 0; i < buckets->len; i++) {
+			bucket = &g_array_index (buckets, MrpTimephaseBucket, i);
+
+			if (bucket->work == 0) {
+				continue;
+			}
+
+			date = mrp_time_format ("%Y-%m-%d", bucket->start);
+			g_print ("  %s %10.1f h %12.2f\n",
+				 date, bucket->work / 3600.0, bucket->cost);
+			g_free (date);
+		}
+
+		g_array_free (buckets, TRUE);
+	}
+
+	g_object_unref (project);
+	g_object_unref (app);
+
+	return 0;
+}
+
 static gboolean
 migrate_config_to_xdg_dir (void)
 {
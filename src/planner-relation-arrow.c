@@ -448,17 +448,6 @@ relation_arrow_update_line_segments (PlannerRelationArrow *arrow)
 	gnome_canvas_item_request_update (GNOME_CANVAS_ITEM (arrow));
 }
 
-static void
-relation_arrow_geometry_changed (PlannerGanttRow      *row,
-				 gdouble               x1,
-				 gdouble               y1,
-				 gdouble               x2,
-				 gdouble               y2,
-				 PlannerRelationArrow *arrow)
-{
-	relation_arrow_update_line_segments (arrow);
-}
-
 static void
 relation_arrow_successor_visibility_changed (PlannerGanttRow      *row,
 					     gboolean              visible,
@@ -508,21 +497,11 @@ planner_relation_arrow_set_predecessor (PlannerRelationArrow *arrow,
 	g_object_add_weak_pointer (G_OBJECT (predecessor),
 				   (gpointer)&priv->predecessor);
 
-	g_signal_connect_object (predecessor,
-				 "geometry-changed",
-				 G_CALLBACK (relation_arrow_geometry_changed),
-				 arrow,
-				 0);
-
 	g_signal_connect_object (predecessor,
 				 "visibility-changed",
 				 G_CALLBACK (relation_arrow_predecessor_visibility_changed),
 				 arrow,
 				 0);
-
-	if (priv->predecessor != NULL && priv->successor != NULL) {
-		relation_arrow_update_line_segments (arrow);
-	}
 }
 
 void
@@ -545,21 +524,42 @@ planner_relation_arrow_set_successor (PlannerRelationArrow *arrow,
 
 	g_object_add_weak_pointer (G_OBJECT (successor), (gpointer)&priv->successor);
 
-	g_signal_connect_object (successor,
-				 "geometry-changed",
-				 G_CALLBACK (relation_arrow_geometry_changed),
-				 arrow,
-				 0);
-
 	g_signal_connect_object (successor,
 				 "visibility-changed",
 				 G_CALLBACK (relation_arrow_successor_visibility_changed),
 				 arrow,
 				 0);
+}
+
+PlannerGanttRow *
+planner_relation_arrow_get_successor (PlannerRelationArrow *arrow)
+{
+	g_return_val_if_fail (PLANNER_IS_RELATION_ARROW (arrow), NULL);
 
-	if (priv->predecessor != NULL && priv->successor != NULL) {
-		relation_arrow_update_line_segments (arrow);
+	return arrow->priv->successor;
+}
+
+PlannerGanttRow *
+planner_relation_arrow_get_predecessor (PlannerRelationArrow *arrow)
+{
+	g_return_val_if_fail (PLANNER_IS_RELATION_ARROW (arrow), NULL);
+
+	return arrow->priv->predecessor;
+}
+
+/* The arrow doesn't follow its rows by itself, the owner calls this once the
+ * rows have their final geometry.
+ */
+void
+planner_relation_arrow_update (PlannerRelationArrow *arrow)
+{
+	g_return_if_fail (PLANNER_IS_RELATION_ARROW (arrow));
+
+	if (arrow->priv->predecessor == NULL || arrow->priv->successor == NULL) {
+		return;
 	}
+
+	relation_arrow_update_line_segments (arrow);
 }
 
 PlannerRelationArrow *
@@ -601,6 +601,12 @@ relation_arrow_get_bounds (PlannerRelationArrow *arrow,
 	item = GNOME_CANVAS_ITEM (arrow);
 	priv = arrow->priv;
 
+	/* Not routed yet. */
+	if (priv->num_points == 0) {
+		*x1 = *y1 = *x2 = *y2 = 0;
+		return;
+	}
+
 	/* Get the items bbox in canvas pixel coordinates. */
 
 	/* Silence warning. */
@@ -708,6 +714,10 @@ relation_arrow_draw (GnomeCanvasItem *item,
 	arrow = PLANNER_RELATION_ARROW (item);
 	priv = arrow->priv;
 
+	if (priv->num_points == 0) {
+		return;
+	}
+
 	cairo_save (cr);
 	cairo_set_line_width (cr, 1.0);
 	cairo_set_line_cap (cr, CAIRO_LINE_CAP_SQUARE);
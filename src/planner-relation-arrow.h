@@ -59,3 +59,9 @@ planner_relation_arrow_set_successor             (PlannerRelationArrow *arrow,
 void
 planner_relation_arrow_set_predecessor           (PlannerRelationArrow *arrow,
 					     PlannerGanttRow      *predecessor);
+PlannerGanttRow *
+planner_relation_arrow_get_successor             (PlannerRelationArrow *arrow);
+PlannerGanttRow *
+planner_relation_arrow_get_predecessor           (PlannerRelationArrow *arrow);
+void
+planner_relation_arrow_update                    (PlannerRelationArrow *arrow);
@@ -206,6 +206,8 @@ static void           resource_view_print_cleanup            (PlannerView
 static void           resource_view_resource_notify_cb       (MrpResource             *resource,
 							      GParamSpec              *pspec,
 							      PlannerView             *view);
+static void           resource_view_resource_overallocations_changed_cb (MrpResource  *resource,
+									PlannerView  *view);
 static void           resource_view_resource_prop_changed_cb (MrpResource             *resource,
 							      MrpProperty             *propert,
 							      GValue                  *value,
@@ -660,6 +662,13 @@ resource_view_resource_notify_cb (MrpResource *resource,
 	}
 }
 
+static void
+resource_view_resource_overallocations_changed_cb (MrpResource *resource,
+						   PlannerView *view)
+{
+	resource_view_resource_notify_cb (resource, NULL, view);
+}
+
 static void
 resource_view_resource_prop_changed_cb (MrpResource *resource,
 					MrpProperty *propert,
@@ -704,6 +713,9 @@ resource_view_resource_added_cb (MrpProject  *project,
 	g_signal_connect (resource, "prop_changed",
 			  G_CALLBACK (resource_view_resource_prop_changed_cb),
 			  view);
+	g_signal_connect (resource, "overallocations_changed",
+			  G_CALLBACK (resource_view_resource_overallocations_changed_cb),
+			  view);
 }
 
 static void
@@ -720,6 +732,9 @@ resource_view_resource_removed_cb (MrpProject  *project,
 	g_signal_handlers_disconnect_by_func (resource,
 					      resource_view_resource_prop_changed_cb,
 					      view);
+	g_signal_handlers_disconnect_by_func (resource,
+					      resource_view_resource_overallocations_changed_cb,
+					      view);
 
 	model = gtk_tree_view_get_model (PLANNER_RESOURCE_VIEW (view)->priv->tree_view);
 
@@ -2062,12 +2077,19 @@ resource_view_name_data_func (GtkTreeViewColumn    *tree_column,
 {
 	MrpResource *resource;
 	gchar       *name;
+	gboolean     overallocated;
 
 	gtk_tree_model_get (tree_model, iter, COL_RESOURCE, &resource, -1);
 
 	g_object_get (resource, "name", &name, NULL);
 
-	g_object_set (cell, "text", name, NULL);
+	/* Only overlaps in working time count. */
+	overallocated = mrp_resource_get_overallocated_periods (resource)->len > 0;
+
+	g_object_set (cell,
+		      "text", name,
+		      "foreground", overallocated ? "indian red" : NULL,
+		      NULL);
 	g_free (name);
 }
 
@@ -20,6 +20,7 @@
  */
 
 #include <config.h>
+#include <string.h>
 #include <glib/gi18n.h>
 #include <libplanner/mrp-relation.h>
 #include "planner-task-cmd.h"
@@ -290,3 +291,267 @@ planner_task_cmd_insert (PlannerWindow  *main_window,
 	return cmd_base;
 }
 
+
+typedef struct {
+	MrpTask       *task;
+	MrpConstraint  old_constraint;
+	MrpConstraint  constraint;
+} TaskLevelChange;
+
+typedef struct {
+	PlannerCmd       base;
+
+	MrpProject      *project;
+	TaskLevelChange *changes;
+	guint            n_changes;
+} TaskCmdLevel;
+
+/* Sets all the constraints before rescheduling once. */
+static void
+task_cmd_level_set_constraints (TaskCmdLevel *cmd,
+				gboolean      undo)
+{
+	TaskLevelChange *change;
+	gboolean         block;
+	guint            i;
+
+	block = mrp_project_get_block_scheduling (cmd->project);
+	mrp_project_set_block_scheduling (cmd->project, TRUE);
+
+	for (i = 0; i < cmd->n_changes; i++) {
+		change = &cmd->changes[i];
+
+		g_object_set (change->task,
+			      "constraint",
+			      undo ? &change->old_constraint : &change->constraint,
+			      NULL);
+	}
+
+	mrp_project_set_block_scheduling (cmd->project, block);
+}
+
+static gboolean
+task_cmd_level_do (PlannerCmd *cmd_base)
+{
+	task_cmd_level_set_constraints ((TaskCmdLevel *) cmd_base, FALSE);
+
+	return TRUE;
+}
+
+static void
+task_cmd_level_undo (PlannerCmd *cmd_base)
+{
+	task_cmd_level_set_constraints ((TaskCmdLevel *) cmd_base, TRUE);
+}
+
+static void
+task_cmd_level_free (PlannerCmd *cmd_base)
+{
+	TaskCmdLevel *cmd;
+	guint         i;
+
+	cmd = (TaskCmdLevel *) cmd_base;
+
+	for (i = 0; i < cmd->n_changes; i++) {
+		g_object_unref (cmd->changes[i].task);
+	}
+
+	g_free (cmd->changes);
+	g_object_unref (cmd->project);
+}
+
+/* Returns NULL if no task needs to be delayed. */
+PlannerCmd *
+planner_task_cmd_level_resources (PlannerWindow *main_window)
+{
+	PlannerCmd       *cmd_base;
+	TaskCmdLevel     *cmd;
+	TaskLevelChange  *change;
+	MrpProject       *project;
+	MrpLevelingDelay *delay;
+	MrpConstraint    *constraint;
+	GList            *delays, *l;
+
+	project = planner_window_get_project (main_window);
+
+	delays = mrp_project_get_leveling_delays (project);
+	if (!delays) {
+		return NULL;
+	}
+
+	cmd_base = planner_cmd_new (TaskCmdLevel,
+				    _("Level resources"),
+				    task_cmd_level_do,
+				    task_cmd_level_undo,
+				    task_cmd_level_free);
+
+	cmd = (TaskCmdLevel *) cmd_base;
+
+	cmd->project = g_object_ref (project);
+	cmd->n_changes = g_list_length (delays);
+	cmd->changes = g_new (TaskLevelChange, cmd->n_changes);
+
+	cmd_base->size += cmd->n_changes * sizeof (TaskLevelChange);
+
+	for (l = delays, change = cmd->changes; l; l = l->next, change++) {
+		delay = l->data;
+
+		change->task = g_object_ref (delay->task);
+
+		g_object_get (delay->task, "constraint", &constraint, NULL);
+		change->old_constraint = *constraint;
+		g_free (constraint);
+
+		change->constraint.type = MRP_CONSTRAINT_SNET;
+		change->constraint.time = delay->start;
+	}
+
+	g_list_free_full (delays, g_free);
+
+	planner_cmd_manager_insert_and_do (planner_window_get_cmd_manager (main_window),
+					   cmd_base);
+
+	return cmd_base;
+}
+
+typedef struct {
+	PlannerCmd         base;
+
+	PlannerTaskTree   *tree;
+	MrpProject        *project;
+
+	GtkTreePath       *path;
+
+	gchar             *property;
+	GValue            *value;
+	GValue            *old_value;
+} TaskCmdEditProperty;
+
+static MrpTask *
+task_cmd_edit_property_get_task (TaskCmdEditProperty *cmd)
+{
+	PlannerGanttModel *model;
+
+	model = PLANNER_GANTT_MODEL (gtk_tree_view_get_model (GTK_TREE_VIEW (cmd->tree)));
+
+	return planner_gantt_model_get_task_from_path (model, cmd->path);
+}
+
+static gboolean
+task_cmd_edit_property_do (PlannerCmd *cmd_base)
+{
+	TaskCmdEditProperty *cmd;
+
+	cmd = (TaskCmdEditProperty*) cmd_base;
+
+	g_object_set_property (G_OBJECT (task_cmd_edit_property_get_task (cmd)),
+			       cmd->property,
+			       cmd->value);
+
+	return TRUE;
+}
+
+static void
+task_cmd_edit_property_undo (PlannerCmd *cmd_base)
+{
+	TaskCmdEditProperty *cmd;
+
+	cmd = (TaskCmdEditProperty*) cmd_base;
+
+	g_object_set_property (G_OBJECT (task_cmd_edit_property_get_task (cmd)),
+			       cmd->property,
+			       cmd->old_value);
+}
+
+static void
+task_cmd_edit_property_free (PlannerCmd *cmd_base)
+{
+	TaskCmdEditProperty *cmd;
+
+	cmd = (TaskCmdEditProperty*) cmd_base;
+
+	g_object_unref (cmd->project);
+
+	gtk_tree_path_free (cmd->path);
+
+	g_free (cmd->property);
+	g_value_unset (cmd->value);
+	g_value_unset (cmd->old_value);
+
+	g_free (cmd->value);
+	g_free (cmd->old_value);
+}
+
+/* Consecutive edits of the same property on the same task, e.g. repeatedly
+ * dragging a bar, are undone in one step.
+ */
+static gboolean
+task_cmd_edit_property_merge (PlannerCmd *cmd_base,
+			      PlannerCmd *next_base)
+{
+	TaskCmdEditProperty *cmd;
+	TaskCmdEditProperty *next;
+
+	cmd = (TaskCmdEditProperty*) cmd_base;
+	next = (TaskCmdEditProperty*) next_base;
+
+	if (cmd->tree != next->tree ||
+	    strcmp (cmd->property, next->property) != 0 ||
+	    gtk_tree_path_compare (cmd->path, next->path) != 0) {
+		return FALSE;
+	}
+
+	g_value_unset (cmd->value);
+	g_value_init (cmd->value, G_VALUE_TYPE (next->value));
+	g_value_copy (next->value, cmd->value);
+
+	return TRUE;
+}
+
+/* Sets @property of @task to @value. Nothing is returned, since the command
+ * is freed when it is merged into the previous edit.
+ */
+void
+planner_task_cmd_edit_property (PlannerWindow   *main_window,
+				PlannerTaskTree *tree,
+				MrpTask         *task,
+				const gchar     *property,
+				const GValue    *value)
+{
+	PlannerCmd          *cmd_base;
+	TaskCmdEditProperty *cmd;
+	PlannerGanttModel   *model;
+
+	cmd_base = planner_cmd_new (TaskCmdEditProperty,
+				    _("Edit task property"),
+				    task_cmd_edit_property_do,
+				    task_cmd_edit_property_undo,
+				    task_cmd_edit_property_free);
+
+	cmd_base->merge_func = task_cmd_edit_property_merge;
+
+	cmd = (TaskCmdEditProperty *) cmd_base;
+
+	cmd->tree = tree;
+	cmd->project = g_object_ref (planner_window_get_project (main_window));
+
+	model = PLANNER_GANTT_MODEL (gtk_tree_view_get_model (GTK_TREE_VIEW (tree)));
+
+	cmd->path = planner_gantt_model_get_path_from_task (model, task);
+
+	cmd->property = g_strdup (property);
+
+	cmd->value = g_new0 (GValue, 1);
+	g_value_init (cmd->value, G_VALUE_TYPE (value));
+	g_value_copy (value, cmd->value);
+
+	cmd->old_value = g_new0 (GValue, 1);
+	g_value_init (cmd->old_value, G_VALUE_TYPE (value));
+
+	g_object_get_property (G_OBJECT (task),
+			       cmd->property,
+			       cmd->old_value);
+
+	planner_cmd_manager_insert_and_do (planner_window_get_cmd_manager (main_window),
+					   cmd_base);
+}
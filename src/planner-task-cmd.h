@@ -37,3 +37,9 @@ PlannerCmd *planner_task_cmd_insert        (PlannerWindow    *main_window,
 					    gint              work,
 					    gint              duration,
 					    MrpTask          *new_task);
+PlannerCmd *planner_task_cmd_level_resources (PlannerWindow  *main_window);
+void        planner_task_cmd_edit_property (PlannerWindow    *main_window,
+					    PlannerTaskTree  *tree,
+					    MrpTask          *task,
+					    const gchar      *property,
+					    const GValue     *value);
@@ -126,6 +126,11 @@ static void        task_tree_duration_data_func        (GtkTreeViewColumn    *tr
 							GtkTreeModel         *tree_model,
 							GtkTreeIter          *iter,
 							gpointer              data);
+static void        task_tree_value_data_func           (GtkTreeViewColumn    *tree_column,
+							 GtkCellRenderer      *cell,
+							 GtkTreeModel         *tree_model,
+							 GtkTreeIter          *iter,
+							 gpointer              data);
 static void        task_tree_cost_data_func            (GtkTreeViewColumn    *tree_column,
 							GtkCellRenderer      *cell,
 							GtkTreeModel         *tree_model,
@@ -187,113 +192,6 @@ static guint signals[LAST_SIGNAL];
  * Commands
  */
 
-typedef struct {
-	PlannerCmd         base;
-
-	PlannerTaskTree   *tree;
-	MrpProject        *project;
-
-	GtkTreePath       *path;
-
-	gchar             *property;
-	GValue            *value;
-	GValue            *old_value;
-} TaskCmdEditProperty;
-
-static gboolean
-task_cmd_edit_property_do (PlannerCmd *cmd_base)
-{
-	TaskCmdEditProperty *cmd;
-	MrpTask             *task;
-
-	cmd = (TaskCmdEditProperty*) cmd_base;
-
-	task = task_tree_get_task_from_path (cmd->tree, cmd->path);
-
-	g_object_set_property (G_OBJECT (task),
-			       cmd->property,
-			       cmd->value);
-
-	return TRUE;
-}
-
-static void
-task_cmd_edit_property_undo (PlannerCmd *cmd_base)
-{
-	TaskCmdEditProperty *cmd;
-	MrpTask             *task;
-
-	cmd = (TaskCmdEditProperty*) cmd_base;
-
-	task = task_tree_get_task_from_path (cmd->tree, cmd->path);
-
-	g_object_set_property (G_OBJECT (task),
-			       cmd->property,
-			       cmd->old_value);
-}
-
-static void
-task_cmd_edit_property_free (PlannerCmd *cmd_base)
-{
-	TaskCmdEditProperty *cmd;
-
-	cmd = (TaskCmdEditProperty*) cmd_base;
-
-	g_object_unref (cmd->project);
-
-	g_free (cmd->property);
-	g_value_unset (cmd->value);
-	g_value_unset (cmd->old_value);
-
-	g_free (cmd->value);
-	g_free (cmd->old_value);
-}
-
-static PlannerCmd *
-task_cmd_edit_property (PlannerWindow   *window,
-			PlannerTaskTree *tree,
-			MrpTask         *task,
-			const gchar     *property,
-			const GValue    *value)
-{
-	PlannerCmd          *cmd_base;
-	TaskCmdEditProperty *cmd;
-	PlannerGanttModel   *model;
-
-	cmd_base = planner_cmd_new (TaskCmdEditProperty,
-				    _("Edit task property"),
-				    task_cmd_edit_property_do,
-				    task_cmd_edit_property_undo,
-				    task_cmd_edit_property_free);
-
-	cmd = (TaskCmdEditProperty *) cmd_base;
-
-	cmd->tree = tree;
-	cmd->project = g_object_ref (planner_window_get_project (window));
-
-	model = PLANNER_GANTT_MODEL (gtk_tree_view_get_model (GTK_TREE_VIEW (tree)));
-
-	cmd->path = planner_gantt_model_get_path_from_task (model, task);
-
-	cmd->property = g_strdup (property);
-
-	cmd->value = g_new0 (GValue, 1);
-	g_value_init (cmd->value, G_VALUE_TYPE (value));
-	g_value_copy (value, cmd->value);
-
-	cmd->old_value = g_new0 (GValue, 1);
-	g_value_init (cmd->old_value, G_VALUE_TYPE (value));
-
-	g_object_get_property (G_OBJECT (task),
-			       cmd->property,
-			       cmd->old_value);
-
-	planner_cmd_manager_insert_and_do (planner_window_get_cmd_manager (window),
-					   cmd_base);
-
-	return cmd_base;
-}
-
 typedef struct {
 	PlannerCmd       base;
 
@@ -553,6 +451,56 @@ task_cmd_remove_free (PlannerCmd *cmd_base)
 	gtk_tree_path_free (cmd->path);
 }
 
+/* What a remove command keeps alive for @task: the task object with its
+ * name, note and custom property values, and the lists of its relations,
+ * assignments and children, for the whole subtree.
+ */
+static gsize
+task_cmd_remove_get_size (MrpProject *project, MrpTask *task)
+{
+	MrpTask     *child;
+	GTypeQuery   query;
+	GList       *properties, *l;
+	GValue       value = G_VALUE_INIT;
+	const gchar *str;
+	gchar       *name, *note;
+	gsize        size;
+
+	g_type_query (G_OBJECT_TYPE (task), &query);
+	size = sizeof (TaskCmdRemove) + query.instance_size;
+
+	g_object_get (task, "name", &name, "note", &note, NULL);
+	size += (name ? strlen (name) + 1 : 0) + (note ? strlen (note) + 1 : 0);
+	g_free (name);
+	g_free (note);
+
+	properties = mrp_project_get_properties_from_type (project, MRP_TYPE_TASK);
+	for (l = properties; l; l = l->next) {
+		g_value_init (&value, G_PARAM_SPEC_VALUE_TYPE (l->data));
+		mrp_object_get_property (MRP_OBJECT (task), l->data, &value);
+
+		size += sizeof (GValue);
+		if (G_VALUE_HOLDS_STRING (&value) && (str = g_value_get_string (&value))) {
+			size += strlen (str) + 1;
+		}
+
+		g_value_unset (&value);
+	}
+	g_list_free (properties);
+
+	size += sizeof (GList) * (g_list_length (mrp_task_get_predecessor_relations (task)) +
+				  g_list_length (mrp_task_get_successor_relations (task)) +
+				  g_list_length (mrp_task_get_assignments (task)));
+
+	child = mrp_task_get_first_child (task);
+	while (child) {
+		size += sizeof (GList) + task_cmd_remove_get_size (project, child);
+		child = mrp_task_get_next_sibling (child);
+	}
+
+	return size;
+}
+
 static PlannerCmd *
 task_cmd_remove (PlannerTaskTree *tree,
 		 GtkTreePath     *path,
@@ -577,6 +525,8 @@ task_cmd_remove (PlannerTaskTree *tree,
 
 	cmd->task = g_object_ref (task);
 
+	cmd_base->size += task_cmd_remove_get_size (cmd->project, task);
+
 	planner_cmd_manager_insert_and_do (planner_window_get_cmd_manager (priv->main_window),
 					   cmd_base);
 
@@ -1510,6 +1460,37 @@ task_tree_cost_data_func (GtkTreeViewColumn *tree_column,
 	g_free (str);
 }
 
+/* Shows one of the earned value columns, the model column is set on the view
+ * column since the print code passes no user data.
+ */
+static void
+task_tree_value_data_func (GtkTreeViewColumn *tree_column,
+			   GtkCellRenderer   *cell,
+			   GtkTreeModel      *tree_model,
+			   GtkTreeIter       *iter,
+			   gpointer           data)
+{
+	gfloat  value;
+	gchar  *str;
+	gint    weight;
+
+	gtk_tree_model_get (tree_model,
+			    iter,
+			    GPOINTER_TO_INT (g_object_get_data (G_OBJECT (tree_column),
+								"model-column")), &value,
+			    COL_WEIGHT, &weight,
+			    -1);
+
+	str = planner_format_float (value, 2, FALSE);
+
+	g_object_set (cell,
+		      "text", str,
+		      "weight", weight,
+		      NULL);
+
+	g_free (str);
+}
+
 static void
 task_tree_complete_data_func (GtkTreeViewColumn *tree_column,
 			  GtkCellRenderer   *cell,
@@ -1695,11 +1676,11 @@ task_tree_name_edited (GtkCellRendererText *cell,
 		g_value_init (&value, G_TYPE_STRING);
 		g_value_set_string (&value, new_text);
 
-		task_cmd_edit_property (priv->main_window,
-					task_tree,
-					task,
-					"name",
-					&value);
+		planner_task_cmd_edit_property (priv->main_window,
+						task_tree,
+						task,
+						"name",
+						&value);
 
 		g_value_unset (&value);
 	}
@@ -1741,11 +1722,11 @@ task_tree_complete_edited (GtkCellRendererText *cell,
 		g_value_init (&value, G_TYPE_INT);
 		g_value_set_int (&value, complete);
 
-		task_cmd_edit_property (tree->priv->main_window,
-					PLANNER_TASK_TREE (view),
-					task,
-					"percent_complete",
-					&value);
+		planner_task_cmd_edit_property (tree->priv->main_window,
+						PLANNER_TASK_TREE (view),
+						task,
+						"percent_complete",
+						&value);
 
 		g_value_unset (&value);
 	}
@@ -1927,11 +1908,11 @@ task_tree_duration_edited (GtkCellRendererText *cell,
 		g_value_init (&value, G_TYPE_INT);
 		g_value_set_int (&value, duration);
 
-		task_cmd_edit_property (tree->priv->main_window,
-					PLANNER_TASK_TREE (view),
-					task,
-					"duration",
-					&value);
+		planner_task_cmd_edit_property (tree->priv->main_window,
+						PLANNER_TASK_TREE (view),
+						task,
+						"duration",
+						&value);
 	}
 
 	gtk_tree_path_free (path);
@@ -1966,11 +1947,11 @@ task_tree_work_edited (GtkCellRendererText *cell,
 	g_value_init (&value, G_TYPE_INT);
 	g_value_set_int (&value, work);
 
-	task_cmd_edit_property (PLANNER_TASK_TREE (view)->priv->main_window,
-				PLANNER_TASK_TREE (view),
-				task,
-				"work",
-				&value);
+	planner_task_cmd_edit_property (PLANNER_TASK_TREE (view)->priv->main_window,
+					PLANNER_TASK_TREE (view),
+					task,
+					"work",
+					&value);
 
 	gtk_tree_path_free (path);
 }
@@ -1985,10 +1966,8 @@ task_tree_property_data_func (GtkTreeViewColumn *tree_column,
 	MrpObject       *object;
 	MrpProperty     *property = data;
 	MrpPropertyType  type;
+	GValue           value = { 0 };
 	gchar           *svalue;
-	gint             ivalue;
-	gfloat           fvalue;
-	mrptime          tvalue;
 
 	gtk_tree_model_get (tree_model,
 			    iter,
@@ -1996,16 +1975,17 @@ task_tree_property_data_func (GtkTreeViewColumn *tree_column,
 			    &object,
 			    -1);
 
-	/* FIXME: implement mrp_object_get_property like
-	 * g_object_get_property that takes a GValue.
+	/* Read the value straight from the property column, this is called
+	 * for every visible row on each redraw.
 	 */
 	type = mrp_property_get_property_type (property);
 
+	g_value_init (&value, G_PARAM_SPEC_VALUE_TYPE (G_PARAM_SPEC (property)));
+	mrp_object_get_property (object, property, &value);
+
 	switch (type) {
 	case MRP_PROPERTY_TYPE_STRING:
-		mrp_object_get (object,
-				mrp_property_get_name (property), &svalue,
-				NULL);
+		svalue = g_value_dup_string (&value);
 
 		if (svalue == NULL) {
 			svalue = g_strdup ("");
@@ -2013,41 +1993,24 @@ task_tree_property_data_func (GtkTreeViewColumn *tree_column,
 
 		break;
 	case MRP_PROPERTY_TYPE_INT:
-		mrp_object_get (object,
-				mrp_property_get_name (property), &ivalue,
-				NULL);
-		svalue = g_strdup_printf ("%d", ivalue);
+		svalue = g_strdup_printf ("%d", g_value_get_int (&value));
 		break;
 
 	case MRP_PROPERTY_TYPE_FLOAT:
-		mrp_object_get (object,
-				mrp_property_get_name (property), &fvalue,
-				NULL);
-
-		svalue = planner_format_float (fvalue, 4, FALSE);
+		svalue = planner_format_float (g_value_get_float (&value), 4, FALSE);
 		break;
 
 	case MRP_PROPERTY_TYPE_DATE:
-		mrp_object_get (object,
-				mrp_property_get_name (property), &tvalue,
-				NULL);
-		svalue = planner_format_date (tvalue);
+		svalue = planner_format_date (g_value_get_int64 (&value));
 		break;
 
 	case MRP_PROPERTY_TYPE_DURATION:
-		mrp_object_get (object,
-				mrp_property_get_name (property), &ivalue,
-				NULL);
-
-		svalue = planner_format_duration (PLANNER_TASK_TREE (data)->priv->project, ivalue);
+		svalue = planner_format_duration (mrp_object_get_project (object),
+						  g_value_get_int (&value));
 		break;
 
 	case MRP_PROPERTY_TYPE_COST:
-		mrp_object_get (object,
-				mrp_property_get_name (property), &fvalue,
-				NULL);
-
-		svalue = planner_format_float (fvalue, 2, FALSE);
+		svalue = planner_format_float (g_value_get_float (&value), 2, FALSE);
 		break;
 
 	default:
@@ -2056,6 +2019,8 @@ task_tree_property_data_func (GtkTreeViewColumn *tree_column,
 		break;
 	}
 
+	g_value_unset (&value);
+
 	g_object_set (cell, "text", svalue, NULL);
 	g_free (svalue);
 }
@@ -2251,13 +2216,47 @@ task_tree_property_changed (MrpProject      *project,
 	}
 }
 
+/* The model batches its row changes per frame of the tree. */
+static void
+task_tree_realize_cb (GtkWidget *widget, gpointer data)
+{
+	GtkTreeModel *model;
+
+	model = gtk_tree_view_get_model (GTK_TREE_VIEW (widget));
+	if (model) {
+		planner_gantt_model_set_widget (PLANNER_GANTT_MODEL (model), widget);
+	}
+}
+
+static void
+task_tree_unrealize_cb (GtkWidget *widget, gpointer data)
+{
+	GtkTreeModel *model;
+
+	model = gtk_tree_view_get_model (GTK_TREE_VIEW (widget));
+	if (model) {
+		planner_gantt_model_set_widget (PLANNER_GANTT_MODEL (model), NULL);
+	}
+}
+
 void
 planner_task_tree_set_model (PlannerTaskTree   *tree,
 			     PlannerGanttModel *model)
 {
+	GtkTreeModel *old_model;
+
+	old_model = gtk_tree_view_get_model (GTK_TREE_VIEW (tree));
+	if (old_model) {
+		planner_gantt_model_set_widget (PLANNER_GANTT_MODEL (old_model), NULL);
+	}
+
 	gtk_tree_view_set_model (GTK_TREE_VIEW (tree),
 				 GTK_TREE_MODEL (model));
 
+	if (gtk_widget_get_realized (GTK_WIDGET (tree))) {
+		planner_gantt_model_set_widget (model, GTK_WIDGET (tree));
+	}
+
 	g_signal_connect (model,
 			  "row-inserted",
 			  G_CALLBACK (task_tree_row_inserted),
@@ -2291,6 +2290,16 @@ task_tree_setup_tree_view (GtkTreeView       *tree,
 	gtk_tree_view_set_rules_hint (tree, TRUE);
 	gtk_tree_view_set_reorderable (tree, TRUE);
 
+	g_signal_connect (tree,
+			  "realize",
+			  G_CALLBACK (task_tree_realize_cb),
+			  NULL);
+
+	g_signal_connect (tree,
+			  "unrealize",
+			  G_CALLBACK (task_tree_unrealize_cb),
+			  NULL);
+
 	g_signal_connect (tree,
 			  "popup_menu",
 			  G_CALLBACK (task_tree_tree_view_popup_menu),
@@ -2530,6 +2539,34 @@ task_tree_add_column (PlannerTaskTree *tree,
 		g_object_set_data (G_OBJECT (col), "id", "cost");
 		break;
 
+	case COL_ACTUAL_COST:
+	case COL_PLANNED_VALUE:
+	case COL_EARNED_VALUE:
+		cell = gtk_cell_renderer_text_new ();
+		col = gtk_tree_view_column_new_with_attributes (title,
+								cell,
+								NULL);
+		gtk_tree_view_column_set_resizable (col, TRUE);
+		gtk_tree_view_column_set_min_width (col, 70);
+		gtk_tree_view_column_set_cell_data_func (col,
+							 cell,
+							 task_tree_value_data_func,
+							 GTK_TREE_VIEW (tree),
+							 NULL);
+		g_object_set_data (G_OBJECT (col),
+				   "data-func", task_tree_value_data_func);
+		g_object_set_data (G_OBJECT (col),
+				   "model-column", GINT_TO_POINTER (column));
+
+		if (column == COL_ACTUAL_COST) {
+			g_object_set_data (G_OBJECT (col), "id", "actual-cost");
+		} else if (column == COL_PLANNED_VALUE) {
+			g_object_set_data (G_OBJECT (col), "id", "planned-value");
+		} else {
+			g_object_set_data (G_OBJECT (col), "id", "earned-value");
+		}
+		break;
+
 	case COL_COMPLETE:
 		cell = gtk_cell_renderer_text_new ();
 		g_object_set (cell, "editable", TRUE, NULL);
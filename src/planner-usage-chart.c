@@ -54,13 +54,17 @@
 /* Font width factor. */
 static gdouble font_width_factor = 1.0;
 
+/* Rows kept materialized above and below the viewport. */
+#define OVERSCAN_ROWS 10
+
 typedef struct _TreeNode TreeNode;
 typedef void (*TreeFunc) (TreeNode *node, gpointer data);
 
 struct _TreeNode {
 	MrpResource      *resource;
 	MrpAssignment    *assignment;
-	GnomeCanvasItem  *item;
+	GnomeCanvasItem  *item;       /* Only set while the row is on screen. */
+	gint              row;        /* Index in the row table, or -1. */
 	TreeNode         *parent;
 	TreeNode        **children;
 	guint             num_children;
@@ -96,6 +100,19 @@ struct _PlannerUsageChartPriv {
 	gboolean         height_changed;
 	guint            reflow_idle_id;
 	GList           *signal_ids;
+
+	/* The visible nodes in display order. All rows have the same height,
+	 * so row i starts at i * row_height.
+	 */
+	GPtrArray       *rows;
+
+	/* Only the nodes around the viewport have a canvas item, the rest of
+	 * the items are hidden in the pool for reuse.
+	 */
+	GPtrArray       *materialized;
+	GPtrArray       *pool;
+	GtkAdjustment   *canvas_vadjustment;
+	guint            viewport_idle_id;
 };
 
 enum {
@@ -143,9 +160,10 @@ static void      usage_chart_set_vadjustment       (PlannerUsageChart       *cha
 static void      usage_chart_reflow_now            (PlannerUsageChart      *chart);
 static void      usage_chart_reflow                (PlannerUsageChart      *chart,
 						     gboolean                 height_changed);
-static gdouble   usage_chart_reflow_do             (PlannerUsageChart      *chart,
-						     TreeNode                *root,
-						     gdouble                  start_y);
+static void      usage_chart_reflow_do             (PlannerUsageChart      *chart);
+static void      usage_chart_update_viewport       (PlannerUsageChart      *chart);
+static void      usage_chart_release_node          (PlannerUsageChart      *chart,
+						     TreeNode                *node);
 static gboolean  usage_chart_reflow_idle           (PlannerUsageChart      *chart);
 static gint      usage_chart_get_width             (PlannerUsageChart      *chart);
 static TreeNode *usage_chart_tree_node_new         (void);
@@ -187,8 +205,9 @@ static void      usage_chart_project_start_changed (MrpProject              *pro
 static void      usage_chart_root_finish_changed   (MrpTask                 *root,
 						     GParamSpec              *spec,
 						     PlannerUsageChart      *chart);
-static void      show_hide_descendants              (TreeNode                *node,
-						     gboolean                 show);
+static void      usage_chart_canvas_vadjustment_notify_cb (GnomeCanvas       *canvas,
+							   GParamSpec        *pspec,
+							   PlannerUsageChart *chart);
 static void      collapse_descendants               (TreeNode                *node);
 static TreeNode *usage_chart_tree_node_at_path     (TreeNode                *node,
 						     GtkTreePath             *path);
@@ -323,6 +342,9 @@ usage_chart_init (PlannerUsageChart * chart)
 	chart->priv = priv;
 
 	priv->tree = usage_chart_tree_node_new ();
+	priv->rows = g_ptr_array_new ();
+	priv->materialized = g_ptr_array_new ();
+	priv->pool = g_ptr_array_new ();
 
 	priv->zoom = DEFAULT_ZOOM_LEVEL;
 
@@ -373,6 +395,12 @@ usage_chart_init (PlannerUsageChart * chart)
 				priv->canvas, "hadjustment",
 				G_BINDING_DEFAULT);
 
+	/* Rows are materialized for whatever part the canvas shows. */
+	g_signal_connect (priv->canvas,
+			  "notify::vadjustment",
+			  G_CALLBACK (usage_chart_canvas_vadjustment_notify_cb),
+			  chart);
+	usage_chart_canvas_vadjustment_notify_cb (priv->canvas, NULL, chart);
 }
 
 static TreeNode *
@@ -381,6 +409,7 @@ usage_chart_tree_node_new (void)
 	TreeNode *node;
 	node = g_new0 (TreeNode, 1);
 	node->expanded = TRUE;
+	node->row = -1;
 	return node;
 }
 
@@ -624,6 +653,20 @@ usage_chart_finalize (GObject *object)
 
 	chart = PLANNER_USAGE_CHART (object);
 
+	if (chart->priv->viewport_idle_id) {
+		g_source_remove (chart->priv->viewport_idle_id);
+	}
+
+	if (chart->priv->canvas_vadjustment) {
+		g_signal_handlers_disconnect_by_data (chart->priv->canvas_vadjustment,
+						      chart);
+		g_object_unref (chart->priv->canvas_vadjustment);
+	}
+
+	g_ptr_array_free (chart->priv->rows, TRUE);
+	g_ptr_array_free (chart->priv->materialized, TRUE);
+	g_ptr_array_free (chart->priv->pool, TRUE);
+
 	g_free (chart->priv->tree);
 	g_free (chart->priv);
 
@@ -815,58 +858,214 @@ usage_chart_set_vadjustment (PlannerUsageChart *chart,
 	g_object_notify (G_OBJECT (chart), "vadjustment");
 }
 
-static gboolean
-node_is_visible (TreeNode *node)
+static gint
+usage_chart_get_row_height (PlannerUsageChart *chart)
 {
-	g_return_val_if_fail (node->parent != NULL, FALSE);
-
-	while (node->parent) {
-		if (!node->parent->expanded) {
-			return FALSE;
-		}
-		node = node->parent;
+	if (chart->priv->row_height == -1) {
+		return 23;
 	}
 
-	return TRUE;
+	return chart->priv->row_height;
 }
 
-static gdouble
-usage_chart_reflow_do (PlannerUsageChart *chart,
-			TreeNode           *root,
-			gdouble             start_y)
+static void
+usage_chart_add_rows (GPtrArray *rows, TreeNode *root, gboolean visible)
 {
-	gdouble   row_y;
 	TreeNode *node;
 	guint     i;
-	gint      row_height;
 
-	if (root->children == NULL) {
-		return start_y;
+	for (i = 0; i < root->num_children; i++) {
+		node = root->children[i];
+
+		if (visible) {
+			node->row = rows->len;
+			g_ptr_array_add (rows, node);
+		} else {
+			node->row = -1;
+		}
+
+		usage_chart_add_rows (rows, node, visible && node->expanded);
 	}
+}
+
+/* Rebuilds the row table from the tree. */
+static void
+usage_chart_reflow_do (PlannerUsageChart *chart)
+{
+	PlannerUsageChartPriv *priv;
+
+	priv = chart->priv;
 
-	node = root->children[0];
-	row_y = start_y;
+	g_ptr_array_set_size (priv->rows, 0);
+	usage_chart_add_rows (priv->rows, priv->tree, TRUE);
+}
+
+static void
+usage_chart_materialize_node (PlannerUsageChart *chart,
+			      TreeNode          *node)
+{
+	PlannerUsageChartPriv *priv;
+	GnomeCanvasItem       *item;
+
+	priv = chart->priv;
+
+	if (priv->pool->len > 0) {
+		item = g_ptr_array_remove_index_fast (priv->pool,
+						      priv->pool->len - 1);
 
-	row_height = chart->priv->row_height;
-	if (row_height == -1) {
-		row_height = 23;
+		g_object_set (item,
+			      "resource", node->resource,
+			      "assignment", node->assignment,
+			      "scale", SCALE (priv->zoom),
+			      "zoom", priv->zoom,
+			      NULL);
+		planner_usage_row_set_visible (PLANNER_USAGE_ROW (item), TRUE);
+	} else {
+		item = gnome_canvas_item_new (gnome_canvas_root (priv->canvas),
+					      PLANNER_TYPE_USAGE_ROW,
+					      "resource", node->resource,
+					      "assignment", node->assignment,
+					      "scale", SCALE (priv->zoom),
+					      "zoom", priv->zoom,
+					      NULL);
 	}
-	for (i = 0; i < root->num_children; i++) {
-		node = root->children[i];
-		if (node_is_visible (node)) {
-			g_object_set (node->item,
-				      "y", row_y,
-				      "height", (double) row_height, NULL);
-			row_y += row_height;
-
-			if (node->children != NULL) {
-				row_y += usage_chart_reflow_do (chart, node,
-								 row_y);
-			}
+
+	node->item = item;
+	g_ptr_array_add (priv->materialized, node);
+}
+
+/* Hides the item of @node and puts it in the pool, dropping the signal
+ * connections it had for the resource or assignment. The caller removes
+ * @node from the materialized array.
+ */
+static void
+usage_chart_release_node (PlannerUsageChart *chart,
+			  TreeNode          *node)
+{
+	g_object_set (node->item,
+		      "resource", NULL,
+		      "assignment", NULL,
+		      NULL);
+	planner_usage_row_set_visible (PLANNER_USAGE_ROW (node->item), FALSE);
+
+	g_ptr_array_add (chart->priv->pool, node->item);
+	node->item = NULL;
+}
+
+/* Makes sure the rows in and around the viewport, and only those, have an
+ * item at the right position.
+ */
+static void
+usage_chart_update_viewport (PlannerUsageChart *chart)
+{
+	PlannerUsageChartPriv *priv;
+	GtkAllocation          allocation;
+	TreeNode              *node;
+	gint                   row_height;
+	gint                   cy;
+	gdouble                top;
+	gint                   first, last, i;
+
+	priv = chart->priv;
+
+	if (priv->viewport_idle_id) {
+		g_source_remove (priv->viewport_idle_id);
+		priv->viewport_idle_id = 0;
+	}
+
+	row_height = usage_chart_get_row_height (chart);
+
+	gtk_widget_get_allocation (GTK_WIDGET (priv->canvas), &allocation);
+	gnome_canvas_get_scroll_offsets (priv->canvas, NULL, &cy);
+	gnome_canvas_c2w (priv->canvas, 0, cy, NULL, &top);
+
+	first = MAX (0, (gint) floor (top / row_height) - OVERSCAN_ROWS);
+	last = MIN ((gint) priv->rows->len,
+		    (gint) ceil ((top + allocation.height) / row_height) + OVERSCAN_ROWS);
+
+	for (i = priv->materialized->len - 1; i >= 0; i--) {
+		node = g_ptr_array_index (priv->materialized, i);
+
+		if (node->row < first || node->row >= last) {
+			usage_chart_release_node (chart, node);
+			g_ptr_array_remove_index_fast (priv->materialized, i);
 		}
 	}
 
-	return row_y - start_y;
+	for (i = first; i < last; i++) {
+		node = g_ptr_array_index (priv->rows, i);
+
+		if (!node->item) {
+			usage_chart_materialize_node (chart, node);
+		}
+
+		g_object_set (node->item,
+			      "y", (gdouble) i * row_height,
+			      "height", (gdouble) row_height,
+			      NULL);
+	}
+}
+
+static gboolean
+usage_chart_viewport_idle (PlannerUsageChart *chart)
+{
+	chart->priv->viewport_idle_id = 0;
+
+	usage_chart_update_viewport (chart);
+
+	return FALSE;
+}
+
+static void
+usage_chart_canvas_scrolled_cb (GtkAdjustment     *adjustment,
+				PlannerUsageChart *chart)
+{
+	if (chart->priv->viewport_idle_id != 0) {
+		return;
+	}
+
+	/* Run before the canvas redraws the newly exposed area. */
+	chart->priv->viewport_idle_id =
+		g_idle_add_full (GDK_PRIORITY_REDRAW - 1,
+				 (GSourceFunc) usage_chart_viewport_idle,
+				 chart, NULL);
+}
+
+static void
+usage_chart_canvas_vadjustment_notify_cb (GnomeCanvas       *canvas,
+					  GParamSpec        *pspec,
+					  PlannerUsageChart *chart)
+{
+	PlannerUsageChartPriv *priv;
+	GtkAdjustment         *vadj;
+
+	priv = chart->priv;
+
+	vadj = gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (canvas));
+	if (vadj == priv->canvas_vadjustment) {
+		return;
+	}
+
+	if (priv->canvas_vadjustment) {
+		g_signal_handlers_disconnect_by_func (priv->canvas_vadjustment,
+						      usage_chart_canvas_scrolled_cb,
+						      chart);
+		g_object_unref (priv->canvas_vadjustment);
+	}
+
+	priv->canvas_vadjustment = vadj;
+
+	if (vadj) {
+		g_object_ref (vadj);
+		g_signal_connect (vadj,
+				  "value-changed",
+				  G_CALLBACK (usage_chart_canvas_scrolled_cb),
+				  chart);
+		g_signal_connect (vadj,
+				  "changed",
+				  G_CALLBACK (usage_chart_canvas_scrolled_cb),
+				  chart);
+	}
 }
 
 static gboolean
@@ -882,12 +1081,15 @@ usage_chart_reflow_idle (PlannerUsageChart *chart)
 	priv = chart->priv;
 
 	if (priv->height_changed || priv->height == -1) {
-		height = usage_chart_reflow_do (chart, priv->tree, 0);
+		usage_chart_reflow_do (chart);
+		height = priv->rows->len * usage_chart_get_row_height (chart);
 		priv->height = height;
 	} else {
 		height = priv->height;
 	}
 
+	usage_chart_update_viewport (chart);
+
 	gtk_widget_get_allocation (GTK_WIDGET (priv->canvas), &allocation);
 
 	t1 = priv->project_start;
@@ -1186,21 +1388,12 @@ usage_chart_insert_row (PlannerUsageChart *chart,
 			 MrpAssignment      *assign)
 {
 	PlannerUsageChartPriv *priv;
-	GnomeCanvasItem        *item;
 	TreeNode               *tree_node;
 
 	priv = chart->priv;
 
-	item = gnome_canvas_item_new (gnome_canvas_root (priv->canvas),
-				      PLANNER_TYPE_USAGE_ROW,
-				      "resource", resource,
-				      "assignment", assign,
-				      "scale", SCALE (priv->zoom),
-				      "zoom", priv->zoom,
-				      NULL);
-
+	/* The item is created when the row scrolls into view. */
 	tree_node = usage_chart_tree_node_new ();
-	tree_node->item = item;
 	tree_node->resource = resource;
 	tree_node->assignment = assign;
 	usage_chart_tree_node_insert_path (priv->tree, path, tree_node);
@@ -1314,21 +1507,6 @@ usage_chart_disconnect_signals (PlannerUsageChart *chart)
 	chart->priv->signal_ids = NULL;
 }
 
-static void
-show_hide_descendants (TreeNode *node, gboolean show)
-{
-	gint i;
-
-	for (i = 0; i < node->num_children; i++) {
-		planner_usage_row_set_visible (PLANNER_USAGE_ROW
-						(node->children[i]->item),
-						show);
-		if (!show || (show && node->children[i]->expanded)) {
-			show_hide_descendants (node->children[i], show);
-		}
-	}
-}
-
 static void
 expand_descendants (TreeNode *node)
 {
@@ -1362,7 +1540,6 @@ planner_usage_chart_expand_row (PlannerUsageChart *chart,
 	node = usage_chart_tree_node_at_path (chart->priv->tree, path);
 	if (node) {
 		node->expanded = TRUE;
-		show_hide_descendants (node, TRUE);
 		usage_chart_reflow (chart, TRUE);
 	}
 }
@@ -1379,7 +1556,6 @@ planner_usage_chart_collapse_row (PlannerUsageChart *chart,
 	if (node) {
 		node->expanded = FALSE;
 		collapse_descendants (node);
-		show_hide_descendants (node, FALSE);
 		usage_chart_reflow (chart, TRUE);
 	}
 }
@@ -1390,7 +1566,6 @@ planner_usage_chart_expand_all (PlannerUsageChart *chart)
 	g_return_if_fail (PLANNER_IS_USAGE_CHART (chart));
 
 	expand_descendants (chart->priv->tree);
-	show_hide_descendants (chart->priv->tree, TRUE);
 	usage_chart_reflow (chart, TRUE);
 }
 
@@ -1406,7 +1581,6 @@ planner_usage_chart_collapse_all (PlannerUsageChart *chart)
 	for (i = 0; i < node->num_children; i++) {
 		node->children[i]->expanded = FALSE;
 		collapse_descendants (node->children[i]);
-		show_hide_descendants (node->children[i], FALSE);
 	}
 
 	usage_chart_reflow (chart, TRUE);
@@ -1497,6 +1671,9 @@ usage_chart_row_deleted (GtkTreeModel *model,
 	node = usage_chart_tree_node_at_path (priv->tree, path);
 	usage_chart_tree_node_remove (node);
 	usage_chart_remove_children (chart, node);
+
+	/* Don't leave the freed nodes in the row table until the reflow. */
+	usage_chart_reflow_do (chart);
 	/*
 	 * g_return_if_fail (path != NULL || iter != NULL);
 	 * fprintf(stderr,"On degage une ligne\n");
@@ -1582,8 +1759,10 @@ usage_chart_remove_children (PlannerUsageChart *chart, TreeNode *node)
 		usage_chart_remove_children (chart, node->children[i]);
 	}
 
-	g_object_run_dispose (G_OBJECT (node->item));
-	node->item = NULL;
+	if (node->item) {
+		g_ptr_array_remove_fast (chart->priv->materialized, node);
+		usage_chart_release_node (chart, node);
+	}
 
 	node->assignment = NULL;
 	node->resource = NULL;
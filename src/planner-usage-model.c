@@ -30,6 +30,7 @@
 #include <gtk/gtk.h>
 #include <glib/gi18n.h>
 #include <libplanner/mrp-task.h>
+#include <libplanner/mrp-project.h>
 #include "planner-marshal.h"
 #include "planner-usage-model.h"
 
@@ -220,6 +221,8 @@ usage_model_get_column_type (GtkTreeModel *tree_model, gint column)
 		return MRP_TYPE_RESOURCE;
 	case COL_ASSIGNMENT:
 		return MRP_TYPE_ASSIGNMENT;
+	case COL_WORK:
+		return G_TYPE_INT;
 	default:
 		return G_TYPE_INVALID;
 	}
@@ -356,6 +359,36 @@ usage_model_get_path (GtkTreeModel *tree_model, GtkTreeIter *iter)
 						(tree_model), node);
 }
 
+/* The total work of @resource, from the monthly work the project keeps. */
+static gint
+usage_model_get_resource_work (MrpResource *resource)
+{
+	MrpProject         *project;
+	MrpTask            *root;
+	GArray             *buckets;
+	MrpTimephaseBucket *bucket;
+	gint                work = 0;
+	guint               i;
+
+	project = mrp_object_get_project (MRP_OBJECT (resource));
+	root = mrp_project_get_root_task (project);
+
+	buckets = mrp_project_get_resource_timephase (project,
+						      resource,
+						      MRP_TIME_UNIT_MONTH,
+						      mrp_project_get_project_start (project),
+						      mrp_task_get_finish (root));
+
+	for (i = 0; i < buckets->len; i++) {
+		bucket = &g_array_index (buckets, MrpTimephaseBucket, i);
+		work += bucket->work;
+	}
+
+	g_array_free (buckets, TRUE);
+
+	return work;
+}
+
 static void
 usage_model_get_value (GtkTreeModel *tree_model,
 			GtkTreeIter *iter, gint column, GValue *value)
@@ -420,6 +453,11 @@ usage_model_get_value (GtkTreeModel *tree_model,
 		g_value_set_object (value, assign);
 		break;
 
+	case COL_WORK:
+		g_value_init (value, G_TYPE_INT);
+		g_value_set_int (value, assign ? 0 : usage_model_get_resource_work (resource));
+		break;
+
 	default:
 		g_warning ("Bad column %d requested", column);
 	}
@@ -52,6 +52,7 @@ enum {
         COL_TASKNAME,
         COL_RESOURCE,
         COL_ASSIGNMENT,
+        COL_WORK,
         NUM_COLS
 };
 
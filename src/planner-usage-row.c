@@ -40,6 +40,7 @@
 #include "planner-usage-row.h"
 #include "planner-usage-chart.h"
 #include "planner-canvas-line.h"
+#include "planner-change-queue.h"
 #include "planner-scale-utils.h"
 #include "planner-usage-chart.h"
 #include "planner-usage-model.h"
@@ -108,11 +109,18 @@ struct _PlannerUsageRowPriv {
 
         guint          scroll_timeout_id;
         State          state;
+
+        /* Objects the row has connected notify handlers to. The list data
+         * are weak pointers, so the row can be recycled for another
+         * resource or assignment.
+         */
+        GSList        *connected;
 };
 
 static void     usage_row_class_init                   (PlannerUsageRowClass  *class);
 static void     usage_row_init                         (PlannerUsageRow       *row);
 static void     usage_row_dispose                      (GObject               *object);
+static void     usage_row_disconnect_all               (PlannerUsageRow       *row);
 static void     usage_row_set_property                 (GObject                *object,
 							 guint                   param_id,
 							 const GValue           *value,
@@ -158,6 +166,8 @@ static void     usage_row_task_notify_cb               (MrpTask                *
 static void     usage_row_resource_assignment_added_cb (MrpResource            *resource,
 							 MrpAssignment          *assign,
 							 PlannerUsageRow       *row);
+static void     usage_row_resource_overallocations_changed_cb (MrpResource     *resource,
+								PlannerUsageRow *row);
 
 
 static GnomeCanvasItemClass *parent_class;
@@ -319,6 +329,11 @@ usage_row_dispose (GObject *object)
 
                 /* g_array_free (priv->resource_widths, FALSE); */
 
+                usage_row_disconnect_all (row);
+                g_clear_object (&priv->resource);
+                g_clear_object (&priv->assignment);
+                g_clear_object (&priv->layout);
+
                 g_free (priv);
                 row->priv = NULL;
         }
@@ -444,6 +459,10 @@ recalc_bounds (PlannerUsageRow *row)
 		get_resource_bounds (priv->resource, priv->scale, &x_debut,
 				     &x_fin, &x_debut_real);
 	}
+	else {
+		/* A recycled row waiting for its next resource or assignment. */
+		x_debut = x_fin = x_debut_real = 0.0;
+	}
 
 	priv->x = x_debut;
 	priv->width = x_fin - x_debut;
@@ -455,6 +474,47 @@ recalc_bounds (PlannerUsageRow *row)
 	return changed;
 }
 
+static void
+usage_row_connect (PlannerUsageRow *row,
+                   gpointer         instance,
+                   const gchar     *signal,
+                   GCallback        callback)
+{
+        PlannerUsageRowPriv *priv;
+
+        priv = row->priv;
+
+        g_signal_connect_object (instance, signal, callback, row, 0);
+
+        if (g_slist_find (priv->connected, instance)) {
+                return;
+        }
+
+        priv->connected = g_slist_prepend (priv->connected, instance);
+        g_object_add_weak_pointer (instance, &priv->connected->data);
+}
+
+static void
+usage_row_disconnect_all (PlannerUsageRow *row)
+{
+        PlannerUsageRowPriv *priv;
+        GSList              *l;
+
+        priv = row->priv;
+
+        for (l = priv->connected; l; l = l->next) {
+                if (!l->data) {
+                        continue;
+                }
+
+                g_signal_handlers_disconnect_by_data (l->data, row);
+                g_object_remove_weak_pointer (l->data, &l->data);
+        }
+
+        g_slist_free (priv->connected);
+        priv->connected = NULL;
+}
+
 static void
 usage_row_set_property (GObject      *object,
                          guint         param_id,
@@ -504,7 +564,7 @@ usage_row_set_property (GObject      *object,
 
         case PROP_RESOURCE:
                 if (priv->resource != NULL) {
-                        /* FIXME: check handlers to modify !!! */
+                        usage_row_disconnect_all (row);
                         g_object_unref (priv->resource);
                 }
                 if (g_value_get_object (value) == NULL) {
@@ -512,15 +572,12 @@ usage_row_set_property (GObject      *object,
                 } else {
                         GList *a;
                         priv->resource = g_object_ref (g_value_get_object (value));
-                        g_signal_connect_object (priv->resource, "notify",
-                                                 G_CALLBACK
-                                                 (usage_row_resource_notify_cb),
-                                                 row, 0);
-                        g_signal_connect_object (priv->resource,
-                                                 "assignment_added",
-                                                 G_CALLBACK
-                                                 (usage_row_resource_assignment_added_cb),
-                                                 row, 0);
+                        usage_row_connect (row, priv->resource, "notify",
+                                           G_CALLBACK (usage_row_resource_notify_cb));
+                        usage_row_connect (row, priv->resource, "assignment_added",
+                                           G_CALLBACK (usage_row_resource_assignment_added_cb));
+                        usage_row_connect (row, priv->resource, "overallocations_changed",
+                                           G_CALLBACK (usage_row_resource_overallocations_changed_cb));
                         a = mrp_resource_get_assignments (priv->resource);
                         for (; a; a = a->next) {
                                 MrpAssignment *assign;
@@ -529,15 +586,10 @@ usage_row_set_property (GObject      *object,
                                 assign = a->data;
 
 				tmp_task = mrp_assignment_get_task (assign);
-                                g_signal_connect_object (assign,
-                                                         "notify",
-                                                         G_CALLBACK (usage_row_assignment_notify_cb),
-                                                         row, 0);
-
-                                g_signal_connect_object (tmp_task,
-                                                         "notify",
-                                                         G_CALLBACK (usage_row_task_notify_cb),
-                                                         row, 0);
+                                usage_row_connect (row, assign, "notify",
+                                                   G_CALLBACK (usage_row_assignment_notify_cb));
+                                usage_row_connect (row, tmp_task, "notify",
+                                                   G_CALLBACK (usage_row_task_notify_cb));
                         }
                 }
                 /*
@@ -559,9 +611,11 @@ usage_row_set_property (GObject      *object,
 
         case PROP_ASSIGNMENT:
                 if (priv->assignment != NULL) {
-                        /* gantt_row_disconnect_all_resources (priv->task, row); */
+                        usage_row_disconnect_all (row);
                         g_object_unref (priv->assignment);
-                        /* FIXME: Disconnect notify handlers. */
+
+                        /* The label shows the units of the assignment. */
+                        g_clear_object (&priv->layout);
                 }
                 if (g_value_get_object (value) == NULL) {
                         priv->assignment = NULL;
@@ -578,15 +632,10 @@ usage_row_set_property (GObject      *object,
                                 priv->fixed_duration = 0;
                         }
 
-                        g_signal_connect_object (priv->assignment,
-                                                 "notify",
-                                                 G_CALLBACK (usage_row_assignment_notify_cb),
-                                                 row, 0);
-
-                        g_signal_connect_object (task,
-                                                 "notify",
-                                                 G_CALLBACK (usage_row_task_notify_cb),
-                                                 row, 0);
+                        usage_row_connect (row, priv->assignment, "notify",
+                                           G_CALLBACK (usage_row_assignment_notify_cb));
+                        usage_row_connect (row, task, "notify",
+                                           G_CALLBACK (usage_row_task_notify_cb));
                 }
 
                 /* usage_row_connect_all_resources (priv->assignment, row); */
@@ -726,45 +775,6 @@ usage_row_update (GnomeCanvasItem      *item,
 /* LightSkyBlue1 */
 #define SET_COLOR_COMPLETE       SET_CAIRO_COLOR(176, 226, 255)
 
-typedef enum {
-        START_ASSIGN,
-        END_ASSIGN
-} date_type;
-
-typedef struct {
-        date_type type;
-        mrptime time;
-        gint units;
-        MrpAssignment *assignment;
-        MrpTask *task;
-} Date;
-
-static gint
-usage_row_date_compare (gconstpointer date1,
-			 gconstpointer date2)
-{
-        const Date *a, *b;
-
-	a = date1;
-        b = date2;
-
-	if (a->time < b->time) {
-                return -1;
-        }
-	else if (a->time == b->time) {
-                if (a->type < b->type) {
-                        return -1;
-                }
-		else if (a->type == b->type) {
-                        return 0;
-                } else {
-                        return 1;
-                }
-        } else {
-                return 1;
-        }
-}
-
 typedef enum {
         ROW_MIDDLE = 0,
         ROW_START  = 1 << 0,
@@ -994,96 +1004,88 @@ usage_row_draw_resource (PlannerUsageRow *row,
                          gint             width,
                          gint             height)
 {
-        GList         *dates;
-        MrpResource   *resource;
-        MrpTask       *root;
-        MrpAssignment *assignment;
-        MrpTask       *task;
-        MrpProject    *project;
-        GList         *assignments;
-        GList         *a, *d;
-        Date          *date, *date0, *date1;
-        mrptime        work_start, finish, previous_time;
-        gint           units;
-        RowChunk       chunk;
+        MrpResource    *resource;
+        MrpTask        *root;
+        MrpProject     *project;
+        GArray         *profile;
+        MrpLoadSegment *segment;
+        MrpLoadSegment  idle;
+        mrptime         finish, previous_time;
+        RowChunk        chunk;
+        guint           i;
+        gint            units;
 
         resource = row->priv->resource;
 
-        dates = NULL;
-
 	project = mrp_object_get_project (MRP_OBJECT (resource));
 
-	assignments = mrp_resource_get_assignments (resource);
-        for (a = assignments; a; a = a->next) {
-                assignment = a->data;
-
-                task = mrp_assignment_get_task (assignment);
-                work_start = mrp_task_get_work_start (task);
-                finish = mrp_task_get_finish (task);
-
-		units = mrp_assignment_get_units (assignment);
-
-		date0 = g_new0 (Date, 1);
-                date0->type = START_ASSIGN;
-                date0->time = work_start;
-                date0->units = units;
-                date0->assignment = assignment;
-                date0->task = task;
-
-                date1 = g_new0 (Date, 1);
-                date1->type = END_ASSIGN;
-                date1->time = finish;
-                date1->units = units;
-                date1->assignment = assignment;
-                date1->task = task;
-                dates = g_list_insert_sorted (dates, date0, usage_row_date_compare);
-                dates = g_list_insert_sorted (dates, date1, usage_row_date_compare);
-        }
-
-        units = 0;
-        previous_time = mrp_project_get_project_start (project);
-
 	root = mrp_project_get_root_task (project);
 	finish = mrp_task_get_finish (root);
 
+	/* The profile is maintained by the resource, it's only rebuilt when
+	 * the assignments or their tasks change.
+	 */
+	profile = mrp_resource_get_load_profile (resource);
+
+        previous_time = mrp_project_get_project_start (project);
+
         chunk = ROW_START;
 
-        for (d = dates; d; d = d->next) {
-                date = d->data;
+        for (i = 0; i <= profile->len; i++) {
+		if (i < profile->len) {
+			segment = &g_array_index (profile, MrpLoadSegment, i);
+		} else {
+			/* Nothing assigned after the last segment. */
+			idle.start = previous_time;
+			idle.end = finish;
+			idle.units = 0;
+			segment = &idle;
+		}
 
-                if (date->time != previous_time) {
-                        if (date->time == finish) {
+		/* Nothing assigned before the first segment. */
+		if (i == 0 && segment->start != previous_time) {
+                        if (segment->start == finish) {
 				chunk |= ROW_END;
 			}
 
                         usage_row_draw_resource_ival (previous_time,
-                                                       date->time,
-                                                       units,
+                                                       segment->start,
+                                                       0,
                                                        chunk,
                                                        cr, item,
                                                        x, y, width, height);
 
                         chunk &= ~ROW_START;
-                        previous_time = date->time;
-                }
+                        previous_time = segment->start;
+		}
 
-                if (date->type == START_ASSIGN) {
-                        units += date->units;
-                } else {
-                        units -= date->units;
+                if (segment->end != previous_time && !(chunk & ROW_END)) {
+                        if (segment->end == finish || i == profile->len) {
+				chunk |= ROW_END;
+			}
+
+                        units = segment->units;
+
+			/* Overlaps outside working time are not shown as
+			 * overallocated.
+			 */
+			if (units > 100 &&
+			    !mrp_resource_is_overallocated (resource,
+							    previous_time,
+							    segment->end)) {
+				units = 100;
+			}
+
+                        usage_row_draw_resource_ival (previous_time,
+                                                       segment->end,
+                                                       units,
+                                                       chunk,
+                                                       cr, item,
+                                                       x, y, width, height);
+
+                        chunk &= ~ROW_START;
+                        previous_time = segment->end;
                 }
-                g_free (date);
-        }
-        g_list_free (dates);
-
-        if (!(chunk & ROW_END)) {
-		chunk |= ROW_END;
-                usage_row_draw_resource_ival (previous_time,
-                                               finish,
-                                               units,
-                                               chunk,
-                                               cr, item,
-                                               x, y, width, height);
         }
 }
 
@@ -1307,17 +1309,71 @@ usage_row_bounds (GnomeCanvasItem *item,
         }
 }
 
+static void
+usage_row_flush_changes (GPtrArray *rows, gpointer data)
+{
+        PlannerUsageRow *row;
+        guint            i;
+
+        for (i = 0; i < rows->len; i++) {
+                row = g_ptr_array_index (rows, i);
+
+                /* Disposed since it was queued. */
+                if (!row->priv || !recalc_bounds (row)) {
+                        continue;
+                }
+
+                usage_row_geometry_changed (row);
+                gnome_canvas_item_request_update (GNOME_CANVAS_ITEM (row));
+        }
+}
+
+/* Task, assignment and resource changes are collected per canvas and the
+ * affected rows recalculated once per frame.
+ */
+static void
+usage_row_queue_change (PlannerUsageRow *row)
+{
+        GnomeCanvas        *canvas;
+        PlannerChangeQueue *queue;
+        GPtrArray          *rows;
+
+        canvas = GNOME_CANVAS_ITEM (row)->canvas;
+        if (!canvas) {
+                rows = g_ptr_array_new ();
+                g_ptr_array_add (rows, row);
+                usage_row_flush_changes (rows, NULL);
+                g_ptr_array_free (rows, TRUE);
+                return;
+        }
+
+        queue = g_object_get_data (G_OBJECT (canvas), "planner-usage-row-changes");
+        if (!queue) {
+                queue = planner_change_queue_new (usage_row_flush_changes, NULL);
+                planner_change_queue_set_widget (queue, GTK_WIDGET (canvas));
+
+                g_object_set_data_full (G_OBJECT (canvas),
+                                        "planner-usage-row-changes",
+                                        queue,
+                                        (GDestroyNotify) planner_change_queue_free);
+        }
+
+        planner_change_queue_add (queue, row);
+}
+
 static void
 usage_row_resource_notify_cb (MrpResource      *resource,
 			       GParamSpec       *pspec,
                                PlannerUsageRow *row)
 {
-        if (!recalc_bounds (row)) {
-		return;
-	}
+        usage_row_queue_change (row);
+}
 
-        usage_row_geometry_changed (row);
-        gnome_canvas_item_request_update (GNOME_CANVAS_ITEM (row));
+static void
+usage_row_resource_overallocations_changed_cb (MrpResource     *resource,
+					       PlannerUsageRow *row)
+{
+        usage_row_queue_change (row);
 }
 
 static void
@@ -1329,15 +1385,10 @@ usage_row_resource_assignment_added_cb (MrpResource      *resource,
 
         task = mrp_assignment_get_task (assign);
 
-	g_signal_connect_object (assign,
-                                 "notify",
-                                 G_CALLBACK (usage_row_assignment_notify_cb),
-                                 row, 0);
-
-        g_signal_connect_object (task,
-                                 "notify",
-                                 G_CALLBACK (usage_row_task_notify_cb),
-                                 row, 0);
+        usage_row_connect (row, assign, "notify",
+                           G_CALLBACK (usage_row_assignment_notify_cb));
+        usage_row_connect (row, task, "notify",
+                           G_CALLBACK (usage_row_task_notify_cb));
         recalc_bounds (row);
         usage_row_geometry_changed (row);
         gnome_canvas_item_request_update (GNOME_CANVAS_ITEM (row));
@@ -1348,12 +1399,7 @@ usage_row_assignment_notify_cb (MrpAssignment    *assignment,
                                  GParamSpec       *pspec,
 				 PlannerUsageRow *row)
 {
-        if (!recalc_bounds (row)) {
-		return;
-	}
-
-        usage_row_geometry_changed (row);
-        gnome_canvas_item_request_update (GNOME_CANVAS_ITEM (row));
+        usage_row_queue_change (row);
 }
 
 static void
@@ -1371,12 +1417,7 @@ usage_row_task_notify_cb (MrpTask          *task,
                 row->priv->fixed_duration = FALSE;
         }
 
-        if (!recalc_bounds (row)) {
-		return;
-	}
-
-        usage_row_geometry_changed (row);
-        gnome_canvas_item_request_update (GNOME_CANVAS_ITEM (row));
+        usage_row_queue_change (row);
 }
 
 /* Returns the geometry of the actual bars, not the bounding box, not including
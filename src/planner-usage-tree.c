@@ -302,6 +302,35 @@ usage_tree_taskname_data_func (GtkTreeViewColumn *tree_column,
         g_free (name);
 }
 
+static void
+usage_tree_work_data_func (GtkTreeViewColumn *tree_column,
+			   GtkCellRenderer   *cell,
+			   GtkTreeModel      *tree_model,
+			   GtkTreeIter       *iter,
+			   gpointer           data)
+{
+	PlannerUsageTree *tree = data;
+	MrpAssignment    *assignment;
+	gint              work;
+	gchar            *str;
+
+	gtk_tree_model_get (tree_model, iter,
+			    COL_ASSIGNMENT, &assignment,
+			    COL_WORK, &work,
+			    -1);
+
+	/* Only resource rows show their total work. */
+	if (assignment) {
+		g_object_set (cell, "text", "", NULL);
+		g_object_unref (assignment);
+		return;
+	}
+
+	str = planner_format_duration (tree->priv->project, work);
+	g_object_set (cell, "text", str, NULL);
+	g_free (str);
+}
+
 /* Note: this is not ideal, it emits the signal as soon as the width is changed
  * during the resize. We should only emit it when the resizing is done.
  */
@@ -352,6 +381,21 @@ usage_tree_add_column (GtkTreeView *tree, gint column, const gchar *title)
                 gtk_tree_view_column_set_min_width (col, 100);
                 gtk_tree_view_append_column (tree, col);
                 break;
+        case COL_WORK:
+                cell = gtk_cell_renderer_text_new ();
+                g_object_set (cell, "editable", FALSE, "xalign", 1.0, NULL);
+                col = gtk_tree_view_column_new_with_attributes (title, cell,
+                                                                NULL);
+                gtk_tree_view_column_set_cell_data_func (col, cell,
+                                                         usage_tree_work_data_func,
+                                                         tree, NULL);
+                g_object_set_data (G_OBJECT (col), "data-func",
+                                   usage_tree_work_data_func);
+                g_object_set_data (G_OBJECT (col), "user-data", tree);
+		g_object_set_data (G_OBJECT (col), "id", "work");
+                gtk_tree_view_column_set_resizable (col, TRUE);
+                gtk_tree_view_append_column (tree, col);
+                break;
         case COL_RESOURCE:
         case COL_ASSIGNMENT:
         default:
@@ -389,6 +433,8 @@ planner_usage_tree_new (PlannerWindow      *main_window,
                                 _("\nName"));
         usage_tree_add_column (GTK_TREE_VIEW (tree), COL_TASKNAME,
                                 _("\nTask"));
+        usage_tree_add_column (GTK_TREE_VIEW (tree), COL_WORK,
+                                _("\nWork"));
 
         return GTK_WIDGET (tree);
 }
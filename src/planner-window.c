@@ -22,9 +22,19 @@
  */
 
 #include <config.h>
+#include <errno.h>
+#include <stdio.h>
 #include <string.h>
 #include <math.h>
+#ifdef G_OS_WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <signal.h>
+#include <unistd.h>
+#endif
 #include <glib/gi18n.h>
+#include <glib/gstdio.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gtk/gtk.h>
 #include <libplanner/mrp-error.h>
@@ -178,6 +188,9 @@ static GtkWidget *window_create_dialog_button            (const gchar
 							  const gchar                  *text);
 static void       window_recent_add_item                 (PlannerWindow                *window,
 							  const gchar                  *uri);
+static void       window_start_journal                   (PlannerWindow *window);
+static void       window_start_journal_file              (PlannerWindow *window,
+							  const gchar   *filename);
 static void       window_save_state                      (PlannerWindow *window);
 static void       window_restore_state                   (PlannerWindow *window);
 
@@ -868,6 +881,8 @@ window_open_cb (GtkAction *action,
 	filter = gtk_file_filter_new ();
 	gtk_file_filter_set_name (filter, _("Planner Files"));
 	gtk_file_filter_add_pattern (filter, "*.planner");
+	gtk_file_filter_add_pattern (filter, "*.planner.gz");
+	gtk_file_filter_add_pattern (filter, "*.planner.zst");
 	gtk_file_filter_add_pattern (filter, "*.mrproject");
 	gtk_file_chooser_add_filter (GTK_FILE_CHOOSER (file_chooser), filter);
 
@@ -1493,8 +1508,27 @@ window_do_save_as (PlannerWindow *window)
 	gtk_widget_destroy (file_chooser);
 
 	if (filename != NULL) {
-		gboolean  success;
-		GError   *error = NULL;
+		gboolean            success;
+		GError             *error = NULL;
+		MrpFileCompression  old_compression;
+
+		/* Compressed files are asked for by their extension. The old
+		 * setting is put back if the file isn't saved.
+		 */
+		old_compression = mrp_project_get_file_compression (priv->project);
+
+		if (g_str_has_suffix (filename, ".gz")) {
+			mrp_project_set_file_compression (priv->project,
+							  MRP_FILE_COMPRESSION_GZIP);
+		}
+		else if (g_str_has_suffix (filename, ".zst") &&
+			 mrp_file_compression_is_supported (MRP_FILE_COMPRESSION_ZSTD)) {
+			mrp_project_set_file_compression (priv->project,
+							  MRP_FILE_COMPRESSION_ZSTD);
+		} else {
+			mrp_project_set_file_compression (priv->project,
+							  MRP_FILE_COMPRESSION_NONE);
+		}
 
 		/* Save the file. */
 		success = mrp_project_save_as (window->priv->project, filename,
@@ -1516,6 +1550,8 @@ window_do_save_as (PlannerWindow *window)
 			ret = gtk_dialog_run (GTK_DIALOG (dialog));
 			gtk_widget_destroy (dialog);
 
+			g_clear_error (&error);
+
 			switch (ret) {
 			case GTK_RESPONSE_YES:
 				success = mrp_project_save_as (priv->project,
@@ -1525,6 +1561,9 @@ window_do_save_as (PlannerWindow *window)
 				break;
 			case GTK_RESPONSE_NO:
 			case GTK_RESPONSE_DELETE_EVENT:
+				mrp_project_set_file_compression (priv->project,
+								  old_compression);
+				g_free (filename);
 				return window_do_save_as (window);
 				break;
 			default:
@@ -1533,11 +1572,18 @@ window_do_save_as (PlannerWindow *window)
 		}
 
 		if (success) {
+			/* The journal follows the project to its new file. */
+			mrp_project_stop_journal (priv->project, TRUE);
+			window_start_journal (window);
+
 			/* Add the file to the recent list */
 			window_recent_add_item (window, mrp_project_get_uri (priv->project));
 		} else {
 			GtkWidget *dialog;
 
+			mrp_project_set_file_compression (priv->project,
+							  old_compression);
+
 			dialog = gtk_message_dialog_new (GTK_WINDOW (window),
 							 GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
 							 GTK_MESSAGE_ERROR,
@@ -1547,6 +1593,9 @@ window_do_save_as (PlannerWindow *window)
 			gtk_dialog_run (GTK_DIALOG (dialog));
 			gtk_widget_destroy (dialog);
 
+			g_error_free (error);
+			g_free (filename);
+
 			return FALSE;
 		}
 
@@ -1562,6 +1611,242 @@ window_do_save_as (PlannerWindow *window)
 	}
 }
 
+static gchar *
+window_get_journal_dir (void)
+{
+	gchar *dir;
+
+	dir = g_build_filename (g_get_user_cache_dir (), "planner", "journal", NULL);
+	g_mkdir_with_parents (dir, 0700);
+
+	return dir;
+}
+
+/* A name no other window uses: the process and a number within it. */
+static gchar *
+window_get_untitled_journal (void)
+{
+	static guint  serial;
+	gchar        *dir, *filename;
+
+	dir = window_get_journal_dir ();
+	filename = g_strdup_printf ("%s" G_DIR_SEPARATOR_S "untitled-%d-%u.journal",
+				    dir, (gint) getpid (), ++serial);
+	g_free (dir);
+
+	return filename;
+}
+
+/* Keeps the changes made since the last save in a journal in the cache
+ * directory, named after the project file. When Planner crashed before the
+ * project was saved, opening the project again replays them. A project that
+ * was never saved gets a journal named after the window instead, which is
+ * offered for recovery on the next start, see
+ * planner_window_recover_journals().
+ */
+static void
+window_start_journal (PlannerWindow *window)
+{
+	PlannerWindowPriv *priv;
+	const gchar       *uri;
+	gchar             *dir, *name, *filename;
+
+	priv = window->priv;
+
+	uri = mrp_project_get_uri (priv->project);
+	if (uri && strncmp (uri, "sql://", 6) == 0) {
+		return;
+	}
+
+	if (uri == NULL) {
+		filename = window_get_untitled_journal ();
+	} else {
+		dir = window_get_journal_dir ();
+		name = g_compute_checksum_for_string (G_CHECKSUM_MD5, uri, -1);
+		filename = g_strconcat (dir, G_DIR_SEPARATOR_S, name, ".journal", NULL);
+		g_free (name);
+		g_free (dir);
+	}
+
+	window_start_journal_file (window, filename);
+
+	g_free (filename);
+}
+
+static void
+window_start_journal_file (PlannerWindow *window, const gchar *filename)
+{
+	PlannerWindowPriv *priv;
+	GError            *error = NULL;
+	GtkWidget         *dialog;
+
+	priv = window->priv;
+
+	if (!mrp_project_start_journal (priv->project, filename, &error)) {
+		dialog = gtk_message_dialog_new (GTK_WINDOW (window),
+						 GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+						 GTK_MESSAGE_WARNING,
+						 GTK_BUTTONS_OK,
+						 _("Unsaved changes to this project could not be recovered."));
+		gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (dialog),
+							  "%s", error->message);
+		gtk_dialog_run (GTK_DIALOG (dialog));
+		gtk_widget_destroy (dialog);
+		g_error_free (error);
+
+		/* Start over rather than keep a journal that can't be used. */
+		g_remove (filename);
+		mrp_project_start_journal (priv->project, filename, NULL);
+	}
+}
+
+/* Whether the process that kept an untitled journal is gone. */
+static gboolean
+window_journal_is_left_behind (gint pid)
+{
+	if (pid == (gint) getpid ()) {
+		return FALSE;
+	}
+
+#ifdef G_OS_UNIX
+	return kill (pid, 0) != 0 && errno == ESRCH;
+#else
+	return TRUE;
+#endif
+}
+
+/* A journal with just its header has nothing to recover. */
+static gboolean
+window_journal_has_records (const gchar *filename)
+{
+	gchar    *contents, *end;
+	gsize     length;
+	gboolean  ret = FALSE;
+
+	if (!g_file_get_contents (filename, &contents, &length, NULL)) {
+		return FALSE;
+	}
+
+	end = memchr (contents, '\n', length);
+	if (end) {
+		end++;
+		ret = memchr (end, '\n', contents + length - end) != NULL;
+	}
+
+	g_free (contents);
+
+	return ret;
+}
+
+static void
+window_recover_journal (PlannerWindow *window, const gchar *filename)
+{
+	PlannerWindowPriv *priv;
+	GtkWidget         *dialog;
+	gchar             *untitled;
+	gint               ret;
+
+	dialog = gtk_message_dialog_new (GTK_WINDOW (window),
+					 GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+					 GTK_MESSAGE_QUESTION,
+					 GTK_BUTTONS_NONE,
+					 _("Recover the unsaved project?"));
+	gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (dialog),
+		_("Planner was closed before a new project was saved. Its changes can be recovered into a new window."));
+	gtk_dialog_add_buttons (GTK_DIALOG (dialog),
+				_("_Discard"), GTK_RESPONSE_NO,
+				_("_Recover"), GTK_RESPONSE_YES,
+				NULL);
+	gtk_dialog_set_default_response (GTK_DIALOG (dialog), GTK_RESPONSE_YES);
+
+	ret = gtk_dialog_run (GTK_DIALOG (dialog));
+	gtk_widget_destroy (dialog);
+
+	if (ret != GTK_RESPONSE_YES) {
+		if (ret == GTK_RESPONSE_NO) {
+			g_remove (filename);
+		}
+		return;
+	}
+
+	if (!mrp_project_is_empty (window->priv->project) ||
+	    mrp_project_get_uri (window->priv->project)) {
+		window = PLANNER_WINDOW (planner_application_new_window (window->priv->application));
+		gtk_widget_show_all (GTK_WIDGET (window));
+	}
+
+	priv = window->priv;
+
+	/* Take the journal over under the name of this window, so that
+	 * another Planner starting meanwhile leaves it alone.
+	 */
+	untitled = window_get_untitled_journal ();
+	mrp_project_stop_journal (priv->project, TRUE);
+
+	if (g_rename (filename, untitled) == 0) {
+		window_start_journal_file (window, untitled);
+	} else {
+		window_start_journal (window);
+	}
+
+	g_free (untitled);
+}
+
+/**
+ * planner_window_recover_journals:
+ * @window: a #PlannerWindow
+ *
+ * Offers to recover the changes to projects that were never saved, from the
+ * journals left behind by a Planner that is no longer running. A recovered
+ * project goes into @window if that is still empty, otherwise into a new
+ * window.
+ **/
+void
+planner_window_recover_journals (PlannerWindow *window)
+{
+	GDir        *gdir;
+	const gchar *entry;
+	gchar       *dir, *filename;
+	GList       *journals = NULL, *l;
+	gint         pid;
+	guint        serial;
+
+	g_return_if_fail (PLANNER_IS_WINDOW (window));
+
+	dir = window_get_journal_dir ();
+
+	gdir = g_dir_open (dir, 0, NULL);
+	if (!gdir) {
+		g_free (dir);
+		return;
+	}
+
+	while ((entry = g_dir_read_name (gdir))) {
+		if (sscanf (entry, "untitled-%d-%u.journal", &pid, &serial) != 2 ||
+		    !window_journal_is_left_behind (pid)) {
+			continue;
+		}
+
+		journals = g_list_prepend (journals,
+					   g_build_filename (dir, entry, NULL));
+	}
+
+	g_dir_close (gdir);
+
+	for (l = journals; l; l = l->next) {
+		filename = l->data;
+
+		if (window_journal_has_records (filename)) {
+			window_recover_journal (window, filename);
+		} else {
+			g_remove (filename);
+		}
+	}
+
+	g_list_free_full (journals, g_free);
+	g_free (dir);
+}
+
 static GtkWidget *
 window_create_dialog_button (const gchar *icon_name, const gchar *text)
 {
@@ -1605,6 +1890,8 @@ planner_window_new (PlannerApplication *application)
 
 	priv->project = mrp_project_new (MRP_APPLICATION (application));
 
+	planner_cmd_manager_set_project (priv->cmd_manager, priv->project);
+
 	priv->last_saved = g_timer_new ();
 
 	g_signal_connect (priv->project, "needs_saving_changed",
@@ -1624,6 +1911,8 @@ planner_window_new (PlannerApplication *application)
 	window_populate (window);
 	window_update_title (window);
 
+	window_start_journal (window);
+
 	return GTK_WIDGET (window);
 }
 
@@ -1641,6 +1930,7 @@ planner_window_open (PlannerWindow *window,
 
 	priv = window->priv;
 
+	/* Loading drops the journal kept for the untitled project. */
 	if (!mrp_project_load (priv->project, uri, &error)) {
 		dialog = gtk_message_dialog_new (
 			GTK_WINDOW (window),
@@ -1652,9 +1942,13 @@ planner_window_open (PlannerWindow *window,
 		gtk_dialog_run (GTK_DIALOG (dialog));
 		gtk_widget_destroy (dialog);
 
+		window_start_journal (window);
+
 		return FALSE;
 	}
 
+	window_start_journal (window);
+
 	planner_window_check_version (window);
 
 	if (!internal) {
@@ -1823,6 +2117,9 @@ planner_window_close (PlannerWindow *window)
 	}
 
         if (close) {
+		/* Saved or deliberately thrown away, nothing to recover. */
+		mrp_project_stop_journal (priv->project, TRUE);
+
 		window_save_state (window);
 
                 g_signal_emit (window, signals[CLOSED], 0, NULL);
@@ -61,6 +61,7 @@ GtkUIManager *      planner_window_get_ui_manager          (PlannerWindow      *
 MrpProject *        planner_window_get_project             (PlannerWindow      *window);
 PlannerApplication *planner_window_get_application         (PlannerWindow      *window);
 void                planner_window_check_version           (PlannerWindow      *window);
+void                planner_window_recover_journals        (PlannerWindow      *window);
 void                planner_window_close                   (PlannerWindow      *window);
 void                planner_window_show_day_type_dialog    (PlannerWindow      *window);
 void                planner_window_show_calendar_dialog    (PlannerWindow      *window);
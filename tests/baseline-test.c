@@ -0,0 +1,117 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+#include <config.h>
+#include <stdlib.h>
+#include "libplanner/mrp-project.h"
+#include "libplanner/mrp-relation.h"
+#include "self-check.h"
+
+#define DAY (60*60*8)
+
+gint
+main (gint argc, gchar **argv)
+{
+	MrpApplication      *app;
+	MrpProject          *project, *loaded;
+	MrpTask             *task_a, *task_b, *task_c;
+	MrpBaseline         *baseline, *scenario;
+	MrpBaselineVariance *variance;
+	GList               *variances;
+	mrptime              start_a, start_c, start;
+	gint                 work;
+	gchar               *str;
+
+	app = mrp_application_new ();
+	project = mrp_project_new (app);
+
+	g_object_set (project, "project_start", mrp_time_from_string ("20020218"), NULL);
+
+	task_a = add_task (project, NULL, "A", 2 * DAY);
+	task_b = add_task (project, NULL, "B", 3 * DAY);
+	task_c = add_task (project, NULL, "C", DAY);
+	mrp_task_add_predecessor (task_b, task_a, MRP_RELATION_FS, 0, NULL);
+
+	start_a = mrp_task_get_start (task_a);
+	start_c = mrp_task_get_start (task_c);
+
+	baseline = mrp_project_add_baseline (project, "Plan");
+
+	CHECK_POINTER_RESULT (mrp_project_get_baseline (project, "Plan"), baseline);
+	CHECK_BOOLEAN_RESULT (mrp_baseline_is_scenario (baseline), FALSE);
+	CHECK_INTEGER_RESULT (mrp_baseline_get_n_tasks (baseline), 3);
+	CHECK_BOOLEAN_RESULT (mrp_baseline_get_task (baseline, task_a, &start, NULL, NULL, &work), TRUE);
+	CHECK_INTEGER_RESULT (start, start_a);
+	CHECK_INTEGER_RESULT (work, 2 * DAY);
+
+	CHECK_POINTER_RESULT (mrp_project_get_variances (project, baseline), NULL);
+
+	/* Longer A pushes B, C does not move. */
+	g_object_set (task_a, "work", 3 * DAY, NULL);
+
+	variances = mrp_project_get_variances (project, baseline);
+	CHECK_INTEGER_RESULT (g_list_length (variances), 2);
+
+	variance = variances->data;
+	CHECK_POINTER_RESULT (variance->task, task_a);
+	CHECK_INTEGER_RESULT (variance->start_variance, 0);
+	CHECK_BOOLEAN_RESULT (variance->finish_variance > 0, TRUE);
+	CHECK_INTEGER_RESULT (variance->work_variance, DAY);
+
+	variance = variances->next->data;
+	CHECK_POINTER_RESULT (variance->task, task_b);
+	CHECK_BOOLEAN_RESULT (variance->start_variance > 0, TRUE);
+
+	g_list_free_full (variances, g_free);
+
+	/* Changing a scenario leaves the baseline it came from alone. */
+	scenario = mrp_project_add_scenario (project, "What if", baseline);
+	CHECK_BOOLEAN_RESULT (mrp_baseline_is_scenario (scenario), TRUE);
+
+	mrp_baseline_set_task (scenario, task_c, start_c + 24 * 60 * 60,
+			       start_c + 2 * 24 * 60 * 60, DAY, DAY);
+
+	CHECK_BOOLEAN_RESULT (mrp_baseline_get_task (scenario, task_c, &start, NULL, NULL, NULL), TRUE);
+	CHECK_INTEGER_RESULT (start, start_c + 24 * 60 * 60);
+	CHECK_BOOLEAN_RESULT (mrp_baseline_get_task (baseline, task_c, &start, NULL, NULL, NULL), TRUE);
+	CHECK_INTEGER_RESULT (start, start_c);
+
+	variances = mrp_project_get_variances (project, scenario);
+	CHECK_INTEGER_RESULT (g_list_length (variances), 3);
+	g_list_free_full (variances, g_free);
+
+	/* Baselines are saved and loaded with the project. */
+	CHECK_BOOLEAN_RESULT (mrp_project_save_to_xml (project, &str, NULL), TRUE);
+
+	loaded = mrp_project_new (app);
+	CHECK_BOOLEAN_RESULT (mrp_project_load_from_xml (loaded, str, NULL), TRUE);
+	g_free (str);
+
+	CHECK_INTEGER_RESULT (g_list_length (mrp_project_get_baselines (loaded)), 2);
+
+	baseline = mrp_project_get_baseline (loaded, "Plan");
+	CHECK_BOOLEAN_RESULT (baseline != NULL, TRUE);
+	CHECK_INTEGER_RESULT (mrp_baseline_get_n_tasks (baseline), 3);
+	CHECK_BOOLEAN_RESULT (mrp_baseline_get_task (baseline,
+						     mrp_project_get_task_by_name (loaded, "A"),
+						     &start, NULL, NULL, &work), TRUE);
+	CHECK_INTEGER_RESULT (start, start_a);
+	CHECK_INTEGER_RESULT (work, 2 * DAY);
+
+	scenario = mrp_project_get_baseline (loaded, "What if");
+	CHECK_BOOLEAN_RESULT (scenario != NULL, TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_baseline_is_scenario (scenario), TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_baseline_get_task (scenario,
+						     mrp_project_get_task_by_name (loaded, "C"),
+						     &start, NULL, NULL, NULL), TRUE);
+	CHECK_INTEGER_RESULT (start, start_c + 24 * 60 * 60);
+
+	mrp_project_remove_baseline (loaded, scenario);
+	CHECK_POINTER_RESULT (mrp_project_get_baseline (loaded, "What if"), NULL);
+
+	g_object_unref (loaded);
+	g_object_unref (project);
+
+
+	g_object_unref (app);
+
+	return EXIT_SUCCESS;
+}
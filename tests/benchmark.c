@@ -0,0 +1,893 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib/gstdio.h>
+#include "libplanner/mrp-project.h"
+#include "libplanner/mrp-relation.h"
+#include "libplanner/mrp-resource.h"
+#include "libplanner/mrp-risk.h"
+#include "src/planner-gantt-model.h"
+#ifndef G_OS_WIN32
+#include <unistd.h>
+#endif
+#include "self-check.h"
+
+/* Timing runs on large generated plans, kept out of the unit tests. Nothing
+ * is run unless PLANNER_BENCHMARK is set, so "meson test --benchmark" skips
+ * it otherwise. Pass the names of the runs to do only those, all of them are
+ * done by default.
+ *
+ * PLANNER_BENCHMARK_SQL_URI selects the database of the SQL run, for example
+ * "sql://localhost#db=scratch". Without an id in it a project is generated
+ * and saved there first. tools/sql_load_benchmark.sh sets it all up.
+ */
+#define SKIP          77
+#define DAY           (60*60*8)
+#define N_CHAINS      20
+#define SQL_TASKS     2000
+#define SQL_RESOURCES 50
+#define SQL_LOAD_RUNS 5
+
+extern gchar *get_wbs_from_task (MrpTask *task);
+
+static MrpProject *
+new_project (MrpApplication *app)
+{
+	MrpProject *project;
+
+	project = mrp_project_new (app);
+	g_object_set (project, "project_start", mrp_time_from_string ("20020218"), NULL);
+
+	return project;
+}
+
+static MrpResource **
+add_resources (MrpProject *project, gint n_resources)
+{
+	MrpResource **resources;
+	gint          i;
+
+	resources = g_new (MrpResource *, n_resources);
+
+	for (i = 0; i < n_resources; i++) {
+		resources[i] = g_object_new (MRP_TYPE_RESOURCE, "name", "R", "cost", 10.0, NULL);
+		mrp_project_add_resource (project, resources[i]);
+	}
+
+	return resources;
+}
+
+static void
+add_property (MrpProject *project, const gchar *name)
+{
+	mrp_project_add_property (project,
+				  MRP_TYPE_TASK,
+				  mrp_property_new (name,
+						    MRP_PROPERTY_TYPE_DURATION,
+						    name, "", TRUE),
+				  TRUE);
+}
+
+static void
+benchmark_risk (MrpApplication *app)
+{
+	const gint       n_tasks = 2000, n_iterations = 2000;
+	MrpProject      *project;
+	MrpTask        **tasks;
+	MrpTask         *summary = NULL;
+	MrpRiskAnalysis *analysis;
+	GTimer          *timer;
+	gint             i;
+
+	project = new_project (app);
+
+	add_property (project, MRP_RISK_PROPERTY_OPTIMISTIC);
+	add_property (project, MRP_RISK_PROPERTY_PESSIMISTIC);
+
+	tasks = g_new (MrpTask *, n_tasks);
+
+	mrp_project_set_block_scheduling (project, TRUE);
+
+	for (i = 0; i < n_tasks; i++) {
+		if (i % 10 == 0) {
+			summary = add_task (project, NULL, "S", 0);
+		}
+
+		tasks[i] = add_task (project, summary, "T", DAY * (1 + i % 4));
+		mrp_object_set (tasks[i],
+				MRP_RISK_PROPERTY_OPTIMISTIC, DAY / 2,
+				MRP_RISK_PROPERTY_PESSIMISTIC, DAY * (2 + i % 7),
+				NULL);
+
+		if (i >= N_CHAINS + 2) {
+			mrp_task_add_predecessor (tasks[i], tasks[i - N_CHAINS - i % 3],
+						  MRP_RELATION_FS, 0, NULL);
+		}
+	}
+
+	mrp_project_set_block_scheduling (project, FALSE);
+
+	timer = g_timer_new ();
+
+	analysis = mrp_risk_analysis_new (project);
+
+	g_print ("risk: snapshot of %d tasks: %.3f s\n",
+		 n_tasks, g_timer_elapsed (timer, NULL));
+
+	g_timer_start (timer);
+
+	mrp_risk_analysis_run (analysis, n_iterations, 1);
+
+	g_print ("risk: ran %d iterations: %.3f s\n",
+		 n_iterations, g_timer_elapsed (timer, NULL));
+
+	CHECK_BOOLEAN_RESULT (mrp_risk_analysis_get_finish_percentile (analysis, 90) >=
+			      mrp_risk_analysis_get_finish_percentile (analysis, 10), TRUE);
+
+	g_timer_destroy (timer);
+	mrp_risk_analysis_free (analysis);
+	g_free (tasks);
+	g_object_unref (project);
+}
+
+static void
+benchmark_rollup (MrpApplication *app)
+{
+	const gint    n_tasks = 50000, depth = 100, n_updates = 1000;
+	MrpProject   *project;
+	MrpResource **resources;
+	MrpTask     **summaries;
+	MrpTask      *parent = NULL;
+	MrpTask      *deepest = NULL;
+	MrpTask      *root;
+	GTimer       *timer;
+	gint          i;
+
+	project = new_project (app);
+	mrp_project_set_status_date (project, mrp_time_from_string ("20100101"));
+
+	resources = add_resources (project, 1);
+	summaries = g_new (MrpTask *, depth);
+
+	mrp_project_set_block_scheduling (project, TRUE);
+
+	for (i = 0; i < depth; i++) {
+		parent = add_task (project, parent, "S", 0);
+		summaries[i] = parent;
+	}
+
+	for (i = 0; i < n_tasks; i++) {
+		parent = add_task (project, summaries[i % depth], "T", DAY);
+		mrp_resource_assign (resources[0], parent, 100);
+
+		if (i == depth - 1) {
+			deepest = parent;
+		}
+	}
+
+	mrp_project_set_block_scheduling (project, FALSE);
+
+	root = mrp_project_get_root_task (project);
+
+	CHECK_BOOLEAN_RESULT (mrp_task_get_cost (root) == 80.0 * n_tasks, TRUE);
+
+	timer = g_timer_new ();
+
+	/* Each update only touches the ancestors of the task. */
+	for (i = 0; i < n_updates; i++) {
+		g_object_set (deepest, "percent_complete", i % 2 ? 100 : 0, NULL);
+	}
+
+	g_print ("rollup: %d progress updates at depth %d of %d tasks: %.3f s\n",
+		 n_updates, depth, n_tasks, g_timer_elapsed (timer, NULL));
+
+	CHECK_BOOLEAN_RESULT (mrp_task_get_earned_value (root) == 80, TRUE);
+
+	g_timer_start (timer);
+
+	mrp_project_set_status_date (project, mrp_project_get_project_start (project));
+
+	g_print ("rollup: moving the status date: %.3f s\n", g_timer_elapsed (timer, NULL));
+
+	CHECK_BOOLEAN_RESULT (mrp_task_get_planned_value (root) == 0, TRUE);
+
+	g_timer_destroy (timer);
+	g_free (summaries);
+	g_free (resources);
+	g_object_unref (project);
+}
+
+static void
+benchmark_timephase (MrpApplication *app)
+{
+	const gint    n_tasks = 10000, n_resources = 50;
+	MrpProject   *project;
+	MrpTask     **tasks;
+	MrpTask      *summary = NULL;
+	MrpResource **resources;
+	GTimer       *timer;
+	mrptime       start, finish;
+	gint          i;
+
+	project = new_project (app);
+
+	tasks = g_new (MrpTask *, n_tasks);
+	resources = add_resources (project, n_resources);
+
+	mrp_project_set_block_scheduling (project, TRUE);
+
+	for (i = 0; i < n_tasks; i++) {
+		if (i % 10 == 0) {
+			summary = add_task (project, NULL, "S", 0);
+		}
+
+		tasks[i] = add_task (project, summary, "T", DAY * (1 + i % 3));
+		mrp_resource_assign (resources[i % n_resources], tasks[i], 100);
+
+		if (i >= N_CHAINS) {
+			mrp_task_add_predecessor (tasks[i], tasks[i - N_CHAINS],
+						  MRP_RELATION_FS, 0, NULL);
+		}
+	}
+
+	mrp_project_set_block_scheduling (project, FALSE);
+
+	start = mrp_project_get_project_start (project);
+	finish = mrp_task_get_finish (mrp_project_get_root_task (project));
+
+	timer = g_timer_new ();
+
+	g_array_free (mrp_project_get_resource_timephase (project, resources[0],
+							  MRP_TIME_UNIT_WEEK,
+							  start, finish), TRUE);
+
+	g_print ("timephase: first query of %d tasks: %.3f s\n",
+		 n_tasks, g_timer_elapsed (timer, NULL));
+
+	g_timer_start (timer);
+
+	for (i = 0; i < n_resources; i++) {
+		g_array_free (mrp_project_get_resource_timephase (project, resources[i],
+								  MRP_TIME_UNIT_MONTH,
+								  start, finish), TRUE);
+	}
+
+	g_print ("timephase: monthly buckets of %d resources: %.3f s\n",
+		 n_resources, g_timer_elapsed (timer, NULL));
+
+	/* Only the tasks that moved are added again. */
+	g_object_set (tasks[n_tasks - 1], "work", 4 * DAY, NULL);
+
+	g_timer_start (timer);
+
+	g_array_free (mrp_project_get_resource_timephase (project, resources[0],
+							  MRP_TIME_UNIT_WEEK,
+							  start, finish), TRUE);
+
+	g_print ("timephase: query after changing one task: %.3f s\n",
+		 g_timer_elapsed (timer, NULL));
+
+	g_timer_destroy (timer);
+	g_free (resources);
+	g_free (tasks);
+	g_object_unref (project);
+}
+
+static void
+benchmark_overallocation (MrpApplication *app)
+{
+	const gint    n_tasks = 20000, n_resources = 500, n_chains = 40;
+	MrpProject   *project;
+	MrpTask     **tasks;
+	MrpResource **resources;
+	GTimer       *timer;
+	guint         n_periods = 0;
+	gint          i;
+
+	project = new_project (app);
+
+	tasks = g_new (MrpTask *, n_tasks);
+	resources = add_resources (project, n_resources);
+
+	mrp_project_set_block_scheduling (project, TRUE);
+
+	/* Every resource works on two chains, so the chains overlap. */
+	for (i = 0; i < n_tasks; i++) {
+		tasks[i] = add_task (project, NULL, "T", DAY * (1 + i % 3));
+		mrp_resource_assign (resources[i % n_resources], tasks[i], 100);
+
+		if (i >= n_chains) {
+			mrp_task_add_predecessor (tasks[i], tasks[i - n_chains],
+						  MRP_RELATION_FS, 0, NULL);
+		}
+	}
+
+	mrp_project_set_block_scheduling (project, FALSE);
+
+	timer = g_timer_new ();
+
+	g_object_set (tasks[0], "work", 2 * DAY, NULL);
+
+	g_print ("overallocation: rescheduling %d tasks, not watched: %.3f s\n",
+		 n_tasks, g_timer_elapsed (timer, NULL));
+
+	g_timer_start (timer);
+
+	for (i = 0; i < n_resources; i++) {
+		n_periods += mrp_resource_get_overallocated_periods (resources[i])->len;
+	}
+
+	g_print ("overallocation: indexing %d resources, %u periods: %.3f s\n",
+		 n_resources, n_periods, g_timer_elapsed (timer, NULL));
+
+	g_timer_start (timer);
+
+	g_object_set (tasks[0], "work", DAY, NULL);
+
+	g_print ("overallocation: rescheduling %d tasks, watched: %.3f s\n",
+		 n_tasks, g_timer_elapsed (timer, NULL));
+
+	CHECK_BOOLEAN_RESULT (n_periods > 0, TRUE);
+
+	g_timer_destroy (timer);
+	g_free (resources);
+	g_free (tasks);
+	g_object_unref (project);
+}
+
+static void
+benchmark_leveling (MrpApplication *app)
+{
+	const gint    n_tasks = 2000, n_resources = 50;
+	MrpProject   *project;
+	MrpTask      *summary = NULL;
+	MrpTask     **tasks;
+	MrpResource **resources;
+	GList        *delays;
+	GTimer       *timer;
+	gint          n_delays;
+	gint          i;
+
+	project = new_project (app);
+
+	tasks = g_new (MrpTask *, n_tasks);
+	resources = add_resources (project, n_resources);
+
+	mrp_project_set_block_scheduling (project, TRUE);
+
+	/* Chains of tasks under summaries of ten, each on one or two
+	 * resources, with mixed priorities and units.
+	 */
+	for (i = 0; i < n_tasks; i++) {
+		if (i % 10 == 0) {
+			summary = add_task (project, NULL, "S", 0);
+		}
+
+		tasks[i] = add_task (project, summary, "T", DAY * (1 + i % 3));
+		g_object_set (tasks[i], "priority", (i * 7) % 5, NULL);
+
+		mrp_resource_assign (resources[i % n_resources], tasks[i], 100);
+		if (i % 4 == 0) {
+			mrp_resource_assign (resources[(i * 3 + 1) % n_resources], tasks[i], 50);
+		}
+
+		if (i >= N_CHAINS) {
+			mrp_task_add_predecessor (tasks[i], tasks[i - N_CHAINS],
+						  MRP_RELATION_FS, 0, NULL);
+		}
+	}
+
+	mrp_project_set_block_scheduling (project, FALSE);
+
+	timer = g_timer_new ();
+
+	delays = mrp_project_get_leveling_delays (project);
+	n_delays = g_list_length (delays);
+	g_list_free_full (delays, g_free);
+
+	g_print ("leveling: %d tasks on %d resources, %d delays: %.3f s\n",
+		 n_tasks, n_resources, n_delays, g_timer_elapsed (timer, NULL));
+
+	CHECK_BOOLEAN_RESULT (n_delays > 0, TRUE);
+
+	g_timer_start (timer);
+
+	CHECK_INTEGER_RESULT (mrp_project_level_resources (project), n_delays);
+
+	g_print ("leveling: applied the delays and rescheduled: %.3f s\n",
+		 g_timer_elapsed (timer, NULL));
+
+	g_timer_destroy (timer);
+	g_free (resources);
+	g_free (tasks);
+	g_object_unref (project);
+}
+
+static void
+benchmark_baseline (MrpApplication *app)
+{
+	const gint   n_tasks = 10000;
+	MrpProject  *project;
+	MrpTask    **tasks;
+	MrpBaseline *baseline;
+	GList       *variances;
+	GTimer      *timer;
+	gint         i;
+
+	project = new_project (app);
+
+	tasks = g_new (MrpTask *, n_tasks);
+
+	mrp_project_set_block_scheduling (project, TRUE);
+
+	for (i = 0; i < n_tasks; i++) {
+		tasks[i] = add_task (project, NULL, "T", DAY * (1 + i % 3));
+	}
+
+	mrp_project_set_block_scheduling (project, FALSE);
+
+	timer = g_timer_new ();
+
+	baseline = mrp_project_add_baseline (project, "First");
+
+	g_print ("baseline: first baseline of %d tasks: %.3f s\n",
+		 n_tasks, g_timer_elapsed (timer, NULL));
+
+	CHECK_INTEGER_RESULT (mrp_baseline_get_n_tasks (baseline), n_tasks);
+
+	/* Change one task, the second baseline shares all other blocks. */
+	g_object_set (tasks[n_tasks / 2], "work", 10 * DAY, NULL);
+
+	g_timer_start (timer);
+
+	mrp_project_add_baseline (project, "Second");
+
+	g_print ("baseline: second baseline: %.3f s\n", g_timer_elapsed (timer, NULL));
+
+	g_timer_start (timer);
+
+	variances = mrp_project_get_variances (project, baseline);
+
+	g_print ("baseline: variances against the first baseline: %.3f s\n",
+		 g_timer_elapsed (timer, NULL));
+
+	CHECK_INTEGER_RESULT (g_list_length (variances), 1);
+
+	g_list_free_full (variances, g_free);
+	g_timer_destroy (timer);
+	g_free (tasks);
+	g_object_unref (project);
+}
+
+static void
+benchmark_journal (MrpApplication *app)
+{
+	const gint  n_edits = 100000;
+	MrpProject *project;
+	MrpTask    *task;
+	GTimer     *timer;
+	gchar      *dir, *filename;
+	gchar       note[32];
+	gdouble     elapsed;
+	gint        i;
+
+	dir = g_dir_make_tmp ("benchmark-XXXXXX", NULL);
+	filename = g_build_filename (dir, "benchmark.journal", NULL);
+
+	project = new_project (app);
+	task = add_task (project, NULL, "T", DAY);
+
+	CHECK_BOOLEAN_RESULT (mrp_project_start_journal (project, filename, NULL), TRUE);
+
+	timer = g_timer_new ();
+
+	for (i = 0; i < n_edits; i++) {
+		g_snprintf (note, sizeof (note), "Note %d", i);
+		g_object_set (task, "note", note, NULL);
+	}
+
+	elapsed = g_timer_elapsed (timer, NULL);
+
+	g_print ("journal: %d journaled edits: %.3f s, %.2f us per edit\n",
+		 n_edits, elapsed, 1e6 * elapsed / n_edits);
+
+	mrp_project_stop_journal (project, TRUE);
+	g_rmdir (dir);
+
+	g_timer_destroy (timer);
+	g_object_unref (project);
+	g_free (filename);
+	g_free (dir);
+}
+
+static void
+benchmark_compression (MrpApplication *app)
+{
+	static const gchar *names[] = { "plain", "gzip", "zstd" };
+	const gint          n_tasks = 20000, n_resources = 50;
+	MrpProject         *project, *loaded;
+	MrpResource       **resources;
+	MrpTask            *summary = NULL;
+	MrpTask            *task, *prev = NULL;
+	MrpFileCompression  compression;
+	GTimer             *timer;
+	GStatBuf            buf;
+	gchar              *dir, *filename, *name;
+	gdouble             save_time, load_time;
+	gint                i;
+
+	project = new_project (app);
+	resources = add_resources (project, n_resources);
+
+	mrp_project_set_block_scheduling (project, TRUE);
+
+	for (i = 0; i < n_tasks; i++) {
+		if (i % 10 == 0) {
+			summary = add_task (project, NULL, "Phase", 0);
+		}
+
+		name = g_strdup_printf ("Task %d", i);
+		task = add_task (project, summary, name, DAY * (1 + i % 3));
+		g_free (name);
+
+		mrp_resource_assign (resources[i % n_resources], task, 100);
+
+		if (prev) {
+			mrp_task_add_predecessor (task, prev, MRP_RELATION_FS, 0, NULL);
+		}
+		prev = task;
+	}
+
+	mrp_project_set_block_scheduling (project, FALSE);
+
+	dir = g_dir_make_tmp ("benchmark-XXXXXX", NULL);
+	timer = g_timer_new ();
+
+	for (compression = MRP_FILE_COMPRESSION_NONE;
+	     compression <= MRP_FILE_COMPRESSION_ZSTD;
+	     compression++) {
+		if (!mrp_file_compression_is_supported (compression)) {
+			g_print ("compression: %s not supported\n", names[compression]);
+			continue;
+		}
+
+		filename = g_strdup_printf ("%s/project-%s.planner", dir, names[compression]);
+
+		mrp_project_set_file_compression (project, compression);
+
+		g_timer_start (timer);
+		CHECK_BOOLEAN_RESULT (mrp_project_save_as (project, filename, TRUE, NULL), TRUE);
+		save_time = g_timer_elapsed (timer, NULL);
+
+		loaded = mrp_project_new (app);
+
+		g_timer_start (timer);
+		CHECK_BOOLEAN_RESULT (mrp_project_load (loaded, filename, NULL), TRUE);
+		load_time = g_timer_elapsed (timer, NULL);
+
+		g_object_unref (loaded);
+
+		if (g_stat (filename, &buf) == 0) {
+			g_print ("compression: %s, %d tasks, %.1f kB, save %.3f s, load %.3f s\n",
+				 names[compression], n_tasks, buf.st_size / 1024.0,
+				 save_time, load_time);
+		}
+
+		g_remove (filename);
+		g_free (filename);
+	}
+
+	g_rmdir (dir);
+
+	g_timer_destroy (timer);
+	g_free (dir);
+	g_free (resources);
+	g_object_unref (project);
+}
+
+/* The resident set size in bytes, or 0 where /proc isn't there. */
+static gsize
+get_resident_size (void)
+{
+#ifdef G_OS_WIN32
+	return 0;
+#else
+	gchar *contents;
+	gulong size = 0, resident = 0;
+
+	if (!g_file_get_contents ("/proc/self/statm", &contents, NULL, NULL)) {
+		return 0;
+	}
+
+	sscanf (contents, "%lu %lu", &size, &resident);
+	g_free (contents);
+
+	return resident * sysconf (_SC_PAGESIZE);
+#endif
+}
+
+static void
+benchmark_text (MrpApplication *app)
+{
+	const gint   n_tasks = 100000, n_names = 100;
+	MrpProject  *project;
+	MrpTask     *summary = NULL;
+	MrpTask     *task;
+	GTimer      *timer;
+	gchar      **names;
+	gsize        before, after;
+	gint         i;
+
+	names = g_new (gchar *, n_names);
+	for (i = 0; i < n_names; i++) {
+		names[i] = g_strdup_printf ("Review the design of part %d", i);
+	}
+
+	project = new_project (app);
+
+	mrp_project_set_block_scheduling (project, TRUE);
+
+	before = get_resident_size ();
+	timer = g_timer_new ();
+
+	/* Most notes are empty, names repeat. */
+	for (i = 0; i < n_tasks; i++) {
+		if (i % 10 == 0) {
+			summary = add_task (project, NULL, "Phase", 0);
+		}
+
+		task = add_task (project, summary, names[i % n_names], DAY);
+		if (i % 20 == 0) {
+			g_object_set (task, "note", "Check with the customer", NULL);
+		}
+	}
+
+	g_print ("text: creating %d tasks with %d names: %.3f s\n",
+		 n_tasks, n_names, g_timer_elapsed (timer, NULL));
+
+	after = get_resident_size ();
+	if (after > before) {
+		g_print ("text: resident memory %.1f MB, %.0f bytes per task\n",
+			 (after - before) / (1024.0 * 1024.0),
+			 (gdouble) (after - before) / n_tasks);
+	}
+
+	mrp_project_set_block_scheduling (project, FALSE);
+
+	CHECK_STRING_RESULT ((char *) mrp_task_get_name (summary), "Phase");
+
+	g_timer_destroy (timer);
+	g_object_unref (project);
+
+	for (i = 0; i < n_names; i++) {
+		g_free (names[i]);
+	}
+	g_free (names);
+}
+
+static void
+benchmark_gantt_model (MrpApplication *app)
+{
+	const gint         n_summaries = 200, n_children = 20, n_moves = 1000;
+	MrpProject        *project;
+	PlannerGanttModel *model;
+	MrpTask          **summaries;
+	MrpTask           *task, *parent;
+	GList             *tasks, *l;
+	GtkTreePath       *path;
+	GTimer            *timer;
+	gint               i, j;
+
+	project = mrp_project_new (app);
+	model = planner_gantt_model_new (project);
+
+	summaries = g_new (MrpTask *, n_summaries);
+
+	timer = g_timer_new ();
+
+	/* Insert at the front, so that every insert shifts the siblings. */
+	for (i = 0; i < n_summaries; i++) {
+		summaries[i] = g_object_new (MRP_TYPE_TASK, "name", "S", NULL);
+		mrp_project_insert_task (project, NULL, 0, summaries[i]);
+
+		for (j = 0; j < n_children; j++) {
+			task = g_object_new (MRP_TYPE_TASK, "name", "T", NULL);
+			mrp_project_insert_task (project, summaries[i], 0, task);
+		}
+	}
+
+	g_print ("gantt-model: inserted %d tasks: %.3f s\n",
+		 n_summaries * (n_children + 1), g_timer_elapsed (timer, NULL));
+
+	g_timer_start (timer);
+
+	/* Move leaves between summaries. */
+	for (i = 0; i < n_moves; i++) {
+		task = mrp_task_get_first_child (summaries[i % n_summaries]);
+		parent = summaries[(i * 7 + 3) % n_summaries];
+
+		if (task && parent != mrp_task_get_parent (task)) {
+			CHECK_BOOLEAN_RESULT (mrp_project_move_task (project, task, NULL,
+								     parent, TRUE, NULL), TRUE);
+		}
+	}
+
+	g_print ("gantt-model: moved %d tasks: %.3f s\n",
+		 n_moves, g_timer_elapsed (timer, NULL));
+
+	g_timer_start (timer);
+
+	tasks = mrp_project_get_all_tasks (project);
+	for (l = tasks; l; l = l->next) {
+		path = planner_gantt_model_get_path_from_task (model, l->data);
+		gtk_tree_path_free (path);
+		g_free (get_wbs_from_task (l->data));
+	}
+	g_list_free (tasks);
+
+	g_print ("gantt-model: all paths and WBS: %.3f s\n",
+		 g_timer_elapsed (timer, NULL));
+
+	g_timer_destroy (timer);
+	g_free (summaries);
+	g_object_unref (model);
+	g_object_unref (project);
+}
+
+/* Saves a plan of SQL_TASKS chained tasks to @uri, returns the URI with the
+ * id of the new project.
+ */
+static gchar *
+benchmark_sql_save (MrpApplication *app, const gchar *uri)
+{
+	MrpProject   *project;
+	MrpTask      *task, *previous = NULL;
+	MrpResource **resources;
+	GError       *error = NULL;
+	gchar        *saved_uri;
+	gint          i;
+
+	project = new_project (app);
+	resources = add_resources (project, SQL_RESOURCES);
+
+	mrp_project_set_block_scheduling (project, TRUE);
+
+	for (i = 0; i < SQL_TASKS; i++) {
+		task = add_task (project, NULL, "T", DAY * (1 + i % 4));
+		mrp_resource_assign (resources[i % SQL_RESOURCES], task, 100);
+
+		if (previous) {
+			mrp_task_add_predecessor (task, previous,
+						  MRP_RELATION_FS, 0, NULL);
+		}
+		previous = task;
+	}
+
+	mrp_project_set_block_scheduling (project, FALSE);
+
+	if (!mrp_project_save_as (project, uri, FALSE, &error)) {
+		g_printerr ("Could not save to %s: %s\n", uri, error->message);
+		exit (EXIT_FAILURE);
+	}
+
+	saved_uri = g_strdup (mrp_project_get_uri (project));
+
+	g_free (resources);
+	g_object_unref (project);
+
+	return saved_uri;
+}
+
+static void
+benchmark_sql_load (MrpApplication *app)
+{
+	MrpProject  *project;
+	GTimer      *timer;
+	GError      *error = NULL;
+	const gchar *sql_uri;
+	gchar       *uri;
+	gdouble      elapsed, best = 0;
+	GList       *tasks;
+	gint         i;
+
+	sql_uri = g_getenv ("PLANNER_BENCHMARK_SQL_URI");
+	if (!sql_uri) {
+		return;
+	}
+
+	if (strstr (sql_uri, "id=")) {
+		uri = g_strdup (sql_uri);
+	} else {
+		uri = benchmark_sql_save (app, sql_uri);
+	}
+
+	timer = g_timer_new ();
+
+	for (i = 0; i < SQL_LOAD_RUNS; i++) {
+		project = mrp_project_new (app);
+
+		g_timer_start (timer);
+
+		if (!mrp_project_load (project, uri, &error)) {
+			g_printerr ("Could not load %s: %s\n", uri, error->message);
+			exit (EXIT_FAILURE);
+		}
+
+		elapsed = g_timer_elapsed (timer, NULL);
+		if (i == 0 || elapsed < best) {
+			best = elapsed;
+		}
+
+		tasks = mrp_project_get_all_tasks (project);
+		g_print ("sql-load: loaded %d tasks: %.3f s\n",
+			 g_list_length (tasks), elapsed);
+		g_list_free (tasks);
+
+		g_object_unref (project);
+	}
+
+	g_print ("sql-load: best of %d loads: %.3f s\n", SQL_LOAD_RUNS, best);
+
+	g_timer_destroy (timer);
+	g_free (uri);
+}
+
+static const struct {
+	const gchar *name;
+	void       (*run) (MrpApplication *app);
+} benchmarks[] = {
+	{ "risk",           benchmark_risk },
+	{ "rollup",         benchmark_rollup },
+	{ "timephase",      benchmark_timephase },
+	{ "overallocation", benchmark_overallocation },
+	{ "leveling",       benchmark_leveling },
+	{ "baseline",       benchmark_baseline },
+	{ "journal",        benchmark_journal },
+	{ "compression",    benchmark_compression },
+	{ "text",           benchmark_text },
+	{ "gantt-model",    benchmark_gantt_model },
+	{ "sql-load",       benchmark_sql_load },
+};
+
+static gboolean
+is_selected (gint argc, gchar **argv, const gchar *name)
+{
+	gint i;
+
+	if (argc < 2) {
+		return TRUE;
+	}
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp (argv[i], name) == 0) {
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+	MrpApplication *app;
+	guint           i;
+
+	if (!g_getenv ("PLANNER_BENCHMARK")) {
+		return SKIP;
+	}
+
+	app = mrp_application_new ();
+
+	for (i = 0; i < G_N_ELEMENTS (benchmarks); i++) {
+		if (is_selected (argc, argv, benchmarks[i].name)) {
+			benchmarks[i].run (app);
+		}
+	}
+
+	g_object_unref (app);
+
+	return EXIT_SUCCESS;
+}
@@ -16,6 +16,10 @@ main (gint argc, gchar **argv)
         mrptime         time_tue, time_sat, time_sun, time_27nov, time_28nov;
         MrpDay         *day_a, *day_b, *day_c, *def_1_id;
         GList          *l = NULL;
+        MrpProject     *loaded;
+        MrpCalendar    *rules, *shift;
+        MrpCalendarRule rule;
+        gchar          *str;
 
 	app = mrp_application_new ();
 
@@ -166,6 +170,93 @@ main (gint argc, gchar **argv)
         CHECK_INTEGER_RESULT (mrp_day_get_id (day_a),
                               mrp_day_get_id (day_b));
 
+        /****************************************************/
+        /** Check eight: Recurring dates                   **/
+        /****************************************************/
+        project = mrp_project_new (app);
+        rules = mrp_project_get_calendar (project);
+
+        /* Every other Monday off, from 18 Feb 2002. */
+        memset (&rule, 0, sizeof (rule));
+        rule.type = MRP_CALENDAR_RULE_WEEKLY;
+        rule.day = mrp_day_get_nonwork ();
+        rule.start = mrp_time_from_string ("20020218");
+        rule.week_day = MRP_CALENDAR_DAY_MON;
+        rule.interval = 2;
+        mrp_calendar_add_rule (rules, &rule);
+
+        /* The last Friday of every month off. */
+        rule.type = MRP_CALENDAR_RULE_MONTHLY;
+        rule.week_day = MRP_CALENDAR_DAY_FRI;
+        rule.nth = -1;
+        mrp_calendar_add_rule (rules, &rule);
+
+        /* Christmas day off every year. */
+        rule.type = MRP_CALENDAR_RULE_YEARLY;
+        rule.month = 12;
+        rule.month_day = 25;
+        mrp_calendar_add_rule (rules, &rule);
+
+        /* Four days off, four days on, during 2003. */
+        rule.type = MRP_CALENDAR_RULE_CYCLE;
+        rule.start = mrp_time_from_string ("20030101");
+        rule.end = mrp_time_from_string ("20031231");
+        rule.interval = 8;
+        rule.count = 4;
+        mrp_calendar_add_rule (rules, &rule);
+
+        CHECK_INTEGER_RESULT (g_list_length (mrp_calendar_get_rules (rules)), 4);
+
+#define CHECK_DAY(cal, date, day)                                               \
+        CHECK_INTEGER_RESULT (mrp_day_get_id (mrp_calendar_get_day (            \
+                                      cal, mrp_time_from_string (date), TRUE)), \
+                              mrp_day_get_id (day))
+
+        CHECK_DAY (rules, "20020211", mrp_day_get_work ());
+        CHECK_DAY (rules, "20020218", mrp_day_get_nonwork ());
+        CHECK_DAY (rules, "20020225", mrp_day_get_work ());
+        CHECK_DAY (rules, "20020304", mrp_day_get_nonwork ());
+        CHECK_DAY (rules, "20020215", mrp_day_get_work ());
+        CHECK_DAY (rules, "20020222", mrp_day_get_nonwork ());
+        CHECK_DAY (rules, "20021225", mrp_day_get_nonwork ());
+        CHECK_DAY (rules, "20301225", mrp_day_get_nonwork ());
+        CHECK_DAY (rules, "20030102", mrp_day_get_nonwork ());
+        CHECK_DAY (rules, "20030107", mrp_day_get_work ());
+        CHECK_DAY (rules, "20030109", mrp_day_get_nonwork ());
+        CHECK_DAY (rules, "20040106", mrp_day_get_work ());
+
+        /* Single dates take precedence, derived calendars inherit. */
+        mrp_calendar_set_days (rules,
+                               mrp_time_from_string ("20020304"), mrp_day_get_work (),
+                               (mrptime) -1);
+        CHECK_DAY (rules, "20020304", mrp_day_get_work ());
+
+        shift = mrp_calendar_derive ("Shift", rules);
+        CHECK_DAY (shift, "20020318", mrp_day_get_nonwork ());
+        CHECK_DAY (shift, "20020304", mrp_day_get_work ());
+
+        /* Rules are saved and loaded with the project. */
+        CHECK_BOOLEAN_RESULT (mrp_project_save_to_xml (project, &str, NULL), TRUE);
+
+        loaded = mrp_project_new (app);
+        CHECK_BOOLEAN_RESULT (mrp_project_load_from_xml (loaded, str, NULL), TRUE);
+        g_free (str);
+
+        rules = mrp_project_get_calendar (loaded);
+        CHECK_INTEGER_RESULT (g_list_length (mrp_calendar_get_rules (rules)), 4);
+        CHECK_DAY (rules, "20020318", mrp_day_get_nonwork ());
+        CHECK_DAY (rules, "20020304", mrp_day_get_work ());
+        CHECK_DAY (rules, "20020222", mrp_day_get_nonwork ());
+        CHECK_DAY (rules, "20301225", mrp_day_get_nonwork ());
+        CHECK_DAY (rules, "20030109", mrp_day_get_nonwork ());
+        CHECK_DAY (rules, "20040106", mrp_day_get_work ());
+
+        mrp_calendar_remove_rule (rules, mrp_calendar_get_rules (rules)->data);
+        CHECK_DAY (rules, "20020318", mrp_day_get_work ());
+
+        g_object_unref (loaded);
+        g_object_unref (project);
+
 	g_object_unref (app);
 	return EXIT_SUCCESS;
 }
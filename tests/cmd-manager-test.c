@@ -114,10 +114,76 @@ test_cmd (PlannerCmdManager *cmd_manager,
 	return cmd_base;
 }
 
+typedef struct {
+	PlannerCmd  base;
+
+	gint       *target;
+	gint        value;
+	gint        old_value;
+} SetCmd;
+
+static gboolean
+set_cmd_do (PlannerCmd *cmd_base)
+{
+	SetCmd *cmd = (SetCmd *) cmd_base;
+
+	*cmd->target = cmd->value;
+
+	return TRUE;
+}
+
+static void
+set_cmd_undo (PlannerCmd *cmd_base)
+{
+	SetCmd *cmd = (SetCmd *) cmd_base;
+
+	*cmd->target = cmd->old_value;
+}
+
+static gboolean
+set_cmd_merge (PlannerCmd *cmd_base, PlannerCmd *next_base)
+{
+	SetCmd *cmd = (SetCmd *) cmd_base;
+	SetCmd *next = (SetCmd *) next_base;
+
+	if (cmd->target != next->target) {
+		return FALSE;
+	}
+
+	cmd->value = next->value;
+
+	return TRUE;
+}
+
+static void
+set_cmd (PlannerCmdManager *cmd_manager,
+	 gint              *target,
+	 gint               value)
+{
+	PlannerCmd *cmd_base;
+	SetCmd     *cmd;
+
+	cmd_base = planner_cmd_new (SetCmd, "set", set_cmd_do, set_cmd_undo, NULL);
+	cmd_base->merge_func = set_cmd_merge;
+
+	cmd = (SetCmd *) cmd_base;
+	cmd->target = target;
+	cmd->value = value;
+	cmd->old_value = *target;
+
+	planner_cmd_manager_insert_and_do (cmd_manager, cmd_base);
+}
+
 gint
 main (gint argc, gchar **argv)
 {
-	ActionHistory action_history;
+	ActionHistory      action_history;
+	MrpApplication    *app;
+	MrpProject        *project;
+	gint               n_operations;
+	gint               n_commands;
+	gsize              n_bytes;
+	gint               x, y;
 
 	PlannerCmdManager *cmd_manager = planner_cmd_manager_new ();
 
@@ -213,6 +279,120 @@ main (gint argc, gchar **argv)
 	planner_cmd_manager_redo (cmd_manager);
 	CHECK_STRING_RESULT (g_strdup(action_history.actions), "123abcdi");
 
+	/* Test that scheduling is blocked for the duration of a transaction
+	 * and restored afterwards */
+	app = mrp_application_new ();
+	project = mrp_project_new (app);
+	planner_cmd_manager_set_project (cmd_manager, project);
+
+	CHECK_BOOLEAN_RESULT (mrp_project_get_block_scheduling (project), FALSE);
+	planner_cmd_manager_begin_transaction (cmd_manager, "trans 4");
+	CHECK_BOOLEAN_RESULT (mrp_project_get_block_scheduling (project), TRUE);
+	test_cmd(cmd_manager, &action_history, 'z');
+	CHECK_BOOLEAN_RESULT (mrp_project_get_block_scheduling (project), TRUE);
+	planner_cmd_manager_end_transaction (cmd_manager);
+	CHECK_BOOLEAN_RESULT (mrp_project_get_block_scheduling (project), FALSE);
+	CHECK_STRING_RESULT (g_strdup(action_history.actions), "123abcdiz");
+
+	planner_cmd_manager_undo (cmd_manager);
+	CHECK_BOOLEAN_RESULT (mrp_project_get_block_scheduling (project), FALSE);
+	CHECK_STRING_RESULT (g_strdup(action_history.actions), "123abcdi");
+
+	planner_cmd_manager_redo (cmd_manager);
+	CHECK_BOOLEAN_RESULT (mrp_project_get_block_scheduling (project), FALSE);
+	CHECK_STRING_RESULT (g_strdup(action_history.actions), "123abcdiz");
+
+	/* Test that a project blocked by the caller stays blocked */
+	mrp_project_set_block_scheduling (project, TRUE);
+	planner_cmd_manager_undo (cmd_manager);
+	CHECK_BOOLEAN_RESULT (mrp_project_get_block_scheduling (project), TRUE);
+	planner_cmd_manager_redo (cmd_manager);
+	CHECK_BOOLEAN_RESULT (mrp_project_get_block_scheduling (project), TRUE);
+	mrp_project_set_block_scheduling (project, FALSE);
+
+	g_object_unref (cmd_manager);
+	g_object_unref (project);
+	g_object_unref (app);
+
+	/* Test that consecutive commands with a merge function are folded
+	 * into one undo step */
+	cmd_manager = planner_cmd_manager_new ();
+	x = 0;
+	y = 0;
+
+	set_cmd (cmd_manager, &x, 1);
+	set_cmd (cmd_manager, &x, 2);
+	set_cmd (cmd_manager, &x, 3);
+	CHECK_INTEGER_RESULT (x, 3);
+
+	planner_cmd_manager_get_stats (cmd_manager, &n_operations, &n_commands, &n_bytes);
+	CHECK_INTEGER_RESULT (n_operations, 1);
+	CHECK_INTEGER_RESULT (n_commands, 1);
+	CHECK_BOOLEAN_RESULT (n_bytes >= sizeof (SetCmd), TRUE);
+
+	set_cmd (cmd_manager, &y, 1);
+	planner_cmd_manager_get_stats (cmd_manager, &n_operations, NULL, NULL);
+	CHECK_INTEGER_RESULT (n_operations, 2);
+
+	planner_cmd_manager_undo (cmd_manager);
+	planner_cmd_manager_undo (cmd_manager);
+	CHECK_INTEGER_RESULT (x, 0);
+	CHECK_INTEGER_RESULT (y, 0);
+
+	/* Test that the merge interval counts from the command merged into,
+	 * which after an undo is older than the last insert */
+	set_cmd (cmd_manager, &x, 1);
+	g_usleep (G_USEC_PER_SEC);
+	set_cmd (cmd_manager, &y, 1);
+	planner_cmd_manager_undo (cmd_manager);
+	set_cmd (cmd_manager, &x, 2);
+
+	planner_cmd_manager_get_stats (cmd_manager, &n_operations, NULL, NULL);
+	CHECK_INTEGER_RESULT (n_operations, 2);
+
+	planner_cmd_manager_undo (cmd_manager);
+	CHECK_INTEGER_RESULT (x, 1);
+	planner_cmd_manager_undo (cmd_manager);
+	CHECK_INTEGER_RESULT (x, 0);
+
+	/* Test that the history is trimmed to the operation limit, counting
+	 * transactions as one operation */
+	planner_cmd_manager_set_limits (cmd_manager, 3, 1024 * 1024);
+
+	memset(action_history.actions, 0, sizeof(action_history.actions));
+	action_history.next = 0;
+
+	planner_cmd_manager_begin_transaction (cmd_manager, "trans 5");
+	test_cmd(cmd_manager, &action_history, 'a');
+	test_cmd(cmd_manager, &action_history, 'b');
+	planner_cmd_manager_end_transaction (cmd_manager);
+	test_cmd(cmd_manager, &action_history, '1');
+	test_cmd(cmd_manager, &action_history, '2');
+
+	planner_cmd_manager_get_stats (cmd_manager, &n_operations, &n_commands, NULL);
+	CHECK_INTEGER_RESULT (n_operations, 3);
+	CHECK_INTEGER_RESULT (n_commands, 6);
+
+	test_cmd(cmd_manager, &action_history, '3');
+	planner_cmd_manager_get_stats (cmd_manager, &n_operations, &n_commands, NULL);
+	CHECK_INTEGER_RESULT (n_operations, 3);
+	CHECK_INTEGER_RESULT (n_commands, 3);
+
+	planner_cmd_manager_undo (cmd_manager);
+	planner_cmd_manager_undo (cmd_manager);
+	planner_cmd_manager_undo (cmd_manager);
+	planner_cmd_manager_undo (cmd_manager);
+	CHECK_STRING_RESULT (g_strdup(action_history.actions), "ab");
+
+	/* Test that the byte budget trims everything but the latest
+	 * operation */
+	planner_cmd_manager_redo (cmd_manager);
+	planner_cmd_manager_set_limits (cmd_manager, 100, 1);
+	test_cmd(cmd_manager, &action_history, '4');
+	planner_cmd_manager_get_stats (cmd_manager, &n_operations, &n_commands, NULL);
+	CHECK_INTEGER_RESULT (n_operations, 1);
+	CHECK_INTEGER_RESULT (n_commands, 1);
+
 	g_object_unref (cmd_manager);
 
 	return EXIT_SUCCESS;
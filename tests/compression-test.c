@@ -0,0 +1,182 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+#include <config.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib/gstdio.h>
+#include "libplanner/mrp-project.h"
+#include "libplanner/mrp-relation.h"
+#include "self-check.h"
+
+#define N_TASKS     100
+#define N_RESOURCES 10
+#define DAY         (60*60*8)
+
+static const gchar *names[] = { "plain", "gzip", "zstd" };
+
+static MrpProject *
+create_project (MrpApplication *app)
+{
+	MrpProject   *project;
+	MrpResource **resources;
+	MrpTask      *summary = NULL;
+	MrpTask      *task, *prev = NULL;
+	gchar        *name;
+	gint          i;
+
+	project = mrp_project_new (app);
+	g_object_set (project, "project_start", mrp_time_from_string ("20020218"), NULL);
+
+	resources = g_new (MrpResource *, N_RESOURCES);
+
+	for (i = 0; i < N_RESOURCES; i++) {
+		name = g_strdup_printf ("Resource %d", i);
+		resources[i] = g_object_new (MRP_TYPE_RESOURCE, "name", name, NULL);
+		mrp_project_add_resource (project, resources[i]);
+		g_free (name);
+	}
+
+	mrp_project_set_block_scheduling (project, TRUE);
+
+	for (i = 0; i < N_TASKS; i++) {
+		if (i % 10 == 0) {
+			summary = add_task (project, NULL, "Phase", 0);
+		}
+
+		name = g_strdup_printf ("Task %d", i);
+		task = add_task (project, summary, name, DAY * (1 + i % 3));
+		g_free (name);
+
+		mrp_resource_assign (resources[i % N_RESOURCES], task, 100);
+
+		if (prev) {
+			mrp_task_add_predecessor (task, prev, MRP_RELATION_FS, 0, NULL);
+		}
+		prev = task;
+	}
+
+	mrp_project_set_block_scheduling (project, FALSE);
+
+	g_free (resources);
+
+	return project;
+}
+
+static gint
+count_tasks (MrpProject *project)
+{
+	GList *tasks;
+	gint   n;
+
+	tasks = mrp_project_get_all_tasks (project);
+	n = g_list_length (tasks);
+	g_list_free (tasks);
+
+	return n;
+}
+
+static gboolean
+has_magic (const gchar *filename, const gchar *magic, gsize length)
+{
+	gchar    *contents;
+	gsize     size;
+	gboolean  ret;
+
+	if (!g_file_get_contents (filename, &contents, &size, NULL)) {
+		return FALSE;
+	}
+
+	ret = size >= length && memcmp (contents, magic, length) == 0;
+	g_free (contents);
+
+	return ret;
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+	MrpApplication     *app;
+	MrpProject         *project, *loaded;
+	MrpFileCompression  compression;
+	gchar              *dir, *filename, *contents;
+	gsize               size;
+
+	app = mrp_application_new ();
+
+	dir = g_dir_make_tmp ("compression-test-XXXXXX", NULL);
+	CHECK_BOOLEAN_RESULT (dir != NULL, TRUE);
+
+	project = create_project (app);
+
+	CHECK_BOOLEAN_RESULT (mrp_file_compression_is_supported (MRP_FILE_COMPRESSION_NONE), TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_file_compression_is_supported (MRP_FILE_COMPRESSION_GZIP), TRUE);
+
+	for (compression = MRP_FILE_COMPRESSION_NONE;
+	     compression <= MRP_FILE_COMPRESSION_ZSTD;
+	     compression++) {
+		if (!mrp_file_compression_is_supported (compression)) {
+			continue;
+		}
+
+		filename = g_strdup_printf ("%s/project-%s.planner", dir, names[compression]);
+
+		mrp_project_set_file_compression (project, compression);
+
+		CHECK_BOOLEAN_RESULT (mrp_project_save_as (project, filename, TRUE, NULL), TRUE);
+
+		switch (compression) {
+		case MRP_FILE_COMPRESSION_NONE:
+			CHECK_BOOLEAN_RESULT (has_magic (filename, "<?xml", 5), TRUE);
+			break;
+		case MRP_FILE_COMPRESSION_GZIP:
+			CHECK_BOOLEAN_RESULT (has_magic (filename, "\x1f\x8b", 2), TRUE);
+			break;
+		case MRP_FILE_COMPRESSION_ZSTD:
+			CHECK_BOOLEAN_RESULT (has_magic (filename, "\x28\xb5\x2f\xfd", 4), TRUE);
+			break;
+		}
+
+		/* The format is found from the contents, not the name. */
+		loaded = mrp_project_new (app);
+
+		CHECK_BOOLEAN_RESULT (mrp_project_load (loaded, filename, NULL), TRUE);
+
+		CHECK_INTEGER_RESULT (mrp_project_get_file_compression (loaded), compression);
+		CHECK_INTEGER_RESULT (count_tasks (loaded), count_tasks (project));
+		CHECK_BOOLEAN_RESULT (mrp_project_get_task_by_name (loaded, "Task 0") != NULL, TRUE);
+
+		g_object_unref (loaded);
+
+		/* A file cut short fails to load instead of loading half. */
+		if (compression != MRP_FILE_COMPRESSION_NONE) {
+			CHECK_BOOLEAN_RESULT (g_file_get_contents (filename, &contents, &size, NULL), TRUE);
+			CHECK_BOOLEAN_RESULT (g_file_set_contents (filename, contents, size / 2, NULL), TRUE);
+			g_free (contents);
+
+			loaded = mrp_project_new (app);
+			CHECK_BOOLEAN_RESULT (mrp_project_load (loaded, filename, NULL), FALSE);
+			g_object_unref (loaded);
+		}
+
+		g_remove (filename);
+		g_free (filename);
+	}
+
+	/* Compressed names keep their extension. */
+	filename = g_build_filename (dir, "project.gz", NULL);
+
+	mrp_project_set_file_compression (project, MRP_FILE_COMPRESSION_GZIP);
+	CHECK_BOOLEAN_RESULT (mrp_project_save_as (project, filename, TRUE, NULL), TRUE);
+	CHECK_STRING_RESULT ((char *) mrp_project_get_uri (project), filename);
+	CHECK_BOOLEAN_RESULT (has_magic (filename, "\x1f\x8b", 2), TRUE);
+
+	g_remove (filename);
+	g_free (filename);
+
+	g_rmdir (dir);
+
+	g_free (dir);
+	g_object_unref (project);
+	g_object_unref (app);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+#include <config.h>
+#include <stdlib.h>
+#include <gtk/gtk.h>
+#include "libplanner/mrp-project.h"
+#include "libplanner/mrp-relation.h"
+#include "src/planner-gantt-model.h"
+#include "src/planner-gantt-chart.h"
+#include "self-check.h"
+
+/* A chain of long tasks, wider than the view but not taller, so that only
+ * scrolling sideways brings the later arrows into view.
+ */
+#define N_TASKS 20
+#define DAY     (60*60*8)
+
+/* Exit status that tells meson the test was skipped. */
+#define SKIPPED 77
+
+static void
+run_pending (void)
+{
+	while (gtk_events_pending ()) {
+		gtk_main_iteration ();
+	}
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+	MrpApplication    *app;
+	MrpProject        *project;
+	PlannerGanttModel *model;
+	GtkWidget         *window, *sw, *chart;
+	GtkAdjustment     *hadj;
+	MrpTask           *task, *prev = NULL;
+	guint              n_routes;
+	gint               i;
+
+	if (!gtk_init_check (&argc, &argv)) {
+		g_print ("No display, skipping\n");
+		return SKIPPED;
+	}
+
+	app = mrp_application_new ();
+	project = mrp_project_new (app);
+	g_object_set (project, "project_start", mrp_time_from_string ("20020218"), NULL);
+
+	for (i = 0; i < N_TASKS; i++) {
+		task = add_task (project, NULL, "T", 20 * DAY);
+
+		if (prev) {
+			mrp_task_add_predecessor (task, prev, MRP_RELATION_FS, 0, NULL);
+		}
+		prev = task;
+	}
+
+	model = planner_gantt_model_new (project);
+	chart = planner_gantt_chart_new_with_model (GTK_TREE_MODEL (model));
+
+	sw = gtk_scrolled_window_new (NULL, NULL);
+	gtk_container_add (GTK_CONTAINER (sw), chart);
+
+	window = gtk_offscreen_window_new ();
+	gtk_widget_set_size_request (window, 400, 800);
+	gtk_container_add (GTK_CONTAINER (window), sw);
+	gtk_widget_show_all (window);
+
+	run_pending ();
+
+	/* Only the arrows at the start of the chain are in view. */
+	n_routes = planner_gantt_chart_get_n_arrow_routes (PLANNER_GANTT_CHART (chart));
+	CHECK_BOOLEAN_RESULT (n_routes > 0, TRUE);
+	CHECK_BOOLEAN_RESULT (n_routes < N_TASKS - 1, TRUE);
+
+	/* Scrolling sideways routes the arrows it brings into view. */
+	hadj = gtk_scrollable_get_hadjustment (GTK_SCROLLABLE (chart));
+	gtk_adjustment_set_value (hadj,
+				  gtk_adjustment_get_upper (hadj) -
+				  gtk_adjustment_get_page_size (hadj));
+	run_pending ();
+
+	CHECK_BOOLEAN_RESULT (planner_gantt_chart_get_n_arrow_routes (
+				      PLANNER_GANTT_CHART (chart)) > n_routes, TRUE);
+
+	/* Scrolling back doesn't route anything again. */
+	n_routes = planner_gantt_chart_get_n_arrow_routes (PLANNER_GANTT_CHART (chart));
+	gtk_adjustment_set_value (hadj, 0);
+	run_pending ();
+
+	CHECK_INTEGER_RESULT (planner_gantt_chart_get_n_arrow_routes (
+				      PLANNER_GANTT_CHART (chart)), n_routes);
+
+	gtk_widget_destroy (window);
+	g_object_unref (model);
+	g_object_unref (project);
+	g_object_unref (app);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,137 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+#include <config.h>
+#include <string.h>
+#include <stdlib.h>
+#include "libplanner/mrp-project.h"
+#include "src/planner-gantt-model.h"
+#include "self-check.h"
+
+#define N_SUMMARIES 10
+#define N_CHILDREN  5
+#define N_MOVES     50
+
+extern gchar *get_wbs_from_task (MrpTask *task);
+
+static void
+check_task (PlannerGanttModel *model, MrpTask *task)
+{
+	GtkTreePath *path;
+	GtkTreeIter  iter;
+	MrpTask     *found;
+	gchar       *wbs;
+	gchar       *expected;
+
+	path = planner_gantt_model_get_path_from_task (model, task);
+	CHECK_BOOLEAN_RESULT (path != NULL, TRUE);
+
+	CHECK_BOOLEAN_RESULT (gtk_tree_model_get_iter (GTK_TREE_MODEL (model), &iter, path), TRUE);
+
+	gtk_tree_model_get (GTK_TREE_MODEL (model), &iter,
+			    COL_TASK, &found,
+			    COL_WBS, &wbs,
+			    -1);
+
+	CHECK_POINTER_RESULT (found, task);
+
+	expected = get_wbs_from_task (task);
+	CHECK_STRING_RESULT (wbs, expected);
+
+	g_free (expected);
+	g_free (wbs);
+	g_object_unref (found);
+	gtk_tree_path_free (path);
+}
+
+static void
+check_model (PlannerGanttModel *model, MrpProject *project)
+{
+	GList *tasks, *l;
+
+	tasks = mrp_project_get_all_tasks (project);
+	for (l = tasks; l; l = l->next) {
+		check_task (model, l->data);
+	}
+
+	g_list_free (tasks);
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+	MrpApplication    *app;
+	MrpProject        *project;
+	PlannerGanttModel *model;
+	MrpTask           *root;
+	MrpTask           *summaries[N_SUMMARIES];
+	MrpTask           *task, *parent;
+	gint               n_rows;
+	gint               i, j;
+	gboolean           success;
+
+	app = mrp_application_new ();
+	project = mrp_project_new (app);
+	root = mrp_project_get_root_task (project);
+
+	model = planner_gantt_model_new (project);
+
+	/* Insert at the front, so that every insert shifts the siblings. */
+	for (i = 0; i < N_SUMMARIES; i++) {
+		summaries[i] = g_object_new (MRP_TYPE_TASK, "name", "S", NULL);
+		mrp_project_insert_task (project, NULL, 0, summaries[i]);
+
+		for (j = 0; j < N_CHILDREN; j++) {
+			task = g_object_new (MRP_TYPE_TASK, "name", "T", NULL);
+			mrp_project_insert_task (project, summaries[i], 0, task);
+		}
+	}
+
+	check_model (model, project);
+
+	/* Check the WBS of the first child, then make it stale by
+	 * inserting before it.
+	 */
+	task = mrp_task_get_first_child (summaries[0]);
+	check_task (model, task);
+
+	mrp_project_insert_task (project, summaries[0], 0,
+				 g_object_new (MRP_TYPE_TASK, "name", "T", NULL));
+	check_task (model, task);
+
+	/* Move the summary, which changes the WBS of its whole subtree. */
+	success = mrp_project_move_task (project, summaries[0],
+					 NULL, root, TRUE, NULL);
+	CHECK_BOOLEAN_RESULT (success, TRUE);
+	check_task (model, task);
+
+	/* Move leaves between summaries. */
+	for (i = 0; i < N_MOVES; i++) {
+		task = mrp_task_get_first_child (summaries[i % N_SUMMARIES]);
+		if (!task) {
+			continue;
+		}
+
+		parent = summaries[(i * 7 + 3) % N_SUMMARIES];
+
+		if (parent != mrp_task_get_parent (task)) {
+			success = mrp_project_move_task (project, task,
+							 NULL, parent, TRUE, NULL);
+			CHECK_BOOLEAN_RESULT (success, TRUE);
+		}
+	}
+
+	check_model (model, project);
+
+	/* Removing a summary removes its row. */
+	n_rows = gtk_tree_model_iter_n_children (GTK_TREE_MODEL (model), NULL);
+	mrp_project_remove_task (project, summaries[1]);
+	CHECK_INTEGER_RESULT (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (model), NULL),
+			      n_rows - 1);
+
+	check_model (model, project);
+
+	g_object_unref (model);
+	g_object_unref (project);
+	g_object_unref (app);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,96 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+#include <config.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib/gstdio.h>
+#include "libplanner/mrp-project.h"
+#include "libplanner/mrp-relation.h"
+#include "src/planner-gantt-print.h"
+#include "self-check.h"
+
+/* Enough tasks for more than one page. */
+#define N_TASKS 150
+#define LEVEL   7
+#define DAY     (60*60*8)
+
+static gboolean
+has_magic (const gchar *filename, const gchar *magic)
+{
+	gchar    *contents;
+	gsize     size;
+	gboolean  ret;
+
+	if (!g_file_get_contents (filename, &contents, &size, NULL)) {
+		return FALSE;
+	}
+
+	ret = size >= strlen (magic) && memcmp (contents, magic, strlen (magic)) == 0;
+	g_free (contents);
+
+	return ret;
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+	MrpApplication *app;
+	MrpProject     *project;
+	MrpTask        *task, *prev = NULL;
+	GError         *error = NULL;
+	gchar          *dir, *filename;
+	gint            i;
+
+	app = mrp_application_new ();
+	project = mrp_project_new (app);
+	g_object_set (project, "project_start", mrp_time_from_string ("20020218"), NULL);
+
+	for (i = 0; i < N_TASKS; i++) {
+		task = add_task (project, NULL, "T", DAY);
+
+		if (prev) {
+			mrp_task_add_predecessor (task, prev, MRP_RELATION_FS, 0, NULL);
+		}
+		prev = task;
+	}
+
+	dir = g_dir_make_tmp ("gantt-print-test-XXXXXX", NULL);
+	CHECK_BOOLEAN_RESULT (dir != NULL, TRUE);
+
+	/* A PDF, its pages are rendered in parallel. */
+	filename = g_build_filename (dir, "gantt.pdf", NULL);
+
+	CHECK_BOOLEAN_RESULT (planner_gantt_print_export (project, filename, LEVEL,
+							  TRUE, NULL), TRUE);
+	CHECK_BOOLEAN_RESULT (has_magic (filename, "%PDF"), TRUE);
+
+	g_remove (filename);
+	g_free (filename);
+
+	/* An SVG when asked for by the name. */
+	filename = g_build_filename (dir, "gantt.svg", NULL);
+
+	CHECK_BOOLEAN_RESULT (planner_gantt_print_export (project, filename, LEVEL,
+							  FALSE, NULL), TRUE);
+	CHECK_BOOLEAN_RESULT (has_magic (filename, "<?xml"), TRUE);
+
+	g_remove (filename);
+	g_free (filename);
+
+	/* A file that can't be written gives an error. */
+	filename = g_build_filename (dir, "missing", "gantt.pdf", NULL);
+
+	CHECK_BOOLEAN_RESULT (planner_gantt_print_export (project, filename, LEVEL,
+							  FALSE, &error), FALSE);
+	CHECK_BOOLEAN_RESULT (error != NULL, TRUE);
+	g_clear_error (&error);
+
+	g_free (filename);
+
+	g_rmdir (dir);
+	g_free (dir);
+
+	g_object_unref (project);
+	g_object_unref (app);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,108 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+#include <config.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib/gstdio.h>
+#include "libplanner/mrp-project.h"
+#include "libplanner/mrp-error.h"
+#include "self-check.h"
+
+#define DAY (60*60*8)
+
+static gboolean
+file_contains (const gchar *filename, const gchar *str)
+{
+	gchar    *contents;
+	gboolean  ret;
+
+	if (!g_file_get_contents (filename, &contents, NULL, NULL)) {
+		return FALSE;
+	}
+
+	ret = strstr (contents, str) != NULL;
+	g_free (contents);
+
+	return ret;
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+	MrpApplication *app;
+	MrpProject     *project;
+	MrpResource    *resource;
+	MrpTask        *summary, *task;
+	GError         *error = NULL;
+	gchar          *dir, *filename;
+
+	app = mrp_application_new ();
+
+	dir = g_dir_make_tmp ("html-test-XXXXXX", NULL);
+	CHECK_BOOLEAN_RESULT (dir != NULL, TRUE);
+
+	filename = g_build_filename (dir, "project.html", NULL);
+
+	project = mrp_project_new (app);
+	g_object_set (project,
+		      "project_start", mrp_time_from_string ("20020218"),
+		      "name", "Launch",
+		      NULL);
+
+	resource = g_object_new (MRP_TYPE_RESOURCE, "name", "Tester", NULL);
+	mrp_project_add_resource (project, resource);
+
+	summary = add_task (project, NULL, "Phase", 0);
+	task = add_task (project, summary, "Design & review", 2 * DAY);
+	mrp_resource_assign (resource, task, 100);
+
+	/* The native writer has the tasks and resources, escaped. */
+	CHECK_BOOLEAN_RESULT (mrp_project_export (project, filename,
+						  "Planner HTML Native",
+						  FALSE, NULL), TRUE);
+
+	CHECK_BOOLEAN_RESULT (file_contains (filename, "<title>Launch - Planner</title>"), TRUE);
+	CHECK_BOOLEAN_RESULT (file_contains (filename, "Phase"), TRUE);
+	CHECK_BOOLEAN_RESULT (file_contains (filename, "Design &amp; review"), TRUE);
+	CHECK_BOOLEAN_RESULT (file_contains (filename, "Tester"), TRUE);
+
+	/* An existing file is only replaced when forced. */
+	mrp_task_set_name (task, "Build");
+
+	CHECK_BOOLEAN_RESULT (mrp_project_export (project, filename,
+						  "Planner HTML Native",
+						  FALSE, &error), FALSE);
+	CHECK_BOOLEAN_RESULT (g_error_matches (error, MRP_ERROR,
+					       MRP_ERROR_SAVE_FILE_EXIST), TRUE);
+	g_clear_error (&error);
+	CHECK_BOOLEAN_RESULT (file_contains (filename, "Build"), FALSE);
+
+	CHECK_BOOLEAN_RESULT (mrp_project_export (project, filename,
+						  "Planner HTML Native",
+						  TRUE, NULL), TRUE);
+	CHECK_BOOLEAN_RESULT (file_contains (filename, "Build"), TRUE);
+
+	g_remove (filename);
+
+	/* A file that can't be written gives an error. */
+	CHECK_BOOLEAN_RESULT (mrp_project_export (project, dir,
+						  "Planner HTML Native",
+						  TRUE, &error), FALSE);
+	CHECK_BOOLEAN_RESULT (error != NULL, TRUE);
+	g_clear_error (&error);
+
+	/* The XSLT writer has the same tasks. */
+	CHECK_BOOLEAN_RESULT (mrp_project_export (project, filename,
+						  "Planner HTML",
+						  TRUE, NULL), TRUE);
+	CHECK_BOOLEAN_RESULT (file_contains (filename, "Build"), TRUE);
+
+	g_remove (filename);
+	g_rmdir (dir);
+
+	g_free (filename);
+	g_free (dir);
+	g_object_unref (project);
+	g_object_unref (app);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,246 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+#include <config.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib/gstdio.h>
+#include "libplanner/mrp-project.h"
+#include "libplanner/mrp-relation.h"
+#include "self-check.h"
+
+#define DAY (60*60*8)
+
+static gint
+count_records (const gchar *filename)
+{
+	gchar *contents, *p;
+	gint   n = 0;
+
+	if (!g_file_get_contents (filename, &contents, NULL, NULL)) {
+		return -1;
+	}
+
+	for (p = contents; *p; p++) {
+		if (*p == '\n') {
+			n++;
+		}
+	}
+
+	g_free (contents);
+
+	return n;
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+	MrpApplication *app;
+	MrpProject     *project, *loaded;
+	MrpGroup       *group;
+	MrpResource    *resource, *helper;
+	MrpResource    *loaded_resource, *loaded_helper;
+	MrpTask        *task_a, *task_b, *task_c, *summary;
+	MrpTask        *loaded_a, *loaded_c, *loaded_summary;
+	MrpProperty    *property;
+	FILE           *file;
+	gchar          *dir, *filename, *path, *xml, *str;
+
+	app = mrp_application_new ();
+
+	dir = g_dir_make_tmp ("journal-test-XXXXXX", NULL);
+	CHECK_BOOLEAN_RESULT (dir != NULL, TRUE);
+
+	filename = g_build_filename (dir, "project.journal", NULL);
+	path = g_build_filename (dir, "project.planner", NULL);
+
+	project = mrp_project_new (app);
+	g_object_set (project, "project_start", mrp_time_from_string ("20020218"), NULL);
+
+	group = g_object_new (MRP_TYPE_GROUP, "name", "G", NULL);
+	mrp_project_add_group (project, group);
+
+	resource = g_object_new (MRP_TYPE_RESOURCE, "name", "R", "group", group, NULL);
+	mrp_project_add_resource (project, resource);
+
+	task_a = add_task (project, NULL, "A", DAY);
+	summary = add_task (project, NULL, "S", 0);
+	task_b = add_task (project, summary, "B", 2 * DAY);
+	mrp_resource_assign (resource, task_a, 100);
+
+	property = mrp_property_new ("cost-center", MRP_PROPERTY_TYPE_STRING,
+				     "Cost center", "", TRUE);
+	mrp_project_add_property (project, MRP_TYPE_TASK, property, TRUE);
+
+	/* The saved project, the journal starts from it. */
+	CHECK_BOOLEAN_RESULT (mrp_project_save_to_xml (project, &xml, NULL), TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_project_start_journal (project, filename, NULL), TRUE);
+	CHECK_INTEGER_RESULT (count_records (filename), 1);
+
+	g_object_set (task_a, "name", "A\ttabbed", "work", 3 * DAY, NULL);
+	mrp_object_set (task_a, "cost-center", "North", NULL);
+
+	task_c = add_task (project, summary, "C", DAY);
+	mrp_resource_assign (resource, task_c, 50);
+	mrp_task_add_predecessor (task_c, task_a, MRP_RELATION_FS, 0, NULL);
+	g_object_set (mrp_task_get_assignment (task_a, resource), "units", 200, NULL);
+
+	CHECK_BOOLEAN_RESULT (mrp_project_move_task (project, task_c, task_b, summary,
+						     TRUE, NULL), TRUE);
+	mrp_project_remove_task (project, task_b);
+
+	helper = g_object_new (MRP_TYPE_RESOURCE, "name", "H", NULL);
+	mrp_project_add_resource (project, helper);
+	mrp_resource_assign (helper, task_c, 100);
+
+	g_object_set (project, "name", "Journaled", NULL);
+
+	mrp_project_sync_journal (project);
+
+	/* Replaying on top of the saved project gets the edits back. */
+	loaded = mrp_project_new (app);
+	CHECK_BOOLEAN_RESULT (mrp_project_load_from_xml (loaded, xml, NULL), TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_project_start_journal (loaded, filename, NULL), TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_project_needs_saving (loaded), TRUE);
+
+	loaded_a = mrp_project_get_task_by_name (loaded, "A\ttabbed");
+	loaded_c = mrp_project_get_task_by_name (loaded, "C");
+	loaded_summary = mrp_project_get_task_by_name (loaded, "S");
+	loaded_resource = mrp_project_get_resource_by_name (loaded, "R");
+	loaded_helper = mrp_project_get_resource_by_name (loaded, "H");
+
+	CHECK_BOOLEAN_RESULT (loaded_a && loaded_c && loaded_summary, TRUE);
+	CHECK_BOOLEAN_RESULT (loaded_resource && loaded_helper, TRUE);
+	CHECK_POINTER_RESULT (mrp_project_get_task_by_name (loaded, "B"), NULL);
+
+	CHECK_INTEGER_RESULT (mrp_task_get_work (loaded_a), 3 * DAY);
+	mrp_object_get (loaded_a, "cost-center", &str, NULL);
+	CHECK_STRING_RESULT (str, "North");
+	g_free (str);
+
+	CHECK_INTEGER_RESULT (mrp_task_get_n_children (loaded_summary), 1);
+	CHECK_POINTER_RESULT (mrp_task_get_first_child (loaded_summary), loaded_c);
+	CHECK_BOOLEAN_RESULT (mrp_task_get_predecessor_relation (loaded_c, loaded_a) != NULL, TRUE);
+
+	CHECK_INTEGER_RESULT (mrp_assignment_get_units (
+				      mrp_task_get_assignment (loaded_a, loaded_resource)), 200);
+	CHECK_INTEGER_RESULT (mrp_assignment_get_units (
+				      mrp_task_get_assignment (loaded_c, loaded_resource)), 50);
+	CHECK_INTEGER_RESULT (mrp_assignment_get_units (
+				      mrp_task_get_assignment (loaded_c, loaded_helper)), 100);
+
+	CHECK_INTEGER_RESULT (mrp_task_get_start (loaded_c), mrp_task_get_start (task_c));
+	CHECK_INTEGER_RESULT (mrp_task_get_finish (loaded_c), mrp_task_get_finish (task_c));
+
+	g_object_get (loaded, "name", &str, NULL);
+	CHECK_STRING_RESULT (str, "Journaled");
+	g_free (str);
+
+	mrp_project_stop_journal (loaded, FALSE);
+	g_object_unref (loaded);
+
+	/* Saving compacts the journal. */
+	CHECK_BOOLEAN_RESULT (mrp_project_save_as (project, path, TRUE, NULL), TRUE);
+	CHECK_INTEGER_RESULT (count_records (filename), 1);
+
+	g_object_set (task_c, "name", "C after save", NULL);
+	mrp_project_sync_journal (project);
+	CHECK_INTEGER_RESULT (count_records (filename), 2);
+
+	/* A record cut short by a crash is dropped. */
+	file = g_fopen (filename, "ab");
+	fputs ("S\tP\tna", file);
+	fclose (file);
+
+	loaded = mrp_project_new (app);
+	CHECK_BOOLEAN_RESULT (mrp_project_load (loaded, path, NULL), TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_project_start_journal (loaded, filename, NULL), TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_project_get_task_by_name (loaded, "C after save") != NULL, TRUE);
+	CHECK_INTEGER_RESULT (count_records (filename), 2);
+	mrp_project_stop_journal (loaded, FALSE);
+	g_object_unref (loaded);
+
+	/* A journal of the file before it was changed is refused. */
+	file = g_fopen (path, "ab");
+	fputs ("\n", file);
+	fclose (file);
+
+	loaded = mrp_project_new (app);
+	CHECK_BOOLEAN_RESULT (mrp_project_load (loaded, path, NULL), TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_project_start_journal (loaded, filename, NULL), FALSE);
+	g_object_unref (loaded);
+
+	mrp_project_stop_journal (project, TRUE);
+	CHECK_BOOLEAN_RESULT (g_file_test (filename, G_FILE_TEST_EXISTS), FALSE);
+
+	/* A journal of another version of the project is refused. */
+	CHECK_BOOLEAN_RESULT (g_file_set_contents (filename,
+						   "planner-journal\t2\t99\t0\t0\t0\t0\n"
+						   "S\tP\tname\tOther\n",
+						   -1, NULL), TRUE);
+
+	loaded = mrp_project_new (app);
+	CHECK_BOOLEAN_RESULT (mrp_project_load_from_xml (loaded, xml, NULL), TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_project_start_journal (loaded, filename, NULL), FALSE);
+	g_object_unref (loaded);
+	g_remove (filename);
+
+	/* A journal that fails partway leaves the project as it was. */
+	loaded = mrp_project_new (app);
+	CHECK_BOOLEAN_RESULT (mrp_project_load_from_xml (loaded, xml, NULL), TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_project_start_journal (loaded, filename, NULL), TRUE);
+	mrp_project_stop_journal (loaded, FALSE);
+	g_object_unref (loaded);
+
+	file = g_fopen (filename, "ab");
+	fputs ("S\tP\tname\tHalfway\n"
+	       "t\t9999\n", file);
+	fclose (file);
+
+	loaded = mrp_project_new (app);
+	CHECK_BOOLEAN_RESULT (mrp_project_load_from_xml (loaded, xml, NULL), TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_project_start_journal (loaded, filename, NULL), FALSE);
+	CHECK_BOOLEAN_RESULT (mrp_project_needs_saving (loaded), FALSE);
+
+	g_object_get (loaded, "name", &str, NULL);
+	CHECK_BOOLEAN_RESULT (strcmp (str, "Halfway") != 0, TRUE);
+	g_free (str);
+
+	g_object_unref (loaded);
+	g_remove (filename);
+
+	/* A project that was never saved is recovered on a new one, with the
+	 * start it had.
+	 */
+	loaded = mrp_project_new (app);
+	g_object_set (loaded, "project_start", mrp_time_from_string ("20020218"), NULL);
+	CHECK_BOOLEAN_RESULT (mrp_project_start_journal (loaded, filename, NULL), TRUE);
+	CHECK_INTEGER_RESULT (count_records (filename), 1);
+
+	add_task (loaded, NULL, "Untitled", DAY);
+	CHECK_BOOLEAN_RESULT (count_records (filename) > 2, TRUE);
+	mrp_project_stop_journal (loaded, FALSE);
+	g_object_unref (loaded);
+
+	loaded = mrp_project_new (app);
+	CHECK_BOOLEAN_RESULT (mrp_project_start_journal (loaded, filename, NULL), TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_project_get_task_by_name (loaded, "Untitled") != NULL, TRUE);
+	CHECK_INTEGER_RESULT (mrp_project_get_project_start (loaded),
+			      mrp_time_from_string ("20020218"));
+
+	/* Loading a file into the project drops its journal. */
+	CHECK_BOOLEAN_RESULT (mrp_project_load (loaded, path, NULL), TRUE);
+	CHECK_BOOLEAN_RESULT (g_file_test (filename, G_FILE_TEST_EXISTS), FALSE);
+	g_object_unref (loaded);
+
+	g_object_unref (project);
+	g_free (xml);
+
+	g_remove (path);
+	g_rmdir (dir);
+
+	g_free (path);
+	g_free (filename);
+	g_free (dir);
+	g_object_unref (app);
+
+	return EXIT_SUCCESS;
+}
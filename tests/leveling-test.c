@@ -0,0 +1,140 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+#include <config.h>
+#include <stdlib.h>
+#include "libplanner/mrp-project.h"
+#include "libplanner/mrp-relation.h"
+#include "self-check.h"
+
+#define N_TASKS     40
+#define N_RESOURCES 4
+#define N_CHAINS    5
+#define DAY         (60*60*8)
+
+static void
+check_no_overallocations (MrpProject *project)
+{
+	GList *l;
+
+	for (l = mrp_project_get_resources (project); l; l = l->next) {
+		CHECK_INTEGER_RESULT (mrp_resource_get_overallocated_periods (l->data)->len, 0);
+	}
+}
+
+/* Two tasks on one resource, the one with the lower priority is delayed
+ * until the other is done.
+ */
+static void
+check_priority (MrpApplication *app)
+{
+	MrpProject  *project;
+	MrpResource *resource;
+	MrpTask     *low, *high;
+	GList       *delays;
+	mrptime      project_start;
+
+	project = mrp_project_new (app);
+	project_start = mrp_time_from_string ("20020218");
+	g_object_set (project, "project_start", project_start, NULL);
+
+	resource = g_object_new (MRP_TYPE_RESOURCE, "name", "R", NULL);
+	mrp_project_add_resource (project, resource);
+
+	low = g_object_new (MRP_TYPE_TASK, "name", "Low", "work", DAY, NULL);
+	mrp_project_insert_task (project, NULL, -1, low);
+	mrp_resource_assign (resource, low, 100);
+
+	high = g_object_new (MRP_TYPE_TASK, "name", "High", "work", DAY, "priority", 10, NULL);
+	mrp_project_insert_task (project, NULL, -1, high);
+	mrp_resource_assign (resource, high, 100);
+
+	delays = mrp_project_get_leveling_delays (project);
+	CHECK_INTEGER_RESULT (g_list_length (delays), 1);
+	CHECK_POINTER_RESULT (((MrpLevelingDelay *) delays->data)->task, low);
+	CHECK_INTEGER_RESULT (((MrpLevelingDelay *) delays->data)->start,
+			      mrp_task_get_finish (high));
+	g_list_free_full (delays, g_free);
+
+	/* Getting the delays doesn't change the project. */
+	CHECK_INTEGER_RESULT (mrp_task_get_start (low), project_start);
+
+	CHECK_INTEGER_RESULT (mrp_project_level_resources (project), 1);
+	CHECK_INTEGER_RESULT (mrp_task_get_start (low), mrp_task_get_finish (high));
+	CHECK_INTEGER_RESULT (mrp_resource_get_overallocated_periods (resource)->len, 0);
+	CHECK_POINTER_RESULT (mrp_project_get_leveling_delays (project), NULL);
+
+	g_object_unref (project);
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+	MrpApplication  *app;
+	MrpProject      *project;
+	MrpTask         *tasks[N_TASKS];
+	MrpTask         *summary = NULL;
+	MrpResource     *resources[N_RESOURCES];
+	GList           *delays;
+	gint             n_delays;
+	gint             i;
+
+	app = mrp_application_new ();
+
+	check_priority (app);
+
+	project = mrp_project_new (app);
+
+	g_object_set (project, "project_start", mrp_time_from_string ("20020218"), NULL);
+
+	for (i = 0; i < N_RESOURCES; i++) {
+		resources[i] = g_object_new (MRP_TYPE_RESOURCE, "name", "R", NULL);
+		mrp_project_add_resource (project, resources[i]);
+	}
+
+	mrp_project_set_block_scheduling (project, TRUE);
+
+	/* Chains of tasks under summaries of ten, each on one or two
+	 * resources, with mixed priorities and units.
+	 */
+	for (i = 0; i < N_TASKS; i++) {
+		if (i % 10 == 0) {
+			summary = g_object_new (MRP_TYPE_TASK, "name", "S", NULL);
+			mrp_project_insert_task (project, NULL, -1, summary);
+		}
+
+		tasks[i] = g_object_new (MRP_TYPE_TASK,
+					 "name", "T",
+					 "work", DAY * (1 + i % 3),
+					 "priority", (i * 7) % 5,
+					 NULL);
+		mrp_project_insert_task (project, summary, -1, tasks[i]);
+
+		mrp_resource_assign (resources[i % N_RESOURCES], tasks[i], 100);
+		if (i % 4 == 0) {
+			mrp_resource_assign (resources[(i * 3 + 1) % N_RESOURCES], tasks[i], 50);
+		}
+
+		if (i >= N_CHAINS) {
+			mrp_task_add_predecessor (tasks[i], tasks[i - N_CHAINS],
+						  MRP_RELATION_FS, 0, NULL);
+		}
+	}
+
+	mrp_project_set_block_scheduling (project, FALSE);
+
+	delays = mrp_project_get_leveling_delays (project);
+	n_delays = g_list_length (delays);
+	g_list_free_full (delays, g_free);
+
+	CHECK_BOOLEAN_RESULT (n_delays > 0, TRUE);
+	CHECK_INTEGER_RESULT (mrp_project_level_resources (project), n_delays);
+
+	check_no_overallocations (project);
+
+	/* Leveling a leveled project changes nothing. */
+	CHECK_POINTER_RESULT (mrp_project_get_leveling_delays (project), NULL);
+
+	g_object_unref (project);
+	g_object_unref (app);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,112 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+#include <config.h>
+#include <stdlib.h>
+#include "libplanner/mrp-project.h"
+#include "libplanner/mrp-relation.h"
+#include "self-check.h"
+
+#define DAY (60*60*8)
+
+static void
+overallocations_changed_cb (MrpResource *resource, gint *count)
+{
+	(*count)++;
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+	MrpApplication *app;
+	MrpProject     *project;
+	MrpCalendar    *calendar;
+	MrpResource    *resource, *helper;
+	MrpTask        *task_x, *task_a, *task_b, *task_c;
+	MrpLoadSegment *period;
+	GArray         *periods;
+	mrptime         monday, tuesday;
+	gint            count = 0;
+
+	app = mrp_application_new ();
+	project = mrp_project_new (app);
+
+	g_object_set (project, "project_start", mrp_time_from_string ("20020218"), NULL);
+
+	monday = mrp_time_from_string ("20020225");
+	tuesday = mrp_time_from_string ("20020226");
+
+	/* R has Mondays off, H works the default week. */
+	calendar = mrp_calendar_derive ("No Mondays", mrp_project_get_calendar (project));
+	mrp_calendar_set_default_days (calendar,
+				       MRP_CALENDAR_DAY_MON, mrp_day_get_nonwork (),
+				       -1);
+
+	resource = g_object_new (MRP_TYPE_RESOURCE, "name", "R", "calendar", calendar, NULL);
+	mrp_project_add_resource (project, resource);
+
+	helper = g_object_new (MRP_TYPE_RESOURCE, "name", "H", NULL);
+	mrp_project_add_resource (project, helper);
+
+	/* X fills the first week, A the second Monday where only H works. */
+	task_x = add_task (project, NULL, "X", 5 * DAY);
+	mrp_resource_assign (helper, task_x, 100);
+
+	task_a = add_task (project, NULL, "A", DAY);
+	mrp_resource_assign (resource, task_a, 100);
+	mrp_resource_assign (helper, task_a, 100);
+	mrp_task_add_predecessor (task_a, task_x, MRP_RELATION_FS, 0, NULL);
+
+	/* B works four days and goes on after R's Monday off. */
+	task_b = add_task (project, NULL, "B", 5 * DAY);
+	mrp_resource_assign (resource, task_b, 100);
+
+	CHECK_INTEGER_RESULT (mrp_task_get_work_start (task_a), monday + 8 * 60 * 60);
+	CHECK_INTEGER_RESULT (mrp_task_get_finish (task_b), tuesday + 17 * 60 * 60);
+
+	/* A and B only overlap when R does not work. */
+	periods = mrp_resource_get_overallocated_periods (resource);
+	CHECK_INTEGER_RESULT (periods->len, 0);
+	CHECK_BOOLEAN_RESULT (mrp_resource_is_overallocated (resource, monday, tuesday), FALSE);
+
+	g_signal_connect (resource, "overallocations_changed",
+			  G_CALLBACK (overallocations_changed_cb), &count);
+
+	/* C can't start before Tuesday, where it overlaps B. */
+	task_c = add_task (project, NULL, "C", DAY);
+	mrp_resource_assign (resource, task_c, 100);
+	mrp_task_add_predecessor (task_c, task_x, MRP_RELATION_FS, 0, NULL);
+	mrp_project_reschedule (project);
+
+	CHECK_INTEGER_RESULT (count, 1);
+
+	periods = mrp_resource_get_overallocated_periods (resource);
+	CHECK_INTEGER_RESULT (periods->len, 1);
+
+	period = &g_array_index (periods, MrpLoadSegment, 0);
+	CHECK_INTEGER_RESULT (period->start, tuesday + 8 * 60 * 60);
+	CHECK_INTEGER_RESULT (period->end, tuesday + 17 * 60 * 60);
+	CHECK_INTEGER_RESULT (period->units, 200);
+
+	CHECK_BOOLEAN_RESULT (mrp_resource_is_overallocated (resource, monday, tuesday), FALSE);
+	CHECK_BOOLEAN_RESULT (mrp_resource_is_overallocated (resource, monday,
+							     tuesday + 9 * 60 * 60), TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_resource_is_overallocated (resource,
+							     tuesday + 17 * 60 * 60,
+							     tuesday + 24 * 60 * 60), FALSE);
+
+	/* Nothing is emitted when the periods stay the same. */
+	mrp_project_reschedule (project);
+	CHECK_INTEGER_RESULT (count, 1);
+
+	/* Without C the overallocation is gone again. */
+	mrp_project_remove_task (project, task_c);
+	mrp_project_reschedule (project);
+
+	CHECK_INTEGER_RESULT (count, 2);
+	CHECK_INTEGER_RESULT (mrp_resource_get_overallocated_periods (resource)->len, 0);
+
+	g_object_unref (project);
+
+	g_object_unref (app);
+
+	return EXIT_SUCCESS;
+}
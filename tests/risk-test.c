@@ -0,0 +1,84 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+#include <config.h>
+#include <stdlib.h>
+#include "libplanner/mrp-project.h"
+#include "libplanner/mrp-relation.h"
+#include "libplanner/mrp-risk.h"
+#include "self-check.h"
+
+#define DAY (60*60*8)
+
+static void
+add_property (MrpProject *project, const gchar *name)
+{
+	mrp_project_add_property (project,
+				  MRP_TYPE_TASK,
+				  mrp_property_new (name,
+						    MRP_PROPERTY_TYPE_DURATION,
+						    name, "", TRUE),
+				  TRUE);
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+	MrpApplication  *app;
+	MrpProject      *project;
+	MrpTask         *task_a, *task_b, *task_c;
+	MrpRiskAnalysis *analysis;
+	mrptime          finish;
+	gdouble          criticality;
+
+	app = mrp_application_new ();
+	project = mrp_project_new (app);
+
+	g_object_set (project, "project_start", mrp_time_from_string ("20020218"), NULL);
+
+	task_a = add_task (project, NULL, "T", 2 * DAY);
+	task_b = add_task (project, NULL, "T", 3 * DAY);
+	task_c = add_task (project, NULL, "T", DAY);
+	mrp_task_add_predecessor (task_b, task_a, MRP_RELATION_FS, 0, NULL);
+
+	finish = mrp_task_get_finish (task_b);
+
+	/* Without estimates every iteration is the regular schedule. */
+	analysis = mrp_risk_analysis_new (project);
+	mrp_risk_analysis_run (analysis, 100, 1);
+
+	CHECK_INTEGER_RESULT (mrp_risk_analysis_get_iterations (analysis), 100);
+	CHECK_INTEGER_RESULT (mrp_risk_analysis_get_finish_percentile (analysis, 0), finish);
+	CHECK_INTEGER_RESULT (mrp_risk_analysis_get_finish_percentile (analysis, 100), finish);
+	CHECK_BOOLEAN_RESULT (mrp_risk_analysis_get_criticality (analysis, task_a) == 1.0, TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_risk_analysis_get_criticality (analysis, task_b) == 1.0, TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_risk_analysis_get_criticality (analysis, task_c) == 0.0, TRUE);
+
+	mrp_risk_analysis_free (analysis);
+
+	/* C can take up to 20 days, so it is sometimes critical. */
+	add_property (project, MRP_RISK_PROPERTY_PESSIMISTIC);
+	mrp_object_set (task_c, MRP_RISK_PROPERTY_PESSIMISTIC, 20 * DAY, NULL);
+
+	analysis = mrp_risk_analysis_new (project);
+	mrp_risk_analysis_run (analysis, 1000, 1);
+
+	criticality = mrp_risk_analysis_get_criticality (analysis, task_c);
+	CHECK_BOOLEAN_RESULT (criticality > 0 && criticality < 1, TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_risk_analysis_get_criticality (analysis, task_a) < 1, TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_risk_analysis_get_criticality (analysis, task_a) ==
+			      mrp_risk_analysis_get_criticality (analysis, task_b), TRUE);
+
+	CHECK_INTEGER_RESULT (mrp_risk_analysis_get_finish_percentile (analysis, 0), finish);
+	CHECK_BOOLEAN_RESULT (mrp_risk_analysis_get_finish_percentile (analysis, 90) > finish, TRUE);
+
+	/* The same seed gives the same results. */
+	finish = mrp_risk_analysis_get_finish_percentile (analysis, 50);
+	mrp_risk_analysis_run (analysis, 1000, 1);
+	CHECK_INTEGER_RESULT (mrp_risk_analysis_get_finish_percentile (analysis, 50), finish);
+
+	mrp_risk_analysis_free (analysis);
+	g_object_unref (project);
+
+	g_object_unref (app);
+
+	return EXIT_SUCCESS;
+}
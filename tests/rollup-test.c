@@ -0,0 +1,94 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+#include <config.h>
+#include <stdlib.h>
+#include "libplanner/mrp-project.h"
+#include "libplanner/mrp-relation.h"
+#include "self-check.h"
+
+#define DAY (60*60*8)
+
+gint
+main (gint argc, gchar **argv)
+{
+	MrpApplication *app;
+	MrpProject     *project;
+	MrpResource    *resource;
+	MrpTask        *task_a, *task_b, *summary, *root;
+	gfloat          cost;
+
+	app = mrp_application_new ();
+	project = mrp_project_new (app);
+
+	g_object_set (project,
+		      "project_start", mrp_time_from_string ("20020218"),
+		      "status-date", mrp_time_from_string ("20020301"),
+		      NULL);
+
+	resource = g_object_new (MRP_TYPE_RESOURCE, "name", "R", "cost", 10.0, NULL);
+	mrp_project_add_resource (project, resource);
+
+	/* Two days of A and three of B at 10 an hour. */
+	task_a = add_task (project, NULL, "A", 2 * DAY);
+	mrp_resource_assign (resource, task_a, 100);
+
+	summary = add_task (project, NULL, "S", 0);
+	task_b = add_task (project, summary, "B", 3 * DAY);
+	mrp_resource_assign (resource, task_b, 100);
+	mrp_task_add_predecessor (task_b, task_a, MRP_RELATION_FS, 0, NULL);
+
+	root = mrp_project_get_root_task (project);
+
+	CHECK_BOOLEAN_RESULT (mrp_task_get_cost (task_a) == 160, TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_task_get_cost (summary) == 240, TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_task_get_cost (root) == 400, TRUE);
+
+	g_object_get (root, "cost", &cost, NULL);
+	CHECK_BOOLEAN_RESULT (cost == 400, TRUE);
+
+	/* Both tasks are due by the status date, nothing is done yet. */
+	CHECK_BOOLEAN_RESULT (mrp_task_get_planned_value (root) == 400, TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_task_get_earned_value (root) == 0, TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_task_get_actual_cost (root) == 0, TRUE);
+
+	g_object_set (task_a, "percent_complete", 50, NULL);
+	CHECK_BOOLEAN_RESULT (mrp_task_get_earned_value (root) == 80, TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_task_get_actual_cost (root) == 160, TRUE);
+
+	g_object_set (task_b, "percent_complete", 100, NULL);
+	CHECK_BOOLEAN_RESULT (mrp_task_get_earned_value (summary) == 240, TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_task_get_earned_value (root) == 320, TRUE);
+
+	/* Before the start nothing is planned, finished work is still spent. */
+	mrp_project_set_status_date (project, mrp_time_from_string ("20020101"));
+	CHECK_BOOLEAN_RESULT (mrp_task_get_planned_value (root) == 0, TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_task_get_actual_cost (root) == 240, TRUE);
+
+	/* Rates, units and work changes reach the summaries. */
+	g_object_set (resource, "cost", 20.0, NULL);
+	CHECK_BOOLEAN_RESULT (mrp_task_get_cost (root) == 800, TRUE);
+
+	g_object_set (mrp_task_get_assignment (task_b, resource), "units", 50, NULL);
+	CHECK_BOOLEAN_RESULT (mrp_task_get_cost (summary) == 480, TRUE);
+
+	g_object_set (task_a, "work", 3 * DAY, NULL);
+	CHECK_BOOLEAN_RESULT (mrp_task_get_cost (root) == 960, TRUE);
+
+	/* Moving and removing tasks move their totals along. */
+	CHECK_BOOLEAN_RESULT (mrp_project_move_task (project, task_a, task_b, summary,
+						     FALSE, NULL), TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_task_get_cost (summary) == 960, TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_task_get_cost (root) == 960, TRUE);
+
+	mrp_project_remove_task (project, task_b);
+	CHECK_BOOLEAN_RESULT (mrp_task_get_cost (summary) == 480, TRUE);
+	CHECK_BOOLEAN_RESULT (mrp_task_get_cost (root) == 480, TRUE);
+
+	mrp_project_remove_task (project, summary);
+	CHECK_BOOLEAN_RESULT (mrp_task_get_cost (root) == 0, TRUE);
+
+	g_object_unref (project);
+
+	g_object_unref (app);
+
+	return EXIT_SUCCESS;
+}
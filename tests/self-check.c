@@ -113,3 +113,15 @@ check_pointer_result (gconstpointer result, gconstpointer expected)
 	}
 	after_check ();
 }
+
+/* Appends a task with @name and @work to @parent, or to the top level. */
+MrpTask *
+add_task (MrpProject *project, MrpTask *parent, const gchar *name, gint work)
+{
+	MrpTask *task;
+
+	task = g_object_new (MRP_TYPE_TASK, "name", name, "work", work, NULL);
+	mrp_project_insert_task (project, parent, -1, task);
+
+	return task;
+}
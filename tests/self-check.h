@@ -2,6 +2,7 @@
 #define __SELF_CHECK_H__
 
 #include <glib.h>
+#include "libplanner/mrp-project.h"
 
 #define CHECK_RESULT(type, expression, expected_value) \
 G_STMT_START { \
@@ -31,4 +32,9 @@ void check_string_result        (char          *result,
 void check_pointer_result       (gconstpointer  result,
 				 gconstpointer  expected);
 
+MrpTask *add_task               (MrpProject    *project,
+				 MrpTask       *parent,
+				 const gchar   *name,
+				 gint           work);
+
 #endif /* __SELF_CHECK_H__ */
@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include "libplanner/mrp-project.h"
 #include "libplanner/mrp-relation.h"
+#include "libplanner/mrp-private.h"
 #include "self-check.h"
 
 #define DAY (60*60*8)
@@ -21,6 +22,15 @@ main (gint argc, gchar **argv)
 	gboolean	success;
 	MrpTask        *root;
 	MrpRelation    *relation;
+	MrpProperty    *property;
+	gchar          *note;
+	gint            cost;
+	guint           serial;
+	GValue          value = { 0 };
+	GList          *list;
+	MrpResource    *resource;
+	MrpAssignment  *assignment;
+	GArray         *profile;
 
 	app = mrp_application_new ();
 
@@ -216,6 +226,142 @@ main (gint argc, gchar **argv)
 	CHECK_INTEGER_RESULT (mrp_task_get_work (task2), 0);
 	CHECK_INTEGER_RESULT (mrp_task_get_duration (task2), 0);
 
+	/* Custom properties, stored apart from the built-in ones. */
+	mrp_project_add_property (project,
+				  MRP_TYPE_TASK,
+				  mrp_property_new ("custom-note",
+						    MRP_PROPERTY_TYPE_STRING,
+						    "Custom note", "", TRUE),
+				  TRUE);
+	mrp_project_add_property (project,
+				  MRP_TYPE_TASK,
+				  mrp_property_new ("custom-cost",
+						    MRP_PROPERTY_TYPE_INT,
+						    "Custom cost", "", TRUE),
+				  TRUE);
+
+	mrp_object_set (task1, "custom-note", "first", "custom-cost", 42, NULL);
+	mrp_object_set (task2, "custom-note", "second", NULL);
+
+	mrp_object_get (task1, "custom-note", &note, "custom-cost", &cost, NULL);
+	CHECK_STRING_RESULT (note, "first");
+	CHECK_INTEGER_RESULT (cost, 42);
+	g_free (note);
+
+	g_object_get (task1, "note", &note, NULL);
+	CHECK_STRING_RESULT (note, "");
+	g_free (note);
+
+	/* Unset values read back as the default. */
+	mrp_object_get (task2, "custom-note", &note, "custom-cost", &cost, NULL);
+	CHECK_STRING_RESULT (note, "second");
+	CHECK_INTEGER_RESULT (cost, 0);
+	g_free (note);
+
+	/* A task reusing the slot of a freed one must not see its values. */
+	task3 = g_object_new (MRP_TYPE_TASK, "project", project, NULL);
+	mrp_object_set (task3, "custom-note", "gone", "custom-cost", 7, NULL);
+	g_object_unref (task3);
+
+	task3 = g_object_new (MRP_TYPE_TASK, "project", project, NULL);
+	mrp_object_get (task3, "custom-note", &note, "custom-cost", &cost, NULL);
+	CHECK_STRING_RESULT (note, NULL);
+	CHECK_INTEGER_RESULT (cost, 0);
+
+	mrp_object_set (task3, "custom-cost", 3, NULL);
+	mrp_object_get (task3, "custom-note", &note, "custom-cost", &cost, NULL);
+	CHECK_STRING_RESULT (note, NULL);
+	CHECK_INTEGER_RESULT (cost, 3);
+	g_object_unref (task3);
+
+	/* Removing the property drops the values. */
+	property = mrp_project_get_property (project, "custom-note", MRP_TYPE_TASK);
+	mrp_property_ref (property);
+	mrp_project_remove_property (project, MRP_TYPE_TASK, "custom-note");
+
+	g_value_init (&value, G_TYPE_STRING);
+	mrp_object_get_property (MRP_OBJECT (task1), property, &value);
+	CHECK_POINTER_RESULT (g_value_get_string (&value), NULL);
+	g_value_unset (&value);
+	mrp_property_unref (property);
+
+	/* Name and property lookups. */
+	CHECK_POINTER_RESULT (mrp_project_get_task_by_name (project, "T1"), task1);
+
+	mrp_object_set (task1, "name", "Renamed", NULL);
+	CHECK_POINTER_RESULT (mrp_project_get_task_by_name (project, "T1"), NULL);
+	CHECK_POINTER_RESULT (mrp_project_get_task_by_name (project, "Renamed"), task1);
+
+	mrp_project_add_property (project,
+				  MRP_TYPE_TASK,
+				  mrp_property_new ("external-id",
+						    MRP_PROPERTY_TYPE_STRING,
+						    "External id", "", TRUE),
+				  TRUE);
+	mrp_object_set (task1, "external-id", "X-1", NULL);
+
+	list = mrp_project_get_objects_by_property (project, MRP_TYPE_TASK,
+						    "external-id", "X-1");
+	CHECK_INTEGER_RESULT (g_list_length (list), 1);
+	CHECK_POINTER_RESULT (list->data, task1);
+	g_list_free (list);
+
+	mrp_object_set (task1, "external-id", "X-2", NULL);
+	list = mrp_project_get_objects_by_property (project, MRP_TYPE_TASK,
+						    "external-id", "X-1");
+	CHECK_POINTER_RESULT (list, NULL);
+
+	mrp_project_remove_task (project, task1);
+	CHECK_POINTER_RESULT (mrp_project_get_task_by_name (project, "Renamed"), NULL);
+	list = mrp_project_get_objects_by_property (project, MRP_TYPE_TASK,
+						    "external-id", "X-2");
+	CHECK_POINTER_RESULT (list, NULL);
+
+	/* Resource load profiles. */
+	resource = g_object_new (MRP_TYPE_RESOURCE, "name", "R1", NULL);
+	mrp_project_add_resource (project, resource);
+
+	task1 = g_object_new (MRP_TYPE_TASK, "name", "L1", "work", DAY, NULL);
+	mrp_project_insert_task (project, NULL, -1, task1);
+	task3 = g_object_new (MRP_TYPE_TASK, "name", "L2", "work", DAY, NULL);
+	mrp_project_insert_task (project, NULL, -1, task3);
+
+	mrp_resource_assign (resource, task1, 100);
+	mrp_resource_assign (resource, task3, 50);
+
+	/* L1 takes one day at 100%, L2 two days at 50%. */
+	profile = mrp_resource_get_load_profile (resource);
+	CHECK_INTEGER_RESULT (profile->len, 2);
+	CHECK_INTEGER_RESULT (g_array_index (profile, MrpLoadSegment, 0).units, 150);
+	CHECK_INTEGER_RESULT (g_array_index (profile, MrpLoadSegment, 0).end,
+			      mrp_task_get_finish (task1));
+	CHECK_INTEGER_RESULT (g_array_index (profile, MrpLoadSegment, 1).units, 50);
+	CHECK_INTEGER_RESULT (g_array_index (profile, MrpLoadSegment, 1).end,
+			      mrp_task_get_finish (task3));
+
+	profile = mrp_resource_get_overallocated_periods (resource);
+	CHECK_INTEGER_RESULT (profile->len, 1);
+	CHECK_INTEGER_RESULT (g_array_index (profile, MrpLoadSegment, 0).units, 150);
+
+	/* Changing the units reschedules L1 and updates the profile. */
+	assignment = mrp_task_get_assignment (task1, resource);
+	g_object_set (assignment, "units", 50, NULL);
+
+	profile = mrp_resource_get_load_profile (resource);
+	CHECK_INTEGER_RESULT (profile->len, 1);
+	CHECK_INTEGER_RESULT (g_array_index (profile, MrpLoadSegment, 0).units, 100);
+	CHECK_INTEGER_RESULT (mrp_resource_get_overallocated_periods (resource)->len, 0);
+
+	mrp_project_remove_task (project, task3);
+	profile = mrp_resource_get_load_profile (resource);
+	CHECK_INTEGER_RESULT (profile->len, 1);
+	CHECK_INTEGER_RESULT (g_array_index (profile, MrpLoadSegment, 0).units, 50);
+
+	/* Rescheduling hands out new unit intervals, with a new serial. */
+	serial = mrp_task_get_unit_ivals_serial (task1);
+	g_object_set (assignment, "units", 100, NULL);
+	CHECK_BOOLEAN_RESULT (mrp_task_get_unit_ivals_serial (task1) != serial, TRUE);
+
 	/* More tests needed... */
 
 
@@ -0,0 +1,77 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+#include <config.h>
+#include <stdlib.h>
+#include "libplanner/mrp-project.h"
+#include "self-check.h"
+
+#define DAY (60*60*8)
+
+gint
+main (gint argc, gchar **argv)
+{
+	MrpApplication *app;
+	MrpProject     *project;
+	MrpTask        *task_a, *task_b, *task_c;
+	MrpResource    *resource, *helper;
+	gchar          *name, *note;
+
+	app = mrp_application_new ();
+	project = mrp_project_new (app);
+
+	/* Equal names are stored once. */
+	name = g_strdup ("Review");
+	task_a = add_task (project, NULL, name, DAY);
+	task_b = add_task (project, NULL, "Review", DAY);
+	g_free (name);
+
+	CHECK_STRING_RESULT ((char *) mrp_task_get_name (task_a), "Review");
+	CHECK_POINTER_RESULT (mrp_task_get_name (task_b), mrp_task_get_name (task_a));
+
+	/* Renaming one leaves the other alone. */
+	mrp_task_set_name (task_b, "Ship");
+	CHECK_STRING_RESULT ((char *) mrp_task_get_name (task_a), "Review");
+	CHECK_STRING_RESULT ((char *) mrp_task_get_name (task_b), "Ship");
+
+	/* Getting the property still hands out a copy. */
+	g_object_get (task_a, "name", &name, "note", &note, NULL);
+	CHECK_BOOLEAN_RESULT (name != mrp_task_get_name (task_a), TRUE);
+	CHECK_STRING_RESULT (name, "Review");
+	CHECK_STRING_RESULT (note, "");
+	g_free (name);
+	g_free (note);
+
+	g_object_set (task_a, "note", "First", NULL);
+	g_object_get (task_b, "note", &note, NULL);
+	CHECK_STRING_RESULT (note, "");
+	g_free (note);
+
+	/* A name that is no longer used can be used again. */
+	mrp_project_remove_task (project, task_b);
+	task_c = add_task (project, NULL, "Ship", DAY);
+	CHECK_STRING_RESULT ((char *) mrp_task_get_name (task_c), "Ship");
+
+	resource = g_object_new (MRP_TYPE_RESOURCE,
+				 "name", "Tester",
+				 "short_name", "T",
+				 NULL);
+	helper = g_object_new (MRP_TYPE_RESOURCE,
+			       "name", "Tester",
+			       "email", "tester@example.com",
+			       NULL);
+	mrp_project_add_resource (project, resource);
+	mrp_project_add_resource (project, helper);
+
+	CHECK_POINTER_RESULT (mrp_resource_get_name (helper), mrp_resource_get_name (resource));
+	CHECK_STRING_RESULT ((char *) mrp_resource_get_short_name (resource), "T");
+	CHECK_STRING_RESULT ((char *) mrp_resource_get_short_name (helper), "");
+
+	g_object_get (helper, "email", &name, NULL);
+	CHECK_STRING_RESULT (name, "tester@example.com");
+	g_free (name);
+
+	g_object_unref (project);
+
+	g_object_unref (app);
+
+	return EXIT_SUCCESS;
+}
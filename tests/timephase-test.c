@@ -0,0 +1,149 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+#include <config.h>
+#include <stdlib.h>
+#include "libplanner/mrp-project.h"
+#include "libplanner/mrp-relation.h"
+#include "self-check.h"
+
+#define DAY (60*60*8)
+#define HOUR (60*60)
+
+static gint
+get_total_work (GArray *buckets)
+{
+	gint  work = 0;
+	guint i;
+
+	for (i = 0; i < buckets->len; i++) {
+		work += g_array_index (buckets, MrpTimephaseBucket, i).work;
+	}
+
+	g_array_free (buckets, TRUE);
+
+	return work;
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+	MrpApplication     *app;
+	MrpProject         *project;
+	MrpResource        *resource;
+	MrpTask            *task_a, *task_b, *summary, *root;
+	MrpTimephaseBucket *bucket;
+	GArray             *buckets, *incremental;
+	mrptime             start, finish;
+	guint               i;
+
+	app = mrp_application_new ();
+	project = mrp_project_new (app);
+
+	start = mrp_time_from_string ("20020218");
+	g_object_set (project, "project_start", start, NULL);
+
+	resource = g_object_new (MRP_TYPE_RESOURCE, "name", "R", "cost", 10.0, NULL);
+	mrp_project_add_resource (project, resource);
+
+	/* A takes Monday and Tuesday, B the rest of the week. */
+	task_a = add_task (project, NULL, "A", 2 * DAY);
+	mrp_resource_assign (resource, task_a, 100);
+
+	summary = add_task (project, NULL, "S", 0);
+	task_b = add_task (project, summary, "B", 3 * DAY);
+	mrp_task_add_predecessor (task_b, task_a, MRP_RELATION_FS, 0, NULL);
+
+	root = mrp_project_get_root_task (project);
+	finish = start + 7 * 24 * 60 * 60;
+
+	buckets = mrp_project_get_resource_timephase (project, resource,
+						      MRP_TIME_UNIT_DAY, start, finish);
+	CHECK_INTEGER_RESULT (buckets->len, 7);
+
+	bucket = &g_array_index (buckets, MrpTimephaseBucket, 0);
+	CHECK_INTEGER_RESULT (bucket->start, start);
+	CHECK_INTEGER_RESULT (bucket->end, start + 24 * 60 * 60);
+	CHECK_INTEGER_RESULT (bucket->work, 8 * HOUR);
+	CHECK_BOOLEAN_RESULT (bucket->cost == 80, TRUE);
+
+	CHECK_INTEGER_RESULT (g_array_index (buckets, MrpTimephaseBucket, 1).work, 8 * HOUR);
+	CHECK_INTEGER_RESULT (g_array_index (buckets, MrpTimephaseBucket, 2).work, 0);
+	g_array_free (buckets, TRUE);
+
+	/* Weeks start on Monday, months on the first. */
+	buckets = mrp_project_get_resource_timephase (project, resource,
+						      MRP_TIME_UNIT_WEEK, start, finish);
+	CHECK_INTEGER_RESULT (buckets->len, 1);
+	CHECK_INTEGER_RESULT (g_array_index (buckets, MrpTimephaseBucket, 0).start, start);
+	CHECK_INTEGER_RESULT (g_array_index (buckets, MrpTimephaseBucket, 0).work, 2 * DAY);
+	g_array_free (buckets, TRUE);
+
+	buckets = mrp_project_get_resource_timephase (project, resource,
+						      MRP_TIME_UNIT_MONTH, start, finish);
+	CHECK_INTEGER_RESULT (buckets->len, 1);
+	bucket = &g_array_index (buckets, MrpTimephaseBucket, 0);
+	CHECK_INTEGER_RESULT (bucket->start, mrp_time_from_string ("20020201"));
+	CHECK_INTEGER_RESULT (bucket->end, mrp_time_from_string ("20020301"));
+	CHECK_INTEGER_RESULT (bucket->work, 2 * DAY);
+	g_array_free (buckets, TRUE);
+
+	/* Summary tasks and the root add up the tasks below them. */
+	CHECK_INTEGER_RESULT (get_total_work (mrp_project_get_task_timephase (
+						      project, summary,
+						      MRP_TIME_UNIT_WEEK, start, finish)),
+			      3 * DAY);
+	CHECK_INTEGER_RESULT (get_total_work (mrp_project_get_task_timephase (
+						      project, root,
+						      MRP_TIME_UNIT_WEEK, start, finish)),
+			      5 * DAY);
+	CHECK_INTEGER_RESULT (get_total_work (mrp_project_get_task_timephase (
+						      project, task_a,
+						      MRP_TIME_UNIT_DAY, start, finish)),
+			      2 * DAY);
+
+	/* Changes are picked up on the next query. */
+	g_object_set (task_a, "work", 3 * DAY, NULL);
+	CHECK_INTEGER_RESULT (get_total_work (mrp_project_get_resource_timephase (
+						      project, resource,
+						      MRP_TIME_UNIT_DAY, start, finish)),
+			      3 * DAY);
+
+	/* Half time B now takes six days, two of them in this week. */
+	mrp_resource_assign (resource, task_b, 50);
+	CHECK_INTEGER_RESULT (get_total_work (mrp_project_get_resource_timephase (
+						      project, resource,
+						      MRP_TIME_UNIT_WEEK, start, finish)),
+			      4 * DAY);
+
+	/* The incremental result matches a rebuild of all tasks. */
+	incremental = mrp_project_get_resource_timephase (project, resource,
+							  MRP_TIME_UNIT_DAY, start, finish);
+	mrp_project_reschedule (project);
+	buckets = mrp_project_get_resource_timephase (project, resource,
+						      MRP_TIME_UNIT_DAY, start, finish);
+
+	CHECK_INTEGER_RESULT (buckets->len, incremental->len);
+	for (i = 0; i < buckets->len; i++) {
+		CHECK_INTEGER_RESULT (g_array_index (buckets, MrpTimephaseBucket, i).work,
+				      g_array_index (incremental, MrpTimephaseBucket, i).work);
+	}
+
+	g_array_free (buckets, TRUE);
+	g_array_free (incremental, TRUE);
+
+	/* Removed tasks no longer count. */
+	mrp_project_remove_task (project, summary);
+	CHECK_INTEGER_RESULT (get_total_work (mrp_project_get_resource_timephase (
+						      project, resource,
+						      MRP_TIME_UNIT_WEEK, start, finish)),
+			      3 * DAY);
+	CHECK_INTEGER_RESULT (get_total_work (mrp_project_get_task_timephase (
+						      project, root,
+						      MRP_TIME_UNIT_WEEK, start, finish)),
+			      3 * DAY);
+
+	g_object_unref (project);
+
+	g_object_unref (app);
+
+	return EXIT_SUCCESS;
+}
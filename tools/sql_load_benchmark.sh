@@ -0,0 +1,66 @@
+#!/bin/sh
+
+# Fills a scratch PostgreSQL database with many synthetic projects, then times
+# mrp_project_load() of one more project through the SQL storage module, using
+# tests/benchmark from a build tree.
+#
+# To compare two versions of the loader, build both and point
+# PLANNER_STORAGEMODULEDIR at the libplanner directory of each in turn, with
+# the schema that version expects:
+#
+#   PLANNER_STORAGEMODULEDIR=old/_build/libplanner \
+#     $0 scratch data/sql/database-0.13.sql
+#   $0 scratch
+
+if [ "$1" = "--help" ] || [ "$1" = "" ]; then
+	echo "Usage: $0 DATABASE [SCHEMA] [PROJECTS] [TASKS]"
+	echo ""
+	echo "DATABASE  scratch database, all its tables are dropped"
+	echo "SCHEMA    schema file, defaults to data/sql/database-0.16.sql"
+	echo "PROJECTS  number of other projects to create, defaults to 200"
+	echo "TASKS     tasks per other project, defaults to 2000"
+	echo ""
+	echo "BUILDDIR  environment variable, the build tree, defaults to _build"
+	exit 1
+fi
+
+DB=$1
+SCHEMA=${2:-data/sql/database-0.16.sql}
+PROJECTS=${3:-200}
+TASKS=${4:-2000}
+BUILDDIR=${BUILDDIR:-_build}
+PSQL="psql -q -X -d $DB -v ON_ERROR_STOP=1"
+
+if [ ! -x "$BUILDDIR/tests/benchmark" ]; then
+	echo "No $BUILDDIR/tests/benchmark, build the tree first."
+	exit 1
+fi
+
+echo "Creating schema from $SCHEMA..."
+$PSQL -c "DROP SCHEMA public CASCADE; CREATE SCHEMA public;" || exit 1
+$PSQL -f "$SCHEMA" > /dev/null || exit 1
+
+echo "Populating $PROJECTS projects with $TASKS tasks each..."
+$PSQL <<EOF || exit 1
+INSERT INTO project (name) SELECT 'p' || p FROM generate_series (1, $PROJECTS) p;
+INSERT INTO task (proj_id, name, parent_id)
+  SELECT p.proj_id, 't' || t, NULL
+  FROM project p, generate_series (1, $TASKS) t;
+INSERT INTO predecessor (task_id, pred_task_id)
+  SELECT task_id, task_id - 1 FROM task
+  WHERE task_id > 1 AND task_id % $TASKS <> 1;
+INSERT INTO resource (proj_id, name)
+  SELECT p.proj_id, 'r' || r FROM project p, generate_series (1, 50) r;
+INSERT INTO allocation (task_id, res_id)
+  SELECT t.task_id, r.res_id FROM task t, resource r
+  WHERE r.proj_id = t.proj_id AND r.res_id % 50 = t.task_id % 50;
+ANALYZE;
+EOF
+
+echo "Timing mrp_project_load() of a project with 2000 tasks..."
+PLANNER_BENCHMARK=1 \
+PLANNER_BENCHMARK_SQL_URI="sql://localhost#db=$DB" \
+PLANNER_STORAGEMODULEDIR=${PLANNER_STORAGEMODULEDIR:-$BUILDDIR/libplanner} \
+PLANNER_FILEMODULESDIR=$BUILDDIR/libplanner \
+PLANNER_DATADIR=data \
+	"$BUILDDIR/tests/benchmark" sql-load